@@ -53,13 +53,14 @@ static void usage(int v)
 
 static char **parseArgs(int argc, char *argv[])
 {
+    layout_context_t *const lctx = gvLayoutContext();
     int c;
 
     cmd = argv[0];
     while ((c = getopt(argc, argv, ":sv?")) != -1) {
 	switch (c) {
 	case 's':
-	    PSinputscale = POINTS_PER_INCH;
+	    lctx->PSinputscale = POINTS_PER_INCH;
 	    break;
 	case 'v':
 	    Verbose = 1;
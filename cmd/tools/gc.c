@@ -18,14 +18,19 @@
  * Written by Emden Gansner
  */
 
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include <cgraph/agxbuf.h>
+#include <cgraph/alloc.h>
 #include <cgraph/cgraph.h>
 #include <cgraph/cghdr.h>
 #include <cgraph/exit.h>
 #include <cgraph/stack.h>
+#include <cgraph/startswith.h>
 
 typedef struct {
     Agrec_t h;
@@ -297,6 +302,368 @@ static Agraph_t *gread(FILE * fp)
     return agread(fp, NULL);
 }
 
+/* Without -r, graphs are counted as they are read rather than built, which
+ * takes a table of node names and a union-find forest over them for the
+ * components, instead of the graph.
+ */
+
+typedef struct {		/* distinct names, numbered from 0 */
+    char *pool;			/* the names, each NUL terminated */
+    size_t poollen, poolcap;
+    size_t *offset;		/* in pool of each name */
+    size_t count, cap;
+    size_t *slots;		/* number + 1 of the name hashed here, or 0 */
+    size_t nslots;
+} names_t;
+
+static size_t hashname(const char *s, size_t n)
+{
+    uint64_t h = UINT64_C(14695981039346656037);
+    for (size_t i = 0; i < n; i++)
+	h = (h ^ (unsigned char)s[i]) * UINT64_C(1099511628211);
+    return (size_t)(h ^ (h >> 32));
+}
+
+static void names_clear(names_t * t)
+{
+    t->poollen = t->count = 0;
+    if (t->slots)
+	memset(t->slots, 0, t->nslots * sizeof(size_t));
+}
+
+static void names_free(names_t * t)
+{
+    free(t->pool);
+    free(t->offset);
+    free(t->slots);
+}
+
+/* number of the name, added to the table if new */
+static size_t names_get(names_t * t, Agtext_t name, bool * added)
+{
+    size_t i;
+
+    if ((t->count + 1) * 2 > t->nslots) {
+	size_t n = t->nslots ? t->nslots * 2 : 1024;
+	free(t->slots);
+	t->slots = gv_calloc(n, sizeof(size_t));
+	t->nslots = n;
+	for (size_t k = 0; k < t->count; k++) {
+	    const char *s = t->pool + t->offset[k];
+	    i = hashname(s, strlen(s)) & (n - 1);
+	    while (t->slots[i])
+		i = (i + 1) & (n - 1);
+	    t->slots[i] = k + 1;
+	}
+    }
+    for (i = hashname(name.data, name.size) & (t->nslots - 1); t->slots[i];
+	 i = (i + 1) & (t->nslots - 1)) {
+	const char *s = t->pool + t->offset[t->slots[i] - 1];
+	if (strncmp(s, name.data, name.size) == 0 && s[name.size] == '\0') {
+	    *added = false;
+	    return t->slots[i] - 1;
+	}
+    }
+    if (t->poollen + name.size + 1 > t->poolcap) {
+	size_t cap = t->poolcap ? t->poolcap : BUFSIZ;
+	while (cap < t->poollen + name.size + 1)
+	    cap *= 2;
+	t->pool = gv_recalloc(t->pool, t->poolcap, cap, 1);
+	t->poolcap = cap;
+    }
+    if (t->count == t->cap) {
+	size_t cap = t->cap ? t->cap * 2 : 1024;
+	t->offset = gv_recalloc(t->offset, t->cap, cap, sizeof(size_t));
+	t->cap = cap;
+    }
+    memcpy(t->pool + t->poollen, name.data, name.size);
+    t->pool[t->poollen + name.size] = '\0';
+    t->offset[t->count] = t->poollen;
+    t->poollen += name.size + 1;
+    t->slots[i] = ++t->count;
+    *added = true;
+    return t->count - 1;
+}
+
+typedef struct {		/* an edge found by its endpoints and key */
+    size_t tail, head, key;
+} edgekey_t;
+
+typedef struct {
+    edgekey_t *slots;		/* tail SIZE_MAX if empty */
+    size_t count, nslots;
+} edgekeys_t;
+
+static size_t hashedge(edgekey_t e)
+{
+    uint64_t h = (uint64_t)e.tail * UINT64_C(0x9E3779B97F4A7C15);
+    h = (h ^ e.head) * UINT64_C(0xC2B2AE3D27D4EB4F);
+    h = (h ^ e.key) * UINT64_C(0x9E3779B97F4A7C15);
+    return (size_t)(h >> 32);
+}
+
+static void edgekeys_clear(edgekeys_t * t)
+{
+    t->count = 0;
+    for (size_t i = 0; i < t->nslots; i++)
+	t->slots[i].tail = SIZE_MAX;
+}
+
+/* add the edge, returning false if it was already there */
+static bool edgekeys_add(edgekeys_t * t, edgekey_t e)
+{
+    size_t i;
+
+    if ((t->count + 1) * 2 > t->nslots) {
+	edgekey_t *old = t->slots;
+	size_t oldn = t->nslots;
+	t->nslots = oldn ? oldn * 2 : 1024;
+	t->slots = gv_calloc(t->nslots, sizeof(edgekey_t));
+	t->count = 0;
+	edgekeys_clear(t);
+	for (size_t k = 0; k < oldn; k++) {
+	    if (old[k].tail != SIZE_MAX)
+		edgekeys_add(t, old[k]);
+	}
+	free(old);
+    }
+    for (i = hashedge(e) & (t->nslots - 1); t->slots[i].tail != SIZE_MAX;
+	 i = (i + 1) & (t->nslots - 1)) {
+	edgekey_t f = t->slots[i];
+	if (f.tail == e.tail && f.head == e.head && f.key == e.key)
+	    return false;
+    }
+    t->slots[i] = e;
+    t->count++;
+    return true;
+}
+
+typedef struct {
+    names_t nodes, keys;
+    names_t subgs;		/* by parent number and name */
+    size_t *parents;		/* numbers of the subgraphs being read */
+    size_t depth, parentcap;
+    size_t n_anon;		/* anonymous subgraphs seen */
+    agxbuf key;
+    edgekeys_t edges;		/* of strict graphs, or with keys */
+    size_t *parent;		/* union-find forest over nodes */
+    size_t nparent;
+    int n_edges;
+    int n_merged;		/* unions of two components */
+    int n_cl;
+    Agdesc_t desc;
+    char *name;
+    int rv;
+} counts_t;
+
+/* The default ID discipline numbers anonymous graphs, subgraphs and edges
+ * from a counter shared by all graphs, and anonymous graphs are named by it.
+ */
+static IDTYPE anon_ctr = 1;
+
+static size_t find(counts_t * c, size_t n)
+{
+    while (c->parent[n] != n)
+	n = c->parent[n] = c->parent[c->parent[n]];
+    return n;
+}
+
+static size_t count_node(counts_t * c, Agtext_t name)
+{
+    bool added;
+    size_t n = names_get(&c->nodes, name, &added);
+
+    if (added && (flags & CC)) {
+	if (n == c->nparent) {
+	    size_t cap = c->nparent ? c->nparent * 2 : 1024;
+	    c->parent = gv_recalloc(c->parent, c->nparent, cap,
+				    sizeof(size_t));
+	    c->nparent = cap;
+	}
+	c->parent[n] = n;
+    }
+    return n;
+}
+
+static int s_graph(void *state, Agtext_t name, Agdesc_t desc)
+{
+    counts_t *c = state;
+
+    names_clear(&c->nodes);
+    names_clear(&c->subgs);
+    names_clear(&c->keys);
+    edgekeys_clear(&c->edges);
+    c->n_edges = c->n_merged = c->n_cl = 0;
+    c->depth = c->n_anon = 0;
+    c->desc = desc;
+    free(c->name);
+    if (name.data) {
+	c->name = gv_strndup(name.data, name.size);
+    } else {
+	agxbuf xb = {0};
+	agxbprint(&xb, "%c%" PRIu64, LOCALNAMEPREFIX, anon_ctr);
+	c->name = agxbdisown(&xb);
+	anon_ctr += 2;
+    }
+    if (startswith(c->name, "cluster"))
+	c->n_cl++;
+    return 0;
+}
+
+/* Named subgraphs are the same subgraph if they have the same parent, so
+ * they are numbered by parent and name. Anonymous ones are always new.
+ */
+static int s_subgraph(void *state, Agtext_t name)
+{
+    counts_t *c = state;
+    size_t parent = c->depth ? c->parents[c->depth - 1] : SIZE_MAX;
+    size_t n;
+    bool added;
+
+    if (name.data) {
+	agxbprint(&c->key, "%zu:%.*s", parent, (int)name.size, name.data);
+	char *key = agxbuse(&c->key);
+	n = names_get(&c->subgs, (Agtext_t){key, strlen(key), 0}, &added);
+	if (added && startswith(strchr(key, ':') + 1, "cluster"))
+	    c->n_cl++;
+    } else {
+	n = SIZE_MAX / 2 + c->n_anon++;
+	anon_ctr += 2;
+    }
+    if (c->depth == c->parentcap) {
+	size_t cap = c->parentcap ? c->parentcap * 2 : 64;
+	c->parents = gv_recalloc(c->parents, c->parentcap, cap,
+				 sizeof(size_t));
+	c->parentcap = cap;
+    }
+    c->parents[c->depth++] = n;
+    return 0;
+}
+
+static int s_endsubgraph(void *state)
+{
+    counts_t *c = state;
+
+    c->depth--;
+    return 0;
+}
+
+static int s_node(void *state, Agtext_t name, size_t nattrs,
+		  const Agtext_t * attrs)
+{
+    (void)nattrs;
+    (void)attrs;
+
+    (void)count_node(state, name);
+    return 0;
+}
+
+static int s_edge(void *state, Agtext_t tail, Agtext_t head, size_t nattrs,
+		  const Agtext_t * attrs)
+{
+    counts_t *c = state;
+    size_t t = count_node(c, tail);
+    size_t h = count_node(c, head);
+    edgekey_t e = {t, h, SIZE_MAX};
+    bool keyed = false;
+    bool added;
+
+    for (size_t i = 0; i < nattrs; i++) {
+	if (attrs[2 * i].size == 3 && strncmp(attrs[2 * i].data, "key", 3) == 0) {
+	    e.key = names_get(&c->keys, attrs[2 * i + 1], &added);
+	    keyed = true;
+	}
+    }
+    if (!c->desc.directed && e.tail > e.head) {
+	e.tail = h;
+	e.head = t;
+    }
+    if (c->desc.strict) {
+	e.key = SIZE_MAX;
+	if (!edgekeys_add(&c->edges, e))
+	    return 0;
+    } else if (keyed && !edgekeys_add(&c->edges, e))
+	return 0;
+    if (!keyed)
+	anon_ctr += 2;
+    c->n_edges++;
+    if (flags & CC) {
+	t = find(c, t);
+	h = find(c, h);
+	if (t != h) {
+	    c->parent[t] = h;
+	    c->n_merged++;
+	}
+    }
+    return 0;
+}
+
+static int s_endgraph(void *state)
+{
+    counts_t *c = state;
+    int n_nodes = (int)c->nodes.count;
+    int n_cc = 0;
+    int n_cl = 0;
+
+    if (verbose)
+	fprintf(stderr, "Process graph %s in file %s\n", c->name, fname);
+    if (!((c->desc.directed ? DIRECTED : UNDIRECTED) & gtype)) {
+	c->rv = 1;
+	return 0;
+    }
+    if (flags & CC)
+	n_cc = n_nodes - c->n_merged;
+    if (flags & CL)
+	n_cl = c->n_cl;
+    wcp(n_nodes, c->n_edges, n_cc, n_cl, c->name, fname);
+    n_graphs++;
+    tot_edges += c->n_edges;
+    tot_nodes += n_nodes;
+    tot_cc += n_cc;
+    tot_cl += n_cl;
+    return 0;
+}
+
+/* count the graphs of each file as they are read */
+static int stream_files(void)
+{
+    static Agstreamdisc_t handlers = {
+	.graph = s_graph, .subgraph = s_subgraph,
+	.endsubgraph = s_endsubgraph, .node = s_node, .edge = s_edge,
+	.endgraph = s_endgraph,
+    };
+    static char *stdin_only[] = {"-", NULL};
+    char **files = Files ? Files : stdin_only;
+    counts_t c = {0};
+
+    for (size_t i = 0; files[i]; i++) {
+	FILE *fp;
+	if (*files[i] == '-') {
+	    fp = stdin;
+	    fname = "<stdin>";
+	} else if ((fp = fopen(files[i], "r")) != NULL) {
+	    fname = files[i];
+	} else {
+	    fprintf(stderr, "Can't open %s\n", files[i]);
+	    continue;
+	}
+	agsetfile(fname);
+	(void)agstream(fp, NULL, &handlers, &c);
+	if (fp != stdin)
+	    fclose(fp);
+    }
+
+    names_free(&c.nodes);
+    names_free(&c.subgs);
+    names_free(&c.keys);
+    free(c.parents);
+    agxbfree(&c.key);
+    free(c.edges.slots);
+    free(c.parent);
+    free(c.name);
+    return c.rv;
+}
+
 int main(int argc, char *argv[])
 {
     Agraph_t *g;
@@ -305,6 +672,12 @@ int main(int argc, char *argv[])
     int rv = 0;
 
     init(argc, argv);
+    if (!recurse) {
+	rv = stream_files();
+	if (n_graphs > 1)
+	    wcp(tot_nodes, tot_edges, tot_cc, tot_cl, "total", 0);
+	graphviz_exit(rv);
+    }
     newIngraph(&ig, Files, gread);
 
     while ((g = nextGraph(&ig)) != 0) {
@@ -262,6 +262,7 @@ static void init_node_edge(Agraph_t * g)
  * read in attributes relevant to the layout.
  */
 static void init_graph(Agraph_t *g, bool fill, GVC_t *gvc) {
+    layout_context_t *const lctx = gvLayoutContext();
     int d;
     node_t *n;
     edge_t *e;
@@ -277,7 +278,7 @@ static void init_graph(Agraph_t *g, bool fill, GVC_t *gvc) {
 	          << " (!= 2)\n";
 	graphviz_exit(1);
     }
-    Ndim = GD_ndim(g) = 2;
+    lctx->Ndim = GD_ndim(g) = 2;
     init_node_edge(g);
     if (fill) {
 	int ret = init_nop(g,0);
@@ -289,7 +290,7 @@ static void init_graph(Agraph_t *g, bool fill, GVC_t *gvc) {
 		          << agnameof(g) << '\n';
 	    graphviz_exit(1);
 	}
-	if (Concentrate) { /* check for edges without pos info */
+	if (lctx->Concentrate) { /* check for edges without pos info */
 	    for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
 		for (e = agfstout(g, n); e; e = agnxtout(g, e)) {
 		    if (ED_spl(e) == nullptr) ED_edge_type(e) = IGNORED;
@@ -560,6 +561,7 @@ static void cloneClusterTree(Agraph_t * g, Agraph_t * ng)
  * of the graphs gs. 
  */
 static Agraph_t *cloneGraph(std::vector<Agraph_t*> &gs, GVC_t *gvc) {
+    layout_context_t *const lctx = gvLayoutContext();
     Agraph_t *root;
     Agraph_t *subg;
     Agnode_t *n;
@@ -586,7 +588,7 @@ static Agraph_t *cloneGraph(std::vector<Agraph_t*> &gs, GVC_t *gvc) {
 
     /* do common initialization. This will handle root's label. */
     init_graph(root, false, gvc);
-    State = GVSPLINES;
+    lctx->State = GVSPLINES;
 
     used_t gnames; // dict of used subgraph names
     used_t nnames; // dict of used node names
@@ -653,14 +655,15 @@ static Agraph_t *gread(FILE * fp)
  * be non-strict.
  */
 static std::vector<Agraph_t*> readGraphs(GVC_t *gvc) {
+    layout_context_t *const lctx = gvLayoutContext();
     Agraph_t *g;
     std::vector<Agraph_t*> gs;
     ingraph_state ig;
     int kindUnset = 1;
 
     /* set various state values */
-    PSinputscale = POINTS_PER_INCH;
-    Nop = 2;
+    lctx->PSinputscale = POINTS_PER_INCH;
+    lctx->Nop = 2;
 
     newIngraph(&ig, myFiles, gread);
     while ((g = nextGraph(&ig)) != 0) {
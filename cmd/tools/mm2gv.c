@@ -15,6 +15,7 @@
 
 #include "config.h"
 #include <cgraph/alloc.h>
+#include <cgraph/sort.h>
 #include <cgraph/unreachable.h>
 
 #define STANDALONE
@@ -33,13 +34,6 @@
 
 #define BUFS         1024
 
-typedef struct {
-    Agrec_t h;
-    int id;
-} Agnodeinfo_t;
-
-#define ND_id(n)  (((Agnodeinfo_t*)(n->base.data))->id)
-
 static char *cmd;
 
 static double Hue2RGB(double v1, double v2, double H)
@@ -72,22 +66,53 @@ static char *hue2rgb(double hue, agxbuf *xb) {
     return agxbuse(xb);
 }
 
-static Agraph_t *makeDotGraph(SparseMatrix A, char *name, int dim,
-			      double * x, int with_color, int with_label, int with_val)
+/* writeAttr:
+ * Write the next attribute of an attribute list as agwrite would, opening
+ * the list if this is the first.
+ */
+static void writeAttr(FILE *f, int *cnt, char *name, char *value)
+{
+    if ((*cnt)++ == 0)
+	fputs("\t[", f);
+    else
+	fputs(",\n\t\t", f);
+    fprintf(f, "%s=%s", name, agcanon(value, 0));
+}
+
+/* cmpEntry:
+ * Order entries of a row by column, as a graph orders out edges by head,
+ * then by position.
+ */
+static int cmpEntry(const void *a, const void *b, void *arg)
+{
+    const int *ja = arg;
+    const int x = *(const int *)a;
+    const int y = *(const int *)b;
+    if (ja[x] != ja[y])
+	return ja[x] < ja[y] ? -1 : 1;
+    return (x > y) - (x < y);
+}
+
+/* writeDotGraph:
+ * Write the graph of A as DOT, as agwrite would have written it from a graph
+ * with a node for each row and an edge for each entry. Nodes without edges
+ * are written where they fall in the row order. Edges are written directly
+ * from the matrix, so no graph is built.
+ */
+static void writeDotGraph(FILE *f, SparseMatrix A, char *name, int dim,
+			  double * x, int with_color, int with_label, int with_val)
 {
-    Agraph_t *g;
-    Agnode_t *n;
-    Agnode_t *h;
-    Agedge_t *e;
     int i, j;
     agxbuf xb;
     char string[BUFS];
-    Agsym_t *sym = NULL, *sym2 = NULL, *sym3 = NULL;
     int *ia = A->ia;
     int *ja = A->ja;
     double *val = A->a;
-    Agnode_t **arr = gv_calloc(A->m, sizeof(Agnode_t*));
+    bool *has_in = gv_calloc(A->m, sizeof(bool));
+    int *row = NULL;
+    int rowcap = 0;
     double *color = NULL;
+    const char *edgeop;
 
     name = strip_dir(name);
 
@@ -103,39 +128,36 @@ static Agraph_t *makeDotGraph(SparseMatrix A, char *name, int dim,
     }
 
     if (SparseMatrix_known_undirected(A)) {
-	g = agopen("G", Agundirected, NULL);
+	fputs("graph G {\n", f);
+	edgeop = " -- ";
     } else {
-	g = agopen("G", Agdirected, NULL);
+	fputs("digraph G {\n", f);
+	edgeop = " -> ";
     }
 
-    if (with_val) {
-	sym = agattr(g, AGEDGE, "len", "1");
-    }
+    /* graph attributes, in name order */
     agxbinit (&xb, BUFS, string);
+    if (with_color && with_label)
+	fputs("\tgraph [bgcolor=black,\n\t\t", f);
+    else if (with_color)
+	fputs("\tgraph [bgcolor=black];\n", f);
+    else if (with_label)
+	fputs("\tgraph [", f);
     if (with_label) {
 	agxbprint (&xb, "%s. %d nodes, %d edges.", name, A->m, A->nz);
-	agattr(g, AGRAPH, "label", agxbuse (&xb));
-    }
-
-    for (i = 0; i < A->m; i++) {
-	agxbprint(&xb, "%d", i);
-	n = agnode(g, agxbuse(&xb), 1);
-	agbindrec(n, "nodeinfo", sizeof(Agnodeinfo_t), true);
-	ND_id(n) = i;
-	arr[i] = n;
+	fprintf(f, "label=%s", agcanon(agxbuse(&xb), 0));
+	fputs(with_color ? "\n\t];\n" : "];\n", f);
     }
+    if (with_val)
+	fputs("\tedge [len=1];\n", f);
 
     if (with_color) {
 	double maxdist = 0.;
 	double mindist = 0.;
 	bool first = true;
 
-	sym2 = agattr(g, AGEDGE, "color", "");
-	sym3 = agattr(g, AGEDGE, "wt", "");
-	agattr(g, AGRAPH, "bgcolor", "black");
 	color = gv_calloc(A->nz, sizeof(double));
-	for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
-	    i = ND_id(n);
+	for (i = 0; i < A->m; i++) {
 	    if (A->type != MATRIX_TYPE_REAL) {
 		for (j = ia[i]; j < ia[i + 1]; j++) {
 		    color[j] = distance(x, dim, i, ja[j]);
@@ -165,35 +187,51 @@ static Agraph_t *makeDotGraph(SparseMatrix A, char *name, int dim,
 		}
 	    }
 	}
-	for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
-	    i = ND_id(n);
+	for (i = 0; i < A->m; i++) {
 	    for (j = ia[i]; j < ia[i + 1]; j++) {
 		color[j] = (color[j] - mindist) / fmax(maxdist - mindist, 0.000001);
 	    }
 	}
     }
 
-    for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
-	i = ND_id(n);
-	for (j = ia[i]; j < ia[i + 1]; j++) {
-	    h = arr[ja[j]];
-	    e = agedge(g, n, h, NULL, 1);
-	    if (sym && val) {
+    for (i = 0; i < A->m; i++)
+	for (j = ia[i]; j < ia[i + 1]; j++)
+	    has_in[ja[j]] = true;
+
+    for (i = 0; i < A->m; i++) {
+	int k, nrow = ia[i + 1] - ia[i];
+	if (nrow == 0 && !has_in[i])
+	    fprintf(f, "\t%d;\n", i);
+	if (nrow > rowcap) {
+	    row = gv_recalloc(row, (size_t)rowcap, (size_t)nrow, sizeof(int));
+	    rowcap = nrow;
+	}
+	for (k = 0; k < nrow; k++)
+	    row[k] = ia[i] + k;
+	gv_sort(row, (size_t)nrow, sizeof(int), cmpEntry, ja);
+	for (k = 0; k < nrow; k++) {
+	    int cnt = 0;
+	    j = row[k];
+	    fprintf(f, "\t%d%s%d", i, edgeop, ja[j]);
+	    if (with_color)
+		writeAttr(f, &cnt, "color", hue2rgb(.65 * color[j], &xb));
+	    if (with_val && val) {
 		agxbprint(&xb, "%f", val[j]);
-		agxset(e, sym, agxbuse(&xb));
+		writeAttr(f, &cnt, "len", agxbuse(&xb));
 	    }
 	    if (with_color) {
-		agxset(e, sym2, hue2rgb(.65 * color[j], &xb));
 		agxbprint(&xb, "%f", color[j]);
-		agxset(e, sym3, agxbuse(&xb));
+		writeAttr(f, &cnt, "wt", agxbuse(&xb));
 	    }
+	    fputs(cnt > 0 ? "];\n" : ";\n", f);
 	}
     }
+    fputs("}\n", f);
 
     agxbfree (&xb);
     free(color);
-    free(arr);
-    return g;
+    free(has_in);
+    free(row);
 }
 
 static char* useString = "Usage: %s [-uvcl] [-o file] matrix_market_filename\n\
@@ -296,7 +334,6 @@ static void init(int argc, char **argv, parms_t * p)
 
 int main(int argc, char *argv[])
 {
-    Agraph_t *g = 0;
     SparseMatrix A = NULL;
     int dim=0;
     parms_t pv;
@@ -333,9 +370,7 @@ int main(int argc, char *argv[])
 	SparseMatrix_delete(A);
 	A = B;
     }
-    g = makeDotGraph(A, pv.infile, dim, NULL, pv.with_color, pv.with_label, pv.with_val);
-
-    agwrite(g, pv.outf);
+    writeDotGraph(pv.outf, A, pv.infile, dim, NULL, pv.with_color, pv.with_label, pv.with_val);
 
     graphviz_exit(0);
 }
@@ -15,8 +15,14 @@ Dt_t* dtopen(Dtdisc_t* disc, Dtmethod_t* meth)
 	if(!disc || !meth)
 		return NULL;
 
-	/* allocate space for dictionary */
-	if(!(dt = malloc(sizeof(Dt_t))))
+	/* allocate space for dictionary, from the same memory as its data if
+	 * the discipline provides it, so that memory can be released wholesale
+	 */
+	if(disc->memoryf && !disc->eventf)
+	{	if(!(dt = disc->memoryf(0, 0, sizeof(Dt_t), disc)))
+			return NULL;
+	}
+	else if(!(dt = malloc(sizeof(Dt_t))))
 		return NULL;
 
 	/* initialize all absolutely private data */
@@ -24,7 +30,7 @@ Dt_t* dtopen(Dtdisc_t* disc, Dtmethod_t* meth)
 	dt->meth = NULL;
 	dt->disc = NULL;
 	dtdisc(dt,disc,0);
-	dt->type = DT_MALLOC;
+	dt->type = disc->memoryf && !disc->eventf ? DT_MEMORYF : DT_MALLOC;
 	dt->nview = 0;
 	dt->view = dt->walk = NULL;
 	dt->user = NULL;
@@ -60,7 +66,9 @@ Dt_t* dtopen(Dtdisc_t* disc, Dtmethod_t* meth)
 	/* allocate sharable data */
 	if (!(data = dt->memoryf(dt, NULL, sizeof(Dtdata_t), disc)))
 	{ err_open:
-		free(dt);
+		if(dt->type == DT_MEMORYF)
+			(void)disc->memoryf(dt, dt, 0, disc);
+		else	free(dt);
 		return NULL;
 	}
 
@@ -15,14 +15,15 @@
 #include <cgraph/cghdr.h>
 
 #define MAX(a,b)	((a)>(b)?(a):(b))
-static agerrlevel_t agerrno;		/* Last error level */
 static agerrlevel_t agerrlevel = AGWARN;	/* Report errors >= agerrlevel */
-static int agmaxerr;
-
-static long aglast;		/* Last message */
-static FILE *agerrout;		/* Message file */
 static agusererrf usererrf;     /* User-set error function */
 
+/* errors seen, per thread */
+static TLS agerrlevel_t agerrno;	/* Last error level */
+static TLS int agmaxerr;
+static TLS long aglast;		/* Last message */
+static TLS FILE *agerrout;	/* Message file */
+
 agusererrf
 agseterrf (agusererrf newf)
 {
@@ -12,6 +12,13 @@
 #include	<cgraph/unreachable.h>
 #include	<stddef.h>
 #include	<stdbool.h>
+#include	<stdio.h>
+#include	<stdlib.h>
+#ifdef _WIN32
+#include	<windows.h>
+#else
+#include	<pthread.h>
+#endif
 
 /*
  * dynamic attributes
@@ -31,15 +38,54 @@ Dtdisc_t AgDataDictDisc = {
     freesym,
     NULL,
     NULL,
-    NULL,
+    agdictobjmem,
     NULL,
 };
 
 static char DataDictName[] = "_AG_datadict";
 static void init_all_attrs(Agraph_t * g);
+static bool columnar(void *obj);
+static void newcolumn(Agraph_t * root, int kind, Agsym_t * sym);
 static Agdesc_t ProtoDesc = { 1, 0, 1, 0, 1, 1, 0, 0 };
 static Agraph_t *ProtoGraph;
 
+/* The prototype graph is shared by all threads, so it is only used with this
+ * lock held. The lock is taken again by functions called under it, such as
+ * agopen making the prototype graph, so a thread holding it just goes on.
+ */
+#ifdef _WIN32
+static SRWLOCK ProtoLock = SRWLOCK_INIT;
+#else
+static pthread_mutex_t ProtoLock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+static TLS bool ProtoHeld;
+
+/// take the lock on the prototype graph, returning false if already held
+static bool proto_lock(void)
+{
+    if (ProtoHeld)
+	return false;
+#ifdef _WIN32
+    AcquireSRWLockExclusive(&ProtoLock);
+#else
+    pthread_mutex_lock(&ProtoLock);
+#endif
+    ProtoHeld = true;
+    return true;
+}
+
+static void proto_unlock(bool locked)
+{
+    if (!locked)
+	return;
+    ProtoHeld = false;
+#ifdef _WIN32
+    ReleaseSRWLockExclusive(&ProtoLock);
+#else
+    pthread_mutex_unlock(&ProtoLock);
+#endif
+}
+
 Agdatadict_t *agdatadict(Agraph_t * g, int cflag)
 {
     Agdatadict_t *rv;
@@ -118,6 +164,7 @@ static Agdatadict_t *agmakedatadict(Agraph_t * g)
 	dtview(dd->dict.e, parent_dd->dict.e);
 	dtview(dd->dict.g, parent_dd->dict.g);
     } else {
+	const bool locked = proto_lock();
 	if (ProtoGraph && g != ProtoGraph) {
 	    /* it's not ok to dtview here for several reasons. the proto
 	       graph could change, and the sym indices don't match */
@@ -126,6 +173,14 @@ static Agdatadict_t *agmakedatadict(Agraph_t * g)
 	    agcopydict(parent_dd->dict.e, dd->dict.e, g, AGEDGE);
 	    agcopydict(parent_dd->dict.g, dd->dict.g, g, AGRAPH);
 	}
+	proto_unlock(locked);
+	if (g->desc.columnar) {
+	    Agsym_t *sym;
+	    for (sym = dtfirst(dd->dict.n); sym; sym = dtnext(dd->dict.n, sym))
+		newcolumn(g, AGNODE, sym);
+	    for (sym = dtfirst(dd->dict.e); sym; sym = dtnext(dd->dict.e, sym))
+		newcolumn(g, AGEDGE, sym);
+	}
     }
     return dd;
 }
@@ -158,6 +213,8 @@ Agsym_t *agattrsym(void *obj, char *name)
     data = agattrrec(obj);
     if (data)
 	rv = agdictsym(data->dict, name);
+    else if (columnar(obj))
+	rv = agdictsym(agdictof(agroot(obj), AGTYPE(obj)), name);
     else
 	rv = NULL;
     return rv;
@@ -167,6 +224,122 @@ Agsym_t *agattrsym(void *obj, char *name)
 
 char *AgDataRecName = "_AG_strdata";
 
+/* only nodes and edges have sequence numbers unique within a root graph */
+static int kindindex(void *obj)
+{
+    switch (AGTYPE(obj)) {
+    case AGNODE:
+	return 0;
+    case AGINEDGE:
+    case AGOUTEDGE:
+	return 1;
+    default:
+	return -1;
+    }
+}
+
+/*
+ * columnar attributes
+ *
+ * A root graph opened with the columnar descriptor flag keeps the values of
+ * each node and edge attribute in a column (see attrcol.c) instead of giving
+ * every node and edge its own Agattr_t. Graphs themselves keep Agattr_t.
+ */
+
+struct Agattrcols_s {
+    agattrcol_t **col[2];	/* node and edge columns by symbol id */
+    size_t ncol[2];		/* allocated entries of col */
+};
+
+static bool columnar(void *obj)
+{
+    return kindindex(obj) >= 0 && agroot(obj)->desc.columnar;
+}
+
+static agattrcol_t *column(void *obj, int id)
+{
+    Agattrcols_t *c = agroot(obj)->clos->attrcols;
+    int kind = kindindex(obj);
+
+    assert(c && id >= 0 && (size_t) id < c->ncol[kind] && c->col[kind][id]);
+    return c->col[kind][id];
+}
+
+/* make the column of a new root symbol, taking its default as the base */
+static void newcolumn(Agraph_t * root, int kind, Agsym_t * sym)
+{
+    Agattrcols_t *c;
+    size_t id = (size_t) sym->id;
+    int k = kind == AGNODE ? 0 : 1;
+
+    if (!(c = root->clos->attrcols))
+	c = root->clos->attrcols = agalloc(root, sizeof(Agattrcols_t));
+    if (id >= c->ncol[k]) {
+	size_t n = c->ncol[k] * 2 > id + 1 ? c->ncol[k] * 2 : id + 1;
+	c->col[k] = agrealloc(root, c->col[k], c->ncol[k] * sizeof(agattrcol_t *),
+			      n * sizeof(agattrcol_t *));
+	c->ncol[k] = n;
+    }
+    assert(c->col[k][id] == NULL);
+    c->col[k][id] = agattrcol_open(root, sym->defval);
+}
+
+static void closecolumns(Agraph_t * root)
+{
+    Agattrcols_t *c = root->clos->attrcols;
+
+    if (!c)
+	return;
+    for (int k = 0; k < 2; k++) {
+	for (size_t i = 0; i < c->ncol[k]; i++)
+	    agattrcol_close(root, c->col[k][i]);
+	agfree(root, c->col[k]);
+    }
+    agfree(root, c);
+    root->clos->attrcols = NULL;
+}
+
+/* give a new object the defaults of the graph it was created in */
+static void colinit(Agraph_t * context, void *obj)
+{
+    Dict_t *dict = agdictof(context, AGTYPE(obj));
+    uint64_t maxseq = context->clos->seq[AGTYPE(obj) == AGNODE ? AGNODE : AGEDGE];
+    Agsym_t *sym;
+
+    for (sym = dtfirst(dict); sym; sym = dtnext(dict, sym)) {
+	agattrcol_t *col = column(obj, sym->id);
+	if (sym->defval != agattrcol_get(col, AGSEQ(obj)))
+	    agattrcol_set(agroot(obj), col, AGSEQ(obj), maxseq, sym->defval);
+    }
+}
+
+static void coldelete(void *obj)
+{
+    Agattrcols_t *c = agroot(obj)->clos->attrcols;
+    int kind = kindindex(obj);
+
+    if (!c)
+	return;
+    for (size_t i = 0; i < c->ncol[kind]; i++) {
+	if (c->col[kind][i])
+	    agattrcol_unset(agroot(obj), c->col[kind][i], AGSEQ(obj));
+    }
+}
+
+void agnodeattr_renumber(Agnode_t * n, uint64_t seq)
+{
+    Agraph_t *root = agroot(n);
+    Agattrcols_t *c = root->clos->attrcols;
+
+    if (!c || !root->desc.columnar)
+	return;
+    for (size_t i = 0; i < c->ncol[0]; i++) {
+	if (c->col[0][i])
+	    agattrcol_move(root, c->col[0][i], AGSEQ(n), seq,
+			   root->clos->seq[AGNODE]);
+    }
+}
+
 static int topdictsize(Agobj_t * obj)
 {
     Dict_t *d;
@@ -307,7 +480,9 @@ static Agsym_t *setattr(Agraph_t * g, int kind, char *name, const char *value) {
 	    rdict = agdictof(root, kind);
 	    rsym = agnewsym(g, name, value, dtsize(rdict), kind);
 	    dtinsert(rdict, rsym);
-	    switch (kind) {
+	    if (kind != AGRAPH && root->desc.columnar)
+		newcolumn(root, kind, rsym);
+	    else switch (kind) {
 	    case AGRAPH:
 		agapply(root, (Agobj_t *) root, (agobjfn_t) addattr,
 			rsym, TRUE);
@@ -342,8 +517,10 @@ static Agsym_t *setattr(Agraph_t * g, int kind, char *name, const char *value) {
  */
 Agsym_t *agattr(Agraph_t * g, int kind, char *name, const char *value) {
     Agsym_t *rv;
+    bool locked = false;
 
     if (g == 0) {
+	locked = proto_lock();
 	if (ProtoGraph == 0)
 	    ProtoGraph = agopen(0, ProtoDesc, 0);
 	g = ProtoGraph;
@@ -352,6 +529,7 @@ Agsym_t *agattr(Agraph_t * g, int kind, char *name, const char *value) {
 	rv = setattr(g, kind, name, value);
     else
 	rv = getattr(g, kind, name);
+    proto_unlock(locked);
     return rv;
 }
 
@@ -394,6 +572,9 @@ int agraphattr_delete(Agraph_t * g)
 	agdelrec(g, attr->h.name);
     }
 
+    if (g == agroot(g))
+	closecolumns(g);
+
     if ((dd = agdatadict(g, FALSE))) {
 	if (agdtclose(g, dd->dict.n)) return 1;
 	if (agdtclose(g, dd->dict.e)) return 1;
@@ -407,6 +588,10 @@ void agnodeattr_init(Agraph_t * g, Agnode_t * n)
 {
     Agattr_t *data;
 
+    if (columnar(n)) {
+	colinit(g, n);
+	return;
+    }
     data = agattrrec(n);
     if (!data || !data->dict)
 	(void) agmakeattrs(g, n);
@@ -416,6 +601,10 @@ void agnodeattr_delete(Agnode_t * n)
 {
     Agattr_t *rec;
 
+    if (columnar(n)) {
+	coldelete(n);
+	return;
+    }
     if ((rec = agattrrec(n))) {
 	freeattr((Agobj_t *) n, rec);
 	agdelrec(n, AgDataRecName);
@@ -426,6 +615,10 @@ void agedgeattr_init(Agraph_t * g, Agedge_t * e)
 {
     Agattr_t *data;
 
+    if (columnar(e)) {
+	colinit(g, e);
+	return;
+    }
     data = agattrrec(e);
     if (!data || !data->dict)
 	(void) agmakeattrs(g, e);
@@ -435,6 +628,10 @@ void agedgeattr_delete(Agedge_t * e)
 {
     Agattr_t *rec;
 
+    if (columnar(e)) {
+	coldelete(e);
+	return;
+    }
     if ((rec = agattrrec(e))) {
 	freeattr((Agobj_t *) e, rec);
 	agdelrec(e, AgDataRecName);
@@ -444,16 +641,13 @@ void agedgeattr_delete(Agedge_t * e)
 char *agget(void *obj, char *name)
 {
     Agsym_t *sym;
-    Agattr_t *data;
     char *rv;
 
     sym = agattrsym(obj, name);
     if (sym == NULL)
 	rv = 0;			/* note was "", but this provides more info */
-    else {
-	data = agattrrec(obj);
-	rv = data->str[sym->id];
-    }
+    else
+	rv = agxget(obj, sym);
     return rv;
 }
 
@@ -462,12 +656,233 @@ char *agxget(void *obj, Agsym_t * sym)
     Agattr_t *data;
     char *rv;
 
+    if (columnar(obj))
+	return agattrcol_get(column(obj, sym->id), AGSEQ(obj));
     data = agattrrec(obj);
     assert(sym->id >= 0 && sym->id < topdictsize(obj));
     rv = data->str[sym->id];
     return rv;
 }
 
+/*
+ * parsed attribute values
+ *
+ * Layouts read numeric attributes such as width or weight of every node and
+ * edge, often in several phases. Parsed values are kept in columns indexed by
+ * sequence number, one per attribute id and representation. The columns hang
+ * off the root graph's closure, so subgraph symbols that share an id with a
+ * root symbol also share its columns.
+ *
+ * The first read of a column parses the attribute of every node or edge of the
+ * graph at once, and agxset parses the new value of an object it changes into
+ * every column of that attribute. Other reads only look values up, so once a
+ * column is built, threads can read it together. Each entry names the object
+ * it was parsed for. Objects that are not in the graph, such as dot's virtual
+ * nodes and edges, or were created after the column was built, find no entry
+ * and are parsed on every read.
+ */
+
+typedef enum { CACHE_DOUBLE, CACHE_INT, CACHE_POINT, CACHE_TYPES } cachetype_t;
+
+typedef struct {
+    const void *obj;		/* object parsed for, NULL if none */
+    bool ok;			/* did it parse? */
+    union {
+	double d;
+	long i;
+	double p[2];
+    } u;
+} cacheval_t;
+
+typedef struct {
+    cacheval_t *val;		/* values by sequence number */
+    size_t size;		/* allocated entries of val */
+} cachecol_t;
+
+struct Agattrcache_s {
+    cachecol_t *col[2][CACHE_TYPES];	/* node and edge columns by symbol id */
+    size_t ncol[2][CACHE_TYPES];	/* allocated entries of col */
+};
+
+/* the object whose entry holds the values of obj: edges are kept under
+ * their out-edge half */
+static const void *cacheowner(void *obj)
+{
+    return AGTYPE(obj) == AGINEDGE ? (void *)AGMKOUT((Agedge_t *) obj) : obj;
+}
+
+/* parse an attribute value */
+static void parse(const char *s, cachetype_t type, cacheval_t * v)
+{
+    char *endp;
+
+    v->ok = false;
+    if (!s || !s[0])
+	return;
+    switch (type) {
+    case CACHE_DOUBLE:
+	v->u.d = strtod(s, &endp);
+	v->ok = endp != s;
+	break;
+    case CACHE_INT:
+	v->u.i = strtol(s, &endp, 10);
+	v->ok = endp != s;
+	break;
+    case CACHE_POINT:
+	v->ok = sscanf(s, "%lf,%lf", &v->u.p[0], &v->u.p[1]) == 2;
+	break;
+    default:
+	UNREACHABLE();
+    }
+}
+
+/* record the value of an attribute of an object in a column, growing the
+ * column if need be */
+static void cachestore(Agraph_t * root, cachecol_t * col, void *obj,
+		       Agsym_t * sym, cachetype_t type)
+{
+    size_t seq = AGSEQ(obj), n;
+
+    if (seq >= col->size) {
+	/* make room for every object of this kind that exists */
+	n = root->clos->seq[AGTYPE(obj) == AGNODE ? AGNODE : AGEDGE] + 1;
+	if (n < col->size * 2)
+	    n = col->size * 2;
+	if (n <= seq)
+	    n = seq + 1;
+	cacheval_t *val = agrealloc(root, col->val,
+				    col->size * sizeof(cacheval_t),
+				    n * sizeof(cacheval_t));
+	if (!val)
+	    return;
+	col->val = val;
+	col->size = n;
+    }
+    col->val[seq].obj = cacheowner(obj);
+    parse(agxget(obj, sym), type, &col->val[seq]);
+}
+
+/* find the column of an attribute of a kind of object, building it if
+ * asked to */
+static cachecol_t *cachecol(void *obj, Agsym_t * sym, cachetype_t type,
+			    bool build)
+{
+    Agraph_t *g = agroot(obj);
+    Agattrcache_t *c = g->clos->attrcache;
+    cachecol_t *col;
+    int kind = kindindex(obj);
+    size_t id = (size_t) sym->id, n;
+
+    if (kind < 0)
+	return NULL;
+    if (c && id < c->ncol[kind][type] && c->col[kind][type][id].val)
+	return &c->col[kind][type][id];
+    if (!build)
+	return NULL;
+
+    if (!c) {
+	if (!(c = agalloc(g, sizeof(Agattrcache_t))))
+	    return NULL;
+	g->clos->attrcache = c;
+    }
+    if (id >= c->ncol[kind][type]) {
+	n = id + 1 < MINATTR ? MINATTR : id + 1;
+	col = agrealloc(g, c->col[kind][type],
+			c->ncol[kind][type] * sizeof(cachecol_t),
+			n * sizeof(cachecol_t));
+	if (!col)
+	    return NULL;
+	c->col[kind][type] = col;
+	c->ncol[kind][type] = n;
+    }
+
+    /* parse the value of every object of this kind */
+    col = &c->col[kind][type][id];
+    for (Agnode_t *v = agfstnode(g); v; v = agnxtnode(g, v)) {
+	if (kind == 0) {
+	    cachestore(g, col, v, sym, type);
+	} else {
+	    for (Agedge_t *e = agfstout(g, v); e; e = agnxtout(g, e))
+		cachestore(g, col, e, sym, type);
+	}
+    }
+    return col->val ? col : NULL;
+}
+
+/* parse the new values of an attribute of an object into its columns */
+static void cacheupdate(void *obj, Agsym_t * sym)
+{
+    Agraph_t *g = agroot(obj);
+
+    if (!g->clos->attrcache || kindindex(obj) < 0)
+	return;
+    for (int type = 0; type < CACHE_TYPES; type++) {
+	cachecol_t *col = cachecol(obj, sym, type, false);
+	if (col)
+	    cachestore(g, col, obj, sym, type);
+    }
+}
+
+void agattrcache_free(Agraph_t * g)
+{
+    Agattrcache_t *c = g->clos->attrcache;
+
+    if (!c)
+	return;
+    for (int kind = 0; kind < 2; kind++) {
+	for (int type = 0; type < CACHE_TYPES; type++) {
+	    for (size_t id = 0; id < c->ncol[kind][type]; id++)
+		agfree(g, c->col[kind][type][id].val);
+	    agfree(g, c->col[kind][type]);
+	}
+    }
+    agfree(g, c);
+    g->clos->attrcache = NULL;
+}
+
+/* fetch the parsed value of an attribute, or parse it if the object has no
+ * entry */
+static const cacheval_t *cacheparse(void *obj, Agsym_t * sym,
+				     cachetype_t type, cacheval_t * buf)
+{
+    cachecol_t *col = cachecol(obj, sym, type, true);
+    size_t seq = AGSEQ(obj);
+
+    if (col && seq < col->size && col->val[seq].obj == cacheowner(obj))
+	return &col->val[seq];
+    parse(agxget(obj, sym), type, buf);
+    return buf;
+}
+
+int agxgetdouble(void *obj, Agsym_t * sym, double *value)
+{
+    cacheval_t buf;
+    const cacheval_t *v = cacheparse(obj, sym, CACHE_DOUBLE, &buf);
+    if (v->ok)
+	*value = v->u.d;
+    return v->ok;
+}
+
+int agxgetint(void *obj, Agsym_t * sym, long *value)
+{
+    cacheval_t buf;
+    const cacheval_t *v = cacheparse(obj, sym, CACHE_INT, &buf);
+    if (v->ok)
+	*value = v->u.i;
+    return v->ok;
+}
+
+int agxgetpoint(void *obj, Agsym_t * sym, double *x, double *y)
+{
+    cacheval_t buf;
+    const cacheval_t *v = cacheparse(obj, sym, CACHE_POINT, &buf);
+    if (v->ok) {
+	*x = v->u.p[0];
+	*y = v->u.p[1];
+    }
+    return v->ok;
+}
+
 int agset(void *obj, char *name, const char *value) {
     Agsym_t *sym;
     int rv;
@@ -489,10 +904,16 @@ int agxset(void *obj, Agsym_t * sym, const char *value)
 
     g = agraphof(obj);
     hdr = obj;
-    data = agattrrec(hdr);
-    assert(sym->id >= 0 && sym->id < topdictsize(obj));
-    agstrfree(g, data->str[sym->id]);
-    data->str[sym->id] = agstrdup(g, value);
+    if (columnar(obj)) {
+	agattrcol_set(g, column(obj, sym->id), AGSEQ(obj),
+		      g->clos->seq[AGTYPE(obj) == AGNODE ? AGNODE : AGEDGE], value);
+    } else {
+	data = agattrrec(hdr);
+	assert(sym->id >= 0 && sym->id < topdictsize(obj));
+	agstrfree(g, data->str[sym->id]);
+	data->str[sym->id] = agstrdup(g, value);
+    }
+    cacheupdate(obj, sym);
     if (hdr->tag.objtype == AGRAPH) {
 	/* also update dict default */
 	Dict_t *dict;
@@ -539,6 +960,9 @@ static void init_all_attrs(Agraph_t * g)
 
     root = agroot(g);
     agapply(root, (Agobj_t*)root, agraphattr_init_wrapper, NULL, TRUE);
+    /* columnar nodes and edges already take the column defaults */
+    if (root->desc.columnar)
+	return;
     for (n = agfstnode(root); n; n = agnxtnode(root, n)) {
 	agnodeattr_init(g, n);
 	for (e = agfstout(root, n); e; e = agnxtout(root, e)) {
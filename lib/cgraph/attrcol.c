@@ -0,0 +1,211 @@
+/*************************************************************************
+ * Copyright (c) 2011 AT&T Intellectual Property
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors: Details at https://graphviz.org
+ *************************************************************************/
+
+/*
+ * columns of node or edge attribute values
+ *
+ * In a graph opened with the columnar descriptor flag, the values of a node
+ * or edge attribute are kept per attribute rather than per object. Most
+ * objects take the value the column was created with, its base, and cost
+ * nothing. The others are overrides, held in a hash table keyed by sequence
+ * number while they are few and in an array indexed by sequence number once
+ * they are not.
+ */
+
+#include <cgraph/cghdr.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+    uint64_t seq;
+    char *value;		/* NULL if this slot is empty */
+} slot_t;
+
+struct agattrcol_s {
+    char *base;			/* value of objects without an override */
+    char **dense;		/* overrides by sequence number, if many */
+    slot_t *slots;		/* otherwise, open addressed overrides */
+    size_t size;		/* entries of dense or slots */
+    size_t count;		/* number of overrides */
+};
+
+#define MINSLOTS 8
+
+static size_t hash(uint64_t seq, size_t size)
+{
+    return (size_t) ((seq * UINT64_C(0x9E3779B97F4A7C15)) >> 32) & (size - 1);
+}
+
+/* slot holding seq, or the empty slot where it would go */
+static slot_t *lookup(const agattrcol_t * col, uint64_t seq)
+{
+    size_t i = hash(seq, col->size);
+    while (col->slots[i].value && col->slots[i].seq != seq)
+	i = (i + 1) & (col->size - 1);
+    return &col->slots[i];
+}
+
+agattrcol_t *agattrcol_open(Agraph_t * g, const char *base)
+{
+    agattrcol_t *col = agalloc(g, sizeof(agattrcol_t));
+    col->base = agstrdup(g, base);
+    return col;
+}
+
+void agattrcol_close(Agraph_t * g, agattrcol_t * col)
+{
+    if (!col)
+	return;
+    for (size_t i = 0; i < col->size; i++) {
+	if (col->dense)
+	    agstrfree(g, col->dense[i]);
+	else if (col->slots[i].value)
+	    agstrfree(g, col->slots[i].value);
+    }
+    agfree(g, col->dense);
+    agfree(g, col->slots);
+    agstrfree(g, col->base);
+    agfree(g, col);
+}
+
+char *agattrcol_get(const agattrcol_t * col, uint64_t seq)
+{
+    char *rv = NULL;
+
+    if (col->dense) {
+	if (seq < col->size)
+	    rv = col->dense[seq];
+    } else if (col->count > 0)
+	rv = lookup(col, seq)->value;
+    return rv ? rv : col->base;
+}
+
+/* move the overrides into an array once it is no bigger than the table */
+static void densify(Agraph_t * g, agattrcol_t * col, size_t nobj)
+{
+    for (size_t i = 0; i < col->size; i++) {
+	if (col->slots[i].value && col->slots[i].seq >= nobj)
+	    nobj = (size_t) col->slots[i].seq + 1;
+    }
+    char **dense = agalloc(g, nobj * sizeof(char *));
+    for (size_t i = 0; i < col->size; i++) {
+	if (col->slots[i].value)
+	    dense[col->slots[i].seq] = col->slots[i].value;
+    }
+    agfree(g, col->slots);
+    col->slots = NULL;
+    col->dense = dense;
+    col->size = nobj;
+}
+
+static void rehash(Agraph_t * g, agattrcol_t * col, size_t size)
+{
+    slot_t *old = col->slots;
+    size_t oldsize = col->size;
+
+    col->slots = agalloc(g, size * sizeof(slot_t));
+    col->size = size;
+    for (size_t i = 0; i < oldsize; i++) {
+	if (old[i].value)
+	    *lookup(col, old[i].seq) = old[i];
+    }
+    agfree(g, old);
+}
+
+void agattrcol_set(Agraph_t * g, agattrcol_t * col, uint64_t seq,
+		   uint64_t maxseq, const char *value)
+{
+    char *s = agstrdup(g, value);
+
+    if (s == col->base) {
+	agstrfree(g, s);
+	agattrcol_unset(g, col, seq);
+	return;
+    }
+
+    if (!col->dense) {
+	slot_t *slot = col->size ? lookup(col, seq) : NULL;
+	if (slot && slot->value) {
+	    agstrfree(g, slot->value);
+	    slot->value = s;
+	    return;
+	}
+	/* a table is half empty, so costs four pointers per override */
+	if (maxseq < seq)
+	    maxseq = seq;
+	if ((col->count + 1) * 4 > maxseq + 1) {
+	    densify(g, col, (size_t) maxseq + 1);
+	} else {
+	    if ((col->count + 1) * 2 > col->size)
+		rehash(g, col, col->size ? col->size * 2 : MINSLOTS);
+	    slot = lookup(col, seq);
+	    slot->seq = seq;
+	    slot->value = s;
+	    col->count++;
+	    return;
+	}
+    }
+
+    if (seq >= col->size) {
+	size_t size = col->size * 2 > seq + 1 ? col->size * 2 : (size_t) seq + 1;
+	col->dense = agrealloc(g, col->dense, col->size * sizeof(char *),
+			       size * sizeof(char *));
+	col->size = size;
+    }
+    if (col->dense[seq])
+	agstrfree(g, col->dense[seq]);
+    else
+	col->count++;
+    col->dense[seq] = s;
+}
+
+void agattrcol_unset(Agraph_t * g, agattrcol_t * col, uint64_t seq)
+{
+    if (col->dense) {
+	if (seq < col->size && col->dense[seq]) {
+	    agstrfree(g, col->dense[seq]);
+	    col->dense[seq] = NULL;
+	    col->count--;
+	}
+	return;
+    }
+    if (col->count == 0)
+	return;
+
+    slot_t *slot = lookup(col, seq);
+    if (!slot->value)
+	return;
+    agstrfree(g, slot->value);
+    slot->value = NULL;
+    col->count--;
+
+    /* shift back any later entries that could no longer be found */
+    size_t mask = col->size - 1;
+    size_t hole = (size_t) (slot - col->slots);
+    for (size_t i = (hole + 1) & mask; col->slots[i].value; i = (i + 1) & mask) {
+	size_t home = hash(col->slots[i].seq, col->size);
+	if (((i - home) & mask) >= ((i - hole) & mask)) {
+	    col->slots[hole] = col->slots[i];
+	    col->slots[i].value = NULL;
+	    hole = i;
+	}
+    }
+}
+
+void agattrcol_move(Agraph_t * g, agattrcol_t * col, uint64_t from,
+		    uint64_t to, uint64_t maxseq)
+{
+    char *value = agattrcol_get(col, from);
+
+    if (value == col->base)
+	return;
+    agattrcol_set(g, col, to, maxseq, value);
+    agattrcol_unset(g, col, from);
+}
@@ -0,0 +1,646 @@
+/*************************************************************************
+ * Copyright (c) 2011 AT&T Intellectual Property
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors: Details at https://graphviz.org
+ *************************************************************************/
+
+#include <assert.h>
+#include <cgraph/agxbuf.h>
+#include <cgraph/alloc.h>
+#include <cgraph/cghdr.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* binary graph snapshots
+ *
+ * A snapshot is a versioned, little-endian image of a root graph: its
+ * attribute dictionaries, nodes, edges and subgraph tree. Every string is
+ * stored once in a table at the front of the image, NUL terminated, so a
+ * reader can intern it straight out of a memory mapping and then refer to it
+ * by index. Objects refer to each other by index too, so loading a snapshot
+ * is a single pass of object construction with no lexing or parsing.
+ *
+ * Layout:
+ *
+ *   header   magic "\x89GVB", u32 version, u64 body length
+ *   strings  u32 count, then per string: u32 length, u8 flags, bytes, NUL
+ *   root     u8 descriptor flags, u32 name,
+ *            declarations for graphs, nodes and edges: u32 count, then per
+ *              attribute: u32 name, u32 default, u8 flags,
+ *            graph values: u32 count, then pairs of u32 attribute, u32 value,
+ *            nodes: u32 count, then per node: u32 name, values,
+ *            edges: u32 count, then per edge: u32 tail, u32 head, u32 key,
+ *              values,
+ *            u32 count of subgraphs
+ *   subgraph (repeated for each child, in preorder)
+ *            u32 name, graph, node and edge declarations, graph values,
+ *            u32 count of member nodes and their indices,
+ *            u32 count of member edges and their indices,
+ *            u32 count of child subgraphs, then the children
+ *
+ * Names and keys of anonymous objects are written as NONE.
+ */
+
+static const char Magic[4] = {'\x89', 'G', 'V', 'B'};
+
+enum {
+  VERSION = 1,
+  HEADER_SIZE = 16,
+  NONE = UINT32_MAX, ///< index of a missing string
+};
+
+/// string table flags
+enum { STR_HTML = 1 };
+
+/// root descriptor flags
+enum { DESC_DIRECTED = 1, DESC_STRICT = 2, DESC_NO_LOOP = 4 };
+
+/// attribute declaration flags
+enum { SYM_PRINT = 1, SYM_FIXED = 2 };
+
+bool agisbinary(const char *data, size_t size) {
+  return size >= sizeof(Magic) && memcmp(data, Magic, sizeof(Magic)) == 0;
+}
+
+/* writing */
+
+/// an entry in the string table, keyed by the address of the string
+typedef struct {
+  Dtlink_t link;
+  const char *s;
+  uint32_t index;
+} strindex_t;
+
+static void strindex_free(Dt_t *dt, void *obj, Dtdisc_t *disc) {
+  (void)dt;
+  (void)disc;
+  free(obj);
+}
+
+static Dtdisc_t Strindexdisc = {
+    .key = offsetof(strindex_t, s),
+    .size = sizeof(char *),
+    .link = offsetof(strindex_t, link),
+    .freef = strindex_free,
+};
+
+typedef struct {
+  Agraph_t *root;
+  Dict_t *strs;     ///< strings already in the table
+  uint32_t nstrs;   ///< number of strings in the table
+  agxbuf table;     ///< the string table
+  agxbuf body;      ///< everything following the string table
+  Agnode_t **nodes; ///< root nodes, in sequence order
+  size_t nnodes;
+  Agedge_t **edges; ///< root edges, in sequence order
+  size_t nedges;
+  bool overflow;    ///< a count or length did not fit in 32 bits
+} writer_t;
+
+static void put8(agxbuf *xb, uint8_t v) { agxbputc(xb, (char)v); }
+
+static void put32(agxbuf *xb, uint32_t v) {
+  char b[4];
+  for (size_t i = 0; i < sizeof(b); ++i)
+    b[i] = (char)(v >> (8 * i));
+  agxbput_n(xb, b, sizeof(b));
+}
+
+static void put64(agxbuf *xb, uint64_t v) {
+  char b[8];
+  for (size_t i = 0; i < sizeof(b); ++i)
+    b[i] = (char)(v >> (8 * i));
+  agxbput_n(xb, b, sizeof(b));
+}
+
+static void putcount(writer_t *w, size_t n) {
+  if (n >= NONE)
+    w->overflow = true;
+  put32(&w->body, (uint32_t)n);
+}
+
+/// index of \p s in the string table, adding it if needed
+static uint32_t strid(writer_t *w, const char *s) {
+  if (s == NULL)
+    return NONE;
+
+  strindex_t key = {.s = s};
+  strindex_t *e = dtsearch(w->strs, &key);
+  if (e != NULL)
+    return e->index;
+
+  const size_t len = strlen(s);
+  if (len >= NONE || w->nstrs == NONE - 1)
+    w->overflow = true;
+  // only strings owned by the graph's string dictionary carry the HTML mark
+  const bool html = agstrbind(w->root, s) == s && aghtmlstr(s);
+  put32(&w->table, (uint32_t)len);
+  put8(&w->table, html ? STR_HTML : 0);
+  agxbput_n(&w->table, s, len + 1);
+
+  e = gv_alloc(sizeof(strindex_t));
+  e->s = s;
+  e->index = w->nstrs++;
+  dtinsert(w->strs, e);
+  return e->index;
+}
+
+/// index of the name of \p obj, or NONE if it is anonymous
+static uint32_t nameid(writer_t *w, void *obj) {
+  const char *name = agnameof(obj);
+  if (name == NULL || name[0] == LOCALNAMEPREFIX)
+    return NONE;
+  return strid(w, name);
+}
+
+static int cmpseq(const void *x, const void *y) {
+  const Agobj_t *const *a = x;
+  const Agobj_t *const *b = y;
+  if (AGSEQ(*a) < AGSEQ(*b))
+    return -1;
+  if (AGSEQ(*a) > AGSEQ(*b))
+    return 1;
+  return 0;
+}
+
+/// position of \p obj in \p objs, sorted by sequence number
+static uint32_t seqindex(void *objs, size_t n, void *obj) {
+  void **found = bsearch(&obj, objs, n, sizeof(void *), cmpseq);
+  assert(found != NULL && "subgraph member missing from root graph");
+  return (uint32_t)(found - (void **)objs);
+}
+
+/// the attribute dictionary of \p g for \p kind, if any
+static Dict_t *dictof(Agraph_t *g, int kind) {
+  Agdatadict_t *dd = agdatadict(g, FALSE);
+  if (dd == NULL)
+    return NULL;
+  switch (kind) {
+  case AGRAPH:
+    return dd->dict.g;
+  case AGNODE:
+    return dd->dict.n;
+  default:
+    return dd->dict.e;
+  }
+}
+
+static void write_decl(writer_t *w, Agsym_t *sym) {
+  put32(&w->body, strid(w, sym->name));
+  put32(&w->body, strid(w, sym->defval));
+  put8(&w->body,
+       (uint8_t)((sym->print ? SYM_PRINT : 0) | (sym->fixed ? SYM_FIXED : 0)));
+}
+
+/// write the attribute declarations of \p g for \p kind
+///
+/// The root's declarations are written in order of their ids, so values can
+/// refer to them by id. For a subgraph, only its local declarations are
+/// written.
+static void write_decls(writer_t *w, Agraph_t *g, int kind) {
+  Dict_t *dict = dictof(g, kind);
+  if (dict == NULL) {
+    putcount(w, 0);
+    return;
+  }
+  const size_t n = (size_t)dtsize(dict);
+  putcount(w, n);
+  if (g == w->root) {
+    Agsym_t **syms = gv_calloc(n, sizeof(Agsym_t *));
+    for (Agsym_t *sym = dtfirst(dict); sym != NULL; sym = dtnext(dict, sym)) {
+      assert(sym->id >= 0 && (size_t)sym->id < n);
+      syms[sym->id] = sym;
+    }
+    for (size_t i = 0; i < n; ++i)
+      write_decl(w, syms[i]);
+    free(syms);
+    return;
+  }
+  Dict_t *view = dtview(dict, NULL);
+  for (Agsym_t *sym = dtfirst(dict); sym != NULL; sym = dtnext(dict, sym))
+    write_decl(w, sym);
+  dtview(dict, view);
+}
+
+/// does \p obj have a value for \p sym other than the one it would be
+/// created with?
+///
+/// Nodes and edges are recreated in the root graph, so take the root's
+/// defaults. A graph starts with the defaults visible through its own
+/// dictionary, which include those it inherits from its parent.
+static bool differs(void *obj, Agsym_t *sym) {
+  const char *value = agxget(obj, sym);
+  const char *dflt = sym->defval;
+  if (AGTYPE(obj) == AGRAPH)
+    dflt = agattr(obj, AGRAPH, sym->name, NULL)->defval;
+  return value != dflt && strcmp(value, dflt) != 0;
+}
+
+/// write the values of \p obj that differ from its defaults
+static void write_values(writer_t *w, void *obj, int kind) {
+  size_t n = 0;
+  if (agattrrec(obj) != NULL || w->root->desc.columnar) {
+    for (Agsym_t *sym = agnxtattr(w->root, kind, NULL); sym != NULL;
+         sym = agnxtattr(w->root, kind, sym))
+      n += differs(obj, sym);
+  }
+  putcount(w, n);
+  if (n == 0)
+    return;
+  for (Agsym_t *sym = agnxtattr(w->root, kind, NULL); sym != NULL;
+       sym = agnxtattr(w->root, kind, sym)) {
+    if (differs(obj, sym)) {
+      put32(&w->body, (uint32_t)sym->id);
+      put32(&w->body, strid(w, agxget(obj, sym)));
+    }
+  }
+}
+
+static void write_subg(writer_t *w, Agraph_t *g) {
+  put32(&w->body, nameid(w, g));
+  write_decls(w, g, AGRAPH);
+  write_decls(w, g, AGNODE);
+  write_decls(w, g, AGEDGE);
+  write_values(w, g, AGRAPH);
+
+  putcount(w, (size_t)agnnodes(g));
+  for (Agnode_t *n = agfstnode(g); n != NULL; n = agnxtnode(g, n))
+    put32(&w->body, seqindex(w->nodes, w->nnodes, n));
+
+  putcount(w, (size_t)agnedges(g));
+  for (Agnode_t *n = agfstnode(g); n != NULL; n = agnxtnode(g, n))
+    for (Agedge_t *e = agfstout(g, n); e != NULL; e = agnxtout(g, e))
+      put32(&w->body, seqindex(w->edges, w->nedges, e));
+
+  putcount(w, (size_t)agnsubg(g));
+  for (Agraph_t *subg = agfstsubg(g); subg != NULL; subg = agnxtsubg(subg))
+    write_subg(w, subg);
+}
+
+static size_t filewrite(void *chan, const char *buf, size_t len) {
+  return fwrite(buf, 1, len, chan);
+}
+
+int agwrite_binary(Agraph_t *g, void *chan,
+                   size_t (*write)(void *chan, const char *buf, size_t len)) {
+  Agraph_t *root = agroot(g);
+  writer_t w = {.root = root, .strs = dtopen(&Strindexdisc, Dtoset)};
+  int rc = 0;
+
+  if (write == NULL)
+    write = filewrite;
+
+  w.nnodes = (size_t)agnnodes(root);
+  w.nodes = gv_calloc(w.nnodes, sizeof(Agnode_t *));
+  w.nedges = (size_t)agnedges(root);
+  w.edges = gv_calloc(w.nedges, sizeof(Agedge_t *));
+  {
+    size_t i = 0, j = 0;
+    for (Agnode_t *n = agfstnode(root); n != NULL; n = agnxtnode(root, n)) {
+      w.nodes[i++] = n;
+      for (Agedge_t *e = agfstout(root, n); e != NULL; e = agnxtout(root, e))
+        w.edges[j++] = e;
+    }
+  }
+  qsort(w.edges, w.nedges, sizeof(Agedge_t *), cmpseq);
+
+  put8(&w.body, (uint8_t)((agisdirected(root) ? DESC_DIRECTED : 0) |
+                          (agisstrict(root) ? DESC_STRICT : 0) |
+                          (root->desc.no_loop ? DESC_NO_LOOP : 0)));
+  put32(&w.body, nameid(&w, root));
+  write_decls(&w, root, AGRAPH);
+  write_decls(&w, root, AGNODE);
+  write_decls(&w, root, AGEDGE);
+  write_values(&w, root, AGRAPH);
+
+  putcount(&w, w.nnodes);
+  for (size_t i = 0; i < w.nnodes; ++i) {
+    put32(&w.body, nameid(&w, w.nodes[i]));
+    write_values(&w, w.nodes[i], AGNODE);
+  }
+
+  putcount(&w, w.nedges);
+  for (size_t i = 0; i < w.nedges; ++i) {
+    Agedge_t *e = w.edges[i];
+    put32(&w.body, seqindex(w.nodes, w.nnodes, agtail(e)));
+    put32(&w.body, seqindex(w.nodes, w.nnodes, aghead(e)));
+    put32(&w.body, strid(&w, agnameof(e)));
+    write_values(&w, e, AGEDGE);
+  }
+
+  putcount(&w, (size_t)agnsubg(root));
+  for (Agraph_t *subg = agfstsubg(root); subg != NULL; subg = agnxtsubg(subg))
+    write_subg(&w, subg);
+
+  if (w.overflow) {
+    agerr(AGERR, "graph %s is too large for a binary snapshot\n",
+          agnameof(root));
+    rc = EOF;
+  } else {
+    agxbuf header = {0};
+    agxbput_n(&header, Magic, sizeof(Magic));
+    put32(&header, VERSION);
+    put64(&header, (uint64_t)(4 + agxblen(&w.table) + agxblen(&w.body)));
+    put32(&header, w.nstrs);
+
+    const size_t hlen = agxblen(&header);
+    const size_t tlen = agxblen(&w.table);
+    const size_t blen = agxblen(&w.body);
+    if (write(chan, agxbuse(&header), hlen) != hlen ||
+        write(chan, agxbuse(&w.table), tlen) != tlen ||
+        write(chan, agxbuse(&w.body), blen) != blen)
+      rc = EOF;
+    agxbfree(&header);
+  }
+
+  free(w.edges);
+  free(w.nodes);
+  agxbfree(&w.body);
+  agxbfree(&w.table);
+  dtclose(w.strs);
+  return rc;
+}
+
+/* reading */
+
+typedef struct {
+  const unsigned char *p;   ///< read position
+  const unsigned char *end; ///< end of the image
+  bool bad;                 ///< image is truncated or malformed
+  Agraph_t *root;
+  char **strs;              ///< interned string table
+  uint32_t nstrs;
+  Agsym_t **syms[3];        ///< root declarations, per kind, in file order
+  uint32_t nsyms[3];
+  Agnode_t **nodes;
+  uint32_t nnodes;
+  Agedge_t **edges;
+  uint32_t nedges;
+} reader_t;
+
+static uint64_t getn(reader_t *r, size_t n) {
+  if ((size_t)(r->end - r->p) < n) {
+    r->bad = true;
+    r->p = r->end;
+    return 0;
+  }
+  uint64_t v = 0;
+  for (size_t i = 0; i < n; ++i)
+    v |= (uint64_t)r->p[i] << (8 * i);
+  r->p += n;
+  return v;
+}
+
+static uint8_t get8(reader_t *r) { return (uint8_t)getn(r, 1); }
+
+static uint32_t get32(reader_t *r) { return (uint32_t)getn(r, 4); }
+
+/// read a count of items that each take at least \p size bytes
+static uint32_t getcount(reader_t *r, size_t size) {
+  uint32_t n = get32(r);
+  if ((size_t)(r->end - r->p) / size < n) {
+    r->bad = true;
+    return 0;
+  }
+  return n;
+}
+
+/// read an index less than \p n
+static uint32_t getindex(reader_t *r, uint32_t n) {
+  uint32_t i = get32(r);
+  if (i >= n) {
+    r->bad = true;
+    return 0;
+  }
+  return i;
+}
+
+/// read a string index, returning the interned string or NULL for NONE
+static char *getstr(reader_t *r) {
+  uint32_t i = get32(r);
+  if (i == NONE)
+    return NULL;
+  if (i >= r->nstrs) {
+    r->bad = true;
+    return NULL;
+  }
+  return r->strs[i];
+}
+
+/// read a string index that must not be NONE
+static char *getstr_nonnull(reader_t *r) {
+  char *s = getstr(r);
+  if (s == NULL)
+    r->bad = true;
+  return s;
+}
+
+static int kindindex(int kind) { return kind == AGINEDGE ? AGEDGE : kind; }
+
+static void read_decls(reader_t *r, Agraph_t *g, int kind) {
+  const int k = kindindex(kind);
+  uint32_t n = getcount(r, 9);
+  if (g == r->root) {
+    r->syms[k] = gv_calloc(n, sizeof(Agsym_t *));
+    r->nsyms[k] = n;
+  }
+  for (uint32_t i = 0; i < n && !r->bad; ++i) {
+    char *name = getstr_nonnull(r);
+    char *dflt = getstr_nonnull(r);
+    uint8_t flags = get8(r);
+    if (r->bad)
+      break;
+    Agsym_t *sym = agattr(g, kind, name, dflt);
+    sym->print = (flags & SYM_PRINT) != 0;
+    sym->fixed = (flags & SYM_FIXED) != 0;
+    if (g == r->root)
+      r->syms[k][i] = sym;
+  }
+}
+
+static void read_values(reader_t *r, void *obj, int kind) {
+  const int k = kindindex(kind);
+  uint32_t n = getcount(r, 8);
+  for (uint32_t i = 0; i < n && !r->bad; ++i) {
+    uint32_t id = getindex(r, r->nsyms[k]);
+    char *value = getstr_nonnull(r);
+    if (r->bad)
+      break;
+    if (kind == AGRAPH) {
+      // Store the value without agxset, which would also make it the default
+      // for this graph's subgraphs. The defaults were restored as declared.
+      Agraph_t *g = obj;
+      Agattr_t *attr = agattrrec(g);
+      const int sid = r->syms[k][id]->id;
+      agstrfree(g, attr->str[sid]);
+      attr->str[sid] = agstrdup(g, value);
+    } else {
+      agxset(obj, r->syms[k][id], value);
+    }
+  }
+}
+
+static void read_subg(reader_t *r, Agraph_t *parent) {
+  char *name = getstr(r);
+  if (r->bad)
+    return;
+  Agraph_t *g = agsubg(parent, name, 1);
+  read_decls(r, g, AGRAPH);
+  read_decls(r, g, AGNODE);
+  read_decls(r, g, AGEDGE);
+  read_values(r, g, AGRAPH);
+
+  uint32_t n = getcount(r, 4);
+  for (uint32_t i = 0; i < n && !r->bad; ++i) {
+    uint32_t id = getindex(r, r->nnodes);
+    if (!r->bad)
+      agsubnode(g, r->nodes[id], 1);
+  }
+  n = getcount(r, 4);
+  for (uint32_t i = 0; i < n && !r->bad; ++i) {
+    uint32_t id = getindex(r, r->nedges);
+    if (!r->bad)
+      agsubedge(g, r->edges[id], 1);
+  }
+  n = getcount(r, 4);
+  for (uint32_t i = 0; i < n && !r->bad; ++i)
+    read_subg(r, g);
+}
+
+/// read the string table, leaving \p r->strs pointing into the image
+static void read_strings(reader_t *r) {
+  r->nstrs = getcount(r, 6);
+  r->strs = gv_calloc(r->nstrs, sizeof(char *));
+  for (uint32_t i = 0; i < r->nstrs && !r->bad; ++i) {
+    uint32_t len = get32(r);
+    (void)get8(r);
+    if (r->bad || (size_t)(r->end - r->p) <= len || r->p[len] != '\0') {
+      r->bad = true;
+      break;
+    }
+    // Suppress Clang/GCC -Wcast-qual warning. The image is only read from
+    // until the string is interned below.
+#ifdef __GNUC__
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wcast-qual"
+#endif
+    r->strs[i] = (char *)r->p;
+#ifdef __GNUC__
+#pragma GCC diagnostic pop
+#endif
+    r->p += len + 1;
+  }
+}
+
+/// replace the string table entries with strings owned by \p r->root
+static void intern_strings(reader_t *r) {
+  for (uint32_t i = 0; i < r->nstrs; ++i) {
+    // the flags byte immediately precedes the string's bytes
+    const unsigned char *flags = (const unsigned char *)r->strs[i] - 1;
+    r->strs[i] = (*flags & STR_HTML) ? agstrdup_html(r->root, r->strs[i])
+                                     : agstrdup(r->root, r->strs[i]);
+  }
+}
+
+Agraph_t *agread_binary(const char *data, size_t size, size_t *used,
+                        Agdisc_t *disc) {
+  if (!agisbinary(data, size) || size < HEADER_SIZE) {
+    agerr(AGERR, "not a binary graph snapshot\n");
+    return NULL;
+  }
+  reader_t r = {.p = (const unsigned char *)data + sizeof(Magic),
+                .end = (const unsigned char *)data + HEADER_SIZE};
+  uint32_t version = get32(&r);
+  uint64_t len = getn(&r, 8);
+  if (version != VERSION) {
+    agerr(AGERR, "unsupported binary graph snapshot version %u\n",
+          (unsigned)version);
+    return NULL;
+  }
+  if (len > size - HEADER_SIZE) {
+    agerr(AGERR, "truncated binary graph snapshot\n");
+    return NULL;
+  }
+  r.end = r.p + len;
+
+  read_strings(&r);
+  uint8_t flags = get8(&r);
+  const char *name = getstr(&r);
+  if (r.bad) {
+    free(r.strs);
+    agerr(AGERR, "corrupt binary graph snapshot\n");
+    return NULL;
+  }
+
+  Agdesc_t desc = {.directed = (flags & DESC_DIRECTED) != 0,
+                   .strict = (flags & DESC_STRICT) != 0,
+                   .no_loop = (flags & DESC_NO_LOOP) != 0,
+                   .maingraph = 1};
+  // Suppress Clang/GCC -Wcast-qual warning. agopen does not modify the name.
+#ifdef __GNUC__
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wcast-qual"
+#endif
+  r.root = agopen((char *)name, desc, disc);
+#ifdef __GNUC__
+#pragma GCC diagnostic pop
+#endif
+  intern_strings(&r);
+
+  read_decls(&r, r.root, AGRAPH);
+  read_decls(&r, r.root, AGNODE);
+  read_decls(&r, r.root, AGEDGE);
+  read_values(&r, r.root, AGRAPH);
+
+  r.nnodes = getcount(&r, 8);
+  r.nodes = gv_calloc(r.nnodes, sizeof(Agnode_t *));
+  for (uint32_t i = 0; i < r.nnodes && !r.bad; ++i) {
+    r.nodes[i] = agnode(r.root, getstr(&r), 1);
+    read_values(&r, r.nodes[i], AGNODE);
+  }
+
+  r.nedges = getcount(&r, 16);
+  r.edges = gv_calloc(r.nedges, sizeof(Agedge_t *));
+  for (uint32_t i = 0; i < r.nedges && !r.bad; ++i) {
+    uint32_t t = getindex(&r, r.nnodes);
+    uint32_t h = getindex(&r, r.nnodes);
+    char *key = getstr(&r);
+    if (r.bad)
+      break;
+    r.edges[i] = agedge(r.root, r.nodes[t], r.nodes[h], key, 1);
+    if (r.edges[i] == NULL) {
+      r.bad = true;
+      break;
+    }
+    read_values(&r, r.edges[i], AGEDGE);
+  }
+
+  uint32_t n = getcount(&r, 4);
+  for (uint32_t i = 0; i < n && !r.bad; ++i)
+    read_subg(&r, r.root);
+
+  for (uint32_t i = 0; i < r.nstrs; ++i)
+    agstrfree(r.root, r.strs[i]);
+  free(r.strs);
+  for (size_t i = 0; i < sizeof(r.syms) / sizeof(r.syms[0]); ++i)
+    free(r.syms[i]);
+  free(r.nodes);
+  free(r.edges);
+
+  if (r.bad || r.p != r.end) {
+    agerr(AGERR, "corrupt binary graph snapshot\n");
+    agclose(r.root);
+    return NULL;
+  }
+  if (used != NULL)
+    *used = HEADER_SIZE + (size_t)len;
+  return r.root;
+}
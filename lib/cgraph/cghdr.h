@@ -33,6 +33,7 @@
 #include		<stdlib.h>
 #include		<string.h>
 #include <assert.h>
+#include <cgraph/tls.h>
 #include <stdint.h>
 
 static inline bool streq(const char *a, const char *b) {
@@ -53,7 +54,7 @@ CGHDR_API int agapply(Agraph_t * g, Agobj_t * obj, agobjfn_t fn, void *arg,
 	    int preorder);
 
 	/* global variables */
-extern Agraph_t *Ag_G_global;
+extern TLS Agraph_t *Ag_G_global;	/* graph being read, per thread */
 extern char *AgDataRecName;
 
 	/* set ordering disciplines */
@@ -98,13 +99,39 @@ void agnodeattr_init(Agraph_t *g, Agnode_t * n);
 void agnodeattr_delete(Agnode_t * n);
 void agedgeattr_init(Agraph_t *g, Agedge_t * e);
 void agedgeattr_delete(Agedge_t * e);
+void agattrcache_free(Agraph_t * g);
+void agnodeattr_renumber(Agnode_t * n, uint64_t seq);
+
+/* a column of node or edge attribute values, see attrcol.c */
+typedef struct agattrcol_s agattrcol_t;
+agattrcol_t *agattrcol_open(Agraph_t * g, const char *base);
+void agattrcol_close(Agraph_t * g, agattrcol_t * col);
+char *agattrcol_get(const agattrcol_t * col, uint64_t seq);
+void agattrcol_set(Agraph_t * g, agattrcol_t * col, uint64_t seq,
+		   uint64_t maxseq, const char *value);
+void agattrcol_unset(Agraph_t * g, agattrcol_t * col, uint64_t seq);
+void agattrcol_move(Agraph_t * g, agattrcol_t * col, uint64_t from,
+		    uint64_t to, uint64_t maxseq);
+
+/* edges by endpoints, see edgeindex.c */
+void agedgeindex_insert(Agraph_t * g, Agedge_t * e);
+void agedgeindex_delete(Agraph_t * g, Agedge_t * e);
+Agedge_t *agedgeindex_find(Agraph_t * g, Agnode_t * t, Agnode_t * h,
+			   Agtag_t key);
+void agedgeindex_close(Agraph_t * g);
+
+/* adjacency snapshots, see csr.c */
+void agcsrstale(Agraph_t * g);
 
 	/* parsing and lexing graph files */
-int aagparse(void);
-void aglexinit(Agdisc_t * disc, void *ifile);
-int aaglex(void);
-void aglexeof(void);
-void aglexbad(void);
+typedef void *aagscan_t;	/* a scanner, as flex's yyscan_t */
+typedef struct aagstate_s aagstate_t;	/* the parser's state in one read */
+aagscan_t aglexinit(Agdisc_t * disc, void *ifile);
+void aglexeof(aagscan_t scanner);
+void aglexbad(aagscan_t scanner);
+void aglexerror(aagscan_t scanner, const char *str);
+const char *aginputfile(void);
+bool agisbinary(const char *data, size_t size);
 
 	/* ID management */
 int agmapnametoid(Agraph_t * g, int objtype, char *str,
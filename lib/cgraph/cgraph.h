@@ -76,6 +76,12 @@ typedef struct Agrec_s Agrec_t;         ///< generic runtime record
 typedef struct Agdatadict_s Agdatadict_t; ///< set of dictionaries per graph
 typedef struct Agedgepair_s Agedgepair_t; ///< the edge object
 typedef struct Agsubnode_s Agsubnode_t;
+typedef struct Agmapped_s Agmapped_t;   ///< file image for in-place parsing
+typedef struct Agattrcache_s Agattrcache_t; ///< parsed attribute values
+typedef struct Agattrcols_s Agattrcols_t; ///< columnar attribute values
+typedef struct Agcsr_s Agcsr_t;         ///< adjacency snapshot
+typedef struct Agedgeindex_s Agedgeindex_t; ///< edges by endpoints
+typedef struct Agstreamdisc_s Agstreamdisc_t; ///< handlers for streamed reading
 
 /** @brief Header of a user record.
 
@@ -167,6 +173,8 @@ struct Agdesc_s {		/* graph descriptor */
     unsigned no_write:1;	/* if a temporary subgraph */
     unsigned has_attrs:1;	/* if string attr tables should be initialized */
     unsigned has_cmpnd:1;	/* if may contain collapsed nodes */
+    unsigned columnar:1;	/* if node and edge attribute values are
+				   stored by attribute rather than by object */
 };
 
 /* disciplines for external resources needed by libgraph */
@@ -217,6 +225,18 @@ CGRAPH_API extern Agiodisc_t AgIoDisc;
 
 CGRAPH_API extern Agdisc_t AgDefaultDisc;
 
+/** @brief arena memory discipline
+ *
+ * Objects are allocated from large per-graph chunks and never freed
+ * individually, so building a graph is cheaper and @ref agclose of the root
+ * graph releases everything at once. Memory of deleted objects is only
+ * reclaimed when the root graph is closed. Pass @ref AgArenaDisc to
+ * @ref agopen or @ref agread to use it.
+ */
+CGRAPH_API extern Agmemdisc_t AgArenaMemDisc;
+/// default discipline with @ref AgArenaMemDisc for memory
+CGRAPH_API extern Agdisc_t AgArenaDisc;
+
 struct Agdstate_s {
     void *mem;
     void *id;
@@ -253,6 +273,9 @@ struct Agclos_s {
     unsigned char callbacks_enabled;	/* issue user callbacks or hold them? */
     Dict_t *lookup_by_name[3];
     Dict_t *lookup_by_id[3];
+    Agattrcache_t *attrcache;	/* parsed numeric attribute values */
+    Agattrcols_t *attrcols;	/* node and edge values of a columnar graph */
+    uint64_t changes;		/* count of changes to node and edge sets */
 };
 
 struct Agraph_s {
@@ -265,6 +288,8 @@ struct Agraph_s {
     Dict_t *g_dict;		/* subgraphs - descendants */
     Agraph_t *parent, *root;	/* subgraphs - ancestors */
     Agclos_t *clos;		/* shared resources */
+    Agcsr_t *csr;		/* cached adjacency snapshot */
+    Agedgeindex_t *edgeindex;	/* edges by endpoints, if indexed */
 };
 
 CGRAPH_API void agpushdisc(Agraph_t * g, Agcbdisc_t * disc, void *state);
@@ -280,7 +305,103 @@ CGRAPH_API Agraph_t *agmemconcat(Agraph_t *g, const char *cp);
 CGRAPH_API void agreadline(int);
 CGRAPH_API void agsetfile(const char *);
 CGRAPH_API Agraph_t *agconcat(Agraph_t * g, void *chan, Agdisc_t * disc);
+
+/** @brief map a graph file into memory for parsing
+ *
+ * The file is mapped read only, and the lexer is handed large blocks of it
+ * rather than lines read through @ref Agiodisc_s::afread. Only regular files
+ * can be mapped; for anything else this fails and the caller should fall back
+ * to @ref agread on a stdio stream.
+ *
+ * @param filename Path of the file to map
+ * @return A handle for @ref agmapread or NULL (with errno set) on failure
+ */
+CGRAPH_API Agmapped_t *agmapopen(const char *filename);
+/// read the next graph from a mapped file, as @ref agread does for a stream
+CGRAPH_API Agraph_t *agmapread(Agmapped_t *m, Agdisc_t *disc);
+/// merge the next graph from a mapped file, as @ref agconcat does
+CGRAPH_API Agraph_t *agmapconcat(Agraph_t *g, Agmapped_t *m, Agdisc_t *disc);
+/// release a file mapped by @ref agmapopen
+CGRAPH_API int agmapclose(Agmapped_t *m);
 CGRAPH_API int agwrite(Agraph_t * g, void *chan);
+
+/** @brief write a binary snapshot of a root graph
+ *
+ * The snapshot holds the attribute declarations, nodes, edges, subgraphs and
+ * attribute values of @ref agroot of `g`. It can be reloaded with
+ * @ref agread_binary much faster than DOT text can be parsed. Layout results
+ * are included to the extent they are stored as attributes.
+ *
+ * @param g Graph to write
+ * @param chan Output channel passed to `write`
+ * @param write Output function, or NULL if `chan` is a `FILE*`
+ * @return 0 on success or EOF on failure
+ */
+CGRAPH_API int agwrite_binary(Agraph_t *g, void *chan,
+                              size_t (*write)(void *chan, const char *buf,
+                                              size_t len));
+
+/** @brief load a graph from a binary snapshot
+ *
+ * @param data Snapshot image, as written by @ref agwrite_binary
+ * @param size Number of bytes available at `data`
+ * @param [out] used If non-NULL, set to the length of the snapshot consumed
+ * @param disc Discipline for the new graph, or NULL for the default
+ * @return The new root graph or NULL if the image is malformed
+ */
+CGRAPH_API Agraph_t *agread_binary(const char *data, size_t size, size_t *used,
+                                   Agdisc_t *disc);
+
+/// a name or value read by @ref agstream
+typedef struct {
+  const char *data; ///< not NUL terminated, valid until the handler returns
+  size_t size;      ///< length in bytes
+  int html;         ///< was this given as an HTML-like `<...>` string?
+} Agtext_t;
+
+/** @brief handlers for the parts of graphs read by @ref agstream
+ *
+ * Any handler may be NULL. A handler returning nonzero stops the read.
+ * Attribute lists are `nattrs` pairs, the name of the `i`th in `attrs[2*i]`
+ * and its value in `attrs[2*i+1]`. Ports of edge endpoints are given as
+ * `tailport` and `headport` attributes and an edge key as `key`, as the
+ * parser would set them.
+ */
+struct Agstreamdisc_s {
+  int (*graph)(void *state, Agtext_t name, Agdesc_t desc);
+  int (*endgraph)(void *state);
+  int (*subgraph)(void *state, Agtext_t name); ///< `name.data` NULL if none
+  int (*endsubgraph)(void *state);
+  /// a node statement, once for each node it names
+  int (*node)(void *state, Agtext_t name, size_t nattrs,
+              const Agtext_t *attrs);
+  /// an edge statement, once for each edge it makes
+  int (*edge)(void *state, Agtext_t tail, Agtext_t head, size_t nattrs,
+              const Agtext_t *attrs);
+  /// a default attribute statement for objects of `kind`, such as
+  /// `node [shape=box]`, or an `AGRAPH` attribute such as `rankdir=LR`
+  int (*attr)(void *state, int kind, size_t nattrs, const Agtext_t *attrs);
+};
+
+/** @brief read DOT text without building graphs
+ *
+ * Parses every graph in `chan` as @ref agread would, calling a handler for
+ * each graph, subgraph, node, edge and attribute statement instead of
+ * creating objects, so memory use is bounded by the longest statement rather
+ * than the size of the graphs. Edge endpoints are reported only by the edge
+ * handler, unless an empty subgraph leaves them without edges, when the node
+ * handler gets them without attributes. A subgraph used as an edge endpoint
+ * stands for the nodes named inside it.
+ *
+ * @param chan Input channel passed to `io`
+ * @param io Input discipline, or NULL if `chan` is a `FILE*`
+ * @param handlers Functions to call
+ * @param state Passed to every handler
+ * @return 0 at the end of the input, -1 after a syntax error, or the
+ *   nonzero value a handler returned
+ */
+CGRAPH_API int agstream(void *chan, Agiodisc_t *io, Agstreamdisc_t *handlers,
+                        void *state);
 CGRAPH_API int agisdirected(Agraph_t * g);
 CGRAPH_API int agisundirected(Agraph_t * g);
 CGRAPH_API int agisstrict(Agraph_t * g);
@@ -310,6 +431,10 @@ CGRAPH_API Agedge_t *agfstout(Agraph_t * g, Agnode_t * n);
 CGRAPH_API Agedge_t *agnxtout(Agraph_t * g, Agedge_t * e);
 CGRAPH_API Agedge_t *agfstedge(Agraph_t * g, Agnode_t * n);
 CGRAPH_API Agedge_t *agnxtedge(Agraph_t * g, Agedge_t * e, Agnode_t * n);
+/// keep, if `flag` is non-zero, or drop a hash index of the edges of `g` by
+/// their endpoints, which speeds up `agedge` lookups on nodes of high degree;
+/// returns whether `g` was indexed before
+CGRAPH_API int agedgeindex(Agraph_t * g, int flag);
 
 /* generic */
 CGRAPH_API Agraph_t *agraphof(void* obj);
@@ -381,6 +506,24 @@ CGRAPH_API int agxset(void *obj, Agsym_t * sym, const char *value);
 CGRAPH_API int agsafeset(void* obj, char* name, const char* value,
                          const char* def);
 
+/* parsed attribute values
+ *
+ * These parse an attribute value as a number. For nodes and edges, the
+ * first read of an attribute parses it for every node or edge of the graph
+ * and keeps the results, which agxset keeps up to date, so that later reads
+ * do not parse strings again. That first read modifies the graph as agxset
+ * does: make it before several threads read the graph at once.
+ *
+ * Each returns non-zero if the value parsed, and leaves its output untouched
+ * if the value is empty or malformed.
+ */
+/// value as by `strtod`
+CGRAPH_API int agxgetdouble(void *obj, Agsym_t *sym, double *value);
+/// value as by `strtol` in base 10
+CGRAPH_API int agxgetint(void *obj, Agsym_t *sym, long *value);
+/// value as a pair of comma separated numbers `x,y`
+CGRAPH_API int agxgetpoint(void *obj, Agsym_t *sym, double *x, double *y);
+
 /* definitions for subgraphs */
 CGRAPH_API Agraph_t *agsubg(Agraph_t * g, char *name, int cflag);	/* constructor */
 CGRAPH_API Agraph_t *agidsubg(Agraph_t * g, IDTYPE id, int cflag);	/* constructor */
@@ -388,6 +531,32 @@ CGRAPH_API Agraph_t *agfstsubg(Agraph_t * g);
 CGRAPH_API Agraph_t *agnxtsubg(Agraph_t * subg);
 CGRAPH_API Agraph_t *agparent(Agraph_t * g);
 
+/* adjacency snapshots
+ *
+ * agcsr returns the nodes of a graph in agfstnode order with their out and
+ * in edges in compressed sparse row form, in the order agfstout/agnxtout and
+ * agfstin/agnxtin visit them. The snapshot belongs to the graph, and is
+ * reused until a node or edge is next added to, deleted from or reordered
+ * in the root graph or any of its subgraphs. Such a change frees the root
+ * graph's snapshot; agcsrfree frees that of any graph sooner than agclose
+ * would. agcsr returns NULL if memory is exhausted.
+ */
+struct Agcsr_s {
+    int nnodes, nedges;
+    Agnode_t **node;		/* the nodes in sequence */
+    int *out;			/* outedge[out[i]] to outedge[out[i+1]-1] are those of node[i] */
+    Agedge_t **outedge;		/* out edges by tail */
+    int *head;			/* index of the head of each out edge */
+    int *in;			/* inedge[in[i]] to inedge[in[i+1]-1] are those of node[i] */
+    Agedge_t **inedge;		/* in edges by head */
+    int *tail;			/* index of the tail of each in edge */
+};
+CGRAPH_API const Agcsr_t *agcsr(Agraph_t * g);
+/// index of `n` in the snapshot's `node` array, or -1 if it is not there
+CGRAPH_API int agcsrindex(const Agcsr_t * csr, Agnode_t * n);
+/// free the snapshot of `g`, if any
+CGRAPH_API void agcsrfree(Agraph_t * g);
+
 /* set cardinality */
 CGRAPH_API int agnnodes(Agraph_t * g);
 CGRAPH_API int agnedges(Agraph_t * g);
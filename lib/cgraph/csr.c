@@ -0,0 +1,189 @@
+/*************************************************************************
+ * Copyright (c) 2011 AT&T Intellectual Property
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors: Details at https://graphviz.org
+ *************************************************************************/
+
+/*
+ * compressed sparse row snapshots of a graph's adjacency
+ *
+ * A snapshot lists the nodes of a graph or subgraph in sequence, and the out
+ * and in edges of each in the order agfstout/agnxtout and agfstin/agnxtin
+ * would visit them, so that layout engines converting a graph to their own
+ * arrays can do so in a single pass over flat memory. The snapshot is kept
+ * with the graph and reused until the root graph next gains, loses or
+ * reorders a node or edge. The root graph's snapshot is freed by that change,
+ * and those of subgraphs by their next use or agcsrfree.
+ */
+
+#include <cgraph/cghdr.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+    Agcsr_t csr;		/* must be first */
+    uint64_t changes;		/* value of the root's counter when built */
+    int *index;			/* node indices hashed by sequence number, -1 if free */
+    size_t mask;		/* entries of index less one */
+} csr_t;
+
+void agcsrstale(Agraph_t * g)
+{
+    g->clos->changes++;
+    agcsrfree(agroot(g));
+}
+
+void agcsrfree(Agraph_t * g)
+{
+    csr_t *c = (csr_t *) g->csr;
+
+    if (!c)
+	return;
+    agfree(g, c->csr.node);
+    agfree(g, c->csr.out);
+    agfree(g, c->csr.outedge);
+    agfree(g, c->csr.head);
+    agfree(g, c->csr.in);
+    agfree(g, c->csr.inedge);
+    agfree(g, c->csr.tail);
+    agfree(g, c->index);
+    agfree(g, c);
+    g->csr = NULL;
+}
+
+static size_t hash(const csr_t * c, uint64_t seq)
+{
+    return (size_t) ((seq * UINT64_C(0x9E3779B97F4A7C15)) >> 32) & c->mask;
+}
+
+/* index of the node with a sequence number, or -1 */
+static int find(const csr_t * c, uint64_t seq)
+{
+    size_t h;
+    int i;
+
+    for (h = hash(c, seq); (i = c->index[h]) >= 0; h = (h + 1) & c->mask) {
+	if (AGSEQ(c->csr.node[i]) == seq)
+	    return i;
+    }
+    return -1;
+}
+
+/* append the edges of one of a node's edge sets, with the sequence numbers of
+ * their far ends for now, returning the new count
+ */
+static int edgeset(Agraph_t * g, Dtlink_t ** set, Agedge_t *** edges,
+		   int **ends, int *cap, int k)
+{
+    Dtlink_t *lk;
+    Agedge_t *e;
+
+    dtrestore(g->e_seq, *set);
+    for (lk = dtflatten(g->e_seq); lk; lk = dtlink(g->e_seq, lk)) {
+	if (k == *cap) {
+	    int size = *cap ? 2 * *cap : 64;
+	    Agedge_t **grown = agrealloc(g, *edges, *cap * sizeof(Agedge_t *),
+					 size * sizeof(Agedge_t *));
+	    int *grownends = grown ? agrealloc(g, *ends, *cap * sizeof(int),
+					       size * sizeof(int)) : NULL;
+	    if (grown)
+		*edges = grown;
+	    if (!grownends) {
+		k = -1;
+		break;
+	    }
+	    *ends = grownends;
+	    *cap = size;
+	}
+	e = dtobj(g->e_seq, lk);
+	(*edges)[k] = e;
+	(*ends)[k++] = (int) AGSEQ(e->node);	/* the head of an out edge, the tail of an in edge */
+    }
+    *set = dtextract(g->e_seq);
+    return k;
+}
+
+static csr_t *build(Agraph_t * g)
+{
+    csr_t *c;
+    Agsubnode_t *sn;
+    Dtlink_t *lk;
+    int i, k, nnodes, nedges, outcap = 0, incap = 0;
+    size_t h, nindex;
+
+    nnodes = agnnodes(g);
+    if (!(c = agalloc(g, sizeof(csr_t))))
+	return NULL;
+    g->csr = &c->csr;		/* so that agcsrfree can clean up */
+    c->changes = g->clos->changes;
+    c->csr.nnodes = nnodes;
+    c->csr.node = agalloc(g, (nnodes + 1) * sizeof(Agnode_t *));
+    c->csr.out = agalloc(g, (nnodes + 1) * sizeof(int));
+    c->csr.in = agalloc(g, (nnodes + 1) * sizeof(int));
+    /* at most half full */
+    for (nindex = 2; nindex < 2 * (size_t) nnodes; nindex *= 2);
+    c->mask = nindex - 1;
+    c->index = agalloc(g, nindex * sizeof(int));
+    if (!c->csr.node || !c->csr.out || !c->csr.in || !c->index)
+	goto fail;
+    for (h = 0; h < nindex; h++)
+	c->index[h] = -1;
+
+    /* one walk over the node set and each node's edge sets, which are
+     * flattened into lists rather than searched for each successor
+     */
+    i = 0;
+    for (lk = dtflatten(g->n_seq); lk; lk = dtlink(g->n_seq, lk)) {
+	sn = dtobj(g->n_seq, lk);
+	c->csr.node[i] = sn->node;
+	for (h = hash(c, AGSEQ(sn->node)); c->index[h] >= 0;
+	     h = (h + 1) & c->mask);
+	c->index[h] = i;
+	c->csr.out[i + 1] = edgeset(g, &sn->out_seq, &c->csr.outedge,
+				    &c->csr.head, &outcap, c->csr.out[i]);
+	c->csr.in[i + 1] = edgeset(g, &sn->in_seq, &c->csr.inedge,
+				   &c->csr.tail, &incap, c->csr.in[i]);
+	if (c->csr.out[i + 1] < 0 || c->csr.in[i + 1] < 0)
+	    goto fail;
+	i++;
+    }
+    assert(i == nnodes);
+    nedges = c->csr.nedges = c->csr.out[nnodes];
+    assert(c->csr.in[nnodes] == nedges);
+
+    /* the far ends by index, now that every node has one */
+    for (k = 0; k < nedges; k++) {
+	c->csr.head[k] = find(c, (uint64_t) c->csr.head[k]);
+	c->csr.tail[k] = find(c, (uint64_t) c->csr.tail[k]);
+    }
+    return c;
+
+  fail:
+    agcsrfree(g);
+    return NULL;
+}
+
+const Agcsr_t *agcsr(Agraph_t * g)
+{
+    csr_t *c = (csr_t *) g->csr;
+
+    if (c && c->changes == g->clos->changes)
+	return &c->csr;
+    agcsrfree(g);
+    if (!(c = build(g)))
+	return NULL;
+    return &c->csr;
+}
+
+int agcsrindex(const Agcsr_t * csr, Agnode_t * n)
+{
+    const csr_t *c = (const csr_t *) csr;
+    int i = find(c, AGSEQ(n));
+
+    /* a copy of a node is not the node */
+    return i >= 0 && c->csr.node[i] == n ? i : -1;
+}
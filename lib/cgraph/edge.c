@@ -113,6 +113,8 @@ static Agedge_t *agfindedge_by_key(Agraph_t * g, Agnode_t * t, Agnode_t * h,
 
     if (t == NULL || h == NULL)
 	return NULL;
+    if (g->edgeindex)
+	return agedgeindex_find(g, t, h, key);
     template.base.tag = key;
     template.node = t;		/* guess that fan-in < fan-out */
     sn = agsubrep(g, h);
@@ -174,6 +176,7 @@ static void installedge(Agraph_t * g, Agedge_t * e)
     in = AGMKIN(e);
     t = agtail(e);
     h = aghead(e);
+    agcsrstale(g);
     while (g) {
 	if (agfindedge_by_key(g, t, h, AGTAG(e))) break;
 	sn = agsubrep(g, t);
@@ -182,6 +185,7 @@ static void installedge(Agraph_t * g, Agedge_t * e)
 	sn = agsubrep(g, h);
 	ins(g->e_seq, &sn->in_seq, in);
 	ins(g->e_id, &sn->in_id, in);
+	agedgeindex_insert(g, e);
 	g = agparent(g);
     }
 }
@@ -214,7 +218,8 @@ static Agedge_t *newedge(Agraph_t * g, Agnode_t * t, Agnode_t * h,
 
     installedge(g, out);
     if (g->desc.has_attrs) {
-	(void)agbindrec(out, AgDataRecName, sizeof(Agattr_t), false);
+	if (!agroot(g)->desc.columnar)
+	    (void)agbindrec(out, AgDataRecName, sizeof(Agattr_t), false);
 	agedgeattr_init(g, out);
     }
     agmethod_init(g, out);
@@ -320,12 +325,14 @@ void agdeledgeimage(Agraph_t * g, Agedge_t * e, void *ignored)
     }
     t = in->node;
     h = out->node;
+    agcsrstale(g);
     sn = agsubrep(g, t);
     del(g->e_seq, &sn->out_seq, out);
     del(g->e_id, &sn->out_id, out);
     sn = agsubrep(g, h);
     del(g->e_seq, &sn->in_seq, in);
     del(g->e_id, &sn->in_id, in);
+    agedgeindex_delete(g, in);
 #ifdef DEBUG
     for (e = agfstin(g,h); e; e = agnxtin(g,e))
 	assert(e != in);
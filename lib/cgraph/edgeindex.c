@@ -0,0 +1,184 @@
+/*************************************************************************
+ * Copyright (c) 2011 AT&T Intellectual Property
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors: Details at https://graphviz.org
+ *************************************************************************/
+
+/*
+ * hash index of a graph's edges by their endpoints
+ *
+ * Without one, finding the edge from t to h searches the set of h's in-edges,
+ * which costs a splay tree search per lookup and is slow for nodes with very
+ * many edges. A graph may instead keep its edges in an open addressed table
+ * hashed on the (tail, head) pair. Strict graphs look up every edge they are
+ * asked to create, so the parser indexes them.
+ *
+ * The table holds the in-edge half of each edge, which is what a search of
+ * the in-edge sets returns.
+ */
+
+#include <cgraph/cghdr.h>
+#include <stddef.h>
+#include <stdint.h>
+
+struct Agedgeindex_s {
+    Agedge_t **slots;		/* in-edges, NULL if empty */
+    size_t size;		/* a power of 2, or 0 */
+    size_t count;
+};
+
+#define MINSLOTS 16
+
+static Agnode_t *tailof(Agedge_t * in)
+{
+    return in->node;
+}
+
+static Agnode_t *headof(Agedge_t * in)
+{
+    return AGIN2OUT(in)->node;
+}
+
+static size_t hash(Agnode_t * t, Agnode_t * h, size_t size)
+{
+    uint64_t x = (uint64_t) (uintptr_t) t * UINT64_C(0x9E3779B97F4A7C15)
+	+ (uint64_t) (uintptr_t) h;
+    x *= UINT64_C(0xC2B2AE3D27D4EB4F);
+    return (size_t) (x >> 32) & (size - 1);
+}
+
+static void insert(Agedgeindex_t * ix, Agedge_t * in)
+{
+    size_t i = hash(tailof(in), headof(in), ix->size);
+    while (ix->slots[i])
+	i = (i + 1) & (ix->size - 1);
+    ix->slots[i] = in;
+    ix->count++;
+}
+
+static int resize(Agraph_t * g, Agedgeindex_t * ix, size_t size)
+{
+    Agedge_t **old = ix->slots;
+    size_t oldsize = ix->size;
+
+    if (!(ix->slots = agalloc(g, size * sizeof(Agedge_t *)))) {
+	ix->slots = old;
+	return FAILURE;
+    }
+    ix->size = size;
+    ix->count = 0;
+    for (size_t i = 0; i < oldsize; i++) {
+	if (old[i])
+	    insert(ix, old[i]);
+    }
+    agfree(g, old);
+    return SUCCESS;
+}
+
+void agedgeindex_insert(Agraph_t * g, Agedge_t * e)
+{
+    Agedgeindex_t *ix = g->edgeindex;
+
+    if (!ix)
+	return;
+    /* keep the table at most half full */
+    if ((ix->count + 1) * 2 > ix->size &&
+	resize(g, ix, ix->size ? ix->size * 2 : MINSLOTS) != SUCCESS) {
+	/* no room, so fall back to searching the edge sets */
+	agedgeindex(g, FALSE);
+	return;
+    }
+    insert(ix, AGMKIN(e));
+}
+
+void agedgeindex_delete(Agraph_t * g, Agedge_t * e)
+{
+    Agedgeindex_t *ix = g->edgeindex;
+    size_t i, hole, mask;
+
+    if (!ix || ix->count == 0)
+	return;
+    e = AGMKIN(e);
+    mask = ix->size - 1;
+    for (i = hash(tailof(e), headof(e), ix->size); ix->slots[i] != e;
+	 i = (i + 1) & mask) {
+	if (!ix->slots[i])
+	    return;
+    }
+    ix->slots[i] = NULL;
+    ix->count--;
+
+    /* shift back any later entries that could no longer be found */
+    hole = i;
+    for (i = (hole + 1) & mask; ix->slots[i]; i = (i + 1) & mask) {
+	size_t home = hash(tailof(ix->slots[i]), headof(ix->slots[i]), ix->size);
+	if (((i - home) & mask) >= ((i - hole) & mask)) {
+	    ix->slots[hole] = ix->slots[i];
+	    ix->slots[i] = NULL;
+	    hole = i;
+	}
+    }
+}
+
+/* The edge from t to h with the given key, or if the key's objtype is 0,
+ * the first such edge created.
+ */
+Agedge_t *agedgeindex_find(Agraph_t * g, Agnode_t * t, Agnode_t * h,
+			   Agtag_t key)
+{
+    Agedgeindex_t *ix = g->edgeindex;
+    Agedge_t *e, *rv = NULL;
+
+    if (ix->count == 0)
+	return NULL;
+    for (size_t i = hash(t, h, ix->size); (e = ix->slots[i]);
+	 i = (i + 1) & (ix->size - 1)) {
+	if (tailof(e) != t || headof(e) != h)
+	    continue;
+	if (key.objtype == 0) {
+	    if (!rv || AGSEQ(e) < AGSEQ(rv))
+		rv = e;
+	} else if (AGID(e) == key.id)
+	    return e;
+    }
+    return rv;
+}
+
+void agedgeindex_close(Agraph_t * g)
+{
+    Agedgeindex_t *ix = g->edgeindex;
+
+    if (!ix)
+	return;
+    agfree(g, ix->slots);
+    agfree(g, ix);
+    g->edgeindex = NULL;
+}
+
+int agedgeindex(Agraph_t * g, int flag)
+{
+    Agnode_t *n;
+    Agedge_t *e;
+    int prev = g->edgeindex != NULL;
+
+    if (!flag) {
+	agedgeindex_close(g);
+	return prev;
+    }
+    if (prev)
+	return prev;
+    if (!(g->edgeindex = agalloc(g, sizeof(Agedgeindex_t))))
+	return prev;
+    for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
+	for (e = agfstout(g, n); e; e = agnxtout(g, e)) {
+	    agedgeindex_insert(g, e);
+	    if (!g->edgeindex)
+		return prev;
+	}
+    }
+    return prev;
+}
@@ -16,6 +16,17 @@
    */
 %define api.prefix {aag}
 
+  /* Keep all parser state in an argument rather than in globals, so that
+   * threads can each read graphs at the same time.
+   */
+%define api.pure full
+%param {aagscan_t scanner}
+%parse-param {aagstate_t *C}
+
+%code requires {
+#include <cghdr.h>
+}
+
 %{
 
 #include <stdbool.h>
@@ -24,10 +35,8 @@
 #include <cgraph/alloc.h>
 #include <cgraph/unreachable.h>
 #include <stddef.h>
-extern void aagerror(const char*);
 
 static char Key[] = "key";
-static int SubgraphDepth = 0;
 
 typedef union s {					/* possible items in generic list */
 		Agnode_t		*n;
@@ -57,30 +66,35 @@ typedef struct gstack_s {
 	struct gstack_s *down;
 } gstack_t;
 
+/* state of one read */
+struct aagstate_s {
+	Agraph_t *G;				/* top level graph */
+	Agdisc_t	*Disc;		/* discipline passed to agread or agconcat */
+	gstack_t *S;
+	int SubgraphDepth;
+};
+
 /* functions */
-static void appendnode(char *name, char *port, char *sport);
-static void attrstmt(int tkind, char *macroname);
-static void startgraph(char *name, bool directed, bool strict);
-static void getedgeitems(void);
-static void newedge(Agnode_t *t, char *tport, Agnode_t *h, char *hport, char *key);
-static void edgerhs(Agnode_t *n, char *tport, item *hlist, char *key);
-static void appendattr(char *name, char *value);
-static void bindattrs(int kind);
-static void applyattrs(void *obj);
-static void endgraph(void);
-static void endnode(void);
-static void endedge(void);
-static void freestack(void);
-static char* concat(char*, char*);
-static char* concatPort(char*, char*);
-
-static void opensubg(char *name);
-static void closesubg(void);
-
-/* global */
-static Agraph_t *G;				/* top level graph */
-static	Agdisc_t	*Disc;		/* discipline passed to agread or agconcat */
-static gstack_t *S;
+static void appendnode(aagstate_t *C, char *name, char *port, char *sport);
+static void attrstmt(aagstate_t *C, int tkind, char *macroname);
+static void startgraph(aagstate_t *C, char *name, bool directed, bool strict);
+static void getedgeitems(aagstate_t *C);
+static void newedge(aagstate_t *C, Agnode_t *t, char *tport, Agnode_t *h, char *hport, char *key);
+static void edgerhs(aagstate_t *C, Agnode_t *n, char *tport, item *hlist, char *key);
+static void appendattr(aagstate_t *C, char *name, char *value);
+static void bindattrs(aagstate_t *C, int kind);
+static void applyattrs(aagstate_t *C, void *obj);
+static void endgraph(aagscan_t scanner, aagstate_t *C);
+static void endnode(aagstate_t *C);
+static void endedge(aagstate_t *C);
+static void freestack(aagstate_t *C);
+static char* concat(aagstate_t *C, char*, char*);
+static char* concatPort(aagstate_t *C, char*, char*);
+
+static void opensubg(aagstate_t *C, char *name);
+static void closesubg(aagstate_t *C);
+
+static void aagerror(aagscan_t scanner, aagstate_t *C, const char *str);
 
 %}
 
@@ -98,17 +112,21 @@ static gstack_t *S;
 %type <i>  optstrict graphtype rcompound attrtype
 %type <str> optsubghdr optgraphname optmacroname atom qatom
 
+%code {
+int aaglex(AAGSTYPE *lvalp, aagscan_t scanner);
+}
+
 
 %%
 
-graph		:  hdr body {freestack(); endgraph();}
-			|  error	{if (G) {freestack(); endgraph(); agclose(G); G = Ag_G_global = NULL;}}
+graph		:  hdr body {freestack(C); endgraph(scanner, C);}
+			|  error	{if (C->G) {freestack(C); endgraph(scanner, C); agclose(C->G); C->G = Ag_G_global = NULL;}}
 			|  /* empty */
 			;
 
 body		: '{' optstmtlist '}' ;
 
-hdr			:	optstrict graphtype optgraphname {startgraph($3,$2 != 0,$1 != 0);}
+hdr			:	optstrict graphtype optgraphname {startgraph(C,$3,$2 != 0,$1 != 0);}
 			;
 
 optgraphname:	atom {$$=$1;} | /* empty */ {$$=0;} ;
@@ -128,25 +146,25 @@ stmt		:  attrstmt  optsemi
 			;
 
 compound 	:	simple rcompound optattr
-					{if ($2) endedge(); else endnode();}
+					{if ($2) endedge(C); else endnode(C);}
 			;
 
 simple		:	nodelist | subgraph ;
 
-rcompound	:	T_edgeop {getedgeitems();} simple {getedgeitems();} rcompound {$$ = 1;}
+rcompound	:	T_edgeop {getedgeitems(C);} simple {getedgeitems(C);} rcompound {$$ = 1;}
 			|	/* empty */ {$$ = 0;}
 			;
 
 
 nodelist	: node | nodelist ',' node ;
 
-node		: atom {appendnode($1,NULL,NULL);}
-            | atom ':' atom {appendnode($1,$3,NULL);}
-            | atom ':' atom ':' atom {appendnode($1,$3,$5);}
+node		: atom {appendnode(C,$1,NULL,NULL);}
+            | atom ':' atom {appendnode(C,$1,$3,NULL);}
+            | atom ':' atom ':' atom {appendnode(C,$1,$3,$5);}
             ;
 
-attrstmt	:  attrtype optmacroname attrlist {attrstmt($1,$2);}
-			|  graphattrdefs {attrstmt(T_graph,NULL);}
+attrstmt	:  attrtype optmacroname attrlist {attrstmt(C,$1,$2);}
+			|  graphattrdefs {attrstmt(C,T_graph,NULL);}
 			;
 
 attrtype :	T_graph {$$ = T_graph;}
@@ -168,13 +186,13 @@ optattrdefs	: optattrdefs attrdefs
 attrdefs	:  attrassignment optseparator
 			;
 
-attrassignment	:  atom '=' atom {appendattr($1,$3);}
+attrassignment	:  atom '=' atom {appendattr(C,$1,$3);}
 			;
 
 graphattrdefs : attrassignment
 			;
 
-subgraph	:  optsubghdr {opensubg($1);} body {closesubg();}
+subgraph	:  optsubghdr {opensubg(C,$1);} body {closesubg(C);}
 			;
 
 optsubghdr	: T_subgraph atom {$$=$2;}
@@ -189,60 +207,60 @@ atom	:  T_atom {$$ = $1;}
 			;
 
 qatom	:  T_qatom {$$ = $1;}
-			|  qatom '+' T_qatom {$$ = concat($1,$3);}
+			|  qatom '+' T_qatom {$$ = concat(C,$1,$3);}
 			;
 %%
 
-static item *newitem(int tag, void *p0, char *p1)
+static item *newitem(aagstate_t *C, int tag, void *p0, char *p1)
 {
-	item	*rv = agalloc(G,sizeof(item));
+	item	*rv = agalloc(C->G,sizeof(item));
 	rv->tag = tag; rv->u.name = (char*)p0; rv->str = p1;
 	return rv;
 }
 
-static item *cons_node(Agnode_t *n, char *port)
-	{ return newitem(T_node,n,port); }
+static item *cons_node(aagstate_t *C, Agnode_t *n, char *port)
+	{ return newitem(C,T_node,n,port); }
 
-static item *cons_attr(char *name, char *value)
-	{ return newitem(T_atom,name,value); }
+static item *cons_attr(aagstate_t *C, char *name, char *value)
+	{ return newitem(C,T_atom,name,value); }
 
-static item *cons_list(item *list)
-	{ return newitem(T_list,list,NULL); }
+static item *cons_list(aagstate_t *C, item *list)
+	{ return newitem(C,T_list,list,NULL); }
 
-static item *cons_subg(Agraph_t *subg)
-	{ return newitem(T_subgraph,subg,NULL); }
+static item *cons_subg(aagstate_t *C, Agraph_t *subg)
+	{ return newitem(C,T_subgraph,subg,NULL); }
 
-static gstack_t *push(gstack_t *s, Agraph_t *subg) {
+static gstack_t *push(aagstate_t *C, gstack_t *s, Agraph_t *subg) {
 	gstack_t *rv;
-	rv = agalloc(G,sizeof(gstack_t));
+	rv = agalloc(C->G,sizeof(gstack_t));
 	rv->down = s;
 	rv->g = subg;
 	return rv;
 }
 
-static gstack_t *pop(gstack_t *s)
+static gstack_t *pop(aagstate_t *C, gstack_t *s)
 {
 	gstack_t *rv;
 	rv = s->down;
-	agfree(G,s);
+	agfree(C->G,s);
 	return rv;
 }
 
-static void delete_items(item *ilist)
+static void delete_items(aagstate_t *C, item *ilist)
 {
 	item	*p,*pn;
 
 	for (p = ilist; p; p = pn) {
 		pn = p->next;
-		if (p->tag == T_list) delete_items(p->u.list);
-		if (p->tag == T_atom) agstrfree(G,p->str);
-		agfree(G,p);
+		if (p->tag == T_list) delete_items(C,p->u.list);
+		if (p->tag == T_atom) agstrfree(C->G,p->str);
+		agfree(C->G,p);
 	}
 }
 
-static void deletelist(list_t *list)
+static void deletelist(aagstate_t *C, list_t *list)
 {
-	delete_items(list->first);
+	delete_items(C,list->first);
 	list->first = list->last = NULL;
 }
 
@@ -255,37 +273,37 @@ static void listapp(list_t *list, item *v)
 
 
 /* attrs */
-static void appendattr(char *name, char *value)
+static void appendattr(aagstate_t *C, char *name, char *value)
 {
 	item		*v;
 
 	assert(value != NULL);
-	v = cons_attr(name,value);
-	listapp(&(S->attrlist),v);
+	v = cons_attr(C,name,value);
+	listapp(&(C->S->attrlist),v);
 }
 
-static void bindattrs(int kind)
+static void bindattrs(aagstate_t *C, int kind)
 {
 	item		*aptr;
 	char		*name;
 
-	for (aptr = S->attrlist.first; aptr; aptr = aptr->next) {
+	for (aptr = C->S->attrlist.first; aptr; aptr = aptr->next) {
 		assert(aptr->tag == T_atom);	/* signifies unbound attr */
 		name = aptr->u.name;
 		if (kind == AGEDGE && streq(name,Key)) continue;
-		if ((aptr->u.asym = agattr(S->g,kind,name,NULL)) == NULL)
-			aptr->u.asym = agattr(S->g,kind,name,"");
+		if ((aptr->u.asym = agattr(C->S->g,kind,name,NULL)) == NULL)
+			aptr->u.asym = agattr(C->S->g,kind,name,"");
 		aptr->tag = T_attr;				/* signifies bound attr */
-		agstrfree(G,name);
+		agstrfree(C->G,name);
 	}
 }
 
 /* attach node/edge specific attributes */
-static void applyattrs(void *obj)
+static void applyattrs(aagstate_t *C, void *obj)
 {
 	item		*aptr;
 
-	for (aptr = S->attrlist.first; aptr; aptr = aptr->next) {
+	for (aptr = C->S->attrlist.first; aptr; aptr = aptr->next) {
 		if (aptr->tag == T_attr) {
 			if (aptr->u.asym) {
 				agxset(obj,aptr->u.asym,aptr->str);
@@ -308,7 +326,7 @@ static void nomacros(void)
  * First argument is always attrtype, so switch covers all cases.
  * This function is used to handle default attribute value assignment.
  */
-static void attrstmt(int tkind, char *macroname)
+static void attrstmt(aagstate_t *C, int tkind, char *macroname)
 {
 	item			*aptr;
 	int				kind = 0;
@@ -317,7 +335,7 @@ static void attrstmt(int tkind, char *macroname)
 		/* creating a macro def */
 	if (macroname) nomacros();
 		/* invoking a macro def */
-	for (aptr = S->attrlist.first; aptr; aptr = aptr->next)
+	for (aptr = C->S->attrlist.first; aptr; aptr = aptr->next)
 		if (aptr->str == NULL) nomacros();
 
 	switch(tkind) {
@@ -326,32 +344,32 @@ static void attrstmt(int tkind, char *macroname)
 		case T_edge: kind = AGEDGE; break;
 		default: UNREACHABLE();
 	}
-	bindattrs(kind);	/* set up defaults for new attributes */
-	for (aptr = S->attrlist.first; aptr; aptr = aptr->next) {
+	bindattrs(C,kind);	/* set up defaults for new attributes */
+	for (aptr = C->S->attrlist.first; aptr; aptr = aptr->next) {
 		/* If the tag is still T_atom, aptr->u.asym has not been set */
 		if (aptr->tag == T_atom) continue;
-		if (!(aptr->u.asym->fixed) || (S->g != G))
-			sym = agattr(S->g,kind,aptr->u.asym->name,aptr->str);
+		if (!(aptr->u.asym->fixed) || (C->S->g != C->G))
+			sym = agattr(C->S->g,kind,aptr->u.asym->name,aptr->str);
 		else
 			sym = aptr->u.asym;
-		if (S->g == G)
+		if (C->S->g == C->G)
 			sym->print = TRUE;
 	}
-	deletelist(&(S->attrlist));
+	deletelist(C,&(C->S->attrlist));
 }
 
 /* nodes */
 
-static void appendnode(char *name, char *port, char *sport)
+static void appendnode(aagstate_t *C, char *name, char *port, char *sport)
 {
 	item		*elt;
 
 	if (sport) {
-		port = concatPort (port, sport);
+		port = concatPort (C, port, sport);
 	}
-	elt = cons_node(agnode(S->g,name,TRUE),port);
-	listapp(&(S->nodelist),elt);
-	agstrfree(G,name);
+	elt = cons_node(C,agnode(C->S->g,name,TRUE),port);
+	listapp(&(C->S->nodelist),elt);
+	agstrfree(C->G,name);
 }
 
 /* apply current optional attrs to nodelist and clean up lists */
@@ -359,35 +377,35 @@ static void appendnode(char *name, char *port, char *sport)
 clean up S->subg in closesubg() because S->subg might be needed
 to construct edges.  these are the sort of notes you write to yourself
 in the future. */
-static void endnode()
+static void endnode(aagstate_t *C)
 {
 	item	*ptr;
 
-	bindattrs(AGNODE);
-	for (ptr = S->nodelist.first; ptr; ptr = ptr->next)
-		applyattrs(ptr->u.n);
-	deletelist(&(S->nodelist));
-	deletelist(&(S->attrlist));
-	deletelist(&(S->edgelist));
-	S->subg = 0;  /* notice a pattern here? :-( */
+	bindattrs(C,AGNODE);
+	for (ptr = C->S->nodelist.first; ptr; ptr = ptr->next)
+		applyattrs(C,ptr->u.n);
+	deletelist(C,&(C->S->nodelist));
+	deletelist(C,&(C->S->attrlist));
+	deletelist(C,&(C->S->edgelist));
+	C->S->subg = 0;  /* notice a pattern here? :-( */
 }
 
 /* edges - store up node/subg lists until optional edge key can be seen */
 
-static void getedgeitems(void)
+static void getedgeitems(aagstate_t *C)
 {
 	item	*v = 0;
 
-	if (S->nodelist.first) {
-		v = cons_list(S->nodelist.first);
-		S->nodelist.first = S->nodelist.last = NULL;
+	if (C->S->nodelist.first) {
+		v = cons_list(C,C->S->nodelist.first);
+		C->S->nodelist.first = C->S->nodelist.last = NULL;
 	}
-	else {if (S->subg) v = cons_subg(S->subg); S->subg = 0;}
+	else {if (C->S->subg) v = cons_subg(C,C->S->subg); C->S->subg = 0;}
 	/* else nil append */
-	if (v) listapp(&(S->edgelist),v);
+	if (v) listapp(&(C->S->edgelist),v);
 }
 
-static void endedge(void)
+static void endedge(aagstate_t *C)
 {
 	char			*key;
 	item			*aptr,*tptr,*p;
@@ -395,37 +413,37 @@ static void endedge(void)
 	Agnode_t		*t;
 	Agraph_t		*subg;
 
-	bindattrs(AGEDGE);
+	bindattrs(C,AGEDGE);
 
 	/* look for "key" pseudo-attribute */
 	key = NULL;
-	for (aptr = S->attrlist.first; aptr; aptr = aptr->next) {
+	for (aptr = C->S->attrlist.first; aptr; aptr = aptr->next) {
 		if ((aptr->tag == T_atom) && streq(aptr->u.name,Key))
 			key = aptr->str;
 	}
 
 	/* can make edges with node lists or subgraphs */
-	for (p = S->edgelist.first; p->next; p = p->next) {
+	for (p = C->S->edgelist.first; p->next; p = p->next) {
 		if (p->tag == T_subgraph) {
 			subg = p->u.subg;
 			for (t = agfstnode(subg); t; t = agnxtnode(subg,t))
-				edgerhs(agsubnode(S->g,t,FALSE),NULL,p->next,key);
+				edgerhs(C,agsubnode(C->S->g,t,FALSE),NULL,p->next,key);
 		}
 		else {
 			for (tptr = p->u.list; tptr; tptr = tptr->next)
-				edgerhs(tptr->u.n,tptr->str,p->next,key);
+				edgerhs(C,tptr->u.n,tptr->str,p->next,key);
 		}
 	}
-	deletelist(&(S->nodelist));
-	deletelist(&(S->edgelist));
-	deletelist(&(S->attrlist));
-	S->subg = 0;
+	deletelist(C,&(C->S->nodelist));
+	deletelist(C,&(C->S->edgelist));
+	deletelist(C,&(C->S->attrlist));
+	C->S->subg = 0;
 }
 
 /* concat:
  */
 static char*
-concat (char* s1, char* s2)
+concat (aagstate_t *C, char* s1, char* s2)
 {
   char*  s;
   char   buf[BUFSIZ];
@@ -436,9 +454,9 @@ concat (char* s1, char* s2)
   else sym = gv_alloc(len);
   strcpy(sym,s1);
   strcat(sym,s2);
-  s = agstrdup (G,sym);
-  agstrfree (G,s1);
-  agstrfree (G,s2);
+  s = agstrdup (C->G,sym);
+  agstrfree (C->G,s1);
+  agstrfree (C->G,s2);
   if (sym != buf) free (sym);
   return s;
 }
@@ -446,7 +464,7 @@ concat (char* s1, char* s2)
 /* concatPort:
  */
 static char*
-concatPort (char* s1, char* s2)
+concatPort (aagstate_t *C, char* s1, char* s2)
 {
   char*  s;
   char   buf[BUFSIZ];
@@ -456,15 +474,15 @@ concatPort (char* s1, char* s2)
   if (len <= BUFSIZ) sym = buf;
   else sym = gv_alloc(len);
   sprintf (sym, "%s:%s", s1, s2);
-  s = agstrdup (G,sym);
-  agstrfree (G,s1);
-  agstrfree (G,s2);
+  s = agstrdup (C->G,sym);
+  agstrfree (C->G,s1);
+  agstrfree (C->G,s2);
   if (sym != buf) free (sym);
   return s;
 }
 
 
-static void edgerhs(Agnode_t *tail, char *tport, item *hlist, char *key)
+static void edgerhs(aagstate_t *C, Agnode_t *tail, char *tport, item *hlist, char *key)
 {
 	Agnode_t		*head;
 	Agraph_t		*subg;
@@ -473,29 +491,29 @@ static void edgerhs(Agnode_t *tail, char *tport, item *hlist, char *key)
 	if (hlist->tag == T_subgraph) {
 		subg = hlist->u.subg;
 		for (head = agfstnode(subg); head; head = agnxtnode(subg,head))
-			newedge(tail,tport,agsubnode(S->g,head,FALSE),NULL,key);
+			newedge(C,tail,tport,agsubnode(C->S->g,head,FALSE),NULL,key);
 	}
 	else {
 		for (hptr = hlist->u.list; hptr; hptr = hptr->next)
-			newedge(tail,tport,agsubnode(S->g,hptr->u.n,FALSE),hptr->str,key);
+			newedge(C,tail,tport,agsubnode(C->S->g,hptr->u.n,FALSE),hptr->str,key);
 	}
 }
 
-static void mkport(Agedge_t *e, char *name, char *val)
+static void mkport(aagstate_t *C, Agedge_t *e, char *name, char *val)
 {
 	Agsym_t *attr;
 	if (val) {
-		if ((attr = agattr(S->g,AGEDGE,name,NULL)) == NULL)
-			attr = agattr(S->g,AGEDGE,name,"");
+		if ((attr = agattr(C->S->g,AGEDGE,name,NULL)) == NULL)
+			attr = agattr(C->S->g,AGEDGE,name,"");
 		agxset(e,attr,val);
 	}
 }
 
-static void newedge(Agnode_t *t, char *tport, Agnode_t *h, char *hport, char *key)
+static void newedge(aagstate_t *C, Agnode_t *t, char *tport, Agnode_t *h, char *hport, char *key)
 {
 	Agedge_t 	*e;
 
-	e = agedge(S->g,t,h,key,TRUE);
+	e = agedge(C->S->g,t,h,key,TRUE);
 	if (e) {		/* can fail if graph is strict and t==h */
 		char    *tp = tport;
 		char    *hp = hport;
@@ -504,75 +522,85 @@ static void newedge(Agnode_t *t, char *tport, Agnode_t *h, char *hport, char *ke
 			char    *temp;
 			temp = tp; tp = hp; hp = temp;
 		}
-		mkport(e,TAILPORT_ID,tp);
-		mkport(e,HEADPORT_ID,hp);
-		applyattrs(e);
+		mkport(C,e,TAILPORT_ID,tp);
+		mkport(C,e,HEADPORT_ID,hp);
+		applyattrs(C,e);
 	}
 }
 
 /* graphs and subgraphs */
 
 
-static void startgraph(char *name, bool directed, bool strict)
+static void startgraph(aagstate_t *C, char *name, bool directed, bool strict)
 {
-	if (G == NULL) {
-		SubgraphDepth = 0;
+	if (C->G == NULL) {
+		C->SubgraphDepth = 0;
 		Agdesc_t req = {.directed = directed, .strict = strict, .maingraph = true};
-		Ag_G_global = G = agopen(name,req,Disc);
+		Ag_G_global = C->G = agopen(name,req,C->Disc);
 	}
 	else {
-		Ag_G_global = G;
+		Ag_G_global = C->G;
 	}
-	S = push(S,G);
+	/* strict graphs look up every edge they are asked to create */
+	if (agisstrict(C->G))
+		(void)agedgeindex(C->G, TRUE);
+	C->S = push(C,C->S,C->G);
 	agstrfree(NULL,name);
 }
 
-static void endgraph()
+static void endgraph(aagscan_t scanner, aagstate_t *C)
 {
-	aglexeof();
-	aginternalmapclearlocalnames(G);
+	aglexeof(scanner);
+	aginternalmapclearlocalnames(C->G);
 }
 
-static void opensubg(char *name)
+static void opensubg(aagstate_t *C, char *name)
 {
-  if (++SubgraphDepth >= YYMAXDEPTH/2) {
+  if (++C->SubgraphDepth >= YYMAXDEPTH/2) {
     agerr(AGERR,"subgraphs nested more than %d deep",YYMAXDEPTH);
   }
-	S = push(S,agsubg(S->g,name,TRUE));
-	agstrfree(G,name);
+	C->S = push(C,C->S,agsubg(C->S->g,name,TRUE));
+	if (agisstrict(C->G))
+		(void)agedgeindex(C->S->g, TRUE);
+	agstrfree(C->G,name);
 }
 
-static void closesubg()
+static void closesubg(aagstate_t *C)
 {
-	Agraph_t *subg = S->g;
-  --SubgraphDepth;
-	S = pop(S);
-	S->subg = subg;
+	Agraph_t *subg = C->S->g;
+  --C->SubgraphDepth;
+	C->S = pop(C,C->S);
+	C->S->subg = subg;
 	assert(subg);
 }
 
-static void freestack()
+static void freestack(aagstate_t *C)
 {
-	while (S) {
-		deletelist(&(S->nodelist));
-		deletelist(&(S->attrlist));
-		deletelist(&(S->edgelist));
-		S = pop(S);
+	while (C->S) {
+		deletelist(C,&(C->S->nodelist));
+		deletelist(C,&(C->S->attrlist));
+		deletelist(C,&(C->S->edgelist));
+		C->S = pop(C,C->S);
 	}
 }
 
-extern FILE *aagin;
+static void aagerror(aagscan_t scanner, aagstate_t *C, const char *str)
+{
+	(void)C;
+	aglexerror(scanner, str);
+}
+
 Agraph_t *agconcat(Agraph_t *g, void *chan, Agdisc_t *disc)
 {
-	aagin = chan;
-	G = g;
+	aagstate_t state = {.G = g};
+	aagscan_t scanner;
+
 	Ag_G_global = NULL;
-	Disc = (disc? disc :  &AgDefaultDisc);
-	aglexinit(Disc, chan);
-	aagparse();
-	if (Ag_G_global == NULL) aglexbad();
+	state.Disc = (disc? disc :  &AgDefaultDisc);
+	scanner = aglexinit(state.Disc, chan);
+	aagparse(scanner, &state);
+	if (Ag_G_global == NULL) aglexbad(scanner);
 	return Ag_G_global;
 }
 
 Agraph_t *agread(void *fp, Agdisc_t *disc) {return agconcat(NULL,fp,disc); }
-
@@ -12,7 +12,7 @@
 #include <cgraph/cghdr.h>
 #include <stddef.h>
 
-Agraph_t *Ag_G_global;
+TLS Agraph_t *Ag_G_global;
 
 /*
  * this code sets up the resource management discipline
@@ -114,6 +114,8 @@ int agclose(Agraph_t * g)
     }
 
     aginternalmapclose(g);
+    agcsrfree(g);
+    agedgeindex_close(g);
     agmethod_delete(g, g);
 
     assert(dtsize(g->n_id) == 0);
@@ -143,6 +145,7 @@ int agclose(Agraph_t * g)
 	while (g->clos->cb)
 	    agpopdisc(g, g->clos->cb->f);
 	AGDISC(g, id)->close(AGCLOS(g, id));
+	agattrcache_free(g);
 	if (agstrclose(g)) return FAILURE;
 	memdisc = AGDISC(g, mem);
 	memclos = AGCLOS(g, mem);
@@ -265,6 +268,7 @@ Agdesc_t Agundirected = { .maingraph = 1 };
 Agdesc_t Agstrictundirected = { .strict = 1, .maingraph = 1 };
 
 Agdisc_t AgDefaultDisc = { &AgMemDisc, &AgIdDisc, &AgIoDisc };
+Agdisc_t AgArenaDisc = { &AgArenaMemDisc, &AgIdDisc, &AgIoDisc };
 
 /**
  * @dir lib/cgraph
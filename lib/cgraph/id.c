@@ -13,9 +13,31 @@
 #include <inttypes.h>
 #include <stddef.h>
 #include <stdint.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
 
 /* a default ID allocator that works off the shared string lib */
 
+/* anonymous objects get odd IDs from a counter shared by all graphs, so
+ * take the next one atomically where the compiler allows, as graphs may be
+ * read in several threads at once
+ */
+static IDTYPE ctr = 1;
+
+static IDTYPE nextanonid(void)
+{
+#ifdef _MSC_VER
+    return (IDTYPE)_InterlockedExchangeAdd64((volatile __int64 *)&ctr, 2);
+#elif defined(__GNUC__)
+    return __atomic_fetch_add(&ctr, 2, __ATOMIC_RELAXED);
+#else
+    IDTYPE id = ctr;
+    ctr += 2;
+    return id;
+#endif
+}
+
 static void *idopen(Agraph_t * g, Agdisc_t* disc)
 {
     (void)disc;
@@ -26,7 +48,6 @@ static long idmap(void *state, int objtype, char *str, IDTYPE *id,
 		  int createflag)
 {
     char *s;
-    static IDTYPE ctr = 1;
 
     (void)objtype;
     if (str) {
@@ -38,8 +59,7 @@ static long idmap(void *state, int objtype, char *str, IDTYPE *id,
             s = agstrbind(g, str);
         *id = (IDTYPE)(uintptr_t)s;
     } else {
-        *id = ctr;
-        ctr += 2;
+        *id = nextanonid();
     }
     return TRUE;
 }
@@ -158,7 +178,7 @@ char *agnameof(void *obj)
 	    return rv;
     }
     if (AGTYPE(obj) != AGEDGE) {
-	static char buf[32];
+	static TLS char buf[32];
 	snprintf(buf, sizeof(buf), "%c%" PRIu64, LOCALNAMEPREFIX, AGID(obj));
 	rv = buf;
     }
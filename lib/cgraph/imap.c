@@ -195,13 +195,13 @@ void aginternalmapclearlocalnames(Agraph_t * g)
     }
 }
 
-static void closeit(Dict_t ** d)
+static void closeit(Agraph_t * g, Dict_t ** d)
 {
     int i;
 
     for (i = 0; i < 3; i++) {
 	if (d[i]) {
-	    dtclose(d[i]);
+	    agdtclose(g, d[i]);
 	    d[i] = NULL;
 	}
     }
@@ -209,7 +209,24 @@ static void closeit(Dict_t ** d)
 
 void aginternalmapclose(Agraph_t * g)
 {
+    int i;
+    IMapEntry_t *sym, *nxt;
+    Dict_t **d_name;
+
+    /* subgraphs share the maps of their root graph */
+    if (g != agroot(g))
+	return;
+
     Ag_G_global = g;
-    closeit(g->clos->lookup_by_name);
-    closeit(g->clos->lookup_by_id);
+    d_name = g->clos->lookup_by_name;
+    for (i = 0; i < 3; i++) {
+	if (d_name[i]) {
+	    for (sym = dtfirst(d_name[i]); sym; sym = nxt) {
+		nxt = dtnext(d_name[i], sym);
+		aginternalmapdelete(g, i, sym->id);
+	    }
+	}
+    }
+    closeit(g, g->clos->lookup_by_name);
+    closeit(g, g->clos->lookup_by_id);
 }
@@ -8,12 +8,20 @@
  * Contributors: Details at https://graphviz.org
  *************************************************************************/
 
+#include <errno.h>
 #include <stddef.h>
 #include <stdio.h>
+#include <cgraph/alloc.h>
 #include <cgraph/cghdr.h>
 #if defined(_WIN32)
 #include <io.h>
 #endif
+#ifdef HAVE_SYS_MMAN_H
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 static int iofread(void *chan, char *buf, int bufsize)
 {
@@ -72,16 +80,13 @@ memiofread(void *chan, char *buf, int bufsize)
     return l;
 }
 
-static Agiodisc_t memIoDisc = {memiofread, 0, 0};
-
 static Agraph_t *agmemread0(Agraph_t *arg_g, const char *cp)
 {
     Agraph_t* g;
     rdr_t rdr;
     Agdisc_t disc;
+    Agiodisc_t memIoDisc = {memiofread, AgIoDisc.putstr, AgIoDisc.flush};
 
-    memIoDisc.putstr = AgIoDisc.putstr;
-    memIoDisc.flush = AgIoDisc.flush;
     rdr.data = cp;
     rdr.len = strlen(cp);
     rdr.cur = 0;
@@ -108,3 +113,172 @@ Agraph_t *agmemconcat(Agraph_t *g, const char *cp)
 {
     return agmemread0(g, cp);
 }
+
+struct Agmapped_s {
+    char *base;		/* file contents */
+    size_t size;	/* bytes in the file */
+    size_t cur;		/* where DOT text is next read from */
+    size_t offset;	/* start of the next binary snapshot in base */
+};
+
+#ifdef HAVE_SYS_MMAN_H
+/* mapfile:
+ * Map the regular file fd read only. Nothing is ever written to the image,
+ * so its pages stay shared with the page cache.
+ */
+static int mapfile(Agmapped_t *m, int fd)
+{
+    struct stat st;
+
+    if (fstat(fd, &st) != 0)
+	return -1;
+    if (!S_ISREG(st.st_mode)) {
+	errno = ENODEV;
+	return -1;
+    }
+    m->size = (size_t)st.st_size;
+    if (m->size == 0)
+	return 0;
+    m->base = mmap(NULL, m->size, PROT_READ, MAP_SHARED, fd, 0);
+    if (m->base == MAP_FAILED) {
+	m->base = NULL;
+	return -1;
+    }
+#ifdef MADV_SEQUENTIAL
+    (void)madvise(m->base, m->size, MADV_SEQUENTIAL);
+#endif
+    return 0;
+}
+#else
+/* mapfile:
+ * Without mmap, read the whole file into memory instead.
+ */
+static int mapfile(Agmapped_t *m, FILE *f)
+{
+    size_t cap = BUFSIZ;
+    size_t len = 0;
+    char *buf = gv_alloc(cap);
+
+    for (;;) {
+	if (len == cap) {
+	    buf = gv_realloc(buf, cap, 2 * cap);
+	    cap *= 2;
+	}
+	size_t r = fread(buf + len, 1, cap - len, f);
+	len += r;
+	if (r == 0)
+	    break;
+    }
+    if (ferror(f)) {
+	free(buf);
+	return -1;
+    }
+    m->base = buf;
+    m->size = len;
+    return 0;
+}
+#endif
+
+/* mapiofread:
+ * Hand the lexer as much of the image as it has room for. Unlike the stdio
+ * and memory readers, this does not stop at the end of a line.
+ */
+static int mapiofread(void *chan, char *buf, int bufsize)
+{
+    Agmapped_t *m = chan;
+    size_t n = m->size - m->cur;
+
+    if (bufsize <= 0)
+	return 0;
+    if (n > (size_t)bufsize)
+	n = (size_t)bufsize;
+    memcpy(buf, m->base + m->cur, n);
+    m->cur += n;
+    return (int)n;
+}
+
+/* the graphs read keep this, so it cannot be on the stack */
+static Agiodisc_t MapIoDisc = {mapiofread, ioputstr, ioflush};
+
+Agmapped_t *agmapopen(const char *filename)
+{
+    Agmapped_t *m = gv_alloc(sizeof(Agmapped_t));
+    int rc;
+
+#ifdef HAVE_SYS_MMAN_H
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+	free(m);
+	return NULL;
+    }
+    rc = mapfile(m, fd);
+    int err = errno;
+    close(fd);
+    errno = err;
+#else
+    FILE *f = fopen(filename, "rb");
+    if (f == NULL) {
+	free(m);
+	return NULL;
+    }
+    rc = mapfile(m, f);
+    fclose(f);
+#endif
+    if (rc != 0) {
+	free(m);
+	return NULL;
+    }
+    return m;
+}
+
+/* mapconcat:
+ * Read the next graph of DOT text from m, through a copy of disc whose
+ * reader takes the text from the image.
+ */
+static Agraph_t *mapconcat(Agraph_t *g, Agmapped_t *m, Agdisc_t *disc)
+{
+    Agdisc_t d = disc ? *disc : AgDefaultDisc;
+
+    d.io = &MapIoDisc;
+    return agconcat(g, m, &d);
+}
+
+/* A mapped file starting with a binary snapshot is taken to be a sequence
+ * of them, as written by agwrite_binary, rather than DOT text.
+ */
+Agraph_t *agmapread(Agmapped_t *m, Agdisc_t *disc)
+{
+    if (agisbinary(m->base, m->size)) {
+	size_t used;
+	Agraph_t *g;
+
+	if (m->offset >= m->size)
+	    return NULL;
+	g = agread_binary(m->base + m->offset, m->size - m->offset, &used,
+			  disc);
+	m->offset = g ? m->offset + used : m->size;
+	return g;
+    }
+    return mapconcat(NULL, m, disc);
+}
+
+Agraph_t *agmapconcat(Agraph_t *g, Agmapped_t *m, Agdisc_t *disc)
+{
+    return mapconcat(g, m, disc);
+}
+
+int agmapclose(Agmapped_t *m)
+{
+    int rc = 0;
+
+    if (m == NULL)
+	return 0;
+#ifdef HAVE_SYS_MMAN_H
+    if (m->base != NULL)
+	rc = munmap(m->base, m->size);
+#else
+    free(m->base);
+#endif
+    free(m);
+    return rc;
+}
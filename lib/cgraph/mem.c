@@ -8,8 +8,10 @@
  * Contributors: Details at https://graphviz.org
  *************************************************************************/
 
+#include <cgraph/alloc.h>
 #include <cgraph/cghdr.h>
 #include <stdlib.h>
+#include <string.h>
 
 /* memory management discipline and entry points */
 static void *memopen(Agdisc_t* disc)
@@ -48,6 +50,142 @@ static void memfree(void *heap, void *ptr)
 Agmemdisc_t AgMemDisc =
     { memopen, memalloc, memresize, memfree, NULL };
 
+/* arena memory discipline
+ *
+ * Objects are carved out of large zeroed chunks and are never freed
+ * individually. Closing the root graph releases the chunks wholesale,
+ * without visiting the objects in them.
+ */
+
+/* strictest alignment of any object cgraph or its clients allocate */
+typedef union {
+    long double ld;
+    long long ll;
+    double d;
+    void *p;
+    void (*f)(void);
+} arena_align_t;
+
+#define ARENA_ALIGN sizeof(arena_align_t)
+#define ARENA_MINCHUNK ((size_t)64 * 1024)
+#define ARENA_MAXCHUNK ((size_t)4 * 1024 * 1024)
+
+typedef struct arena_chunk_s {
+    struct arena_chunk_s *next;
+    arena_align_t data[];
+} arena_chunk_t;
+
+typedef struct {
+    arena_chunk_t *chunks;	/* current chunk first */
+    char *next;			/* first free byte in the current chunk */
+    char *end;			/* end of the current chunk */
+    char *last;			/* most recent allocation, for resizing in place */
+    size_t chunksize;		/* size of the next chunk to allocate */
+} arena_t;
+
+static void *arenaopen(Agdisc_t *disc)
+{
+    arena_t *arena;
+
+    (void)disc;
+    arena = gv_alloc(sizeof(arena_t));
+    arena->chunksize = ARENA_MINCHUNK;
+    return arena;
+}
+
+static size_t arenaround(size_t size)
+{
+    if (size == 0)
+	return ARENA_ALIGN;
+    return (size + ARENA_ALIGN - 1) / ARENA_ALIGN * ARENA_ALIGN;
+}
+
+static void *arenaalloc(void *heap, size_t request)
+{
+    arena_t *arena = heap;
+    arena_chunk_t *chunk;
+    size_t size = arenaround(request);
+
+    if (size > (size_t)(arena->end - arena->next)) {
+	/* Requests too large to share a chunk get one of their own, placed
+	 * behind the current chunk so its free space is not abandoned.
+	 */
+	if (size > arena->chunksize / 4) {
+	    chunk = calloc(1, sizeof(arena_chunk_t) + size);
+	    if (chunk == NULL)
+		return NULL;
+	    if (arena->chunks) {
+		chunk->next = arena->chunks->next;
+		arena->chunks->next = chunk;
+	    } else {
+		chunk->next = NULL;
+		arena->chunks = chunk;
+		arena->next = arena->end = (char *)chunk->data + size;
+	    }
+	    return chunk->data;
+	}
+	chunk = calloc(1, sizeof(arena_chunk_t) + arena->chunksize);
+	if (chunk == NULL)
+	    return NULL;
+	chunk->next = arena->chunks;
+	arena->chunks = chunk;
+	arena->next = (char *)chunk->data;
+	arena->end = arena->next + arena->chunksize;
+	if (arena->chunksize < ARENA_MAXCHUNK)
+	    arena->chunksize *= 2;
+    }
+    arena->last = arena->next;
+    arena->next += size;
+    return arena->last;
+}
+
+static void *arenaresize(void *heap, void *ptr, size_t oldsize,
+			 size_t request)
+{
+    arena_t *arena = heap;
+    void *rv;
+
+    if (ptr == NULL)
+	return arenaalloc(heap, request);
+
+    /* the most recent allocation can grow or shrink in place */
+    if (ptr == arena->last &&
+	arenaround(request) <= (size_t)(arena->end - arena->last)) {
+	arena->next = arena->last + arenaround(request);
+	if (request > oldsize)
+	    memset((char *) ptr + oldsize, 0, request - oldsize);
+	return ptr;
+    }
+    if (request <= oldsize)
+	return ptr;
+
+    rv = arenaalloc(heap, request);
+    if (rv != NULL)
+	memcpy(rv, ptr, oldsize);
+    return rv;
+}
+
+static void arenafree(void *heap, void *ptr)
+{
+    (void)heap;
+    (void)ptr;
+}
+
+static void arenaclose(void *heap)
+{
+    arena_t *arena = heap;
+    arena_chunk_t *chunk, *next;
+
+    for (chunk = arena->chunks; chunk; chunk = next) {
+	next = chunk->next;
+	free(chunk);
+    }
+    free(arena);
+}
+
+Agmemdisc_t AgArenaMemDisc =
+    { arenaopen, arenaalloc, arenaresize, arenafree, arenaclose };
+
 void *agalloc(Agraph_t * g, size_t size)
 {
     void *mem;
@@ -16,8 +16,8 @@
 Agnode_t *agfindnode_by_id(Agraph_t * g, IDTYPE id)
 {
     Agsubnode_t *sn;
-    static Agsubnode_t template;
-    static Agnode_t dummy;
+    Agsubnode_t template = {0};
+    Agnode_t dummy = {0};
 
     dummy.base.tag.id = id;
     template.node = &dummy;
@@ -78,7 +78,7 @@ static Agnode_t *newnode(Agraph_t * g, IDTYPE id, uint64_t seq)
     AGID(n) = id;
     AGSEQ(n) = seq & SEQ_MASK;
     n->root = agroot(g);
-    if (agroot(g)->desc.has_attrs)
+    if (agroot(g)->desc.has_attrs && !agroot(g)->desc.columnar)
 	(void)agbindrec(n, AgDataRecName, sizeof(Agattr_t), false);
     /* nodeattr_init and method_init will be called later, from the
      * subgraph where the node was actually created, but first it has
@@ -97,6 +97,7 @@ static void installnode(Agraph_t * g, Agnode_t * n)
     if (g == agroot(g)) sn = &(n->mainsub);
     else sn = agalloc(g, sizeof(Agsubnode_t));
     sn->node = n;
+    agcsrstale(g);
     dtinsert(g->n_id, sn);
     dtinsert(g->n_seq, sn);
     assert(dtsize(g->n_id) == dtsize(g->n_seq));
@@ -177,7 +178,7 @@ Agnode_t *agnode(Agraph_t * g, char *name, int cflag)
 void agdelnodeimage(Agraph_t * g, Agnode_t * n, void *ignored)
 {
     Agedge_t *e, *f;
-    static Agsubnode_t template;
+    Agsubnode_t template = {0};
     template.node = n;
 
     (void)ignored;
@@ -188,6 +189,7 @@ void agdelnodeimage(Agraph_t * g, Agnode_t * n, void *ignored)
     /* If the following lines are switched, switch the discpline using
      * free_subnode below.
      */ 
+    agcsrstale(g);
     dtdelete(g->n_id, &template);
     dtdelete(g->n_seq, &template);
 }
@@ -332,7 +334,7 @@ Dtdisc_t Ag_subnode_seq_disc = {
 
 static void agnodesetfinger(Agraph_t * g, Agnode_t * n, void *ignored)
 {
-    static Agsubnode_t template;
+    Agsubnode_t template = {0};
 	template.node = n;
 	dtsearch(g->n_seq,&template);
     (void)ignored;
@@ -354,12 +356,17 @@ int agnodebefore(Agnode_t *fst, Agnode_t *snd)
 	g = agroot(fst);
 	if (AGSEQ(fst) > AGSEQ(snd)) return SUCCESS;
 
+	/* parsed attribute values are indexed by sequence number */
+	agattrcache_free(g);
+	agcsrstale(g);
+
 	/* move snd out of the way somewhere */
 	n = snd;
 	if (agapply (g, (Agobj_t *) n, (agobjfn_t) agnodesetfinger, n, FALSE) != SUCCESS) return FAILURE;
 	{
 		uint64_t seq = g->clos->seq[AGNODE] + 2;
 		assert((seq & SEQ_MASK) == seq && "sequence ID overflow");
+		agnodeattr_renumber(snd, seq & SEQ_MASK);
 		AGSEQ(snd) = seq & SEQ_MASK;
 	}
 	if (agapply (g, (Agobj_t *) n, (agobjfn_t) agnoderenew, n, FALSE) != SUCCESS) return FAILURE;
@@ -369,6 +376,7 @@ int agnodebefore(Agnode_t *fst, Agnode_t *snd)
 		if (agapply (g, (Agobj_t *) n, (agobjfn_t) agnodesetfinger, n, FALSE) != SUCCESS) return FAILURE;
 		uint64_t seq = AGSEQ(n) + 1;
 		assert((seq & SEQ_MASK) == seq && "sequence ID overflow");
+		agnodeattr_renumber(n, seq & SEQ_MASK);
 		AGSEQ(n) = seq & SEQ_MASK;
 		if (agapply (g, (Agobj_t *) n, (agobjfn_t) agnoderenew, n, FALSE) != SUCCESS) return FAILURE;
 		if (n == fst) break;
@@ -376,6 +384,7 @@ int agnodebefore(Agnode_t *fst, Agnode_t *snd)
 	} while (n);
 	if (agapply (g, (Agobj_t *) snd, (agobjfn_t) agnodesetfinger, n, FALSE) != SUCCESS) return FAILURE;
 	assert(AGSEQ(fst) != 0 && "sequence ID overflow");
+	agnodeattr_renumber(snd, (AGSEQ(fst) - 1) & SEQ_MASK);
 	AGSEQ(snd) = (AGSEQ(fst) - 1) & SEQ_MASK;
 	if (agapply (g, (Agobj_t *) snd, (agobjfn_t) agnoderenew, snd, FALSE) != SUCCESS) return FAILURE;
 	return SUCCESS;
@@ -61,6 +61,7 @@ static Dtdisc_t Disc = {
     .key = offsetof(pending_cb_t, key),	/* sort by 'key' */
     .size = sizeof(uint64_t),
     .freef = freef,
+    .memoryf = agdictobjmem,
 };
 
 static Dict_t *dictof(pendingset_t * ds, Agobj_t * obj, cb_t kind)
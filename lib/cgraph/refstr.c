@@ -38,7 +38,10 @@ static Dtdisc_t Refstrdisc = {
     NULL
 };
 
-static Dict_t *Refdict_default;
+/* strings not owned by a graph, such as names read before their graph is
+ * opened, kept per thread so that threads can read graphs at the same time
+ */
+static TLS Dict_t *Refdict_default;
 
 /* refdict:
  * Return the string dictionary associated with g.
@@ -148,6 +151,11 @@ int agstrfree(Agraph_t * g, const char *s)
 	r->refcnt--;
 	if (r->refcnt == 0) {
 	    agdtdelete(g, strdict, r);
+	    /* so that a thread's own strings go with their last use */
+	    if (!g && dtsize(strdict) == 0) {
+		agdtclose(NULL, strdict);
+		Refdict_default = NULL;
+	    }
 	}
     }
     if (r == NULL)
@@ -9,19 +9,9 @@
 #pragma once
 
 #include <assert.h>
+#include <cgraph/tls.h>
 #include <stdlib.h>
 
-/// thread-local storage specifier
-#ifdef _MSC_VER
-#define TLS __declspec(thread)
-#elif defined(__GNUC__)
-#define TLS __thread
-#else
-// assume this environment does not support threads and fall back to (thread
-// unsafe) globals
-#define TLS /* nothing */
-#endif
-
 static TLS int (*gv_sort_compar)(const void *, const void *, void *);
 static TLS void *gv_sort_arg;
 
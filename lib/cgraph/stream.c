@@ -0,0 +1,785 @@
+/*************************************************************************
+ * Copyright (c) 2011 AT&T Intellectual Property
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors: Details at https://graphviz.org
+ *************************************************************************/
+
+/*
+ * streaming DOT reader
+ *
+ * agstream recognizes the language of grammar.y, with the tokens of scan.l,
+ * but builds no graph. It calls a handler for each graph, subgraph, node,
+ * edge and attribute statement as the statement ends, passing names and
+ * values as views of its own buffers. Text is kept only until the statement
+ * that holds it has been reported, so memory use is bounded by the longest
+ * statement rather than by the size of the graph.
+ *
+ * The exception is a subgraph, which may turn out to be an operand of an edge
+ * statement and so stand for every node named inside it. The names of those
+ * nodes are kept until the statement the subgraph begins is complete.
+ */
+
+#include <cgraph/agxbuf.h>
+#include <cgraph/alloc.h>
+#include <cgraph/cghdr.h>
+#include <cgraph/list.h>
+#include <cgraph/sort.h>
+#include <cgraph/strcasecmp.h>
+#include <setjmp.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#define CHUNK 65536		/* bytes of input read at a time */
+#define MAXDEPTH 10000		/* subgraph nesting allowed, as in grammar.y */
+
+enum {				/* tokens other than single characters */
+    TOK_EOF = 256, TOK_ATOM, TOK_QATOM, TOK_NODE, TOK_EDGE, TOK_GRAPH,
+    TOK_DIGRAPH, TOK_STRICT, TOK_SUBGRAPH, TOK_EDGEOP
+};
+
+typedef struct {		/* a name or value in the statement text */
+    size_t offset;
+    size_t size;
+    bool html;
+} text_t;
+
+typedef struct {		/* a node, and its port if it is an endpoint */
+    text_t name;
+    text_t port;
+    bool hasport;
+} end_t;
+
+typedef struct {		/* an operand of an edge statement */
+    bool subg;			/* a range of members, else of ends */
+    size_t first, last;
+} operand_t;
+
+DEFINE_LIST(texts, text_t)
+DEFINE_LIST(ends, end_t)
+DEFINE_LIST(operands, operand_t)
+DEFINE_LIST(views, Agtext_t)
+
+/* edge attribute views start here, leaving room for the ports before them */
+#define PORTVIEWS 4
+
+typedef struct {
+    void *chan;
+    Agiodisc_t *io;
+    char *buf;			/* input, CHUNK bytes */
+    size_t len, pos;
+    bool eof;
+    int line;
+    const char *file;		/* name for messages, or NULL */
+
+    int tok;			/* current token */
+    agxbuf tokbuf;		/* and its text */
+    bool tokhtml;
+    bool directed;		/* of the graph being read */
+
+    char *text;			/* text of statements not yet complete */
+    size_t textlen, textcap;
+    ends_t ends;		/* node lists of the current statements */
+    ends_t members;		/* nodes named in subgraphs being read */
+    operands_t operands;
+    texts_t attrs;		/* name, value, name, value... */
+    views_t views;
+    int collect;		/* how many subgraphs are being read */
+    int depth;
+
+    Agstreamdisc_t *handlers;
+    void *state;
+    jmp_buf jbuf;
+    int rv;
+} stream_t;
+
+static void stop(stream_t * s, int rv)
+{
+    s->rv = rv;
+    longjmp(s->jbuf, 1);
+}
+
+/* input */
+
+/* make n bytes of input available if there are that many left */
+static size_t avail(stream_t * s, size_t n)
+{
+    while (s->len - s->pos < n && !s->eof) {
+	int r;
+	if (s->pos > 0) {
+	    memmove(s->buf, s->buf + s->pos, s->len - s->pos);
+	    s->len -= s->pos;
+	    s->pos = 0;
+	}
+	r = s->io->afread(s->chan, s->buf + s->len, (int)(CHUNK - s->len));
+	if (r <= 0)
+	    s->eof = true;
+	else
+	    s->len += (size_t)r;
+    }
+    return s->len - s->pos;
+}
+
+/* the character i ahead of the next, or EOF */
+static int peek(stream_t * s, size_t i)
+{
+    if (s->len - s->pos <= i && avail(s, i + 1) <= i)
+	return EOF;
+    return (unsigned char)s->buf[s->pos + i];
+}
+
+static int getch(stream_t * s)
+{
+    int c = peek(s, 0);
+    if (c != EOF) {
+	s->pos++;
+	if (c == '\n')
+	    s->line++;
+    }
+    return c;
+}
+
+/* tokens */
+
+static bool isletter(int c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_'
+	|| (c >= 0200 && c <= 0377);
+}
+
+static bool isdigit_(int c)
+{
+    return c >= '0' && c <= '9';
+}
+
+static void putch(stream_t * s, int c)
+{
+    agxbputc(&s->tokbuf, (char)c);
+}
+
+static int keyword(stream_t * s)
+{
+    static const struct {
+	const char *name;
+	int tok;
+    } keywords[] = {
+	{"node", TOK_NODE}, {"edge", TOK_EDGE}, {"graph", TOK_GRAPH},
+	{"digraph", TOK_DIGRAPH}, {"strict", TOK_STRICT},
+	{"subgraph", TOK_SUBGRAPH},
+    };
+    const char *name = agxbstart(&s->tokbuf);
+    size_t len = agxblen(&s->tokbuf);
+
+    for (size_t i = 0; i < sizeof(keywords) / sizeof(keywords[0]); i++) {
+	if (strlen(keywords[i].name) == len
+	    && strncasecmp(keywords[i].name, name, len) == 0)
+	    return keywords[i].tok;
+    }
+    return TOK_ATOM;
+}
+
+/* a number, starting with '-', '.' or a digit */
+static void number(stream_t * s, int c)
+{
+    bool dot = c == '.';
+
+    putch(s, c);
+    for (;;) {
+	c = peek(s, 0);
+	if (c == '.' && !dot)
+	    dot = true;
+	else if (!isdigit_(c))
+	    break;
+	putch(s, getch(s));
+    }
+    if (isletter(c) || c == '.')
+	agerr(AGWARN, "syntax ambiguity - badly delimited number '%.*s%c' in "
+	      "line %d of %s splits into two tokens\n",
+	      (int)agxblen(&s->tokbuf), agxbstart(&s->tokbuf), c, s->line,
+	      s->file ? s->file : "input");
+}
+
+static void lexerror(stream_t * s, const char *what)
+{
+    agerr(AGERR, "%s%ssyntax error in line %d scanning %s\n",
+	  s->file ? s->file : "", s->file ? ": " : "", s->line, what);
+    stop(s, -1);
+}
+
+static void qstring(stream_t * s)
+{
+    int c;
+
+    while ((c = getch(s)) != '"') {
+	if (c == EOF)
+	    lexerror(s, "a quoted string (missing endquote?)");
+	if (c == '\\') {
+	    int d = peek(s, 0);
+	    if (d == '"') {
+		getch(s);
+		putch(s, '"');
+		continue;
+	    }
+	    if (d == '\\') {
+		getch(s);
+		putch(s, '\\');
+	    } else if (d == '\n') {	/* escaped newlines are ignored */
+		getch(s);
+		continue;
+	    }
+	}
+	putch(s, c);
+    }
+}
+
+static void hstring(stream_t * s)
+{
+    int c, nest = 1;
+
+    while ((c = getch(s)) != EOF) {
+	if (c == '>' && --nest == 0)
+	    return;
+	if (c == '<')
+	    nest++;
+	putch(s, c);
+    }
+    lexerror(s, "a HTML string (missing '>'? bad nesting?)");
+}
+
+static void lex(stream_t * s)
+{
+    int c;
+
+    agxbclear(&s->tokbuf);
+    s->tokhtml = false;
+    for (;;) {
+	c = getch(s);
+	if (c == EOF || c == '@') {
+	    s->tok = TOK_EOF;
+	    return;
+	}
+	if (c == ' ' || c == '\t' || c == '\r' || c == '\n')
+	    continue;
+	if (c == 0xEF && peek(s, 0) == 0xBB && peek(s, 1) == 0xBF) {
+	    getch(s);
+	    getch(s);
+	    continue;
+	}
+	if (c == '#' || (c == '/' && peek(s, 0) == '/')) {
+	    while ((c = peek(s, 0)) != EOF && c != '\n')
+		getch(s);
+	    continue;
+	}
+	if (c == '/' && peek(s, 0) == '*') {
+	    getch(s);
+	    while ((c = getch(s)) != EOF && !(c == '*' && peek(s, 0) == '/'));
+	    getch(s);
+	    continue;
+	}
+	break;
+    }
+
+    if (isletter(c)) {
+	putch(s, c);
+	while (isletter(peek(s, 0)) || isdigit_(peek(s, 0)))
+	    putch(s, getch(s));
+	s->tok = keyword(s);
+    } else if (isdigit_(c) || (c == '.' && isdigit_(peek(s, 0)))
+	       || (c == '-' && (isdigit_(peek(s, 0))
+				|| (peek(s, 0) == '.'
+				    && isdigit_(peek(s, 1)))))) {
+	number(s, c);
+	s->tok = TOK_ATOM;
+    } else if (c == '-' && (peek(s, 0) == '>' || peek(s, 0) == '-')) {
+	int d = getch(s);
+	putch(s, c);
+	putch(s, d);
+	s->tok = (d == '>') == s->directed ? TOK_EDGEOP : '-';
+    } else if (c == '"') {
+	qstring(s);
+	s->tok = TOK_QATOM;
+    } else if (c == '<') {
+	hstring(s);
+	s->tok = TOK_QATOM;
+	s->tokhtml = true;
+    } else {
+	putch(s, c);
+	s->tok = c;
+    }
+}
+
+static void syntax_error(stream_t * s)
+{
+    const char *file = s->file ? s->file : "";
+    const char *sep = s->file ? ": " : "";
+
+    if (s->tok == TOK_EOF)
+	agerr(AGERR, "%s%ssyntax error in line %d\n", file, sep, s->line);
+    else
+	agerr(AGERR, "%s%ssyntax error in line %d near '%s'\n", file, sep,
+	      s->line, agxbuse(&s->tokbuf));
+    stop(s, -1);
+}
+
+static void expect(stream_t * s, int tok)
+{
+    if (s->tok != tok)
+	syntax_error(s);
+    lex(s);
+}
+
+static bool isatom(stream_t * s)
+{
+    return s->tok == TOK_ATOM || s->tok == TOK_QATOM;
+}
+
+/* statement text */
+
+static void append(stream_t * s, const char *data, size_t size)
+{
+    if (s->textlen + size > s->textcap) {
+	size_t cap = s->textcap ? s->textcap * 2 : BUFSIZ;
+	while (cap < s->textlen + size)
+	    cap *= 2;
+	s->text = gv_recalloc(s->text, s->textcap, cap, 1);
+	s->textcap = cap;
+    }
+    memcpy(s->text + s->textlen, data, size);
+    s->textlen += size;
+}
+
+/* atom, with any quoted strings joined by '+' */
+static text_t atom(stream_t * s)
+{
+    text_t t = {.offset = s->textlen, .html = s->tokhtml};
+    bool quoted = s->tok == TOK_QATOM;
+
+    if (!isatom(s))
+	syntax_error(s);
+    append(s, agxbstart(&s->tokbuf), agxblen(&s->tokbuf));
+    lex(s);
+    while (quoted && s->tok == '+') {
+	lex(s);
+	if (s->tok != TOK_QATOM)
+	    syntax_error(s);
+	append(s, agxbstart(&s->tokbuf), agxblen(&s->tokbuf));
+	t.html = false;
+	lex(s);
+    }
+    t.size = s->textlen - t.offset;
+    return t;
+}
+
+static Agtext_t view(stream_t * s, text_t t)
+{
+    return (Agtext_t) {.data = s->text + t.offset, .size = t.size,
+		       .html = t.html};
+}
+
+static const Agtext_t None;
+
+/* handlers */
+
+static void check(stream_t * s, int rv)
+{
+    if (rv)
+	stop(s, rv);
+}
+
+/* set up views of the statement's attributes after room for ports */
+static Agtext_t *attrviews(stream_t * s)
+{
+    views_clear(&s->views);
+    for (size_t i = 0; i < PORTVIEWS; i++)
+	views_append(&s->views, None);
+    for (size_t i = 0; i < texts_size(&s->attrs); i++)
+	views_append(&s->views, view(s, texts_get(&s->attrs, i)));
+    return views_at(&s->views, 0) + PORTVIEWS;
+}
+
+static void attrs_event(stream_t * s, int kind)
+{
+    Agstreamdisc_t *h = s->handlers;
+
+    if (h->attr) {
+	Agtext_t *v = attrviews(s);
+	check(s, h->attr(s->state, kind, texts_size(&s->attrs) / 2, v));
+    }
+}
+
+/* nodes of a node list operand, with the statement attributes if it is a
+ * node statement
+ */
+static void node_events(stream_t * s, operand_t op, bool withattrs)
+{
+    Agstreamdisc_t *h = s->handlers;
+
+    if (op.subg || !h->node)
+	return;
+    Agtext_t *v = attrviews(s);
+    size_t nattrs = withattrs ? texts_size(&s->attrs) / 2 : 0;
+    for (size_t i = op.first; i < op.last; i++) {
+	end_t n = ends_get(&s->ends, i);
+	check(s, h->node(s->state, view(s, n.name), nattrs, v));
+    }
+}
+
+static end_t operand_get(stream_t * s, operand_t op, size_t i)
+{
+    return op.subg ? ends_get(&s->members, i) : ends_get(&s->ends, i);
+}
+
+static void edge_events(stream_t * s, operand_t tails, operand_t heads)
+{
+    static const Agtext_t Tailport = {TAILPORT_ID, sizeof(TAILPORT_ID) - 1, 0};
+    static const Agtext_t Headport = {HEADPORT_ID, sizeof(HEADPORT_ID) - 1, 0};
+    Agstreamdisc_t *h = s->handlers;
+
+    if (!h->edge)
+	return;
+    Agtext_t *attrs = attrviews(s);
+    size_t nattrs = texts_size(&s->attrs) / 2;
+    for (size_t i = tails.first; i < tails.last; i++) {
+	end_t t = operand_get(s, tails, i);
+	for (size_t j = heads.first; j < heads.last; j++) {
+	    end_t hd = operand_get(s, heads, j);
+	    Agtext_t *v = attrs;
+	    size_t n = nattrs;
+	    if (hd.hasport) {
+		*--v = view(s, hd.port);
+		*--v = Headport;
+		n++;
+	    }
+	    if (t.hasport) {
+		*--v = view(s, t.port);
+		*--v = Tailport;
+		n++;
+	    }
+	    check(s, h->edge(s->state, view(s, t.name), view(s, hd.name), n, v));
+	}
+    }
+}
+
+/* statements */
+
+static void stmtlist(stream_t * s);
+
+static void attrlists(stream_t * s)
+{
+    while (s->tok == '[') {
+	lex(s);
+	while (s->tok != ']') {
+	    texts_append(&s->attrs, atom(s));
+	    expect(s, '=');
+	    texts_append(&s->attrs, atom(s));
+	    if (s->tok == ';' || s->tok == ',')
+		lex(s);
+	}
+	lex(s);
+    }
+}
+
+static void attrstmt(stream_t * s)
+{
+    int kind = s->tok == TOK_GRAPH ? AGRAPH : s->tok == TOK_NODE ? AGNODE
+	: AGEDGE;
+
+    lex(s);
+    if (isatom(s)) {
+	(void)atom(s);
+	expect(s, '=');
+	agerr(AGWARN, "attribute macros not implemented");
+    }
+    if (s->tok != '[')
+	syntax_error(s);
+    attrlists(s);
+    attrs_event(s, kind);
+}
+
+static int cmpmember(const void *a, const void *b, void *arg)
+{
+    stream_t *s = arg;
+    const size_t *x = a;
+    const size_t *y = b;
+    text_t tx = ends_get(&s->members, *x).name;
+    text_t ty = ends_get(&s->members, *y).name;
+    size_t n = tx.size < ty.size ? tx.size : ty.size;
+    int c = memcmp(s->text + tx.offset, s->text + ty.offset, n);
+
+    if (c)
+	return c;
+    if (tx.size != ty.size)
+	return tx.size < ty.size ? -1 : 1;
+    return *x < *y ? -1 : *x > *y;
+}
+
+static bool samename(stream_t * s, text_t a, text_t b)
+{
+    return a.size == b.size
+	&& memcmp(s->text + a.offset, s->text + b.offset, a.size) == 0;
+}
+
+/* drop all but the first mention of each member from first on */
+static void uniqmembers(stream_t * s, size_t first)
+{
+    size_t n = ends_size(&s->members) - first;
+    size_t *order;
+    bool *dup;
+    size_t k;
+
+    if (n < 2)
+	return;
+    order = gv_calloc(n, sizeof(size_t));
+    dup = gv_calloc(n, sizeof(bool));
+    for (size_t i = 0; i < n; i++)
+	order[i] = first + i;
+    gv_sort(order, n, sizeof(size_t), cmpmember, s);
+    for (size_t i = 1; i < n; i++) {
+	if (samename(s, ends_get(&s->members, order[i - 1]).name,
+		     ends_get(&s->members, order[i]).name))
+	    dup[order[i] - first] = true;
+    }
+    k = first;
+    for (size_t i = 0; i < n; i++) {
+	if (!dup[i])
+	    ends_set(&s->members, k++, ends_get(&s->members, first + i));
+    }
+    ends_resize(&s->members, k, (end_t) {0});
+    free(order);
+    free(dup);
+}
+
+static void subgraph(stream_t * s, operand_t * op)
+{
+    Agstreamdisc_t *h = s->handlers;
+    text_t name = {0};
+    bool named = false;
+
+    if (s->tok == TOK_SUBGRAPH) {
+	lex(s);
+	if (isatom(s)) {
+	    name = atom(s);
+	    named = true;
+	}
+    }
+    if (s->tok != '{')
+	syntax_error(s);
+    if (++s->depth > MAXDEPTH) {
+	agerr(AGERR, "subgraphs nested more than %d deep\n", MAXDEPTH);
+	stop(s, -1);
+    }
+    lex(s);
+    if (h->subgraph)
+	check(s, h->subgraph(s->state, named ? view(s, name) : None));
+    op->subg = true;
+    op->first = ends_size(&s->members);
+    s->collect++;
+    stmtlist(s);
+    s->collect--;
+    uniqmembers(s, op->first);
+    op->last = ends_size(&s->members);
+    s->depth--;
+    if (h->endsubgraph)
+	check(s, h->endsubgraph(s->state));
+}
+
+static void nodelist(stream_t * s, operand_t * op, const text_t * first)
+{
+    op->subg = false;
+    op->first = ends_size(&s->ends);
+    for (;;) {
+	end_t n = {.name = first ? *first : atom(s)};
+	first = NULL;
+	if (s->tok == ':') {
+	    lex(s);
+	    n.port = atom(s);
+	    n.hasport = true;
+	    if (s->tok == ':') {
+		lex(s);
+		append(s, ":", 1);
+		text_t compass = atom(s);
+		n.port.size = compass.offset + compass.size - n.port.offset;
+		n.port.html = false;
+	    }
+	}
+	ends_append(&s->ends, n);
+	if (s->collect)
+	    ends_append(&s->members, n);
+	if (s->tok != ',')
+	    break;
+	lex(s);
+    }
+    op->last = ends_size(&s->ends);
+}
+
+static void operand(stream_t * s, const text_t * first)
+{
+    operand_t op;
+
+    if (first || isatom(s))
+	nodelist(s, &op, first);
+    else if (s->tok == TOK_SUBGRAPH || s->tok == '{')
+	subgraph(s, &op);
+    else
+	syntax_error(s);
+    operands_append(&s->operands, op);
+}
+
+/* node, edge or subgraph statement */
+static void compound(stream_t * s, const text_t * first)
+{
+    size_t ends0 = ends_size(&s->ends);
+    size_t ops0 = operands_size(&s->operands);
+    size_t n;
+
+    operand(s, first);
+    while (s->tok == TOK_EDGEOP) {
+	lex(s);
+	operand(s, NULL);
+    }
+    texts_clear(&s->attrs);
+    attrlists(s);
+
+    n = operands_size(&s->operands) - ops0;
+    if (n == 1)
+	node_events(s, operands_get(&s->operands, ops0), true);
+    /* endpoints only next to empty subgraphs make no edges, but are still
+     * nodes of the graph
+     */
+    for (size_t i = ops0; n > 1 && i < ops0 + n; i++) {
+	operand_t prev = i > ops0 ? operands_get(&s->operands, i - 1)
+	    : (operand_t) {0};
+	operand_t next = i + 1 < ops0 + n ? operands_get(&s->operands, i + 1)
+	    : (operand_t) {0};
+	if (prev.first == prev.last && next.first == next.last)
+	    node_events(s, operands_get(&s->operands, i), false);
+    }
+    for (size_t i = ops0; i + 1 < ops0 + n; i++)
+	edge_events(s, operands_get(&s->operands, i),
+		    operands_get(&s->operands, i + 1));
+
+    ends_resize(&s->ends, ends0, (end_t) {0});
+    operands_resize(&s->operands, ops0, (operand_t) {0});
+}
+
+static void stmt(stream_t * s)
+{
+    size_t mark = s->textlen;
+
+    texts_clear(&s->attrs);
+    switch (s->tok) {
+    case TOK_GRAPH:
+    case TOK_NODE:
+    case TOK_EDGE:
+	attrstmt(s);
+	break;
+    case TOK_ATOM:
+    case TOK_QATOM:{
+	    text_t name = atom(s);
+	    if (s->tok == '=') {
+		lex(s);
+		texts_append(&s->attrs, name);
+		texts_append(&s->attrs, atom(s));
+		attrs_event(s, AGRAPH);
+	    } else
+		compound(s, &name);
+	    break;
+	}
+    case TOK_SUBGRAPH:
+    case '{':
+	compound(s, NULL);
+	break;
+    default:
+	syntax_error(s);
+    }
+    texts_clear(&s->attrs);
+    if (!s->collect) {
+	s->textlen = mark;
+	ends_clear(&s->members);
+    }
+}
+
+/* statements up to and including the closing brace */
+static void stmtlist(stream_t * s)
+{
+    while (s->tok != '}') {
+	stmt(s);
+	if (s->tok == ';')
+	    lex(s);
+    }
+    lex(s);
+}
+
+/* a graph, or false at the end of the input */
+static bool graph(stream_t * s)
+{
+    Agstreamdisc_t *h = s->handlers;
+    Agdesc_t desc = Agundirected;
+    text_t name = {0};
+    bool named = false;
+
+    if (s->tok == TOK_EOF)
+	return false;
+    if (s->tok == TOK_STRICT) {
+	desc.strict = 1;
+	lex(s);
+    }
+    if (s->tok == TOK_DIGRAPH)
+	desc.directed = 1;
+    else if (s->tok != TOK_GRAPH)
+	syntax_error(s);
+    s->directed = desc.directed;
+    lex(s);
+    if (isatom(s)) {
+	name = atom(s);
+	named = true;
+    }
+    if (s->tok != '{')
+	syntax_error(s);
+    if (h->graph)
+	check(s, h->graph(s->state, named ? view(s, name) : None, desc));
+    s->textlen = 0;
+    lex(s);
+    stmtlist(s);
+    if (h->endgraph)
+	check(s, h->endgraph(s->state));
+    return true;
+}
+
+int agstream(void *chan, Agiodisc_t * io, Agstreamdisc_t * handlers,
+	     void *state)
+{
+    stream_t *s = gv_alloc(sizeof(stream_t));
+    int rv;
+
+    s->chan = chan;
+    s->io = io ? io : &AgIoDisc;
+    s->buf = gv_alloc(CHUNK);
+    s->line = 1;
+    s->file = aginputfile();
+    agxbinit(&s->tokbuf, 0, NULL);
+    s->handlers = handlers;
+    s->state = state;
+
+    if (setjmp(s->jbuf) == 0) {
+	lex(s);
+	while (graph(s));
+    }
+    rv = s->rv;
+
+    agxbfree(&s->tokbuf);
+    free(s->buf);
+    free(s->text);
+    ends_free(&s->ends);
+    ends_free(&s->members);
+    operands_free(&s->operands);
+    texts_free(&s->attrs);
+    views_free(&s->views);
+    free(s);
+    return rv;
+}
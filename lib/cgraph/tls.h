@@ -0,0 +1,15 @@
+/// \file
+/// \brief thread-local storage specifier
+
+#pragma once
+
+/// thread-local storage specifier
+#ifdef _MSC_VER
+#define TLS __declspec(thread)
+#elif defined(__GNUC__)
+#define TLS __thread
+#else
+// assume this environment does not support threads and fall back to (thread
+// unsafe) globals
+#define TLS /* nothing */
+#endif
@@ -11,7 +11,7 @@
 #include <cgraph/cghdr.h>
 #include <stddef.h>
 
-static Agraph_t *Ag_dictop_G;
+static TLS Agraph_t *Ag_dictop_G;
 
 /* only indirect call through dtopen() is expected */
 void *agdictobjmem(Dict_t * dict, void * p, size_t size, Dtdisc_t * disc)
@@ -53,11 +53,15 @@ Dict_t *agdtopen(Agraph_t * g, Dtdisc_t * disc, Dtmethod_t * method)
     Dtmemory_f memf;
     Dict_t *d;
 
+    /* cgraph's disciplines name agdictobjmem already, so that graphs opened
+     * in several threads do not write to them */
     memf = disc->memoryf;
-    disc->memoryf = agdictobjmem;
+    if (memf != agdictobjmem)
+	disc->memoryf = agdictobjmem;
     Ag_dictop_G = g;
     d = dtopen(disc, method);
-    disc->memoryf = memf;
+    if (memf != agdictobjmem)
+	disc->memoryf = memf;
     Ag_dictop_G = NULL;
     return d;
 }
@@ -75,11 +79,13 @@ int agdtclose(Agraph_t * g, Dict_t * dict)
 
     disc = dtdisc(dict, NULL, 0);
     memf = disc->memoryf;
-    disc->memoryf = agdictobjmem;
+    if (memf != agdictobjmem)
+	disc->memoryf = agdictobjmem;
     Ag_dictop_G = g;
     if (dtclose(dict))
 	return 1;
-    disc->memoryf = memf;
+    if (memf != agdictobjmem)
+	disc->memoryf = memf;
     Ag_dictop_G = NULL;
     return 0;
 }
@@ -33,9 +33,9 @@ static int ioput(Agraph_t * g, iochan_t * ofile, char *str)
 #define MAX_OUTPUTLINE		128
 #define MIN_OUTPUTLINE		 60
 static int write_body(Agraph_t * g, iochan_t * ofile);
-static int Level;
-static int Max_outputline = MAX_OUTPUTLINE;
-static Agsym_t *Tailport, *Headport;
+static TLS int Level;
+static TLS int Max_outputline = MAX_OUTPUTLINE;
+static TLS Agsym_t *Tailport, *Headport;
 
 static int indent(Agraph_t * g, iochan_t * ofile)
 {
@@ -163,8 +163,8 @@ char *agstrcanon(char *arg, char *buf)
 
 static char *getoutputbuffer(const char *str)
 {
-    static char *rv;
-    static size_t len = 0;
+    static TLS char *rv;
+    static TLS size_t len = 0;
     size_t req;
 
     req = MAX(2 * strlen(str) + 2, BUFSIZ);
@@ -407,13 +407,12 @@ static bool has_no_predecessor_below(Agraph_t * g, Agnode_t * n,
 
 static bool not_default_attrs(Agraph_t * g, Agnode_t * n)
 {
-    Agattr_t *data;
+    Agdatadict_t *dd;
     Agsym_t *sym;
 
-    (void)g;
-    if ((data = agattrrec(n))) {
-	for (sym = dtfirst(data->dict); sym; sym = dtnext(data->dict, sym)) {
-	    if (data->str[sym->id] != sym->defval)
+    if ((dd = agdatadict(agroot(g), FALSE))) {
+	for (sym = dtfirst(dd->dict.n); sym; sym = dtnext(dd->dict.n, sym)) {
+	    if (agxget(n, sym) != sym->defval)
 		return true;
 	}
     }
@@ -463,7 +462,6 @@ static int write_edge_name(Agedge_t * e, iochan_t * ofile, int terminate)
 static int write_nondefault_attrs(void *obj, iochan_t * ofile,
 				  Dict_t * defdict)
 {
-    Agattr_t *data;
     Agsym_t *sym;
     Agraph_t *g;
     int cnt = 0;
@@ -474,9 +472,8 @@ static int write_nondefault_attrs(void *obj, iochan_t * ofile,
 	if (rv)
 	    cnt++;
     }
-    data = agattrrec(obj);
     g = agraphof(obj);
-    if (data)
+    if (agattrrec(obj) || agroot(g)->desc.columnar)
 	for (sym = dtfirst(defdict); sym; sym = dtnext(defdict, sym)) {
 	    if (AGTYPE(obj) == AGINEDGE || AGTYPE(obj) == AGOUTEDGE) {
 		if (Tailport && sym->id == Tailport->id)
@@ -484,7 +481,8 @@ static int write_nondefault_attrs(void *obj, iochan_t * ofile,
 		if (Headport && sym->id == Headport->id)
 		    continue;
 	    }
-	    if (data->str[sym->id] != sym->defval) {
+	    char *value = agxget(obj, sym);
+	    if (value != sym->defval) {
 		if (cnt++ == 0) {
 		    CHKRV(ioput(g, ofile, "\t["));
 		    Level++;
@@ -494,7 +492,7 @@ static int write_nondefault_attrs(void *obj, iochan_t * ofile,
 		}
 		CHKRV(write_canonstr(g, ofile, sym->name));
 		CHKRV(ioput(g, ofile, "="));
-		CHKRV(write_canonstr(g, ofile, data->str[sym->id]));
+		CHKRV(write_canonstr(g, ofile, value));
 	    }
 	}
     if (cnt > 0) {
@@ -11,6 +11,7 @@
 #include	<cgraph/list.h>
 #include	<cgraph/agxbuf.h>
 #include	<cgraph/alloc.h>
+#include	<cgraph/tls.h>
 #include	<circogen/blockpath.h>
 #include	<circogen/edgelist.h>
 #include	<stddef.h>
@@ -37,7 +38,7 @@ static Agraph_t *clone_graph(Agraph_t * ing, Agraph_t ** xg)
     Agedge_t *e;
     Agedge_t *xe;
     agxbuf gname = {0};
-    static int id = 0;
+    static TLS int id = 0;
 
     agxbprint(&gname, "_clone_%d", id++);
     clone = agsubg(ing, agxbuse(&gname), 1);
@@ -378,7 +379,7 @@ static Agraph_t *spanning_tree(Agraph_t * g)
     Agnode_t *n;
     Agraph_t *tree;
     agxbuf gname = {0};
-    static int id = 0;
+    static TLS int id = 0;
 
     agxbprint(&gname, "_span_%d", id++);
     tree = agsubg(g, agxbuse(&gname), 1);
@@ -9,6 +9,7 @@
  *************************************************************************/
 
 #include    <cgraph/agxbuf.h>
+#include    <cgraph/tls.h>
 #include    <circogen/circular.h>
 #include    <circogen/blocktree.h>
 #include    <circogen/circpos.h>
@@ -22,10 +23,10 @@
  */
 static void initGraphAttrs(Agraph_t * g, circ_state * state)
 {
-    static Agraph_t *rootg;
-    static attrsym_t *N_root;
-    static attrsym_t *G_mindist;
-    static char *rootname;
+    static TLS Agraph_t *rootg;
+    static TLS attrsym_t *N_root;
+    static TLS attrsym_t *G_mindist;
+    static TLS char *rootname;
     Agraph_t *rg;
     node_t *n = agfstnode(g);
 
@@ -76,7 +77,7 @@ createOneBlock(Agraph_t * g, circ_state * state)
 void circularLayout(Agraph_t * g, Agraph_t* realg)
 {
     block_t *root;
-    static circ_state state;
+    static TLS circ_state state;
 
     if (agnnodes(g) == 1) {
 	Agnode_t *n = agfstnode(g);
@@ -24,10 +24,11 @@
 
 static void circular_init_edge(edge_t * e)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     agbindrec(e, "Agedgeinfo_t", sizeof(Agedgeinfo_t), true);	//node custom data
     common_init_edge(e);
 
-    ED_factor(e) = late_double(e, E_weight, 1.0, 0.0);
+    ED_factor(e) = late_double(e, lctx->E_weight, 1.0, 0.0);
 }
 
 
@@ -54,9 +55,10 @@ static void circular_init_node_edge(graph_t * g)
 
 void circo_init_graph(graph_t * g)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     setEdgeType (g, EDGETYPE_LINE);
     /* GD_ndim(g) = late_int(g,agfindattr(g,"dim"),2,2); */
-    Ndim = GD_ndim(agroot(g)) = 2;	/* The algorithm only makes sense in 2D */
+    lctx->Ndim = GD_ndim(agroot(g)) = 2;	/* The algorithm only makes sense in 2D */
     circular_init_node_edge(g);
 }
 
@@ -69,11 +71,12 @@ void circo_init_graph(graph_t * g)
 static node_t *makeDerivedNode(graph_t * dg, char *name, int isNode,
 			       void *orig)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     node_t *n = agnode(dg, name,1);
     agbindrec(n, "Agnodeinfo_t", sizeof(Agnodeinfo_t), true);	//node custom data
     ND_alg(n) = gv_alloc(sizeof(cdata));
     if (isNode) {
-	ND_pos(n) = gv_calloc(Ndim, sizeof(double));
+	ND_pos(n) = gv_calloc(lctx->Ndim, sizeof(double));
 	ND_lw(n) = ND_lw(orig);
 	ND_rw(n) = ND_rw(orig);
 	ND_ht(n) = ND_ht(orig);
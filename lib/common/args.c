@@ -31,6 +31,7 @@
  * Return number of unprocessed arguments; return < 0 on error.
  */
 static int neato_extra_args(int argc, char** argv) {
+  layout_context_t *const lctx = gvLayoutContext();
   char** p = argv+1;
   int    i;
   char*  arg;
@@ -44,14 +45,14 @@ static int neato_extra_args(int argc, char** argv) {
       case 'x' : Reduce = TRUE; break;
       case 'n':
         if (arg[2]) {
-          Nop = atoi(arg+2);
-          if (Nop <= 0) {
+          lctx->Nop = atoi(arg+2);
+          if (lctx->Nop <= 0) {
             agerr (AGERR, "Invalid parameter \"%s\" for -n flag\n", arg+2);
             dotneato_usage (1);
 	    return -1;
           }
         }
-        else Nop = 1;
+        else lctx->Nop = 1;
         break;
       default :
         cnt++;
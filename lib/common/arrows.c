@@ -251,11 +251,12 @@ static void arrow_match_name(char *name, arrowflags_t *flag) {
 }
 
 void arrow_flags(Agedge_t *e, uint32_t *sflag, uint32_t *eflag) {
+    layout_context_t *const lctx = gvLayoutContext();
     char *attr;
 
     arrowflags_t sf = {.flags = {{.type = ARR_TYPE_NONE}}};
     arrowflags_t ef = {.flags = {{.type = agisdirected(agraphof(e)) ? ARR_TYPE_NORM : ARR_TYPE_NONE}}};
-    if (E_dir && ((attr = agxget(e, E_dir)))[0]) {
+    if (lctx->E_dir && ((attr = agxget(e, lctx->E_dir)))[0]) {
 	for (const arrowdir_t *arrowdir = Arrowdirs; arrowdir->dir; arrowdir++) {
 	    if (streq(attr, arrowdir->dir)) {
 		sf.flags[0].type = arrowdir->stype;
@@ -293,11 +294,12 @@ void arrow_flags(Agedge_t *e, uint32_t *sflag, uint32_t *eflag) {
 }
 
 static double arrow_length(edge_t * e, uint32_t flag) {
+    layout_context_t *const lctx = gvLayoutContext();
     double length = 0.0;
     int i;
 
-    const double penwidth = late_double(e, E_penwidth, 1.0, 0.0);
-    const double arrowsize = late_double(e, E_arrowsz, 1.0, 0.0);
+    const double penwidth = late_double(e, lctx->E_penwidth, 1.0, 0.0);
+    const double arrowsize = late_double(e, lctx->E_arrowsz, 1.0, 0.0);
 
     if (arrowsize == 0) {
 	return 0;
@@ -22,9 +22,10 @@
 #include <common/memory.h>
 #include <cgraph/agxbuf.h>
 #include <cgraph/strcasecmp.h>
+#include <cgraph/tls.h>
 #include <cgraph/unreachable.h>
 
-static char* colorscheme;
+static TLS char* colorscheme;
 
 static void hsv2rgb(double h, double s, double v,
 			double *r, double *g, double *b)
@@ -135,8 +136,8 @@ static int colorcmpf(const void *p0, const void *p1)
 
 char *canontoken(char *str)
 {
-    static char *canon;
-    static size_t allocated;
+    static TLS char *canon;
+    static TLS size_t allocated;
     char c, *p, *q;
     size_t len;
 
@@ -234,7 +235,7 @@ static char* resolveColor (char* str)
 
 int colorxlate(char *str, gvcolor_t * color, color_type_t target_type)
 {
-    static hsvrgbacolor_t *last;
+    static TLS hsvrgbacolor_t *last;
     char *p;
     hsvrgbacolor_t fake;
     char c;
@@ -47,6 +47,7 @@
  */
 
 #include <cgraph/alloc.h>
+#include <cgraph/tls.h>
 #include <math.h>
 #include <stdbool.h>
 #ifdef STANDALONE
@@ -391,7 +392,7 @@ estimateError(ellipse_t * ep, int degree, double etaA, double etaB)
  * Assume initial call to moveTo to initialize, followed by
  * calls to curveTo and lineTo, and finished with endPath.
  */
-static int bufsize;
+static TLS int bufsize;
 
 static void moveTo(Ppolyline_t *polypath, double x, double y)
 {
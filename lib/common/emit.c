@@ -26,6 +26,7 @@
 #include <cgraph/agxbuf.h>
 #include <cgraph/alloc.h>
 #include <cgraph/list.h>
+#include <cgraph/tls.h>
 #include <cgraph/unreachable.h>
 #include <common/htmltable.h>
 #include <gvc/gvc.h>
@@ -726,9 +727,10 @@ static bool isRect(polygon_t * p)
  */
 static bool isFilled(node_t * n)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     char *style, *p, **pp;
     bool r = false;
-    style = late_nnstring(n, N_style, "");
+    style = late_nnstring(n, lctx->N_style, "");
     if (style[0]) {
         pp = parse_style(style);
         while ((p = *pp)) {
@@ -1586,6 +1588,7 @@ static void emit_xdot (GVJ_t * job, xdot* xd)
 
 static void emit_background(GVJ_t * job, graph_t *g)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     xdot* xd;
     char *str;
     int dfltColor;
@@ -1617,9 +1620,9 @@ static void emit_background(GVJ_t * job, graph_t *g)
             gvrender_set_pencolor(job, "transparent");
 	    checkClusterStyle(g, &istyle);
 	    if (clrs[1]) 
-		gvrender_set_gradient_vals(job,clrs[1],late_int(g,G_gradientangle,0,0), frac);
+		gvrender_set_gradient_vals(job,clrs[1],late_int(g,lctx->G_gradientangle,0,0), frac);
 	    else 
-		gvrender_set_gradient_vals(job,DEFAULT_COLOR,late_int(g,G_gradientangle,0,0), frac);
+		gvrender_set_gradient_vals(job,DEFAULT_COLOR,late_int(g,lctx->G_gradientangle,0,0), frac);
 	    if (istyle & RADIAL)
 		filled = RGRADIENT;
 	    else
@@ -1693,12 +1696,13 @@ static void setup_page(GVJ_t * job)
 
 static bool node_in_layer(GVJ_t *job, graph_t * g, node_t * n)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     char *pn, *pe;
     edge_t *e;
 
     if (job->numLayers <= 1)
 	return true;
-    pn = late_string(n, N_layer, "");
+    pn = late_string(n, lctx->N_layer, "");
     if (selectedlayer(job, pn))
 	return true;
     if (pn[0])
@@ -1706,7 +1710,7 @@ static bool node_in_layer(GVJ_t *job, graph_t * g, node_t * n)
     if ((e = agfstedge(g, n)) == NULL)
 	return true;
     for (e = agfstedge(g, n); e; e = agnxtedge(g, e, n)) {
-	pe = late_string(e, E_layer, "");
+	pe = late_string(e, lctx->E_layer, "");
 	if (pe[0] == '\0' || selectedlayer(job, pe))
 	    return true;
     }
@@ -1715,18 +1719,19 @@ static bool node_in_layer(GVJ_t *job, graph_t * g, node_t * n)
 
 static bool edge_in_layer(GVJ_t *job, edge_t * e)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     char *pe, *pn;
     int cnt;
 
     if (job->numLayers <= 1)
 	return true;
-    pe = late_string(e, E_layer, "");
+    pe = late_string(e, lctx->E_layer, "");
     if (selectedlayer(job, pe))
 	return true;
     if (pe[0])
 	return false;
     for (cnt = 0; cnt < 2; cnt++) {
-	pn = late_string(cnt < 1 ? agtail(e) : aghead(e), N_layer, "");
+	pn = late_string(cnt < 1 ? agtail(e) : aghead(e), lctx->N_layer, "");
 	if (pn[0] == '\0' || selectedlayer(job, pn))
 	    return true;
     }
@@ -1913,6 +1918,7 @@ static void emit_end_node(GVJ_t * job)
  */
 static void emit_node(GVJ_t * job, node_t * n)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     GVC_t *gvc = job->gvc;
     char *s;
     char *style;
@@ -1928,11 +1934,11 @@ static void emit_node(GVJ_t * job, node_t * n)
 	ND_state(n) = gvc->common.viewNum; 	     /* mark node as drawn */
 
         gvrender_comment(job, agnameof(n));
-	s = late_string(n, N_comment, "");
+	s = late_string(n, lctx->N_comment, "");
 	if (s[0])
 	    gvrender_comment(job, s);
         
-	style = late_string(n, N_style, "");
+	style = late_string(n, lctx->N_style, "");
 	if (style[0]) {
 	    styles = parse_style(style);
 	    sp = styles;
@@ -2014,8 +2020,8 @@ static void emit_attachment(GVJ_t * job, textlabel_t * lp, splines * spl)
  * so we commpute a default pencolor with the same number of colors. */
 static char* default_pencolor(char *pencolor, char *deflt)
 {
-    static char *buf;
-    static size_t bufsz;
+    static TLS char *buf;
+    static TLS size_t bufsz;
     char *p;
     size_t len, ncol;
 
@@ -2222,8 +2228,9 @@ static double bothfunc (double curlen, double totallen, double initwid)
 static radfunc_t 
 taperfun (edge_t* e)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     char* attr;
-    if (E_dir && ((attr = agxget(e, E_dir)))[0]) {
+    if (lctx->E_dir && ((attr = agxget(e, lctx->E_dir)))[0]) {
 	if (streq(attr, "forward")) return forfunc;
 	if (streq(attr, "back")) return revfunc;
 	if (streq(attr, "both")) return bothfunc;
@@ -2234,6 +2241,7 @@ taperfun (edge_t* e)
 
 static void emit_edge_graphics(GVJ_t * job, edge_t * e, char** styles)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     int i, j, cnum, numc = 0, numsemi = 0;
     char *color, *pencolor, *fillcolor;
     char *headcolor, *tailcolor, *lastcolor;
@@ -2249,8 +2257,8 @@ static void emit_edge_graphics(GVJ_t * job, edge_t * e, char** styles)
 
     setColorScheme (agget (e, "colorscheme"));
     if (ED_spl(e)) {
-	arrowsize = late_double(e, E_arrowsz, 1.0, 0.0);
-	color = late_string(e, E_color, "");
+	arrowsize = late_double(e, lctx->E_arrowsz, 1.0, 0.0);
+	color = late_string(e, lctx->E_color, "");
 
 	if (styles) {
 	    char** sp = styles;
@@ -2280,27 +2288,27 @@ static void emit_edge_graphics(GVJ_t * job, edge_t * e, char** styles)
 
 	fillcolor = pencolor = color;
 	if (ED_gui_state(e) & GUI_STATE_ACTIVE) {
-	    pencolor = late_nnstring(e, E_activepencolor,
+	    pencolor = late_nnstring(e, lctx->E_activepencolor,
 			default_pencolor(pencolor, DEFAULT_ACTIVEPENCOLOR));
-	    fillcolor = late_nnstring(e, E_activefillcolor, DEFAULT_ACTIVEFILLCOLOR);
+	    fillcolor = late_nnstring(e, lctx->E_activefillcolor, DEFAULT_ACTIVEFILLCOLOR);
 	}
 	else if (ED_gui_state(e) & GUI_STATE_SELECTED) {
-	    pencolor = late_nnstring(e, E_selectedpencolor,
+	    pencolor = late_nnstring(e, lctx->E_selectedpencolor,
 			default_pencolor(pencolor, DEFAULT_SELECTEDPENCOLOR));
-	    fillcolor = late_nnstring(e, E_selectedfillcolor, DEFAULT_SELECTEDFILLCOLOR);
+	    fillcolor = late_nnstring(e, lctx->E_selectedfillcolor, DEFAULT_SELECTEDFILLCOLOR);
 	}
 	else if (ED_gui_state(e) & GUI_STATE_DELETED) {
-	    pencolor = late_nnstring(e, E_deletedpencolor,
+	    pencolor = late_nnstring(e, lctx->E_deletedpencolor,
 			default_pencolor(pencolor, DEFAULT_DELETEDPENCOLOR));
-	    fillcolor = late_nnstring(e, E_deletedfillcolor, DEFAULT_DELETEDFILLCOLOR);
+	    fillcolor = late_nnstring(e, lctx->E_deletedfillcolor, DEFAULT_DELETEDFILLCOLOR);
 	}
 	else if (ED_gui_state(e) & GUI_STATE_VISITED) {
-	    pencolor = late_nnstring(e, E_visitedpencolor,
+	    pencolor = late_nnstring(e, lctx->E_visitedpencolor,
 			default_pencolor(pencolor, DEFAULT_VISITEDPENCOLOR));
-	    fillcolor = late_nnstring(e, E_visitedfillcolor, DEFAULT_VISITEDFILLCOLOR);
+	    fillcolor = late_nnstring(e, lctx->E_visitedfillcolor, DEFAULT_VISITEDFILLCOLOR);
 	}
 	else
-	    fillcolor = late_nnstring(e, E_fillcolor, color);
+	    fillcolor = late_nnstring(e, lctx->E_fillcolor, color);
 	if (pencolor != color)
     	    gvrender_set_pencolor(job, pencolor);
 	if (fillcolor != color)
@@ -2474,6 +2482,7 @@ static bool edge_in_box(edge_t *e, boxf b)
 
 static void emit_begin_edge(GVJ_t * job, edge_t * e, char** styles)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     obj_state_t *obj;
     int flags = job->flags;
     char *s;
@@ -2496,8 +2505,8 @@ static void emit_begin_edge(GVJ_t * job, edge_t * e, char** styles)
      */
     if (styles && ED_spl(e)) gvrender_set_style(job, styles);
 
-    if (E_penwidth && (s = agxget(e, E_penwidth)) && s[0]) {
-	penwidth = late_double(e, E_penwidth, 1.0, 0.0);
+    if (lctx->E_penwidth && (s = agxget(e, lctx->E_penwidth)) && s[0]) {
+	penwidth = late_double(e, lctx->E_penwidth, 1.0, 0.0);
 	gvrender_set_penwidth(job, penwidth);
     }
 
@@ -2742,6 +2751,7 @@ static void nodeIntersect(GVJ_t *job, pointf p, bool explicit_iurl, char *iurl,
 
 static void emit_end_edge(GVJ_t * job)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     obj_state_t *obj = job->obj;
     edge_t *e = obj->u.e;
     int i, nump;
@@ -2790,11 +2800,11 @@ static void emit_end_edge(GVJ_t * job)
     emit_edge_label(job, ED_label(e), EMIT_ELABEL,
 	obj->explicit_labeltooltip, 
 	obj->labelurl, obj->labeltooltip, obj->labeltarget, obj->id, 
-	((mapbool(late_string(e, E_decorate, "false")) && ED_spl(e)) ? ED_spl(e) : 0));
+	((mapbool(late_string(e, lctx->E_decorate, "false")) && ED_spl(e)) ? ED_spl(e) : 0));
     emit_edge_label(job, ED_xlabel(e), EMIT_ELABEL,
 	obj->explicit_labeltooltip, 
 	obj->labelurl, obj->labeltooltip, obj->labeltarget, obj->id, 
-	((mapbool(late_string(e, E_decorate, "false")) && ED_spl(e)) ? ED_spl(e) : 0));
+	((mapbool(late_string(e, lctx->E_decorate, "false")) && ED_spl(e)) ? ED_spl(e) : 0));
     emit_edge_label(job, ED_head_label(e), EMIT_HLABEL, 
 	obj->explicit_headtooltip,
 	obj->headurl, obj->headtooltip, obj->headtarget, obj->id,
@@ -2810,6 +2820,7 @@ static void emit_end_edge(GVJ_t * job)
 
 static void emit_edge(GVJ_t * job, edge_t * e)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     char *s;
     char *style;
     char **styles = NULL;
@@ -2829,11 +2840,11 @@ static void emit_edge(GVJ_t * job, edge_t * e)
 	gvrender_comment(job, s);
 	free(s);
 
-	s = late_string(e, E_comment, "");
+	s = late_string(e, lctx->E_comment, "");
 	if (s[0])
 	    gvrender_comment(job, s);
 
-	style = late_string(e, E_style, "");
+	style = late_string(e, lctx->E_style, "");
 	/* We shortcircuit drawing an invisible edge because the arrowhead
 	 * code resets the style to solid, and most of the code generators
 	 * (except PostScript) won't honor a previous style of invis.
@@ -2996,6 +3007,7 @@ boxf xdotBB (Agraph_t* g)
 
 static void init_gvc(GVC_t * gvc, graph_t * g)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     double xf, yf;
     char *p;
     int i;
@@ -3048,14 +3060,14 @@ static void init_gvc(GVC_t * gvc, graph_t * g)
     gvc->bb = GD_bb(g);
 
     /* clusters have peripheries */
-    G_peripheries = agfindgraphattr(g, "peripheries");
-    G_penwidth = agfindgraphattr(g, "penwidth");
+    lctx->G_peripheries = agfindgraphattr(g, "peripheries");
+    lctx->G_penwidth = agfindgraphattr(g, "penwidth");
 
     /* default font */
     gvc->defaultfontname = late_nnstring(NULL,
-                N_fontname, DEFAULT_FONTNAME);
+                lctx->N_fontname, DEFAULT_FONTNAME);
     gvc->defaultfontsize = late_double(NULL,
-                N_fontsize, DEFAULT_FONTSIZE, MIN_FONTSIZE);
+                lctx->N_fontsize, DEFAULT_FONTSIZE, MIN_FONTSIZE);
 
     /* default line style */
     gvc->defaultlinestyle = defaultlinestyle;
@@ -3508,7 +3520,7 @@ static void free_string_entry(Dict_t * dict, char *key, Dtdisc_t * disc)
     free(key);
 }
 
-static Dict_t *strings;
+static TLS Dict_t *strings;
 static Dtdisc_t stringdict = {
     .link = -1, // link - allocate separate holder objects
     .freef = (Dtfree_f)free_string_entry,
@@ -3553,6 +3565,7 @@ static void emit_end_cluster(GVJ_t *job) {
 
 void emit_clusters(GVJ_t * job, Agraph_t * g, int flags)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     int doPerim, c, istyle, filled;
     pointf AF[4];
     char *color, *fillcolor, *pencolor, **style, *s;
@@ -3590,23 +3603,23 @@ void emit_clusters(GVJ_t * job, Agraph_t * g, int flags)
 	fillcolor = pencolor = 0;
 
 	if (GD_gui_state(sg) & GUI_STATE_ACTIVE) {
-	    pencolor = late_nnstring(sg, G_activepencolor, DEFAULT_ACTIVEPENCOLOR);
-	    fillcolor = late_nnstring(sg, G_activefillcolor, DEFAULT_ACTIVEFILLCOLOR);
+	    pencolor = late_nnstring(sg, lctx->G_activepencolor, DEFAULT_ACTIVEPENCOLOR);
+	    fillcolor = late_nnstring(sg, lctx->G_activefillcolor, DEFAULT_ACTIVEFILLCOLOR);
 	    filled = TRUE;
 	}
 	else if (GD_gui_state(sg) & GUI_STATE_SELECTED) {
-	    pencolor = late_nnstring(sg, G_activepencolor, DEFAULT_SELECTEDPENCOLOR);
-	    fillcolor = late_nnstring(sg, G_activefillcolor, DEFAULT_SELECTEDFILLCOLOR);
+	    pencolor = late_nnstring(sg, lctx->G_activepencolor, DEFAULT_SELECTEDPENCOLOR);
+	    fillcolor = late_nnstring(sg, lctx->G_activefillcolor, DEFAULT_SELECTEDFILLCOLOR);
 	    filled = TRUE;
 	}
 	else if (GD_gui_state(sg) & GUI_STATE_DELETED) {
-	    pencolor = late_nnstring(sg, G_deletedpencolor, DEFAULT_DELETEDPENCOLOR);
-	    fillcolor = late_nnstring(sg, G_deletedfillcolor, DEFAULT_DELETEDFILLCOLOR);
+	    pencolor = late_nnstring(sg, lctx->G_deletedpencolor, DEFAULT_DELETEDPENCOLOR);
+	    fillcolor = late_nnstring(sg, lctx->G_deletedfillcolor, DEFAULT_DELETEDFILLCOLOR);
 	    filled = TRUE;
 	}
 	else if (GD_gui_state(sg) & GUI_STATE_VISITED) {
-	    pencolor = late_nnstring(sg, G_visitedpencolor, DEFAULT_VISITEDPENCOLOR);
-	    fillcolor = late_nnstring(sg, G_visitedfillcolor, DEFAULT_VISITEDFILLCOLOR);
+	    pencolor = late_nnstring(sg, lctx->G_visitedpencolor, DEFAULT_VISITEDPENCOLOR);
+	    fillcolor = late_nnstring(sg, lctx->G_visitedfillcolor, DEFAULT_VISITEDFILLCOLOR);
 	    filled = TRUE;
 	}
 	else {
@@ -3635,9 +3648,9 @@ void emit_clusters(GVJ_t * job, Agraph_t * g, int flags)
 	    if (findStopColor (fillcolor, clrs, &frac)) {
         	gvrender_set_fillcolor(job, clrs[0]);
 		if (clrs[1]) 
-		    gvrender_set_gradient_vals(job,clrs[1],late_int(sg,G_gradientangle,0,0), frac);
+		    gvrender_set_gradient_vals(job,clrs[1],late_int(sg,lctx->G_gradientangle,0,0), frac);
 		else 
-		    gvrender_set_gradient_vals(job,DEFAULT_COLOR,late_int(sg,G_gradientangle,0,0), frac);
+		    gvrender_set_gradient_vals(job,DEFAULT_COLOR,late_int(sg,lctx->G_gradientangle,0,0), frac);
 		if (istyle & RADIAL)
 		    filled = RGRADIENT;
 	 	else
@@ -3647,13 +3660,13 @@ void emit_clusters(GVJ_t * job, Agraph_t * g, int flags)
         	gvrender_set_fillcolor(job, fillcolor);
 	}
 
-	if (G_penwidth && ((s=ag_xget(sg,G_penwidth)) && s[0])) {
-	    penwidth = late_double(sg, G_penwidth, 1.0, 0.0);
+	if (lctx->G_penwidth && ((s=ag_xget(sg,lctx->G_penwidth)) && s[0])) {
+	    penwidth = late_double(sg, lctx->G_penwidth, 1.0, 0.0);
             gvrender_set_penwidth(job, penwidth);
 	}
 
 	if (istyle & ROUNDED) {
-	    if ((doPerim = late_int(sg, G_peripheries, 1, 0)) || filled) {
+	    if ((doPerim = late_int(sg, lctx->G_peripheries, 1, 0)) || filled) {
 		AF[0] = GD_bb(sg).LL;
 		AF[2] = GD_bb(sg).UR;
 		AF[1].x = AF[2].x;
@@ -3675,7 +3688,7 @@ void emit_clusters(GVJ_t * job, Agraph_t * g, int flags)
 	    AF[1].y = AF[0].y;
 	    AF[3].x = AF[0].x;
 	    AF[3].y = AF[2].y;
-	    if (late_int(sg, G_peripheries, 1, 0) == 0)
+	    if (late_int(sg, lctx->G_peripheries, 1, 0) == 0)
         	gvrender_set_pencolor(job, "transparent");
 	    else
     		gvrender_set_pencolor(job, pencolor);
@@ -3685,7 +3698,7 @@ void emit_clusters(GVJ_t * job, Agraph_t * g, int flags)
 	    gvrender_box(job, GD_bb(sg), 0);
 	}
 	else {
-	    if (late_int(sg, G_peripheries, 1, 0)) {
+	    if (late_int(sg, lctx->G_peripheries, 1, 0)) {
     		gvrender_set_pencolor(job, pencolor);
 		gvrender_box(job, GD_bb(sg), filled);
 	    }
@@ -3785,12 +3798,12 @@ static token_t style_token(char **s) {
  */
 char **parse_style(char *s)
 {
-    static char *parse[FUNLIMIT];
+    static TLS char *parse[FUNLIMIT];
     size_t parse_offsets[sizeof(parse) / sizeof(parse[0])];
     size_t fun = 0;
     bool in_parens = false;
     char *p;
-    static agxbuf ps_xb;
+    static TLS agxbuf ps_xb;
 
     p = s;
     while (true) {
@@ -3955,16 +3968,49 @@ extern gvdevice_callbacks_t gvdevice_callbacks;
  * 
  * If set is non-zero, the "C" locale set;
  * if set is zero, the original locale is reset.
- * Calls to the function can nest.
+ * Calls to the function can nest. Only the calling thread's locale is
+ * changed where the platform allows it, so layouts in other threads are
+ * not disturbed.
  */
 void gv_fixLocale (int set)
 {
-    static char* save_locale;
-    static int cnt;
+    static TLS int cnt;
+#if defined(LC_NUMERIC_MASK)
+    static TLS locale_t save_locale, c_locale;
 
     if (set) {
 	cnt++;
 	if (cnt == 1) {
+	    locale_t base = duplocale(uselocale((locale_t)0));
+	    if (base != (locale_t)0) {
+		c_locale = newlocale(LC_NUMERIC_MASK, "C", base);
+		if (c_locale == (locale_t)0)
+		    freelocale(base);
+		else
+		    save_locale = uselocale(c_locale);
+	    }
+	}
+    }
+    else if (cnt > 0) {
+	cnt--;
+	if (cnt == 0 && c_locale != (locale_t)0) {
+	    uselocale(save_locale);
+	    freelocale(c_locale);
+	    c_locale = (locale_t)0;
+	}
+    }
+#else
+    static TLS char* save_locale;
+#ifdef _WIN32
+    static TLS int save_config;
+#endif
+
+    if (set) {
+	cnt++;
+	if (cnt == 1) {
+#ifdef _WIN32
+	    save_config = _configthreadlocale(_ENABLE_PER_THREAD_LOCALE);
+#endif
 	    save_locale = gv_strdup(setlocale (LC_NUMERIC, NULL));
 	    setlocale (LC_NUMERIC, "C");
 	}
@@ -3974,8 +4020,12 @@ void gv_fixLocale (int set)
 	if (cnt == 0) {
 	    setlocale (LC_NUMERIC, save_locale);
 	    free (save_locale);
+#ifdef _WIN32
+	    _configthreadlocale(save_config);
+#endif
 	}
     }
+#endif
 }
 
 
@@ -3983,9 +4033,10 @@ void gv_fixLocale (int set)
 
 int gvRenderJobs (GVC_t * gvc, graph_t * g)
 {
-    static GVJ_t *prevjob;
+    static TLS GVJ_t *prevjob;
     GVJ_t *job, *firstjob;
 
+    gvSetLayoutContext(gvc->layout_context);
     if (Verbose)
 	start_timer();
     
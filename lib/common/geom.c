@@ -13,6 +13,7 @@
 
 #include "config.h"
 
+#include <cgraph/tls.h>
 #include <common/geom.h>
 #include <common/geomprocs.h>
 
@@ -158,8 +159,8 @@ void rect2poly(pointf *p)
 
 static pointf rotatepf(pointf p, int cwrot)
 {
-    static double sina, cosa;
-    static int last_cwrot;
+    static TLS double sina, cosa;
+    static TLS int last_cwrot;
     pointf P;
 
     /* cosa is initially wrong for a cwrot of 0
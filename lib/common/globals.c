@@ -11,6 +11,7 @@
 #include "config.h"
 
 #define EXTERN
+#include <cgraph/tls.h>
 #include <common/types.h>
 #include <common/globals.h>
 #include <fdpgen/fdp.h>
@@ -28,3 +29,19 @@ static fdpParms_t fdpParms = {
 };
 
 struct fdpParms_s* fdp_parms = &fdpParms;
+
+/* the layout context of threads that have not chosen one */
+static TLS layout_context_t thread_context;
+static TLS layout_context_t *current_context;
+
+layout_context_t *gvLayoutContext(void)
+{
+    return current_context ? current_context : &thread_context;
+}
+
+layout_context_t *gvSetLayoutContext(layout_context_t *ctx)
+{
+    layout_context_t *prev = gvLayoutContext();
+    current_context = ctx;
+    return prev;
+}
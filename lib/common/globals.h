@@ -39,35 +39,44 @@ DEFINE_LIST_WITH_DTOR(show_boxes, char*, free)
     GLOBALS_API EXTERN char **Files;	/* from command line */
     GLOBALS_API EXTERN const char **Lib;		/* from command line */
     GLOBALS_API EXTERN char *CmdName;
-    GLOBALS_API EXTERN char *Gvimagepath; /* Per-graph path of files allowed in image attributes  (also ps libs) */
 
     GLOBALS_API EXTERN unsigned char Verbose;
     GLOBALS_API EXTERN unsigned char Reduce;
     GLOBALS_API EXTERN int MemTest;
     GLOBALS_API EXTERN char *HTTPServerEnVar;
     GLOBALS_API EXTERN int graphviz_errors;
-    GLOBALS_API EXTERN int Nop;
-    GLOBALS_API EXTERN double PSinputscale;
     GLOBALS_API EXTERN show_boxes_t Show_boxes; // emit code for correct box coordinates
-    GLOBALS_API EXTERN int CL_type;		/* NONE, LOCAL, GLOBAL */
-    GLOBALS_API EXTERN unsigned char Concentrate;	/* if parallel edges should be merged */
-    GLOBALS_API EXTERN double Epsilon;	/* defined in input_graph */
-    GLOBALS_API EXTERN int MaxIter;
-    GLOBALS_API EXTERN int Ndim;
-    GLOBALS_API EXTERN int State;		/* last finished phase */
-    GLOBALS_API EXTERN int EdgeLabelsDone;	/* true if edge labels have been positioned */
-    GLOBALS_API EXTERN double Initial_dist;
-    GLOBALS_API EXTERN double Damping;
     GLOBALS_API EXTERN int Y_invert;	/* invert y in dot & plain output */
     GLOBALS_API EXTERN int GvExitOnUsage;   /* gvParseArgs() should exit on usage or error */
 
-    GLOBALS_API EXTERN Agsym_t
+/* State of a layout in progress, set up by graph_init and read by the layout
+ * engines and renderers. Each GVC_t owns one, so graphs can be laid out in
+ * several threads at once, each with its own GVC_t. Functions using it fetch
+ * the calling thread's current context once, with gvLayoutContext.
+ */
+typedef struct layout_context_s {
+    char *Gvimagepath; /* Per-graph path of files allowed in image attributes  (also ps libs) */
+    int Nop;
+    double PSinputscale;
+    int CL_type;		/* NONE, LOCAL, GLOBAL */
+    unsigned char Concentrate;	/* if parallel edges should be merged */
+    double Epsilon;	/* defined in input_graph */
+    int MaxIter;
+    int Ndim;
+    int State;		/* last finished phase */
+    int EdgeLabelsDone;	/* true if edge labels have been positioned */
+    double Initial_dist;
+    double Damping;
+    double PhaseDeadline;	/* wall_clock() time the running phase stops at, or 0 */
+    bool PhaseTruncated;	/* the running phase stopped at PhaseDeadline */
+
+    Agsym_t
 	*G_activepencolor, *G_activefillcolor,
 	*G_visitedpencolor, *G_visitedfillcolor,
 	*G_deletedpencolor, *G_deletedfillcolor,
 	*G_ordering, *G_peripheries, *G_penwidth,
 	*G_gradientangle, *G_margin;
-    GLOBALS_API EXTERN Agsym_t
+    Agsym_t
 	*N_height, *N_width, *N_shape, *N_color, *N_fillcolor,
 	*N_activepencolor, *N_activefillcolor,
 	*N_selectedpencolor, *N_selectedfillcolor,
@@ -79,7 +88,7 @@ DEFINE_LIST_WITH_DTOR(show_boxes, char*, free)
 	*N_skew, *N_distortion, *N_fixed, *N_imagescale, *N_imagepos, *N_layer,
 	*N_group, *N_comment, *N_vertices, *N_z,
 	*N_penwidth, *N_gradientangle;
-    GLOBALS_API EXTERN Agsym_t
+    Agsym_t
 	*E_weight, *E_minlen, *E_color, *E_fillcolor,
 	*E_activepencolor, *E_activefillcolor,
 	*E_selectedpencolor, *E_selectedfillcolor,
@@ -96,6 +105,14 @@ DEFINE_LIST_WITH_DTOR(show_boxes, char*, free)
 	*E_labeldistance, *E_labelangle,
 	*E_tailclip, *E_headclip,
 	*E_penwidth;
+} layout_context_t;
+
+/// the calling thread's current layout context
+    GLOBALS_API layout_context_t *gvLayoutContext(void);
+
+/// make `ctx` the calling thread's current layout context, returning the
+/// previous one; NULL selects a context private to the thread
+    GLOBALS_API layout_context_t *gvSetLayoutContext(layout_context_t *ctx);
 
     GLOBALS_API extern struct fdpParms_s* fdp_parms;
 
@@ -18,6 +18,7 @@
 #include <cgraph/alloc.h>
 #include <cgraph/strcasecmp.h>
 #include <cgraph/strview.h>
+#include <cgraph/tls.h>
 #include <cgraph/tokenize.h>
 #include <cgraph/unused.h>
 #include <limits.h>
@@ -44,6 +45,7 @@ typedef struct {
 #endif
     char* ptr;         // input source
     int tok;           // token type
+    HTMLSTYPE *lval;   // semantic value of the token
     agxbuf* xb;        // buffer to gather T_string data
     agxbuf lb;         // buffer for translating lexical data
     int warn;          // set if warning given
@@ -55,7 +57,7 @@ typedef struct {
     size_t currtoklen;
     size_t prevtoklen;
 } lexstate_t;
-static lexstate_t state;
+static TLS lexstate_t state;
 
 /* error_context:
  * Print the last 2 "token"s seen.
@@ -574,8 +576,8 @@ doAttrs(void *tp, attr_item * items, int nel, char **atts, char *s)
 
 static void mkBR(char **atts)
 {
-    htmllval.i = UNSET_ALIGN;
-    doAttrs(&htmllval.i, br_items, sizeof(br_items) / ISIZE, atts, "<BR>");
+    state.lval->i = UNSET_ALIGN;
+    doAttrs(&state.lval->i, br_items, sizeof(br_items) / ISIZE, atts, "<BR>");
 }
 
 static htmlimg_t *mkImg(char **atts)
@@ -627,7 +629,7 @@ static void startElement(void *user, const char *name, char **atts)
     GVC_t *gvc = user;
 
     if (strcasecmp(name, "TABLE") == 0) {
-	htmllval.tbl = mkTbl(atts);
+	state.lval->tbl = mkTbl(atts);
 	state.inCell = 0;
 	state.tok = T_table;
     } else if (strcasecmp(name, "TR") == 0 || strcasecmp(name, "TH") == 0) {
@@ -635,31 +637,31 @@ static void startElement(void *user, const char *name, char **atts)
 	state.tok = T_row;
     } else if (strcasecmp(name, "TD") == 0) {
 	state.inCell = 1;
-	htmllval.cell = mkCell(atts);
+	state.lval->cell = mkCell(atts);
 	state.tok = T_cell;
     } else if (strcasecmp(name, "FONT") == 0) {
-	htmllval.font = mkFont(gvc, atts, 0);
+	state.lval->font = mkFont(gvc, atts, 0);
 	state.tok = T_font;
     } else if (strcasecmp(name, "B") == 0) {
-	htmllval.font = mkFont(gvc, 0, HTML_BF);
+	state.lval->font = mkFont(gvc, 0, HTML_BF);
 	state.tok = T_bold;
     } else if (strcasecmp(name, "S") == 0) {
-	htmllval.font = mkFont(gvc, 0, HTML_S);
+	state.lval->font = mkFont(gvc, 0, HTML_S);
 	state.tok = T_s;
     } else if (strcasecmp(name, "U") == 0) {
-	htmllval.font = mkFont(gvc, 0, HTML_UL);
+	state.lval->font = mkFont(gvc, 0, HTML_UL);
 	state.tok = T_underline;
     } else if (strcasecmp(name, "O") == 0) {
-	htmllval.font = mkFont(gvc, 0, HTML_OL);
+	state.lval->font = mkFont(gvc, 0, HTML_OL);
 	state.tok = T_overline;
     } else if (strcasecmp(name, "I") == 0) {
-	htmllval.font = mkFont(gvc, 0, HTML_IF);
+	state.lval->font = mkFont(gvc, 0, HTML_IF);
 	state.tok = T_italic;
     } else if (strcasecmp(name, "SUP") == 0) {
-	htmllval.font = mkFont(gvc, 0, HTML_SUP);
+	state.lval->font = mkFont(gvc, 0, HTML_SUP);
 	state.tok = T_sup;
     } else if (strcasecmp(name, "SUB") == 0) {
-	htmllval.font = mkFont(gvc, 0, HTML_SUB);
+	state.lval->font = mkFont(gvc, 0, HTML_SUB);
 	state.tok = T_sub;
     } else if (strcasecmp(name, "BR") == 0) {
 	mkBR(atts);
@@ -669,7 +671,7 @@ static void startElement(void *user, const char *name, char **atts)
     } else if (strcasecmp(name, "VR") == 0) {
 	state.tok = T_vr;
     } else if (strcasecmp(name, "IMG") == 0) {
-	htmllval.img = mkImg(atts);
+	state.lval->img = mkImg(atts);
 	state.tok = T_img;
     } else if (strcasecmp(name, "HTML") == 0) {
 	state.tok = T_html;
@@ -1059,7 +1061,7 @@ static void printTok(int tok)
 
 #endif
 
-int htmllex()
+int htmllex(HTMLSTYPE *lval)
 {
 #ifdef HAVE_EXPAT
     static char *begin_html = "<HTML>";
@@ -1071,6 +1073,7 @@ int htmllex()
     int rv;
 
     state.tok = 0;
+    state.lval = lval;
     do {
 	if (state.mode == 2)
 	    return EOF;
@@ -1122,6 +1125,7 @@ int htmllex()
 #endif
     return state.tok;
 #else
+    (void)lval;
     return EOF;
 #endif
 }
@@ -17,7 +17,8 @@ extern "C" {
 #include <agxbuf.h>
 
     extern int initHTMLlexer(char *, agxbuf *, htmlenv_t *);
-    extern int htmllex(void);
+    union HTMLSTYPE;
+    extern int htmllex(union HTMLSTYPE *);
     extern int htmllineno(void);
     extern int clearHTMLlexer(void);
     void htmlerror(const char *);
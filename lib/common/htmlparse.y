@@ -16,9 +16,15 @@
    */
 %define api.prefix {html}
 
+  /* Labels may be parsed in several threads at once, so keep no parser state
+   * in globals.
+   */
+%define api.pure full
+
 %{
 
 #include <cgraph/alloc.h>
+#include <cgraph/tls.h>
 #include <common/render.h>
 #include <common/htmltable.h>
 #include <common/htmllex.h>
@@ -30,7 +36,7 @@ typedef struct sfont_t {
     struct sfont_t *pfont;
 } sfont_t;
 
-static struct {
+static TLS struct {
   htmllabel_t* lbl;       /* Generated label */
   htmltbl_t*   tblstack;  /* Stack of tables maintained during parsing */
   Dt_t*        fitemList; /* Dictionary for font text items */
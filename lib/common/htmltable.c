@@ -40,6 +40,7 @@
 #include <cgraph/exit.h>
 #include <cgraph/prisize_t.h>
 #include <cgraph/strcasecmp.h>
+#include <cgraph/tls.h>
 #include <cgraph/unreachable.h>
 #include <float.h>
 #include <inttypes.h>
@@ -383,7 +384,7 @@ initAnchor(GVJ_t * job, htmlenv_t * env, htmldata_t * data, boxf b,
     obj_state_t *obj = job->obj;
     int changed;
     char *id;
-    static int anchorId;
+    static TLS int anchorId;
     agxbuf xb = {0};
 
     save->url = obj->url;
@@ -524,7 +525,7 @@ static void emit_html_tbl(GVJ_t * job, htmltbl_t * tbl, htmlenv_t * env)
     pointf pos = env->pos;
     htmlcell_t **cells = tbl->u.n.cells;
     htmlcell_t *cp;
-    static textfont_t savef;
+    static TLS textfont_t savef;
     htmlmap_data_t saved;
     int anchor;			/* if true, we need to undo anchor settings. */
     int doAnchor = (tbl->data.href || tbl->data.target);
@@ -1772,7 +1773,7 @@ size_html_tbl(graph_t * g, htmltbl_t * tbl, htmlcell_t * parent,
 	      htmlenv_t * env)
 {
     int rv = 0;
-    static textfont_t savef;
+    static TLS textfont_t savef;
 
     if (tbl->font)
 	pushFontInfo(env, tbl->font, &savef);
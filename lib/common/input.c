@@ -24,7 +24,7 @@
 #include <string.h>
 
 static char *usageFmt =
-    "Usage: %s [-Vv?] [-(GNE)name=val] [-(KTlso)<val>] <dot files>\n";
+    "Usage: %s [-Vv?] [--arena] [-(GNE)name=val] [-(KTlso)<val>] <dot files>\n";
 
 static char *genericItems = "\n\
  -V          - Print version and exit\n\
@@ -40,7 +40,8 @@ static char *genericItems = "\n\
  -P          - Internally generate a graph of the current plugins. \n\
  -q[l]       - Set level of message suppression (=1)\n\
  -s[v]       - Scale input by 'v' (=72)\n\
- -y          - Invert y coordinate in output\n";
+ -y          - Invert y coordinate in output\n\
+ --arena     - Allocate each input graph from its own arena\n";
 
 static char *neatoFlags =
     "(additional options for neato)    [-x] [-n<v>]\n";
@@ -228,6 +229,7 @@ graph_t *gvPluginsGraph(GVC_t *gvc)
  */
 int dotneato_args_initialize(GVC_t * gvc, int argc, char **argv)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     char c, *rest, *layout;
     const char *val;
     int i, v, nfiles;
@@ -280,6 +282,8 @@ int dotneato_args_initialize(GVC_t * gvc, int argc, char **argv)
 	} else if (argv[i] &&
 	    (startswith(argv[i], "-?") || strcmp(argv[i], "--help") == 0)) {
 	    return dotneato_usage(0);
+	} else if (argv[i] && strcmp(argv[i], "--arena") == 0) {
+	    gvc->common.arena = true;
 	} else if (argv[i] && argv[i][0] == '-') {
 	    rest = &argv[i][2];
 	    switch (c = argv[i][1]) {
@@ -393,17 +397,17 @@ int dotneato_args_initialize(GVC_t * gvc, int argc, char **argv)
 		break;
 	    case 's':
 		if (*rest) {
-		    PSinputscale = atof(rest);
-		    if (PSinputscale < 0) {
+		    lctx->PSinputscale = atof(rest);
+		    if (lctx->PSinputscale < 0) {
 			fprintf(stderr,
 				"Invalid parameter \"%s\" for -s flag\n",
 				rest);
 			return (dotneato_usage(1));
 		    }
-		    else if (PSinputscale == 0)
-			PSinputscale = POINTS_PER_INCH;
+		    else if (lctx->PSinputscale == 0)
+			lctx->PSinputscale = POINTS_PER_INCH;
 		} else
-		    PSinputscale = POINTS_PER_INCH;
+		    lctx->PSinputscale = POINTS_PER_INCH;
 		break;
 	    case 'x':
 		Reduce = TRUE;
@@ -516,36 +520,45 @@ graph_t *gvNextInputGraph(GVC_t *gvc)
     graph_t *g = NULL;
     static char *fn;
     static FILE *fp;
-    static FILE *oldfp;
+    static Agmapped_t *mp;
+    static void *oldin;
     static int fidx, gidx;
 
     while (!g) {
-	if (!fp) {
+	if (!fp && !mp) {
     	    if (!(fn = gvc->input_filenames[0])) {
 		if (fidx++ == 0)
 		    fp = stdin;
 	    }
 	    else {
-		while ((fn = gvc->input_filenames[fidx++]) && !(fp = fopen(fn, "r")))  {
+		/* regular files are read from a memory mapping,
+		 * anything else through stdio */
+		while ((fn = gvc->input_filenames[fidx++]) && !(mp = agmapopen(fn))
+		       && !(fp = fopen(fn, "r")))  {
 		    agerr(AGERR, "%s: can't open %s: %s\n", gvc->common.cmdname, fn, strerror(errno));
 		    graphviz_errors++;
 		}
 	    }
 	}
-	if (fp == NULL)
+	if (fp == NULL && mp == NULL)
 	    break;
-	if (oldfp != fp) {
+	void *in = mp ? (void *)mp : (void *)fp;
+	if (oldin != in) {
 	    agsetfile(fn ? fn : "<stdin>");
-	    oldfp = fp;
+	    oldin = in;
 	}
-	g = agread(fp,NULL);
+	Agdisc_t *disc = gvc->common.arena ? &AgArenaDisc : NULL;
+	g = mp ? agmapread(mp, disc) : agread(fp, disc);
 	if (g) {
 	    gvg_init(gvc, g, fn, gidx++);
 	    break;
 	}
-	if (fp != stdin)
+	if (mp)
+	    agmapclose(mp);
+	else if (fp != stdin)
 	    fclose (fp);
-	oldfp = fp = NULL;
+	mp = NULL;
+	oldin = fp = NULL;
 	gidx = 0;
     }
     return g;
@@ -626,6 +639,7 @@ static void setRatio(graph_t * g)
 */
 void graph_init(graph_t * g, bool use_rankdir)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     char *p;
     double xf;
     static char *rankname[] = { "local", "global", "none", NULL };
@@ -662,7 +676,7 @@ void graph_init(graph_t * g, bool use_rankdir)
     GD_charset(g) = findCharset (g);
 
     if (!HTTPServerEnVar) {
-	Gvimagepath = agget (g, "imagepath");
+	lctx->Gvimagepath = agget (g, "imagepath");
     }
 
     GD_drawing(g)->quantum =
@@ -725,11 +739,11 @@ void graph_init(graph_t * g, bool use_rankdir)
 	GD_drawing(g)->landscape = mapbool(p);
 
     p = agget(g, "clusterrank");
-    CL_type = maptoken(p, rankname, rankcode);
+    lctx->CL_type = maptoken(p, rankname, rankcode);
     p = agget(g, "concentrate");
-    Concentrate = mapbool(p) ? TRUE : FALSE;
-    State = GVBEGIN;
-    EdgeLabelsDone = 0;
+    lctx->Concentrate = mapbool(p) ? TRUE : FALSE;
+    lctx->State = GVBEGIN;
+    lctx->EdgeLabelsDone = 0;
 
     GD_drawing(g)->dpi = 0.0;
     if (((p = agget(g, "dpi")) && p[0])
@@ -738,78 +752,78 @@ void graph_init(graph_t * g, bool use_rankdir)
 
     do_graph_label(g);
 
-    Initial_dist = MYHUGE;
+    lctx->Initial_dist = MYHUGE;
 
-    G_ordering = agfindgraphattr(g, "ordering");
-    G_gradientangle = agfindgraphattr(g,"gradientangle");
-    G_margin = agfindgraphattr(g, "margin");
+    lctx->G_ordering = agfindgraphattr(g, "ordering");
+    lctx->G_gradientangle = agfindgraphattr(g,"gradientangle");
+    lctx->G_margin = agfindgraphattr(g, "margin");
 
     /* initialize nodes */
-    N_height = agfindnodeattr(g, "height");
-    N_width = agfindnodeattr(g, "width");
-    N_shape = agfindnodeattr(g, "shape");
-    N_color = agfindnodeattr(g, "color");
-    N_fillcolor = agfindnodeattr(g, "fillcolor");
-    N_style = agfindnodeattr(g, "style");
-    N_fontsize = agfindnodeattr(g, "fontsize");
-    N_fontname = agfindnodeattr(g, "fontname");
-    N_fontcolor = agfindnodeattr(g, "fontcolor");
-    N_label = agfindnodeattr(g, "label");
-    if (!N_label)
-	N_label = agattr(g, AGNODE, "label", NODENAME_ESC);
-    N_xlabel = agfindnodeattr(g, "xlabel");
-    N_showboxes = agfindnodeattr(g, "showboxes");
-    N_penwidth = agfindnodeattr(g, "penwidth");
-    N_ordering = agfindnodeattr(g, "ordering");
-    N_margin = agfindnodeattr(g, "margin");
+    lctx->N_height = agfindnodeattr(g, "height");
+    lctx->N_width = agfindnodeattr(g, "width");
+    lctx->N_shape = agfindnodeattr(g, "shape");
+    lctx->N_color = agfindnodeattr(g, "color");
+    lctx->N_fillcolor = agfindnodeattr(g, "fillcolor");
+    lctx->N_style = agfindnodeattr(g, "style");
+    lctx->N_fontsize = agfindnodeattr(g, "fontsize");
+    lctx->N_fontname = agfindnodeattr(g, "fontname");
+    lctx->N_fontcolor = agfindnodeattr(g, "fontcolor");
+    lctx->N_label = agfindnodeattr(g, "label");
+    if (!lctx->N_label)
+	lctx->N_label = agattr(g, AGNODE, "label", NODENAME_ESC);
+    lctx->N_xlabel = agfindnodeattr(g, "xlabel");
+    lctx->N_showboxes = agfindnodeattr(g, "showboxes");
+    lctx->N_penwidth = agfindnodeattr(g, "penwidth");
+    lctx->N_ordering = agfindnodeattr(g, "ordering");
+    lctx->N_margin = agfindnodeattr(g, "margin");
     /* attribs for polygon shapes */
-    N_sides = agfindnodeattr(g, "sides");
-    N_peripheries = agfindnodeattr(g, "peripheries");
-    N_skew = agfindnodeattr(g, "skew");
-    N_orientation = agfindnodeattr(g, "orientation");
-    N_distortion = agfindnodeattr(g, "distortion");
-    N_fixed = agfindnodeattr(g, "fixedsize");
-    N_imagescale = agfindnodeattr(g, "imagescale");
-    N_imagepos = agfindnodeattr(g, "imagepos");
-    N_nojustify = agfindnodeattr(g, "nojustify");
-    N_layer = agfindnodeattr(g, "layer");
-    N_group = agfindnodeattr(g, "group");
-    N_comment = agfindnodeattr(g, "comment");
-    N_vertices = agfindnodeattr(g, "vertices");
-    N_z = agfindnodeattr(g, "z");
-    N_gradientangle = agfindnodeattr(g,"gradientangle");
+    lctx->N_sides = agfindnodeattr(g, "sides");
+    lctx->N_peripheries = agfindnodeattr(g, "peripheries");
+    lctx->N_skew = agfindnodeattr(g, "skew");
+    lctx->N_orientation = agfindnodeattr(g, "orientation");
+    lctx->N_distortion = agfindnodeattr(g, "distortion");
+    lctx->N_fixed = agfindnodeattr(g, "fixedsize");
+    lctx->N_imagescale = agfindnodeattr(g, "imagescale");
+    lctx->N_imagepos = agfindnodeattr(g, "imagepos");
+    lctx->N_nojustify = agfindnodeattr(g, "nojustify");
+    lctx->N_layer = agfindnodeattr(g, "layer");
+    lctx->N_group = agfindnodeattr(g, "group");
+    lctx->N_comment = agfindnodeattr(g, "comment");
+    lctx->N_vertices = agfindnodeattr(g, "vertices");
+    lctx->N_z = agfindnodeattr(g, "z");
+    lctx->N_gradientangle = agfindnodeattr(g,"gradientangle");
 
     /* initialize edges */
-    E_weight = agfindedgeattr(g, "weight");
-    E_color = agfindedgeattr(g, "color");
-    E_fillcolor = agfindedgeattr(g, "fillcolor");
-    E_fontsize = agfindedgeattr(g, "fontsize");
-    E_fontname = agfindedgeattr(g, "fontname");
-    E_fontcolor = agfindedgeattr(g, "fontcolor");
-    E_label = agfindedgeattr(g, "label");
-    E_xlabel = agfindedgeattr(g, "xlabel");
-    E_label_float = agfindedgeattr(g, "labelfloat");
-    E_dir = agfindedgeattr(g, "dir");
-    E_arrowhead = agfindedgeattr(g, "arrowhead");
-    E_arrowtail = agfindedgeattr(g, "arrowtail");
-    E_headlabel = agfindedgeattr(g, "headlabel");
-    E_taillabel = agfindedgeattr(g, "taillabel");
-    E_labelfontsize = agfindedgeattr(g, "labelfontsize");
-    E_labelfontname = agfindedgeattr(g, "labelfontname");
-    E_labelfontcolor = agfindedgeattr(g, "labelfontcolor");
-    E_labeldistance = agfindedgeattr(g, "labeldistance");
-    E_labelangle = agfindedgeattr(g, "labelangle");
-    E_minlen = agfindedgeattr(g, "minlen");
-    E_showboxes = agfindedgeattr(g, "showboxes");
-    E_style = agfindedgeattr(g, "style");
-    E_decorate = agfindedgeattr(g, "decorate");
-    E_arrowsz = agfindedgeattr(g, "arrowsize");
-    E_constr = agfindedgeattr(g, "constraint");
-    E_layer = agfindedgeattr(g, "layer");
-    E_comment = agfindedgeattr(g, "comment");
-    E_tailclip = agfindedgeattr(g, "tailclip");
-    E_headclip = agfindedgeattr(g, "headclip");
-    E_penwidth = agfindedgeattr(g, "penwidth");
+    lctx->E_weight = agfindedgeattr(g, "weight");
+    lctx->E_color = agfindedgeattr(g, "color");
+    lctx->E_fillcolor = agfindedgeattr(g, "fillcolor");
+    lctx->E_fontsize = agfindedgeattr(g, "fontsize");
+    lctx->E_fontname = agfindedgeattr(g, "fontname");
+    lctx->E_fontcolor = agfindedgeattr(g, "fontcolor");
+    lctx->E_label = agfindedgeattr(g, "label");
+    lctx->E_xlabel = agfindedgeattr(g, "xlabel");
+    lctx->E_label_float = agfindedgeattr(g, "labelfloat");
+    lctx->E_dir = agfindedgeattr(g, "dir");
+    lctx->E_arrowhead = agfindedgeattr(g, "arrowhead");
+    lctx->E_arrowtail = agfindedgeattr(g, "arrowtail");
+    lctx->E_headlabel = agfindedgeattr(g, "headlabel");
+    lctx->E_taillabel = agfindedgeattr(g, "taillabel");
+    lctx->E_labelfontsize = agfindedgeattr(g, "labelfontsize");
+    lctx->E_labelfontname = agfindedgeattr(g, "labelfontname");
+    lctx->E_labelfontcolor = agfindedgeattr(g, "labelfontcolor");
+    lctx->E_labeldistance = agfindedgeattr(g, "labeldistance");
+    lctx->E_labelangle = agfindedgeattr(g, "labelangle");
+    lctx->E_minlen = agfindedgeattr(g, "minlen");
+    lctx->E_showboxes = agfindedgeattr(g, "showboxes");
+    lctx->E_style = agfindedgeattr(g, "style");
+    lctx->E_decorate = agfindedgeattr(g, "decorate");
+    lctx->E_arrowsz = agfindedgeattr(g, "arrowsize");
+    lctx->E_constr = agfindedgeattr(g, "constraint");
+    lctx->E_layer = agfindedgeattr(g, "layer");
+    lctx->E_comment = agfindedgeattr(g, "comment");
+    lctx->E_tailclip = agfindedgeattr(g, "tailclip");
+    lctx->E_headclip = agfindedgeattr(g, "headclip");
+    lctx->E_penwidth = agfindedgeattr(g, "penwidth");
 
     /* background */
     GD_drawing(g)->xdots = init_xdot (g);
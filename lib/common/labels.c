@@ -10,6 +10,7 @@
 
 #include <cgraph/agxbuf.h>
 #include <cgraph/alloc.h>
+#include <cgraph/tls.h>
 #include <common/render.h>
 #include <common/htmltable.h>
 #include <limits.h>
@@ -22,7 +23,7 @@ static void storeline(GVC_t *gvc, textlabel_t *lp, char *line,
                       char terminator) {
     pointf size;
     textspan_t *span;
-    static textfont_t tf;
+    static TLS textfont_t tf;
     size_t oldsz = lp->u.txt.nspans + 1;
 
     lp->u.txt.span = ZALLOC(oldsz + 1, lp->u.txt.span, textspan_t, oldsz);
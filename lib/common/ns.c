@@ -1,6 +1,7 @@
 /**
  * @file
- * @brief Network Simplex algorithm for ranking nodes of a DAG, @ref rank, @ref rank2
+ * @brief Network Simplex algorithm for ranking nodes of a DAG, @ref rank, @ref rank2,
+ * @ref rank_warm
  */
 
 /*************************************************************************
@@ -16,10 +17,14 @@
 #include <assert.h>
 #include <cgraph/alloc.h>
 #include <cgraph/prisize_t.h>
+#include <cgraph/tls.h>
+#include <common/ns_compact.h>
 #include <common/render.h>
+#include <common/workers.h>
 #include <limits.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdlib.h>
 
 static void dfs_cutval(node_t * v, edge_t * par);
 static int dfs_range_init(node_t * v, edge_t * par, int low);
@@ -34,14 +39,16 @@ static void check_cycles(graph_t * g);
 #define SEQ(a,b,c)		((a) <= (b) && (b) <= (c))
 #define TREE_EDGE(e)	(ED_tree_index(e) >= 0)
 
-static graph_t *G;
-static size_t N_nodes, N_edges;
-static int Maxrank;
-static size_t S_i;			/* search index for enter_edge */
-static int Search_size;
+static TLS graph_t *G;
+static TLS size_t N_nodes, N_edges;
+static TLS int Maxrank;
+static TLS size_t S_i;			/* search index for enter_edge */
+static TLS int Search_size;
 #define SEARCHSIZE 30
-static nlist_t Tree_node;
-static elist Tree_edge;
+/* graphs with at least this many nodes go to ns_compact */
+#define NS_COMPACT_MIN 2000
+static TLS nlist_t Tree_node;
+static TLS elist Tree_edge;
 
 static int add_tree_edge(edge_t * e)
 {
@@ -138,8 +145,14 @@ static void exchange_tree_edges(edge_t * e, edge_t * f)
     ND_tree_in(n).list[ND_tree_in(n).size] = NULL;
 }
 
+/* init_rank:
+ * Give each node the least rank its in-edges allow, visiting the nodes in
+ * topological order. With warm set, a node starts from its current ND_rank
+ * instead of 0, so the ranks of a previous solution are kept where they are
+ * feasible and the others are only raised as far as needed.
+ */
 static
-void init_rank(void)
+void init_rank(bool warm)
 {
     int i;
     nodequeue *Q;
@@ -155,7 +168,8 @@ void init_rank(void)
     }
 
     while ((v = dequeue(Q))) {
-	ND_rank(v) = 0;
+	if (!warm)
+	    ND_rank(v) = 0;
 	ctr++;
 	for (i = 0; (e = ND_in(v).list[i]); i++)
 	    ND_rank(v) = MAX(ND_rank(v), ND_rank(agtail(e)) + ED_minlen(e));
@@ -209,8 +223,8 @@ static edge_t *leave_edge(void)
     return rv;
 }
 
-static edge_t *Enter;
-static int Low, Lim, Slack;
+static TLS edge_t *Enter;
+static TLS int Low, Lim, Slack;
 
 static void dfs_enter_outedge(node_t * v)
 {
@@ -780,8 +794,12 @@ static void TB_balance(void)
     }
     for (ii = 0; ii < Tree_node.size; ii++) {
       n = Tree_node.list[ii];
-      if (ND_node_type(n) != NORMAL)
+      if (ND_node_type(n) != NORMAL) {
+        free_list(ND_tree_in(n));
+        free_list(ND_tree_out(n));
+        ND_mark(n) = FALSE;
         continue;
+      }
       inweight = outweight = 0;
       low = 0;
       high = Maxrank;
@@ -876,6 +894,27 @@ graphSize (graph_t * g, int* nn, int* ne)
     *ne = nedges;
 }
 
+/* use_compact:
+ * Whether to rank g with the solver of ns_compact.c rather than the one here.
+ * They give the same ranks, but that one is faster on large graphs.
+ */
+static bool use_compact(graph_t *g)
+{
+    int n = 0;
+    for (node_t *v = GD_nlist(g); v && n < NS_COMPACT_MIN; v = ND_next(v))
+	n++;
+    return n >= NS_COMPACT_MIN;
+}
+
+/* ns_threads:
+ * The number of threads ns_compact may use, from the threads attribute of g.
+ */
+static int ns_threads(graph_t *g)
+{
+    const size_t n = workers_threads(g);
+    return n > INT_MAX ? INT_MAX : (int)n;
+}
+
 /* rank:
  * Apply network simplex to rank the nodes in a graph.
  * Uses ED_minlen as the internode constraint: if a->b with minlen=ml,
@@ -888,8 +927,10 @@ graphSize (graph_t * g, int* nn, int* ne)
  * Returns 0 if successful; returns 1 if the graph was not connected;
  * returns 2 if something seriously wrong;
  */
-int rank2(graph_t * g, int balance, int maxiter, int search_size)
+static int ns_rank(graph_t * g, int balance, int maxiter, int search_size,
+		   bool warm)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     int iter = 0;
     char *ns = "network simplex: ";
     edge_t *e, *f;
@@ -897,21 +938,32 @@ int rank2(graph_t * g, int balance, int maxiter, int search_size)
 #ifdef DEBUG
     check_cycles(g);
 #endif
+    if (search_size < 0)
+	search_size = SEARCHSIZE;
+    const bool compact = use_compact(g);
+    const int threads = compact ? ns_threads(g) : 1;
     if (Verbose) {
 	int nn, ne;
 	graphSize (g, &nn, &ne);
-	fprintf(stderr, "%s %d nodes %d edges maxiter=%d balance=%d\n", ns,
-	    nn, ne, maxiter, balance);
+	fprintf(stderr, "%s %d nodes %d edges maxiter=%d balance=%d%s%s", ns,
+	    nn, ne, maxiter, balance, warm ? " warm start" : "",
+	    compact ? " compact" : "");
+	if (threads > 1)
+	    fprintf(stderr, " threads=%d", threads);
+	fputc('\n', stderr);
 	start_timer();
     }
+    if (compact) {
+	const int rc = ns_compact(g, balance, maxiter, search_size, warm,
+				  threads);
+	if (rc >= 0)
+	    return rc;
+    }
     bool feasible = init_graph(g);
     if (!feasible)
-	init_rank();
+	init_rank(warm);
 
-    if (search_size >= 0)
-	Search_size = search_size;
-    else
-	Search_size = SEARCHSIZE;
+    Search_size = search_size;
 
     {
 	int err = feasible_tree();
@@ -943,6 +995,10 @@ int rank2(graph_t * g, int balance, int maxiter, int search_size)
 	}
 	if (iter >= maxiter)
 	    break;
+	if (phase_expired()) {
+	    lctx->PhaseTruncated = true;
+	    break;
+	}
     }
     switch (balance) {
     case 1:
@@ -965,6 +1021,22 @@ int rank2(graph_t * g, int balance, int maxiter, int search_size)
     return 0;
 }
 
+int rank2(graph_t * g, int balance, int maxiter, int search_size)
+{
+    return ns_rank(g, balance, maxiter, search_size, false);
+}
+
+/* rank_warm:
+ * As rank2, but starting from the ranks already in ND_rank, e.g. those of a
+ * previous layout of a similar graph. Where they violate a constraint they
+ * are raised just enough to satisfy it, rather than all ranks being thrown
+ * away, so a start close to the optimum needs few pivots to reach it.
+ */
+int rank_warm(graph_t * g, int balance, int maxiter, int search_size)
+{
+    return ns_rank(g, balance, maxiter, search_size, true);
+}
+
 int rank(graph_t * g, int balance, int maxiter)
 {
     char *s;
@@ -1144,7 +1216,7 @@ void check_fast_node(node_t * n)
 
 static char* dump_node (node_t* n)
 {
-    static char buf[50];
+    static TLS char buf[50];
 
     if (ND_node_type(n)) {
 	snprintf(buf, sizeof(buf), "%p", n);
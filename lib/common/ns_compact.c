@@ -0,0 +1,1370 @@
+/*************************************************************************
+ * Copyright (c) 2011 AT&T Intellectual Property
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors: Details at https://graphviz.org
+ *************************************************************************/
+
+/* The network simplex of ns.c, over arrays.
+ *
+ * Nodes are numbered in GD_nlist order and edges in the order of the out-edge
+ * lists, so the out-edges of a node are a contiguous run of the edge array and
+ * its in-edges a run of an array of edge numbers. The tree edges at a node are
+ * kept in runs of the same length and place in two further arrays. Every
+ * search of the tree keeps an explicit stack in place of the recursion in
+ * ns.c, but visits nodes and edges in the same order, so that ties are broken
+ * the same way and the resulting ranks do not depend on which solver ran.
+ */
+
+#include <assert.h>
+#include <cgraph/alloc.h>
+#include <cgraph/tls.h>
+#include <common/ns_compact.h>
+#include <common/render.h>
+#include <common/workers.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+#define SEQ(a, b, c) ((a) <= (b) && (b) <= (c))
+
+typedef struct {
+  int rank;
+  int low, lim;
+  int par;      ///< parent tree edge, or -1
+  int priority; ///< unranked in-edges, for init_rank
+  int subtree;  ///< tight subtree, or -1, while finding the feasible tree
+  int out;      ///< first out-edge, and first tree out-edge in tree_out
+  int in;       ///< first in-edge in in_edges, and tree in-edge in tree_in
+  int n_out, n_in;
+  int n_tree_out, n_tree_in;
+  bool normal; ///< ND_node_type is NORMAL
+  bool mark;
+} nsnode_t;
+
+typedef struct {
+  int tail, head;
+  int minlen, weight;
+  int cutvalue;
+  int tree_index; ///< position in tree_edge, or -1
+} nsedge_t;
+
+/// a frame of an iterative tree search
+typedef struct {
+  int v;
+  int from; ///< node or edge the search came from, or -1
+  int k;    ///< next edge of `v` to look at
+} frame_t;
+
+/// a worker's part of a parallel search, and what it found there
+typedef struct {
+  size_t begin, end; ///< positions in the tree edge list, or items
+  int best;          ///< edge found, or -1
+  int value;         ///< its cut value or slack
+  int count;         ///< negative cut values seen
+  frame_t *stack;    ///< for searches of subtrees
+  size_t stack_size;
+} part_t;
+
+typedef struct {
+  graph_t *g;
+  node_t **gnodes;
+  edge_t **gedges;
+  nsnode_t *nodes;
+  nsedge_t *edges;
+  int n_nodes, n_edges;
+  int *in_edges;
+  int *tree_out, *tree_in;
+  int *tree_edge;
+  int n_tree_edges;
+  frame_t *stack; ///< room for a frame per node
+  size_t stack_size;
+  int s_i; ///< search index for enter_edge
+  int search_size;
+  int maxrank;
+  bool feasible; ///< no edge has negative slack
+  // state of enter_edge
+  int enter, low, lim, slack;
+  bool outsearch;
+  // parallel searches, if there is more than one worker
+  workers_t *workers;
+  part_t *parts;
+  int leave_start; ///< tree edge leave_edge started from
+  int *items;      ///< subtrees (>= 0) and edges (< 0) to search
+  size_t n_items, items_size;
+} ns_t;
+
+static int slack(const ns_t *ns, int e) {
+  const nsedge_t *f = &ns->edges[e];
+  return ns->nodes[f->head].rank - ns->nodes[f->tail].rank - f->minlen;
+}
+
+static bool tree_edge(const ns_t *ns, int e) {
+  return ns->edges[e].tree_index >= 0;
+}
+
+static int add_tree_edge(ns_t *ns, int e) {
+  nsedge_t *f = &ns->edges[e];
+  if (f->tree_index >= 0) {
+    agerr(AGERR, "add_tree_edge: missing tree edge\n");
+    return -1;
+  }
+  assert(ns->n_tree_edges < ns->n_nodes);
+  f->tree_index = ns->n_tree_edges;
+  ns->tree_edge[ns->n_tree_edges++] = e;
+  nsnode_t *n = &ns->nodes[f->tail];
+  n->mark = true;
+  if (n->n_tree_out == n->n_out) {
+    agerr(AGERR, "add_tree_edge: empty outedge list\n");
+    return -1;
+  }
+  ns->tree_out[n->out + n->n_tree_out++] = e;
+  n = &ns->nodes[f->head];
+  n->mark = true;
+  if (n->n_tree_in == n->n_in) {
+    agerr(AGERR, "add_tree_edge: empty inedge list\n");
+    return -1;
+  }
+  ns->tree_in[n->in + n->n_tree_in++] = e;
+  return 0;
+}
+
+/// as invalidate_path in ns.c
+static void invalidate_path(ns_t *ns, int lca, int to_node) {
+  nsnode_t *nodes = ns->nodes;
+  while (true) {
+    if (nodes[to_node].low == -1)
+      break;
+
+    nodes[to_node].low = -1;
+
+    const int e = nodes[to_node].par;
+    if (e == -1)
+      break;
+
+    if (nodes[to_node].lim >= nodes[lca].lim) {
+      if (to_node != lca)
+        agerr(AGERR, "invalidate_path: skipped over LCA\n");
+      break;
+    }
+
+    const nsedge_t *f = &ns->edges[e];
+    if (nodes[f->tail].lim > nodes[f->head].lim)
+      to_node = f->tail;
+    else
+      to_node = f->head;
+  }
+}
+
+/// remove `e` from a run of `*size` tree edges, moving the last into its place
+static void remove_tree_edge(int *list, int *size, int e) {
+  const int i = --*size;
+  int j;
+  for (j = 0; j <= i; j++)
+    if (list[j] == e)
+      break;
+  list[j] = list[i];
+}
+
+static void exchange_tree_edges(ns_t *ns, int e, int f) {
+  nsedge_t *ee = &ns->edges[e];
+  nsedge_t *ff = &ns->edges[f];
+
+  ff->tree_index = ee->tree_index;
+  ns->tree_edge[ee->tree_index] = f;
+  ee->tree_index = -1;
+
+  nsnode_t *n = &ns->nodes[ee->tail];
+  remove_tree_edge(&ns->tree_out[n->out], &n->n_tree_out, e);
+  n = &ns->nodes[ee->head];
+  remove_tree_edge(&ns->tree_in[n->in], &n->n_tree_in, e);
+
+  n = &ns->nodes[ff->tail];
+  ns->tree_out[n->out + n->n_tree_out++] = f;
+  n = &ns->nodes[ff->head];
+  ns->tree_in[n->in + n->n_tree_in++] = f;
+}
+
+/// as init_rank in ns.c
+static void init_rank(ns_t *ns, bool warm) {
+  nsnode_t *nodes = ns->nodes;
+  int *queue = gv_calloc((size_t)ns->n_nodes, sizeof(queue[0]));
+  int front = 0, back = 0;
+
+  for (int v = 0; v < ns->n_nodes; v++) {
+    if (nodes[v].priority == 0)
+      queue[back++] = v;
+  }
+
+  while (front < back) {
+    nsnode_t *v = &nodes[queue[front++]];
+    if (!warm)
+      v->rank = 0;
+    for (int i = 0; i < v->n_in; i++) {
+      const nsedge_t *e = &ns->edges[ns->in_edges[v->in + i]];
+      v->rank = MAX(v->rank, nodes[e->tail].rank + e->minlen);
+    }
+    for (int e = v->out; e < v->out + v->n_out; e++) {
+      const int w = ns->edges[e].head;
+      if (--nodes[w].priority <= 0) {
+        assert(back < ns->n_nodes);
+        queue[back++] = w;
+      }
+    }
+  }
+  if (front != ns->n_nodes) {
+    ns->feasible = false;
+    agerr(AGERR, "trouble in init_rank\n");
+    for (int v = 0; v < ns->n_nodes; v++)
+      if (nodes[v].priority)
+        agerr(AGPREV, "\t%s %d\n", agnameof(ns->gnodes[v]), nodes[v].priority);
+  }
+  free(queue);
+}
+
+/* Search for a leaving edge as in ns.c: look at the tree edges in turn,
+ * starting from where the last search stopped and wrapping around, until
+ * search_size of them with negative cut value have been seen, and take the
+ * first with the most negative value among those. With several workers, after
+ * a first stretch, the list is searched in rounds of one part per worker. Each
+ * part counts its negative cut values and finds the first most negative one,
+ * and the parts are then combined in order, so the edge found is the one a
+ * search in a single thread would find.
+ */
+enum {
+  LEAVE_SERIAL = 4096, ///< tree edges searched before using workers
+  LEAVE_PART = 4096,   ///< tree edges per part per round
+};
+
+/* Search positions [from, to) as leave_edge does, continuing from the edge rv
+ * found so far and the count cnt of negative cut values. Return true, with the
+ * position at which it happened in *stop, if the count reaches search_size.
+ */
+static bool leave_search(const ns_t *ns, int start, size_t from, size_t to,
+                         int *rv, int *cnt, size_t *stop) {
+  if (from >= to)
+    return false;
+  const size_t n = (size_t)ns->n_tree_edges;
+  size_t i = ((size_t)start + from) % n;
+  for (size_t t = from; t < to; t++) {
+    const int f = ns->tree_edge[i];
+    if (++i == n)
+      i = 0;
+    if (ns->edges[f].cutvalue < 0) {
+      if (*rv < 0 || ns->edges[*rv].cutvalue > ns->edges[f].cutvalue)
+        *rv = f;
+      if (++*cnt >= ns->search_size) {
+        *stop = t;
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+static void leave_part(void *arg, size_t index) {
+  const ns_t *ns = arg;
+  part_t *p = &ns->parts[index];
+  const size_t n = (size_t)ns->n_tree_edges;
+  p->best = -1;
+  p->count = 0;
+  if (p->begin >= p->end)
+    return;
+  size_t i = ((size_t)ns->leave_start + p->begin) % n;
+  for (size_t t = p->begin; t < p->end; t++) {
+    const int f = ns->tree_edge[i];
+    if (++i == n)
+      i = 0;
+    const int cutvalue = ns->edges[f].cutvalue;
+    if (cutvalue < 0) {
+      p->count++;
+      if (p->best < 0 || p->value > cutvalue) {
+        p->best = f;
+        p->value = cutvalue;
+      }
+    }
+  }
+}
+
+static int leave_edge(ns_t *ns) {
+  const size_t n = (size_t)ns->n_tree_edges;
+  const int j = ns->s_i;
+  const int start = (size_t)j == n ? 0 : j;
+  int rv = -1;
+  int cnt = 0;
+  size_t stop;
+
+  size_t t = ns->workers ? MIN(n, LEAVE_SERIAL) : n;
+  if (leave_search(ns, start, 0, t, &rv, &cnt, &stop)) {
+    ns->s_i = (int)(((size_t)start + stop) % n);
+    return rv;
+  }
+  while (t < n) {
+    const size_t parts = workers_size(ns->workers);
+    for (size_t i = 0; i < parts; i++) {
+      ns->parts[i].begin = MIN(n, t + i * LEAVE_PART);
+      ns->parts[i].end = MIN(n, t + (i + 1) * LEAVE_PART);
+    }
+    ns->leave_start = start;
+    workers_run(ns->workers, leave_part, ns);
+    for (size_t i = 0; i < parts; i++) {
+      const part_t *p = &ns->parts[i];
+      if (p->count == 0)
+        continue;
+      if (cnt + p->count < ns->search_size) {
+        if (rv < 0 || ns->edges[rv].cutvalue > p->value)
+          rv = p->best;
+        cnt += p->count;
+      } else {
+        const bool found = leave_search(ns, start, p->begin, p->end, &rv, &cnt,
+                                        &stop);
+        assert(found);
+        (void)found;
+        ns->s_i = (int)(((size_t)start + stop) % n);
+        return rv;
+      }
+    }
+    t = ns->parts[parts - 1].end;
+  }
+  ns->s_i = j > 0 ? j : (int)n;
+  return rv;
+}
+
+/// push a frame onto a stack that grows as needed
+static void push(frame_t **stack, size_t *size, int *top, frame_t fr) {
+  if ((size_t)(*top + 1) == *size) {
+    *stack = gv_recalloc(*stack, *size, *size * 2, sizeof(**stack));
+    *size *= 2;
+  }
+  (*stack)[++*top] = fr;
+}
+
+/* The search of dfs_enter_outedge (out set) or dfs_enter_inedge in ns.c,
+ * from v, taking as entering edge the first with the least slack among those
+ * leaving the subtree, and going on from the edge *best, of slack *value,
+ * found so far.
+ */
+static void enter_search(const ns_t *ns, int v, bool out, frame_t **stack,
+                         size_t *stack_size, int *best, int *value) {
+  const nsnode_t *nodes = ns->nodes;
+  int top = -1;
+  push(stack, stack_size, &top, (frame_t){.v = v});
+
+  while (top >= 0) {
+    frame_t *fr = &(*stack)[top];
+    const nsnode_t *n = &nodes[fr->v];
+    const int edges = out ? n->n_out : n->n_in;
+    const int tree_edges = out ? n->n_tree_in : n->n_tree_out;
+    if (fr->k < edges) {
+      const int e = out ? n->out + fr->k : ns->in_edges[n->in + fr->k];
+      fr->k++;
+      const int w = out ? ns->edges[e].head : ns->edges[e].tail;
+      if (!tree_edge(ns, e)) {
+        if (!SEQ(ns->low, nodes[w].lim, ns->lim)) {
+          const int s = slack(ns, e);
+          if (s < *value || *best < 0) {
+            *best = e;
+            *value = s;
+          }
+        }
+      } else if (nodes[w].lim < n->lim) {
+        push(stack, stack_size, &top, (frame_t){.v = w});
+      }
+    } else if (fr->k < edges + tree_edges && *value > 0) {
+      const int i = fr->k - edges;
+      fr->k++;
+      const int e = out ? ns->tree_in[n->in + i] : ns->tree_out[n->out + i];
+      const int w = out ? ns->edges[e].tail : ns->edges[e].head;
+      if (nodes[w].lim < n->lim)
+        push(stack, stack_size, &top, (frame_t){.v = w});
+    } else {
+      top--;
+    }
+  }
+}
+
+/* With several workers, the search for an entering edge below a large subtree
+ * is split into items: the non-tree edges leaving it from the nodes near its
+ * root, and the subtrees below those nodes, listed in the order the search
+ * would come to them. The workers take runs of items of about equal size,
+ * each finding the first edge of least slack in its run, and the first of
+ * least slack among those is the edge a search in a single thread would find.
+ *
+ * This relies on there being no negative slack, which a search in a single
+ * thread stops looking for in some subtrees once it has seen a slack of 0.
+ */
+enum {
+  ENTER_PARALLEL = 8192, ///< least subtree searched by the workers
+  ENTER_ITEM = 1024,     ///< least subtree split into items
+  ENTER_SPLITS = 64,     ///< most subtrees split into items, per worker
+};
+
+static size_t subtree_size(const ns_t *ns, int v) {
+  return (size_t)(ns->nodes[v].lim - ns->nodes[v].low + 1);
+}
+
+static void add_item(ns_t *ns, int item) {
+  if (ns->n_items == ns->items_size) {
+    const size_t size = ns->items_size ? ns->items_size * 2 : 1024;
+    ns->items = gv_recalloc(ns->items, ns->items_size, size,
+                            sizeof(ns->items[0]));
+    ns->items_size = size;
+  }
+  ns->items[ns->n_items++] = item;
+}
+
+/// list the items of the search below v, splitting subtrees larger than grain
+static void enter_items(ns_t *ns, int v, bool out, size_t grain) {
+  const nsnode_t *nodes = ns->nodes;
+  frame_t *stack = ns->stack;
+  size_t splits = ENTER_SPLITS * workers_size(ns->workers);
+  int top = 0;
+  stack[0] = (frame_t){.v = v};
+  ns->n_items = 0;
+
+  while (top >= 0) {
+    frame_t *fr = &stack[top];
+    const nsnode_t *n = &nodes[fr->v];
+    const int edges = out ? n->n_out : n->n_in;
+    const int tree_edges = out ? n->n_tree_in : n->n_tree_out;
+    if (fr->k >= edges + tree_edges) {
+      top--;
+      continue;
+    }
+    int e, w;
+    if (fr->k < edges) {
+      e = out ? n->out + fr->k : ns->in_edges[n->in + fr->k];
+      w = out ? ns->edges[e].head : ns->edges[e].tail;
+    } else {
+      const int i = fr->k - edges;
+      e = out ? ns->tree_in[n->in + i] : ns->tree_out[n->out + i];
+      w = out ? ns->edges[e].tail : ns->edges[e].head;
+    }
+    fr->k++;
+    if (!tree_edge(ns, e)) {
+      if (!SEQ(ns->low, nodes[w].lim, ns->lim))
+        add_item(ns, -1 - e);
+    } else if (nodes[w].lim < n->lim) {
+      if (splits > 0 && subtree_size(ns, w) > grain) {
+        splits--;
+        stack[++top] = (frame_t){.v = w};
+      } else {
+        add_item(ns, w);
+      }
+    }
+  }
+}
+
+static void enter_part(void *arg, size_t index) {
+  const ns_t *ns = arg;
+  part_t *p = &ns->parts[index];
+  p->best = -1;
+  p->value = INT_MAX;
+  for (size_t i = p->begin; i < p->end && p->value > 0; i++) {
+    const int item = ns->items[i];
+    if (item < 0) {
+      const int e = -1 - item;
+      const int s = slack(ns, e);
+      if (s < p->value || p->best < 0) {
+        p->best = e;
+        p->value = s;
+      }
+    } else {
+      enter_search(ns, item, ns->outsearch, &p->stack, &p->stack_size,
+                   &p->best, &p->value);
+    }
+  }
+}
+
+static void enter_parallel(ns_t *ns, int v) {
+  const size_t parts = workers_size(ns->workers);
+  const size_t size = subtree_size(ns, v);
+  enter_items(ns, v, ns->outsearch, MAX(size / (8 * parts), ENTER_ITEM));
+
+  /* give each worker a run of items of about equal total size */
+  size_t done = 0, i = 0;
+  for (size_t k = 0; k < parts; k++) {
+    ns->parts[k].begin = i;
+    for (; i < ns->n_items && done < size * (k + 1) / parts; i++)
+      done += ns->items[i] < 0 ? 1 : subtree_size(ns, ns->items[i]);
+    ns->parts[k].end = k + 1 == parts ? ns->n_items : i;
+  }
+  workers_run(ns->workers, enter_part, ns);
+
+  for (size_t k = 0; k < parts; k++) {
+    const part_t *p = &ns->parts[k];
+    if (p->best >= 0 && (p->value < ns->slack || ns->enter < 0)) {
+      ns->enter = p->best;
+      ns->slack = p->value;
+    }
+  }
+}
+
+static int enter_edge(ns_t *ns, int e) {
+  const nsedge_t *f = &ns->edges[e];
+  int v;
+
+  /* v is the down node */
+  if (ns->nodes[f->tail].lim < ns->nodes[f->head].lim) {
+    v = f->tail;
+    ns->outsearch = false;
+  } else {
+    v = f->head;
+    ns->outsearch = true;
+  }
+  ns->enter = -1;
+  ns->slack = INT_MAX;
+  ns->low = ns->nodes[v].low;
+  ns->lim = ns->nodes[v].lim;
+  if (ns->workers && ns->feasible && subtree_size(ns, v) >= ENTER_PARALLEL)
+    enter_parallel(ns, v);
+  else
+    enter_search(ns, v, ns->outsearch, &ns->stack, &ns->stack_size,
+                 &ns->enter, &ns->slack);
+  return ns->enter;
+}
+
+/// the `k`th tree edge at node `n`, out-edges first
+static int nth_tree_edge(const ns_t *ns, const nsnode_t *n, int k) {
+  if (k < n->n_tree_out)
+    return ns->tree_out[n->out + k];
+  return ns->tree_in[n->in + k - n->n_tree_out];
+}
+
+/// the end of edge `e` other than node `v`
+static int other_end(const ns_t *ns, int e, int v) {
+  const nsedge_t *f = &ns->edges[e];
+  return f->tail == v ? f->head : f->tail;
+}
+
+/* Set ND_par, ND_low and ND_lim over the part of the tree below v, entered
+ * through edge par, numbering it from low. With incremental set, this is
+ * dfs_range of ns.c and skips subtrees whose numbering is unchanged; otherwise
+ * it is dfs_range_init and numbers every node.
+ */
+static void dfs_range(ns_t *ns, int v, int par, int low, bool incremental) {
+  nsnode_t *nodes = ns->nodes;
+  frame_t *stack = ns->stack;
+
+  if (incremental && nodes[v].par == par && nodes[v].low == low)
+    return;
+
+  int lim = low;
+  int top = 0;
+  stack[0] = (frame_t){.v = v};
+  nodes[v].par = par;
+  nodes[v].low = low;
+
+  while (top >= 0) {
+    frame_t *fr = &stack[top];
+    nsnode_t *n = &nodes[fr->v];
+    if (fr->k < n->n_tree_out + n->n_tree_in) {
+      const int e = nth_tree_edge(ns, n, fr->k++);
+      if (e == n->par)
+        continue;
+      const int w = other_end(ns, e, fr->v);
+      if (incremental && nodes[w].par == e && nodes[w].low == lim) {
+        lim = nodes[w].lim + 1;
+        continue;
+      }
+      nodes[w].par = e;
+      nodes[w].low = lim;
+      stack[++top] = (frame_t){.v = w};
+    } else {
+      n->lim = lim++;
+      top--;
+    }
+  }
+}
+
+static int x_val(const ns_t *ns, int e, int v, int dir) {
+  const nsnode_t *nodes = ns->nodes;
+  const nsedge_t *f = &ns->edges[e];
+  const int other = f->tail == v ? f->head : f->tail;
+  int d, rv;
+  bool outside;
+
+  if (!SEQ(nodes[v].low, nodes[other].lim, nodes[v].lim)) {
+    outside = true;
+    rv = f->weight;
+  } else {
+    outside = false;
+    if (tree_edge(ns, e))
+      rv = f->cutvalue;
+    else
+      rv = 0;
+    rv -= f->weight;
+  }
+  if (dir > 0) {
+    if (f->head == v)
+      d = 1;
+    else
+      d = -1;
+  } else {
+    if (f->tail == v)
+      d = 1;
+    else
+      d = -1;
+  }
+  if (outside)
+    d = -d;
+  if (d < 0)
+    rv = -rv;
+  return rv;
+}
+
+/* set cut value of f, assuming values of edges on one side were already set */
+static void x_cutval(ns_t *ns, int f) {
+  nsedge_t *ff = &ns->edges[f];
+  int v, dir;
+
+  /* set v to the node on the side of the edge already searched */
+  if (ns->nodes[ff->tail].par == f) {
+    v = ff->tail;
+    dir = 1;
+  } else {
+    v = ff->head;
+    dir = -1;
+  }
+
+  const nsnode_t *n = &ns->nodes[v];
+  int sum = 0;
+  for (int e = n->out; e < n->out + n->n_out; e++)
+    sum += x_val(ns, e, v, dir);
+  for (int i = 0; i < n->n_in; i++)
+    sum += x_val(ns, ns->in_edges[n->in + i], v, dir);
+  ff->cutvalue = sum;
+}
+
+/// set the cut values of the tree edges below `v`, children before parents
+static void dfs_cutval(ns_t *ns, int v) {
+  frame_t *stack = ns->stack;
+  int top = 0;
+  stack[0] = (frame_t){.v = v, .from = -1};
+
+  while (top >= 0) {
+    frame_t *fr = &stack[top];
+    const nsnode_t *n = &ns->nodes[fr->v];
+    if (fr->k < n->n_tree_out + n->n_tree_in) {
+      const int e = nth_tree_edge(ns, n, fr->k++);
+      if (e != fr->from)
+        stack[++top] = (frame_t){.v = other_end(ns, e, fr->v), .from = e};
+    } else {
+      if (fr->from >= 0)
+        x_cutval(ns, fr->from);
+      top--;
+    }
+  }
+}
+
+static void init_cutvalues(ns_t *ns) {
+  dfs_range(ns, 0, -1, 1, false);
+  dfs_cutval(ns, 0);
+}
+
+typedef struct {
+  int rep;        ///< some node in the tree
+  int size;       ///< total tight tree size
+  int heap_index; ///< required to find non-min elts when merged
+  int par;        ///< union find
+} subtree_t;
+
+typedef struct {
+  int *elt;
+  int size;
+} STheap_t;
+
+/// find initial tight subtree `st`, containing node `v`; return its size
+static int tight_subtree_search(ns_t *ns, int v, int st) {
+  nsnode_t *nodes = ns->nodes;
+  frame_t *stack = ns->stack;
+  int top = 0;
+  int rv = 1;
+  stack[0] = (frame_t){.v = v};
+  nodes[v].subtree = st;
+
+  while (top >= 0) {
+    frame_t *fr = &stack[top];
+    const nsnode_t *n = &nodes[fr->v];
+    if (fr->k < n->n_in + n->n_out) {
+      const int k = fr->k++;
+      int e, w;
+      if (k < n->n_in) {
+        e = ns->in_edges[n->in + k];
+        w = ns->edges[e].tail;
+      } else {
+        e = n->out + k - n->n_in;
+        w = ns->edges[e].head;
+      }
+      if (tree_edge(ns, e))
+        continue;
+      if (nodes[w].subtree == -1 && slack(ns, e) == 0) {
+        if (add_tree_edge(ns, e) != 0)
+          return -1;
+        nodes[w].subtree = st;
+        rv++;
+        stack[++top] = (frame_t){.v = w};
+      }
+    } else {
+      top--;
+    }
+  }
+  return rv;
+}
+
+static int STsetFind(subtree_t *st, int s0) {
+  while (st[s0].par != s0) {
+    st[s0].par = st[st[s0].par].par; /* path compression for the code weary */
+    s0 = st[s0].par;
+  }
+  return s0;
+}
+
+static int STsetUnion(subtree_t *st, int s0, int s1) {
+  int r0, r1, r;
+
+  for (r0 = s0; st[r0].par != r0; r0 = st[r0].par)
+    ;
+  for (r1 = s1; st[r1].par != r1; r1 = st[r1].par)
+    ;
+  if (r0 == r1)
+    return r0; /* safety code but shouldn't happen */
+  assert(st[r0].heap_index > -1 || st[r1].heap_index > -1);
+  if (st[r1].heap_index == -1)
+    r = r0;
+  else if (st[r0].heap_index == -1)
+    r = r1;
+  else if (st[r1].size < st[r0].size)
+    r = r0;
+  else
+    r = r1;
+
+  st[r0].par = st[r1].par = r;
+  st[r].size = st[r0].size + st[r1].size;
+  assert(st[r].heap_index >= 0);
+  return r;
+}
+
+/* find tightest edge to another tree incident on the given tree */
+static int inter_tree_edge(ns_t *ns, subtree_t *st, int tree) {
+  const nsnode_t *nodes = ns->nodes;
+  frame_t *stack = ns->stack;
+  int best = -1;
+  int top = 0;
+  const int ts = STsetFind(st, nodes[st[tree].rep].subtree);
+  stack[0] = (frame_t){.v = st[tree].rep, .from = -1};
+
+  while (top >= 0) {
+    frame_t *fr = &stack[top];
+    const nsnode_t *n = &nodes[fr->v];
+    if (fr->k >= n->n_out + n->n_in) {
+      top--;
+      continue;
+    }
+    const int k = fr->k++;
+    const bool out = k < n->n_out;
+    const int e = out ? n->out + k : ns->in_edges[n->in + k - n->n_out];
+    const int w = out ? ns->edges[e].head : ns->edges[e].tail;
+    if (tree_edge(ns, e)) {
+      if (w == fr->from) // do not search back in tree
+        continue;
+      // search forward in tree, unless no better edge can be found
+      if (best < 0 || slack(ns, best) != 0)
+        stack[++top] = (frame_t){.v = w, .from = fr->v};
+    } else if (STsetFind(st, nodes[w].subtree) != ts) {
+      // encountered candidate edge
+      if (best < 0 || slack(ns, e) < slack(ns, best))
+        best = e;
+    }
+    /* else ignore non-tree edge between nodes in the same tree */
+  }
+  return best;
+}
+
+static void STheapify(subtree_t *st, STheap_t *heap, int i) {
+  int left, right, smallest;
+  int *elt = heap->elt;
+  do {
+    left = 2 * (i + 1) - 1;
+    right = 2 * (i + 1);
+    if (left < heap->size && st[elt[left]].size < st[elt[i]].size)
+      smallest = left;
+    else
+      smallest = i;
+    if (right < heap->size && st[elt[right]].size < st[elt[smallest]].size)
+      smallest = right;
+    else
+      smallest = i;
+    if (smallest != i) {
+      const int temp = elt[i];
+      elt[i] = elt[smallest];
+      elt[smallest] = temp;
+      st[elt[i]].heap_index = i;
+      st[elt[smallest]].heap_index = smallest;
+      i = smallest;
+    } else
+      break;
+  } while (i < heap->size);
+}
+
+static int STextractmin(subtree_t *st, STheap_t *heap) {
+  const int rv = heap->elt[0];
+  st[rv].heap_index = -1;
+  heap->elt[0] = heap->elt[heap->size - 1];
+  st[heap->elt[0]].heap_index = 0;
+  heap->elt[heap->size - 1] = rv;
+  heap->size--;
+  STheapify(st, heap, 0);
+  return rv;
+}
+
+/// add `delta` to the rank of every node in the tree containing `v`
+static void tree_adjust(ns_t *ns, int v, int delta) {
+  frame_t *stack = ns->stack;
+  int top = 0;
+  stack[0] = (frame_t){.v = v, .from = -1};
+
+  while (top >= 0) {
+    const frame_t fr = stack[top--];
+    nsnode_t *n = &ns->nodes[fr.v];
+    n->rank += delta;
+    for (int k = 0; k < n->n_tree_in + n->n_tree_out; k++) {
+      const int e = k < n->n_tree_in ? ns->tree_in[n->in + k]
+                                     : ns->tree_out[n->out + k - n->n_tree_in];
+      const int w = other_end(ns, e, fr.v);
+      if (w != fr.from) {
+        assert(top + 1 < ns->n_nodes);
+        stack[++top] = (frame_t){.v = w, .from = fr.v};
+      }
+    }
+  }
+}
+
+/// merge the trees joined by entering tree edge `e`
+static int merge_trees(ns_t *ns, subtree_t *st, int e) {
+  assert(!tree_edge(ns, e));
+
+  const int t0 = STsetFind(st, ns->nodes[ns->edges[e].tail].subtree);
+  const int t1 = STsetFind(st, ns->nodes[ns->edges[e].head].subtree);
+
+  if (st[t0].heap_index == -1) { // move t0
+    const int delta = slack(ns, e);
+    if (delta != 0)
+      tree_adjust(ns, st[t0].rep, delta);
+  } else { // move t1
+    const int delta = -slack(ns, e);
+    if (delta != 0)
+      tree_adjust(ns, st[t1].rep, delta);
+  }
+  if (add_tree_edge(ns, e) != 0)
+    return -1;
+  return STsetUnion(st, t0, t1);
+}
+
+/* Construct initial tight tree, as feasible_tree in ns.c.
+ * Return 1 if input graph is not connected; 2 on error; 0 on success.
+ */
+static int feasible_tree(ns_t *ns) {
+  const size_t n_nodes = (size_t)ns->n_nodes;
+  int error = 0;
+
+  for (int v = 0; v < ns->n_nodes; v++)
+    ns->nodes[v].subtree = -1;
+
+  subtree_t *st = gv_calloc(n_nodes, sizeof(st[0]));
+  STheap_t heap = {.elt = gv_calloc(n_nodes, sizeof(heap.elt[0]))};
+  /* given init_rank, find all tight subtrees */
+  int subtree_count = 0;
+  for (int v = 0; v < ns->n_nodes; v++) {
+    if (ns->nodes[v].subtree == -1) {
+      const int t = subtree_count++;
+      st[t].rep = v;
+      st[t].size = tight_subtree_search(ns, v, t);
+      if (st[t].size < 0) {
+        error = 2;
+        goto end;
+      }
+      st[t].par = t;
+    }
+  }
+
+  /* incrementally merge subtrees */
+  heap.size = subtree_count;
+  for (int i = 0; i < heap.size; i++) {
+    heap.elt[i] = i;
+    st[i].heap_index = i;
+  }
+  for (int i = heap.size / 2; i >= 0; i--)
+    STheapify(st, &heap, i);
+  while (heap.size > 1) {
+    const int tree0 = STextractmin(st, &heap);
+    const int ee = inter_tree_edge(ns, st, tree0);
+    if (ee < 0) {
+      error = 1;
+      break;
+    }
+    const int tree1 = merge_trees(ns, st, ee);
+    if (tree1 < 0) {
+      error = 2;
+      break;
+    }
+    STheapify(st, &heap, st[tree1].heap_index);
+  }
+
+end:
+  free(heap.elt);
+  free(st);
+  if (error)
+    return error;
+  assert(ns->n_tree_edges == ns->n_nodes - 1);
+  init_cutvalues(ns);
+  return 0;
+}
+
+/* walk up from v to LCA(v,w), setting new cutvalues. */
+static int treeupdate(ns_t *ns, int v, int w, int cutvalue, bool dir) {
+  const nsnode_t *nodes = ns->nodes;
+  while (!SEQ(nodes[v].low, nodes[w].lim, nodes[v].lim)) {
+    nsedge_t *e = &ns->edges[nodes[v].par];
+    const bool d = v == e->tail ? dir : !dir;
+    if (d)
+      e->cutvalue += cutvalue;
+    else
+      e->cutvalue -= cutvalue;
+    if (nodes[e->tail].lim > nodes[e->head].lim)
+      v = e->tail;
+    else
+      v = e->head;
+  }
+  return v;
+}
+
+/// subtract `delta` from the ranks of `v` and the tree below it
+static void rerank(ns_t *ns, int v, int delta) {
+  frame_t *stack = ns->stack;
+  int top = 0;
+  stack[0] = (frame_t){.v = v};
+
+  while (top >= 0) {
+    const int u = stack[top--].v;
+    nsnode_t *n = &ns->nodes[u];
+    n->rank -= delta;
+    for (int k = 0; k < n->n_tree_out + n->n_tree_in; k++) {
+      const int e = nth_tree_edge(ns, n, k);
+      if (e != n->par) {
+        assert(top + 1 < ns->n_nodes);
+        stack[++top] = (frame_t){.v = other_end(ns, e, u)};
+      }
+    }
+  }
+}
+
+/* e is the tree edge that is leaving and f is the nontree edge that
+ * is entering.  compute new cut values, ranks, and exchange e and f.
+ */
+static int update(ns_t *ns, int e, int f) {
+  nsnode_t *nodes = ns->nodes;
+  nsedge_t *ee = &ns->edges[e];
+  nsedge_t *ff = &ns->edges[f];
+
+  const int delta = slack(ns, f);
+  /* "for (v = in nodes in tail side of e) do ND_rank(v) -= delta;" */
+  if (delta > 0) {
+    const nsnode_t *t = &nodes[ee->tail];
+    const nsnode_t *h = &nodes[ee->head];
+    if (t->n_tree_in + t->n_tree_out == 1)
+      rerank(ns, ee->tail, delta);
+    else if (h->n_tree_in + h->n_tree_out == 1)
+      rerank(ns, ee->head, -delta);
+    else if (t->lim < h->lim)
+      rerank(ns, ee->tail, delta);
+    else
+      rerank(ns, ee->head, -delta);
+  }
+
+  const int cutvalue = ee->cutvalue;
+  const int lca = treeupdate(ns, ff->tail, ff->head, cutvalue, true);
+  if (treeupdate(ns, ff->head, ff->tail, cutvalue, false) != lca) {
+    agerr(AGERR, "update: mismatched lca in treeupdates\n");
+    return 2;
+  }
+
+  // invalidate paths from LCA till affected nodes:
+  const int lca_low = nodes[lca].low;
+  invalidate_path(ns, lca, ff->head);
+  invalidate_path(ns, lca, ff->tail);
+
+  ff->cutvalue = -cutvalue;
+  ee->cutvalue = 0;
+  exchange_tree_edges(ns, e, f);
+  dfs_range(ns, lca, nodes[lca].par, lca_low, true);
+  return 0;
+}
+
+static void scan_and_normalize(ns_t *ns) {
+  int Minrank = INT_MAX;
+  ns->maxrank = -INT_MAX;
+  for (int v = 0; v < ns->n_nodes; v++) {
+    if (ns->nodes[v].normal) {
+      Minrank = MIN(Minrank, ns->nodes[v].rank);
+      ns->maxrank = MAX(ns->maxrank, ns->nodes[v].rank);
+    }
+  }
+  for (int v = 0; v < ns->n_nodes; v++)
+    ns->nodes[v].rank -= Minrank;
+  ns->maxrank -= Minrank;
+}
+
+static void clear_marks(ns_t *ns) {
+  for (int v = 0; v < ns->n_nodes; v++)
+    ns->nodes[v].mark = false;
+}
+
+static void LR_balance(ns_t *ns) {
+  for (int i = 0; i < ns->n_tree_edges; i++) {
+    const int e = ns->tree_edge[i];
+    if (ns->edges[e].cutvalue == 0) {
+      const int f = enter_edge(ns, e);
+      if (f < 0)
+        continue;
+      const int delta = slack(ns, f);
+      if (delta <= 1)
+        continue;
+      const nsedge_t *ee = &ns->edges[e];
+      if (ns->nodes[ee->tail].lim < ns->nodes[ee->head].lim)
+        rerank(ns, ee->tail, delta / 2);
+      else
+        rerank(ns, ee->head, -delta / 2);
+    }
+  }
+  clear_marks(ns);
+}
+
+/// the nodes being sorted by TB_balance
+static TLS const nsnode_t *Sort_nodes;
+
+static int decreasingrankcmpf(const void *x, const void *y) {
+  const int *n0 = x;
+  const int *n1 = y;
+  if (Sort_nodes[*n1].rank < Sort_nodes[*n0].rank) {
+    return -1;
+  }
+  if (Sort_nodes[*n1].rank > Sort_nodes[*n0].rank) {
+    return 1;
+  }
+  return 0;
+}
+
+static int increasingrankcmpf(const void *x, const void *y) {
+  const int *n0 = x;
+  const int *n1 = y;
+  if (Sort_nodes[*n0].rank < Sort_nodes[*n1].rank) {
+    return -1;
+  }
+  if (Sort_nodes[*n0].rank > Sort_nodes[*n1].rank) {
+    return 1;
+  }
+  return 0;
+}
+
+static void TB_balance(ns_t *ns) {
+  nsnode_t *nodes = ns->nodes;
+  int adj = 0;
+  char *s;
+
+  scan_and_normalize(ns);
+
+  /* find nodes that are not tight and move to less populated ranks */
+  int *nrank = gv_calloc((size_t)ns->maxrank + 1, sizeof(nrank[0]));
+  if ((s = agget(ns->g, "TBbalance"))) {
+    if (streq(s, "min"))
+      adj = 1;
+    else if (streq(s, "max"))
+      adj = 2;
+    if (adj)
+      for (int v = 0; v < ns->n_nodes; v++)
+        if (nodes[v].normal) {
+          if (nodes[v].n_in == 0 && adj == 1) {
+            nodes[v].rank = 0;
+          }
+          if (nodes[v].n_out == 0 && adj == 2) {
+            nodes[v].rank = ns->maxrank;
+          }
+        }
+  }
+  int *order = gv_calloc((size_t)ns->n_nodes, sizeof(order[0]));
+  for (int v = 0; v < ns->n_nodes; v++)
+    order[v] = v;
+  Sort_nodes = nodes;
+  qsort(order, (size_t)ns->n_nodes, sizeof(order[0]),
+        adj > 1 ? decreasingrankcmpf : increasingrankcmpf);
+  Sort_nodes = NULL;
+  for (int v = 0; v < ns->n_nodes; v++) {
+    if (nodes[v].normal)
+      nrank[nodes[v].rank]++;
+  }
+  for (int i = 0; i < ns->n_nodes; i++) {
+    nsnode_t *n = &nodes[order[i]];
+    if (!n->normal)
+      continue;
+    int inweight = 0, outweight = 0;
+    int low = 0;
+    int high = ns->maxrank;
+    for (int j = 0; j < n->n_in; j++) {
+      const nsedge_t *e = &ns->edges[ns->in_edges[n->in + j]];
+      inweight += e->weight;
+      low = MAX(low, nodes[e->tail].rank + e->minlen);
+    }
+    for (int e = n->out; e < n->out + n->n_out; e++) {
+      outweight += ns->edges[e].weight;
+      high = MIN(high, nodes[ns->edges[e].head].rank - ns->edges[e].minlen);
+    }
+    if (low < 0)
+      low = 0; /* vnodes can have ranks < 0 */
+    if (adj) {
+      if (inweight == outweight)
+        n->rank = adj == 1 ? low : high;
+    } else {
+      if (inweight == outweight) {
+        int choice = low;
+        for (int j = low + 1; j <= high; j++)
+          if (nrank[j] < nrank[choice])
+            choice = j;
+        nrank[n->rank]--;
+        nrank[choice]++;
+        n->rank = choice;
+      }
+    }
+    n->mark = false;
+  }
+  free(order);
+  free(nrank);
+}
+
+/* Number the nodes and edges of g into ns, and copy out their attributes.
+ * Return false if g is not one that can be numbered.
+ */
+static bool init_graph(ns_t *ns, graph_t *g, bool *feasible) {
+  node_t *n;
+  edge_t *e;
+  size_t n_nodes = 0, n_edges = 0, n_in_edges = 0;
+
+  for (n = GD_nlist(g); n; n = ND_next(n)) {
+    n_nodes++;
+    for (size_t i = 0; (e = ND_out(n).list[i]); i++)
+      n_edges++;
+    for (size_t i = 0; (e = ND_in(n).list[i]); i++) {
+      n_in_edges++;
+      ED_tree_index(e) = -1;
+    }
+  }
+  if (n_nodes == 0 || n_nodes > INT_MAX || n_edges > INT_MAX ||
+      n_in_edges != n_edges)
+    return false;
+
+  ns->g = g;
+  ns->n_nodes = (int)n_nodes;
+  ns->n_edges = (int)n_edges;
+  ns->gnodes = gv_calloc(n_nodes, sizeof(ns->gnodes[0]));
+  ns->gedges = gv_calloc(n_edges, sizeof(ns->gedges[0]));
+  ns->nodes = gv_calloc(n_nodes, sizeof(ns->nodes[0]));
+  ns->edges = gv_calloc(n_edges, sizeof(ns->edges[0]));
+  ns->in_edges = gv_calloc(n_edges, sizeof(ns->in_edges[0]));
+  ns->tree_out = gv_calloc(n_edges, sizeof(ns->tree_out[0]));
+  ns->tree_in = gv_calloc(n_edges, sizeof(ns->tree_in[0]));
+  ns->tree_edge = gv_calloc(n_nodes, sizeof(ns->tree_edge[0]));
+  ns->stack = gv_calloc(n_nodes, sizeof(ns->stack[0]));
+  ns->stack_size = n_nodes;
+
+  /* number the nodes, borrowing ND_low to map a node to its number */
+  int v = 0;
+  for (n = GD_nlist(g); n; n = ND_next(n), v++) {
+    nsnode_t *nn = &ns->nodes[v];
+    ns->gnodes[v] = n;
+    nn->rank = ND_rank(n);
+    nn->low = ND_low(n);
+    nn->lim = ND_lim(n);
+    nn->par = -1;
+    nn->normal = ND_node_type(n) == NORMAL;
+    ND_low(n) = v;
+  }
+
+  /* number the edges in out-edge order, borrowing ED_tree_index likewise */
+  bool ok = true;
+  int id = 0, in = 0;
+  for (v = 0; v < ns->n_nodes; v++) {
+    n = ns->gnodes[v];
+    nsnode_t *nn = &ns->nodes[v];
+    nn->out = id;
+    for (size_t i = 0; (e = ND_out(n).list[i]); i++, id++) {
+      const int h = ND_low(aghead(e));
+      if (agtail(e) != n || h < 0 || h >= ns->n_nodes ||
+          ns->gnodes[h] != aghead(e)) {
+        ok = false;
+        goto done;
+      }
+      ns->gedges[id] = e;
+      ns->edges[id] = (nsedge_t){.tail = v,
+                                 .head = h,
+                                 .minlen = ED_minlen(e),
+                                 .weight = ED_weight(e),
+                                 .tree_index = -1};
+      ED_tree_index(e) = id;
+    }
+    nn->n_out = id - nn->out;
+  }
+  for (v = 0; v < ns->n_nodes; v++) {
+    n = ns->gnodes[v];
+    nsnode_t *nn = &ns->nodes[v];
+    nn->in = in;
+    for (size_t i = 0; (e = ND_in(n).list[i]); i++, in++) {
+      const int f = ED_tree_index(e);
+      if (f < 0 || ns->edges[f].head != v) {
+        ok = false;
+        goto done;
+      }
+      ns->in_edges[in] = f;
+    }
+    nn->n_in = nn->priority = in - nn->in;
+  }
+
+  *feasible = true;
+  for (int f = 0; f < ns->n_edges; f++)
+    if (slack(ns, f) < 0)
+      *feasible = false;
+
+done:
+  /* give back the borrowed fields */
+  for (v = 0; v < ns->n_nodes; v++)
+    ND_low(ns->gnodes[v]) = ns->nodes[v].low;
+  return ok;
+}
+
+/// copy the results back to the graph, as ns.c leaves them
+static void store(const ns_t *ns) {
+  for (int v = 0; v < ns->n_nodes; v++) {
+    node_t *n = ns->gnodes[v];
+    const nsnode_t *nn = &ns->nodes[v];
+    ND_rank(n) = nn->rank;
+    ND_low(n) = nn->low;
+    ND_lim(n) = nn->lim;
+    ND_par(n) = nn->par >= 0 ? ns->gedges[nn->par] : NULL;
+    ND_priority(n) = nn->priority;
+    ND_mark(n) = nn->mark;
+  }
+  for (int e = 0; e < ns->n_edges; e++) {
+    ED_cutvalue(ns->gedges[e]) = ns->edges[e].cutvalue;
+    ED_tree_index(ns->gedges[e]) = ns->edges[e].tree_index;
+  }
+}
+
+static void free_ns(ns_t *ns) {
+  free(ns->gnodes);
+  free(ns->gedges);
+  free(ns->nodes);
+  free(ns->edges);
+  free(ns->in_edges);
+  free(ns->tree_out);
+  free(ns->tree_in);
+  free(ns->tree_edge);
+  free(ns->stack);
+  if (ns->workers) {
+    for (size_t i = 0; i < workers_size(ns->workers); i++)
+      free(ns->parts[i].stack);
+    workers_free(ns->workers);
+  }
+  free(ns->parts);
+  free(ns->items);
+}
+
+int ns_compact(graph_t *g, int balance, int maxiter, int search_size,
+               bool warm, int threads) {
+  layout_context_t *const lctx = gvLayoutContext();
+  int iter = 0;
+  char *nsstr = "network simplex: ";
+  ns_t ns = {0};
+  bool feasible;
+  int e, rc;
+
+  if (!init_graph(&ns, g, &feasible)) {
+    free_ns(&ns);
+    return -1;
+  }
+  ns.feasible = true;
+  if (!feasible)
+    init_rank(&ns, warm);
+
+  ns.search_size = search_size;
+  if (threads > 1) {
+    ns.workers = workers_new((size_t)threads);
+    const size_t parts = workers_size(ns.workers);
+    if (parts > 1) {
+      ns.parts = gv_calloc(parts, sizeof(ns.parts[0]));
+      for (size_t i = 0; i < parts; i++) {
+        ns.parts[i].stack_size = 64;
+        ns.parts[i].stack = gv_calloc(ns.parts[i].stack_size,
+                                      sizeof(ns.parts[i].stack[0]));
+      }
+    } else {
+      workers_free(ns.workers);
+      ns.workers = NULL;
+    }
+  }
+
+  rc = feasible_tree(&ns);
+  if (rc != 0 || maxiter <= 0) {
+    clear_marks(&ns);
+    goto done;
+  }
+
+  while ((e = leave_edge(&ns)) >= 0) {
+    const int f = enter_edge(&ns, e);
+    assert(f >= 0);
+    rc = update(&ns, e, f);
+    if (rc != 0) {
+      clear_marks(&ns);
+      goto done;
+    }
+    iter++;
+    if (Verbose && iter % 100 == 0) {
+      if (iter % 1000 == 100)
+        fputs(nsstr, stderr);
+      fprintf(stderr, "%d ", iter);
+      if (iter % 1000 == 0)
+        fputc('\n', stderr);
+    }
+    if (iter >= maxiter)
+      break;
+    if (phase_expired()) {
+      lctx->PhaseTruncated = true;
+      break;
+    }
+  }
+  switch (balance) {
+  case 1:
+    TB_balance(&ns);
+    break;
+  case 2:
+    LR_balance(&ns);
+    break;
+  default:
+    scan_and_normalize(&ns);
+    clear_marks(&ns);
+    break;
+  }
+  if (Verbose) {
+    if (iter >= 100)
+      fputc('\n', stderr);
+    fprintf(stderr, "%s%d nodes %d edges %d iter %.2f sec\n", nsstr,
+            ns.n_nodes, ns.n_edges, iter, elapsed_sec());
+  }
+
+done:
+  store(&ns);
+  free_ns(&ns);
+  return rc;
+}
@@ -0,0 +1,28 @@
+/// @file
+/// @brief network simplex over compact arrays, for large graphs
+
+#pragma once
+
+#include <common/types.h>
+#include <stdbool.h>
+
+/// rank the nodes of `g` as the network simplex in ns.c does
+///
+/// This is the same algorithm, making the same choices and so giving the same
+/// ranks, but run over arrays of small node and edge records indexed by
+/// position rather than over the graph itself, with iterative rather than
+/// recursive searches of the spanning tree. It is used instead of the solver in
+/// ns.c for large graphs, where that one spends most of its time on cache
+/// misses and can run out of stack.
+///
+/// The arguments and result are those of `rank2` and `rank_warm`, except that
+/// `search_size` must already have had its default put in place of a negative
+/// value. Returns -1, without ranking `g`, if it is not a graph this can handle
+/// (for example, if an edge in an in-edge list is missing from the out-edge
+/// lists).
+///
+/// With `threads` more than 1, searches for the edges to exchange in each
+/// iteration are shared among that many threads where they are long enough to
+/// be worth it. The edges found, and so the ranks, are the same.
+int ns_compact(graph_t *g, int balance, int maxiter, int search_size,
+               bool warm, int threads);
@@ -10,6 +10,8 @@
 
 #include <common/render.h>
 #include <cgraph/agxbuf.h>
+#include <cgraph/tls.h>
+#include <cgraph/tls.h>
 #include <gvc/gvc.h>
 #include <stdarg.h>
 #include <stdbool.h>
@@ -18,15 +20,15 @@
 #define YDIR(y) (Y_invert ? (Y_off - (y)) : (y))
 #define YFDIR(y) (Y_invert ? (YF_off - (y)) : (y))
 
-static double Y_off;        /* ymin + ymax */
-static double YF_off;       /* Y_off in inches */
+static TLS double Y_off;        /* ymin + ymax */
+static TLS double YF_off;       /* Y_off in inches */
 
 double yDir (double y)
 {
     return YDIR(y);
 }
 
-static int (*putstr) (void *chan, const char *str);
+static TLS int (*putstr) (void *chan, const char *str);
 
 static void agputs (const char* s, FILE* fp)
 {
@@ -34,7 +36,7 @@ static void agputs (const char* s, FILE* fp)
 }
 
 static void agputc(char c, FILE *fp) {
-    static char buf[2] = {'\0','\0'};
+    static TLS char buf[2] = {'\0','\0'};
     buf[0] = c;
     putstr(fp, buf);
 }
@@ -108,6 +110,7 @@ static void writenodeandport(FILE *f, node_t *node, char *portname) {
 /* _write_plain:
  */
 void write_plain(GVJ_t *job, graph_t *g, FILE *f, bool extend) {
+    layout_context_t *const lctx = gvLayoutContext();
     int i, j, splinePoints;
     char *tport, *hport;
     node_t *n;
@@ -131,18 +134,18 @@ void write_plain(GVJ_t *job, graph_t *g, FILE *f, bool extend) {
 	printstring(f, "node ", agcanonStr(agnameof(n)));
 	printpoint(f, ND_coord(n));
 	if (ND_label(n)->html)   /* if html, get original text */
-	    lbl = agcanonStr (agxget(n, N_label));
+	    lbl = agcanonStr (agxget(n, lctx->N_label));
 	else
 	    lbl = canon(agraphof(n),ND_label(n)->text);
         printdouble(f, " ", ND_width(n));
         printdouble(f, " ", ND_height(n));
         printstring(f, " ", lbl);
-	printstring(f, " ", late_nnstring(n, N_style, "solid"));
+	printstring(f, " ", late_nnstring(n, lctx->N_style, "solid"));
 	printstring(f, " ", ND_shape(n)->name);
-	printstring(f, " ", late_nnstring(n, N_color, DEFAULT_COLOR));
-	fillcolor = late_nnstring(n, N_fillcolor, "");
+	printstring(f, " ", late_nnstring(n, lctx->N_color, DEFAULT_COLOR));
+	fillcolor = late_nnstring(n, lctx->N_fillcolor, "");
         if (fillcolor[0] == '\0')
-	    fillcolor = late_nnstring(n, N_color, DEFAULT_FILL);
+	    fillcolor = late_nnstring(n, lctx->N_color, DEFAULT_FILL);
 	printstring(f, " ", fillcolor);
 	agputc('\n', f);
     }
@@ -177,8 +180,8 @@ void write_plain(GVJ_t *job, graph_t *g, FILE *f, bool extend) {
 		printstring(f, " ", canon(agraphof(agtail(e)),ED_label(e)->text));
 		printpoint(f, ED_label(e)->pos);
 	    }
-	    printstring(f, " ", late_nnstring(e, E_style, "solid"));
-	    printstring(f, " ", late_nnstring(e, E_color, DEFAULT_COLOR));
+	    printstring(f, " ", late_nnstring(e, lctx->E_style, "solid"));
+	    printstring(f, " ", late_nnstring(e, lctx->E_color, DEFAULT_COLOR));
 	    agputc('\n', f);
 	}
     }
@@ -225,6 +228,7 @@ static void rec_attach_bb(graph_t * g, Agsym_t* bbsym, Agsym_t* lpsym, Agsym_t*
 
 void attach_attrs_and_arrows(graph_t* g, int* sp, int* ep)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     int e_arrows;		/* graph has edges with end arrows */
     int s_arrows;		/* graph has edges with start arrows */
     int j, sides;
@@ -246,8 +250,8 @@ void attach_attrs_and_arrows(graph_t* g, int* sp, int* ep)
     agxbinit(&xb, BUFSIZ, xbuffer);
     safe_dcl(g, AGNODE, "pos", "");
     safe_dcl(g, AGNODE, "rects", "");
-    N_width = safe_dcl(g, AGNODE, "width", "");
-    N_height = safe_dcl(g, AGNODE, "height", "");
+    lctx->N_width = safe_dcl(g, AGNODE, "width", "");
+    lctx->N_height = safe_dcl(g, AGNODE, "height", "");
     safe_dcl(g, AGEDGE, "pos", "");
     if (GD_has_labels(g) & NODE_XLABEL)
 	safe_dcl(g, AGNODE, "xlp", "");
@@ -280,9 +284,9 @@ void attach_attrs_and_arrows(graph_t* g, int* sp, int* ep)
 	    agset(n, "pos", buf);
 	}
 	snprintf(buf, sizeof(buf), "%.5g", PS2INCH(ND_ht(n)));
-	agxset(n, N_height, buf);
+	agxset(n, lctx->N_height, buf);
 	snprintf(buf, sizeof(buf), "%.5g", PS2INCH(ND_lw(n) + ND_rw(n)));
-	agxset(n, N_width, buf);
+	agxset(n, lctx->N_width, buf);
 	if (ND_xlabel(n) && ND_xlabel(n)->set) {
 	    ptf = ND_xlabel(n)->pos;
 	    snprintf(buf, sizeof(buf), "%.5g,%.5g", ptf.x, YDIR(ptf.y));
@@ -294,7 +298,7 @@ void attach_attrs_and_arrows(graph_t* g, int* sp, int* ep)
 	    agset(n, "rects", agxbuse(&xb));
 	} else {
 	    polygon_t *poly;
-	    if (N_vertices && isPolygon(n)) {
+	    if (lctx->N_vertices && isPolygon(n)) {
 		poly = ND_shape_info(n);
 		sides = poly->sides;
 		if (sides < 3) {
@@ -318,10 +322,10 @@ void attach_attrs_and_arrows(graph_t* g, int* sp, int* ep)
 				ND_width(n) / 2.0 * cos(i / (double) sides * M_PI * 2.0),
 				YFDIR(ND_height(n) / 2.0 * sin(i / (double) sides * M_PI * 2.0)));
 		}
-		agxset(n, N_vertices, agxbuse(&xb));
+		agxset(n, lctx->N_vertices, agxbuse(&xb));
 	    }
 	}
-	if (State >= GVSPLINES) {
+	if (lctx->State >= GVSPLINES) {
 	    for (e = agfstout(g, n); e; e = agnxtout(g, e)) {
 		if (ED_edge_type(e) == IGNORED)
 		    continue;
@@ -9,14 +9,15 @@
  *************************************************************************/
 
 #include <cgraph/agxbuf.h>
+#include <cgraph/tls.h>
 #include <cgraph/unreachable.h>
 #include <common/render.h>
 #include <label/xlabels.h>
 #include <stdbool.h>
 
-static int Rankdir;
-static bool Flip;
-static pointf Offset;
+static TLS int Rankdir;
+static TLS bool Flip;
+static TLS pointf Offset;
 
 static void place_flip_graph_label(graph_t * g);
 
@@ -88,11 +89,12 @@ static pointf map_point(pointf p)
 
 static void map_edge(edge_t * e)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     int j, k;
     bezier bz;
 
     if (ED_spl(e) == NULL) {
-	if (!Concentrate && ED_edge_type(e) != IGNORED)
+	if (!lctx->Concentrate && ED_edge_type(e) != IGNORED)
 	    agerr(AGERR, "lost %s %s edge\n", agnameof(agtail(e)),
 		  agnameof(aghead(e)));
 	return;
@@ -144,6 +146,7 @@ void translate_bb(graph_t * g, int rankdir)
  */
 static void translate_drawing(graph_t * g)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     node_t *v;
     edge_t *e;
     bool shift = Offset.x || Offset.y;
@@ -156,7 +159,7 @@ static void translate_drawing(graph_t * g)
 	ND_coord(v) = map_point(ND_coord(v));
 	if (ND_xlabel(v))
 	    ND_xlabel(v)->pos = map_point(ND_xlabel(v)->pos);
-	if (State == GVSPLINES)
+	if (lctx->State == GVSPLINES)
 	    for (e = agfstout(g, v); e; e = agnxtout(g, e))
 		map_edge(e);
     }
@@ -404,6 +407,7 @@ countClusterLabels (Agraph_t* g)
 
 static void addXLabels(Agraph_t * gp)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     Agnode_t *np;
     Agedge_t *ep;
     int cnt, i, n_objs, n_lbls;
@@ -425,7 +429,7 @@ static void addXLabels(Agraph_t * gp)
 	!(GD_has_labels(gp) & EDGE_XLABEL) &&
 	!(GD_has_labels(gp) & TAIL_LABEL) &&
 	!(GD_has_labels(gp) & HEAD_LABEL) &&
-	(!(GD_has_labels(gp) & EDGE_LABEL) || EdgeLabelsDone))
+	(!(GD_has_labels(gp) & EDGE_LABEL) || lctx->EdgeLabelsDone))
 	return;
 
     for (np = agfstnode(gp); np; np = agnxtnode(gp, np)) {
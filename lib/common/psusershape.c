@@ -13,10 +13,11 @@
 #include <common/render.h>
 #include <gvc/gvio.h>
 #include <cgraph/strcasecmp.h>
+#include <cgraph/tls.h>
 #include <stdbool.h>
 
-static int N_EPSF_files;
-static Dict_t *EPSF_contents;
+static TLS int N_EPSF_files;
+static TLS Dict_t *EPSF_contents;
 
 static void ps_image_free(Dict_t * dict, usershape_t * p, Dtdisc_t * disc)
 {
@@ -263,7 +264,7 @@ char *ps_string(char *ins, int chset)
 {
     char *s;
     char *base;
-    static agxbuf  xb;
+    static TLS agxbuf  xb;
     static int warned;
 
     switch (chset) {
@@ -0,0 +1,76 @@
+/*************************************************************************
+ * Copyright (c) 2011 AT&T Intellectual Property
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors: Details at https://graphviz.org
+ *************************************************************************/
+
+#include <cgraph/tls.h>
+#include <common/random.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/* The additive feedback generator of glibc’s rand: x[i] = x[i-3] + x[i-31],
+ * with the low bit dropped, seeded by a Park–Miller sequence that is then run
+ * for 310 steps.
+ */
+enum { RAND_DEGREE = 31, RAND_SEPARATION = 3 };
+
+static TLS struct {
+  uint32_t state[RAND_DEGREE];
+  int front, rear; ///< indices of x[i-3] and x[i-31]
+  bool seeded;
+} rand_state;
+
+void gv_srand(unsigned seed) {
+  if (seed == 0)
+    seed = 1;
+  int64_t word = seed;
+  rand_state.state[0] = (uint32_t)seed;
+  for (int i = 1; i < RAND_DEGREE; ++i) {
+    const int64_t hi = word / 127773;
+    const int64_t lo = word % 127773;
+    word = 16807 * lo - 2836 * hi;
+    if (word < 0)
+      word += 2147483647;
+    rand_state.state[i] = (uint32_t)word;
+  }
+  rand_state.front = RAND_SEPARATION;
+  rand_state.rear = 0;
+  rand_state.seeded = true;
+  for (int i = 0; i < 10 * RAND_DEGREE; ++i)
+    (void)gv_rand();
+}
+
+int gv_rand(void) {
+  if (!rand_state.seeded)
+    gv_srand(1);
+  uint32_t *x = rand_state.state;
+  x[rand_state.front] += x[rand_state.rear];
+  const int result = (int)(x[rand_state.front] >> 1);
+  rand_state.front = (rand_state.front + 1) % RAND_DEGREE;
+  rand_state.rear = (rand_state.rear + 1) % RAND_DEGREE;
+  return result;
+}
+
+/* The linear congruential generator POSIX specifies for drand48. An unseeded
+ * generator starts from 0, as glibc’s does.
+ */
+static TLS uint64_t rand48_state;
+
+void gv_srand48(long seed) {
+  rand48_state = ((uint64_t)(unsigned long)seed & 0xffffffff) << 16 | 0x330E;
+}
+
+double gv_drand48(void) {
+  rand48_state = (rand48_state * 0x5DEECE66Dull + 0xB) & ((1ull << 48) - 1);
+  return (double)rand48_state / (double)(1ull << 48);
+}
+
+void gv_reset_random(void) {
+  rand_state.seeded = false;
+  rand48_state = 0;
+}
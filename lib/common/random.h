@@ -0,0 +1,59 @@
+/*************************************************************************
+ * Copyright (c) 2011 AT&T Intellectual Property
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors: Details at https://graphviz.org
+ *************************************************************************/
+
+/// @file
+/// @brief random numbers for layouts
+///
+/// These stand in for the C library’s `rand` and `drand48` families. They
+/// produce the same sequences as the GNU C library’s, so layouts are unchanged
+/// there, but keep their state per thread. A layout running in one thread
+/// therefore neither disturbs nor is disturbed by layouts in other threads.
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef GVDLL
+#ifdef GVC_EXPORTS
+#define RANDOM_API __declspec(dllexport)
+#else
+#define RANDOM_API __declspec(dllimport)
+#endif
+#endif
+
+#ifndef RANDOM_API
+#define RANDOM_API /* nothing */
+#endif
+
+/// largest value returned by `gv_rand`
+#define GV_RAND_MAX 2147483647
+
+/// seed the calling thread’s `gv_rand` sequence, as `srand`
+RANDOM_API void gv_srand(unsigned seed);
+
+/// next value in [0, GV_RAND_MAX] of the calling thread’s sequence, as `rand`
+RANDOM_API int gv_rand(void);
+
+/// seed the calling thread’s `gv_drand48` sequence, as `srand48`
+RANDOM_API void gv_srand48(long seed);
+
+/// next value in [0, 1) of the calling thread’s sequence, as `drand48`
+RANDOM_API double gv_drand48(void);
+
+/// return both of the calling thread’s sequences to their unseeded state
+RANDOM_API void gv_reset_random(void);
+
+#undef RANDOM_API
+
+#ifdef __cplusplus
+}
+#endif
@@ -121,6 +121,7 @@ extern "C" {
     RENDER_API obj_state_t* push_obj_state(GVJ_t *job);
     RENDER_API int rank(graph_t * g, int balance, int maxiter);
     RENDER_API int rank2(graph_t * g, int balance, int maxiter, int search_size);
+    RENDER_API int rank_warm(graph_t * g, int balance, int maxiter, int search_size);
     RENDER_API port resolvePort(node_t*  n, node_t* other, port* oldport);
     RENDER_API void resolvePorts (edge_t* e);
     RENDER_API void round_corners(GVJ_t * job, pointf * AF, int sides, int style, int filled);
@@ -12,6 +12,7 @@
 #include <assert.h>
 #include <cgraph/agxbuf.h>
 #include <cgraph/alloc.h>
+#include <cgraph/tls.h>
 #include <common/geomprocs.h>
 #include <common/render.h>
 #include <limits.h>
@@ -22,14 +23,14 @@
 #include <stdlib.h>
 #include <string.h>
 
-static int nedges, nboxes; /* total no. of edges and boxes used in routing */
+static TLS int nedges, nboxes; /* total no. of edges and boxes used in routing */
 
-static int routeinit;
+static TLS int routeinit;
 /* static data used across multiple edges */
-static Ppoint_t *polypoints;  /* vertices of polygon defined by boxes */
-static int polypointn;        /* size of polypoints[] */
-static Pedge_t *edges;        /* polygon edges passed to Proutespline */
-static int edgen;             /* size of edges[] */
+static TLS Ppoint_t *polypoints;  /* vertices of polygon defined by boxes */
+static TLS int polypointn;        /* size of polypoints[] */
+static TLS Pedge_t *edges;        /* polygon edges passed to Proutespline */
+static TLS int edgen;             /* size of edges[] */
 
 static int checkpath(int, boxf*, path*);
 static void printpath(path * pp);
@@ -253,6 +254,14 @@ void routesplinesterm()
 	fprintf(stderr,
 		"routesplines: %d edges, %d boxes %.2f sec\n",
 		nedges, nboxes, elapsed_sec());
+    /* routing may have been done in a thread that is about to end */
+    free(polypoints);
+    polypoints = NULL;
+    polypointn = 0;
+    free(edges);
+    edges = NULL;
+    edgen = 0;
+    Pfreebuffers();
 }
 
 static void
@@ -1061,6 +1070,7 @@ makeStraightEdge(graph_t * g, edge_t * e, int et, splineInfo* sinfo)
 void 
 makeStraightEdges(graph_t *g, edge_t **edge_list, int e_cnt, int et,
                   splineInfo *sinfo) {
+    layout_context_t *const lctx = gvLayoutContext();
     pointf dumb[4];
     bool curved = et == EDGETYPE_CURVED;
     pointf del;
@@ -1070,7 +1080,7 @@ makeStraightEdges(graph_t *g, edge_t **edge_list, int e_cnt, int et,
     node_t *head = aghead(e);
     dumb[1] = dumb[0] = add_pointf(ND_coord(n), ED_tail_port(e).p);
     dumb[2] = dumb[3] = add_pointf(ND_coord(head), ED_head_port(e).p);
-    if (e_cnt == 1 || Concentrate) {
+    if (e_cnt == 1 || lctx->Concentrate) {
 	if (curved) bend(dumb,get_cycle_centroid(g, edge_list[0]));
 	clip_and_install(e, aghead(e), dumb, 4, sinfo);
 	addEdgeLabels(e);
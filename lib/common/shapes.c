@@ -10,6 +10,7 @@
 
 #include <assert.h>
 #include <cgraph/alloc.h>
+#include <cgraph/tls.h>
 #include <cgraph/unreachable.h>
 #include <common/render.h>
 #include <common/htmltable.h>
@@ -366,9 +367,10 @@ static int same_side(pointf p0, pointf p1, pointf L0, pointf L1)
 static
 char* penColor(GVJ_t * job, node_t * n)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     char *color;
 
-    color = late_nnstring(n, N_color, "");
+    color = late_nnstring(n, lctx->N_color, "");
     if (!color[0])
 	color = DEFAULT_COLOR;
     gvrender_set_pencolor(job, color);
@@ -378,12 +380,13 @@ char* penColor(GVJ_t * job, node_t * n)
 static
 char *findFillDflt(node_t * n, char *dflt)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     char *color;
 
-    color = late_nnstring(n, N_fillcolor, "");
+    color = late_nnstring(n, lctx->N_fillcolor, "");
     if (!color[0]) {
 	/* for backward compatibility, default fill is same as pen */
-	color = late_nnstring(n, N_color, "");
+	color = late_nnstring(n, lctx->N_color, "");
 	if (!color[0]) {
 	    color = dflt;
 	}
@@ -423,12 +426,13 @@ isEllipse(node_t* n)
 
 static char **checkStyle(node_t * n, int *flagp)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     char *style;
     char **pstyle = 0;
     int istyle = 0;
     polygon_t *poly;
 
-    style = late_nnstring(n, N_style, "");
+    style = late_nnstring(n, lctx->N_style, "");
     if (style[0]) {
 	char **pp;
 	char **qp;
@@ -489,6 +493,7 @@ static char **checkStyle(node_t * n, int *flagp)
 
 static int stylenode(GVJ_t * job, node_t * n)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     char **pstyle, *s;
     int istyle;
     double penwidth;
@@ -496,8 +501,8 @@ static int stylenode(GVJ_t * job, node_t * n)
     if ((pstyle = checkStyle(n, &istyle)))
 	gvrender_set_style(job, pstyle);
 
-    if (N_penwidth && (s = agxget(n, N_penwidth)) && s[0]) {
-	penwidth = late_double(n, N_penwidth, 1.0, 0.0);
+    if (lctx->N_penwidth && (s = agxget(n, lctx->N_penwidth)) && s[0]) {
+	penwidth = late_double(n, lctx->N_penwidth, 1.0, 0.0);
 	gvrender_set_penwidth(job, penwidth);
     }
 
@@ -1814,9 +1819,10 @@ void round_corners(GVJ_t * job, pointf * AF, int sides, int style, int filled)
  */
 static double userSize(node_t * n)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     double w, h;
-    w = late_double(n, N_width, 0.0, MIN_NODEWIDTH);
-    h = late_double(n, N_height, 0.0, MIN_NODEHEIGHT);
+    w = late_double(n, lctx->N_width, 0.0, MIN_NODEWIDTH);
+    h = late_double(n, lctx->N_height, 0.0, MIN_NODEHEIGHT);
     return POINTS(MAX(w, h));
 }
 
@@ -1847,6 +1853,7 @@ bool isPolygon(node_t * n)
 
 static void poly_init(node_t * n)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     pointf dimen, min_bb, bb;
     pointf outline_bb;
     point imagesize;
@@ -1894,12 +1901,12 @@ static void poly_init(node_t * n)
 	height = POINTS(ND_height(n));
     }
 
-    peripheries = late_int(n, N_peripheries, peripheries, 0);
-    orientation += late_double(n, N_orientation, 0.0, -360.0);
+    peripheries = late_int(n, lctx->N_peripheries, peripheries, 0);
+    orientation += late_double(n, lctx->N_orientation, 0.0, -360.0);
     if (sides == 0) {		/* not for builtins */
-	skew = late_double(n, N_skew, 0.0, -100.0);
-	sides = late_int(n, N_sides, 4, 0);
-	distortion = late_double(n, N_distortion, 0.0, -100.0);
+	skew = late_double(n, lctx->N_skew, 0.0, -100.0);
+	sides = late_int(n, lctx->N_sides, 4, 0);
+	distortion = late_double(n, lctx->N_distortion, 0.0, -100.0);
     }
 
     /* get label dimensions */
@@ -2023,7 +2030,7 @@ static void poly_init(node_t * n)
     min_bb = bb;
 
     /* increase node size to width/height if needed */
-    fxd = late_string(n, N_fixed, "false");
+    fxd = late_string(n, lctx->N_fixed, "false");
     if (*fxd == 's' && streq(fxd,"shape")) {
 	bb.x = width;
 	bb.y = height;
@@ -2049,7 +2056,7 @@ static void poly_init(node_t * n)
     }
 
     /* Compute space available for label.  Provides the justification borders */
-    if (!mapbool(late_string(n, N_nojustify, "false"))) {
+    if (!mapbool(late_string(n, lctx->N_nojustify, "false"))) {
 	if (isBox) {
 	    ND_label(n)->space.x = MAX(dimen.x,bb.x) - spacex;
 	}
@@ -2070,7 +2077,7 @@ static void poly_init(node_t * n)
 	ND_label(n)->space.y = dimen.y + temp;
     }
 
-    const double penwidth = late_int(n, N_penwidth, DEFAULT_NODEPENWIDTH, MIN_NODEPENWIDTH);
+    const double penwidth = late_int(n, lctx->N_penwidth, DEFAULT_NODEPENWIDTH, MIN_NODEPENWIDTH);
 
     outp = peripheries;
     if (peripheries < 1)
@@ -2326,12 +2333,13 @@ static void poly_free(node_t * n)
  */
 static bool poly_inside(inside_t * inside_context, pointf p)
 {
-    static node_t *lastn;	/* last node argument */
-    static polygon_t *poly;
-    static int last, outp, sides;
-    static pointf O;		/* point (0,0) */
-    static pointf *vertex;
-    static double xsize, ysize, scalex, scaley, box_URx, box_URy;
+    layout_context_t *const lctx = gvLayoutContext();
+    static TLS node_t *lastn;	/* last node argument */
+    static TLS polygon_t *poly;
+    static TLS int last, outp, sides;
+    static TLS pointf O;		/* point (0,0) */
+    static TLS pointf *vertex;
+    static TLS double xsize, ysize, scalex, scaley, box_URx, box_URy;
 
     int i, i1, j, s;
     pointf P, Q, R;
@@ -2400,7 +2408,7 @@ static bool poly_inside(inside_t * inside_context, pointf p)
 	box_URx = n_outline_width / 2.0;
 	box_URy = n_outline_height / 2.0;
 
-	const double penwidth = late_int(n, N_penwidth, DEFAULT_NODEPENWIDTH, MIN_NODEPENWIDTH);
+	const double penwidth = late_int(n, lctx->N_penwidth, DEFAULT_NODEPENWIDTH, MIN_NODEPENWIDTH);
 	if (poly->peripheries >= 1 && penwidth > 0) {
 	    /* index to outline, i.e., the outer-periphery with penwidth taken into account */
 	    outp = (poly->peripheries + 1 - 1) * sides;
@@ -2835,13 +2843,14 @@ static port poly_port(node_t * n, char *portname, char *compass)
 /* generic polygon gencode routine */
 static void poly_gencode(GVJ_t * job, node_t * n)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     obj_state_t *obj = job->obj;
     polygon_t *poly;
     double xsize, ysize;
     int i, j, peripheries, sides, style;
     pointf P, *vertices;
-    static pointf *AF;
-    static int A_size;
+    static TLS pointf *AF;
+    static TLS int A_size;
     int filled;
     bool usershape_p;
     bool pfilled;		/* true if fill not handled by user shape */
@@ -2875,35 +2884,35 @@ static void poly_gencode(GVJ_t * job, node_t * n)
     clrs[0] = NULL;
 
     if (ND_gui_state(n) & GUI_STATE_ACTIVE) {
-	pencolor = late_nnstring(n, N_activepencolor, DEFAULT_ACTIVEPENCOLOR);
+	pencolor = late_nnstring(n, lctx->N_activepencolor, DEFAULT_ACTIVEPENCOLOR);
 	gvrender_set_pencolor(job, pencolor);
 	color =
-	    late_nnstring(n, N_activefillcolor, DEFAULT_ACTIVEFILLCOLOR);
+	    late_nnstring(n, lctx->N_activefillcolor, DEFAULT_ACTIVEFILLCOLOR);
 	gvrender_set_fillcolor(job, color);
 	filled = FILL;
     } else if (ND_gui_state(n) & GUI_STATE_SELECTED) {
 	pencolor =
-	    late_nnstring(n, N_selectedpencolor, DEFAULT_SELECTEDPENCOLOR);
+	    late_nnstring(n, lctx->N_selectedpencolor, DEFAULT_SELECTEDPENCOLOR);
 	gvrender_set_pencolor(job, pencolor);
 	color =
-	    late_nnstring(n, N_selectedfillcolor,
+	    late_nnstring(n, lctx->N_selectedfillcolor,
 			  DEFAULT_SELECTEDFILLCOLOR);
 	gvrender_set_fillcolor(job, color);
 	filled = FILL;
     } else if (ND_gui_state(n) & GUI_STATE_DELETED) {
 	pencolor =
-	    late_nnstring(n, N_deletedpencolor, DEFAULT_DELETEDPENCOLOR);
+	    late_nnstring(n, lctx->N_deletedpencolor, DEFAULT_DELETEDPENCOLOR);
 	gvrender_set_pencolor(job, pencolor);
 	color =
-	    late_nnstring(n, N_deletedfillcolor, DEFAULT_DELETEDFILLCOLOR);
+	    late_nnstring(n, lctx->N_deletedfillcolor, DEFAULT_DELETEDFILLCOLOR);
 	gvrender_set_fillcolor(job, color);
 	filled = FILL;
     } else if (ND_gui_state(n) & GUI_STATE_VISITED) {
 	pencolor =
-	    late_nnstring(n, N_visitedpencolor, DEFAULT_VISITEDPENCOLOR);
+	    late_nnstring(n, lctx->N_visitedpencolor, DEFAULT_VISITEDPENCOLOR);
 	gvrender_set_pencolor(job, pencolor);
 	color =
-	    late_nnstring(n, N_visitedfillcolor, DEFAULT_VISITEDFILLCOLOR);
+	    late_nnstring(n, lctx->N_visitedfillcolor, DEFAULT_VISITEDFILLCOLOR);
 	gvrender_set_fillcolor(job, color);
 	filled = FILL;
     } else {
@@ -2913,9 +2922,9 @@ static void poly_gencode(GVJ_t * job, node_t * n)
 	    if (findStopColor (fillcolor, clrs, &frac)) {
         	gvrender_set_fillcolor(job, clrs[0]);
 		if (clrs[1]) 
-		    gvrender_set_gradient_vals(job,clrs[1],late_int(n,N_gradientangle,0,0), frac);
+		    gvrender_set_gradient_vals(job,clrs[1],late_int(n,lctx->N_gradientangle,0,0), frac);
 		else 
-		    gvrender_set_gradient_vals(job,DEFAULT_COLOR,late_int(n,N_gradientangle,0,0), frac);
+		    gvrender_set_gradient_vals(job,DEFAULT_COLOR,late_int(n,lctx->N_gradientangle,0,0), frac);
 		if (style & RADIAL)
 		    filled = RGRADIENT;
 	 	else
@@ -3027,8 +3036,8 @@ static void poly_gencode(GVJ_t * job, node_t * n)
 	    }
 	}
 	gvrender_usershape(job, name, AF, sides, filled != 0,
-			   late_string(n, N_imagescale, "false"),
-			   late_string(n, N_imagepos, "mc"));
+			   late_string(n, lctx->N_imagescale, "false"),
+			   late_string(n, lctx->N_imagepos, "mc"));
 	filled = 0;		/* with user shapes, we have done the fill if needed */
     }
 
@@ -3053,6 +3062,7 @@ static void poly_gencode(GVJ_t * job, node_t * n)
  */
 static void point_init(node_t * n)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     polygon_t *poly = gv_alloc(sizeof(polygon_t));
     int sides, outp, peripheries = ND_shape(n)->polygon->peripheries;
     double sz;
@@ -3065,8 +3075,8 @@ static void point_init(node_t * n)
      * if both are set, use smallest.
      * if neither, use default
      */
-    w = late_double(n, N_width, MAXDOUBLE, 0.0);
-    h = late_double(n, N_height, MAXDOUBLE, 0.0);
+    w = late_double(n, lctx->N_width, MAXDOUBLE, 0.0);
+    h = late_double(n, lctx->N_height, MAXDOUBLE, 0.0);
     w = MIN(w, h);
     if (w == MAXDOUBLE && h == MAXDOUBLE)	/* neither defined */
 	ND_width(n) = ND_height(n) = DEF_POINT;
@@ -3081,13 +3091,13 @@ static void point_init(node_t * n)
     }
 
     sz = ND_width(n) * POINTS_PER_INCH;
-    peripheries = late_int(n, N_peripheries, peripheries, 0);
+    peripheries = late_int(n, lctx->N_peripheries, peripheries, 0);
     if (peripheries < 1)
 	outp = 1;
     else
 	outp = peripheries;
     sides = 2;
-    const double penwidth = late_int(n, N_penwidth, DEFAULT_NODEPENWIDTH, MIN_NODEPENWIDTH);
+    const double penwidth = late_int(n, lctx->N_penwidth, DEFAULT_NODEPENWIDTH, MIN_NODEPENWIDTH);
     if (peripheries >= 1 && penwidth > 0) {
         // allocate extra vertices representing the outline, i.e., the outermost
         // periphery with penwidth taken into account
@@ -3142,8 +3152,9 @@ static void point_init(node_t * n)
 
 static bool point_inside(inside_t * inside_context, pointf p)
 {
-    static node_t *lastn;	/* last node argument */
-    static double radius;
+    layout_context_t *const lctx = gvLayoutContext();
+    static TLS node_t *lastn;	/* last node argument */
+    static TLS double radius;
     pointf P;
     node_t *n;
 
@@ -3159,7 +3170,7 @@ static bool point_inside(inside_t * inside_context, pointf p)
 	int outp;
 	polygon_t *poly = ND_shape_info(n);
 	const int sides = 2;
-	const double penwidth = late_int(n, N_penwidth, DEFAULT_NODEPENWIDTH, MIN_NODEPENWIDTH);
+	const double penwidth = late_int(n, lctx->N_penwidth, DEFAULT_NODEPENWIDTH, MIN_NODEPENWIDTH);
 
 	if (poly->peripheries >= 1 && penwidth > 0) {
 	    /* index to outline, i.e., the outer-periphery with penwidth taken into account */
@@ -3184,6 +3195,7 @@ static bool point_inside(inside_t * inside_context, pointf p)
 
 static void point_gencode(GVJ_t * job, node_t * n)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     obj_state_t *obj = job->obj;
     polygon_t *poly;
     int i, j, sides, peripheries, style;
@@ -3207,36 +3219,36 @@ static void point_gencode(GVJ_t * job, node_t * n)
 	gvrender_set_style(job, point_style);
     else
 	gvrender_set_style(job, &point_style[1]);
-    if (N_penwidth)
-	gvrender_set_penwidth(job, late_double(n, N_penwidth, 1.0, 0.0));
+    if (lctx->N_penwidth)
+	gvrender_set_penwidth(job, late_double(n, lctx->N_penwidth, 1.0, 0.0));
 
     if (ND_gui_state(n) & GUI_STATE_ACTIVE) {
-	color = late_nnstring(n, N_activepencolor, DEFAULT_ACTIVEPENCOLOR);
+	color = late_nnstring(n, lctx->N_activepencolor, DEFAULT_ACTIVEPENCOLOR);
 	gvrender_set_pencolor(job, color);
 	color =
-	    late_nnstring(n, N_activefillcolor, DEFAULT_ACTIVEFILLCOLOR);
+	    late_nnstring(n, lctx->N_activefillcolor, DEFAULT_ACTIVEFILLCOLOR);
 	gvrender_set_fillcolor(job, color);
     } else if (ND_gui_state(n) & GUI_STATE_SELECTED) {
 	color =
-	    late_nnstring(n, N_selectedpencolor, DEFAULT_SELECTEDPENCOLOR);
+	    late_nnstring(n, lctx->N_selectedpencolor, DEFAULT_SELECTEDPENCOLOR);
 	gvrender_set_pencolor(job, color);
 	color =
-	    late_nnstring(n, N_selectedfillcolor,
+	    late_nnstring(n, lctx->N_selectedfillcolor,
 			  DEFAULT_SELECTEDFILLCOLOR);
 	gvrender_set_fillcolor(job, color);
     } else if (ND_gui_state(n) & GUI_STATE_DELETED) {
 	color =
-	    late_nnstring(n, N_deletedpencolor, DEFAULT_DELETEDPENCOLOR);
+	    late_nnstring(n, lctx->N_deletedpencolor, DEFAULT_DELETEDPENCOLOR);
 	gvrender_set_pencolor(job, color);
 	color =
-	    late_nnstring(n, N_deletedfillcolor, DEFAULT_DELETEDFILLCOLOR);
+	    late_nnstring(n, lctx->N_deletedfillcolor, DEFAULT_DELETEDFILLCOLOR);
 	gvrender_set_fillcolor(job, color);
     } else if (ND_gui_state(n) & GUI_STATE_VISITED) {
 	color =
-	    late_nnstring(n, N_visitedpencolor, DEFAULT_VISITEDPENCOLOR);
+	    late_nnstring(n, lctx->N_visitedpencolor, DEFAULT_VISITEDPENCOLOR);
 	gvrender_set_pencolor(job, color);
 	color =
-	    late_nnstring(n, N_visitedfillcolor, DEFAULT_VISITEDFILLCOLOR);
+	    late_nnstring(n, lctx->N_visitedfillcolor, DEFAULT_VISITEDFILLCOLOR);
 	gvrender_set_fillcolor(job, color);
     } else {
 	color = findFillDflt(n, "black");
@@ -3286,7 +3298,7 @@ static void point_gencode(GVJ_t * job, node_t * n)
 
 #define ISCTRL(c) ((c) == '{' || (c) == '}' || (c) == '|' || (c) == '<' || (c) == '>')
 
-static char *reclblp;
+static TLS char *reclblp;
 
 static void free_field(field_t * f)
 {
@@ -3620,6 +3632,7 @@ static void dumpL(field_t * info, int level)
 /* syntax of labels: foo|bar|baz or foo|(recursive|label)|baz */
 static void record_init(node_t * n)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     field_t *info;
     pointf sz;
     int flip;
@@ -3646,7 +3659,7 @@ static void record_init(node_t * n)
     size_reclbl(n, info);
     sz.x = POINTS(ND_width(n));
     sz.y = POINTS(ND_height(n));
-    if (mapbool(late_string(n, N_fixed, "false"))) {
+    if (mapbool(late_string(n, lctx->N_fixed, "false"))) {
 	if (sz.x < info->size.x || sz.y < info->size.y) {
 /* should check that the record really won't fit, e.g., there may be no text.
 			agerr(AGWARN, "node '%s' size may be too small\n", agnameof(n));
@@ -3657,7 +3670,7 @@ static void record_init(node_t * n)
 	sz.y = MAX(info->size.y, sz.y);
     }
     resize_reclbl(info, sz,
-                  mapbool(late_string(n, N_nojustify, "false")) ? TRUE : FALSE);
+                  mapbool(late_string(n, lctx->N_nojustify, "false")) ? TRUE : FALSE);
     pointf ul = {-sz.x / 2., sz.y / 2.};	/* FIXME - is this still true:    suspected to introduce rounding error - see Kluge below */
     pos_reclbl(info, ul, sides);
     ND_width(n) = PS2INCH(info->size.x);
@@ -3814,6 +3827,7 @@ static void gen_fields(GVJ_t * job, node_t * n, field_t * f)
 
 static void record_gencode(GVJ_t * job, node_t * n)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     obj_state_t *obj = job->obj;
     boxf BF;
     pointf AF[4];
@@ -3844,9 +3858,9 @@ static void record_gencode(GVJ_t * job, node_t * n)
 	if (findStopColor (fillcolor, clrs, &frac)) {
             gvrender_set_fillcolor(job, clrs[0]);
 	    if (clrs[1]) 
-		gvrender_set_gradient_vals(job,clrs[1],late_int(n,N_gradientangle,0,0), frac);
+		gvrender_set_gradient_vals(job,clrs[1],late_int(n,lctx->N_gradientangle,0,0), frac);
 	    else 
-		gvrender_set_gradient_vals(job,DEFAULT_COLOR,late_int(n,N_gradientangle,0,0), frac);
+		gvrender_set_gradient_vals(job,DEFAULT_COLOR,late_int(n,lctx->N_gradientangle,0,0), frac);
 	    if (style & RADIAL)
 		filled = RGRADIENT;
 	    else
@@ -3886,8 +3900,8 @@ static void record_gencode(GVJ_t * job, node_t * n)
     }
 }
 
-static shape_desc **UserShape;
-static int N_UserShape;
+static TLS shape_desc **UserShape;
+static TLS int N_UserShape;
 
 shape_desc *find_user_shape(const char *name)
 {
@@ -4044,11 +4058,12 @@ static void star_vertices (pointf* vertices, pointf* bb)
 
 static bool star_inside(inside_t * inside_context, pointf p)
 {
-    static node_t *lastn;	/* last node argument */
-    static polygon_t *poly;
-    static int outp, sides;
-    static pointf *vertex;
-    static pointf O;		/* point (0,0) */
+    layout_context_t *const lctx = gvLayoutContext();
+    static TLS node_t *lastn;	/* last node argument */
+    static TLS polygon_t *poly;
+    static TLS int outp, sides;
+    static TLS pointf *vertex;
+    static TLS pointf O;		/* point (0,0) */
 
     if (!inside_context) {
 	lastn = NULL;
@@ -4072,7 +4087,7 @@ static bool star_inside(inside_t * inside_context, pointf p)
 	vertex = poly->vertices;
 	sides = poly->sides;
 
-	const double penwidth = late_int(n, N_penwidth, DEFAULT_NODEPENWIDTH, MIN_NODEPENWIDTH);
+	const double penwidth = late_int(n, lctx->N_penwidth, DEFAULT_NODEPENWIDTH, MIN_NODEPENWIDTH);
 	if (poly->peripheries >= 1 && penwidth > 0) {
 	    /* index to outline, i.e., the outer-periphery with penwidth taken into account */
 	    outp = (poly->peripheries + 1 - 1) * sides;
@@ -1233,10 +1233,11 @@ makeSelfEdge(edge_t * edges[], int ind, int cnt, double sizex,
  */
 void makePortLabels(edge_t * e)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     /* Only use this if labelangle or labeldistance is set for the edge;
      * otherwise, handle with external labels.
      */
-    if (!E_labelangle && !E_labeldistance) return;
+    if (!lctx->E_labelangle && !lctx->E_labeldistance) return;
 
     if (ED_head_label(e) && !ED_head_label(e)->set) {
 	if (place_portlabel(e, true))
@@ -1357,6 +1358,7 @@ void addEdgeLabels(edge_t *e) {
  */
 int place_portlabel(edge_t * e, bool head_p)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     textlabel_t *l;
     splines *spl;
     bezier *bez;
@@ -1369,8 +1371,8 @@ int place_portlabel(edge_t * e, bool head_p)
     if (ED_edge_type(e) == IGNORED)
 	return 0;
     /* add label here only if labelangle or labeldistance is defined; else, use external label */
-    if ((!E_labelangle || *(la = AGXGET(e,E_labelangle)) == '\0') &&
-	(!E_labeldistance || *(ld = AGXGET(e,E_labeldistance)) == '\0')) {
+    if ((!lctx->E_labelangle || *(la = AGXGET(e,lctx->E_labelangle)) == '\0') &&
+	(!lctx->E_labeldistance || *(ld = AGXGET(e,lctx->E_labeldistance)) == '\0')) {
 	return 0;
     }
 
@@ -1400,8 +1402,8 @@ int place_portlabel(edge_t * e, bool head_p)
 	}
     }
     angle = atan2(pf.y - pe.y, pf.x - pe.x) +
-	RADIANS(late_double(e, E_labelangle, PORT_LABEL_ANGLE, -180.0));
-    dist = PORT_LABEL_DISTANCE * late_double(e, E_labeldistance, 1.0, 0.0);
+	RADIANS(late_double(e, lctx->E_labelangle, PORT_LABEL_ANGLE, -180.0));
+    dist = PORT_LABEL_DISTANCE * late_double(e, lctx->E_labeldistance, 1.0, 0.0);
     l->pos.x = pe.x + dist * cos(angle);
     l->pos.y = pe.y + dist * sin(angle);
     l->set = true;
@@ -20,6 +20,7 @@
 #include <common/render.h>
 #include <common/textspan_lut.h>
 #include <cgraph/strcasecmp.h>
+#include <cgraph/tls.h>
 
 /* estimate_textspan_size:
  * Estimate size of textspan, for given face and size, in points.
@@ -61,8 +62,8 @@ static int fontcmpf(const void *a, const void *b)
 
 static PostscriptAlias* translate_postscript_fontname(char* fontname)
 {
-    static PostscriptAlias key;
-    static PostscriptAlias *result;
+    static TLS PostscriptAlias key;
+    static TLS PostscriptAlias *result;
 
     if (key.name == NULL || strcasecmp(key.name, fontname)) {
 	free(key.name);
@@ -11,6 +11,7 @@
 #ifndef _WIN32
 
 #include	<sys/types.h>
+#include	<sys/time.h>
 #include	<sys/times.h>
 #include	<sys/param.h>
 
@@ -23,6 +24,13 @@ typedef struct tms mytime_t;
 #define GET_TIME(S) times(&(S))
 #define DIFF_IN_SECS(S,T) ((S.tms_utime + S.tms_stime - T.tms_utime - T.tms_stime)/(double)HZ)
 
+static double wall_time(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (double)tv.tv_sec + (double)tv.tv_usec / 1e6;
+}
+
 #else
 
 #include	<time.h>
@@ -31,12 +39,21 @@ typedef clock_t mytime_t;
 #define GET_TIME(S) S = clock()
 #define DIFF_IN_SECS(S,T) ((S - T) / (double)CLOCKS_PER_SEC)
 
+/* the Windows clock counts real time since the process started */
+static double wall_time(void)
+{
+    return clock() / (double)CLOCKS_PER_SEC;
+}
+
 #endif
 
+#include <cgraph/tls.h>
 #include <common/types.h>
+#include <common/globals.h>
 #include <common/utils.h>
+#include <stdbool.h>
 
-static mytime_t T;
+static TLS mytime_t T;
 
 void start_timer(void)
 {
@@ -52,3 +69,23 @@ double elapsed_sec(void)
     rv = DIFF_IN_SECS(S, T);
     return rv;
 }
+
+/* wall_clock:
+ * Seconds of real time, as opposed to the processor time of elapsed_sec,
+ * since some fixed point. Only differences between values are meaningful.
+ */
+double wall_clock(void)
+{
+    return wall_time();
+}
+
+/* phase_expired:
+ * True if the running layout phase has a deadline and it has passed. The
+ * caller stops with the best answer it has and sets PhaseTruncated.
+ */
+bool phase_expired(void)
+{
+    layout_context_t *const lctx = gvLayoutContext();
+    const double deadline = lctx->PhaseDeadline;
+    return deadline > 0 && wall_clock() >= deadline;
+}
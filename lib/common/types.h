@@ -452,6 +452,7 @@ typedef enum {NATIVEFONTS,PSFONTS,SVGFONTS} fontname_kind;
 	int rank;
 	int order;	/* initially, order = 1 for ordered edges */
 	double mval;
+	bool settled;	/* keeps its order from an earlier layout */
 	elist save_in;
 	elist save_out;
 
@@ -513,6 +514,7 @@ typedef enum {NATIVEFONTS,PSFONTS,SVGFONTS} fontname_kind;
 #define ND_rw(n) (((Agnodeinfo_t*)AGDATA(n))->rw)
 #define ND_save_in(n) (((Agnodeinfo_t*)AGDATA(n))->save_in)
 #define ND_save_out(n) (((Agnodeinfo_t*)AGDATA(n))->save_out)
+#define ND_settled(n) (((Agnodeinfo_t*)AGDATA(n))->settled)
 #define ND_shape(n) (((Agnodeinfo_t*)AGDATA(n))->shape)
 #define ND_shape_info(n) (((Agnodeinfo_t*)AGDATA(n))->shape_info)
 #define ND_showboxes(n) (((Agnodeinfo_t*)AGDATA(n))->showboxes)
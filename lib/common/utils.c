@@ -12,6 +12,7 @@
 #include <cgraph/alloc.h>
 #include <cgraph/agxbuf.h>
 #include <cgraph/strview.h>
+#include <cgraph/tls.h>
 #include <cgraph/tokenize.h>
 #include <common/htmltable.h>
 #include <common/entities.h>
@@ -64,16 +65,17 @@ node_t *dequeue(nodequeue * q)
     return n;
 }
 
+/* The late_* numeric helpers go through cgraph's parsed attribute values, so
+ * an attribute read by several layout phases is only parsed once per object.
+ * The first read of an attribute of a node or edge builds its values for the
+ * whole graph, so it must not be a read made from several threads at once.
+ */
 int late_int(void *obj, attrsym_t *attr, int defaultValue, int minimum) {
     if (attr == NULL)
         return defaultValue;
-    char *p = ag_xget(obj, attr);
-    if (!p || p[0] == '\0')
-        return defaultValue;
-    char *endp;
-    long rv = strtol(p, &endp, 10);
-    if (p == endp || rv > INT_MAX)
-        return defaultValue; /* invalid int format */
+    long rv;
+    if (!agxgetint(obj, attr, &rv) || rv > INT_MAX)
+        return defaultValue; /* empty or invalid int format */
     if (rv < minimum)
         return minimum;
     else return (int)rv;
@@ -83,13 +85,9 @@ double late_double(void *obj, attrsym_t *attr, double defaultValue,
                    double minimum) {
     if (!attr || !obj)
         return defaultValue;
-    char *p = ag_xget(obj, attr);
-    if (!p || p[0] == '\0')
-        return defaultValue;
-    char *endp;
-    double rv = strtod(p, &endp);
-    if (p == endp)
-        return defaultValue; /* invalid double format */
+    double rv;
+    if (!agxgetdouble(obj, attr, &rv))
+        return defaultValue; /* empty or invalid double format */
     if (rv < minimum)
         return minimum;
     else return rv;
@@ -104,7 +102,8 @@ double late_double(void *obj, attrsym_t *attr, double defaultValue,
  * Set but negative values are treated like 0.
  */
 double get_inputscale(graph_t *g) {
-    if (PSinputscale > 0) return PSinputscale;  /* command line flag prevails */
+    layout_context_t *const lctx = gvLayoutContext();
+    if (lctx->PSinputscale > 0) return lctx->PSinputscale;  /* command line flag prevails */
     double d = late_double(g, agfindgraphattr(g, "inputscale"), -1, 0);
     if (d == 0) return POINTS_PER_INCH;
     else return d;
@@ -259,8 +258,8 @@ Agnodeinfo_t* ND_info(node_t * n) { return ((Agnodeinfo_t*)AGDATA(n));}
  */
 char *Fgets(FILE * fp)
 {
-    static size_t bsize = 0;
-    static char *buf;
+    static TLS size_t bsize = 0;
+    static TLS char *buf;
     char *lp;
     size_t len;
 
@@ -317,7 +316,7 @@ static strview_t *mkDirlist(const char *list) {
 }
 
 static char *findPath(const strview_t *dirs, const char *str) {
-    static agxbuf safefilename;
+    static TLS agxbuf safefilename;
 
     for (const strview_t *dp = dirs; dp != NULL && dp->data != NULL; dp++) {
 	agxbprint(&safefilename, "%.*s%s%s", (int)dp->size, dp->data, DIRSEP, str);
@@ -330,9 +329,10 @@ static char *findPath(const strview_t *dirs, const char *str) {
 
 const char *safefile(const char *filename)
 {
-    static bool onetime = true;
-    static char *pathlist = NULL;
-    static strview_t *dirs;
+    layout_context_t *const lctx = gvLayoutContext();
+    static TLS bool onetime = true;
+    static TLS char *pathlist = NULL;
+    static TLS strview_t *dirs;
 
     if (!filename || !filename[0])
 	return NULL;
@@ -347,10 +347,10 @@ const char *safefile(const char *filename)
 	return NULL;
     }
 
-    if (pathlist != Gvimagepath) {
+    if (pathlist != lctx->Gvimagepath) {
 	free (dirs);
 	dirs = NULL;
-	pathlist = Gvimagepath;
+	pathlist = lctx->Gvimagepath;
 	if (pathlist && *pathlist)
 	    dirs = mkDirlist(pathlist);
     }
@@ -458,7 +458,7 @@ pointf spline_at_y(splines * spl, double y)
     int i, j;
     double low, high, d, t;
     pointf c[4], p;
-    static bezier bz;
+    static TLS bezier bz;
 
 /* this caching seems to prevent p.x from getting set from bz.list[0].x
 	- optimizer problem ? */
@@ -532,46 +532,49 @@ struct fontinfo {
 
 void common_init_node(node_t * n)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     struct fontinfo fi;
     char *str;
     ND_width(n) =
-	late_double(n, N_width, DEFAULT_NODEWIDTH, MIN_NODEWIDTH);
+	late_double(n, lctx->N_width, DEFAULT_NODEWIDTH, MIN_NODEWIDTH);
     ND_height(n) =
-	late_double(n, N_height, DEFAULT_NODEHEIGHT, MIN_NODEHEIGHT);
+	late_double(n, lctx->N_height, DEFAULT_NODEHEIGHT, MIN_NODEHEIGHT);
     ND_shape(n) =
-	bind_shape(late_nnstring(n, N_shape, DEFAULT_NODESHAPE), n);
-    str = agxget(n, N_label);
-    fi.fontsize = late_double(n, N_fontsize, DEFAULT_FONTSIZE, MIN_FONTSIZE);
-    fi.fontname = late_nnstring(n, N_fontname, DEFAULT_FONTNAME);
-    fi.fontcolor = late_nnstring(n, N_fontcolor, DEFAULT_COLOR);
+	bind_shape(late_nnstring(n, lctx->N_shape, DEFAULT_NODESHAPE), n);
+    str = agxget(n, lctx->N_label);
+    fi.fontsize = late_double(n, lctx->N_fontsize, DEFAULT_FONTSIZE, MIN_FONTSIZE);
+    fi.fontname = late_nnstring(n, lctx->N_fontname, DEFAULT_FONTNAME);
+    fi.fontcolor = late_nnstring(n, lctx->N_fontcolor, DEFAULT_COLOR);
     ND_label(n) = make_label(n, str,
 	        (aghtmlstr(str) ? LT_HTML : LT_NONE) | ( (shapeOf(n) == SH_RECORD) ? LT_RECD : LT_NONE),
 		fi.fontsize, fi.fontname, fi.fontcolor);
-    if (N_xlabel && (str = agxget(n, N_xlabel)) && str[0]) {
+    if (lctx->N_xlabel && (str = agxget(n, lctx->N_xlabel)) && str[0]) {
 	ND_xlabel(n) = make_label(n, str, aghtmlstr(str) ? LT_HTML : LT_NONE,
 				fi.fontsize, fi.fontname, fi.fontcolor);
 	GD_has_labels(agraphof(n)) |= NODE_XLABEL;
     }
 
-    ND_showboxes(n) = late_int(n, N_showboxes, 0, 0);
+    ND_showboxes(n) = late_int(n, lctx->N_showboxes, 0, 0);
     ND_shape(n)->fns->initfn(n);
 }
 
 static void initFontEdgeAttr(edge_t * e, struct fontinfo *fi)
 {
-    fi->fontsize = late_double(e, E_fontsize, DEFAULT_FONTSIZE, MIN_FONTSIZE);
-    fi->fontname = late_nnstring(e, E_fontname, DEFAULT_FONTNAME);
-    fi->fontcolor = late_nnstring(e, E_fontcolor, DEFAULT_COLOR);
+    layout_context_t *const lctx = gvLayoutContext();
+    fi->fontsize = late_double(e, lctx->E_fontsize, DEFAULT_FONTSIZE, MIN_FONTSIZE);
+    fi->fontname = late_nnstring(e, lctx->E_fontname, DEFAULT_FONTNAME);
+    fi->fontcolor = late_nnstring(e, lctx->E_fontcolor, DEFAULT_COLOR);
 }
 
 static void
 initFontLabelEdgeAttr(edge_t * e, struct fontinfo *fi,
 		      struct fontinfo *lfi)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     if (!fi->fontname) initFontEdgeAttr(e, fi);
-    lfi->fontsize = late_double(e, E_labelfontsize, fi->fontsize, MIN_FONTSIZE);
-    lfi->fontname = late_nnstring(e, E_labelfontname, fi->fontname);
-    lfi->fontcolor = late_nnstring(e, E_labelfontcolor, fi->fontcolor);
+    lfi->fontsize = late_double(e, lctx->E_labelfontsize, fi->fontsize, MIN_FONTSIZE);
+    lfi->fontname = late_nnstring(e, lctx->E_labelfontname, fi->fontname);
+    lfi->fontcolor = late_nnstring(e, lctx->E_labelfontcolor, fi->fontcolor);
 }
 
 /* noClip:
@@ -617,6 +620,7 @@ chkPort (port (*pf)(node_t*, char*, char*), node_t* n, char* s)
 /* return true if edge has label */
 int common_init_edge(edge_t * e)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     char *str;
     int r = 0;
     struct fontinfo fi;
@@ -625,17 +629,17 @@ int common_init_edge(edge_t * e)
 
     fi.fontname = NULL;
     lfi.fontname = NULL;
-    if (E_label && (str = agxget(e, E_label)) && str[0]) {
+    if (lctx->E_label && (str = agxget(e, lctx->E_label)) && str[0]) {
 	r = 1;
 	initFontEdgeAttr(e, &fi);
 	ED_label(e) = make_label(e, str, aghtmlstr(str) ? LT_HTML : LT_NONE,
 				fi.fontsize, fi.fontname, fi.fontcolor);
 	GD_has_labels(sg) |= EDGE_LABEL;
 	ED_label_ontop(e) =
-	    mapbool(late_string(e, E_label_float, "false")) ? TRUE : FALSE;
+	    mapbool(late_string(e, lctx->E_label_float, "false")) ? TRUE : FALSE;
     }
 
-    if (E_xlabel && (str = agxget(e, E_xlabel)) && str[0]) {
+    if (lctx->E_xlabel && (str = agxget(e, lctx->E_xlabel)) && str[0]) {
 	if (!fi.fontname)
 	    initFontEdgeAttr(e, &fi);
 	ED_xlabel(e) = make_label(e, str, aghtmlstr(str) ? LT_HTML : LT_NONE,
@@ -643,13 +647,13 @@ int common_init_edge(edge_t * e)
 	GD_has_labels(sg) |= EDGE_XLABEL;
     }
 
-    if (E_headlabel && (str = agxget(e, E_headlabel)) && str[0]) {
+    if (lctx->E_headlabel && (str = agxget(e, lctx->E_headlabel)) && str[0]) {
 	initFontLabelEdgeAttr(e, &fi, &lfi);
 	ED_head_label(e) = make_label(e, str, aghtmlstr(str) ? LT_HTML : LT_NONE,
 				lfi.fontsize, lfi.fontname, lfi.fontcolor);
 	GD_has_labels(sg) |= HEAD_LABEL;
     }
-    if (E_taillabel && (str = agxget(e, E_taillabel)) && str[0]) {
+    if (lctx->E_taillabel && (str = agxget(e, lctx->E_taillabel)) && str[0]) {
 	if (!lfi.fontname)
 	    initFontLabelEdgeAttr(e, &fi, &lfi);
 	ED_tail_label(e) = make_label(e, str, aghtmlstr(str) ? LT_HTML : LT_NONE,
@@ -667,7 +671,7 @@ int common_init_edge(edge_t * e)
     if (str && str[0])
 	ND_has_port(agtail(e)) = true;
     ED_tail_port(e) = chkPort (ND_shape(agtail(e))->fns->portfn, agtail(e), str);
-    if (noClip(e, E_tailclip))
+    if (noClip(e, lctx->E_tailclip))
 	ED_tail_port(e).clip = false;
     str = agget(e, HEAD_ID);
     /* libgraph always defines tailport/headport; libcgraph doesn't */
@@ -675,7 +679,7 @@ int common_init_edge(edge_t * e)
     if (str && str[0])
 	ND_has_port(aghead(e)) = true;
     ED_head_port(e) = chkPort(ND_shape(aghead(e))->fns->portfn, aghead(e), str);
-    if (noClip(e, E_headclip))
+    if (noClip(e, lctx->E_headclip))
 	ED_head_port(e).clip = false;
 
     return r;
@@ -852,8 +856,9 @@ Agsym_t *setAttr(graph_t * g, void *obj, char *name, char *value,
 static node_t *clustNode(node_t * n, graph_t * cg, agxbuf * xb,
 			 graph_t * clg)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     node_t *cn;
-    static int idx = 0;
+    static TLS int idx = 0;
 
     agxbprint(xb, "__%d:%s", idx++, agnameof(cg));
 
@@ -865,9 +870,9 @@ static node_t *clustNode(node_t * n, graph_t * cg, agxbuf * xb,
 	agsubnode(clg,n,1);
 
     /* set attributes */
-    N_label = setAttr(agraphof(cn), cn, "label", "", N_label);
-    N_style = setAttr(agraphof(cn), cn, "style", "invis", N_style);
-    N_shape = setAttr(agraphof(cn), cn, "shape", "box", N_shape);
+    lctx->N_label = setAttr(agraphof(cn), cn, "label", "", lctx->N_label);
+    lctx->N_style = setAttr(agraphof(cn), cn, "style", "invis", lctx->N_style);
+    lctx->N_shape = setAttr(agraphof(cn), cn, "shape", "box", lctx->N_shape);
 
     return cn;
 }
@@ -1356,8 +1361,8 @@ cvtAndAppend (unsigned char c, agxbuf* xb)
  */
 char* htmlEntityUTF8 (char* s, graph_t* g)
 {
-    static graph_t* lastg;
-    static bool warned;
+    static TLS graph_t* lastg;
+    static TLS bool warned;
     unsigned char c;
     unsigned int v;
 
@@ -1733,15 +1738,6 @@ void gv_nodesize(node_t *n, bool flip) {
     }
 }
 
-#ifndef HAVE_DRAND48
-double drand48(void)
-{
-    double d;
-    d = rand();
-    d = d / RAND_MAX;
-    return d;
-}
-#endif
 typedef struct {
     Dtlink_t link;
     char* name;
@@ -129,13 +129,11 @@ UTILS_API bool is_a_cluster(Agraph_t *g);
 /* from postproc.c */
 UTILS_API void gv_nodesize(Agnode_t *n, bool flip);
 
-#ifndef HAVE_DRAND48
-UTILS_API double drand48(void);
-#endif
-
 /* from timing.c */
 UTILS_API void start_timer(void);
 UTILS_API double elapsed_sec(void);
+UTILS_API double wall_clock(void);
+UTILS_API bool phase_expired(void);
 
 /* from psusershape.c */
 UTILS_API void cat_libfile(GVJ_t *job, const char **arglib,
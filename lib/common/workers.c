@@ -0,0 +1,208 @@
+/*************************************************************************
+ * Copyright (c) 2011 AT&T Intellectual Property
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors: Details at https://graphviz.org
+ *************************************************************************/
+
+#include <cgraph/alloc.h>
+#include <common/types.h>
+#include <common/utils.h>
+#include <common/workers.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+typedef struct {
+  workers_t *pool;
+  size_t index;
+} thread_arg_t;
+
+struct workers_s {
+  size_t n; ///< workers, counting the thread that made the pool
+  workers_fn fn;
+  void *arg;
+  unsigned long generation; ///< jobs started, under lock
+  size_t running;           ///< threads yet to finish this job, under lock
+  bool stop;                ///< under lock
+  thread_arg_t *args;
+#ifdef _WIN32
+  HANDLE *threads;
+  CRITICAL_SECTION lock;
+  CONDITION_VARIABLE start, done;
+#else
+  pthread_t *threads;
+  pthread_mutex_t lock;
+  pthread_cond_t start, done;
+#endif
+};
+
+static void lock(workers_t *w) {
+#ifdef _WIN32
+  EnterCriticalSection(&w->lock);
+#else
+  pthread_mutex_lock(&w->lock);
+#endif
+}
+
+static void unlock(workers_t *w) {
+#ifdef _WIN32
+  LeaveCriticalSection(&w->lock);
+#else
+  pthread_mutex_unlock(&w->lock);
+#endif
+}
+
+#ifdef _WIN32
+#define WAIT(w, cond) SleepConditionVariableCS(&(w)->cond, &(w)->lock, INFINITE)
+#define WAKE_ALL(w, cond) WakeAllConditionVariable(&(w)->cond)
+#define WAKE(w, cond) WakeConditionVariable(&(w)->cond)
+#else
+#define WAIT(w, cond) pthread_cond_wait(&(w)->cond, &(w)->lock)
+#define WAKE_ALL(w, cond) pthread_cond_broadcast(&(w)->cond)
+#define WAKE(w, cond) pthread_cond_signal(&(w)->cond)
+#endif
+
+static void serve(thread_arg_t *a) {
+  workers_t *w = a->pool;
+  unsigned long seen = 0;
+  lock(w);
+  for (;;) {
+    while (!w->stop && w->generation == seen)
+      WAIT(w, start);
+    if (w->stop)
+      break;
+    seen = w->generation;
+    const workers_fn fn = w->fn;
+    void *arg = w->arg;
+    unlock(w);
+    fn(arg, a->index);
+    lock(w);
+    if (--w->running == 0)
+      WAKE(w, done);
+  }
+  unlock(w);
+}
+
+#ifdef _WIN32
+static DWORD WINAPI thread(LPVOID arg) {
+  serve(arg);
+  return 0;
+}
+#else
+static void *thread(void *arg) {
+  serve(arg);
+  return NULL;
+}
+#endif
+
+workers_t *workers_new(size_t n) {
+  workers_t *w = gv_alloc(sizeof(workers_t));
+  w->n = 1;
+  if (n <= 1)
+    return w;
+
+#ifdef _WIN32
+  InitializeCriticalSection(&w->lock);
+  InitializeConditionVariable(&w->start);
+  InitializeConditionVariable(&w->done);
+#else
+  pthread_mutex_init(&w->lock, NULL);
+  pthread_cond_init(&w->start, NULL);
+  pthread_cond_init(&w->done, NULL);
+#endif
+  w->threads = gv_calloc(n, sizeof(w->threads[0]));
+  w->args = gv_calloc(n, sizeof(w->args[0]));
+  for (size_t i = 1; i < n; ++i) {
+    w->args[i] = (thread_arg_t){.pool = w, .index = i};
+#ifdef _WIN32
+    w->threads[i] = CreateThread(NULL, 0, thread, &w->args[i], 0, NULL);
+    if (w->threads[i] == NULL)
+      break;
+#else
+    if (pthread_create(&w->threads[i], NULL, thread, &w->args[i]) != 0)
+      break;
+#endif
+    w->n = i + 1;
+  }
+  return w;
+}
+
+size_t workers_size(const workers_t *w) { return w->n; }
+
+void workers_run(workers_t *w, workers_fn fn, void *arg) {
+  if (w->n == 1) {
+    fn(arg, 0);
+    return;
+  }
+  lock(w);
+  w->fn = fn;
+  w->arg = arg;
+  w->running = w->n - 1;
+  ++w->generation;
+  WAKE_ALL(w, start);
+  unlock(w);
+
+  fn(arg, 0);
+
+  lock(w);
+  while (w->running > 0)
+    WAIT(w, done);
+  unlock(w);
+}
+
+void workers_free(workers_t *w) {
+  if (w == NULL)
+    return;
+  if (w->threads != NULL) {
+    lock(w);
+    w->stop = true;
+    WAKE_ALL(w, start);
+    unlock(w);
+    for (size_t i = 1; i < w->n; ++i) {
+#ifdef _WIN32
+      WaitForSingleObject(w->threads[i], INFINITE);
+      CloseHandle(w->threads[i]);
+#else
+      pthread_join(w->threads[i], NULL);
+#endif
+    }
+#ifdef _WIN32
+    DeleteCriticalSection(&w->lock);
+#else
+    pthread_cond_destroy(&w->done);
+    pthread_cond_destroy(&w->start);
+    pthread_mutex_destroy(&w->lock);
+#endif
+    free(w->threads);
+    free(w->args);
+  }
+  free(w);
+}
+
+size_t workers_processors(void) {
+#ifdef _WIN32
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  return info.dwNumberOfProcessors > 0 ? info.dwNumberOfProcessors : 1;
+#elif defined(_SC_NPROCESSORS_ONLN)
+  const long n = sysconf(_SC_NPROCESSORS_ONLN);
+  return n > 0 ? (size_t)n : 1;
+#else
+  return 1;
+#endif
+}
+
+size_t workers_threads(Agraph_t *g) {
+  const int n = late_int(g, agfindgraphattr(g, "threads"), 1, 0);
+  return n == 0 ? workers_processors() : (size_t)n;
+}
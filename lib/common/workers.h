@@ -0,0 +1,53 @@
+/// @file
+/// @brief a pool of threads running one job at a time
+///
+/// A layout phase that splits a job into parts, runs them at once and then
+/// needs all their results before going on, does so many times in a row. A
+/// pool keeps its threads between jobs, so each job costs a wake up and a wait
+/// rather than starting and joining threads.
+
+#pragma once
+
+#include <cgraph/cgraph.h>
+#include <stddef.h>
+
+#ifdef GVDLL
+#ifdef GVC_EXPORTS
+#define WORKERS_API __declspec(dllexport)
+#else
+#define WORKERS_API __declspec(dllimport)
+#endif
+#endif
+
+#ifndef WORKERS_API
+#define WORKERS_API /* nothing */
+#endif
+
+typedef struct workers_s workers_t;
+
+/// a part of a job, `index` in [0, workers_size(w)) telling which
+typedef void (*workers_fn)(void *arg, size_t index);
+
+/// make a pool of `n` workers, counting the calling thread as the first
+///
+/// Fewer workers are made if threads cannot be started, but always at least
+/// the calling thread.
+WORKERS_API workers_t *workers_new(size_t n);
+
+/// the number of workers in a pool
+WORKERS_API size_t workers_size(const workers_t *w);
+
+/// run `fn(arg, i)` in worker `i` for every worker, returning when all are done
+///
+/// Part 0 runs in the calling thread.
+WORKERS_API void workers_run(workers_t *w, workers_fn fn, void *arg);
+
+/// stop the threads of a pool and free it
+WORKERS_API void workers_free(workers_t *w);
+
+/// the number of processors available, or 1 if it cannot be found
+WORKERS_API size_t workers_processors(void);
+
+/// the number of threads the `threads` attribute of a graph lets its layout
+/// use: 1 if it is not set, or one per processor if it is 0
+WORKERS_API size_t workers_threads(Agraph_t *g);
@@ -11,6 +11,7 @@
 #include <assert.h>
 #include <cgraph/alloc.h>
 #include <cgraph/bitarray.h>
+#include <cgraph/tls.h>
 #include <dotgen/dot.h>
 #include <stddef.h>
 
@@ -45,8 +46,8 @@ typedef struct nodeGroup_t {
     double width, height;
 } nodeGroup_t;
 
-static nodeGroup_t *nodeGroups;
-static int nNodeGroups = 0;
+static TLS nodeGroup_t *nodeGroups;
+static TLS int nNodeGroups = 0;
 
 /* computeNodeGroups:
  * computeNodeGroups function does the groupings of nodes.   
@@ -161,9 +162,9 @@ typedef struct layerWidthInfo_t {
     double height;
 } layerWidthInfo_t;
 
-static layerWidthInfo_t *layerWidthInfo = NULL;
-static int *sortedLayerIndex;
-static int nLayers = 0;
+static TLS layerWidthInfo_t *layerWidthInfo = NULL;
+static TLS int *sortedLayerIndex;
+static TLS int nLayers = 0;
 
 /* computeLayerWidths:
  */
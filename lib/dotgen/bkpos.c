@@ -0,0 +1,699 @@
+/*************************************************************************
+ * Copyright (c) 2011 AT&T Intellectual Property
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors: Details at https://graphviz.org
+ *************************************************************************/
+
+
+/*
+ * Horizontal coordinate assignment after Brandes and Köpf, "Fast and Simple
+ * Horizontal Coordinate Assignment" (Graph Drawing 2001).
+ *
+ * This is an alternative to ranking the auxiliary graph of position.c with
+ * network simplex. Each node of a rank is aligned with the median of its
+ * neighbors on the rank above (or below), preferring to keep long edges
+ * straight, so that aligned nodes form vertical blocks. The blocks are then
+ * placed as far left (or right) as the constraints of the auxiliary graph
+ * allow, which takes one pass over them in topological order. Doing this
+ * for the four combinations of up/down and left/right and taking the median
+ * of the four results for each node gives a balanced layout.
+ *
+ * The constraints are the edges of the auxiliary graph among the nodes of
+ * the ranks and the left and right boundary nodes of clusters, so node
+ * separation, flat edges and cluster containment and separation are honored
+ * as they are with network simplex. Only the edges made by make_edge_pairs,
+ * which give network simplex what it is to minimize, are ignored. Nodes are
+ * only aligned with nodes of the same lowest cluster.
+ *
+ * The median of feasible layouts, taken node by node, is again feasible, so
+ * the only way for this to fail is for an alignment to contradict the
+ * constraints. The caller then falls back to network simplex.
+ */
+
+#include <cgraph/alloc.h>
+#include <dotgen/dot.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define REFINE_PASSES 4
+
+/* a neighbor on the next rank up or down, through fast edge edge */
+typedef struct {
+    int pos;
+    int edge;
+} nbr_t;
+
+typedef struct {
+    int n;		/* nodes: those of the ranks, then ln and rn nodes */
+    int n_ranked;	/* how many of them are in ranks */
+    node_t **node;
+    int *layer;		/* rank of each node, or INT_MIN */
+    int *pos;		/* place in its rank */
+
+    int n_edges;	/* fast edges between adjacent ranks */
+    int *tail, *head;
+    int *dx;		/* x(head) - x(tail) that would make the edge straight */
+    int *weight;
+    bool *marked;	/* crosses an inner segment */
+    int *up_start, *down_start;
+    nbr_t *up, *down;	/* neighbors above and below, in order */
+
+    int n_cons;		/* constraints x(chead) - x(ctail) >= cmin */
+    int *ctail, *chead, *cmin;
+
+    int *root, *align, *off;	/* alignment being placed */
+    int *bstart, *bhead, *bmin, *indeg, *order;	/* block graph */
+} bk_t;
+
+static int cmpnbr(const void *x, const void *y)
+{
+    const nbr_t *a = x, *b = y;
+    if (a->pos < b->pos)
+	return -1;
+    if (a->pos > b->pos)
+	return 1;
+    return 0;
+}
+
+static bool is_virtual(bk_t * bk, int v)
+{
+    return v < bk->n_ranked && ND_node_type(bk->node[v]) == VIRTUAL;
+}
+
+/* add_cluster_nodes:
+ * Number the boundary nodes of g and its clusters.
+ */
+static void add_cluster_nodes(bk_t * bk, graph_t * g)
+{
+    node_t *ends[] = {GD_ln(g), GD_rn(g)};
+
+    for (int c = 1; c <= GD_n_cluster(g); c++)
+	add_cluster_nodes(bk, GD_clust(g)[c]);
+    for (size_t i = 0; i < sizeof(ends) / sizeof(ends[0]); i++) {
+	node_t *v = ends[i];
+	if (v == NULL || ND_rank(v) >= 0)
+	    continue;
+	ND_rank(v) = bk->n;
+	bk->node[bk->n] = v;
+	bk->layer[bk->n] = INT_MIN;
+	bk->pos[bk->n] = 0;
+	bk->n++;
+    }
+}
+
+/* count_cluster_nodes:
+ * How many boundary nodes g and its clusters can have.
+ */
+static size_t count_cluster_nodes(graph_t * g)
+{
+    size_t n = 2;
+
+    for (int c = 1; c <= GD_n_cluster(g); c++)
+	n += count_cluster_nodes(GD_clust(g)[c]);
+    return n;
+}
+
+/* neighbors:
+ * Build the lists of neighbors above and below each ranked node, sorted by
+ * their place in their rank.
+ */
+static void neighbors(bk_t * bk)
+{
+    int n = bk->n_ranked;
+    edge_t *e;
+
+    bk->up_start = gv_calloc((size_t)n + 1, sizeof(int));
+    bk->down_start = gv_calloc((size_t)n + 1, sizeof(int));
+    for (int v = 0; v < n; v++) {
+	node_t *u = bk->node[v];
+	if (ND_save_out(u).list == NULL)
+	    continue;
+	for (int i = 0; (e = ND_save_out(u).list[i]); i++) {
+	    int h = ND_rank(aghead(e));
+	    if (h < 0 || h >= n || bk->layer[h] != bk->layer[v] + 1)
+		continue;
+	    bk->down_start[v + 1]++;
+	    bk->up_start[h + 1]++;
+	    bk->n_edges++;
+	}
+    }
+    for (int v = 0; v < n; v++) {
+	bk->up_start[v + 1] += bk->up_start[v];
+	bk->down_start[v + 1] += bk->down_start[v];
+    }
+
+    size_t m = (size_t)bk->n_edges;
+    bk->tail = gv_calloc(m, sizeof(int));
+    bk->head = gv_calloc(m, sizeof(int));
+    bk->dx = gv_calloc(m, sizeof(int));
+    bk->weight = gv_calloc(m, sizeof(int));
+    bk->marked = gv_calloc(m, sizeof(bool));
+    bk->up = gv_calloc(m, sizeof(nbr_t));
+    bk->down = gv_calloc(m, sizeof(nbr_t));
+    int *up_fill = gv_calloc((size_t)n, sizeof(int));
+    int *down_fill = gv_calloc((size_t)n, sizeof(int));
+    int k = 0;
+    for (int v = 0; v < n; v++) {
+	node_t *u = bk->node[v];
+	if (ND_save_out(u).list == NULL)
+	    continue;
+	for (int i = 0; (e = ND_save_out(u).list[i]); i++) {
+	    int h = ND_rank(aghead(e));
+	    if (h < 0 || h >= n || bk->layer[h] != bk->layer[v] + 1)
+		continue;
+	    bk->tail[k] = v;
+	    bk->head[k] = h;
+	    bk->dx[k] = ROUND(ED_tail_port(e).p.x - ED_head_port(e).p.x);
+	    bk->weight[k] = ED_weight(e);
+	    bk->down[bk->down_start[v] + down_fill[v]++] =
+		(nbr_t){.pos = bk->pos[h], .edge = k};
+	    bk->up[bk->up_start[h] + up_fill[h]++] =
+		(nbr_t){.pos = bk->pos[v], .edge = k};
+	    k++;
+	}
+    }
+    free(up_fill);
+    free(down_fill);
+    for (int v = 0; v < n; v++) {
+	qsort(bk->up + bk->up_start[v], (size_t)(bk->up_start[v + 1] -
+		bk->up_start[v]), sizeof(nbr_t), cmpnbr);
+	qsort(bk->down + bk->down_start[v], (size_t)(bk->down_start[v + 1] -
+		bk->down_start[v]), sizeof(nbr_t), cmpnbr);
+    }
+}
+
+/* constraints:
+ * Collect the edges of the auxiliary graph between numbered nodes.
+ */
+static void constraints(bk_t * bk)
+{
+    edge_t *e;
+    size_t size = 0;
+
+    for (int v = 0; v < bk->n; v++)
+	for (int i = 0; (e = ND_out(bk->node[v]).list[i]); i++)
+	    size++;
+    bk->ctail = gv_calloc(size, sizeof(int));
+    bk->chead = gv_calloc(size, sizeof(int));
+    bk->cmin = gv_calloc(size, sizeof(int));
+    for (int v = 0; v < bk->n; v++)
+	for (int i = 0; (e = ND_out(bk->node[v]).list[i]); i++) {
+	    int h = ND_rank(aghead(e));
+	    if (h < 0)
+		continue;
+	    bk->ctail[bk->n_cons] = v;
+	    bk->chead[bk->n_cons] = h;
+	    bk->cmin[bk->n_cons] = ED_minlen(e);
+	    bk->n_cons++;
+	}
+}
+
+/* mark_conflicts:
+ * Mark the edges between layers that cross an inner segment, an edge
+ * between two virtual nodes, so the alignments keep long edges straight.
+ */
+static void mark_conflicts(bk_t * bk, graph_t * g)
+{
+    rank_t *rank = GD_rank(g);
+
+    for (int r = GD_minrank(g); r < GD_maxrank(g); r++) {
+	int n0 = rank[r].n, n1 = rank[r + 1].n;
+	int k0 = 0, l = 0;
+	for (int l1 = 0; l1 < n1; l1++) {
+	    int v = ND_rank(rank[r + 1].v[l1]);
+	    int inner = -1;
+	    if (is_virtual(bk, v))
+		for (int i = bk->up_start[v]; i < bk->up_start[v + 1]; i++)
+		    if (is_virtual(bk, bk->tail[bk->up[i].edge])) {
+			inner = bk->up[i].pos;
+			break;
+		    }
+	    if (l1 < n1 - 1 && inner < 0)
+		continue;
+	    int k1 = inner >= 0 ? inner : n0 - 1;
+	    for (; l <= l1; l++) {
+		int w = ND_rank(rank[r + 1].v[l]);
+		for (int i = bk->up_start[w]; i < bk->up_start[w + 1]; i++) {
+		    int edge = bk->up[i].edge;
+		    if ((bk->up[i].pos < k0 || bk->up[i].pos > k1)
+			&& !(is_virtual(bk, w)
+			     && is_virtual(bk, bk->tail[edge])))
+			bk->marked[edge] = true;
+		}
+	    }
+	    k0 = k1;
+	}
+    }
+}
+
+/* align:
+ * Align each node with a median neighbor on the previous rank, going down
+ * the ranks if down, else up, and along each rank from the left if left,
+ * else from the right.
+ */
+static void align(bk_t * bk, graph_t * g, bool down, bool left, bool blocks)
+{
+    rank_t *rank = GD_rank(g);
+    int *root = bk->root, *align = bk->align, *off = bk->off;
+    int *start = down ? bk->up_start : bk->down_start;
+    nbr_t *nbr = down ? bk->up : bk->down;
+
+    for (int v = 0; v < bk->n; v++) {
+	root[v] = align[v] = v;
+	off[v] = 0;
+    }
+    if (!blocks)
+	return;
+    for (int i = 1; i <= GD_maxrank(g) - GD_minrank(g); i++) {
+	int r = down ? GD_minrank(g) + i : GD_maxrank(g) - i;
+	int n = rank[r].n;
+	int last = left ? -1 : INT_MAX;
+	for (int j = 0; j < n; j++) {
+	    int v = ND_rank(rank[r].v[left ? j : n - 1 - j]);
+	    int d = start[v + 1] - start[v];
+	    if (d == 0)
+		continue;
+	    int m[] = {(d - 1) / 2, d / 2};
+	    for (int k = 0; k < 2; k++) {
+		if (k == 1 && m[1] == m[0])
+		    break;
+		if (align[v] != v)
+		    break;
+		nbr_t *um = &nbr[start[v] + m[left ? k : 1 - k]];
+		int edge = um->edge;
+		int u = down ? bk->tail[edge] : bk->head[edge];
+		if (bk->marked[edge])
+		    continue;
+		if (left ? last >= um->pos : last <= um->pos)
+		    continue;
+		if (ND_clust(bk->node[u]) != ND_clust(bk->node[v]))
+		    continue;
+		align[u] = v;
+		root[v] = root[u];
+		align[v] = root[v];
+		off[v] = off[u] + (down ? bk->dx[edge] : -bk->dx[edge]);
+		last = um->pos;
+	    }
+	}
+    }
+}
+
+/* place:
+ * Place the blocks of the alignment as far left, or right, as the
+ * constraints allow, and store the nodes' coordinates in x.
+ * Returns false if the alignment contradicts the constraints.
+ */
+static bool place(bk_t * bk, bool left, int *x)
+{
+    int n = bk->n;
+    int *root = bk->root, *off = bk->off;
+    int *bstart = bk->bstart, *indeg = bk->indeg, *order = bk->order;
+
+    for (int v = 0; v <= n; v++)
+	bstart[v] = 0;
+    for (int v = 0; v < n; v++)
+	indeg[v] = 0;
+    for (int i = 0; i < bk->n_cons; i++) {
+	int a = bk->ctail[i], b = bk->chead[i];
+	if (root[a] == root[b]) {
+	    if (bk->cmin[i] + off[a] - off[b] > 0)
+		return false;
+	    continue;
+	}
+	bstart[root[a] + 1]++;
+	indeg[root[b]]++;
+    }
+    for (int v = 0; v < n; v++)
+	bstart[v + 1] += bstart[v];
+    for (int i = 0; i < bk->n_cons; i++) {
+	int a = bk->ctail[i], b = bk->chead[i];
+	if (root[a] == root[b])
+	    continue;
+	int k = bstart[root[a]]++;
+	bk->bhead[k] = root[b];
+	bk->bmin[k] = bk->cmin[i] + off[a] - off[b];
+    }
+    for (int v = n; v > 0; v--)
+	bstart[v] = bstart[v - 1];
+    bstart[0] = 0;
+
+    /* topological order of the blocks */
+    int n_order = 0, n_blocks = 0;
+    for (int v = 0; v < n; v++)
+	if (root[v] == v) {
+	    n_blocks++;
+	    if (indeg[v] == 0)
+		order[n_order++] = v;
+	}
+    for (int i = 0; i < n_order; i++) {
+	int b = order[i];
+	for (int k = bstart[b]; k < bstart[b + 1]; k++)
+	    if (--indeg[bk->bhead[k]] == 0)
+		order[n_order++] = bk->bhead[k];
+    }
+    if (n_order < n_blocks)
+	return false;
+
+    if (left) {
+	for (int i = 0; i < n_order; i++)
+	    x[order[i]] = 0;
+	for (int i = 0; i < n_order; i++) {
+	    int b = order[i];
+	    for (int k = bstart[b]; k < bstart[b + 1]; k++) {
+		int h = bk->bhead[k];
+		x[h] = MAX(x[h], x[b] + bk->bmin[k]);
+	    }
+	}
+    } else {
+	for (int i = n_order - 1; i >= 0; i--) {
+	    int b = order[i];
+	    x[b] = 0;
+	    for (int k = bstart[b]; k < bstart[b + 1]; k++)
+		x[b] = MIN(x[b], x[bk->bhead[k]] - bk->bmin[k]);
+	}
+    }
+    for (int v = 0; v < n; v++)
+	if (root[v] != v)
+	    x[v] = x[root[v]] + off[v];
+    return true;
+}
+
+static int cmpint(const void *x, const void *y)
+{
+    const int *a = x, *b = y;
+    if (*a < *b)
+	return -1;
+    if (*a > *b)
+	return 1;
+    return 0;
+}
+
+/* balance:
+ * Combine the four layouts into x. Each is first moved to line up with the
+ * narrowest, the left ones on its left side and the right ones on its
+ * right side, then each node gets the mean of its two median coordinates.
+ */
+static void balance(int n, int *xs[4], int *x)
+{
+    int lo[4], hi[4], best = 0;
+
+    for (int k = 0; k < 4; k++) {
+	lo[k] = INT_MAX;
+	hi[k] = INT_MIN;
+	for (int v = 0; v < n; v++) {
+	    lo[k] = MIN(lo[k], xs[k][v]);
+	    hi[k] = MAX(hi[k], xs[k][v]);
+	}
+	if (hi[k] - lo[k] < hi[best] - lo[best])
+	    best = k;
+    }
+    int least = INT_MAX;
+    for (int k = 0; k < 4; k++) {
+	/* layouts 0 and 2 are the left ones */
+	int shift = k % 2 == 0 ? lo[best] - lo[k] : hi[best] - hi[k];
+	for (int v = 0; v < n; v++) {
+	    xs[k][v] += shift;
+	    least = MIN(least, xs[k][v]);
+	}
+    }
+    for (int v = 0; v < n; v++) {
+	int c[4];
+	for (int k = 0; k < 4; k++)
+	    c[k] = xs[k][v] - least;
+	qsort(c, 4, sizeof(int), cmpint);
+	x[v] = (c[1] + c[2]) / 2;
+    }
+}
+
+typedef struct {
+    int x;
+    int weight;
+} target_t;
+
+static int cmptarget(const void *x, const void *y)
+{
+    const target_t *a = x, *b = y;
+    if (a->x < b->x)
+	return -1;
+    if (a->x > b->x)
+	return 1;
+    return 0;
+}
+
+/* refine:
+ * Sweep the ranks down and up, passes times in all, moving each node to the
+ * weighted median of where its edges would be straight, as far as its
+ * constraints allow with the others where they are. Each move shortens the
+ * edges of the node, in the weighted sum network simplex minimizes, or
+ * leaves them be, and keeps the layout feasible.
+ */
+static void refine(bk_t * bk, graph_t * g, int *x, int passes)
+{
+    rank_t *rank = GD_rank(g);
+    int n = bk->n;
+    int *in_start = gv_calloc((size_t)n + 1, sizeof(int));
+    int *out_start = gv_calloc((size_t)n + 1, sizeof(int));
+    int *in = gv_calloc((size_t)bk->n_cons, sizeof(int));
+    int *out = gv_calloc((size_t)bk->n_cons, sizeof(int));
+    size_t size = 1;
+
+    for (int c = 0; c < bk->n_cons; c++) {
+	in_start[bk->chead[c] + 1]++;
+	out_start[bk->ctail[c] + 1]++;
+    }
+    for (int v = 0; v < n; v++) {
+	in_start[v + 1] += in_start[v];
+	out_start[v + 1] += out_start[v];
+    }
+    for (int c = 0; c < bk->n_cons; c++) {
+	in[in_start[bk->chead[c]]++] = c;
+	out[out_start[bk->ctail[c]]++] = c;
+    }
+    for (int v = n; v > 0; v--) {
+	in_start[v] = in_start[v - 1];
+	out_start[v] = out_start[v - 1];
+    }
+    in_start[0] = out_start[0] = 0;
+    for (int v = 0; v < bk->n_ranked; v++) {
+	size_t d = (size_t)(bk->up_start[v + 1] - bk->up_start[v] +
+			    bk->down_start[v + 1] - bk->down_start[v]);
+	size = MAX(size, d);
+    }
+    target_t *t = gv_calloc(size, sizeof(target_t));
+
+    for (int pass = 0; pass < passes; pass++) {
+	bool down = pass % 2 == 0;
+	for (int i = 0; i <= GD_maxrank(g) - GD_minrank(g); i++) {
+	    int r = down ? GD_minrank(g) + i : GD_maxrank(g) - i;
+	    for (int j = 0; j < rank[r].n; j++) {
+		int v = ND_rank(rank[r].v[j]);
+		int nt = 0, total = 0;
+		for (int k = bk->up_start[v]; k < bk->up_start[v + 1]; k++) {
+		    int edge = bk->up[k].edge;
+		    t[nt++] = (target_t){x[bk->tail[edge]] + bk->dx[edge],
+					 bk->weight[edge]};
+		}
+		for (int k = bk->down_start[v]; k < bk->down_start[v + 1]; k++) {
+		    int edge = bk->down[k].edge;
+		    t[nt++] = (target_t){x[bk->head[edge]] - bk->dx[edge],
+					 bk->weight[edge]};
+		}
+		for (int k = 0; k < nt; k++)
+		    total += t[k].weight;
+		if (total == 0)
+		    continue;
+		qsort(t, (size_t)nt, sizeof(target_t), cmptarget);
+
+		/* the weighted medians are [lo, hi]; stay put if in it */
+		int k = 0, sum = t[0].weight;
+		while (2 * sum < total)
+		    sum += t[++k].weight;
+		int lo = t[k].x, hi = t[k].x;
+		if (2 * sum == total && k + 1 < nt)
+		    hi = t[k + 1].x;
+		int want = MIN(MAX(x[v], lo), hi);
+
+		for (int c = in_start[v]; c < in_start[v + 1]; c++)
+		    want = MAX(want, x[bk->ctail[in[c]]] + bk->cmin[in[c]]);
+		for (int c = out_start[v]; c < out_start[v + 1]; c++)
+		    want = MIN(want, x[bk->chead[out[c]]] - bk->cmin[out[c]]);
+		x[v] = want;
+	    }
+	}
+    }
+    free(t);
+    free(in);
+    free(out);
+    free(in_start);
+    free(out_start);
+}
+
+/* length:
+ * The weighted sum of how far the edges between ranks are from vertical,
+ * as network simplex would count it.
+ */
+static double length(bk_t * bk, int *x)
+{
+    double sum = 0;
+
+    for (int e = 0; e < bk->n_edges; e++)
+	sum += (double)bk->weight[e] *
+	    abs(x[bk->head[e]] - x[bk->tail[e]] - bk->dx[e]);
+    return sum;
+}
+
+/* coords:
+ * Lay out the nodes into x, from the four alignments if blocks, else from
+ * the nodes packed left and right. Returns false if that cannot be done.
+ */
+static bool coords(bk_t * bk, graph_t * g, bool blocks, int *xs[4], int *x)
+{
+    for (int k = 0; k < 4; k++) {
+	bool down = k < 2, left = k % 2 == 0;
+	if (!blocks && !down) {
+	    /* up and down are the same without blocks */
+	    memcpy(xs[k], xs[k - 2], (size_t)bk->n * sizeof(int));
+	    continue;
+	}
+	align(bk, g, down, left, blocks);
+	if (!place(bk, left, xs[k]))
+	    return false;
+    }
+    balance(bk->n, xs, x);
+    refine(bk, g, x, REFINE_PASSES);
+    for (int c = 0; c < bk->n_cons; c++)
+	if (x[bk->chead[c]] - x[bk->ctail[c]] < bk->cmin[c])
+	    return false;
+    return true;
+}
+
+static void free_bk(bk_t * bk)
+{
+    free(bk->node);
+    free(bk->layer);
+    free(bk->pos);
+    free(bk->tail);
+    free(bk->head);
+    free(bk->dx);
+    free(bk->weight);
+    free(bk->marked);
+    free(bk->up_start);
+    free(bk->down_start);
+    free(bk->up);
+    free(bk->down);
+    free(bk->ctail);
+    free(bk->chead);
+    free(bk->cmin);
+    free(bk->root);
+    free(bk->align);
+    free(bk->off);
+    free(bk->bstart);
+    free(bk->bhead);
+    free(bk->bmin);
+    free(bk->indeg);
+    free(bk->order);
+}
+
+/* dot_bk_position:
+ * Set ND_rank, the x coordinate, of the nodes of the ranks of g and of the
+ * boundary nodes of its clusters, from the constraints of the auxiliary
+ * graph built by create_aux_edges. Other nodes of the auxiliary graph are
+ * left alone. Returns non-zero, leaving ND_rank as it was, if the
+ * coordinates cannot be found this way.
+ */
+int dot_bk_position(graph_t * g)
+{
+    rank_t *rank = GD_rank(g);
+    bk_t bk = {0};
+    node_t *n;
+    int rv = 1;
+
+    if (Verbose)
+	start_timer();
+
+    /* number the nodes, keeping their ranks to restore on failure */
+    size_t size = 0;
+    for (int r = GD_minrank(g); r <= GD_maxrank(g); r++)
+	size += (size_t)rank[r].n;
+    size += count_cluster_nodes(g);
+    bk.node = gv_calloc(size, sizeof(node_t *));
+    bk.layer = gv_calloc(size, sizeof(int));
+    bk.pos = gv_calloc(size, sizeof(int));
+    size_t n_all = 0;
+    for (n = GD_nlist(g); n; n = ND_next(n))
+	n_all++;
+    int *saved = gv_calloc(n_all, sizeof(int));
+    size_t i = 0;
+    for (n = GD_nlist(g); n; n = ND_next(n)) {
+	saved[i++] = ND_rank(n);
+	ND_rank(n) = -1;
+    }
+    for (int r = GD_minrank(g); r <= GD_maxrank(g); r++)
+	for (int j = 0; j < rank[r].n; j++) {
+	    n = rank[r].v[j];
+	    ND_rank(n) = bk.n;
+	    bk.node[bk.n] = n;
+	    bk.layer[bk.n] = r;
+	    bk.pos[bk.n] = j;
+	    bk.n++;
+	}
+    bk.n_ranked = bk.n;
+    add_cluster_nodes(&bk, g);
+
+    neighbors(&bk);
+    constraints(&bk);
+    mark_conflicts(&bk, g);
+
+    size_t nn = (size_t)bk.n;
+    bk.root = gv_calloc(nn, sizeof(int));
+    bk.align = gv_calloc(nn, sizeof(int));
+    bk.off = gv_calloc(nn, sizeof(int));
+    bk.bstart = gv_calloc(nn + 1, sizeof(int));
+    bk.bhead = gv_calloc((size_t)bk.n_cons, sizeof(int));
+    bk.bmin = gv_calloc((size_t)bk.n_cons, sizeof(int));
+    bk.indeg = gv_calloc(nn, sizeof(int));
+    bk.order = gv_calloc(nn, sizeof(int));
+    int *xs[4];
+    for (int k = 0; k < 4; k++)
+	xs[k] = gv_calloc(nn, sizeof(int));
+    int *x = gv_calloc(nn, sizeof(int));
+
+    /* with the alignments, and with each node on its own */
+    int *y = gv_calloc(nn, sizeof(int));
+    bool aligned = coords(&bk, g, true, xs, x);
+    bool packed = coords(&bk, g, false, xs, y);
+    if (packed && (!aligned || length(&bk, y) < length(&bk, x))) {
+	int *t = x;
+	x = y;
+	y = t;
+	aligned = false;
+    }
+    free(y);
+
+    i = 0;
+    for (n = GD_nlist(g); n; n = ND_next(n))
+	ND_rank(n) = saved[i++];
+    if (aligned || packed) {
+	for (int v = 0; v < bk.n; v++)
+	    ND_rank(bk.node[v]) = x[v];
+	rv = 0;
+    }
+    if (Verbose)
+	fprintf(stderr, "Brandes-Koepf: %d nodes %d constraints %s %.2f sec\n",
+		bk.n, bk.n_cons, aligned ? "aligned" : packed ? "packed" :
+		"failed", elapsed_sec());
+
+    for (int k = 0; k < 4; k++)
+	free(xs[k]);
+    free(x);
+    free(saved);
+    free_bk(&bk);
+    return rv;
+}
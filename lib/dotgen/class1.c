@@ -19,9 +19,10 @@
 
 int nonconstraint_edge(edge_t * e)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     char *constr;
 
-    if (E_constr && (constr = agxget(e, E_constr))) {
+    if (lctx->E_constr && (constr = agxget(e, lctx->E_constr))) {
 	if (constr[0] && !mapbool(constr))
 	    return TRUE;
     }
@@ -11,6 +11,7 @@
 
 /* classify edges for mincross/nodepos/splines, using given ranks */
 
+#include <cgraph/exit.h>
 #include <dotgen/dot.h>
 #include <stdbool.h>
 
@@ -160,9 +161,11 @@ int mergeable(edge_t * e, edge_t * f)
 
 void class2(graph_t * g)
 {
-    int c;
+    layout_context_t *const lctx = gvLayoutContext();
+    int c, i, j, k;
     node_t *n, *t, *h;
     edge_t *e, *prev, *opp;
+    const Agcsr_t *csr;
 
     GD_nlist(g) = NULL;
 
@@ -171,21 +174,28 @@ void class2(graph_t * g)
     mark_clusters(g);
     for (c = 1; c <= GD_n_cluster(g); c++)
 	build_skeleton(g, GD_clust(g)[c]);
-    for (n = agfstnode(g); n; n = agnxtnode(g, n))
-	for (e = agfstout(g, n); e; e = agnxtout(g, e)) {
-	    if (ND_weight_class(aghead(e)) <= 2)
-		ND_weight_class(aghead(e))++;
-	    if (ND_weight_class(agtail(e)) <= 2)
-		ND_weight_class(agtail(e))++;
-	}
 
-    for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
+    /* the nodes and out edges of g, in sequence */
+    if (!(csr = agcsr(g)))
+	graphviz_exit(EXIT_FAILURE);
+
+    for (k = 0; k < csr->nedges; k++) {
+	e = csr->outedge[k];
+	if (ND_weight_class(aghead(e)) <= 2)
+	    ND_weight_class(aghead(e))++;
+	if (ND_weight_class(agtail(e)) <= 2)
+	    ND_weight_class(agtail(e))++;
+    }
+
+    for (i = 0; i < csr->nnodes; i++) {
+	n = csr->node[i];
 	if (ND_clust(n) == NULL && n == UF_find(n)) {
 	    fast_node(g, n);
 	    GD_n_nodes(g)++;
 	}
 	prev = NULL;
-	for (e = agfstout(g, n); e; e = agnxtout(g, e)) {
+	for (k = csr->out[i]; k < csr->out[i + 1]; k++) {
+	    e = csr->outedge[k];
 
 	    /* already processed */
 	    if (ED_to_virt(e)) {
@@ -220,7 +230,7 @@ void class2(graph_t * g)
 		}
 		if (ED_label(e) == NULL && ED_label(prev) == NULL
 		    && ports_eq(e, prev)) {
-		    if (Concentrate)
+		    if (lctx->Concentrate)
 			ED_edge_type(e) = IGNORED;
 		    else {
 			merge_chain(g, e, ED_to_virt(prev), true);
@@ -265,7 +275,9 @@ void class2(graph_t * g)
 	    /* backward edges */
 	    else {
 		/* avoid when opp==e in undirected graph */
-		for (opp = agfstout(g, aghead(e)); opp != NULL; opp = agnxtout(g, opp)) {
+		const int hi = csr->head[k];
+		for (j = csr->out[hi]; j < csr->out[hi + 1]; j++) {
+		    opp = csr->outedge[j];
 		    if (aghead(opp) != agtail(e) || aghead(opp) == aghead(e) ||
 		        ED_edge_type(opp) == IGNORED) {
 			continue;
@@ -275,7 +287,7 @@ void class2(graph_t * g)
 			make_chain(g, agtail(opp), aghead(opp), opp);
 		    if (ED_label(e) == NULL && ED_label(opp) == NULL
 			&& ports_eq(e, opp)) {
-			if (Concentrate) {
+			if (lctx->Concentrate) {
 			    ED_edge_type(e) = IGNORED;
 			    ED_conc_opp_flag(opp) = true;
 			} else {	/* see above.  this is getting out of hand */
@@ -285,7 +297,7 @@ void class2(graph_t * g)
 			break;
 		    }
 		}
-		if (opp != NULL) {
+		if (j < csr->out[hi + 1]) {
 		    continue;
 		}
 		make_chain(g, aghead(e), agtail(e), e);
@@ -293,6 +305,7 @@ void class2(graph_t * g)
 	    }
 	}
     }
+    agcsrfree(g);
     /* since decompose() is not called on subgraphs */
     if (g != dot_root(g)) {
 	GD_comp(g).list = ALLOC(1, GD_comp(g).list, node_t *);
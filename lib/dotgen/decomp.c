@@ -18,12 +18,13 @@
  */
 
 #include <cgraph/stack.h>
+#include <cgraph/tls.h>
 #include <dotgen/dot.h>
 #include <stddef.h>
 #include <stdint.h>
 
-static node_t *Last_node;
-static size_t Cmark;
+static TLS node_t *Last_node;
+static TLS size_t Cmark;
 
 static void 
 begin_component(graph_t* g)
@@ -16,6 +16,7 @@
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <stdio.h>
 
 static void
 dot_init_subg(graph_t * g, graph_t* droot)
@@ -50,13 +51,14 @@ dot_init_node(node_t * n)
 static void 
 dot_init_edge(edge_t * e)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     char *tailgroup, *headgroup;
     agbindrec(e, "Agedgeinfo_t", sizeof(Agedgeinfo_t), true);	//graph custom data
     common_init_edge(e);
 
-    ED_weight(e) = late_int(e, E_weight, 1, 0);
-    tailgroup = late_string(agtail(e), N_group, "");
-    headgroup = late_string(aghead(e), N_group, "");
+    ED_weight(e) = late_int(e, lctx->E_weight, 1, 0);
+    tailgroup = late_string(agtail(e), lctx->N_group, "");
+    headgroup = late_string(aghead(e), lctx->N_group, "");
     ED_count(e) = ED_xpenalty(e) = 1;
     if (tailgroup[0] && (tailgroup == headgroup)) {
 	ED_xpenalty(e) = CL_CROSS;
@@ -67,8 +69,8 @@ dot_init_edge(edge_t * e)
 	ED_weight(e) = 0;
     }
 
-    ED_showboxes(e) = late_int(e, E_showboxes, 0, 0);
-    ED_minlen(e) = late_int(e, E_minlen, 1, 0);
+    ED_showboxes(e) = late_int(e, lctx->E_showboxes, 0, 0);
+    ED_minlen(e) = late_int(e, lctx->E_minlen, 1, 0);
 }
 
 void 
@@ -177,6 +179,103 @@ void dot_cleanup(graph_t * g)
     dot_cleanup_graph(g);
 }
 
+/* dot_warmstart:
+ * If g asks, with warmstart=true, for its layout to start from the node
+ * positions of an earlier one, return the attribute holding them.
+ */
+Agsym_t *dot_warmstart(graph_t * g)
+{
+    graph_t *root = agroot(g);
+
+    if (!mapbool(agget(root, "warmstart")))
+	return NULL;
+    return agattr(root, AGNODE, "pos", NULL);
+}
+
+/* dot_prior_pos:
+ * Read the position n had in an earlier layout from pos, undoing the
+ * rotation for rankdir so it is in the coordinates dot works in. Positions
+ * are only known up to a translation. Return false if n has none.
+ */
+bool dot_prior_pos(node_t * n, Agsym_t * pos, pointf * p)
+{
+    pointf q;
+
+    if (ND_node_type(n) != NORMAL)
+	return false;
+    if (sscanf(agxget(n, pos), "%lf,%lf", &q.x, &q.y) != 2)
+	return false;
+    *p = cwrotatepf(q, 90 * GD_rankdir(agroot(n)));
+    return true;
+}
+
+/* dot_prior_bb:
+ * Read the bounding box cluster g had in an earlier layout, in the
+ * coordinates dot_prior_pos gives. Return false if g has none.
+ */
+bool dot_prior_bb(graph_t * g, boxf * bb)
+{
+    Agsym_t *sym = agattr(agroot(g), AGRAPH, "bb", NULL);
+    const int rankdir = GD_rankdir(agroot(g));
+    pointf p, q;
+
+    if (!sym || sscanf(agxget(g, sym), "%lf,%lf,%lf,%lf", &p.x, &p.y,
+		       &q.x, &q.y) != 4)
+	return false;
+    p = cwrotatepf(p, 90 * rankdir);
+    q = cwrotatepf(q, 90 * rankdir);
+    bb->LL = (pointf){MIN(p.x, q.x), MIN(p.y, q.y)};
+    bb->UR = (pointf){MAX(p.x, q.x), MAX(p.y, q.y)};
+    return true;
+}
+
+/* dot_prior_spline_x:
+ * Where the spline of edge e crossed height y in an earlier layout, with y in
+ * the coordinates of that layout.
+ */
+bool dot_prior_spline_x(edge_t * e, double y, double *x)
+{
+    graph_t *root = agroot(agtail(e));
+    Agsym_t *pos = agattr(root, AGEDGE, "pos", NULL);
+    const int rankdir = GD_rankdir(root);
+    pointf bz[4];
+    int k = 0, len;
+
+    if (!pos)
+	return false;
+    for (const char *s = agxget(e, pos); *s && *s != ';'; s += len) {
+	/* skip the arrowhead end points */
+	if ((s[0] == 'e' || s[0] == 's') && s[1] == ',')
+	    s += 2;
+	if (sscanf(s, "%lf,%lf%n", &bz[k].x, &bz[k].y, &len) < 2)
+	    return false;
+	while (s[len] == ' ')
+	    len++;
+	bz[k] = cwrotatepf(bz[k], 90 * rankdir);
+	if (k < 3) {
+	    k++;
+	    continue;
+	}
+	/* bisect a piece that spans y, taking it to be monotone in y */
+	if ((bz[0].y - y) * (bz[3].y - y) <= 0 && bz[0].y != bz[3].y) {
+	    double lo = 0, hi = 1;
+	    const bool down = bz[3].y < bz[0].y;
+	    for (int i = 0; i < 20; i++) {
+		const double t = (lo + hi) / 2;
+		if ((Bezier(bz, 3, t, NULL, NULL).y > y) == down)
+		    lo = t;
+		else
+		    hi = t;
+	    }
+	    *x = Bezier(bz, 3, (lo + hi) / 2, NULL, NULL).x;
+	    return true;
+	}
+	bz[0] = bz[3];
+	k = 1;
+    }
+    return false;
+}
+
 #ifdef DEBUG
 int
 fastn (graph_t * g)
@@ -279,7 +378,43 @@ attach_phase_attrs (Agraph_t * g, int maxphase)
     }
 }
 
-static void dotLayout(Agraph_t * g)
+/* The parts of the time limit of a layout given to its phases, in the order
+ * they run. A phase that ends early leaves its time to those after it.
+ */
+#define RANK_SHARE 0.2
+#define MINCROSS_SHARE 0.4
+#define POSITION_SHARE 0.25
+#define SPLINES_SHARE 0.15
+
+/* phase_start:
+ * Give the phase about to run the part share of the time left until end,
+ * the wall_clock() time the layout should be done by, or none if end is 0.
+ */
+static void phase_start(double end, double share)
+{
+    layout_context_t *const lctx = gvLayoutContext();
+    lctx->PhaseTruncated = false;
+    if (end <= 0) {
+	lctx->PhaseDeadline = 0;
+	return;
+    }
+    const double now = wall_clock();
+    lctx->PhaseDeadline = now + MAX(end - now, 0) * share;
+}
+
+/* phase_end:
+ * Report under -v if the phase that ran stopped early for lack of time.
+ */
+static void phase_end(const char *phase)
+{
+    layout_context_t *const lctx = gvLayoutContext();
+    if (lctx->PhaseTruncated && Verbose)
+	fprintf(stderr, "dot: %s stopped at the time limit\n", phase);
+    lctx->PhaseDeadline = 0;
+    lctx->PhaseTruncated = false;
+}
+
+static void dotLayout(Agraph_t * g, double end)
 {
     aspect_t aspect;
     aspect_t* asp;
@@ -292,7 +427,9 @@ static void dotLayout(Agraph_t * g)
     dot_init_node_edge(g);
 
     do {
+	phase_start(end, RANK_SHARE);
         dot_rank(g, asp);
+	phase_end("rank");
 	if (maxphase == 1) {
 	    attach_phase_attrs (g, 1);
 	    return;
@@ -302,12 +439,17 @@ static void dotLayout(Agraph_t * g)
 	    asp = NULL;
 	    aspect.nextIter = 0;
 	}
+	phase_start(end, MINCROSS_SHARE /
+		    (MINCROSS_SHARE + POSITION_SHARE + SPLINES_SHARE));
         dot_mincross(g, (asp != NULL));
+	phase_end("mincross");
 	if (maxphase == 2) {
 	    attach_phase_attrs (g, 2);
 	    return;
 	}
+	phase_start(end, POSITION_SHARE / (POSITION_SHARE + SPLINES_SHARE));
         dot_position(g, asp);
+	phase_end("position");
 	if (maxphase == 3) {
 	    attach_phase_attrs (g, 2);  /* positions will be attached on output */
 	    return;
@@ -317,7 +459,9 @@ static void dotLayout(Agraph_t * g)
     if (GD_flags(g) & NEW_RANK)
 	removeFill (g);
     dot_sameports(g);
+    phase_start(end, 1);
     dot_splines(g);
+    phase_end("splines");
     if (mapbool(agget(g, "compound")))
 	dot_compoundEdges(g);
 }
@@ -429,7 +573,7 @@ copyClusterInfo (int ncc, Agraph_t** ccs, Agraph_t* root)
 /* doDot:
  * Assume g has nodes.
  */
-static void doDot (Agraph_t* g)
+static void doDot (Agraph_t* g, double end)
 {
     Agraph_t **ccs;
     Agraph_t *sg;
@@ -444,7 +588,7 @@ static void doDot (Agraph_t* g)
 	/* No pack information; use old dot with components
          * handled during layout
          */
-	dotLayout(g);
+	dotLayout(g, end);
     } else {
 	/* fill in default values */
 	if (mode == l_undef) 
@@ -458,14 +602,20 @@ static void doDot (Agraph_t* g)
           /* components using clusters */
 	ccs = cccomps(g, &ncc, 0);
 	if (ncc == 1) {
-	    dotLayout(g);
+	    dotLayout(g, end);
 	} else if (GD_drawing(g)->ratio_kind == R_NONE) {
 	    pinfo.doSplines = 1;
 
 	    for (i = 0; i < ncc; i++) {
 		sg = ccs[i];
 		initSubg (sg, g);
-		dotLayout (sg);
+		/* share what is left of the time limit with the rest */
+		double part = end;
+		if (end > 0) {
+		    const double now = wall_clock();
+		    part = now + MAX(end - now, 0) / (ncc - i);
+		}
+		dotLayout (sg, part);
 	    }
 	    attachPos (g);
 	    packSubgraphs(ncc, ccs, g, &pinfo);
@@ -477,7 +627,7 @@ static void doDot (Agraph_t* g)
              * One possibility is to layout nodes, pack, then apply the ratio
              * adjustment. We would then have to re-adjust all positions.
              */
-	    dotLayout(g);
+	    dotLayout(g, end);
 	}
 
 	for (i = 0; i < ncc; i++) {
@@ -489,9 +639,21 @@ static void doDot (Agraph_t* g)
     }
 }
 
+/* layout_end:
+ * The wall_clock() time the layout of g should be done by, from its
+ * timelimit attribute in seconds, or 0 for no limit.
+ */
+static double layout_end(Agraph_t * g)
+{
+    const double limit = late_double(g, agfindgraphattr(g, "timelimit"), 0, 0);
+    if (limit <= 0)
+	return 0;
+    return wall_clock() + limit;
+}
+
 void dot_layout(Agraph_t * g)
 {
-    if (agnnodes(g)) doDot (g);
+    if (agnnodes(g)) doDot (g, layout_end(g));
     dotneato_postprocess(g);
 }
 
@@ -28,10 +28,15 @@ extern "C" {
     extern void delete_fast_edge(Agedge_t *);
     extern void delete_fast_node(Agraph_t *, Agnode_t *);
     extern void delete_flat_edge(Agedge_t *);
+    extern int dot_bk_position(graph_t * g);
     extern void dot_cleanup(graph_t * g);
     extern void dot_layout(Agraph_t * g);
     extern void dot_init_node_edge(graph_t * g);
     extern void dot_scan_ranks(graph_t * g);
+    extern Agsym_t *dot_warmstart(graph_t * g);
+    extern bool dot_prior_pos(node_t * n, Agsym_t * pos, pointf * p);
+    extern bool dot_prior_bb(graph_t * g, boxf * bb);
+    extern bool dot_prior_spline_x(edge_t * e, double y, double *x);
     extern void enqueue_neighbors(nodequeue * q, node_t * n0, int pass);
     extern void expand_cluster(Agraph_t *);
     extern Agedge_t *fast_edge(Agedge_t *);
@@ -18,6 +18,7 @@
 #include <cgraph/alloc.h>
 #include <cgraph/list.h>
 #include <common/boxes.h>
+#include <common/workers.h>
 #include <dotgen/dot.h>
 #include <limits.h>
 #include <math.h>
@@ -64,6 +65,7 @@ typedef struct {
 } spline_info_t;
 
 DEFINE_LIST(points, pointf)
+DEFINE_LIST(node_list, node_t *)
 
 static void adjustregularpath(path *, int, int);
 static Agedge_t *bot_bound(Agedge_t *, int);
@@ -257,6 +259,429 @@ setEdgeLabelPos (graph_t * g)
     }
 }
 
+/* check_time:
+ * Once out of time, draw the remaining edges as lines, which are not routed.
+ * Returns the edge type to go on with.
+ */
+static int check_time(graph_t * g, int et)
+{
+    layout_context_t *const lctx = gvLayoutContext();
+    node_t *n;
+
+    if ((et == EDGETYPE_SPLINE || et == EDGETYPE_PLINE) && phase_expired()) {
+	lctx->PhaseTruncated = true;
+	et = EDGETYPE_LINE;
+	for (n = GD_nlist(g); n; n = ND_next(n)) {
+	    if (ND_node_type(n) == VIRTUAL && ND_label(n)) {
+		place_vnlabel(n);
+	    }
+	}
+    }
+    return et;
+}
+
+/* group_size:
+ * The number of edges from edges[i] on that are routed together with it.
+ */
+static int group_size(edge_t ** edges, int i, int n_edges)
+{
+    Agedgeinfo_t fwdedgeai, fwdedgebi;
+    Agedgepair_t fwdedgea, fwdedgeb;
+    edge_t *e0, *e1, *ea, *eb, *le0, *le1;
+    int cnt;
+    fwdedgea.out.base.data = (Agrec_t*)&fwdedgeai;
+    fwdedgeb.out.base.data = (Agrec_t*)&fwdedgebi;
+
+    le0 = getmainedge((e0 = edges[i++]));
+    if (ED_tail_port(e0).defined || ED_head_port(e0).defined) {
+	ea = e0;
+    } else {
+	ea =  le0;
+    }
+    if (ED_tree_index(ea) & BWDEDGE) {
+	MAKEFWDEDGE(&fwdedgea.out, ea);
+	ea = &fwdedgea.out;
+    }
+    for (cnt = 1; i < n_edges; cnt++, i++) {
+	if (le0 != (le1 = getmainedge((e1 = edges[i]))))
+	    break;
+	if (ED_adjacent(e0)) continue; /* all flat adjacent edges at once */
+	if (ED_tail_port(e1).defined || ED_head_port(e1).defined) {
+		eb = e1;
+	} else {
+		eb = le1;
+	}
+	if (ED_tree_index(eb) & BWDEDGE) {
+	    MAKEFWDEDGE(&fwdedgeb.out, eb);
+	    eb = &fwdedgeb.out;
+	}
+	if (portcmp(ED_tail_port(ea), ED_tail_port(eb)))
+	    break;
+	if (portcmp(ED_head_port(ea), ED_head_port(eb)))
+	    break;
+	if ((ED_tree_index(e0) & EDGETYPEMASK) == FLATEDGE
+	    && ED_label(e0) != ED_label(e1))
+	    break;
+	if (ED_tree_index(edges[i]) & MAINGRAPH)	/* Aha! -C is on */
+	    break;
+    }
+    return cnt;
+}
+
+/* is_regular:
+ * Whether the group of edges from edges[ind] is routed by make_regular_edge.
+ */
+static bool is_regular(edge_t ** edges, int ind, int et)
+{
+    edge_t *e0 = edges[ind];
+    return et != EDGETYPE_CURVED && agtail(e0) != aghead(e0)
+	&& ND_rank(agtail(e0)) != ND_rank(aghead(e0));
+}
+
+/* route_group:
+ * Route the cnt edges from edges[ind], which group_size put together.
+ */
+static void route_group(graph_t * g, spline_info_t * sd, path * P,
+			edge_t ** edges, int ind, int cnt, int et)
+{
+    edge_t *e, *e0 = edges[ind];
+    node_t *n;
+
+    if (et == EDGETYPE_CURVED) {
+	int ii;
+	edge_t** edgelist = gv_calloc(cnt, sizeof(edge_t*));
+	edgelist[0] = getmainedge((edges+ind)[0]);
+	for (ii = 1; ii < cnt; ii++)
+	    edgelist[ii] = (edges+ind)[ii];
+	makeStraightEdges (g, edgelist, cnt, et, &sinfo);
+	free(edgelist);
+    }
+    else if (agtail(e0) == aghead(e0)) {
+	int b, r;
+	double sizey;
+	n = agtail(e0);
+	r = ND_rank(n);
+	if (r == GD_maxrank(g)) {
+	    if (r > 0)
+		sizey = ND_coord(GD_rank(g)[r-1].v[0]).y - ND_coord(n).y;
+	    else
+		sizey = ND_ht(n);
+	}
+	else if (r == GD_minrank(g)) {
+	    sizey = ND_coord(n).y - ND_coord(GD_rank(g)[r+1].v[0]).y;
+	}
+	else {
+	    double upy = ND_coord(GD_rank(g)[r-1].v[0]).y - ND_coord(n).y;
+	    double dwny = ND_coord(n).y - ND_coord(GD_rank(g)[r+1].v[0]).y;
+	    sizey = MIN(upy, dwny);
+	}
+	makeSelfEdge(edges, ind, cnt, sd->Multisep, sizey / 2, &sinfo);
+	for (b = 0; b < cnt; b++) {
+	    e = edges[ind+b];
+	    if (ED_label(e))
+		updateBB(g, ED_label(e));
+	}
+    }
+    else if (ND_rank(agtail(e0)) == ND_rank(aghead(e0))) {
+	make_flat_edge(g, sd, P, edges, ind, cnt, et);
+    }
+    else
+	make_regular_edge(g, sd, P, edges, ind, cnt, et);
+}
+
+/* Routing a regular edge reads the sizes and places of the nodes next to
+ * those on its path, in maximal_bbox, and afterwards shrinks the virtual
+ * nodes of its path to the room the spline took, in recover_slack. It also
+ * looks, in top_bound and bot_bound, at the splines already installed on the
+ * other edges leaving its top node and entering its bottom node. Each group
+ * of edges is given a level after those of the groups before it whose
+ * virtual nodes it reads, that read or write its own, or that share its top
+ * or bottom node. The groups of a level are then independent, and may be
+ * routed at once, each seeing the nodes and splines as the serial loop would.
+ * Flat edges, loops and curved edges are routed alone in a level of their
+ * own.
+ */
+typedef struct {
+    int *base;		/* index of the first node of each rank */
+    int *read, *write;	/* the last level reading and writing each node */
+    int *top, *bottom;	/* the last level starting and ending at it */
+} levels_t;
+
+static int node_index(const levels_t * lv, node_t * v)
+{
+    return lv->base[ND_rank(v)] + ND_order(v);
+}
+
+/* add_neighbors:
+ * Add the nodes maximal_bbox may look at for vn to reads.
+ */
+static void add_neighbors(graph_t * g, node_list_t * reads, node_t * vn,
+			  edge_t * ie, edge_t * oe)
+{
+    node_t *left = neighbor(g, vn, ie, oe, -1);
+    node_t *right = neighbor(g, vn, ie, oe, 1);
+    node_list_append(reads, vn);
+    if (left)
+	node_list_append(reads, left);
+    if (right)
+	node_list_append(reads, right);
+}
+
+/* regular_footprint:
+ * The nodes make_regular_edge reads and writes in routing the group whose
+ * first edge is e, following its path as make_regular_edge does, and the
+ * nodes the path starts and ends at.
+ */
+static void regular_footprint(graph_t * g, edge_t * e, node_list_t * reads,
+			      node_list_t * writes, node_t ** top,
+			      node_t ** bottom)
+{
+    Agedgeinfo_t fwdedgei;
+    Agedgepair_t fwdedge;
+    edge_t *le;
+    node_t *v;
+
+    fwdedge.out.base.data = (Agrec_t*)&fwdedgei;
+    if (abs(ND_rank(agtail(e)) - ND_rank(aghead(e))) > 1) {
+	fwdedgei = *(Agedgeinfo_t*)e->base.data;
+	fwdedge.out = *e;
+	fwdedge.in = *AGOUT2IN(e);
+	fwdedge.out.base.data = (Agrec_t*)&fwdedgei;
+	le = getmainedge(e);
+	while (ED_to_virt(le))
+	    le = ED_to_virt(le);
+	agtail(&fwdedge.out) = (ED_tree_index(e) & BWDEDGE) ? aghead(e)
+							    : agtail(e);
+	aghead(&fwdedge.out) = aghead(le);
+	e = &fwdedge.out;
+    } else if (ED_tree_index(e) & BWDEDGE) {
+	MAKEFWDEDGE(&fwdedge.out, e);
+	e = &fwdedge.out;
+    }
+
+    *top = agtail(e);
+    add_neighbors(g, reads, agtail(e), NULL, e);
+    for (v = aghead(e); ND_node_type(v) == VIRTUAL && !sinfo.splineMerge(v);
+	 v = aghead(e)) {
+	edge_t *oe = ND_out(v).list[0];
+	node_list_append(writes, v);
+	add_neighbors(g, reads, v, e, oe);
+	e = oe;
+    }
+    add_neighbors(g, reads, v, e, NULL);
+    *bottom = v;
+}
+
+/* set_levels:
+ * Give each of the n groups of edges, starting at ind[k], its level, as
+ * above, returning the number of levels.
+ */
+static int set_levels(graph_t * g, edge_t ** edges, const int *ind, int n,
+		      int n_nodes, int et, int *level)
+{
+    node_list_t reads = {0}, writes = {0};
+    int top = 0, floor = 0;
+    levels_t lv = {.base = gv_calloc(GD_maxrank(g) + 1, sizeof(int)),
+		   .read = gv_calloc(n_nodes, sizeof(int)),
+		   .write = gv_calloc(n_nodes, sizeof(int)),
+		   .top = gv_calloc(n_nodes, sizeof(int)),
+		   .bottom = gv_calloc(n_nodes, sizeof(int))};
+
+    for (int r = GD_minrank(g) + 1; r <= GD_maxrank(g); r++)
+	lv.base[r] = lv.base[r - 1] + GD_rank(g)[r - 1].n;
+
+    for (int k = 0; k < n; k++) {
+	if (!is_regular(edges, ind[k], et)) {
+	    level[k] = floor = ++top;
+	    continue;
+	}
+	node_t *first, *last;
+	node_list_clear(&reads);
+	node_list_clear(&writes);
+	regular_footprint(g, edges[ind[k]], &reads, &writes, &first, &last);
+	const int fi = node_index(&lv, first), li = node_index(&lv, last);
+	int l = MAX(floor, MAX(lv.top[fi], lv.bottom[li])) + 1;
+	for (size_t i = 0; i < node_list_size(&reads); i++)
+	    l = MAX(l, lv.write[node_index(&lv, node_list_get(&reads, i))] + 1);
+	for (size_t i = 0; i < node_list_size(&writes); i++) {
+	    const int v = node_index(&lv, node_list_get(&writes, i));
+	    l = MAX(l, MAX(lv.read[v], lv.write[v]) + 1);
+	}
+	for (size_t i = 0; i < node_list_size(&reads); i++) {
+	    const int v = node_index(&lv, node_list_get(&reads, i));
+	    lv.read[v] = MAX(lv.read[v], l);
+	}
+	for (size_t i = 0; i < node_list_size(&writes); i++)
+	    lv.write[node_index(&lv, node_list_get(&writes, i))] = l;
+	lv.top[fi] = lv.bottom[li] = l;
+	level[k] = l;
+	top = MAX(top, l);
+    }
+    node_list_free(&reads);
+    node_list_free(&writes);
+    free(lv.base);
+    free(lv.read);
+    free(lv.write);
+    free(lv.top);
+    free(lv.bottom);
+    return top;
+}
+
+/* the spline found for a group of regular edges, before it is installed */
+typedef struct {
+    Agedgeinfo_t fwdedgeai, fwdedgebi;
+    Agedgepair_t fwdedgea, fwdedgeb;	/* stand-ins the route may run along */
+    edge_t *fe;		/* the edge the points run along */
+    node_t *hn;		/* and the node they end at */
+    points_t points;	/* none if no route was found */
+} regular_route_t;
+
+static bool route_regular(graph_t *, spline_info_t *, path *, edge_t **,
+			  int, int, regular_route_t *);
+static void install_regular(spline_info_t *, edge_t **, int, int,
+			    regular_route_t *);
+
+typedef struct {
+    graph_t *g;
+    spline_info_t *sd;
+    layout_context_t *ctx;	/* of the calling thread */
+    edge_t **edges;
+    const int *ind;		/* of the groups */
+    const int *todo;		/* the groups of the level */
+    size_t n;			/* and their number */
+    size_t parts;		/* sharing them */
+    regular_route_t *routes;	/* found for them */
+    int et;
+    path *paths;		/* of each worker */
+    bool *started;		/* whether a worker's routing is set up */
+    bool finish;		/* end the routing of each worker */
+} spline_job_t;
+
+/* route_part:
+ * Find the routes of every parts'th regular group of the level, from index
+ * on. Nothing is installed on the edges, so the routes of the level are
+ * found from the same state whatever the order.
+ */
+static void route_part(void *arg, size_t index)
+{
+    spline_job_t *job = arg;
+    layout_context_t *ctx = gvSetLayoutContext(job->ctx);
+
+    if (job->finish) {
+	if (job->started[index])
+	    routesplinesterm();
+	job->started[index] = false;
+	gvSetLayoutContext(ctx);
+	return;
+    }
+    if (!job->started[index]) {
+	routesplinesinit();
+	job->started[index] = true;
+    }
+    for (size_t i = index; i < job->n; i += job->parts)
+	(void)route_regular(job->g, job->sd, &job->paths[index], job->edges,
+			    job->ind[job->todo[i]], job->et, &job->routes[i]);
+    gvSetLayoutContext(ctx);
+}
+
+/* levels of fewer groups than this are routed in the calling thread */
+#define MIN_PARALLEL_GROUPS 16
+
+/* route_threaded:
+ * Route the edges as the loop in _dot_splines does, but the regular groups
+ * of each level in several threads. The workers only find the routes; the
+ * calling thread then installs them on their edges in the order of the
+ * groups, so the result is the same as the loop's. Returns the edge type to
+ * go on with.
+ */
+static int route_threaded(graph_t * g, spline_info_t * sd, path * P,
+			  edge_t ** edges, int n_edges, int n_nodes, int et,
+			  size_t threads)
+{
+    int n = 0, i, r;
+
+    int *ind = gv_calloc(n_edges, sizeof(int));
+    int *cnt = gv_calloc(n_edges, sizeof(int));
+    for (i = 0; i < n_edges; i += cnt[n++]) {
+	ind[n] = i;
+	cnt[n] = group_size(edges, i, n_edges);
+    }
+    int *level = gv_calloc(n, sizeof(int));
+    const int levels = set_levels(g, edges, ind, n, n_nodes, et, level);
+
+    /* the groups by level, in order within each */
+    int *first = gv_calloc(levels + 2, sizeof(int));
+    int *todo = gv_calloc(n, sizeof(int));
+    for (int k = 0; k < n; k++)
+	first[level[k] + 1]++;
+    int widest = 0;
+    for (int l = 1; l <= levels + 1; l++) {
+	widest = MAX(widest, first[l]);
+	first[l] += first[l - 1];
+    }
+    int *next = gv_calloc(levels + 1, sizeof(int));
+    memcpy(next, first, (levels + 1) * sizeof(int));
+    for (int k = 0; k < n; k++)
+	todo[next[level[k]]++] = k;
+    free(next);
+
+    /* rank boxes are filled in as they are first used; fill them all now */
+    for (r = GD_minrank(g); r < GD_maxrank(g); r++)
+	rank_box(sd, g, r);
+
+    workers_t *workers = workers_new(threads);
+    const size_t parts = workers_size(workers);
+    spline_job_t job = {.g = g, .sd = sd, .ctx = gvLayoutContext(),
+			.edges = edges, .ind = ind, .parts = parts};
+    job.routes = gv_calloc(widest, sizeof(regular_route_t));
+    job.paths = gv_calloc(parts, sizeof(path));
+    job.started = gv_calloc(parts, sizeof(bool));
+    for (size_t p = 0; p < parts; p++)
+	job.paths[p].boxes = gv_calloc(n_nodes + 20 * 2 * NSUB, sizeof(boxf));
+    if (Verbose)
+	fprintf(stderr, "splines: %d groups of edges in %d levels, %zu threads\n",
+		n, levels, parts);
+
+    for (int l = 1; l <= levels; l++) {
+	const int *lv = &todo[first[l]];
+	const size_t size = (size_t)(first[l + 1] - first[l]);
+	if (size == 0)
+	    continue;
+	et = check_time(g, et);
+	/* a level of flat edges, loops or curved edges holds that group alone */
+	if (size < MIN_PARALLEL_GROUPS || !is_regular(edges, ind[lv[0]], et)) {
+	    for (size_t j = 0; j < size; j++)
+		route_group(g, sd, P, edges, ind[lv[j]], cnt[lv[j]], et);
+	    continue;
+	}
+	job.todo = lv;
+	job.n = size;
+	job.et = et;
+	workers_run(workers, route_part, &job);
+	for (size_t j = 0; j < size; j++) {
+	    if (!points_is_empty(&job.routes[j].points))
+		install_regular(sd, edges, ind[lv[j]], cnt[lv[j]],
+				&job.routes[j]);
+	    points_free(&job.routes[j].points);
+	}
+    }
+
+    job.finish = true;
+    workers_run(workers, route_part, &job);
+    workers_free(workers);
+    for (size_t p = 0; p < parts; p++)
+	free(job.paths[p].boxes);
+    free(job.paths);
+    free(job.started);
+    free(job.routes);
+    free(first);
+    free(todo);
+    free(level);
+    free(ind);
+    free(cnt);
+    return et;
+}
+
 /* _dot_splines:
  * Main spline routing code.
  * The normalize parameter allows this function to be called by the
@@ -266,18 +691,20 @@ setEdgeLabelPos (graph_t * g)
  */
 static void _dot_splines(graph_t * g, int normalize)
 {
-    int i, j, k, n_nodes, n_edges, ind, cnt;
+    layout_context_t *const lctx = gvLayoutContext();
+    int i, j, k, n_nodes, n_edges, cnt;
     node_t *n;
-    Agedgeinfo_t fwdedgeai, fwdedgebi;
-    Agedgepair_t fwdedgea, fwdedgeb;
-    edge_t *e, *e0, *e1, *ea, *eb, *le0, *le1, **edges = NULL;
+    edge_t *e, **edges = NULL;
     path P = {0};
     spline_info_t sd;
     int et = EDGE_TYPE(g);
-    fwdedgea.out.base.data = (Agrec_t*)&fwdedgeai;
-    fwdedgeb.out.base.data = (Agrec_t*)&fwdedgebi;
 
     if (et == EDGETYPE_NONE) return;
+    /* with no time left, skip the search for orthogonal routes */
+    if (et == EDGETYPE_ORTHO && phase_expired()) {
+	lctx->PhaseTruncated = true;
+	et = EDGETYPE_LINE;
+    }
     if (et == EDGETYPE_CURVED) {
 	resetRW (g);
 	if (GD_has_labels(g->root) & EDGE_LABEL) {
@@ -388,83 +815,15 @@ static void _dot_splines(graph_t * g, int normalize)
 	}
     }
 
-    for (i = 0; i < n_edges;) {
-	ind = i;
-	le0 = getmainedge((e0 = edges[i++]));
-	if (ED_tail_port(e0).defined || ED_head_port(e0).defined) {
-	    ea = e0;
-	} else {
-	    ea =  le0;
-	}
-	if (ED_tree_index(ea) & BWDEDGE) {
-	    MAKEFWDEDGE(&fwdedgea.out, ea);
-	    ea = &fwdedgea.out;
-	}
-	for (cnt = 1; i < n_edges; cnt++, i++) {
-	    if (le0 != (le1 = getmainedge((e1 = edges[i]))))
-		break;
-	    if (ED_adjacent(e0)) continue; /* all flat adjacent edges at once */
-	    if (ED_tail_port(e1).defined || ED_head_port(e1).defined) {
-		    eb = e1;
-	    } else {
-		    eb = le1;
-	    }
-	    if (ED_tree_index(eb) & BWDEDGE) {
-		MAKEFWDEDGE(&fwdedgeb.out, eb);
-		eb = &fwdedgeb.out;
-	    }
-	    if (portcmp(ED_tail_port(ea), ED_tail_port(eb)))
-		break;
-	    if (portcmp(ED_head_port(ea), ED_head_port(eb)))
-		break;
-	    if ((ED_tree_index(e0) & EDGETYPEMASK) == FLATEDGE
-		&& ED_label(e0) != ED_label(e1))
-		break;
-	    if (ED_tree_index(edges[i]) & MAINGRAPH)	/* Aha! -C is on */
-		break;
-	}
-
-	if (et == EDGETYPE_CURVED) {
-	    int ii;
-	    edge_t** edgelist = gv_calloc(cnt, sizeof(edge_t*));
-	    edgelist[0] = getmainedge((edges+ind)[0]);
-	    for (ii = 1; ii < cnt; ii++)
-		edgelist[ii] = (edges+ind)[ii];
-	    makeStraightEdges (g, edgelist, cnt, et, &sinfo);
-	    free(edgelist);
-	}
-	else if (agtail(e0) == aghead(e0)) {
-	    int b, r;
-	    double sizey;
-	    n = agtail(e0);
-	    r = ND_rank(n);
-	    if (r == GD_maxrank(g)) {
-		if (r > 0)
-		    sizey = ND_coord(GD_rank(g)[r-1].v[0]).y - ND_coord(n).y;
-		else
-		    sizey = ND_ht(n);
-	    }
-	    else if (r == GD_minrank(g)) {
-		sizey = ND_coord(n).y - ND_coord(GD_rank(g)[r+1].v[0]).y;
-	    }
-	    else {
-		double upy = ND_coord(GD_rank(g)[r-1].v[0]).y - ND_coord(n).y;
-		double dwny = ND_coord(n).y - ND_coord(GD_rank(g)[r+1].v[0]).y;
-		sizey = MIN(upy, dwny);
-	    }
-	    makeSelfEdge(edges, ind, cnt, sd.Multisep, sizey / 2, &sinfo);
-	    for (b = 0; b < cnt; b++) {
-		e = edges[ind+b];
-		if (ED_label(e))
-		    updateBB(g, ED_label(e));
-	    }
-	}
-	else if (ND_rank(agtail(e0)) == ND_rank(aghead(e0))) {
-	    make_flat_edge(g, &sd, &P, edges, ind, cnt, et);
+    const size_t threads = workers_threads(g);
+    if (threads > 1 && normalize && !lctx->Concentrate && et != EDGETYPE_CURVED)
+	et = route_threaded(g, &sd, &P, edges, n_edges, n_nodes, et, threads);
+    else
+	for (i = 0; i < n_edges; i += cnt) {
+	    et = check_time(g, et);
+	    cnt = group_size(edges, i, n_edges);
+	    route_group(g, &sd, &P, edges, i, cnt, et);
 	}
-	else
-	    make_regular_edge(g, &sd, &P, edges, ind, cnt, et);
-    }
 
     /* place regular edge labels */
     for (n = GD_nlist(g); n; n = ND_next(n)) {
@@ -484,9 +843,9 @@ finish :
 #endif
     /* place port labels */
     /* FIX: head and tail labels are not part of cluster bbox */
-    if ((E_headlabel || E_taillabel) && (E_labelangle || E_labeldistance)) {
+    if ((lctx->E_headlabel || lctx->E_taillabel) && (lctx->E_labelangle || lctx->E_labeldistance)) {
 	for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
-	    if (E_headlabel) {
+	    if (lctx->E_headlabel) {
 		for (e = agfstin(g, n); e; e = agnxtin(g, e))
 		    if (ED_head_label(AGMKOUT(e))) {
 			place_portlabel(AGMKOUT(e), true);
@@ -494,7 +853,7 @@ finish :
 		    }
 
 	    }
-	    if (E_taillabel) {
+	    if (lctx->E_taillabel) {
 		for (e = agfstout(g, n); e; e = agnxtout(g, e)) {
 		    if (ED_tail_label(e)) {
 			if (place_portlabel(e, false))
@@ -515,8 +874,8 @@ finish :
 	free(sd.Rank_box);
 	routesplinesterm();
     } 
-    State = GVSPLINES;
-    EdgeLabelsDone = 1;
+    lctx->State = GVSPLINES;
+    lctx->EdgeLabelsDone = 1;
 }
 
 /* dot_splines:
@@ -687,134 +1046,138 @@ static int edgecmp(edge_t** ptr0, edge_t** ptr1)
 
 /* cloneGraph:
  */
+/* the attribute symbols and State of the main graph, while its clone is
+ * laid out; the names are in lower case so the globals.h macros leave them be
+ */
 typedef struct {
-    attrsym_t* E_constr;
-    attrsym_t* E_samehead;
-    attrsym_t* E_sametail;
-    attrsym_t* E_weight;
-    attrsym_t* E_minlen;
-    attrsym_t* E_fontcolor;
-    attrsym_t* E_fontname;
-    attrsym_t* E_fontsize;
-    attrsym_t* E_headclip;
-    attrsym_t* E_headlabel;
-    attrsym_t* E_label;
-    attrsym_t* E_label_float;
-    attrsym_t* E_labelfontcolor;
-    attrsym_t* E_labelfontname;
-    attrsym_t* E_labelfontsize;
-    attrsym_t* E_tailclip;
-    attrsym_t* E_taillabel;
-    attrsym_t* E_xlabel;
-
-    attrsym_t* N_height;
-    attrsym_t* N_width;
-    attrsym_t* N_shape;
-    attrsym_t* N_style;
-    attrsym_t* N_fontsize;
-    attrsym_t* N_fontname;
-    attrsym_t* N_fontcolor;
-    attrsym_t* N_label;
-    attrsym_t* N_xlabel;
-    attrsym_t* N_showboxes;
-    attrsym_t* N_ordering;
-    attrsym_t* N_sides;
-    attrsym_t* N_peripheries;
-    attrsym_t* N_skew;
-    attrsym_t* N_orientation;
-    attrsym_t* N_distortion;
-    attrsym_t* N_fixed;
-    attrsym_t* N_nojustify;
-    attrsym_t* N_group;
-
-    attrsym_t* G_ordering;
-    int        State;
+    attrsym_t* e_constr;
+    attrsym_t* e_samehead;
+    attrsym_t* e_sametail;
+    attrsym_t* e_weight;
+    attrsym_t* e_minlen;
+    attrsym_t* e_fontcolor;
+    attrsym_t* e_fontname;
+    attrsym_t* e_fontsize;
+    attrsym_t* e_headclip;
+    attrsym_t* e_headlabel;
+    attrsym_t* e_label;
+    attrsym_t* e_label_float;
+    attrsym_t* e_labelfontcolor;
+    attrsym_t* e_labelfontname;
+    attrsym_t* e_labelfontsize;
+    attrsym_t* e_tailclip;
+    attrsym_t* e_taillabel;
+    attrsym_t* e_xlabel;
+
+    attrsym_t* n_height;
+    attrsym_t* n_width;
+    attrsym_t* n_shape;
+    attrsym_t* n_style;
+    attrsym_t* n_fontsize;
+    attrsym_t* n_fontname;
+    attrsym_t* n_fontcolor;
+    attrsym_t* n_label;
+    attrsym_t* n_xlabel;
+    attrsym_t* n_showboxes;
+    attrsym_t* n_ordering;
+    attrsym_t* n_sides;
+    attrsym_t* n_peripheries;
+    attrsym_t* n_skew;
+    attrsym_t* n_orientation;
+    attrsym_t* n_distortion;
+    attrsym_t* n_fixed;
+    attrsym_t* n_nojustify;
+    attrsym_t* n_group;
+
+    attrsym_t* g_ordering;
+    int        state;
 } attr_state_t;
 
 static void
 setState (graph_t* auxg, attr_state_t* attr_state)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     /* save state */
-    attr_state->E_constr = E_constr;
-    attr_state->E_samehead = E_samehead;
-    attr_state->E_sametail = E_sametail;
-    attr_state->E_weight = E_weight;
-    attr_state->E_minlen = E_minlen;
-    attr_state->E_fontcolor = E_fontcolor;
-    attr_state->E_fontname = E_fontname;
-    attr_state->E_fontsize = E_fontsize;
-    attr_state->E_headclip = E_headclip;
-    attr_state->E_headlabel = E_headlabel;
-    attr_state->E_label = E_label;
-    attr_state->E_label_float = E_label_float;
-    attr_state->E_labelfontcolor = E_labelfontcolor;
-    attr_state->E_labelfontname = E_labelfontname;
-    attr_state->E_labelfontsize = E_labelfontsize;
-    attr_state->E_tailclip = E_tailclip;
-    attr_state->E_taillabel = E_taillabel;
-    attr_state->E_xlabel = E_xlabel;
-    attr_state->N_height = N_height;
-    attr_state->N_width = N_width;
-    attr_state->N_shape = N_shape;
-    attr_state->N_style = N_style;
-    attr_state->N_fontsize = N_fontsize;
-    attr_state->N_fontname = N_fontname;
-    attr_state->N_fontcolor = N_fontcolor;
-    attr_state->N_label = N_label;
-    attr_state->N_xlabel = N_xlabel;
-    attr_state->N_showboxes = N_showboxes;
-    attr_state->N_ordering = N_ordering;
-    attr_state->N_sides = N_sides;
-    attr_state->N_peripheries = N_peripheries;
-    attr_state->N_skew = N_skew;
-    attr_state->N_orientation = N_orientation;
-    attr_state->N_distortion = N_distortion;
-    attr_state->N_fixed = N_fixed;
-    attr_state->N_nojustify = N_nojustify;
-    attr_state->N_group = N_group;
-    attr_state->State = State;
-    attr_state->G_ordering = G_ordering;
-
-    E_constr = NULL;
-    E_samehead = agattr(auxg,AGEDGE, "samehead", NULL);
-    E_sametail = agattr(auxg,AGEDGE, "sametail", NULL);
-    E_weight = agattr(auxg,AGEDGE, "weight", NULL);
-    if (!E_weight)
-	E_weight = agattr (auxg,AGEDGE,"weight", "");
-    E_minlen = NULL;
-    E_fontcolor = NULL;
-    E_fontname = agfindedgeattr(auxg, "fontname");
-    E_fontsize = agfindedgeattr(auxg, "fontsize");
-    E_headclip = agfindedgeattr(auxg, "headclip");
-    E_headlabel = NULL;
-    E_label = agfindedgeattr(auxg, "label");
-    E_label_float = agfindedgeattr(auxg, "label_float");
-    E_labelfontcolor = NULL;
-    E_labelfontname = agfindedgeattr(auxg, "labelfontname");
-    E_labelfontsize = agfindedgeattr(auxg, "labelfontsize");
-    E_tailclip = agfindedgeattr(auxg, "tailclip");
-    E_taillabel = NULL;
-    E_xlabel = NULL;
-    N_height = agfindnodeattr(auxg, "height");
-    N_width = agfindnodeattr(auxg, "width");
-    N_shape = agfindnodeattr(auxg, "shape");
-    N_style = NULL;
-    N_fontsize = agfindnodeattr(auxg, "fontsize");
-    N_fontname = agfindnodeattr(auxg, "fontname");
-    N_fontcolor = NULL;
-    N_label = agfindnodeattr(auxg, "label");
-    N_xlabel = NULL;
-    N_showboxes = NULL;
-    N_ordering = agfindnodeattr(auxg, "ordering");
-    N_sides = agfindnodeattr(auxg, "sides");
-    N_peripheries = agfindnodeattr(auxg, "peripheries");
-    N_skew = agfindnodeattr(auxg, "skew");
-    N_orientation = agfindnodeattr(auxg, "orientation");
-    N_distortion = agfindnodeattr(auxg, "distortion");
-    N_fixed = agfindnodeattr(auxg, "fixed");
-    N_nojustify = NULL;
-    N_group = NULL;
-    G_ordering = agfindgraphattr (auxg, "ordering");
+    attr_state->e_constr = lctx->E_constr;
+    attr_state->e_samehead = lctx->E_samehead;
+    attr_state->e_sametail = lctx->E_sametail;
+    attr_state->e_weight = lctx->E_weight;
+    attr_state->e_minlen = lctx->E_minlen;
+    attr_state->e_fontcolor = lctx->E_fontcolor;
+    attr_state->e_fontname = lctx->E_fontname;
+    attr_state->e_fontsize = lctx->E_fontsize;
+    attr_state->e_headclip = lctx->E_headclip;
+    attr_state->e_headlabel = lctx->E_headlabel;
+    attr_state->e_label = lctx->E_label;
+    attr_state->e_label_float = lctx->E_label_float;
+    attr_state->e_labelfontcolor = lctx->E_labelfontcolor;
+    attr_state->e_labelfontname = lctx->E_labelfontname;
+    attr_state->e_labelfontsize = lctx->E_labelfontsize;
+    attr_state->e_tailclip = lctx->E_tailclip;
+    attr_state->e_taillabel = lctx->E_taillabel;
+    attr_state->e_xlabel = lctx->E_xlabel;
+    attr_state->n_height = lctx->N_height;
+    attr_state->n_width = lctx->N_width;
+    attr_state->n_shape = lctx->N_shape;
+    attr_state->n_style = lctx->N_style;
+    attr_state->n_fontsize = lctx->N_fontsize;
+    attr_state->n_fontname = lctx->N_fontname;
+    attr_state->n_fontcolor = lctx->N_fontcolor;
+    attr_state->n_label = lctx->N_label;
+    attr_state->n_xlabel = lctx->N_xlabel;
+    attr_state->n_showboxes = lctx->N_showboxes;
+    attr_state->n_ordering = lctx->N_ordering;
+    attr_state->n_sides = lctx->N_sides;
+    attr_state->n_peripheries = lctx->N_peripheries;
+    attr_state->n_skew = lctx->N_skew;
+    attr_state->n_orientation = lctx->N_orientation;
+    attr_state->n_distortion = lctx->N_distortion;
+    attr_state->n_fixed = lctx->N_fixed;
+    attr_state->n_nojustify = lctx->N_nojustify;
+    attr_state->n_group = lctx->N_group;
+    attr_state->state = lctx->State;
+    attr_state->g_ordering = lctx->G_ordering;
+
+    lctx->E_constr = NULL;
+    lctx->E_samehead = agattr(auxg,AGEDGE, "samehead", NULL);
+    lctx->E_sametail = agattr(auxg,AGEDGE, "sametail", NULL);
+    lctx->E_weight = agattr(auxg,AGEDGE, "weight", NULL);
+    if (!lctx->E_weight)
+	lctx->E_weight = agattr (auxg,AGEDGE,"weight", "");
+    lctx->E_minlen = NULL;
+    lctx->E_fontcolor = NULL;
+    lctx->E_fontname = agfindedgeattr(auxg, "fontname");
+    lctx->E_fontsize = agfindedgeattr(auxg, "fontsize");
+    lctx->E_headclip = agfindedgeattr(auxg, "headclip");
+    lctx->E_headlabel = NULL;
+    lctx->E_label = agfindedgeattr(auxg, "label");
+    lctx->E_label_float = agfindedgeattr(auxg, "label_float");
+    lctx->E_labelfontcolor = NULL;
+    lctx->E_labelfontname = agfindedgeattr(auxg, "labelfontname");
+    lctx->E_labelfontsize = agfindedgeattr(auxg, "labelfontsize");
+    lctx->E_tailclip = agfindedgeattr(auxg, "tailclip");
+    lctx->E_taillabel = NULL;
+    lctx->E_xlabel = NULL;
+    lctx->N_height = agfindnodeattr(auxg, "height");
+    lctx->N_width = agfindnodeattr(auxg, "width");
+    lctx->N_shape = agfindnodeattr(auxg, "shape");
+    lctx->N_style = NULL;
+    lctx->N_fontsize = agfindnodeattr(auxg, "fontsize");
+    lctx->N_fontname = agfindnodeattr(auxg, "fontname");
+    lctx->N_fontcolor = NULL;
+    lctx->N_label = agfindnodeattr(auxg, "label");
+    lctx->N_xlabel = NULL;
+    lctx->N_showboxes = NULL;
+    lctx->N_ordering = agfindnodeattr(auxg, "ordering");
+    lctx->N_sides = agfindnodeattr(auxg, "sides");
+    lctx->N_peripheries = agfindnodeattr(auxg, "peripheries");
+    lctx->N_skew = agfindnodeattr(auxg, "skew");
+    lctx->N_orientation = agfindnodeattr(auxg, "orientation");
+    lctx->N_distortion = agfindnodeattr(auxg, "distortion");
+    lctx->N_fixed = agfindnodeattr(auxg, "fixed");
+    lctx->N_nojustify = NULL;
+    lctx->N_group = NULL;
+    lctx->G_ordering = agfindgraphattr (auxg, "ordering");
 }
 
 /* cloneGraph:
@@ -872,46 +1235,47 @@ cloneGraph (graph_t* g, attr_state_t* attr_state)
 static void
 cleanupCloneGraph (graph_t* g, attr_state_t* attr_state)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     /* restore main graph syms */
-    E_constr = attr_state->E_constr;
-    E_samehead = attr_state->E_samehead;
-    E_sametail = attr_state->E_sametail;
-    E_weight = attr_state->E_weight;
-    E_minlen = attr_state->E_minlen;
-    E_fontcolor = attr_state->E_fontcolor;
-    E_fontname = attr_state->E_fontname;
-    E_fontsize = attr_state->E_fontsize;
-    E_headclip = attr_state->E_headclip;
-    E_headlabel = attr_state->E_headlabel;
-    E_label = attr_state->E_label;
-    E_label_float = attr_state->E_label_float;
-    E_labelfontcolor = attr_state->E_labelfontcolor;
-    E_labelfontname = attr_state->E_labelfontname;
-    E_labelfontsize = attr_state->E_labelfontsize;
-    E_tailclip = attr_state->E_tailclip;
-    E_taillabel = attr_state->E_taillabel;
-    E_xlabel = attr_state->E_xlabel;
-    N_height = attr_state->N_height;
-    N_width = attr_state->N_width;
-    N_shape = attr_state->N_shape;
-    N_style = attr_state->N_style;
-    N_fontsize = attr_state->N_fontsize;
-    N_fontname = attr_state->N_fontname;
-    N_fontcolor = attr_state->N_fontcolor;
-    N_label = attr_state->N_label;
-    N_xlabel = attr_state->N_xlabel;
-    N_showboxes = attr_state->N_showboxes;
-    N_ordering = attr_state->N_ordering;
-    N_sides = attr_state->N_sides;
-    N_peripheries = attr_state->N_peripheries;
-    N_skew = attr_state->N_skew;
-    N_orientation = attr_state->N_orientation;
-    N_distortion = attr_state->N_distortion;
-    N_fixed = attr_state->N_fixed;
-    N_nojustify = attr_state->N_nojustify;
-    N_group = attr_state->N_group;
-    G_ordering = attr_state->G_ordering;
-    State = attr_state->State;
+    lctx->E_constr = attr_state->e_constr;
+    lctx->E_samehead = attr_state->e_samehead;
+    lctx->E_sametail = attr_state->e_sametail;
+    lctx->E_weight = attr_state->e_weight;
+    lctx->E_minlen = attr_state->e_minlen;
+    lctx->E_fontcolor = attr_state->e_fontcolor;
+    lctx->E_fontname = attr_state->e_fontname;
+    lctx->E_fontsize = attr_state->e_fontsize;
+    lctx->E_headclip = attr_state->e_headclip;
+    lctx->E_headlabel = attr_state->e_headlabel;
+    lctx->E_label = attr_state->e_label;
+    lctx->E_label_float = attr_state->e_label_float;
+    lctx->E_labelfontcolor = attr_state->e_labelfontcolor;
+    lctx->E_labelfontname = attr_state->e_labelfontname;
+    lctx->E_labelfontsize = attr_state->e_labelfontsize;
+    lctx->E_tailclip = attr_state->e_tailclip;
+    lctx->E_taillabel = attr_state->e_taillabel;
+    lctx->E_xlabel = attr_state->e_xlabel;
+    lctx->N_height = attr_state->n_height;
+    lctx->N_width = attr_state->n_width;
+    lctx->N_shape = attr_state->n_shape;
+    lctx->N_style = attr_state->n_style;
+    lctx->N_fontsize = attr_state->n_fontsize;
+    lctx->N_fontname = attr_state->n_fontname;
+    lctx->N_fontcolor = attr_state->n_fontcolor;
+    lctx->N_label = attr_state->n_label;
+    lctx->N_xlabel = attr_state->n_xlabel;
+    lctx->N_showboxes = attr_state->n_showboxes;
+    lctx->N_ordering = attr_state->n_ordering;
+    lctx->N_sides = attr_state->n_sides;
+    lctx->N_peripheries = attr_state->n_peripheries;
+    lctx->N_skew = attr_state->n_skew;
+    lctx->N_orientation = attr_state->n_orientation;
+    lctx->N_distortion = attr_state->n_distortion;
+    lctx->N_fixed = attr_state->n_fixed;
+    lctx->N_nojustify = attr_state->n_nojustify;
+    lctx->N_group = attr_state->n_group;
+    lctx->G_ordering = attr_state->g_ordering;
+    lctx->State = attr_state->state;
 
     dot_cleanup(g);
     agclose(g);
@@ -1212,6 +1576,7 @@ static void
 make_flat_adj_edges(graph_t* g, edge_t** edges, int ind, int cnt, edge_t* e0,
                     int et)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     node_t* n;
     node_t *tn, *hn;
     edge_t* e;
@@ -1285,7 +1650,7 @@ make_flat_adj_edges(graph_t* g, edge_t** edges, int ind, int cnt, edge_t* e0,
     if (!hvye) {
 	hvye = agedge (auxg, auxt, auxh,NULL,1);
     }
-    agxset (hvye, E_weight, "10000");
+    agxset (hvye, lctx->E_weight, "10000");
     GD_gvc(auxg) = GD_gvc(g);
     GD_dotroot(auxg) = auxg;
     setEdgeType (auxg, et);
@@ -1759,63 +2124,64 @@ static int makeLineEdge(graph_t *g, edge_t *fe, points_t *points, node_t** hp) {
     return pn;
 }
 
-static void
-make_regular_edge(graph_t* g, spline_info_t* sp, path * P, edge_t ** edges, int ind, int cnt, int et)
+/* route_regular:
+ * Find the spline of the group of edges from edges[ind] into r, returning
+ * false if there is none. Nothing is installed on the edges, but the virtual
+ * nodes of the path are shrunk to the room the spline takes.
+ */
+static bool route_regular(graph_t *g, spline_info_t *sp, path *P,
+			  edge_t **edges, int ind, int et, regular_route_t *r)
 {
     node_t *tn, *hn;
-    Agedgeinfo_t fwdedgeai, fwdedgebi, fwdedgei;
-    Agedgepair_t fwdedgea, fwdedgeb, fwdedge;
     edge_t *e, *fe, *le, *segfirst;
     pathend_t tend, hend;
     boxf b;
-    int sl, si, i, j, dx, longedge;
-    points_t pointfs = {0};
-    points_t pointfs2 = {0};
+    int sl, si, i, longedge;
+    points_t *pointfs = &r->points;
 
-    fwdedgea.out.base.data = (Agrec_t*)&fwdedgeai;
-    fwdedgeb.out.base.data = (Agrec_t*)&fwdedgebi;
-    fwdedge.out.base.data = (Agrec_t*)&fwdedgei;
+    r->fwdedgea.out.base.data = (Agrec_t*)&r->fwdedgeai;
+    r->fwdedgeb.out.base.data = (Agrec_t*)&r->fwdedgebi;
 
     sl = 0;
     e = edges[ind];
     bool hackflag = false;
     if (abs(ND_rank(agtail(e)) - ND_rank(aghead(e))) > 1) {
-	fwdedgeai = *(Agedgeinfo_t*)e->base.data;
-	fwdedgea.out = *e;
-	fwdedgea.in = *AGOUT2IN(e);
-	fwdedgea.out.base.data = (Agrec_t*)&fwdedgeai;
+	r->fwdedgeai = *(Agedgeinfo_t*)e->base.data;
+	r->fwdedgea.out = *e;
+	r->fwdedgea.in = *AGOUT2IN(e);
+	r->fwdedgea.out.base.data = (Agrec_t*)&r->fwdedgeai;
 	if (ED_tree_index(e) & BWDEDGE) {
-	    MAKEFWDEDGE(&fwdedgeb.out, e);
-	    agtail(&fwdedgea.out) = aghead(e);
-	    ED_tail_port(&fwdedgea.out) = ED_head_port(e);
+	    MAKEFWDEDGE(&r->fwdedgeb.out, e);
+	    agtail(&r->fwdedgea.out) = aghead(e);
+	    ED_tail_port(&r->fwdedgea.out) = ED_head_port(e);
 	} else {
-	    fwdedgebi = *(Agedgeinfo_t*)e->base.data;
-	    fwdedgeb.out = *e;
-	    fwdedgeb.out.base.data = (Agrec_t*)&fwdedgebi;
-	    agtail(&fwdedgea.out) = agtail(e);
-	    fwdedgeb.in = *AGOUT2IN(e);
+	    r->fwdedgebi = *(Agedgeinfo_t*)e->base.data;
+	    r->fwdedgeb.out = *e;
+	    r->fwdedgeb.out.base.data = (Agrec_t*)&r->fwdedgebi;
+	    agtail(&r->fwdedgea.out) = agtail(e);
+	    r->fwdedgeb.in = *AGOUT2IN(e);
 	}
 	le = getmainedge(e);
 	while (ED_to_virt(le))
 	    le = ED_to_virt(le);
-	aghead(&fwdedgea.out) = aghead(le);
-	ED_head_port(&fwdedgea.out).defined = false;
-	ED_edge_type(&fwdedgea.out) = VIRTUAL;
-	ED_head_port(&fwdedgea.out).p.x = ED_head_port(&fwdedgea.out).p.y = 0;
-	ED_to_orig(&fwdedgea.out) = e;
-	e = &fwdedgea.out;
+	aghead(&r->fwdedgea.out) = aghead(le);
+	ED_head_port(&r->fwdedgea.out).defined = false;
+	ED_edge_type(&r->fwdedgea.out) = VIRTUAL;
+	ED_head_port(&r->fwdedgea.out).p.x = ED_head_port(&r->fwdedgea.out).p.y = 0;
+	ED_to_orig(&r->fwdedgea.out) = e;
+	e = &r->fwdedgea.out;
 	hackflag = true;
     } else {
 	if (ED_tree_index(e) & BWDEDGE) {
-	    MAKEFWDEDGE(&fwdedgea.out, e);
-	    e = &fwdedgea.out;
+	    MAKEFWDEDGE(&r->fwdedgea.out, e);
+	    e = &r->fwdedgea.out;
 	}
     }
     fe = e;
 
     /* compute the spline points for the edge */
 
-    if (et == EDGETYPE_LINE && makeLineEdge(g, fe, &pointfs, &hn)) {
+    if (et == EDGETYPE_LINE && makeLineEdge(g, fe, pointfs, &hn)) {
     }
     else {
 	bool is_spline = et == EDGETYPE_SPLINE;
@@ -1875,16 +2241,15 @@ make_regular_edge(graph_t* g, spline_info_t* sp, path * P, edge_t ** edges, int
 	    if (pn == 0) {
 	        free(ps);
 	        boxes_free(&boxes);
-	        points_free(&pointfs);
-	        points_free(&pointfs2);
-	        return;
+	        points_free(pointfs);
+	        return false;
 	    }
 	
 	    for (i = 0; i < pn; i++) {
-		points_append(&pointfs, ps[i]);
+		points_append(pointfs, ps[i]);
 	    }
 	    free(ps);
-	    e = straight_path(ND_out(hn).list[0], sl, &pointfs);
+	    e = straight_path(ND_out(hn).list[0], sl, pointfs);
 	    recover_slack(segfirst, P);
 	    segfirst = e;
 	    tn = agtail(e);
@@ -1901,7 +2266,7 @@ make_regular_edge(graph_t* g, spline_info_t* sp, path * P, edge_t ** edges, int
 	}
 	boxes_append(&boxes, rank_box(sp, g, ND_rank(tn)));
 	b = hend.nb = maximal_bbox(g, sp, hn, e, NULL);
-	endpath(P, hackflag ? &fwdedgeb.out : e, REGULAREDGE, &hend,
+	endpath(P, hackflag ? &r->fwdedgeb.out : e, REGULAREDGE, &hend,
 	        spline_merge(aghead(e)));
 	b.UR.y = hend.boxes[hend.boxn - 1].UR.y;
 	b.LL.y = hend.boxes[hend.boxn - 1].LL.y;
@@ -1928,34 +2293,51 @@ make_regular_edge(graph_t* g, spline_info_t* sp, path * P, edge_t ** edges, int
         }
 	if (pn == 0) {
 	    free(ps);
-	    points_free(&pointfs);
-	    points_free(&pointfs2);
-	    return;
+	    points_free(pointfs);
+	    return false;
 	}
 	for (i = 0; i < pn; i++) {
-	    points_append(&pointfs, ps[i]);
+	    points_append(pointfs, ps[i]);
 	}
 	free(ps);
 	recover_slack(segfirst, P);
-	hn = hackflag ? aghead(&fwdedgeb.out) : aghead(e);
+	hn = hackflag ? aghead(&r->fwdedgeb.out) : aghead(e);
     }
+    r->fe = fe;
+    r->hn = hn;
+    return true;
+}
+
+/* install_regular:
+ * Install copies of the spline r found for the group of cnt edges from
+ * edges[ind], one per edge.
+ */
+static void install_regular(spline_info_t *sp, edge_t **edges, int ind,
+			    int cnt, regular_route_t *r)
+{
+    Agedgeinfo_t fwdedgei;
+    Agedgepair_t fwdedge;
+    edge_t *e;
+    int j, dx;
+    points_t *pointfs = &r->points;
+    points_t pointfs2 = {0};
+
+    fwdedge.out.base.data = (Agrec_t*)&fwdedgei;
 
     /* make copies of the spline points, one per multi-edge */
 
     if (cnt == 1) {
-	clip_and_install(fe, hn, points_at(&pointfs, 0), (int)points_size(&pointfs),
-	                 &sinfo);
-	points_free(&pointfs);
-	points_free(&pointfs2);
+	clip_and_install(r->fe, r->hn, points_at(pointfs, 0),
+	                 (int)points_size(pointfs), &sinfo);
 	return;
     }
     dx = sp->Multisep * (cnt - 1) / 2;
-    for (size_t k = 1; k + 1 < points_size(&pointfs); k++)
-	points_at(&pointfs, k)->x -= dx;
+    for (size_t k = 1; k + 1 < points_size(pointfs); k++)
+	points_at(pointfs, k)->x -= dx;
 
-    for (size_t k = 0; k < points_size(&pointfs); k++)
-	points_append(&pointfs2, points_get(&pointfs, k));
-    clip_and_install(fe, hn, points_at(&pointfs2, 0),
+    for (size_t k = 0; k < points_size(pointfs); k++)
+	points_append(&pointfs2, points_get(pointfs, k));
+    clip_and_install(r->fe, r->hn, points_at(&pointfs2, 0),
                      (int)points_size(&pointfs2), &sinfo);
     for (j = 1; j < cnt; j++) {
 	e = edges[ind + j];
@@ -1963,18 +2345,30 @@ make_regular_edge(graph_t* g, spline_info_t* sp, path * P, edge_t ** edges, int
 	    MAKEFWDEDGE(&fwdedge.out, e);
 	    e = &fwdedge.out;
 	}
-	for (size_t k = 1; k + 1 < points_size(&pointfs); k++)
-	    points_at(&pointfs, k)->x += sp->Multisep;
+	for (size_t k = 1; k + 1 < points_size(pointfs); k++)
+	    points_at(pointfs, k)->x += sp->Multisep;
 	points_clear(&pointfs2);
-	for (size_t k = 0; k < points_size(&pointfs); k++)
-	    points_append(&pointfs2, points_get(&pointfs, k));
+	for (size_t k = 0; k < points_size(pointfs); k++)
+	    points_append(&pointfs2, points_get(pointfs, k));
 	clip_and_install(e, aghead(e), points_at(&pointfs2, 0),
 	                 (int)points_size(&pointfs2), &sinfo);
     }
-    points_free(&pointfs);
     points_free(&pointfs2);
 }
 
+/* make_regular_edge:
+ * Route the group of cnt edges from edges[ind] and install their splines.
+ */
+static void
+make_regular_edge(graph_t* g, spline_info_t* sp, path * P, edge_t ** edges, int ind, int cnt, int et)
+{
+    regular_route_t r = {0};
+
+    if (route_regular(g, sp, P, edges, ind, et, &r))
+	install_regular(sp, edges, ind, cnt, &r);
+    points_free(&r.points);
+}
+
 /* regular edges */
 
 #define DONT_WANT_ANY_ENDPOINT_PATH_REFINEMENT
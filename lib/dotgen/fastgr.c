@@ -8,6 +8,7 @@
  * Contributors: Details at https://graphviz.org
  *************************************************************************/
 
+#include <cgraph/tls.h>
 #include <cgraph/unused.h>
 #include <dotgen/dot.h>
 #include <stdbool.h>
@@ -227,7 +228,12 @@ void flat_edge(graph_t * g, edge_t * e)
 {
     elist_append(e, ND_flat_out(agtail(e)));
     elist_append(e, ND_flat_in(aghead(e)));
-    GD_has_flat_edges(dot_root(g)) = GD_has_flat_edges(g) = true;
+    /* mincross reverses flat edges of a graph known to have them, in several
+     * threads at once, so the flags are only written if not yet set */
+    if (!GD_has_flat_edges(dot_root(g)))
+	GD_has_flat_edges(dot_root(g)) = true;
+    if (!GD_has_flat_edges(g))
+	GD_has_flat_edges(g) = true;
 }
 
 void delete_flat_edge(edge_t * e)
@@ -242,7 +248,7 @@ void delete_flat_edge(edge_t * e)
 #ifdef DEBUG
 static char *NAME(node_t * n)
 {
-    static char buf[20];
+    static TLS char buf[20];
     if (ND_node_type(n) == NORMAL)
 	return agnameof(n);
     snprintf(buf, sizeof(buf), "V%p", n);
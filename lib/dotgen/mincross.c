@@ -19,8 +19,13 @@
 #include <assert.h>
 #include <cgraph/cgraph.h>
 #include <cgraph/exit.h>
+#include <cgraph/sort.h>
+#include <cgraph/tls.h>
+#include <common/random.h>
+#include <common/workers.h>
 #include <dotgen/dot.h>
 #include <limits.h>
+#include <math.h>
 #include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
@@ -40,6 +45,11 @@ static void flat_search(graph_t * g, node_t * v);
 static void init_mincross(graph_t * g);
 static void merge2(graph_t * g);
 static void init_mccomp(graph_t *g, size_t c);
+static bool mincross_comps(graph_t * g, int doBalance, int *nc,
+			   adjmatrix_t ** kept);
+static int mincross_restarts(graph_t * g, size_t comp, int doBalance);
+static void enqueue_shuffled(nodequeue * q, node_t * n0, int pass);
+static void warm_order(graph_t * g, Agsym_t * pos);
 static void cleanup2(graph_t * g, int nc);
 static int mincross_clust(graph_t * g, int);
 static int mincross(graph_t * g, int startpass, int endpass, int);
@@ -49,6 +59,7 @@ static void save_best(graph_t * g);
 static void restore_best(graph_t * g);
 static adjmatrix_t *new_matrix(int i, int j);
 static void free_matrix(adjmatrix_t * p);
+static void keep_flat(adjmatrix_t * flat, adjmatrix_t ** kept);
 static int ordercmpf(int *i0, int *i1);
 #ifdef DEBUG
 #if DEBUG > 1
@@ -65,14 +76,34 @@ void node_in_root_vlist(node_t * n);
 
 
 	/* mincross parameters */
-static int MinQuit;
-static double Convergence;
-
-static graph_t *Root;
-static int GlobalMinRank, GlobalMaxRank;
-static edge_t **TE_list;
-static int *TI_list;
-static bool ReMincross;
+static TLS int MinQuit;
+static TLS double Convergence;
+
+static TLS graph_t *Root;
+static TLS int GlobalMinRank, GlobalMaxRank;
+static TLS edge_t **TE_list;
+static TLS int *TI_list;
+static TLS bool ReMincross;
+static TLS int Restarts;	/* orderings tried per component */
+static TLS unsigned Seed;	/* for the orderings after the first */
+static TLS double Deadline;	/* wall clock time to stop trying, or 0 */
+static TLS bool Shuffle;	/* build_ranks starts its searches at random */
+static TLS bool OutOfTime;	/* the phase deadline has passed */
+static TLS bool Warm;		/* start from the orders of an earlier layout */
+static TLS int *Tree, T;	/* scratch space of tree_cross */
+static TLS bool LocalCross;	/* count only what a cluster can change */
+static TLS edge_t **Xedges;	/* scratch space of clust_rcross */
+static TLS size_t XE;
+static TLS rank_t *Ranks;	/* of Root, while a worker orders a component */
+static TLS node_t *Nlist;	/* and the nodes of that component */
+
+/* The ranks and node list mincross works on in g. A worker ordering one
+ * component of Root, in mincross_comps, has rank structures of its own,
+ * whose node arrays are its component's part of those of Root, so workers
+ * write nothing in the graph's records that the others read.
+ */
+#define RANKS(g)	(Ranks && (g) == Root ? Ranks : GD_rank(g))
+#define NLIST(g)	(Ranks && (g) == Root ? Nlist : GD_nlist(g))
 
 #if defined(DEBUG) && DEBUG > 1
 static void indent(graph_t* g)
@@ -85,7 +116,7 @@ static void indent(graph_t* g)
 
 static char* nname(node_t* v)
 {
-        static char buf[1000];
+        static TLS char buf[1000];
 	if (ND_node_type(v)) {
 		if (ND_ranktype(v) == CLUSTER)
 			snprintf(buf, sizeof(buf), "v%s_%p", agnameof(ND_clust(v)), v);
@@ -104,8 +135,8 @@ static void dumpg (graph_t* g)
     fprintf (stderr, "digraph A {\n");
     for (r = GD_minrank(g); r <= GD_maxrank(g); r++) {
 	fprintf (stderr, "  subgraph {rank=same  ");
-	for (i = 0; i < GD_rank(g)[r].n; i++) {
-	  v = GD_rank(g)[r].v[i];
+	for (i = 0; i < RANKS(g)[r].n; i++) {
+	  v = RANKS(g)[r].v[i];
           if (i > 0)
  	    fprintf (stderr, " -> %s", nname(v));
           else
@@ -115,8 +146,8 @@ static void dumpg (graph_t* g)
         else fprintf (stderr, " }\n");
     }
     for (r = GD_minrank(g); r < GD_maxrank(g); r++) {
-	for (i = 0; i < GD_rank(g)[r].n; i++) {
-	  v = GD_rank(g)[r].v[i];
+	for (i = 0; i < RANKS(g)[r].n; i++) {
+	  v = RANKS(g)[r].v[i];
 	  for (j = 0; (e = ND_out(v).list[j]); j++) {
              fprintf (stderr, "%s -> ", nname(v));
              fprintf (stderr, "%s\n", nname(aghead(e)));
@@ -133,16 +164,16 @@ static void dumpr (graph_t* g, int edges)
 
     for (r = GD_minrank(g); r <= GD_maxrank(g); r++) {
 	fprintf (stderr, "[%d] ", r);
-	for (i = 0; i < GD_rank(g)[r].n; i++) {
-	  v = GD_rank(g)[r].v[i];
+	for (i = 0; i < RANKS(g)[r].n; i++) {
+	  v = RANKS(g)[r].v[i];
  	  fprintf (stderr, "%s(%.02f,%d) ", nname(v), saveorder(v),ND_order(v));
         }
 	fprintf (stderr, "\n");
     }
     if (edges == 0) return;
     for (r = GD_minrank(g); r < GD_maxrank(g); r++) {
-	for (i = 0; i < GD_rank(g)[r].n; i++) {
-	  v = GD_rank(g)[r].v[i];
+	for (i = 0; i < RANKS(g)[r].n; i++) {
+	  v = RANKS(g)[r].v[i];
 	  for (j = 0; (e = ND_out(v).list[j]); j++) {
              fprintf (stderr, "%s -> ", nname(v));
              fprintf (stderr, "%s\n", nname(aghead(e)));
@@ -336,6 +367,7 @@ checkLabelOrder (graph_t* g)
  */
 void dot_mincross(graph_t * g, int doBalance)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     int nc;
     char *s;
 
@@ -357,12 +389,23 @@ void dot_mincross(graph_t * g, int doBalance)
     }
 
     init_mincross(g);
-
-    size_t comp;
-    for (nc = 0, comp = 0; comp < GD_comp(g).size; comp++) {
-	init_mccomp(g, comp);
-	nc += mincross(g, 0, 2, doBalance);
+    OutOfTime = false;
+
+    adjmatrix_t **kept = N_NEW(GD_maxrank(g) + 1, adjmatrix_t *);
+    if (!mincross_comps(g, doBalance, &nc, kept)) {
+	size_t comp;
+	for (nc = 0, comp = 0; comp < GD_comp(g).size; comp++) {
+	    init_mccomp(g, comp);
+	    nc += mincross_restarts(g, comp, doBalance);
+	    for (int r = GD_minrank(g); r <= GD_maxrank(g); r++) {
+		keep_flat(GD_rank(g)[r].flat, &kept[r]);
+		GD_rank(g)[r].flat = NULL;
+	    }
+	}
     }
+    for (int r = GD_minrank(g); r <= GD_maxrank(g); r++)
+	GD_rank(g)[r].flat = kept[r];
+    free(kept);
 
     merge2(g);
 
@@ -385,6 +428,8 @@ void dot_mincross(graph_t * g, int doBalance)
 #endif
     }
     cleanup2(g, nc);
+    if (OutOfTime)
+	lctx->PhaseTruncated = true;
 }
 
 static adjmatrix_t *new_matrix(int i, int j)
@@ -418,6 +463,393 @@ static void init_mccomp(graph_t *g, size_t c) {
     }
 }
 
+/* keep_order:
+ * Copy the order of the nodes of each rank of g into order.
+ */
+static void keep_order(graph_t * g, node_t ** order)
+{
+    size_t k = 0;
+
+    for (int r = GD_minrank(g); r <= GD_maxrank(g); r++)
+	for (int i = 0; i < RANKS(g)[r].n; i++)
+	    order[k++] = RANKS(g)[r].v[i];
+}
+
+/* put_order:
+ * Put the nodes of each rank of g back in the order kept by keep_order.
+ */
+static void put_order(graph_t * g, node_t ** order)
+{
+    size_t k = 0;
+
+    for (int r = GD_minrank(g); r <= GD_maxrank(g); r++) {
+	for (int i = 0; i < RANKS(g)[r].n; i++) {
+	    node_t *v = RANKS(g)[r].v[i] = order[k++];
+	    ND_order(v) = i;
+	}
+	RANKS(Root)[r].valid = false;
+    }
+}
+
+/* out_of_time:
+ * Whether the mincross phase has run past the deadline the layout gave it.
+ * Once true it stays so until the phase ends, so each loop stops at its next
+ * check and leaves the best order found so far.
+ */
+static bool out_of_time(void)
+{
+    if (!OutOfTime && phase_expired())
+	OutOfTime = true;
+    return OutOfTime;
+}
+
+/* mincross_restarts:
+ * Order component comp of g, installed in its ranks by init_mccomp, with
+ * mincross, then, if mcrestarts asks for more tries, again from other
+ * orders until the tries or the time given by mctimelimit run out. The
+ * other orders come from build_ranks starting its searches at random, with
+ * a sequence that depends only on mcseed, comp and the try, so the result
+ * does not depend on the threads used. The order with the fewest crossings
+ * is kept and its crossings returned. The cycles of flat edges are broken
+ * by the first try only; later ones keep to its matrices, as its second
+ * pass does. Warm starts are tried once, since their point is to keep the
+ * earlier order.
+ */
+static int mincross_restarts(graph_t * g, size_t comp, int doBalance)
+{
+    int nc = mincross(g, 0, 2, doBalance);
+    int tries;
+
+    if (Restarts <= 1 || Warm || nc == 0)
+	return nc;
+
+    size_t size = 0;
+    for (int r = GD_minrank(g); r <= GD_maxrank(g); r++)
+	size += (size_t)RANKS(g)[r].n;
+    node_t **best = N_NEW(size, node_t *);
+    keep_order(g, best);
+
+    for (tries = 1; tries < Restarts && nc > 0; tries++) {
+	if ((Deadline > 0 && wall_clock() >= Deadline) || out_of_time())
+	    break;
+	gv_srand(Seed + 7919u * (unsigned)comp + 104729u * (unsigned)tries);
+	Shuffle = true;
+	const int c = mincross(g, 0, 2, doBalance);
+	Shuffle = false;
+	if (c < nc) {
+	    nc = c;
+	    keep_order(g, best);
+	}
+    }
+    put_order(g, best);
+    free(best);
+    if (Verbose)
+	fprintf(stderr, "mincross: component %zu: %d crossings after %d tries\n",
+		comp, nc, tries);
+    return nc;
+}
+
+/* keep_flat:
+ * Each component breaks the cycles of its own flat edges in matrices of its
+ * own. Once all are ordered, each rank is left with the last matrix made
+ * for it, which the passes over the whole graph use; kept holds it.
+ */
+static void keep_flat(adjmatrix_t * flat, adjmatrix_t ** kept)
+{
+    if (flat == NULL)
+	return;
+    free_matrix(*kept);
+    *kept = flat;
+}
+
+/* The components of a graph, ordered by several threads at once. Each
+ * component is ordered in rank structures of its own, see RANKS, whose node
+ * arrays are its part of the node arrays of the root, where the serial loop
+ * of dot_mincross would put it, so the merged ranks are the same.
+ */
+typedef struct {
+    graph_t *g;
+    int doBalance;
+    layout_context_t *ctx;	/* of the calling thread */
+    int minquit;
+    double convergence;
+    int restarts;
+    unsigned seed;
+    double deadline;
+    size_t n_edges;	/* for the size of TE_list and TI_list */
+    size_t n;		/* components */
+    int *nodes;		/* nodes of each component */
+    int *lo, *hi;	/* ranks of each component */
+    int **offset;	/* first place in each of its ranks */
+    int **count;	/* nodes in each of its ranks */
+    adjmatrix_t ***flat;	/* the flat edge matrices of each of its ranks */
+    size_t *part;	/* the worker ordering each component */
+    int *nc;		/* crossings left in each component */
+    bool *failed;	/* did not fill its ranks as expected */
+    bool *truncated;	/* stopped at the phase deadline */
+    rank_t *last;	/* the ranks of the last component */
+} mccomps_t;
+
+/* mincross_comp:
+ * Order component c of mc, in this thread, as dot_mincross does.
+ */
+static void mincross_comp(mccomps_t * mc, size_t c)
+{
+    graph_t *g = mc->g;
+    rank_t *rank = N_NEW(GD_maxrank(g) + 2, rank_t);
+    int r;
+
+    for (r = GD_minrank(g); r <= GD_maxrank(g); r++) {
+	rank[r] = GD_rank(g)[r];
+	rank[r].v = rank[r].av;
+	if (r >= mc->lo[c] && r <= mc->hi[c])
+	    rank[r].v += mc->offset[c][r - mc->lo[c]];
+	rank[r].n = 0;
+	rank[r].valid = false;
+	rank[r].flat = NULL;
+    }
+
+    Ranks = rank;
+    Nlist = GD_comp(g).list[c];
+    mc->nc[c] = mincross_restarts(g, c, mc->doBalance);
+    mc->truncated[c] = OutOfTime;
+    Ranks = NULL;
+    Nlist = NULL;
+
+    for (r = GD_minrank(g); r <= GD_maxrank(g); r++) {
+	int n = r >= mc->lo[c] && r <= mc->hi[c] ?
+	    mc->count[c][r - mc->lo[c]] : 0;
+	if (rank[r].n != n)
+	    mc->failed[c] = true;
+	if (n > 0) {
+	    mc->flat[c][r - mc->lo[c]] = rank[r].flat;
+	    rank[r].flat = NULL;
+	}
+	free_matrix(rank[r].flat);
+    }
+    /* the serial loop leaves the crossings of the last component cached */
+    if (c + 1 == mc->n)
+	mc->last = rank;
+    else
+	free(rank);
+}
+
+/* mincross_part:
+ * Order the components given to worker index, with the mincross state of
+ * this thread set up as init_mincross sets it up for mc->g.
+ */
+static void mincross_part(void *arg, size_t index)
+{
+    mccomps_t *mc = arg;
+    layout_context_t *ctx = gvSetLayoutContext(mc->ctx);
+    graph_t *root = Root;
+    edge_t **te_list = TE_list;
+    int *ti_list = TI_list;
+    int minquit = MinQuit;
+    double convergence = Convergence;
+    bool remincross = ReMincross;
+    int restarts = Restarts;
+    unsigned seed = Seed;
+    double deadline = Deadline;
+    bool out_of_time = OutOfTime;
+    bool warm = Warm;
+    int *tree = Tree, t = T;
+    int min_rank = GlobalMinRank, max_rank = GlobalMaxRank;
+
+    Root = mc->g;
+    TE_list = N_NEW(mc->n_edges + 1, edge_t *);
+    TI_list = N_NEW(mc->n_edges + 1, int);
+    MinQuit = mc->minquit;
+    Convergence = mc->convergence;
+    Restarts = mc->restarts;
+    Seed = mc->seed;
+    Deadline = mc->deadline;
+    OutOfTime = false;
+    Warm = false;
+    ReMincross = false;
+    Tree = NULL;
+    T = 0;
+    GlobalMinRank = GD_minrank(mc->g);
+    GlobalMaxRank = GD_maxrank(mc->g);
+
+    for (size_t i = 0; i < mc->n; i++)
+	if (mc->part[i] == index)
+	    mincross_comp(mc, i);
+
+    free(TE_list);
+    free(TI_list);
+    free(Tree);
+    Root = root;
+    TE_list = te_list;
+    TI_list = ti_list;
+    MinQuit = minquit;
+    Convergence = convergence;
+    Restarts = restarts;
+    Seed = seed;
+    Deadline = deadline;
+    OutOfTime = out_of_time;
+    Warm = warm;
+    ReMincross = remincross;
+    Tree = tree;
+    T = t;
+    GlobalMinRank = min_rank;
+    GlobalMaxRank = max_rank;
+    gvSetLayoutContext(ctx);
+}
+
+static int cmpcomp(const void *x, const void *y, void *arg)
+{
+    const size_t *a = x, *b = y;
+    const int *nodes = arg;
+    if (nodes[*a] != nodes[*b])
+	return nodes[*a] > nodes[*b] ? -1 : 1;
+    if (*a != *b)
+	return *a < *b ? -1 : 1;
+    return 0;
+}
+
+/* mincross_comps:
+ * Order the components of g as the loop in dot_mincross does, but in
+ * several threads, if the threads attribute of g asks for more than one and
+ * g has several components. Components do not share nodes or edges, so they
+ * can be ordered at once; the nodes of each are placed in the ranks where
+ * the serial loop would place them, giving the same result. Warm starts are
+ * left to the loop, since they read the earlier layout through attribute
+ * lookups that reorganize the graph's shared dictionaries, and so are
+ * graphs that are not roots, whose nodes in_graph looks up. Returns false
+ * if the components were not ordered, else stores their crossings in nc.
+ */
+static bool mincross_comps(graph_t * g, int doBalance, int *nc,
+			   adjmatrix_t ** kept)
+{
+    mccomps_t mc = {0};
+    node_t *v;
+    int r;
+
+    const size_t threads = workers_threads(g);
+    if (threads <= 1 || GD_comp(g).size <= 1 || Warm || g != agroot(g) ||
+	g != dot_root(g))
+	return false;
+
+    mc.g = g;
+    mc.doBalance = doBalance;
+    mc.ctx = gvLayoutContext();
+    mc.minquit = MinQuit;
+    mc.convergence = Convergence;
+    mc.restarts = Restarts;
+    mc.seed = Seed;
+    mc.deadline = Deadline;
+    mc.n_edges = (size_t)agnedges(g);
+    mc.n = GD_comp(g).size;
+    mc.nodes = N_NEW(mc.n, int);
+    mc.lo = N_NEW(mc.n, int);
+    mc.hi = N_NEW(mc.n, int);
+    mc.offset = N_NEW(mc.n, int *);
+    mc.count = N_NEW(mc.n, int *);
+    mc.flat = N_NEW(mc.n, adjmatrix_t **);
+    mc.part = N_NEW(mc.n, size_t);
+    mc.nc = N_NEW(mc.n, int);
+    mc.failed = N_NEW(mc.n, bool);
+    mc.truncated = N_NEW(mc.n, bool);
+
+    /* the place of each component in each rank, as init_mccomp finds it */
+    int *next = N_NEW(GD_maxrank(g) + 2, int);
+    for (size_t c = 0; c < mc.n; c++) {
+	mc.lo[c] = INT_MAX;
+	mc.hi[c] = INT_MIN;
+	for (v = GD_comp(g).list[c]; v; v = ND_next(v)) {
+	    mc.lo[c] = MIN(mc.lo[c], ND_rank(v));
+	    mc.hi[c] = MAX(mc.hi[c], ND_rank(v));
+	    mc.nodes[c]++;
+	}
+	if (mc.nodes[c] == 0) {
+	    mc.lo[c] = GD_minrank(g);
+	    mc.hi[c] = mc.lo[c] - 1;
+	}
+	mc.offset[c] = N_NEW(mc.hi[c] - mc.lo[c] + 1, int);
+	mc.count[c] = N_NEW(mc.hi[c] - mc.lo[c] + 1, int);
+	mc.flat[c] = N_NEW(mc.hi[c] - mc.lo[c] + 1, adjmatrix_t *);
+	for (v = GD_comp(g).list[c]; v; v = ND_next(v))
+	    mc.count[c][ND_rank(v) - mc.lo[c]]++;
+	for (r = mc.lo[c]; r <= mc.hi[c]; r++) {
+	    mc.offset[c][r - mc.lo[c]] = next[r];
+	    next[r] += mc.count[c][r - mc.lo[c]];
+	}
+    }
+    free(next);
+
+    /* give the largest components out first, each to the least busy worker */
+    workers_t *workers = workers_new(MIN(threads, mc.n));
+    const size_t parts = workers_size(workers);
+    size_t *order = N_NEW(mc.n, size_t);
+    int *load = N_NEW(parts, int);
+    for (size_t c = 0; c < mc.n; c++)
+	order[c] = c;
+    gv_sort(order, mc.n, sizeof(order[0]), cmpcomp, mc.nodes);
+    for (size_t i = 0; i < mc.n; i++) {
+	size_t best = 0;
+	for (size_t p = 1; p < parts; p++)
+	    if (load[p] < load[best])
+		best = p;
+	mc.part[order[i]] = best;
+	load[best] += mc.nodes[order[i]];
+    }
+    free(order);
+    free(load);
+
+    if (Verbose)
+	fprintf(stderr, "mincross: %zu components in %zu threads\n", mc.n,
+		parts);
+    workers_run(workers, mincross_part, &mc);
+    workers_free(workers);
+
+    /* merge what the workers found as the serial loop would leave it */
+    bool failed = false;
+    *nc = 0;
+    for (size_t c = 0; c < mc.n; c++) {
+	*nc += mc.nc[c];
+	failed |= mc.failed[c];
+	OutOfTime |= mc.truncated[c];
+	for (r = mc.lo[c]; r <= mc.hi[c]; r++)
+	    keep_flat(mc.flat[c][r - mc.lo[c]], &kept[r]);
+    }
+    GD_nlist(g) = GD_comp(g).list[mc.n - 1];
+    for (r = GD_minrank(g); r <= GD_maxrank(g); r++) {
+	GD_rank(g)[r].v = GD_rank(g)[r].av;
+	GD_rank(g)[r].n = 0;
+	GD_rank(g)[r].candidate = mc.last[r].candidate;
+	GD_rank(g)[r].valid = mc.last[r].valid;
+	GD_rank(g)[r].cache_nc = mc.last[r].cache_nc;
+    }
+    if (failed) {
+	for (r = GD_minrank(g); r <= GD_maxrank(g); r++) {
+	    free_matrix(kept[r]);
+	    kept[r] = NULL;
+	}
+	if (Verbose)
+	    fprintf(stderr,
+		    "mincross: components overlap, ordering them again\n");
+    }
+
+    for (size_t c = 0; c < mc.n; c++) {
+	free(mc.offset[c]);
+	free(mc.count[c]);
+	free(mc.flat[c]);
+    }
+    free(mc.nodes);
+    free(mc.lo);
+    free(mc.hi);
+    free(mc.offset);
+    free(mc.count);
+    free(mc.flat);
+    free(mc.part);
+    free(mc.nc);
+    free(mc.failed);
+    free(mc.truncated);
+    free(mc.last);
+    return !failed;
+}
+
 static int betweenclust(edge_t * e)
 {
     while (ED_to_orig(e))
@@ -478,12 +910,13 @@ static void do_ordering(graph_t * g, int outflag)
 
 static void do_ordering_for_nodes(graph_t * g)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     /* Order nodes which have the "ordered" attribute */
     node_t *n;
     const char *ordering;
 
     for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
-	if ((ordering = late_string(n, N_ordering, NULL))) {
+	if ((ordering = late_string(n, lctx->N_ordering, NULL))) {
 	    if (streq(ordering, "out"))
 		do_ordering_node(g, n, TRUE);
 	    else if (streq(ordering, "in"))
@@ -503,11 +936,12 @@ static void do_ordering_for_nodes(graph_t * g)
  */
 static void ordered_edges(graph_t * g)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     char *ordering;
 
-    if (!G_ordering && !N_ordering)
+    if (!lctx->G_ordering && !lctx->N_ordering)
 	return;
-    if ((ordering = late_string(g, G_ordering, NULL))) {
+    if ((ordering = late_string(g, lctx->G_ordering, NULL))) {
 	if (streq(ordering, "out"))
 	    do_ordering(g, TRUE);
 	else if (streq(ordering, "in"))
@@ -524,7 +958,7 @@ static void ordered_edges(graph_t * g)
 	    if (!is_cluster(subg))
 		ordered_edges(subg);
 	}
-	if (N_ordering) do_ordering_for_nodes (g);
+	if (lctx->N_ordering) do_ordering_for_nodes (g);
     }
 }
 
@@ -564,7 +998,7 @@ static int left2right(graph_t * g, node_t * v, node_t * w)
 	if (ND_clust(v) != ND_clust(w))
 	    return TRUE;
     }
-    M = GD_rank(g)[ND_rank(v)].flat;
+    M = RANKS(g)[ND_rank(v)].flat;
     if (M == NULL)
 	rv = FALSE;
     else {
@@ -573,7 +1007,13 @@ static int left2right(graph_t * g, node_t * v, node_t * w)
 	    v = w;
 	    w = t;
 	}
-	rv = ELT(M, flatindex(v), flatindex(w));
+	/* the passes over the whole graph see the matrix of one component,
+	 * made before clusters were expanded; it says nothing of the nodes
+	 * past its end */
+	if (flatindex(v) >= M->nrows || flatindex(w) >= M->ncols)
+	    rv = FALSE;
+	else
+	    rv = ELT(M, flatindex(v), flatindex(w));
     }
     return rv;
 }
@@ -624,9 +1064,9 @@ static void exchange(node_t * v, node_t * w)
     vi = ND_order(v);
     wi = ND_order(w);
     ND_order(v) = wi;
-    GD_rank(Root)[r].v[wi] = v;
+    RANKS(Root)[r].v[wi] = v;
     ND_order(w) = vi;
-    GD_rank(Root)[r].v[vi] = w;
+    RANKS(Root)[r].v[vi] = w;
 }
 
 static void balanceNodes(graph_t * g, int r, node_t * v, node_t * w)
@@ -642,8 +1082,8 @@ static void balanceNodes(graph_t * g, int r, node_t * v, node_t * w)
 	return;
 
     /* count the number of dummy and original nodes */
-    for (i = 0; i < GD_rank(g)[r].n; i++) {
-	if (ND_node_type(GD_rank(g)[r].v[i]) == NORMAL)
+    for (i = 0; i < RANKS(g)[r].n; i++) {
+	if (ND_node_type(RANKS(g)[r].v[i]) == NORMAL)
 	    cntOri++;
 	else
 	    cntDummy++;
@@ -662,8 +1102,8 @@ static void balanceNodes(graph_t * g, int r, node_t * v, node_t * w)
     }
 
     /* get the separator node index */
-    for (i = 0; i < GD_rank(g)[r].n; i++) {
-	if (GD_rank(g)[r].v[i] == s)
+    for (i = 0; i < RANKS(g)[r].n; i++) {
+	if (RANKS(g)[r].v[i] == s)
 	    sepIndex = i;
     }
 
@@ -673,14 +1113,14 @@ static void balanceNodes(graph_t * g, int r, node_t * v, node_t * w)
      * right of the separator node 
      */
     for (i = sepIndex - 1; i >= 0; i--) {
-	if (ND_node_type(GD_rank(g)[r].v[i]) == nullType)
+	if (ND_node_type(RANKS(g)[r].v[i]) == nullType)
 	    k++;
 	else
 	    break;
     }
 
-    for (i = sepIndex + 1; i < GD_rank(g)[r].n; i++) {
-	if (ND_node_type(GD_rank(g)[r].v[i]) == nullType)
+    for (i = sepIndex + 1; i < RANKS(g)[r].n; i++) {
+	if (ND_node_type(RANKS(g)[r].v[i]) == nullType)
 	    m++;
 	else
 	    break;
@@ -691,8 +1131,8 @@ static void balanceNodes(graph_t * g, int r, node_t * v, node_t * w)
     exchange(v, w);
 
     /* get the separator node index */
-    for (i = 0; i < GD_rank(g)[r].n; i++) {
-	if (GD_rank(g)[r].v[i] == s)
+    for (i = 0; i < RANKS(g)[r].n; i++) {
+	if (RANKS(g)[r].v[i] == s)
 	    sepIndex = i;
     }
 
@@ -700,14 +1140,14 @@ static void balanceNodes(graph_t * g, int r, node_t * v, node_t * w)
      * right of the separator node 
      */
     for (i = sepIndex - 1; i >= 0; i--) {
-	if (ND_node_type(GD_rank(g)[r].v[i]) == nullType)
+	if (ND_node_type(RANKS(g)[r].v[i]) == nullType)
 	    k1++;
 	else
 	    break;
     }
 
-    for (i = sepIndex + 1; i < GD_rank(g)[r].n; i++) {
-	if (ND_node_type(GD_rank(g)[r].v[i]) == nullType)
+    for (i = sepIndex + 1; i < RANKS(g)[r].n; i++) {
+	if (ND_node_type(RANKS(g)[r].v[i]) == nullType)
 	    m1++;
 	else
 	    break;
@@ -728,10 +1168,10 @@ static int balance(graph_t * g)
 
     for (r = GD_maxrank(g); r >= GD_minrank(g); r--) {
 
-	GD_rank(g)[r].candidate = false;
-	for (i = 0; i < GD_rank(g)[r].n - 1; i++) {
-	    v = GD_rank(g)[r].v[i];
-	    w = GD_rank(g)[r].v[i + 1];
+	RANKS(g)[r].candidate = false;
+	for (i = 0; i < RANKS(g)[r].n - 1; i++) {
+	    v = RANKS(g)[r].v[i];
+	    w = RANKS(g)[r].v[i + 1];
 	    assert(ND_order(v) < ND_order(w));
 	    if (left2right(g, v, w))
 		continue;
@@ -741,7 +1181,7 @@ static int balance(graph_t * g)
 		c1 += in_cross(w, v);
 	    }
 
-	    if (GD_rank(g)[r + 1].n > 0) {
+	    if (RANKS(g)[r + 1].n > 0) {
 		c0 += out_cross(v, w);
 		c1 += out_cross(w, v);
 	    }
@@ -760,36 +1200,36 @@ static int transpose_step(graph_t * g, int r, bool reverse)
     node_t *v, *w;
 
     rv = 0;
-    GD_rank(g)[r].candidate = false;
-    for (i = 0; i < GD_rank(g)[r].n - 1; i++) {
-	v = GD_rank(g)[r].v[i];
-	w = GD_rank(g)[r].v[i + 1];
+    RANKS(g)[r].candidate = false;
+    for (i = 0; i < RANKS(g)[r].n - 1; i++) {
+	v = RANKS(g)[r].v[i];
+	w = RANKS(g)[r].v[i + 1];
 	assert(ND_order(v) < ND_order(w));
 	if (left2right(g, v, w))
 	    continue;
+	if (Warm && ND_settled(v) && ND_settled(w))
+	    continue;
 	c0 = c1 = 0;
 	if (r > 0) {
 	    c0 += in_cross(v, w);
 	    c1 += in_cross(w, v);
 	}
-	if (GD_rank(g)[r + 1].n > 0) {
+	if (RANKS(g)[r + 1].n > 0) {
 	    c0 += out_cross(v, w);
 	    c1 += out_cross(w, v);
 	}
 	if (c1 < c0 || (c0 > 0 && reverse && c1 == c0)) {
 	    exchange(v, w);
 	    rv += c0 - c1;
-	    GD_rank(Root)[r].valid = false;
-	    GD_rank(g)[r].candidate = true;
+	    RANKS(Root)[r].valid = false;
+	    RANKS(g)[r].candidate = true;
 
 	    if (r > GD_minrank(g)) {
-		GD_rank(Root)[r - 1].valid = false;
-		GD_rank(g)[r - 1].candidate = true;
-	    }
-	    if (r < GD_maxrank(g)) {
-		GD_rank(Root)[r + 1].valid = false;
-		GD_rank(g)[r + 1].candidate = true;
+		RANKS(Root)[r - 1].valid = false;
+		RANKS(g)[r - 1].candidate = true;
 	    }
+	    if (r < GD_maxrank(g))
+		RANKS(g)[r + 1].candidate = true;
 	}
     }
     return rv;
@@ -800,19 +1240,20 @@ static void transpose(graph_t * g, bool reverse)
     int r, delta;
 
     for (r = GD_minrank(g); r <= GD_maxrank(g); r++)
-	GD_rank(g)[r].candidate = true;
+	RANKS(g)[r].candidate = true;
     do {
 	delta = 0;
 	for (r = GD_minrank(g); r <= GD_maxrank(g); r++) {
-	    if (GD_rank(g)[r].candidate) {
+	    if (RANKS(g)[r].candidate) {
 		delta += transpose_step(g, r, reverse);
 	    }
 	}
-    } while (delta >= 1);
+    } while (delta >= 1 && !out_of_time());
 }
 
 static int mincross(graph_t * g, int startpass, int endpass, int doBalance)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     int maxthispass = 0, iter, trying, pass;
     int cur_cross, best_cross;
 
@@ -822,11 +1263,15 @@ static int mincross(graph_t * g, int startpass, int endpass, int doBalance)
     } else
 	cur_cross = best_cross = INT_MAX;
     for (pass = startpass; pass <= endpass; pass++) {
+	/* the other initial order would not be the earlier one */
+	if (pass == 1 && Warm)
+	    continue;
 	if (pass <= 1) {
-	    maxthispass = MIN(4, MaxIter);
+	    maxthispass = MIN(4, lctx->MaxIter);
 	    if (g == dot_root(g))
 		build_ranks(g, pass);
-	    if (pass == 0)
+	    /* a restart keeps the cycles the first try broke */
+	    if (pass == 0 && !Shuffle)
 		flat_breakcycles(g);
 	    flat_reorder(g);
 
@@ -835,7 +1280,7 @@ static int mincross(graph_t * g, int startpass, int endpass, int doBalance)
 		best_cross = cur_cross;
 	    }
 	} else {
-	    maxthispass = MaxIter;
+	    maxthispass = lctx->MaxIter;
 	    if (cur_cross > best_cross)
 		restore_best(g);
 	    cur_cross = best_cross;
@@ -848,7 +1293,7 @@ static int mincross(graph_t * g, int startpass, int endpass, int doBalance)
 			pass, iter, trying, cur_cross, best_cross);
 	    if (trying++ >= MinQuit)
 		break;
-	    if (cur_cross == 0)
+	    if (cur_cross == 0 || out_of_time())
 		break;
 	    mincross_step(g, iter);
 	    if ((cur_cross = ncross(g)) <= best_cross) {
@@ -858,7 +1303,7 @@ static int mincross(graph_t * g, int startpass, int endpass, int doBalance)
 		best_cross = cur_cross;
 	    }
 	}
-	if (cur_cross == 0)
+	if (cur_cross == 0 || out_of_time())
 	    break;
     }
     if (cur_cross > best_cross)
@@ -881,14 +1326,22 @@ static void restore_best(graph_t * g)
     int i, r;
 
     for (r = GD_minrank(g); r <= GD_maxrank(g); r++) {
-	for (i = 0; i < GD_rank(g)[r].n; i++) {
-	    n = GD_rank(g)[r].v[i];
+	bool changed = false;
+	for (i = 0; i < RANKS(g)[r].n; i++) {
+	    n = RANKS(g)[r].v[i];
+	    if (ND_order(n) != saveorder(n))
+		changed = true;
 	    ND_order(n) = saveorder(n);
 	}
+	/* only the crossings next to a reordered rank change */
+	if (changed) {
+	    RANKS(Root)[r].valid = false;
+	    if (r > GlobalMinRank)
+		RANKS(Root)[r - 1].valid = false;
+	}
     }
     for (r = GD_minrank(g); r <= GD_maxrank(g); r++) {
-	GD_rank(Root)[r].valid = false;
-	qsort(GD_rank(g)[r].v, GD_rank(g)[r].n, sizeof(GD_rank(g)[0].v[0]),
+	qsort(RANKS(g)[r].v, RANKS(g)[r].n, sizeof(RANKS(g)[0].v[0]),
 	      (qsort_cmpf) nodeposcmpf);
     }
 }
@@ -898,8 +1351,8 @@ static void save_best(graph_t * g)
     node_t *n;
     int i, r;
     for (r = GD_minrank(g); r <= GD_maxrank(g); r++) {
-	for (i = 0; i < GD_rank(g)[r].n; i++) {
-	    n = GD_rank(g)[r].v[i];
+	for (i = 0; i < RANKS(g)[r].n; i++) {
+	    n = RANKS(g)[r].v[i];
 	    saveorder(n) = ND_order(n);
 	}
     }
@@ -940,16 +1393,16 @@ static void merge2(graph_t * g)
 
     /* install complete ranks */
     for (r = GD_minrank(g); r <= GD_maxrank(g); r++) {
-	GD_rank(g)[r].n = GD_rank(g)[r].an;
-	GD_rank(g)[r].v = GD_rank(g)[r].av;
-	for (i = 0; i < GD_rank(g)[r].n; i++) {
-	    v = GD_rank(g)[r].v[i];
+	RANKS(g)[r].n = RANKS(g)[r].an;
+	RANKS(g)[r].v = RANKS(g)[r].av;
+	for (i = 0; i < RANKS(g)[r].n; i++) {
+	    v = RANKS(g)[r].v[i];
 	    if (v == NULL) {
 		if (Verbose)
 		    fprintf(stderr,
 			    "merge2: graph %s, rank %d has only %d < %d nodes\n",
-			    agnameof(g), r, i, GD_rank(g)[r].n);
-		GD_rank(g)[r].n = i;
+			    agnameof(g), r, i, RANKS(g)[r].n);
+		RANKS(g)[r].n = i;
 		break;
 	    }
 	    ND_order(v) = i;
@@ -977,8 +1430,8 @@ static void cleanup2(graph_t * g, int nc)
 
     /* remove node temporary edges for ordering nodes */
     for (r = GD_minrank(g); r <= GD_maxrank(g); r++) {
-	for (i = 0; i < GD_rank(g)[r].n; i++) {
-	    v = GD_rank(g)[r].v[i];
+	for (i = 0; i < RANKS(g)[r].n; i++) {
+	    v = RANKS(g)[r].v[i];
 	    ND_order(v) = i;
 	    if (ND_flat_out(v).list) {
 		for (j = 0; (e = ND_flat_out(v).list[j]); j++)
@@ -990,7 +1443,7 @@ static void cleanup2(graph_t * g, int nc)
 		    }
 	    }
 	}
-	free_matrix(GD_rank(g)[r].flat);
+	free_matrix(RANKS(g)[r].flat);
     }
     if (Verbose)
 	fprintf(stderr, "mincross %s: %d crossings, %.2f secs.\n",
@@ -1005,16 +1458,31 @@ static node_t *neighbor(node_t * v, int dir)
 assert(v);
     if (dir < 0) {
 	if (ND_order(v) > 0)
-	    rv = GD_rank(Root)[ND_rank(v)].v[ND_order(v) - 1];
+	    rv = RANKS(Root)[ND_rank(v)].v[ND_order(v) - 1];
     } else
-	rv = GD_rank(Root)[ND_rank(v)].v[ND_order(v) + 1];
+	rv = RANKS(Root)[ND_rank(v)].v[ND_order(v) + 1];
 assert((rv == 0) || (ND_order(rv)-ND_order(v))*dir > 0);
     return rv;
 }
 
+/* in_graph:
+ * Whether g contains node or edge obj, as agcontains tells, but without
+ * searching the dictionaries of a root graph, which holds every node that
+ * is not virtual and every edge that is not. Workers ordering components of
+ * the root at once must not search them, as searching reorganizes them.
+ */
+static bool in_graph(graph_t * g, void *obj)
+{
+    if (g != agroot(g))
+	return agcontains(g, obj);
+    if (AGTYPE(obj) == AGNODE)
+	return ND_node_type((node_t *) obj) == NORMAL;
+    return ED_edge_type((edge_t *) obj) == NORMAL;
+}
+
 static int is_a_normal_node_of(graph_t * g, node_t * v)
 {
-    return ND_node_type(v) == NORMAL && agcontains(g, v);
+    return ND_node_type(v) == NORMAL && in_graph(g, v);
 }
 
 static int is_a_vnode_of_an_edge_of(graph_t * g, node_t * v)
@@ -1024,7 +1492,7 @@ static int is_a_vnode_of_an_edge_of(graph_t * g, node_t * v)
 	edge_t *e = ND_out(v).list[0];
 	while (ED_edge_type(e) != NORMAL)
 	    e = ED_to_orig(e);
-	if (agcontains(g, e))
+	if (in_graph(g, e))
 	    return TRUE;
     }
     return FALSE;
@@ -1055,7 +1523,7 @@ void save_vlist(graph_t * g)
 
     if (GD_rankleader(g))
 	for (r = GD_minrank(g); r <= GD_maxrank(g); r++) {
-	    GD_rankleader(g)[r] = GD_rank(g)[r].v[0];
+	    GD_rankleader(g)[r] = RANKS(g)[r].v[0];
 	}
 }
 
@@ -1091,7 +1559,7 @@ void rec_reset_vlists(graph_t * g)
 	    assert(GD_rank(dot_root(g))[r].v[ND_order(u)] == u);
 #endif
 	    GD_rank(g)[r].v = GD_rank(dot_root(g))[r].v + ND_order(u);
-	    GD_rank(g)[r].n = ND_order(w) - ND_order(u) + 1;
+	    RANKS(g)[r].n = ND_order(w) - ND_order(u) + 1;
 	}
 }
 
@@ -1211,14 +1679,14 @@ static void flat_search(graph_t * g, node_t * v)
     int i;
     bool hascl;
     edge_t *e;
-    adjmatrix_t *M = GD_rank(g)[ND_rank(v)].flat;
+    adjmatrix_t *M = RANKS(g)[ND_rank(v)].flat;
 
     ND_mark(v) = TRUE;
     ND_onstack(v) = true;
     hascl = GD_n_cluster(dot_root(g)) > 0;
     if (ND_flat_out(v).list)
 	for (i = 0; (e = ND_flat_out(v).list[i]); i++) {
-	    if (hascl && !(agcontains(g, agtail(e)) && agcontains(g, aghead(e))))
+	    if (hascl && !(in_graph(g, agtail(e)) && in_graph(g, aghead(e))))
 		continue;
 	    if (ED_weight(e) == 0)
 		continue;
@@ -1249,20 +1717,20 @@ static void flat_breakcycles(graph_t * g)
 
     for (r = GD_minrank(g); r <= GD_maxrank(g); r++) {
 	flat = 0;
-	for (i = 0; i < GD_rank(g)[r].n; i++) {
-	    v = GD_rank(g)[r].v[i];
+	for (i = 0; i < RANKS(g)[r].n; i++) {
+	    v = RANKS(g)[r].v[i];
 	    ND_mark(v) = FALSE;
 	    ND_onstack(v) = false;
 	    flatindex(v) = i;
 	    if (ND_flat_out(v).size > 0 && flat == 0) {
-		GD_rank(g)[r].flat =
-		    new_matrix(GD_rank(g)[r].n, GD_rank(g)[r].n);
+		RANKS(g)[r].flat =
+		    new_matrix(RANKS(g)[r].n, RANKS(g)[r].n);
 		flat = 1;
 	    }
 	}
 	if (flat) {
-	    for (i = 0; i < GD_rank(g)[r].n; i++) {
-		v = GD_rank(g)[r].v[i];
+	    for (i = 0; i < RANKS(g)[r].n; i++) {
+		v = RANKS(g)[r].v[i];
 		if (!ND_mark(v))
 		    flat_search(g, v);
 	    }
@@ -1309,30 +1777,30 @@ void install_in_rank(graph_t * g, node_t * n)
     int i, r;
 
     r = ND_rank(n);
-    i = GD_rank(g)[r].n;
-    if (GD_rank(g)[r].an <= 0) {
+    i = RANKS(g)[r].n;
+    if (RANKS(g)[r].an <= 0) {
 	agerr(AGERR, "install_in_rank, line %d: %s %s rank %d i = %d an = 0\n",
 	      __LINE__, agnameof(g), agnameof(n), r, i);
 	return;
     }
 
-    GD_rank(g)[r].v[i] = n;
+    RANKS(g)[r].v[i] = n;
     ND_order(n) = i;
-    GD_rank(g)[r].n++;
-    assert(GD_rank(g)[r].n <= GD_rank(g)[r].an);
+    RANKS(g)[r].n++;
+    assert(RANKS(g)[r].n <= RANKS(g)[r].an);
 #ifdef DEBUG
     {
 	node_t *v;
 
-	for (v = GD_nlist(g); v; v = ND_next(v))
+	for (v = NLIST(g); v; v = ND_next(v))
 	    if (v == n)
 		break;
 	assert(v != NULL);
     }
 #endif
-    if (ND_order(n) > GD_rank(Root)[r].an) {
+    if (ND_order(n) > RANKS(Root)[r].an) {
 	agerr(AGERR, "install_in_rank, line %d: ND_order(%s) [%d] > GD_rank(Root)[%d].an [%d]\n",
-	      __LINE__, agnameof(n), ND_order(n), r, GD_rank(Root)[r].an);
+	      __LINE__, agnameof(n), ND_order(n), r, RANKS(Root)[r].an);
 	return;
     }
     if (r < GD_minrank(g) || r > GD_maxrank(g)) {
@@ -1340,10 +1808,10 @@ void install_in_rank(graph_t * g, node_t * n)
 	      __LINE__, r, GD_minrank(g), GD_maxrank(g));
 	return;
     }
-    if (GD_rank(g)[r].v + ND_order(n) >
-	GD_rank(g)[r].av + GD_rank(Root)[r].an) {
+    if (RANKS(g)[r].v + ND_order(n) >
+	RANKS(g)[r].av + RANKS(Root)[r].an) {
 	agerr(AGERR, "install_in_rank, line %d: GD_rank(g)[%d].v + ND_order(%s) [%d] > GD_rank(g)[%d].av + GD_rank(Root)[%d].an [%d]\n",
-	      __LINE__, r, agnameof(n),ND_order(n), r, r, GD_rank(Root)[r].an);
+	      __LINE__, r, agnameof(n),ND_order(n), r, r, RANKS(Root)[r].an);
 	return;
     }
 }
@@ -1360,13 +1828,13 @@ void build_ranks(graph_t * g, int pass)
     nodequeue *q;
 
     q = new_queue(GD_n_nodes(g));
-    for (n = GD_nlist(g); n; n = ND_next(n))
+    for (n = NLIST(g); n; n = ND_next(n))
 	MARK(n) = FALSE;
 
 #ifdef DEBUG
     {
 	edge_t *e;
-	for (n = GD_nlist(g); n; n = ND_next(n)) {
+	for (n = NLIST(g); n; n = ND_next(n)) {
 	    for (i = 0; (e = ND_out(n).list[i]); i++)
 		assert(!MARK(aghead(e)));
 	    for (i = 0; (e = ND_in(n).list[i]); i++)
@@ -1376,43 +1844,255 @@ void build_ranks(graph_t * g, int pass)
 #endif
 
     for (i = GD_minrank(g); i <= GD_maxrank(g); i++)
-	GD_rank(g)[i].n = 0;
+	RANKS(g)[i].n = 0;
 
-    for (n = GD_nlist(g); n; n = ND_next(n)) {
+    /* the nodes to start searches from, in random order if Shuffle */
+    node_t **starts = N_NEW(GD_n_nodes(g) + 1, node_t *);
+    size_t n_starts = 0;
+    for (n = NLIST(g); n; n = ND_next(n)) {
 	otheredges = pass == 0 ? ND_in(n).list : ND_out(n).list;
-	if (otheredges[0] != NULL)
-	    continue;
+	if (otheredges[0] == NULL)
+	    starts[n_starts++] = n;
+    }
+    if (Shuffle)
+	for (size_t k = n_starts; k > 1; k--) {
+	    size_t l = (size_t)gv_rand() % k;
+	    n = starts[k - 1];
+	    starts[k - 1] = starts[l];
+	    starts[l] = n;
+	}
+
+    for (size_t k = 0; k < n_starts; k++) {
+	n = starts[k];
 	if (!MARK(n)) {
 	    MARK(n) = TRUE;
 	    enqueue(q, n);
 	    while ((n0 = dequeue(q))) {
 		if (ND_ranktype(n0) != CLUSTER) {
 		    install_in_rank(g, n0);
-		    enqueue_neighbors(q, n0, pass);
+		    if (Shuffle)
+			enqueue_shuffled(q, n0, pass);
+		    else
+			enqueue_neighbors(q, n0, pass);
 		} else {
 		    install_cluster(g, n0, pass, q);
 		}
 	    }
 	}
     }
+    free(starts);
     if (dequeue(q))
 	agerr(AGERR, "surprise\n");
     for (i = GD_minrank(g); i <= GD_maxrank(g); i++) {
-	GD_rank(Root)[i].valid = false;
-	if (GD_flip(g) && GD_rank(g)[i].n > 0) {
-	    node_t **vlist = GD_rank(g)[i].v;
-	    int num_nodes_1 = GD_rank(g)[i].n - 1;
+	RANKS(Root)[i].valid = false;
+	if (GD_flip(g) && RANKS(g)[i].n > 0) {
+	    node_t **vlist = RANKS(g)[i].v;
+	    int num_nodes_1 = RANKS(g)[i].n - 1;
 	    int half_num_nodes_1 = num_nodes_1 / 2;
 	    for (j = 0; j <= half_num_nodes_1; j++)
 		exchange(vlist[j], vlist[num_nodes_1 - j]);
 	}
     }
 
+    Agsym_t *pos;
+    if (Warm && (pos = dot_warmstart(g)))
+	warm_order(g, pos);
+
     if (g == dot_root(g) && ncross(g) > 0)
 	transpose(g, FALSE);
     free_queue(q);
 }
 
+/* enqueue_shuffled:
+ * Enqueue the neighbors of n0 as enqueue_neighbors does, but going around
+ * its edges from a random one in a random direction.
+ */
+static void enqueue_shuffled(nodequeue * q, node_t * n0, int pass)
+{
+    elist l = pass == 0 ? ND_out(n0) : ND_in(n0);
+
+    if (l.size == 0)
+	return;
+    const size_t first = (size_t)gv_rand() % l.size;
+    const bool back = gv_rand() % 2 == 0;
+    for (size_t i = 0; i < l.size; i++) {
+	size_t k = back ? (first + l.size - i) % l.size : (first + i) % l.size;
+	node_t *v = pass == 0 ? aghead(l.list[k]) : agtail(l.list[k]);
+	if (!MARK(v)) {
+	    MARK(v) = TRUE;
+	    enqueue(q, v);
+	}
+    }
+}
+
+/* prior_order_x:
+ * The x coordinate n had in an earlier layout, whose node positions pos
+ * holds. A virtual node of an edge takes the x where the edge crossed its
+ * rank, or, without a spline, the x between the edge's ends in proportion
+ * to its rank. Return false if n had none.
+ */
+static bool prior_order_x(Agsym_t * pos, node_t * n, double *x)
+{
+    edge_t *e;
+    pointf t, h;
+
+    if (ND_node_type(n) == NORMAL) {
+	if (!dot_prior_pos(n, pos, &t))
+	    return false;
+	*x = t.x;
+	return true;
+    }
+    if (ND_out(n).size > 0)
+	e = ND_out(n).list[0];
+    else if (ND_in(n).size > 0)
+	e = ND_in(n).list[0];
+    else
+	return false;
+    while (ED_to_orig(e))
+	e = ED_to_orig(e);
+    if (ED_edge_type(e) != NORMAL || !dot_prior_pos(agtail(e), pos, &t) ||
+	!dot_prior_pos(aghead(e), pos, &h))
+	return false;
+    const int rt = ND_rank(agtail(e)), rh = ND_rank(aghead(e));
+    if (rt == rh)
+	return false;
+    const double f = (ND_rank(n) - rt) / (double)(rh - rt);
+    if (!dot_prior_spline_x(e, t.y + (h.y - t.y) * f, x))
+	*x = t.x + (h.x - t.x) * f;
+    return true;
+}
+
+static int warmcmpf(const void *x, const void *y)
+{
+    node_t *a = *(node_t * const *)x;
+    node_t *b = *(node_t * const *)y;
+    if (ND_mval(a) != ND_mval(b))
+	return ND_mval(a) < ND_mval(b) ? -1 : 1;
+    return (ND_order(a) > ND_order(b)) - (ND_order(a) < ND_order(b));
+}
+
+/* warm_order:
+ * Order the ranks build_ranks has just filled as the nodes were ordered in
+ * an earlier layout, whose node positions pos holds, by their x there. The
+ * skeleton of a cluster takes the middle of the box the cluster had, since
+ * every other node on its ranks was to one side of that box. A node
+ * that is new, or whose edge is, goes to the middle of its neighbors that
+ * had an x, or else stays after the node build_ranks put before it. Nodes
+ * that had an x, as did all their neighbors, are settled: mincross leaves
+ * them where they are and only moves the others among them.
+ */
+static void warm_order(graph_t * g, Agsym_t * pos)
+{
+    int r, i;
+    node_t *v;
+    pointf p;
+    size_t total = 0, k;
+
+    /* first ND_settled marks the nodes with an x, which ND_mval holds */
+    for (r = GD_minrank(g); r <= GD_maxrank(g); r++) {
+	for (i = 0; i < RANKS(g)[r].n; i++) {
+	    v = RANKS(g)[r].v[i];
+	    ND_settled(v) = !(ND_node_type(v) == VIRTUAL &&
+			      ND_ranktype(v) == CLUSTER) &&
+		prior_order_x(pos, v, &ND_mval(v));
+	}
+	total += (size_t)RANKS(g)[r].n;
+    }
+    for (int c = 1; c <= GD_n_cluster(g); c++) {
+	graph_t *clust = GD_clust(g)[c];
+	boxf bb;
+	if (dot_prior_bb(clust, &bb)) {
+	    for (r = GD_minrank(clust); r <= GD_maxrank(clust); r++) {
+		v = GD_rankleader(clust)[r];
+		ND_mval(v) = (bb.LL.x + bb.UR.x) / 2;
+		ND_settled(v) = true;
+	    }
+	    continue;
+	}
+	/* without a box, each rank of the skeleton takes the middle of the
+	 * cluster's nodes on that rank */
+	for (r = GD_minrank(clust); r <= GD_maxrank(clust); r++) {
+	    double sum = 0;
+	    int cnt = 0;
+	    for (v = agfstnode(clust); v; v = agnxtnode(clust, v))
+		if (ND_rank(v) == r && dot_prior_pos(v, pos, &p)) {
+		    sum += p.x;
+		    cnt++;
+		}
+	    if (cnt == 0)
+		continue;
+	    v = GD_rankleader(clust)[r];
+	    ND_mval(v) = sum / cnt;
+	    ND_settled(v) = true;
+	}
+    }
+
+    /* then the others are placed and the settled nodes found */
+    bool *settled = N_NEW(total, bool);
+    k = 0;
+    for (r = GD_minrank(g); r <= GD_maxrank(g); r++) {
+	double prev = -INFINITY;
+	for (i = 0; i < RANKS(g)[r].n; i++) {
+	    v = RANKS(g)[r].v[i];
+	    bool all = ND_settled(v);
+	    double sum = 0;
+	    int cnt = 0;
+	    for (size_t j = 0; j < ND_in(v).size + ND_out(v).size; j++) {
+		node_t *u = j < ND_in(v).size ? agtail(ND_in(v).list[j]) :
+		    aghead(ND_out(v).list[j - ND_in(v).size]);
+		if (ND_settled(u)) {
+		    sum += ND_mval(u);
+		    cnt++;
+		} else
+		    all = false;
+	    }
+	    if (!ND_settled(v))
+		ND_mval(v) = cnt > 0 ? sum / cnt : prev;
+	    prev = ND_mval(v);
+	    settled[k++] = all;
+	}
+    }
+    k = 0;
+    for (r = GD_minrank(g); r <= GD_maxrank(g); r++)
+	for (i = 0; i < RANKS(g)[r].n; i++)
+	    ND_settled(RANKS(g)[r].v[i]) = settled[k++];
+    free(settled);
+
+    for (r = GD_minrank(g); r <= GD_maxrank(g); r++) {
+	node_t **vlist = RANKS(g)[r].v;
+	const int n = RANKS(g)[r].n;
+	if (n == 0)
+	    continue;
+	const int base = ND_order(vlist[0]);
+	qsort(vlist, (size_t)n, sizeof(vlist[0]), warmcmpf);
+	for (i = 0; i < n; i++)
+	    ND_order(vlist[i]) = base + i;
+	RANKS(Root)[r].valid = false;
+    }
+
+    /* a flat edge that ran right to left before is turned around, or
+     * flat_reorder would put its tail first again */
+    if (!GD_has_flat_edges(g))
+	return;
+    for (r = GD_minrank(g); r <= GD_maxrank(g); r++)
+	for (i = 0; i < RANKS(g)[r].n; i++) {
+	    v = RANKS(g)[r].v[i];
+	    if (!ND_settled(v) || !ND_flat_out(v).list)
+		continue;
+	    edge_t *e;
+	    for (int j = 0; (e = ND_flat_out(v).list[j]); j++) {
+		node_t *w = aghead(e);
+		const int k = ND_order(w) - ND_order(RANKS(g)[r].v[0]);
+		if (ED_edge_type(e) == FLATORDER || !ND_settled(w) || k < 0 ||
+		    k >= i || RANKS(g)[r].v[k] != w)
+		    continue;
+		delete_flat_edge(e);
+		j--;
+		flat_rev(g, e);
+	    }
+	}
+}
+
 void enqueue_neighbors(nodequeue * q, node_t * n0, int pass)
 {
     edge_t *e;
@@ -1465,6 +2145,28 @@ static int postorder(graph_t * g, node_t * v, node_t ** list, int r)
     return cnt;
 }
 
+/* flat_ordered:
+ * Whether every constraining flat edge on rank r of g already runs the way
+ * flat_reorder would make it.
+ */
+static bool flat_ordered(graph_t * g, int r)
+{
+    for (int i = 0; i < RANKS(g)[r].n; i++) {
+	node_t *v = RANKS(g)[r].v[i];
+	edge_t *e;
+	if (!ND_flat_out(v).list)
+	    continue;
+	for (int j = 0; (e = ND_flat_out(v).list[j]); j++) {
+	    if (!constraining_flat_edge(g, e))
+		continue;
+	    if (GD_flip(g) ? ND_order(aghead(e)) > ND_order(v)
+			   : ND_order(aghead(e)) < ND_order(v))
+		return false;
+	}
+    }
+    return true;
+}
+
 static void flat_reorder(graph_t * g)
 {
     int i, r, pos, n_search, local_in_cnt, local_out_cnt, base_order;
@@ -1475,17 +2177,19 @@ static void flat_reorder(graph_t * g)
     if (!GD_has_flat_edges(g))
 	return;
     for (r = GD_minrank(g); r <= GD_maxrank(g); r++) {
-	if (GD_rank(g)[r].n == 0) continue;
-	base_order = ND_order(GD_rank(g)[r].v[0]);
-	for (i = 0; i < GD_rank(g)[r].n; i++)
-	    MARK(GD_rank(g)[r].v[i]) = FALSE;
+	if (RANKS(g)[r].n == 0) continue;
+	base_order = ND_order(RANKS(g)[r].v[0]);
+	for (i = 0; i < RANKS(g)[r].n; i++)
+	    MARK(RANKS(g)[r].v[i]) = FALSE;
 	temprank = ALLOC(i + 1, temprank, node_t *);
 	pos = 0;
+	/* a warm start keeps the earlier order if it needs no change */
+	const bool keep = Warm && flat_ordered(g, r);
 
 	/* construct reverse topological sort order in temprank */
-	for (i = 0; i < GD_rank(g)[r].n; i++) {
-	    if (GD_flip(g)) v = GD_rank(g)[r].v[i];
-	    else v = GD_rank(g)[r].v[GD_rank(g)[r].n - i - 1];
+	for (i = 0; i < RANKS(g)[r].n; i++) {
+	    if (GD_flip(g)) v = RANKS(g)[r].v[i];
+	    else v = RANKS(g)[r].v[RANKS(g)[r].n - i - 1];
 
 	    local_in_cnt = local_out_cnt = 0;
 	    for (size_t j = 0; j < ND_flat_in(v).size; j++) {
@@ -1496,7 +2200,7 @@ static void flat_reorder(graph_t * g)
 		flat_e = ND_flat_out(v).list[j];
 		if (constraining_flat_edge(g, flat_e)) local_out_cnt++;
 	    }
-	    if ((local_in_cnt == 0) && (local_out_cnt == 0))
+	    if (keep || (local_in_cnt == 0 && local_out_cnt == 0))
 		temprank[pos++] = v;
 	    else {
 		if (!MARK(v) && local_in_cnt == 0) {
@@ -1519,14 +2223,14 @@ static void flat_reorder(graph_t * g)
 		    right--;
 		}
 	    }
-	    for (i = 0; i < GD_rank(g)[r].n; i++) {
-		v = GD_rank(g)[r].v[i] = temprank[i];
+	    for (i = 0; i < RANKS(g)[r].n; i++) {
+		v = RANKS(g)[r].v[i] = temprank[i];
 		ND_order(v) = i + base_order;
 	    }
 
 	    /* nonconstraint flat edges must be made LR */
-	    for (i = 0; i < GD_rank(g)[r].n; i++) {
-		v = GD_rank(g)[r].v[i];
+	    for (i = 0; i < RANKS(g)[r].n; i++) {
+		v = RANKS(g)[r].v[i];
 		if (ND_flat_out(v).list) {
 		    for (size_t j = 0; (e = ND_flat_out(v).list[j]); j++) {
 			if ( (!GD_flip(g) && ND_order(aghead(e)) < ND_order(agtail(e))) ||
@@ -1542,7 +2246,7 @@ static void flat_reorder(graph_t * g)
 	    /* postprocess to restore intended order */
 	}
 	/* else do no harm! */
-	GD_rank(Root)[r].valid = false;
+	RANKS(Root)[r].valid = false;
     }
     free(temprank);
 }
@@ -1550,10 +2254,10 @@ static void flat_reorder(graph_t * g)
 static void reorder(graph_t * g, int r, bool reverse, bool hasfixed)
 {
     int changed = 0, nelt;
-    node_t **vlist = GD_rank(g)[r].v;
-    node_t **lp, **rp, **ep = vlist + GD_rank(g)[r].n;
+    node_t **vlist = RANKS(g)[r].v;
+    node_t **lp, **rp, **ep = vlist + RANKS(g)[r].n;
 
-    for (nelt = GD_rank(g)[r].n - 1; nelt >= 0; nelt--) {
+    for (nelt = RANKS(g)[r].n - 1; nelt >= 0; nelt--) {
 	lp = vlist;
 	while (lp < ep) {
 	    /* find leftmost node that can be compared */
@@ -1593,9 +2297,9 @@ static void reorder(graph_t * g, int r, bool reverse, bool hasfixed)
     }
 
     if (changed) {
-	GD_rank(Root)[r].valid = false;
+	RANKS(Root)[r].valid = false;
 	if (r > 0)
-	    GD_rank(Root)[r - 1].valid = false;
+	    RANKS(Root)[r - 1].valid = false;
     }
 }
 
@@ -1652,65 +2356,205 @@ static int local_cross(elist l, int dir)
     return cross;
 }
 
-static int rcross(graph_t * g, int r)
+/* tree_cross:
+ * Count the crossings of the edges between ranks r and r+1, weighted by
+ * their xpenalty, after Barth, Juenger and Mutzel, "Simple and Efficient
+ * Bilayer Cross Counting". The weights of the edges seen so far are kept by
+ * the order of their heads in the leaves of a complete binary tree whose
+ * inner nodes hold the sums of their subtrees, so the weight of the edges to
+ * nodes right of a given one is found in time logarithmic in the size of
+ * rank r+1.
+ */
+static int tree_cross(graph_t * g, int r)
 {
-    static int *Count, C;
-    int top, bot, cross, max, i, k;
-    node_t **rtop, *v;
+    int first, size, top, cross, i, k;
+    node_t **rtop;
+    edge_t *e;
 
     cross = 0;
-    max = 0;
-    rtop = GD_rank(g)[r].v;
+    rtop = RANKS(g)[r].v;
 
-    if (C <= GD_rank(Root)[r + 1].n) {
-	C = GD_rank(Root)[r + 1].n + 1;
-	Count = ALLOC(C, Count, int);
+    /* the leaves are Tree[first] ... Tree[first + n - 1] */
+    for (first = 1; first < RANKS(g)[r + 1].n; first *= 2);
+    size = 2 * first - 1;
+    first--;
+    if (T < size) {
+	T = size;
+	Tree = ALLOC(T, Tree, int);
     }
+    for (i = 0; i < size; i++)
+	Tree[i] = 0;
 
-    for (i = 0; i < GD_rank(g)[r + 1].n; i++)
-	Count[i] = 0;
-
-    for (top = 0; top < GD_rank(g)[r].n; top++) {
-	edge_t *e;
-	if (max > 0) {
-	    for (i = 0; (e = ND_out(rtop[top]).list[i]); i++) {
-		for (k = ND_order(aghead(e)) + 1; k <= max; k++)
-		    cross += Count[k] * ED_xpenalty(e);
-	    }
+    for (top = 0; top < RANKS(g)[r].n; top++) {
+	/* edges from one node do not cross, so add them only after */
+	for (i = 0; (e = ND_out(rtop[top]).list[i]); i++) {
+	    int right = 0;
+	    for (k = ND_order(aghead(e)) + first; k > 0; k = (k - 1) / 2)
+		if (k % 2)
+		    right += Tree[k + 1];
+	    cross += right * ED_xpenalty(e);
 	}
 	for (i = 0; (e = ND_out(rtop[top]).list[i]); i++) {
-	    int inv = ND_order(aghead(e));
-	    if (inv > max)
-		max = inv;
-	    Count[inv] += ED_xpenalty(e);
+	    k = ND_order(aghead(e)) + first;
+	    Tree[k] += ED_xpenalty(e);
+	    while (k > 0) {
+		k = (k - 1) / 2;
+		Tree[k] += ED_xpenalty(e);
+	    }
 	}
     }
-    for (top = 0; top < GD_rank(g)[r].n; top++) {
-	v = GD_rank(g)[r].v[top];
+    return cross;
+}
+
+static int rcross(graph_t * g, int r)
+{
+    int top, bot, cross;
+    node_t *v;
+
+    cross = tree_cross(g, r);
+    for (top = 0; top < RANKS(g)[r].n; top++) {
+	v = RANKS(g)[r].v[top];
 	if (ND_has_port(v))
 	    cross += local_cross(ND_out(v), 1);
     }
-    for (bot = 0; bot < GD_rank(g)[r + 1].n; bot++) {
-	v = GD_rank(g)[r + 1].v[bot];
+    for (bot = 0; bot < RANKS(g)[r + 1].n; bot++) {
+	v = RANKS(g)[r + 1].v[bot];
 	if (ND_has_port(v))
 	    cross += local_cross(ND_in(v), -1);
     }
     return cross;
 }
 
+/* sort_heads:
+ * Sort the edges l[0] ... l[n - 1], ordered by tail, by the order of their
+ * heads, using the scratch space s, and return the weighted number of pairs
+ * of edges from different tails whose heads are the other way round.
+ * Edges from the same tail are already in order of their heads.
+ */
+static int sort_heads(edge_t **l, edge_t **s, size_t n)
+{
+    size_t i, j, k, m;
+    int cross, right;
+
+    if (n < 2)
+	return 0;
+    m = n / 2;
+    cross = sort_heads(l, s, m) + sort_heads(l + m, s + m, n - m);
+
+    /* right is the weight of the edges of the first half not yet merged */
+    right = 0;
+    for (i = 0; i < m; i++)
+	right += ED_xpenalty(l[i]);
+    for (i = 0, j = m, k = 0; i < m || j < n; k++) {
+	if (j == n || (i < m && ND_order(aghead(l[i])) <= ND_order(aghead(l[j])))) {
+	    right -= ED_xpenalty(l[i]);
+	    s[k] = l[i++];
+	} else {
+	    cross += right * ED_xpenalty(l[j]);
+	    s[k] = l[j++];
+	}
+    }
+    memcpy(l, s, n * sizeof(edge_t *));
+    return cross;
+}
+
+static int tailcmpf(const void *x, const void *y)
+{
+    edge_t *e0 = *(edge_t *const *)x;
+    edge_t *e1 = *(edge_t *const *)y;
+    int t0 = ND_order(agtail(e0)), t1 = ND_order(agtail(e1));
+    int h0 = ND_order(aghead(e0)), h1 = ND_order(aghead(e1));
+
+    if (t0 != t1)
+	return t0 < t1 ? -1 : 1;
+    if (h0 != h1)
+	return h0 < h1 ? -1 : 1;
+    return 0;
+}
+
+/* clust_rcross:
+ * Count the crossings between ranks r and r+1 that the order of the nodes
+ * of the cluster g can change: those of the edges with an end in g, among
+ * themselves. The other crossings are the same whatever the order of g.
+ */
+static int clust_rcross(graph_t * g, int r)
+{
+    rank_t *top = NULL, *bot = NULL;
+    int lo = 0, hi = -1, cross, i, j;
+    size_t n = 0, k;
+    edge_t *e;
+    node_t *v;
+
+    if (r >= GD_minrank(g) && r <= GD_maxrank(g) && RANKS(g)[r].n > 0) {
+	top = &RANKS(g)[r];
+	lo = ND_order(top->v[0]);
+	hi = lo + top->n - 1;
+	for (i = 0; i < top->n; i++)
+	    n += ND_out(top->v[i]).size;
+    }
+    if (r + 1 >= GD_minrank(g) && r + 1 <= GD_maxrank(g))
+	bot = &RANKS(g)[r + 1];
+    if (bot)
+	for (i = 0; i < bot->n; i++)
+	    n += ND_in(bot->v[i]).size;
+    if (XE < 2 * n) {
+	XE = 2 * n;
+	Xedges = ALLOC(XE, Xedges, edge_t *);
+    }
+
+    n = 0;
+    if (top)
+	for (i = 0; i < top->n; i++)
+	    for (j = 0; (e = ND_out(top->v[i]).list[j]); j++)
+		Xedges[n++] = e;
+    if (bot)
+	for (i = 0; i < bot->n; i++)
+	    for (j = 0; (e = ND_in(bot->v[i]).list[j]); j++)
+		if (ND_order(agtail(e)) < lo || ND_order(agtail(e)) > hi)
+		    Xedges[n++] = e;
+    qsort(Xedges, n, sizeof(edge_t *), tailcmpf);
+
+    /* the ports of the ends of these edges, each counted once */
+    cross = 0;
+    for (k = 0; k < n; k++) {
+	v = agtail(Xedges[k]);
+	if (ND_has_port(v) && (k == 0 || agtail(Xedges[k - 1]) != v))
+	    cross += local_cross(ND_out(v), 1);
+    }
+    cross += sort_heads(Xedges, Xedges + n, n);
+    for (k = 0; k < n; k++) {
+	v = aghead(Xedges[k]);
+	if (ND_has_port(v) && (k == 0 || aghead(Xedges[k - 1]) != v))
+	    cross += local_cross(ND_in(v), -1);
+    }
+    return cross;
+}
+
+/* ncross:
+ * The number of crossings of the root, or when ordering a cluster in
+ * a graph of many clusters, of those clust_rcross counts in its ranks.
+ */
 int ncross(graph_t * g)
 {
     int r, count, nc;
 
+    if (g != Root && LocalCross) {
+	count = 0;
+	for (r = MAX(GD_minrank(g) - 1, GD_minrank(Root));
+	     r <= MIN(GD_maxrank(g), GD_maxrank(Root) - 1); r++)
+	    count += clust_rcross(g, r);
+	return count;
+    }
+
     g = Root;
     count = 0;
     for (r = GD_minrank(g); r < GD_maxrank(g); r++) {
-	if (GD_rank(g)[r].valid)
-	    count += GD_rank(g)[r].cache_nc;
+	if (RANKS(g)[r].valid)
+	    count += RANKS(g)[r].cache_nc;
 	else {
-	    nc = GD_rank(g)[r].cache_nc = rcross(g, r);
+	    nc = RANKS(g)[r].cache_nc = rcross(g, r);
 	    count += nc;
-	    GD_rank(g)[r].valid = true;
+	    RANKS(g)[r].valid = true;
 	}
     }
     return count;
@@ -1777,8 +2621,8 @@ static bool medians(graph_t * g, int r0, int r1)
     bool hasfixed = false;
 
     list = TI_list;
-    v = GD_rank(g)[r0].v;
-    for (i = 0; i < GD_rank(g)[r0].n; i++) {
+    v = RANKS(g)[r0].v;
+    for (i = 0; i < RANKS(g)[r0].n; i++) {
 	n = v[i];
 	size_t j = 0;
 	if (r1 > r0)
@@ -1819,11 +2663,18 @@ static bool medians(graph_t * g, int r0, int r1)
 	    }
 	}
     }
-    for (i = 0; i < GD_rank(g)[r0].n; i++) {
+    for (i = 0; i < RANKS(g)[r0].n; i++) {
 	n = v[i];
 	if ((ND_out(n).size == 0) && (ND_in(n).size == 0))
 	    hasfixed |= flat_mval(n);
     }
+    /* nodes settled by a warm start stay where they are */
+    if (Warm)
+	for (i = 0; i < RANKS(g)[r0].n; i++)
+	    if (ND_settled(v[i])) {
+		ND_mval(v[i]) = -1;
+		hasfixed = true;
+	    }
     return hasfixed;
 }
 
@@ -1900,8 +2751,8 @@ void check_rs(graph_t * g, int null_ok)
     for (r = GD_minrank(g); r <= GD_maxrank(g); r++) {
 	fprintf(stderr, "%d: ", r);
 	prev = NULL;
-	for (i = 0; i < GD_rank(g)[r].n; i++) {
-	    v = GD_rank(g)[r].v[i];
+	for (i = 0; i < RANKS(g)[r].n; i++) {
+	    v = RANKS(g)[r].v[i];
 	    if (v == NULL) {
 		fprintf(stderr, "NULL\t");
 		if (!null_ok)
@@ -1924,8 +2775,8 @@ void check_order(void)
     graph_t *g = Root;
 
     for (r = GD_minrank(g); r <= GD_maxrank(g); r++) {
-	assert(GD_rank(g)[r].v[GD_rank(g)[r].n] == NULL);
-	for (i = 0; (v = GD_rank(g)[r].v[i]); i++) {
+	assert(RANKS(g)[r].v[RANKS(g)[r].n] == NULL);
+	for (i = 0; (v = RANKS(g)[r].v[i]); i++) {
 	    assert(ND_rank(v) == r);
 	    assert(ND_order(v) == i);
 	}
@@ -1935,19 +2786,33 @@ void check_order(void)
 
 static void mincross_options(graph_t * g)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     char *p;
     double f;
 
     /* set default values */
     MinQuit = 8;
-    MaxIter = 24;
+    lctx->MaxIter = 24;
     Convergence = .995;
 
+    /* GV_CROSS_LOCAL=false counts all crossings of the root also while
+     * ordering a cluster */
+    p = getenv("GV_CROSS_LOCAL");
+    LocalCross = !p || mapbool(p);
+
     p = agget(g, "mclimit");
     if (p && (f = atof(p)) > 0.0) {
 	MinQuit = MAX(1, MinQuit * f);
-	MaxIter = MAX(1, MaxIter * f);
+	lctx->MaxIter = MAX(1, lctx->MaxIter * f);
     }
+
+    Restarts = late_int(g, agfindgraphattr(g, "mcrestarts"), 1, 1);
+    Seed = (unsigned)late_int(g, agfindgraphattr(g, "mcseed"), 1, INT_MIN);
+    Warm = dot_warmstart(g) != NULL;
+    Deadline = 0;
+    p = agget(g, "mctimelimit");
+    if (p && (f = atof(p)) > 0.0)
+	Deadline = wall_clock() + f;
 }
 
 #ifdef DEBUG
@@ -1976,15 +2841,15 @@ void check_vlists(graph_t * g)
     node_t *u;
 
     for (r = GD_minrank(g); r <= GD_maxrank(g); r++) {
-	for (i = 0; i < GD_rank(g)[r].n; i++) {
-	    u = GD_rank(g)[r].v[i];
+	for (i = 0; i < RANKS(g)[r].n; i++) {
+	    u = RANKS(g)[r].v[i];
 	    j = ND_order(u);
-	    assert(GD_rank(Root)[r].v[j] == u);
+	    assert(RANKS(Root)[r].v[j] == u);
 	}
 	if (GD_rankleader(g)) {
 	    u = GD_rankleader(g)[r];
 	    j = ND_order(u);
-	    assert(GD_rank(Root)[r].v[j] == u);
+	    assert(RANKS(Root)[r].v[j] == u);
 	}
     }
     for (c = 1; c <= GD_n_cluster(g); c++)
@@ -1995,7 +2860,7 @@ void node_in_root_vlist(node_t * n)
 {
     node_t **vptr;
 
-    for (vptr = GD_rank(Root)[ND_rank(n)].v; *vptr; vptr++)
+    for (vptr = RANKS(Root)[ND_rank(n)].v; *vptr; vptr++)
 	if (*vptr == n)
 	    break;
     if (*vptr == 0)
@@ -25,6 +25,8 @@
 #include <stdlib.h>
 
 static int nsiter2(graph_t * g);
+static int xrank(graph_t * g);
+static bool bk_xcoords(graph_t * g);
 static void create_aux_edges(graph_t * g);
 static void remove_aux_edges(graph_t * g);
 static void set_xcoords(graph_t * g);
@@ -120,19 +122,20 @@ connectGraph (graph_t* g)
 
 void dot_position(graph_t * g, aspect_t* asp)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     if (GD_nlist(g) == NULL)
 	return;			/* ignore empty graph */
     mark_lowclusters(g);	/* we could remove from splines.c now */
     set_ycoords(g);
-    if (Concentrate)
+    if (lctx->Concentrate)
 	dot_concentrate(g);
     expand_leaves(g);
     if (flat_edges(g))
 	set_ycoords(g);
     create_aux_edges(g);
-    if (rank(g, 2, nsiter2(g))) { /* LR balance == 2 */
+    if (!bk_xcoords(g) && xrank(g)) {
 	connectGraph (g);
-	const int rank_result = rank(g, 2, nsiter2(g));
+	const int rank_result = xrank(g);
 	assert(rank_result == 0);
 	(void)rank_result;
     }
@@ -153,6 +156,174 @@ static int nsiter2(graph_t * g)
     return maxiter;
 }
 
+/* xrank:
+ * Rank the auxiliary graph, which gives the x coordinates. With a warm
+ * start, the ranks create_aux_edges took from an earlier layout are kept
+ * as far as they are feasible.
+ */
+static int xrank(graph_t * g)
+{
+    char *s;
+    int search_size = -1;
+
+    if (!dot_warmstart(g))
+	return rank(g, 2, nsiter2(g));	/* LR balance == 2 */
+    if ((s = agget(g, "searchsize")))
+	search_size = atoi(s);
+    return rank_warm(g, 2, nsiter2(g), search_size);
+}
+
+static void warm_clusters(graph_t * g);
+
+/* bk_xcoords:
+ * With xposition=bk, give the auxiliary graph's nodes their x coordinates by
+ * the method of Brandes and Koepf, in linear time, instead of by network
+ * simplex, then pull the cluster boundaries in around their contents.
+ * Return false, leaving it to xrank, if not asked to or if the method
+ * cannot give coordinates meeting the constraints. Warm starts and
+ * ratio=compress, which need network simplex, also leave it to xrank.
+ */
+static bool bk_xcoords(graph_t * g)
+{
+    char *s = agget(g, "xposition");
+
+    if (!s || !streq(s, "bk"))
+	return false;
+    if (dot_warmstart(g) || GD_drawing(g)->ratio_kind == R_COMPRESS) {
+	if (Verbose)
+	    fprintf(stderr, "Brandes-Koepf: not used with %s\n",
+		    dot_warmstart(g) ? "warmstart" : "ratio=compress");
+	return false;
+    }
+    if (dot_bk_position(g))
+	return false;
+    warm_clusters(g);
+    return true;
+}
+
+/* prior_x:
+ * Find the x coordinate n had in an earlier layout. A virtual node of an
+ * edge is put where the edge's spline crossed its rank.
+ */
+static bool prior_x(Agsym_t * pos, node_t * n, double *x)
+{
+    node_t *t;
+    edge_t *e = NULL;
+    pointf p;
+
+    if (ND_node_type(n) == NORMAL) {
+	if (!dot_prior_pos(n, pos, &p))
+	    return false;
+	*x = p.x;
+	return true;
+    }
+
+    /* the edge lists are saved while the auxiliary graph is built */
+    for (t = n; ND_node_type(t) == VIRTUAL && ND_save_in(t).size == 1;) {
+	e = ND_save_in(t).list[0];
+	t = agtail(e);
+    }
+    if (e == NULL || !dot_prior_pos(t, pos, &p))
+	return false;
+    while (ED_to_orig(e))
+	e = ED_to_orig(e);
+    return ED_edge_type(e) == NORMAL
+	&& dot_prior_spline_x(e, ND_coord(n).y + p.y - ND_coord(t).y, x);
+}
+
+/* lr_minlen:
+ * The separation make_LR_constraints requires between u and its right
+ * neighbor v.
+ */
+static int lr_minlen(node_t * u, node_t * v)
+{
+    int minlen = 0;
+    edge_t *e;
+
+    for (int i = 0; (e = ND_out(u).list[i]); i++)
+	if (aghead(e) == v)
+	    minlen = MAX(minlen, ED_minlen(e));
+    return minlen;
+}
+
+/* warm_LR_constraints:
+ * Replace the packed ranks make_LR_constraints gave the nodes with their
+ * x coordinates in an earlier layout. Nodes without one, and virtual nodes
+ * whose edge has no usable spline, stay as close to their left neighbor as
+ * allowed. Virtual nodes are kept left of where they would push the next
+ * node with a known position, as their positions are only approximate; a
+ * real node is only moved right of its prior position if the order of the
+ * rank has changed. So the ranks stay feasible.
+ */
+static void warm_LR_constraints(graph_t * g, Agsym_t * pos)
+{
+    rank_t *rank = GD_rank(g);
+
+    for (int i = GD_minrank(g); i <= GD_maxrank(g); i++) {
+	const int n = rank[i].n;
+	if (n == 0)
+	    continue;
+	double *want = gv_calloc((size_t)n, sizeof(double));
+	bool *known = gv_calloc((size_t)n, sizeof(bool));
+	for (int j = 0; j < n; j++)
+	    known[j] = prior_x(pos, rank[i].v[j], &want[j]);
+
+	/* from the right, bound virtual nodes by the nodes after them */
+	double bound = INFINITY;
+	for (int j = n - 1; j >= 0; j--) {
+	    node_t *v = rank[i].v[j];
+	    if (j + 1 < n)
+		bound -= lr_minlen(v, rank[i].v[j + 1]);
+	    if (!known[j])
+		continue;
+	    if (ND_node_type(v) == NORMAL)
+		bound = want[j];
+	    else
+		want[j] = bound = MIN(want[j], bound);
+	}
+
+	/* from the left, give every node its place */
+	for (int j = 0; j < n; j++) {
+	    node_t *v = rank[i].v[j];
+	    if (j == 0)
+		ND_rank(v) = known[j] ? ROUND(want[j]) : 0;
+	    else {
+		node_t *u = rank[i].v[j - 1];
+		ND_rank(v) = ND_rank(u) + lr_minlen(u, v);
+		if (known[j])
+		    ND_rank(v) = MAX(ND_rank(v), ROUND(want[j]));
+	    }
+	}
+	free(known);
+	free(want);
+    }
+}
+
+/* warm_clusters:
+ * Put the left and right boundary nodes of g and its clusters as close to
+ * the nodes they contain as allowed.
+ */
+static void warm_clusters(graph_t * g)
+{
+    node_t *ln = GD_ln(g), *rn = GD_rn(g);
+    edge_t *e;
+
+    for (int c = 1; c <= GD_n_cluster(g); c++)
+	warm_clusters(GD_clust(g)[c]);
+    if (ln) {
+	int r = INT_MAX;
+	for (int i = 0; (e = ND_out(ln).list[i]); i++)
+	    r = MIN(r, ND_rank(aghead(e)) - ED_minlen(e));
+	ND_rank(ln) = r == INT_MAX ? 0 : r;
+    }
+    if (rn) {
+	int r = INT_MIN;
+	for (int i = 0; (e = ND_in(rn).list[i]); i++)
+	    r = MAX(r, ND_rank(agtail(e)) + ED_minlen(e));
+	ND_rank(rn) = r == INT_MIN ? 0 : r;
+    }
+}
+
 static bool go(node_t *u, node_t *v) {
     int i;
     edge_t *e;
@@ -391,10 +562,11 @@ static bool vnode_not_related_to(graph_t *g, node_t *v) {
  */
 static void keepout_othernodes(graph_t * g)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     int i, c, r, margin;
     node_t *u, *v;
 
-    margin = late_int (g, G_margin, CL_OFFSET, 0);
+    margin = late_int (g, lctx->G_margin, CL_OFFSET, 0);
     for (r = GD_minrank(g); r <= GD_maxrank(g); r++) {
 	if (GD_rank(g)[r].n == 0)
 	    continue;
@@ -431,10 +603,11 @@ static void keepout_othernodes(graph_t * g)
  */
 static void contain_subclust(graph_t * g)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     int margin, c;
     graph_t *subg;
 
-    margin = late_int (g, G_margin, CL_OFFSET, 0);
+    margin = late_int (g, lctx->G_margin, CL_OFFSET, 0);
     make_lrvn(g);
     for (c = 1; c <= GD_n_cluster(g); c++) {
 	subg = GD_clust(g)[c];
@@ -447,44 +620,72 @@ static void contain_subclust(graph_t * g)
     }
 }
 
+/* the extent of a subcluster on one rank */
+typedef struct {
+    int rank;
+    int order;		/* of its leftmost node */
+    graph_t *clust;
+} extent_t;
+
+static int extentcmpf(const void *x, const void *y)
+{
+    const extent_t *a = x;
+    const extent_t *b = y;
+
+    if (a->rank != b->rank)
+	return a->rank < b->rank ? -1 : 1;
+    if (a->order != b->order)
+	return a->order < b->order ? -1 : 1;
+    return 0;
+}
+
 /* separate_subclust:
  * Guarantee space between subcluster of g.
  * This is done by adding a constraint between the right bbox node rn
  * of the left cluster and the left bbox node ln of the right cluster.
- * This is only done if the two clusters overlap in some rank.
+ * The extents of the subclusters are sorted by rank and position, and
+ * only clusters next to each other in some rank are constrained; the
+ * constraints between the others follow from these and contain_nodes.
  */
 static void separate_subclust(graph_t * g)
 {
-    int i, j, margin;
-    graph_t *low, *high;
+    layout_context_t *const lctx = gvLayoutContext();
+    int i, r, margin;
+    size_t n = 0, k;
+    extent_t *ext;
     graph_t *left, *right;
 
-    margin = late_int (g, G_margin, CL_OFFSET, 0);
-    for (i = 1; i <= GD_n_cluster(g); i++)
+    margin = late_int (g, lctx->G_margin, CL_OFFSET, 0);
+    for (i = 1; i <= GD_n_cluster(g); i++) {
 	make_lrvn(GD_clust(g)[i]);
+	n += (size_t)(GD_maxrank(GD_clust(g)[i]) - GD_minrank(GD_clust(g)[i]) + 1);
+    }
+    ext = gv_calloc(n, sizeof(extent_t));
+    n = 0;
     for (i = 1; i <= GD_n_cluster(g); i++) {
-	for (j = i + 1; j <= GD_n_cluster(g); j++) {
-	    low = GD_clust(g)[i];
-	    high = GD_clust(g)[j];
-	    if (GD_minrank(low) > GD_minrank(high)) {
-		graph_t *temp = low;
-		low = high;
-		high = temp;
-	    }
-	    if (GD_maxrank(low) < GD_minrank(high))
+	graph_t *subg = GD_clust(g)[i];
+	for (r = GD_minrank(subg); r <= GD_maxrank(subg); r++) {
+	    if (GD_rank(subg)[r].n == 0 || GD_rank(subg)[r].v[0] == NULL)
 		continue;
-	    if (ND_order(GD_rank(low)[GD_minrank(high)].v[0])
-		< ND_order(GD_rank(high)[GD_minrank(high)].v[0])) {
-		left = low;
-		right = high;
-	    } else {
-		left = high;
-		right = low;
-	    }
-	    make_aux_edge(GD_rn(left), GD_ln(right), margin, 0);
+	    ext[n].rank = r;
+	    ext[n].order = ND_order(GD_rank(subg)[r].v[0]);
+	    ext[n].clust = subg;
+	    n++;
 	}
-	separate_subclust(GD_clust(g)[i]);
     }
+    qsort(ext, n, sizeof(extent_t), extentcmpf);
+    for (k = 1; k < n; k++) {
+	if (ext[k - 1].rank != ext[k].rank)
+	    continue;
+	left = ext[k - 1].clust;
+	right = ext[k].clust;
+	if (!find_fast_edge(GD_rn(left), GD_ln(right)))
+	    make_aux_edge(GD_rn(left), GD_ln(right), margin, 0);
+    }
+    free(ext);
+
+    for (i = 1; i <= GD_n_cluster(g); i++)
+	separate_subclust(GD_clust(g)[i]);
 }
 
 /* pos_clusters: create constraints for:
@@ -528,10 +729,16 @@ static void compress_graph(graph_t * g)
 
 static void create_aux_edges(graph_t * g)
 {
+    Agsym_t *pos = dot_warmstart(g);
+
     allocate_aux_edges(g);
     make_LR_constraints(g);
+    if (pos)
+	warm_LR_constraints(g, pos);
     make_edge_pairs(g);
     pos_clusters(g);
+    if (pos)
+	warm_clusters(g);
     compress_graph(g);
 }
 
@@ -635,6 +842,7 @@ static void adjustSimple(graph_t * g, int delta, int margin_total)
  */
 static void adjustRanks(graph_t * g, int margin_total)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     double lht;			/* label height */
     double rht;			/* height between top and bottom ranks */
     int maxr, minr, margin;
@@ -645,7 +853,7 @@ static void adjustRanks(graph_t * g, int margin_total)
     if (g == dot_root(g))
 	margin = 0;
     else
-	margin = late_int (g, G_margin, CL_OFFSET, 0);
+	margin = late_int (g, lctx->G_margin, CL_OFFSET, 0);
 
     ht1 = GD_ht1(g);
     ht2 = GD_ht2(g);
@@ -688,6 +896,7 @@ static void adjustRanks(graph_t * g, int margin_total)
  */
 static int clust_ht(Agraph_t * g)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     int c;
     double ht1, ht2;
     graph_t *subg;
@@ -697,7 +906,7 @@ static int clust_ht(Agraph_t * g)
     if (g == dot_root(g)) 
 	margin = CL_OFFSET;
     else
-	margin = late_int (g, G_margin, CL_OFFSET, 0);
+	margin = late_int (g, lctx->G_margin, CL_OFFSET, 0);
 
     ht1 = GD_ht1(g);
     ht2 = GD_ht2(g);
@@ -736,6 +945,7 @@ static int clust_ht(Agraph_t * g)
 /* set y coordinates of nodes, a rank at a time */
 static void set_ycoords(graph_t * g)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     int i, j, r;
     double ht2, maxht, delta, d0, d1;
     node_t *n;
@@ -772,7 +982,7 @@ static void set_ycoords(graph_t * g)
 
 	    /* update nearest enclosing cluster rank ht */
 	    if ((clust = ND_clust(n))) {
-		int yoff = (clust == g ? 0 : late_int (clust, G_margin, CL_OFFSET, 0));
+		int yoff = (clust == g ? 0 : late_int (clust, lctx->G_margin, CL_OFFSET, 0));
 		if (ND_rank(n) == GD_minrank(clust))
 		    GD_ht2(clust) = fmax(GD_ht2(clust), ht2 + yoff);
 		if (ND_rank(n) == GD_maxrank(clust))
@@ -1129,10 +1339,11 @@ static void make_lrvn(graph_t * g)
  */
 static void contain_nodes(graph_t * g)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     int margin, r;
     node_t *ln, *rn, *v;
 
-    margin = late_int (g, G_margin, CL_OFFSET, 0);
+    margin = late_int (g, lctx->G_margin, CL_OFFSET, 0);
     make_lrvn(g);
     ln = GD_ln(g);
     rn = GD_rn(g);
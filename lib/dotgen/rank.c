@@ -23,11 +23,15 @@
  *  watch out for interactions between leaves and clusters.
  */
 
+#include	<assert.h>
+#include	<cgraph/alloc.h>
+#include	<cgraph/tls.h>
 #include	<dotgen/dot.h>
 #include	<limits.h>
 #include	<stdbool.h>
 #include	<stddef.h>
 #include	<stdint.h>
+#include	<stdlib.h>
 
 static void dot1_rank(graph_t * g, aspect_t* asp);
 static void dot2_rank(graph_t * g, aspect_t* asp);
@@ -172,18 +176,22 @@ node_induce(graph_t * par, graph_t * g)
     edge_t *e;
     int i;
 
-    /* enforce that a node is in at most one cluster at this level */
+    /* enforce that a node is in at most one cluster at this level.
+     * collapse_cluster gives every node of a collapsed cluster a ranktype,
+     * so only the clusters of newrank need to be searched. */
     for (n = agfstnode(g); n; n = nn) {
 	nn = agnxtnode(g, n);
 	if (ND_ranktype(n)) {
 	    agdelete(g, n);
 	    continue;
 	}
-	for (i = 1; i < GD_n_cluster(par); i++)
-	    if (agcontains(GD_clust(par)[i], n))
-		break;
-	if (i < GD_n_cluster(par))
-	    agdelete(g, n);
+	if (GD_flags(dot_root(g)) & NEW_RANK) {
+	    for (i = 1; i < GD_n_cluster(par); i++)
+		if (agcontains(GD_clust(par)[i], n))
+		    break;
+	    if (i < GD_n_cluster(par))
+		agdelete(g, n);
+	}
 	ND_clust(n) = NULL;
     }
 
@@ -250,6 +258,7 @@ cluster_leader(graph_t * clust)
 static void 
 collapse_cluster(graph_t * g, graph_t * subg)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     if (GD_parent(subg)) {
 	return;
     }
@@ -258,7 +267,7 @@ collapse_cluster(graph_t * g, graph_t * subg)
     if (agfstnode(subg) == NULL)
 	return;
     make_new_cluster(g, subg);
-    if (CL_type == LOCAL) {
+    if (lctx->CL_type == LOCAL) {
 	dot1_rank(subg, 0);
 	cluster_leader(subg);
     } else
@@ -269,13 +278,14 @@ collapse_cluster(graph_t * g, graph_t * subg)
 static void 
 collapse_sets(graph_t *rg, graph_t *g)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     int c;
     graph_t  *subg;
 
     for (subg = agfstsubg(g); subg; subg = agnxtsubg(subg)) {
 	c = rank_set_class(subg);
 	if (c) {
-	    if ((c == CLUSTER) && CL_type == LOCAL)
+	    if ((c == CLUSTER) && lctx->CL_type == LOCAL)
 		collapse_cluster(rg, subg);
 	    else
 		collapse_rankset(rg, subg, c);
@@ -366,18 +376,96 @@ minmax_edges2(graph_t * g, point slen)
     return (e != 0);
 }
 
+/* the ranks of an earlier layout, for a warm start */
+typedef struct {
+    Agsym_t *pos;
+    double *ys;		/* distinct heights of the nodes, top first */
+    size_t n_ys;
+    int step;		/* ranks from one height to the next */
+} prior_ranks_t;
+
+static int cmp_height(const void *x, const void *y)
+{
+    const double a = *(const double *)x;
+    const double b = *(const double *)y;
+    return (a < b) - (a > b);
+}
+
+/* prior_ranks_init:
+ * Collect the heights of the nodes of g's root in an earlier layout. Return
+ * false if g is not to be warm started.
+ */
+static bool prior_ranks_init(graph_t * g, prior_ranks_t * pr)
+{
+    graph_t *root = agroot(g);
+    node_t *n;
+    pointf p;
+
+    *pr = (prior_ranks_t){.pos = dot_warmstart(g), .step = 1};
+    if (!pr->pos)
+	return false;
+    pr->ys = gv_calloc((size_t)agnnodes(root), sizeof(double));
+    for (n = agfstnode(root); n; n = agnxtnode(root, n))
+	if (dot_prior_pos(n, pr->pos, &p))
+	    pr->ys[pr->n_ys++] = p.y;
+    qsort(pr->ys, pr->n_ys, sizeof(double), cmp_height);
+    size_t distinct = 0;
+    for (size_t i = 0; i < pr->n_ys; i++)
+	if (distinct == 0 || pr->ys[i] != pr->ys[distinct - 1])
+	    pr->ys[distinct++] = pr->ys[i];
+    pr->n_ys = distinct;
+    /* edgelabel_ranks put label ranks between those of the nodes */
+    if (GD_has_labels(root) & EDGE_LABEL)
+	pr->step = 2;
+    return true;
+}
+
+/* prior_rank:
+ * The rank of n in an earlier layout, numbering the heights there from the
+ * top, or 0 if n had none.
+ */
+static int prior_rank(const prior_ranks_t * pr, node_t * n)
+{
+    pointf p;
+
+    if (!dot_prior_pos(n, pr->pos, &p))
+	return 0;
+    const double *y = bsearch(&p.y, pr->ys, pr->n_ys, sizeof(double),
+			      cmp_height);
+    assert(y != NULL);
+    return (int)(y - pr->ys) * pr->step;
+}
+
 /* Run the network simplex algorithm on each component. */
 void rank1(graph_t * g)
 {
     int maxiter = INT_MAX;
+    int search_size;
     char *s;
+    prior_ranks_t prior;
 
     if ((s = agget(g, "nslimit1")))
 	maxiter = atof(s) * agnnodes(g);
+    if (!prior_ranks_init(g, &prior)) {
+	for (size_t c = 0; c < GD_comp(g).size; c++) {
+	    GD_nlist(g) = GD_comp(g).list[c];
+	    rank(g, (GD_n_cluster(g) == 0 ? 1 : 0), maxiter);	/* TB balance */
+	}
+	return;
+    }
+
+    if ((s = agget(g, "searchsize")))
+	search_size = atoi(s);
+    else
+	search_size = -1;
     for (size_t c = 0; c < GD_comp(g).size; c++) {
+	node_t *n;
 	GD_nlist(g) = GD_comp(g).list[c];
-	rank(g, (GD_n_cluster(g) == 0 ? 1 : 0), maxiter);	/* TB balance */
+	for (n = GD_nlist(g); n; n = ND_next(n))
+	    ND_rank(n) = prior_rank(&prior, n);
+	rank_warm(g, (GD_n_cluster(g) == 0 ? 1 : 0), maxiter, search_size);
     }
+    free(prior.ys);
 }
 
 /* 
@@ -388,6 +476,7 @@ void rank1(graph_t * g)
  */
 static void expand_ranksets(graph_t * g, aspect_t* asp)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     int c;
     node_t *n, *leader;
 
@@ -412,7 +501,7 @@ static void expand_ranksets(graph_t * g, aspect_t* asp)
 	    n = agnxtnode(g, n);
 	}
 	if (g == dot_root(g)) {
-	    if (CL_type == LOCAL) {
+	    if (lctx->CL_type == LOCAL) {
 		for (c = 1; c <= GD_n_cluster(g); c++)
 		    set_minmax(GD_clust(g)[c]);
 	    } else {
@@ -559,9 +648,10 @@ static int rankset_kind(graph_t * g)
 
 static bool is_nonconstraint(edge_t * e)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     char *constr;
 
-    if (E_constr && (constr = agxget(e, E_constr))) {
+    if (lctx->E_constr && (constr = agxget(e, lctx->E_constr))) {
 	if (constr[0] && !mapbool(constr))
 	    return true;
     }
@@ -696,7 +786,7 @@ static bool is_internal_to_cluster(edge_t * e)
     return false;
 }
 
-static node_t* Last_node;
+static TLS node_t* Last_node;
 static node_t* makeXnode (graph_t* G, char* name)
 {
     node_t *n = agnode(G, name, 1);
@@ -752,7 +842,7 @@ static void weak(graph_t * g, node_t * t, node_t * h, edge_t * orig)
 {
     node_t *v;
     edge_t *e, *f;
-    static int id;
+    static TLS int id;
     char buf[100];
 
     for (e = agfstin(g, t); e; e = agnxtin(g, e)) {
@@ -1081,7 +1171,19 @@ void dot2_rank(graph_t * g, aspect_t* asp)
 	ssize = atoi(s);
     else
 	ssize = -1;
-    rank2(Xg, 1, maxiter, ssize);
+    /* network simplex takes the threads it may use from the graph it ranks */
+    if ((s = agget(g, "threads")))
+	agattr(Xg, AGRAPH, "threads", s);
+    prior_ranks_t prior;
+    if (prior_ranks_init(g, &prior)) {
+	node_t *n;
+	for (n = agfstnode(g); n; n = agnxtnode(g, n))
+	    if (find(n) == n)
+		ND_rank(ND_rep(n)) = prior_rank(&prior, n);
+	rank_warm(Xg, 1, maxiter, ssize);
+	free(prior.ys);
+    } else
+	rank2(Xg, 1, maxiter, ssize);
 /* fastgr(Xg); */
     readout_levels(g, Xg, ncc);
 #ifdef DEBUG
@@ -38,24 +38,25 @@ static void sameport(node_t *u, edge_list_t l);
 void dot_sameports(graph_t * g)
 /* merge edge ports in G */
 {
+    layout_context_t *const lctx = gvLayoutContext();
     node_t *n;
     edge_t *e;
     char *id;
     same_list_t samehead = {0};
     same_list_t sametail = {0};
 
-    E_samehead = agattr(g, AGEDGE, "samehead", NULL);
-    E_sametail = agattr(g, AGEDGE, "sametail", NULL);
-    if (!(E_samehead || E_sametail))
+    lctx->E_samehead = agattr(g, AGEDGE, "samehead", NULL);
+    lctx->E_sametail = agattr(g, AGEDGE, "sametail", NULL);
+    if (!(lctx->E_samehead || lctx->E_sametail))
 	return;
     for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
 	for (e = agfstedge(g, n); e; e = agnxtedge(g, e, n)) {
 	    if (aghead(e) == agtail(e)) continue;  /* Don't support same* for loops */
-	    if (aghead(e) == n && E_samehead &&
-	        (id = agxget(e, E_samehead))[0])
+	    if (aghead(e) == n && lctx->E_samehead &&
+	        (id = agxget(e, lctx->E_samehead))[0])
 		sameedge(&samehead, e, id);
-	    else if (agtail(e) == n && E_sametail &&
-	        (id = agxget(e, E_sametail))[0])
+	    else if (agtail(e) == n && lctx->E_sametail &&
+	        (id = agxget(e, lctx->E_sametail))[0])
 		sameedge(&sametail, e, id);
 	}
 	for (size_t i = 0; i < same_list_size(&samehead); i++) {
@@ -7,6 +7,7 @@
  *
  * Contributors: Details at https://graphviz.org
  *************************************************************************/
+#include <common/random.h>
 #include <sparse/general.h>
 #include <sparse/SparseMatrix.h>
 #include <sparse/QuadTree.h>
@@ -92,7 +93,7 @@ static void node_distinct_coloring_internal2(int scheme, QuadTree qt,
   width = cspace_size*0.5;
 
   /* randomly assign colors first */
-  srand(seed);
+  gv_srand(seed);
   for (i = 0; i < n*cdim; i++) colors[i] = cspace_size*drand();
 
   x = MALLOC(sizeof(double)*cdim*n);
@@ -160,7 +161,7 @@ static void node_distinct_coloring_internal(int scheme, QuadTree qt,
     /* do multiple iterations and pick the best */
     int iter, seed_max = -1;
     double color_diff_max = -1;
-    srand(123);
+    gv_srand(123);
     iter = -seed;
     for (i = 0; i < iter; i++){
       seed = irand(100000);
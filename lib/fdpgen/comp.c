@@ -21,6 +21,7 @@
 #define FDP_PRIVATE 1
 
 #include <cgraph/alloc.h>
+#include <cgraph/tls.h>
 #include <fdpgen/fdp.h>
 #include <fdpgen/comp.h>
 #include <pack/pack.h>
@@ -55,7 +56,7 @@ static void dfs(Agraph_t * g, Agnode_t * n, Agraph_t * out, char *marks)
  * Note that if ports and/or pinned nodes exists, they will all be
  * in the first component returned by findCComp.
  */
-static int C_cnt = 0;
+static TLS int C_cnt = 0;
 graph_t **findCComp(graph_t * g, int *cnt, int *pinned)
 {
     node_t *n;
@@ -31,6 +31,7 @@
 
 static void initialPositions(graph_t * g)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     int i;
     node_t *np;
     attrsym_t *possym;
@@ -49,10 +50,10 @@ static void initialPositions(graph_t * g)
 	    pvec = ND_pos(np);
 	    c = '\0';
 	    if (sscanf(p, "%lf,%lf%c", pvec, pvec + 1, &c) >= 2) {
-		if (PSinputscale > 0.0) {
+		if (lctx->PSinputscale > 0.0) {
 		    int j;
 		    for (j = 0; j < NDIM; j++)
-			pvec[j] = pvec[j] / PSinputscale;
+			pvec[j] = pvec[j] / lctx->PSinputscale;
 		}
 		ND_pinned(np) = P_SET;
 		if (c == '!'
@@ -70,8 +71,9 @@ static void initialPositions(graph_t * g)
  */
 static void init_edge(edge_t * e, attrsym_t * E_len)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     agbindrec(e, "Agedgeinfo_t", sizeof(Agedgeinfo_t), true);	//node custom data
-    ED_factor(e) = late_double(e, E_weight, 1.0, 0.0);
+    ED_factor(e) = late_double(e, lctx->E_weight, 1.0, 0.0);
     ED_dist(e) = late_double(e, E_len, fdp_parms->K, 0.0);
 
     common_init_edge(e);
@@ -22,6 +22,7 @@
 #define FDP_PRIVATE 1
 
 #include <cgraph/alloc.h>
+#include <cgraph/tls.h>
 #include <fdpgen/fdp.h>
 #include <fdpgen/grid.h>
 #include <common/macros.h>
@@ -112,7 +113,7 @@ static int ijcmpf(Dt_t * d, gridpt * p1, gridpt * p2, Dtdisc_t * disc)
     return 0;
 }
 
-static Grid _grid; // hack because can't attach info. to Dt_t
+static TLS Grid _grid; // hack because can't attach info. to Dt_t
 
 /* newCell:
  * Allocate a new cell from free store and initialize its indices
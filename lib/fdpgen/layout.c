@@ -35,6 +35,7 @@
 #include <assert.h>
 #include <cgraph/alloc.h>
 #include <cgraph/list.h>
+#include <cgraph/tls.h>
 #include <fdpgen/tlayout.h>
 #include <math.h>
 #include <neatogen/neatoprocs.h>
@@ -76,6 +77,7 @@ static void
 finalCC(graph_t * g, int c_cnt, graph_t ** cc, point * pts, graph_t * rg,
 	layout_info* infop)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     attrsym_t * G_width = infop->G_width;
     attrsym_t * G_height = infop->G_height;
     graph_t *cg;
@@ -136,7 +138,7 @@ finalCC(graph_t * g, int c_cnt, graph_t ** cc, point * pts, graph_t * rg,
     if (isRoot || isEmpty)
 	margin = 0;
     else
-	margin = late_int (rg, G_margin, CL_OFFSET, 0);
+	margin = late_int (rg, lctx->G_margin, CL_OFFSET, 0);
     pt.x = -bb.LL.x + margin;
     pt.y = -bb.LL.y + margin + GD_border(rg)[BOTTOM_IX].y;
     bb.LL.x = 0;
@@ -291,7 +293,7 @@ static char *portName(graph_t * g, bport_t * p)
     edge_t *e = p->e;
     node_t *h = aghead(e);
     node_t *t = agtail(e);
-    static char buf[BSZ + 1];
+    static TLS char buf[BSZ + 1];
 
 	snprintf(buf, sizeof(buf), "_port_%s_(%d)_(%d)_%u",agnameof(g),
 		ND_id(t), ND_id(h), AGSEQ(e));
@@ -308,6 +310,7 @@ static char *portName(graph_t * g, bport_t * p)
  */
 static void chkPos(graph_t* g, node_t* n, layout_info* infop, boxf* bbp)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     char *p;
     char *pp;
     boxf bb;
@@ -326,11 +329,11 @@ static void chkPos(graph_t* g, node_t* n, layout_info* infop, boxf* bbp)
 	c = '\0';
 	if (sscanf(p, "%lf,%lf,%lf,%lf%c",
 		   &bb.LL.x, &bb.LL.y, &bb.UR.x, &bb.UR.y, &c) >= 4) {
-	    if (PSinputscale > 0.0) {
-		bb.LL.x /= PSinputscale;
-		bb.LL.y /= PSinputscale;
-		bb.UR.x /= PSinputscale;
-		bb.UR.y /= PSinputscale;
+	    if (lctx->PSinputscale > 0.0) {
+		bb.LL.x /= lctx->PSinputscale;
+		bb.LL.y /= lctx->PSinputscale;
+		bb.UR.x /= lctx->PSinputscale;
+		bb.UR.y /= lctx->PSinputscale;
 	    }
 	    if (c == '!')
 		ND_pinned(n) = P_PIN;
@@ -730,6 +733,7 @@ static graph_t *expandCluster(node_t * n, graph_t * cg)
 static void 
 setClustNodes(graph_t* root)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     boxf bb;
     graph_t* p;
     pointf ctr;
@@ -754,7 +758,7 @@ setClustNodes(graph_t* root)
 	ND_pos(n)[1] = ctr.y;
 	ND_width(n) = w;
 	ND_height(n) = h;
-	const double penwidth = late_int(n, N_penwidth, DEFAULT_NODEPENWIDTH, MIN_NODEPENWIDTH);
+	const double penwidth = late_int(n, lctx->N_penwidth, DEFAULT_NODEPENWIDTH, MIN_NODEPENWIDTH);
 	ND_outline_width(n) = w + penwidth;
 	ND_outline_height(n) = h + penwidth;
 	/* ND_xsize(n) = POINTS(w); */
@@ -1022,10 +1026,11 @@ mkClusters (graph_t * g, clist_t* pclist, graph_t* parent)
 
 static void fdp_init_graph(Agraph_t * g)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     setEdgeType (g, EDGETYPE_LINE);
     GD_alg(g) = gv_alloc(sizeof(gdata)); // freed in cleanup_graph
     GD_ndim(agroot(g)) = late_int(g, agattr(g,AGRAPH, "dim", NULL), 2, 2);
-    Ndim = GD_ndim(agroot(g)) = MIN(GD_ndim(agroot(g)), MAXDIM);
+    lctx->Ndim = GD_ndim(agroot(g)) = MIN(GD_ndim(agroot(g)), MAXDIM);
 
     mkClusters (g, NULL, g);
     fdp_initParams(g);
@@ -1056,6 +1061,7 @@ static int fdpLayout(graph_t * g)
 static void
 fdpSplines (graph_t * g)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     int trySplines = 0;
     int et = EDGE_TYPE(g);
 
@@ -1064,7 +1070,7 @@ fdpSplines (graph_t * g)
 	    trySplines = splineEdges(g, compoundEdges, EDGETYPE_SPLINE);
 	    /* When doing the edges again, accept edges done by compoundEdges */
 	    if (trySplines)
-		Nop = 2;
+		lctx->Nop = 2;
 	}
 	if (trySplines || et != EDGETYPE_COMPOUND) {
 	    if (HAS_CLUST_EDGE(g)) {
@@ -1075,17 +1081,18 @@ fdpSplines (graph_t * g)
 		spline_edges1(g, et);
 	    }
 	}
-	Nop = 0;
+	lctx->Nop = 0;
     }
-    if (State < GVSPLINES)
+    if (lctx->State < GVSPLINES)
 	spline_edges1(g, et);
 }
 
 void fdp_layout(graph_t * g)
 {
-    double save_scale = PSinputscale;
+    layout_context_t *const lctx = gvLayoutContext();
+    double save_scale = lctx->PSinputscale;
         
-    PSinputscale = get_inputscale (g);
+    lctx->PSinputscale = get_inputscale (g);
     fdp_init_graph(g);
     if (fdpLayout(g) != 0) {
 	return;
@@ -1095,5 +1102,5 @@ void fdp_layout(graph_t * g)
     if (EDGE_TYPE(g) != EDGETYPE_NONE) fdpSplines (g);
 
     gv_postprocess(g, 0);
-    PSinputscale = save_scale;
+    lctx->PSinputscale = save_scale;
 }
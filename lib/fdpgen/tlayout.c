@@ -36,17 +36,15 @@
 #ifndef _WIN32
 #include <unistd.h>
 #endif
+#include <cgraph/tls.h>
 #include <ctype.h>
 #include <fdpgen/dbg.h>
 #include <fdpgen/grid.h>
 #include <neatogen/neato.h>
 
-#ifndef HAVE_SRAND48
-#define srand48 srand
-#endif
-
 #include <fdpgen/tlayout.h>
 #include <common/globals.h>
+#include <common/random.h>
 
 #define D_useGrid   (fdp_parms->useGrid)
 #define D_useNew    (fdp_parms->useNew)
@@ -79,7 +77,7 @@ typedef struct {
     int loopcnt;        /* actual iterations in this pass */
 } parms_t;
 
-static parms_t parms;
+static TLS parms_t parms;
 
 #define T_useGrid   (parms.useGrid)
 #define T_useNew    (parms.useNew)
@@ -211,8 +209,8 @@ doRep(node_t * p, node_t * q, double xdelta, double ydelta, double dist2)
     double dist;
 
     while (dist2 == 0.0) {
-	xdelta = 5 - rand() % 10;
-	ydelta = 5 - rand() % 10;
+	xdelta = 5 - gv_rand() % 10;
+	ydelta = 5 - gv_rand() % 10;
 	dist2 = xdelta * xdelta + ydelta * ydelta;
     }
     if (T_useNew) {
@@ -321,8 +319,8 @@ static void applyAttr(Agnode_t * p, Agnode_t * q, Agedge_t * e)
     ydelta = ND_pos(q)[1] - ND_pos(p)[1];
     dist2 = xdelta * xdelta + ydelta * ydelta;
     while (dist2 == 0.0) {
-	xdelta = 5 - rand() % 10;
-	ydelta = 5 - rand() % 10;
+	xdelta = 5 - gv_rand() % 10;
+	ydelta = 5 - gv_rand() % 10;
 	dist2 = xdelta * xdelta + ydelta * ydelta;
     }
     dist = sqrt(dist2);
@@ -526,7 +524,7 @@ static pointf initPositions(graph_t * g, bport_t * pp)
 	local_seed = getpid() ^ time(NULL);
 #endif
     }
-    srand48(local_seed);
+    gv_srand48(local_seed);
 
     /* If ports, place ports on and nodes within an ellipse centered at origin
      * with halfwidth Wd and halfheight Ht.
@@ -582,8 +580,8 @@ static pointf initPositions(graph_t * g, bport_t * pp)
 		    ND_pos(np)[1] = 0.9 * p.y + 0.1 * ctr.y;
 /* fprintf (stderr, "%s %d (%g,%g)\n", agnameof(np), cnt, ND_pos(np)[0], ND_pos(np)[1]); */
 		} else {
-		    double angle = PItimes2 * drand48();
-		    double radius = 0.9 * drand48();
+		    double angle = PItimes2 * gv_drand48();
+		    double radius = 0.9 * gv_drand48();
 		    ND_pos(np)[0] = radius * T_Wd * cos(angle);
 		    ND_pos(np)[1] = radius * T_Ht * sin(angle);
 /* fprintf (stderr, "%s 0 (%g,%g)\n", agnameof(np), ND_pos(np)[0], ND_pos(np)[1]); */
@@ -598,14 +596,14 @@ static pointf initPositions(graph_t * g, bport_t * pp)
 		    ND_pos(np)[0] -= ctr.x;
 		    ND_pos(np)[1] -= ctr.y;
 		} else {
-		    ND_pos(np)[0] = T_Wd * (2.0 * drand48() - 1.0);
-		    ND_pos(np)[1] = T_Ht * (2.0 * drand48() - 1.0);
+		    ND_pos(np)[0] = T_Wd * (2.0 * gv_drand48() - 1.0);
+		    ND_pos(np)[1] = T_Ht * (2.0 * gv_drand48() - 1.0);
 		}
 	    }
 	} else {		/* No ports or positions; place randomly */
 	    for (np = agfstnode(g); np; np = agnxtnode(g, np)) {
-		ND_pos(np)[0] = T_Wd * (2.0 * drand48() - 1.0);
-		ND_pos(np)[1] = T_Ht * (2.0 * drand48() - 1.0);
+		ND_pos(np)[0] = T_Wd * (2.0 * gv_drand48() - 1.0);
+		ND_pos(np)[1] = T_Ht * (2.0 * gv_drand48() - 1.0);
 	    }
 	}
     }
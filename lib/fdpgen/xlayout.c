@@ -24,6 +24,8 @@ Increase less between tries
 /* uses PRIVATE interface */
 #define FDP_PRIVATE 1
 
+#include <cgraph/tls.h>
+#include <common/random.h>
 #include <fdpgen/xlayout.h>
 #include <neatogen/adjust.h>
 #include <fdpgen/dbg.h>
@@ -43,17 +45,17 @@ Increase less between tries
 #define WD2(n) (X_marg.doAdd ? (ND_width(n)/2.0 + X_marg.x): ND_width(n)*X_marg.x/2.0)
 #define HT2(n) (X_marg.doAdd ? (ND_height(n)/2.0 + X_marg.y): ND_height(n)*X_marg.y/2.0)
 
-static xparams xParams = {
+static TLS xparams xParams = {
     60,				/* numIters */
     0.0,			/* T0 */
     0.3,			/* K */
     1.5,			/* C */
     0				/* loopcnt */
 };
-static double K2;
-static expand_t X_marg;
-static double X_nonov;
-static double X_ov;
+static TLS double K2;
+static TLS expand_t X_marg;
+static TLS double X_nonov;
+static TLS double X_ov;
 
 #ifdef DEBUG
 static void pr2graphs(Agraph_t *g0, Agraph_t *g1) {
@@ -260,8 +262,8 @@ doRep(node_t * p, node_t * q, double xdelta, double ydelta, double dist2)
 #endif
 
     while (dist2 == 0.0) {
-	xdelta = 5 - rand() % 10;
-	ydelta = 5 - rand() % 10;
+	xdelta = 5 - gv_rand() % 10;
+	ydelta = 5 - gv_rand() % 10;
 	dist2 = xdelta * xdelta + ydelta * ydelta;
     }
 #if defined(MS)
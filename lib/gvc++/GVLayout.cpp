@@ -1,7 +1,11 @@
+#include <algorithm>
 #include <cassert>
+#include <climits>
+#include <future>
 #include <memory>
 #include <stdexcept>
 #include <string>
+#include <vector>
 
 #include "GVContext.h"
 #include "GVLayout.h"
@@ -63,4 +67,48 @@ GVRenderData GVLayout::render(const std::string &format) const {
   return GVRenderData(result, length);
 }
 
+std::vector<GVRenderData> GVLayout::render_batch(
+    GVContext &gvc, const std::vector<std::shared_ptr<CGraph::AGraph>> &graphs,
+    const std::string &engine, const std::string &format, unsigned threads) {
+  std::vector<Agraph_t *> gs;
+  gs.reserve(graphs.size());
+  for (const auto &g : graphs) {
+    if (gvLayoutDone(g->c_struct())) {
+      throw std::runtime_error("Previous layout not yet destroyed");
+    }
+    gs.push_back(g->c_struct());
+  }
+
+  std::vector<char *> results(gs.size());
+  std::vector<unsigned int> lengths(gs.size());
+  const auto failed = gvLayoutBatch(
+      gvc.c_struct(), gs.data(), gs.size(), engine.c_str(), format.c_str(),
+      results.data(), lengths.data(),
+      static_cast<int>(std::min(threads, static_cast<unsigned>(INT_MAX))));
+
+  // take ownership of every rendering before any exception
+  std::vector<GVRenderData> rendered;
+  rendered.reserve(gs.size());
+  for (std::size_t i = 0; i < gs.size(); ++i) {
+    rendered.push_back(GVRenderData(results[i], lengths[i]));
+  }
+  if (failed) {
+    throw std::runtime_error("Layout or rendering failed");
+  }
+  return rendered;
+}
+
+std::future<std::vector<GVRenderData>> GVLayout::render_batch_async(
+    std::shared_ptr<GVContext> gvc,
+    std::vector<std::shared_ptr<CGraph::AGraph>> graphs, std::string engine,
+    std::string format, unsigned threads) {
+  return std::async(std::launch::async,
+                    [gvc = std::move(gvc), graphs = std::move(graphs),
+                     engine = std::move(engine), format = std::move(format),
+                     threads] {
+                      return render_batch(*gvc, graphs, engine, format,
+                                          threads);
+                    });
+}
+
 } // namespace GVC
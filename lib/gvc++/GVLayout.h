@@ -1,6 +1,9 @@
 #pragma once
 
+#include <future>
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "AGraph.h"
 #include "GVContext.h"
@@ -46,6 +49,24 @@ public:
   // render the layout in the specified format
   GVRenderData render(const std::string &format) const;
 
+  // lay out and render each of the graphs, spreading them over up to the
+  // specified number of threads, or one per processor if 0, each with a
+  // context of its own kept in `gvc` for later batches. The renderings are
+  // returned in the order of the graphs, which are left with no layout.
+  static std::vector<GVRenderData>
+  render_batch(GVContext &gvc,
+               const std::vector<std::shared_ptr<CGraph::AGraph>> &graphs,
+               const std::string &engine, const std::string &format,
+               unsigned threads = 0);
+
+  // as `render_batch`, but run from another thread. `gvc` and the graphs must
+  // not be used until the result is ready.
+  static std::future<std::vector<GVRenderData>>
+  render_batch_async(std::shared_ptr<GVContext> gvc,
+                     std::vector<std::shared_ptr<CGraph::AGraph>> graphs,
+                     std::string engine, std::string format,
+                     unsigned threads = 0);
+
 private:
   std::shared_ptr<GVContext> m_gvc;
   std::shared_ptr<CGraph::AGraph> m_g;
@@ -0,0 +1,228 @@
+/*************************************************************************
+ * Copyright (c) 2011 AT&T Intellectual Property
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors: Details at https://graphviz.org
+ *************************************************************************/
+
+/* Laying out and rendering many graphs from a pool of threads.
+ *
+ * Each worker thread owns a context of its own, made like the caller's and
+ * kept in it for later batches, so a batch pays for creating contexts and
+ * loading plugins only the first time.
+ */
+
+#include "config.h"
+
+#include <cgraph/alloc.h>
+#include <gvc/gvc.h>
+#include <gvc/gvcint.h>
+#include <common/globals.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+/* work shared by the threads of one batch */
+typedef struct {
+    graph_t **graphs;
+    size_t count;
+    const char *engine;
+    const char *format;
+    char **results;
+    unsigned int *lengths;
+    size_t next;	/* next graph to take, under lock */
+    size_t failed;	/* graphs not laid out or rendered, under lock */
+#ifdef _WIN32
+    CRITICAL_SECTION lock;
+#else
+    pthread_mutex_t lock;
+#endif
+} batch_t;
+
+typedef struct {
+    batch_t *batch;
+    GVC_t *gvc;
+} worker_t;
+
+static void batch_lock(batch_t *b)
+{
+#ifdef _WIN32
+    EnterCriticalSection(&b->lock);
+#else
+    pthread_mutex_lock(&b->lock);
+#endif
+}
+
+static void batch_unlock(batch_t *b)
+{
+#ifdef _WIN32
+    LeaveCriticalSection(&b->lock);
+#else
+    pthread_mutex_unlock(&b->lock);
+#endif
+}
+
+/* layOut:
+ * Lay out and render one graph, leaving it with no layout.
+ * Return true on success.
+ */
+static bool layOut(GVC_t *gvc, graph_t *g, const char *engine,
+		   const char *format, char **result, unsigned int *length)
+{
+    if (gvLayout(gvc, g, engine) != 0)
+	return false;
+    char *data = NULL;
+    unsigned int len = 0;
+    const int rc = gvRenderData(gvc, g, format, &data, &len);
+    gvFreeLayout(gvc, g);
+    if (rc != 0)
+	return false;
+    *result = data;
+    *length = len;
+    return true;
+}
+
+static void work(worker_t *w)
+{
+    batch_t *b = w->batch;
+    for (;;) {
+	batch_lock(b);
+	const size_t i = b->next++;
+	batch_unlock(b);
+	if (i >= b->count)
+	    break;
+	if (!layOut(w->gvc, b->graphs[i], b->engine, b->format,
+		    &b->results[i], &b->lengths[i])) {
+	    batch_lock(b);
+	    ++b->failed;
+	    batch_unlock(b);
+	}
+    }
+}
+
+#ifdef _WIN32
+static DWORD WINAPI worker(LPVOID arg)
+{
+    work(arg);
+    return 0;
+}
+#else
+static void *worker(void *arg)
+{
+    work(arg);
+    return NULL;
+}
+#endif
+
+/* processors:
+ * The number of processors available, or 1 if it cannot be found.
+ */
+static size_t processors(void)
+{
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors > 0 ? info.dwNumberOfProcessors : 1;
+#elif defined(_SC_NPROCESSORS_ONLN)
+    const long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (size_t)n : 1;
+#else
+    return 1;
+#endif
+}
+
+/* batchContexts:
+ * Make sure gvc holds at least n worker contexts, and return them.
+ */
+static GVC_t **batchContexts(GVC_t *gvc, size_t n)
+{
+    if (gvc->batch_contexts_n < n) {
+	gvc->batch_contexts = gv_recalloc(gvc->batch_contexts,
+					  gvc->batch_contexts_n, n,
+					  sizeof(gvc->batch_contexts[0]));
+	for (size_t i = gvc->batch_contexts_n; i < n; ++i)
+	    gvc->batch_contexts[i] = gvContextPlugins(gvc->common.builtins,
+						      gvc->common.demand_loading);
+	gvc->batch_contexts_n = n;
+    }
+    return gvc->batch_contexts;
+}
+
+int gvLayoutBatch(GVC_t *gvc, graph_t **graphs, size_t count,
+		  const char *engine, const char *format, char **results,
+		  unsigned int *lengths, int threads)
+{
+    for (size_t i = 0; i < count; ++i) {
+	results[i] = NULL;
+	lengths[i] = 0;
+    }
+    if (count == 0)
+	return 0;
+
+    size_t n = threads > 0 ? (size_t)threads : processors();
+    if (n > count)
+	n = count;
+    GVC_t **contexts = batchContexts(gvc, n);
+
+    batch_t b = {.graphs = graphs, .count = count, .engine = engine,
+		 .format = format, .results = results, .lengths = lengths};
+    worker_t *workers = gv_calloc(n, sizeof(workers[0]));
+    for (size_t i = 0; i < n; ++i) {
+	workers[i].batch = &b;
+	workers[i].gvc = contexts[i];
+    }
+
+#ifdef _WIN32
+    InitializeCriticalSection(&b.lock);
+    HANDLE *tids = gv_calloc(n, sizeof(tids[0]));
+#else
+    pthread_mutex_init(&b.lock, NULL);
+    pthread_t *tids = gv_calloc(n, sizeof(tids[0]));
+#endif
+    bool *started = gv_calloc(n, sizeof(started[0]));
+
+    /* the first worker runs in this thread */
+    for (size_t i = 1; i < n; ++i) {
+#ifdef _WIN32
+	tids[i] = CreateThread(NULL, 0, worker, &workers[i], 0, NULL);
+	started[i] = tids[i] != NULL;
+#else
+	started[i] = pthread_create(&tids[i], NULL, worker, &workers[i]) == 0;
+#endif
+    }
+    work(&workers[0]);
+    for (size_t i = 1; i < n; ++i) {
+	if (!started[i])
+	    continue;
+#ifdef _WIN32
+	WaitForSingleObject(tids[i], INFINITE);
+	CloseHandle(tids[i]);
+#else
+	pthread_join(tids[i], NULL);
+#endif
+    }
+
+#ifdef _WIN32
+    DeleteCriticalSection(&b.lock);
+#else
+    pthread_mutex_destroy(&b.lock);
+#endif
+    free(started);
+    free(tids);
+    free(workers);
+
+    /* the first worker left its context bound to this thread */
+    gvSetLayoutContext(gvc->layout_context);
+    return b.failed > INT_MAX ? INT_MAX : (int)b.failed;
+}
@@ -19,12 +19,25 @@
 #include <gvc/gvio.h>
 #include <stdbool.h>
 #include <stdlib.h>
+#include <string.h>
+
+/* init_label_default:
+ * Make node labels default to the node name in graphs created from now on.
+ * Only the first context changes the default, so later ones can be created
+ * while other threads are using theirs.
+ */
+static void init_label_default(void)
+{
+    Agsym_t *sym = agattr(NULL, AGNODE, "label", NULL);
+    if (sym == NULL || strcmp(sym->defval, NODENAME_ESC) != 0)
+	agattr(NULL, AGNODE, "label", NODENAME_ESC);
+}
 
 GVC_t *gvContext(void)
 {
     GVC_t *gvc;
 
-    agattr(NULL, AGNODE, "label", NODENAME_ESC);
+    init_label_default();
     /* default to no builtins, demand loading enabled */
     gvc = gvNEWcontext(NULL, TRUE);
     gvconfig(gvc, false); /* configure for available plugins */
@@ -35,7 +48,7 @@ GVC_t *gvContextPlugins(const lt_symlist_t *builtins, int demand_loading)
 {
     GVC_t *gvc;
 
-    agattr(NULL, AGNODE, "label", NODENAME_ESC);
+    init_label_default();
     gvc = gvNEWcontext(builtins, demand_loading);
     gvconfig(gvc, false); /* configure for available plugins */
     return gvc;
@@ -16,6 +16,7 @@
 #pragma once
 
 #include <stdbool.h>
+#include <stddef.h>
 
 #include "types.h"
 #include "gvplugin.h"
@@ -87,6 +88,19 @@ GVC_API int gvRenderData(GVC_t *gvc, graph_t *g, const char *format, char **resu
 /* Free memory allocated and pointed to by *result in gvRenderData */
 GVC_API void gvFreeRenderData (char* data);
 
+/* Lay out and render each of count graphs with the given engine and format,
+ * spreading them over up to the given number of threads, or one per processor
+ * if threads is not positive. Each thread uses a context of its own, made with
+ * the same builtins as gvc and kept in it for later calls. The graphs must be
+ * distinct root graphs, and are left with no layout.
+ * results[i] and lengths[i] receive the rendering of graphs[i], as from
+ * gvRenderData, or NULL and 0 if it could not be laid out or rendered.
+ * Returns the number of graphs that could not be.
+ */
+GVC_API int gvLayoutBatch(GVC_t *gvc, graph_t **graphs, size_t count,
+                          const char *engine, const char *format,
+                          char **results, unsigned int *lengths, int threads);
+
 /* Render layout according to -T and -o options found by gvParseArgs */
 GVC_API int gvRenderJobs(GVC_t *gvc, graph_t *g);
 
@@ -117,6 +117,7 @@ extern "C" {
 
 	/* gvrender_begin_job() */
 	gvplugin_active_layout_t layout;
+	struct layout_context_s *layout_context; /* state of layouts in this context */
 
 	char *graphname;	/* name from graph */
 	GVJ_t *active_jobs;   /* linked list of active jobs */
@@ -151,6 +152,10 @@ extern "C" {
 
 	/* whether to mangle font names (at least in SVG), usually false */
 	int fontrenaming;
+
+	/* gvLayoutBatch() */
+	GVC_t **batch_contexts;	/* a context for each worker, kept for reuse */
+	size_t batch_contexts_n;
     };
 
 GVCINT_API GVC_t* gvCloneGVC (GVC_t *);
@@ -28,6 +28,7 @@ extern "C" {
 			    all pages in all layers */
 	const lt_symlist_t *builtins;
 	int demand_loading;
+	bool arena; /* allocate input graphs with AgArenaDisc */
     } GVCOMMON_t;
 
 #ifdef __cplusplus
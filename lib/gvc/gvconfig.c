@@ -16,6 +16,7 @@
 
 #include <cgraph/alloc.h>
 #include <cgraph/exit.h>
+#include <cgraph/tls.h>
 #include <gvc/gvconfig.h>
 
 #include <ctype.h>
@@ -267,13 +268,19 @@ static void gvconfig_write_library_config(GVC_t *gvc, char *lib_path,
 static int line_callback(struct dl_phdr_info *info, size_t size, void *line)
 {
    const char *p = info->dlpi_name;
-   char *tmp = strstr(p, "/libgvc.");
+   const char *tmp = strstr(p, "/libgvc.");
    (void) size;
    if (tmp) {
-        *tmp = 0;
+        /* the name belongs to the loader, and is searched again by each
+         * thread, so copy the directory part rather than cutting it short */
+        const size_t len = (size_t)(tmp - p);
+        if (len + sizeof("/graphviz") > BSZ)
+            return 0;
+        memcpy(line, p, len); // use line buffer for result
+        ((char *)line)[len] = '\0';
         /* Check for real /lib dir. Don't accept pre-install /.libs */
-        if (strcmp(strrchr(p,'/'), DOTLIBS) != 0) {
-            memmove(line, p, strlen(p) + 1); // use line buffer for result
+        const char *dir = strrchr(line, '/');
+        if (dir == NULL || strcmp(dir, DOTLIBS) != 0) {
             strcat(line, "/graphviz");  /* plugins are in "graphviz" subdirectory */
             return 1;
         }
@@ -284,9 +291,9 @@ static int line_callback(struct dl_phdr_info *info, size_t size, void *line)
 
 char * gvconfig_libdir(GVC_t * gvc)
 {
-    static char line[BSZ];
-    static char *libdir;
-    static bool dirShown = false;
+    static TLS char line[BSZ];
+    static TLS char *libdir;
+    static TLS bool dirShown = false;
 
     if (!libdir) {
         libdir=getenv("GVBINDIR");
@@ -52,6 +52,8 @@ GVC_t *gvNEWcontext(const lt_symlist_t *builtins, int demand_loading)
     gvc->common.errorfn = agerrorf;
     gvc->common.builtins = builtins;
     gvc->common.demand_loading = demand_loading;
+    gvc->layout_context = zmalloc(sizeof(layout_context_t));
+    gvSetLayoutContext(gvc->layout_context);
 
     return gvc;
 }
@@ -75,6 +77,9 @@ int gvFreeContext(GVC_t * gvc)
     unsigned int num_apis = APIS, i;
 #undef ELEM
 
+    for (size_t j = 0; j < gvc->batch_contexts_n; ++j)
+	gvFreeContext(gvc->batch_contexts[j]);
+    free(gvc->batch_contexts);
     emit_once_reset();
     gvg_next = gvc->gvgs;
     while ((gvg = gvg_next)) {
@@ -92,6 +97,9 @@ int gvFreeContext(GVC_t * gvc)
     free(gvc->config_path);
     free(gvc->input_filenames);
     textfont_dict_close(gvc);
+    if (gvLayoutContext() == gvc->layout_context)
+	gvSetLayoutContext(NULL);
+    free(gvc->layout_context);
     for (i = 0; i != num_apis; ++i) {
 	for (api = gvc->apis[i]; api != NULL; api = api_next) {
 	    api_next = api->next;
@@ -111,6 +119,8 @@ GVC_t* gvCloneGVC (GVC_t * gvc0)
     memcpy (&gvc->apis, &gvc0->apis, sizeof(gvc->apis));
     memcpy (&gvc->api, &gvc0->api, sizeof(gvc->api));
     gvc->packages = gvc0->packages;
+    gvc->layout_context = zmalloc(sizeof(layout_context_t));
+    *gvc->layout_context = *gvc0->layout_context;
     
     return gvc;
 }
@@ -118,6 +128,9 @@ GVC_t* gvCloneGVC (GVC_t * gvc0)
 void gvFreeCloneGVC (GVC_t * gvc)
 {
     gvjobs_delete(gvc);
+    if (gvLayoutContext() == gvc->layout_context)
+	gvSetLayoutContext(NULL);
+    free(gvc->layout_context);
     free(gvc);
 }
 
@@ -14,6 +14,7 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 
 /* these are intended to be private entry points - see gvc.h for the public ones */
 
@@ -123,6 +124,16 @@
 
     int gvlayout_select(GVC_t * gvc, const char *str);
 
+/* layout cache */
+
+    typedef struct {
+	uint64_t h1, h2;	/* two hashes of what the layout depends on */
+	bool used;		/* whether the cache is on for this layout */
+    } gvlayout_key_t;
+
+    bool gvlayout_cache_find(GVC_t * gvc, Agraph_t * g, gvlayout_key_t * key);
+    void gvlayout_cache_add(Agraph_t * g, const gvlayout_key_t * key);
+
 /* argvlist */
     void gv_argvlist_set_item(gv_argvlist_t *list, int index, char *item);
     void gv_argvlist_reset(gv_argvlist_t *list);
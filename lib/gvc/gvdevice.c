@@ -38,15 +38,16 @@
 static const unsigned char z_file_header[] =
    {0x1f, 0x8b, /*magic*/ Z_DEFLATED, 0 /*flags*/, 0,0,0,0 /*time*/, 0 /*xflags*/, OS_CODE};
 
-static z_stream z_strm;
-static unsigned char *df;
-static unsigned int dfallocated;
-static uint64_t crc;
+static TLS z_stream z_strm;
+static TLS unsigned char *df;
+static TLS unsigned int dfallocated;
+static TLS uint64_t crc;
 #endif /* HAVE_LIBZ */
 
 #include <assert.h>
 #include <cgraph/agxbuf.h>
 #include <cgraph/exit.h>
+#include <cgraph/tls.h>
 #include <common/const.h>
 #include <common/memory.h>
 #include <gvc/gvplugin_device.h>
@@ -85,7 +86,7 @@ static size_t gvwrite_no_z(GVJ_t * job, const void *s, size_t len) {
 
 static void auto_output_filename(GVJ_t *job)
 {
-    static agxbuf buf;
+    static TLS agxbuf buf;
     char *fn;
 
     if (!(fn = job->input_filename))
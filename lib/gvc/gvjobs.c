@@ -10,6 +10,7 @@
 
 #include "config.h"
 
+#include	<cgraph/tls.h>
 #include	<common/memory.h>
 #include	<common/types.h>
 #include        <gvc/gvplugin.h>
@@ -18,8 +19,8 @@
 #include        <gvc/gvcproc.h>
 #include        <stdbool.h>
 
-static GVJ_t *output_filename_job;
-static GVJ_t *output_langname_job;
+static TLS GVJ_t *output_filename_job;
+static TLS GVJ_t *output_langname_job;
 
 /*
  * -T and -o can be specified in any order relative to the other, e.g.
@@ -19,6 +19,8 @@
 #include <gvc/gvplugin_layout.h>
 #include <gvc/gvcint.h>
 #include <cgraph/cgraph.h>
+#include <common/globals.h>
+#include <common/random.h>
 #include <gvc/gvcproc.h>
 #include <gvc/gvc.h>
 #include <stdbool.h>
@@ -62,6 +64,7 @@ int gvLayoutJobs(GVC_t * gvc, Agraph_t * g)
         agbindrec(agroot(g), "Agraphinfo_t", sizeof(Agraphinfo_t), true);
         GD_gvc(agroot(g)) = gvc;
     }
+    gvSetLayoutContext(gvc->layout_context);
 
     if ((p = agget(g, "layout"))) {
         gvc->layout.engine = NULL;
@@ -78,15 +81,24 @@ int gvLayoutJobs(GVC_t * gvc, Agraph_t * g)
 	return -1;
 
     gv_fixLocale (1);
+    /* start every layout from the same random sequence, so its result does
+     * not depend on what was laid out before it in this thread */
+    gv_reset_random();
     graph_init(g, !!(gvc->layout.features->flags & LAYOUT_USES_RANKDIR));
     GD_drawing(agroot(g)) = GD_drawing(g);
     gv_initShapes ();
+    gvlayout_key_t key;
+    if (gvlayout_cache_find(gvc, g, &key)) {
+	gv_fixLocale (0);
+	return 0;
+    }
     if (gvle && gvle->layout) {
 	gvle->layout(g);
 
 
 	if (gvle->cleanup)
 	    GD_cleanup(g) = gvle->cleanup;
+	gvlayout_cache_add(g, &key);
     }
     gv_fixLocale (0);
     return 0;
@@ -105,7 +117,8 @@ bool gvLayoutDone(Agraph_t * g)
  */
 int gvFreeLayout(GVC_t * gvc, Agraph_t * g)
 {
-    (void)gvc;
+    if (gvc)
+	gvSetLayoutContext(gvc->layout_context);
 
     /* skip if no Agraphinfo_t yet */
     if (! agbindrec(g, "Agraphinfo_t", 0, true))
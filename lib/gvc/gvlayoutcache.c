@@ -0,0 +1,1080 @@
+/*************************************************************************
+ * Copyright (c) 2011 AT&T Intellectual Property
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors: Details at https://graphviz.org
+ *************************************************************************/
+
+/* A cache of layouts, keyed by what the layout of a graph depends on.
+ *
+ * The key hashes the engine, the structure of the graph and the values of
+ * its attributes, leaving out those that only change how a drawing is
+ * rendered, such as colors and links. A graph with the key of one laid out
+ * before gets that layout's node coordinates and sizes, splines, label
+ * positions and bounding boxes back without running the engine; its labels
+ * and shapes are made from its own attributes as usual. The nodes and edges
+ * the engine put in or took out of clusters are restored with the layout.
+ *
+ * Layouts are kept as text, exact to the bit, in memory for the
+ * GV_LAYOUT_CACHE most recently used, and in files in the directory
+ * GV_LAYOUT_CACHE_DIR, whose oldest files are removed once they take more
+ * than GV_LAYOUT_CACHE_DIR_MB megabytes (64 by default). Both are off
+ * unless set.
+ */
+
+#include "config.h"
+
+#include <cgraph/agxbuf.h>
+#include <cgraph/alloc.h>
+#include <cgraph/cgraph.h>
+#include <common/globals.h>
+#include <common/render.h>
+#include <common/utils.h>
+#include <gvc/gvc.h>
+#include <gvc/gvcint.h>
+#include <gvc/gvcproc.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#ifdef _WIN32
+#include <process.h>
+#include <sys/utime.h>
+#include <windows.h>
+#define getpid _getpid
+#define utime _utime
+#else
+#include <glob.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <utime.h>
+#endif
+
+#define RECORD_VERSION 2
+
+/* a layout kept in memory */
+typedef struct entry_s {
+    uint64_t h1, h2;
+    char *data;
+    struct entry_s *prev, *next;	/* most recently used first */
+} entry_t;
+
+static struct {
+    bool configured;
+    size_t capacity;	/* layouts kept in memory */
+    char *dir;		/* of the files, or NULL */
+    uint64_t dir_limit;	/* bytes the files may take */
+    entry_t *first, *last;
+    size_t count;
+    size_t hits, misses;
+    unsigned serial;	/* for the names of temporary files */
+} Cache;
+
+#ifdef _WIN32
+static SRWLOCK Lock = SRWLOCK_INIT;
+static void cache_lock(void) { AcquireSRWLockExclusive(&Lock); }
+static void cache_unlock(void) { ReleaseSRWLockExclusive(&Lock); }
+#else
+static pthread_mutex_t Lock = PTHREAD_MUTEX_INITIALIZER;
+static void cache_lock(void) { pthread_mutex_lock(&Lock); }
+static void cache_unlock(void) { pthread_mutex_unlock(&Lock); }
+#endif
+
+/* cache_configure:
+ * Read the settings of the cache from the environment, once. Call with the
+ * lock held. Return whether the cache is on.
+ */
+static bool cache_configure(void)
+{
+    if (!Cache.configured) {
+	const char *s = getenv("GV_LAYOUT_CACHE");
+	if (s && atoi(s) > 0)
+	    Cache.capacity = (size_t)atoi(s);
+	s = getenv("GV_LAYOUT_CACHE_DIR");
+	if (s && *s)
+	    Cache.dir = gv_strdup(s);
+	s = getenv("GV_LAYOUT_CACHE_DIR_MB");
+	Cache.dir_limit = (uint64_t)(s && atoi(s) > 0 ? atoi(s) : 64) << 20;
+	Cache.configured = true;
+    }
+    return Cache.capacity > 0 || Cache.dir != NULL;
+}
+
+/* attributes that do not change a layout */
+static const char *RenderOnly[] = {
+    "URL", "bgcolor", "class", "color", "colorscheme", "comment", "edgeURL",
+    "edgehref", "edgetarget", "edgetooltip", "fillcolor", "fontcolor",
+    "gradientangle", "headURL", "headhref", "headtarget", "headtooltip",
+    "href", "id", "labelURL", "labelfontcolor", "labelhref", "labeltarget",
+    "labeltooltip", "layer", "layerlistsep", "layers", "layerselect",
+    "layersep", "pencolor", "stylesheet", "tailURL", "tailhref", "tailtarget",
+    "tailtooltip", "target", "tooltip", "truecolor",
+};
+
+/* layout_attrs:
+ * The attributes of kind declared in g that may change its layout, in a
+ * NULL terminated array.
+ */
+static Agsym_t **layout_attrs(graph_t * g, int kind)
+{
+    Agsym_t *sym;
+    size_t n = 0;
+
+    for (sym = agnxtattr(g, kind, NULL); sym; sym = agnxtattr(g, kind, sym))
+	n++;
+    Agsym_t **syms = gv_calloc(n + 1, sizeof(Agsym_t *));
+    n = 0;
+    for (sym = agnxtattr(g, kind, NULL); sym; sym = agnxtattr(g, kind, sym)) {
+	bool skip = false;
+	for (size_t i = 0; i < sizeof(RenderOnly) / sizeof(RenderOnly[0]); i++)
+	    if (strcmp(sym->name, RenderOnly[i]) == 0) {
+		skip = true;
+		break;
+	    }
+	if (!skip)
+	    syms[n++] = sym;
+    }
+    return syms;
+}
+
+/* two independent 64 bit hashes, FNV-1a and a multiplicative one */
+typedef struct {
+    uint64_t h1, h2;
+    Agsym_t **gattrs, **nattrs, **eattrs;
+} hasher_t;
+
+static void hash_str(hasher_t * h, const char *s)
+{
+    if (s == NULL)
+	s = "";
+    /* the terminating 0 keeps consecutive strings apart */
+    for (size_t i = 0, n = strlen(s) + 1; i < n; i++) {
+	const unsigned char c = (unsigned char)s[i];
+	h->h1 = (h->h1 ^ c) * UINT64_C(0x100000001b3);
+	h->h2 = ((h->h2 << 5 | h->h2 >> 59) ^ c) * UINT64_C(0x9e3779b97f4a7c15);
+    }
+}
+
+/* is_anonymous:
+ * Whether s is one of the names cgraph makes up for anonymous objects, which
+ * differ from one reading of a graph to the next.
+ */
+static bool is_anonymous(const char *s)
+{
+    return s == NULL || s[0] == '%';
+}
+
+static void hash_name(hasher_t * h, const char *s)
+{
+    hash_str(h, is_anonymous(s) ? NULL : s);
+}
+
+static void hash_values(hasher_t * h, void *obj, Agsym_t ** syms)
+{
+    for (size_t i = 0; syms[i]; i++)
+	hash_str(h, agxget(obj, syms[i]));
+}
+
+static void hash_edge(hasher_t * h, edge_t * e)
+{
+    hash_name(h, agnameof(agtail(e)));
+    hash_name(h, agnameof(aghead(e)));
+    hash_name(h, agnameof(e));
+}
+
+static void hash_subgraphs(hasher_t * h, graph_t * g)
+{
+    for (graph_t *sg = agfstsubg(g); sg; sg = agnxtsubg(sg)) {
+	hash_name(h, agnameof(sg));
+	hash_values(h, sg, h->gattrs);
+	for (node_t *n = agfstnode(sg); n; n = agnxtnode(sg, n)) {
+	    hash_name(h, agnameof(n));
+	    for (edge_t *e = agfstout(sg, n); e; e = agnxtout(sg, e))
+		hash_edge(h, e);
+	}
+	hash_subgraphs(h, sg);
+	hash_str(h, "}");
+    }
+}
+
+/* layout_key:
+ * Hash what the layout of g by the engine of gvc depends on.
+ */
+static void layout_key(GVC_t * gvc, graph_t * g, gvlayout_key_t * key)
+{
+    layout_context_t *const lctx = gvLayoutContext();
+    hasher_t h = {.h1 = UINT64_C(0xcbf29ce484222325),
+		  .h2 = UINT64_C(0x84222325cbf29ce4)};
+    char buf[64];
+
+    hash_str(&h, PACKAGE_VERSION);
+    hash_str(&h, gvc->layout.type);
+    snprintf(buf, sizeof(buf), "%d %d %d %d", agisdirected(g), agisstrict(g),
+	     lctx->Nop, lctx->Ndim);
+    hash_str(&h, buf);
+    hash_name(&h, agnameof(g));
+
+    h.gattrs = layout_attrs(g, AGRAPH);
+    h.nattrs = layout_attrs(g, AGNODE);
+    h.eattrs = layout_attrs(g, AGEDGE);
+    Agsym_t **kinds[] = {h.gattrs, h.nattrs, h.eattrs};
+    for (size_t k = 0; k < sizeof(kinds) / sizeof(kinds[0]); k++) {
+	for (size_t i = 0; kinds[k][i]; i++)
+	    hash_str(&h, kinds[k][i]->name);
+	hash_str(&h, "}");
+    }
+
+    hash_values(&h, g, h.gattrs);
+    for (node_t *n = agfstnode(g); n; n = agnxtnode(g, n)) {
+	hash_name(&h, agnameof(n));
+	hash_values(&h, n, h.nattrs);
+    }
+    for (node_t *n = agfstnode(g); n; n = agnxtnode(g, n))
+	for (edge_t *e = agfstout(g, n); e; e = agnxtout(g, e)) {
+	    hash_edge(&h, e);
+	    hash_values(&h, e, h.eattrs);
+	}
+    hash_subgraphs(&h, g);
+
+    free(h.gattrs);
+    free(h.nattrs);
+    free(h.eattrs);
+    key->h1 = h.h1;
+    key->h2 = h.h2;
+}
+
+/* Writing a layout. Numbers are written in hexadecimal floating point, so
+ * they read back exactly.
+ */
+
+static void put_box(agxbuf * xb, boxf b)
+{
+    agxbprint(xb, " %a %a %a %a", b.LL.x, b.LL.y, b.UR.x, b.UR.y);
+}
+
+static void put_label(agxbuf * xb, textlabel_t * l)
+{
+    if (l == NULL)
+	agxbput(xb, " -");
+    else
+	agxbprint(xb, " %d %a %a", l->set ? 1 : 0, l->pos.x, l->pos.y);
+}
+
+static void put_name(agxbuf * xb, const char *s)
+{
+    agxbprint(xb, " %zu:%s", strlen(s), s);
+}
+
+/* put_subgraph:
+ * Write the name of sg, or for an anonymous one, its place among the
+ * anonymous subgraphs of its parent.
+ */
+static void put_subgraph(agxbuf * xb, graph_t * sg)
+{
+    const char *name = agnameof(sg);
+    if (!is_anonymous(name)) {
+	put_name(xb, name);
+	return;
+    }
+    int k = 0;
+    for (graph_t *s = agfstsubg(agparent(sg)); s != sg; s = agnxtsubg(s))
+	if (is_anonymous(agnameof(s)))
+	    k++;
+    agxbprint(xb, " *%d", k);
+}
+
+/* put_clusters:
+ * Write the clusters of g, each with the names of the subgraphs leading to
+ * it from g.
+ */
+static void put_clusters(agxbuf * xb, graph_t * g)
+{
+    agxbprint(xb, "K %d\n", GD_n_cluster(g));
+    for (int c = 1; c <= GD_n_cluster(g); c++) {
+	graph_t *sg = GD_clust(g)[c];
+	graph_t *path[64];
+	int depth = 0;
+	for (graph_t *p = sg; p != g && depth < 64; p = agparent(p))
+	    path[depth++] = p;
+	agxbprint(xb, "c %d", depth);
+	while (depth > 0)
+	    put_subgraph(xb, path[--depth]);
+	put_box(xb, GD_bb(sg));
+	put_label(xb, GD_label(sg));
+	agxbputc(xb, '\n');
+	put_clusters(xb, sg);
+    }
+}
+
+/* max_seq:
+ * The largest sequence number of the nodes or edges of g.
+ */
+static size_t max_seq(graph_t * g, int kind)
+{
+    size_t max = 0;
+    for (node_t *n = agfstnode(g); n; n = agnxtnode(g, n)) {
+	if (kind == AGNODE && AGSEQ(n) > max)
+	    max = AGSEQ(n);
+	for (edge_t *e = agfstout(g, n); e && kind == AGEDGE; e = agnxtout(g, e))
+	    if (AGSEQ(e) > max)
+		max = AGSEQ(e);
+    }
+    return max;
+}
+
+/* put_members:
+ * Write the nodes and edges of each cluster of g, as an engine may have
+ * changed them, by their places in the lists of the layout. node_at and
+ * edge_at give these places by sequence number.
+ */
+static void put_members(agxbuf * xb, graph_t * g, const size_t * node_at,
+			const size_t * edge_at)
+{
+    for (int c = 1; c <= GD_n_cluster(g); c++) {
+	graph_t *sg = GD_clust(g)[c];
+	agxbprint(xb, "m %d", agnnodes(sg));
+	for (node_t *n = agfstnode(sg); n; n = agnxtnode(sg, n))
+	    agxbprint(xb, " %zu", node_at[AGSEQ(n)]);
+	agxbprint(xb, " %d", agnedges(sg));
+	for (node_t *n = agfstnode(sg); n; n = agnxtnode(sg, n))
+	    for (edge_t *e = agfstout(sg, n); e; e = agnxtout(sg, e))
+		agxbprint(xb, " %zu", edge_at[AGSEQ(e)]);
+	agxbputc(xb, '\n');
+	put_members(xb, sg, node_at, edge_at);
+    }
+}
+
+static char *put_layout(graph_t * g, const gvlayout_key_t * key)
+{
+    layout_context_t *const lctx = gvLayoutContext();
+    agxbuf xb = {0};
+
+    agxbprint(&xb, "gvlayout %d %016" PRIx64 "\n", RECORD_VERSION, key->h2);
+    agxbprint(&xb, "G %d %d %d", GD_flags(g), lctx->State, lctx->EdgeLabelsDone);
+    put_box(&xb, GD_bb(g));
+    put_label(&xb, GD_label(g));
+    agxbputc(&xb, '\n');
+    put_clusters(&xb, g);
+
+    agxbprint(&xb, "N %d\n", agnnodes(g));
+    for (node_t *n = agfstnode(g); n; n = agnxtnode(g, n)) {
+	agxbprint(&xb, "n %a %a %a %a %a %a %a", ND_coord(n).x, ND_coord(n).y,
+		  ND_width(n), ND_height(n), ND_lw(n), ND_rw(n), ND_ht(n));
+	put_label(&xb, ND_xlabel(n));
+	agxbputc(&xb, '\n');
+    }
+
+    agxbprint(&xb, "E %d\n", agnedges(g));
+    for (node_t *n = agfstnode(g); n; n = agnxtnode(g, n))
+	for (edge_t *e = agfstout(g, n); e; e = agnxtout(g, e)) {
+	    splines *spl = ED_spl(e);
+	    agxbprint(&xb, "e %d %d", ED_edge_type(e), spl ? spl->size : -1);
+	    put_label(&xb, ED_label(e));
+	    put_label(&xb, ED_xlabel(e));
+	    put_label(&xb, ED_head_label(e));
+	    put_label(&xb, ED_tail_label(e));
+	    if (spl)
+		put_box(&xb, spl->bb);
+	    agxbputc(&xb, '\n');
+	    for (int i = 0; spl && i < spl->size; i++) {
+		bezier *bz = &spl->list[i];
+		agxbprint(&xb, "b %d %" PRIu32 " %" PRIu32 " %a %a %a %a",
+			  bz->size, bz->sflag, bz->eflag, bz->sp.x, bz->sp.y,
+			  bz->ep.x, bz->ep.y);
+		for (int j = 0; j < bz->size; j++)
+		    agxbprint(&xb, " %a %a", bz->list[j].x, bz->list[j].y);
+		agxbputc(&xb, '\n');
+	    }
+	}
+
+    size_t *node_at = gv_calloc(max_seq(g, AGNODE) + 1, sizeof(size_t));
+    size_t *edge_at = gv_calloc(max_seq(g, AGEDGE) + 1, sizeof(size_t));
+    size_t nodes = 0, edges = 0;
+    for (node_t *n = agfstnode(g); n; n = agnxtnode(g, n)) {
+	node_at[AGSEQ(n)] = nodes++;
+	for (edge_t *e = agfstout(g, n); e; e = agnxtout(g, e))
+	    edge_at[AGSEQ(e)] = edges++;
+    }
+    agxbput(&xb, "M\n");
+    put_members(&xb, g, node_at, edge_at);
+    free(node_at);
+    free(edge_at);
+    return agxbdisown(&xb);
+}
+
+/* Reading a layout back. Any mismatch clears ok, after which the reader
+ * reads nothing more.
+ */
+typedef struct {
+    const char *p;
+    bool ok;
+} reader_t;
+
+static void skip_space(reader_t * r)
+{
+    while (*r->p == ' ' || *r->p == '\n')
+	r->p++;
+}
+
+static void expect(reader_t * r, const char *word)
+{
+    skip_space(r);
+    const size_t len = strlen(word);
+    if (r->ok && strncmp(r->p, word, len) == 0)
+	r->p += len;
+    else
+	r->ok = false;
+}
+
+static double get_double(reader_t * r)
+{
+    char *end;
+    if (!r->ok)
+	return 0;
+    const double d = strtod(r->p, &end);
+    if (end == r->p)
+	r->ok = false;
+    r->p = end;
+    return d;
+}
+
+static long get_int(reader_t * r)
+{
+    char *end;
+    if (!r->ok)
+	return 0;
+    const long i = strtol(r->p, &end, 10);
+    if (end == r->p)
+	r->ok = false;
+    r->p = end;
+    return i;
+}
+
+static boxf get_box(reader_t * r)
+{
+    boxf b;
+    b.LL.x = get_double(r);
+    b.LL.y = get_double(r);
+    b.UR.x = get_double(r);
+    b.UR.y = get_double(r);
+    return b;
+}
+
+static void get_label(reader_t * r, textlabel_t * l)
+{
+    skip_space(r);
+    if (!r->ok)
+	return;
+    if (*r->p == '-') {
+	r->p++;
+	if (l)
+	    r->ok = false;
+	return;
+    }
+    const bool set = get_int(r) != 0;
+    const double x = get_double(r);
+    const double y = get_double(r);
+    if (l == NULL) {
+	r->ok = false;
+	return;
+    }
+    l->set = set;
+    l->pos.x = x;
+    l->pos.y = y;
+}
+
+/* get_subgraph:
+ * Find the subgraph of g whose name, given with its length, or place among
+ * the anonymous ones comes next.
+ */
+static graph_t *get_subgraph(reader_t * r, graph_t * g)
+{
+    skip_space(r);
+    if (r->ok && *r->p == '*') {
+	r->p++;
+	long k = get_int(r);
+	graph_t *sg = agfstsubg(g);
+	for (; sg && r->ok; sg = agnxtsubg(sg))
+	    if (is_anonymous(agnameof(sg)) && k-- == 0)
+		break;
+	if (sg == NULL)
+	    r->ok = false;
+	return sg;
+    }
+    const long len = get_int(r);
+    if (!r->ok || len < 0 || *r->p != ':') {
+	r->ok = false;
+	return NULL;
+    }
+    r->p++;
+    if (strnlen(r->p, (size_t)len) < (size_t)len) {
+	r->ok = false;
+	return NULL;
+    }
+    char *name = gv_strndup(r->p, (size_t)len);
+    r->p += len;
+    graph_t *sg = agsubg(g, name, 0);
+    free(name);
+    if (sg == NULL)
+	r->ok = false;
+    return sg;
+}
+
+static void get_clusters(reader_t * r, graph_t * g)
+{
+    expect(r, "K");
+    const long n = get_int(r);
+    if (!r->ok || n < 0 || n > INT_MAX - 1) {
+	r->ok = false;
+	return;
+    }
+    GD_n_cluster(g) = 0;
+    GD_clust(g) = n > 0 ? gv_calloc((size_t)n + 1, sizeof(graph_t *)) : NULL;
+    for (long c = 1; c <= n && r->ok; c++) {
+	expect(r, "c");
+	const long depth = get_int(r);
+	graph_t *sg = g;
+	for (long i = 0; i < depth && r->ok; i++)
+	    sg = get_subgraph(r, sg);
+	if (!r->ok || sg == g)
+	    break;
+	/* start from a clean record, as a layout leaves it behind */
+	agdelrec(sg, "Agraphinfo_t");
+	agbindrec(sg, "Agraphinfo_t", sizeof(Agraphinfo_t), true);
+	GD_clust(g)[++GD_n_cluster(g)] = sg;
+	do_graph_label(sg);
+	GD_bb(sg) = get_box(r);
+	get_label(r, GD_label(sg));
+	get_clusters(r, sg);
+    }
+}
+
+static void free_clusters(graph_t * g)
+{
+    for (int c = 1; c <= GD_n_cluster(g); c++) {
+	graph_t *sg = GD_clust(g)[c];
+	free_clusters(sg);
+	free_label(GD_label(sg));
+	GD_label(sg) = NULL;
+    }
+    free(GD_clust(g));
+    GD_clust(g) = NULL;
+    GD_n_cluster(g) = 0;
+}
+
+/* cache_cleanup:
+ * Free what restoring a layout made, in place of the engine's cleanup.
+ */
+static void cache_cleanup(graph_t * g)
+{
+    for (node_t *n = agfstnode(g); n; n = agnxtnode(g, n)) {
+	for (edge_t *e = agfstout(g, n); e; e = agnxtout(g, e))
+	    if (agbindrec(e, "Agedgeinfo_t", 0, true))
+		gv_cleanup_edge(e);
+	if (agbindrec(n, "Agnodeinfo_t", 0, true))
+	    gv_cleanup_node(n);
+    }
+    free_clusters(g);
+}
+
+static splines *get_splines(reader_t * r, long n)
+{
+    splines *spl = gv_alloc(sizeof(splines));
+    spl->bb = get_box(r);
+    if (n > 0)
+	spl->list = gv_calloc((size_t)n, sizeof(bezier));
+    for (long i = 0; i < n && r->ok; i++) {
+	bezier *bz = &spl->list[i];
+	expect(r, "b");
+	const long size = get_int(r);
+	if (!r->ok || size < 0 || size > INT_MAX) {
+	    r->ok = false;
+	    break;
+	}
+	bz->sflag = (uint32_t)get_int(r);
+	bz->eflag = (uint32_t)get_int(r);
+	bz->sp.x = get_double(r);
+	bz->sp.y = get_double(r);
+	bz->ep.x = get_double(r);
+	bz->ep.y = get_double(r);
+	if (size > 0)
+	    bz->list = gv_calloc((size_t)size, sizeof(pointf));
+	bz->size = (int)size;
+	for (long j = 0; j < size && r->ok; j++) {
+	    bz->list[j].x = get_double(r);
+	    bz->list[j].y = get_double(r);
+	}
+	spl->size = (int)(i + 1);
+    }
+    return spl;
+}
+
+/* the nodes and edges of a graph, for reading the members of its clusters */
+typedef struct {
+    node_t **node;	/* in the order of the layout */
+    edge_t **edge;
+    size_t nodes, edges;
+    bool *in_node, *in_edge;	/* by sequence number, while applying */
+} members_t;
+
+/* get_indices:
+ * Read a count and that many places in a list of size objects. When apply is
+ * set, which is only once they have all been read without error, return
+ * where the count starts; otherwise NULL.
+ */
+static const char *get_indices(reader_t * r, size_t size, bool apply)
+{
+    const char *start = r->p;
+    const long n = get_int(r);
+    if (!r->ok || n < 0 || (size_t)n > size) {
+	r->ok = false;
+	return NULL;
+    }
+    for (long i = 0; i < n && r->ok; i++) {
+	const long k = get_int(r);
+	if (k < 0 || (size_t)k >= size)
+	    r->ok = false;
+    }
+    return apply ? start : NULL;
+}
+
+/* get_cluster_nodes:
+ * Read the nodes of cluster sg, and when apply is set, make them its nodes.
+ */
+static void get_cluster_nodes(reader_t * r, graph_t * sg, members_t * m,
+			      bool apply)
+{
+    const char *start = get_indices(r, m->nodes, apply);
+    if (start == NULL)
+	return;
+    reader_t list = {.p = start, .ok = true};
+    const long n = get_int(&list);
+    for (long i = 0; i < n; i++)
+	m->in_node[AGSEQ(m->node[get_int(&list)])] = true;
+    for (node_t *v = agfstnode(sg), *next; v; v = next) {
+	next = agnxtnode(sg, v);
+	if (!m->in_node[AGSEQ(v)])
+	    agdelete(sg, v);
+    }
+    list.p = start;
+    get_int(&list);
+    for (long i = 0; i < n; i++) {
+	node_t *v = m->node[get_int(&list)];
+	m->in_node[AGSEQ(v)] = false;
+	agsubnode(sg, v, 1);
+    }
+}
+
+/* get_cluster_edges:
+ * Read the edges of cluster sg, and when apply is set, make them its edges.
+ */
+static void get_cluster_edges(reader_t * r, graph_t * sg, members_t * m,
+			      bool apply)
+{
+    const char *start = get_indices(r, m->edges, apply);
+    if (start == NULL)
+	return;
+    reader_t list = {.p = start, .ok = true};
+    const long n = get_int(&list);
+    for (long i = 0; i < n; i++)
+	m->in_edge[AGSEQ(m->edge[get_int(&list)])] = true;
+    for (node_t *v = agfstnode(sg); v; v = agnxtnode(sg, v))
+	for (edge_t *e = agfstout(sg, v), *next; e; e = next) {
+	    next = agnxtout(sg, e);
+	    if (!m->in_edge[AGSEQ(e)])
+		agdelete(sg, e);
+	}
+    list.p = start;
+    get_int(&list);
+    for (long i = 0; i < n; i++) {
+	edge_t *e = m->edge[get_int(&list)];
+	m->in_edge[AGSEQ(e)] = false;
+	agsubedge(sg, e, 1);
+    }
+}
+
+/* get_members:
+ * Read the nodes and edges of the clusters of g. Only check them, unless
+ * apply is set.
+ */
+static void get_members(reader_t * r, graph_t * g, members_t * m, bool apply)
+{
+    for (int c = 1; c <= GD_n_cluster(g) && r->ok; c++) {
+	graph_t *sg = GD_clust(g)[c];
+	expect(r, "m");
+	get_cluster_nodes(r, sg, m, apply);
+	get_cluster_edges(r, sg, m, apply);
+	get_members(r, sg, m, apply);
+    }
+}
+
+/* get_layout:
+ * Set up g as its engine would and give it the layout in data. Return
+ * false, leaving g as it was, if data does not fit g.
+ */
+static bool get_layout(graph_t * g, const char *data, const gvlayout_key_t * key)
+{
+    layout_context_t *const lctx = gvLayoutContext();
+    reader_t r = {.p = data, .ok = true};
+    char check[32];
+
+    snprintf(check, sizeof(check), "%016" PRIx64, key->h2);
+    expect(&r, "gvlayout");
+    if (get_int(&r) != RECORD_VERSION)
+	return false;
+    expect(&r, check);
+
+    expect(&r, "G");
+    const int flags = (int)get_int(&r);
+    const int state = (int)get_int(&r);
+    const int labels_done = (int)get_int(&r);
+    const boxf bb = get_box(&r);
+    get_label(&r, GD_label(g));
+    if (!r.ok)
+	return false;
+    get_clusters(&r, g);
+
+    expect(&r, "N");
+    if (get_int(&r) != agnnodes(g))
+	r.ok = false;
+    for (node_t *n = agfstnode(g); n && r.ok; n = agnxtnode(g, n)) {
+	expect(&r, "n");
+	agbindrec(n, "Agnodeinfo_t", sizeof(Agnodeinfo_t), true);
+	common_init_node(n);
+	ND_coord(n).x = get_double(&r);
+	ND_coord(n).y = get_double(&r);
+	ND_width(n) = get_double(&r);
+	ND_height(n) = get_double(&r);
+	ND_lw(n) = get_double(&r);
+	ND_rw(n) = get_double(&r);
+	ND_ht(n) = get_double(&r);
+	get_label(&r, ND_xlabel(n));
+    }
+
+    expect(&r, "E");
+    if (get_int(&r) != agnedges(g))
+	r.ok = false;
+    for (node_t *n = agfstnode(g); n && r.ok; n = agnxtnode(g, n))
+	for (edge_t *e = agfstout(g, n); e && r.ok; e = agnxtout(g, e)) {
+	    expect(&r, "e");
+	    agbindrec(e, "Agedgeinfo_t", sizeof(Agedgeinfo_t), true);
+	    common_init_edge(e);
+	    ED_edge_type(e) = (char)get_int(&r);
+	    const long beziers = get_int(&r);
+	    get_label(&r, ED_label(e));
+	    get_label(&r, ED_xlabel(e));
+	    get_label(&r, ED_head_label(e));
+	    get_label(&r, ED_tail_label(e));
+	    if (r.ok && beziers >= 0)
+		ED_spl(e) = get_splines(&r, beziers);
+	}
+
+    members_t m = {0};
+    m.node = gv_calloc((size_t)agnnodes(g), sizeof(node_t *));
+    m.edge = gv_calloc((size_t)agnedges(g), sizeof(edge_t *));
+    for (node_t *n = agfstnode(g); n; n = agnxtnode(g, n)) {
+	m.node[m.nodes++] = n;
+	for (edge_t *e = agfstout(g, n); e; e = agnxtout(g, e))
+	    m.edge[m.edges++] = e;
+    }
+    expect(&r, "M");
+    const char *members = r.p;
+    get_members(&r, g, &m, false);
+
+    skip_space(&r);
+    if (!r.ok || *r.p != '\0') {
+	free(m.node);
+	free(m.edge);
+	cache_cleanup(g);
+	return false;
+    }
+    m.in_node = gv_calloc(max_seq(g, AGNODE) + 1, sizeof(bool));
+    m.in_edge = gv_calloc(max_seq(g, AGEDGE) + 1, sizeof(bool));
+    reader_t again = {.p = members, .ok = true};
+    get_members(&again, g, &m, true);
+    free(m.in_node);
+    free(m.in_edge);
+    free(m.node);
+    free(m.edge);
+    GD_flags(g) = flags;
+    GD_bb(g) = bb;
+    lctx->State = state;
+    lctx->EdgeLabelsDone = labels_done;
+    GD_cleanup(g) = cache_cleanup;
+    return true;
+}
+
+/* In memory. Call these with the lock held. */
+
+static void entry_unlink(entry_t * e)
+{
+    if (e->prev)
+	e->prev->next = e->next;
+    else
+	Cache.first = e->next;
+    if (e->next)
+	e->next->prev = e->prev;
+    else
+	Cache.last = e->prev;
+    e->prev = e->next = NULL;
+}
+
+static void entry_push(entry_t * e)
+{
+    e->next = Cache.first;
+    if (Cache.first)
+	Cache.first->prev = e;
+    Cache.first = e;
+    if (Cache.last == NULL)
+	Cache.last = e;
+}
+
+/* memory_find:
+ * A copy of the layout kept for key, or NULL.
+ */
+static char *memory_find(const gvlayout_key_t * key)
+{
+    for (entry_t *e = Cache.first; e; e = e->next)
+	if (e->h1 == key->h1 && e->h2 == key->h2) {
+	    entry_unlink(e);
+	    entry_push(e);
+	    return gv_strdup(e->data);
+	}
+    return NULL;
+}
+
+static void memory_add(const gvlayout_key_t * key, const char *data)
+{
+    if (Cache.capacity == 0)
+	return;
+    for (entry_t *e = Cache.first; e; e = e->next)
+	if (e->h1 == key->h1 && e->h2 == key->h2)
+	    return;
+    while (Cache.count >= Cache.capacity && Cache.last) {
+	entry_t *old = Cache.last;
+	entry_unlink(old);
+	free(old->data);
+	free(old);
+	Cache.count--;
+    }
+    entry_t *e = gv_alloc(sizeof(entry_t));
+    e->h1 = key->h1;
+    e->h2 = key->h2;
+    e->data = gv_strdup(data);
+    entry_push(e);
+    Cache.count++;
+}
+
+/* On disk, in a file per layout named by its key. */
+
+static char *file_name(const char *dir, const gvlayout_key_t * key)
+{
+    agxbuf xb = {0};
+    agxbprint(&xb, "%s/%016" PRIx64 ".gvl", dir, key->h1);
+    return agxbdisown(&xb);
+}
+
+static char *disk_find(const char *dir, const gvlayout_key_t * key)
+{
+    char *path = file_name(dir, key);
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+	free(path);
+	return NULL;
+    }
+    agxbuf xb = {0};
+    char buf[BUFSIZ];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+	agxbput_n(&xb, buf, n);
+    fclose(f);
+    /* mark it used, so it is among the last to be removed */
+    utime(path, NULL);
+    free(path);
+    return agxbdisown(&xb);
+}
+
+typedef struct {
+    char *path;
+    uint64_t size;
+    time_t mtime;
+} file_t;
+
+static int cmp_mtime(const void *x, const void *y)
+{
+    const file_t *a = x, *b = y;
+    return (a->mtime > b->mtime) - (a->mtime < b->mtime);
+}
+
+/* disk_trim:
+ * Remove the least recently used files of dir until they take at most
+ * limit bytes.
+ */
+static void disk_trim(const char *dir, uint64_t limit)
+{
+    file_t *files = NULL;
+    size_t n = 0, cap = 0;
+    uint64_t total = 0;
+    agxbuf xb = {0};
+
+#ifdef _WIN32
+    WIN32_FIND_DATAA fd;
+    agxbprint(&xb, "%s/*.gvl", dir);
+    HANDLE h = FindFirstFileA(agxbuse(&xb), &fd);
+    if (h == INVALID_HANDLE_VALUE) {
+	agxbfree(&xb);
+	return;
+    }
+    do {
+	struct stat st;
+	agxbprint(&xb, "%s/%s", dir, fd.cFileName);
+	char *path = agxbdisown(&xb);
+#else
+    glob_t gl;
+    agxbprint(&xb, "%s/*.gvl", dir);
+    if (glob(agxbuse(&xb), 0, NULL, &gl) != 0) {
+	agxbfree(&xb);
+	return;
+    }
+    for (size_t i = 0; i < gl.gl_pathc; i++) {
+	struct stat st;
+	char *path = gv_strdup(gl.gl_pathv[i]);
+#endif
+	if (stat(path, &st) != 0) {
+	    free(path);
+	    continue;
+	}
+	if (n == cap) {
+	    const size_t c = cap == 0 ? 64 : 2 * cap;
+	    files = gv_recalloc(files, cap, c, sizeof(file_t));
+	    cap = c;
+	}
+	files[n++] = (file_t){path, (uint64_t)st.st_size, st.st_mtime};
+	total += (uint64_t)st.st_size;
+#ifdef _WIN32
+    } while (FindNextFileA(h, &fd));
+    FindClose(h);
+#else
+    }
+    globfree(&gl);
+#endif
+    agxbfree(&xb);
+
+    if (total > limit) {
+	qsort(files, n, sizeof(file_t), cmp_mtime);
+	for (size_t i = 0; i < n && total > limit; i++)
+	    if (remove(files[i].path) == 0)
+		total -= files[i].size;
+    }
+    for (size_t i = 0; i < n; i++)
+	free(files[i].path);
+    free(files);
+}
+
+static void disk_add(const char *dir, uint64_t limit,
+		     const gvlayout_key_t * key, const char *data,
+		     unsigned serial)
+{
+    char *path = file_name(dir, key);
+    agxbuf xb = {0};
+
+    /* write to a file of its own, then rename it, so readers see all or
+     * nothing */
+    agxbprint(&xb, "%s.%d.%u.tmp", path, (int)getpid(), serial);
+    char *tmp = agxbdisown(&xb);
+    FILE *f = fopen(tmp, "wb");
+    if (f == NULL) {
+	if (Verbose)
+	    fprintf(stderr, "layout cache: cannot write %s\n", tmp);
+	free(tmp);
+	free(path);
+	return;
+    }
+    const size_t len = strlen(data);
+    const bool written = fwrite(data, 1, len, f) == len;
+    if (fclose(f) != 0 || !written || rename(tmp, path) != 0)
+	remove(tmp);
+    free(tmp);
+    free(path);
+    disk_trim(dir, limit);
+}
+
+bool gvlayout_cache_find(GVC_t * gvc, graph_t * g, gvlayout_key_t * key)
+{
+    *key = (gvlayout_key_t){0};
+    if (g != agroot(g))
+	return false;
+    /* a layout cut short by a time limit depends on more than the graph */
+    const char *limit = agget(g, "timelimit");
+    if (limit && *limit)
+	return false;
+    cache_lock();
+    const bool on = cache_configure();
+    const char *dir = Cache.dir;
+    cache_unlock();
+    if (!on)
+	return false;
+
+    key->used = true;
+    layout_key(gvc, g, key);
+
+    cache_lock();
+    char *data = memory_find(key);
+    cache_unlock();
+    const char *where = "memory";
+    bool from_disk = false;
+    if (data == NULL && dir) {
+	data = disk_find(dir, key);
+	where = "disk";
+	from_disk = true;
+    }
+    const bool hit = data && get_layout(g, data, key);
+
+    cache_lock();
+    if (hit) {
+	Cache.hits++;
+	if (from_disk)
+	    memory_add(key, data);
+    } else
+	Cache.misses++;
+    const size_t hits = Cache.hits, misses = Cache.misses;
+    cache_unlock();
+    free(data);
+
+    if (Verbose) {
+	if (hit)
+	    fprintf(stderr, "layout cache: hit in %s", where);
+	else
+	    fprintf(stderr, "layout cache: miss");
+	fprintf(stderr, ", %zu hits %zu misses\n", hits, misses);
+    }
+    return hit;
+}
+
+void gvlayout_cache_add(graph_t * g, const gvlayout_key_t * key)
+{
+    if (!key->used)
+	return;
+    char *data = put_layout(g, key);
+
+    cache_lock();
+    memory_add(key, data);
+    const char *dir = Cache.dir;
+    const uint64_t limit = Cache.dir_limit;
+    const unsigned serial = Cache.serial++;
+    cache_unlock();
+
+    if (dir)
+	disk_add(dir, limit, key, data, serial);
+    free(data);
+}
@@ -32,6 +32,7 @@
 #include <cgraph/alloc.h>
 #include <cgraph/strcasecmp.h>
 #include <cgraph/strview.h>
+#include <cgraph/tls.h>
 
 /*
  * Define an apis array of name strings using an enumerated api_t as index.
@@ -154,8 +155,8 @@ gvplugin_library_t *gvplugin_library_load(GVC_t * gvc, char *path)
     lt_ptr ptr;
     char *s, *sym;
     size_t len;
-    static char *p;
-    static size_t lenp;
+    static TLS char *p;
+    static TLS size_t lenp;
     char *libdir;
     char *suffix = "_LTX_library";
 
@@ -338,7 +339,7 @@ char *gvplugin_list(GVC_t * gvc, api_t api, const char *str)
     const gvplugin_available_t *pnext, *plugin;
     char *bp;
     bool new = true;
-    static agxbuf xb;
+    static TLS agxbuf xb;
 
     /* check for valid str */
     if (!str)
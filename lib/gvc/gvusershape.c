@@ -29,13 +29,14 @@
 #include <common/memory.h>
 #include <cgraph/agxbuf.h>
 #include <cgraph/strview.h>
+#include <cgraph/tls.h>
 #include <common/utils.h>
+#include <common/globals.h>
 #include <gvc/gvplugin_loadimage.h>
 #include <gvc/gvplugin.h>
 #include <gvc/gvcint.h>
 #include <gvc/gvcproc.h>
 
-extern char *Gvimagepath;
 extern char *HTTPServerEnVar;
 extern shape_desc *find_user_shape(const char *);
 
@@ -626,7 +627,7 @@ usershape_t *gvusershape_find(const char *name)
 #define MAX_USERSHAPE_FILES_OPEN 50
 bool gvusershape_file_access(usershape_t *us)
 {
-    static int usershape_files_open_cnt;
+    static TLS int usershape_files_open_cnt;
     const char *fn;
 
     assert(us);
@@ -764,9 +765,10 @@ gvusershape_size_dpi (usershape_t* us, pointf dpi)
  */
 point gvusershape_size(graph_t * g, char *name)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     point rv;
     pointf dpi;
-    static char* oldpath;
+    static TLS char* oldpath;
     usershape_t* us;
 
     /* no shape file, no shape size */
@@ -775,8 +777,8 @@ point gvusershape_size(graph_t * g, char *name)
 	return rv;
     }
 
-    if (!HTTPServerEnVar && (oldpath != Gvimagepath)) {
-	oldpath = Gvimagepath;
+    if (!HTTPServerEnVar && (oldpath != lctx->Gvimagepath)) {
+	oldpath = lctx->Gvimagepath;
 	if (ImageDict) {
 	    dtclose(ImageDict);
 	    ImageDict = NULL;
@@ -37,26 +37,27 @@
 #include <neatogen/quad_prog_vpsc.h>
 #endif
 #include <cgraph/strcasecmp.h>
+#include <cgraph/tls.h>
 #include <stddef.h>
 
 #define SEPFACT         0.8f  /* default esep/sep */
 
-static double margin = 0.05;	/* Create initial bounding box by adding
+static TLS double margin = 0.05;	/* Create initial bounding box by adding
 				 * margin * dimension around box enclosing
 				 * nodes.
 				 */
-static double incr = 0.05;	/* Increase bounding box by adding
+static TLS double incr = 0.05;	/* Increase bounding box by adding
 				 * incr * dimension around box.
 				 */
-static int iterations = -1;	/* Number of iterations */
-static int useIter = 0;		/* Use specified number of iterations */
+static TLS int iterations = -1;	/* Number of iterations */
+static TLS int useIter = 0;		/* Use specified number of iterations */
 
-static bool doAll = false; // Move all nodes, regardless of overlap
-static Site **sites;		/* Array of pointers to sites; used in qsort */
-static Site **endSite;		/* Sentinel on sites array */
-static Point nw, ne, sw, se;	/* Corners of clipping window */
+static TLS bool doAll = false; // Move all nodes, regardless of overlap
+static TLS Site **sites;		/* Array of pointers to sites; used in qsort */
+static TLS Site **endSite;		/* Sentinel on sites array */
+static TLS Point nw, ne, sw, se;	/* Corners of clipping window */
 
-static Site **nextSite;
+static TLS Site **nextSite;
 
 static void setBoundBox(Point * ll, Point * ur)
 {
@@ -487,6 +488,7 @@ static int vAdjust(void)
     int increaseCnt = 0;
     int cnt;
 
+    doAll = false; // may be left set by an earlier adjustment
     if (!useIter || iterations > 0)
 	overlapCnt = countOverlap(iterCnt);
 
@@ -600,16 +602,17 @@ static void updateGraph(void)
  */
 double *getSizes(Agraph_t * g, pointf pad, int* n_elabels, int** elabels)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     Agnode_t *n;
-    double *sizes = gv_calloc(Ndim * agnnodes(g), sizeof(double));
+    double *sizes = gv_calloc(lctx->Ndim * agnnodes(g), sizeof(double));
     int i, nedge_nodes = 0;
 
     for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
 	if (elabels && IS_LNODE(n)) nedge_nodes++;
 
 	i = ND_id(n);
-	sizes[i * Ndim] = ND_width(n) * .5 + pad.x;
-	sizes[i * Ndim + 1] = ND_height(n) * .5 + pad.y;
+	sizes[i * lctx->Ndim] = ND_width(n) * .5 + pad.x;
+	sizes[i * lctx->Ndim + 1] = ND_height(n) * .5 + pad.y;
     }
 
     if (elabels && nedge_nodes) {
@@ -683,10 +686,11 @@ SparseMatrix makeMatrix(Agraph_t *g) {
 
 #if ((defined(HAVE_GTS) || defined(HAVE_TRIANGLE)) && defined(SFDP))
 static void fdpAdjust(graph_t *g, adjust_data *am) {
+    layout_context_t *const lctx = gvLayoutContext();
     SparseMatrix A0 = makeMatrix(g);
     SparseMatrix A = A0;
     double *sizes;
-    double *pos = gv_calloc(Ndim * agnnodes(g), sizeof(double));
+    double *pos = gv_calloc(lctx->Ndim * agnnodes(g), sizeof(double));
     Agnode_t *n;
     int i;
     expand_t sep = sepFactor(g);
@@ -702,8 +706,8 @@ static void fdpAdjust(graph_t *g, adjust_data *am) {
     sizes = getSizes(g, pad, NULL, NULL);
 
     for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
-	double* npos = pos + Ndim * ND_id(n);
-	for (i = 0; i < Ndim; i++) {
+	double* npos = pos + lctx->Ndim * ND_id(n);
+	for (i = 0; i < lctx->Ndim; i++) {
 	    npos[i] = ND_pos(n)[i];
 	}
     }
@@ -714,13 +718,13 @@ static void fdpAdjust(graph_t *g, adjust_data *am) {
 	A = SparseMatrix_remove_diagonal(A);
     }
 
-    remove_overlap(Ndim, A, pos, sizes, am->value, am->scaling, 
+    remove_overlap(lctx->Ndim, A, pos, sizes, am->value, am->scaling, 
                    ELSCHEME_NONE, 0, NULL, NULL,
                    mapBool(agget(g, "overlap_shrink"), true) ? TRUE : FALSE);
 
     for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
-	double *npos = pos + Ndim * ND_id(n);
-	for (i = 0; i < Ndim; i++) {
+	double *npos = pos + lctx->Ndim * ND_id(n);
+	for (i = 0; i < lctx->Ndim; i++) {
 	    ND_pos(n)[i] = npos[i];
 	}
     }
@@ -10,6 +10,7 @@
 
 #include <cgraph/alloc.h>
 #include <cgraph/stack.h>
+#include <common/random.h>
 #include <neatogen/kkutils.h>
 #include <neatogen/closest.h>
 #include <stdbool.h>
@@ -74,7 +75,7 @@ typedef struct {
 #define parent(i) ((i)/2)
 #define insideHeap(h,i) ((i)<h->heapSize)
 #define greaterPriority(h,i,j) \
-  (LT(h->data[i],h->data[j]) || ((EQ(h->data[i],h->data[j])) && (rand()%2)))
+  (LT(h->data[i],h->data[j]) || ((EQ(h->data[i],h->data[j])) && (gv_rand()%2)))
 
 #define exchange(h,i,j) {Pair temp; \
         temp=h->data[i]; \
@@ -8,11 +8,12 @@
  * Contributors: Details at https://graphviz.org
  *************************************************************************/
 
+#include <cgraph/tls.h>
 #include <neatogen/digcola.h>
 #ifdef DIGCOLA
 #include <neatogen/kkutils.h>
 
-static int *given_levels = NULL;
+static TLS int *given_levels = NULL;
 /*
  * This function partitions the graph nodes into levels
  * according to the minimizer of the hierarchy energy.
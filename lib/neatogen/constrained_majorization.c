@@ -38,6 +38,7 @@ int stress_majorization_with_hierarchy(vtx_data * graph,	/* Input graph in spars
 				       int maxi,	/* max iterations */
 				       double levels_gap)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     int iterations = 0;		/* Output: number of iteration of the process */
 
 	/*************************************************
@@ -148,7 +149,7 @@ int stress_majorization_with_hierarchy(vtx_data * graph,	/* Input graph in spars
 	    }
 	}
 	if (dim == 2) {
-	    if (IMDS_given_dim(graph, n, y, x, Epsilon)) {
+	    if (IMDS_given_dim(graph, n, y, x, lctx->Epsilon)) {
 		iterations = -1;
 		goto finish;
 	    }
@@ -395,7 +396,7 @@ int stress_majorization_with_hierarchy(vtx_data * graph,	/* Input graph in spars
 	/* check for convergence */
 	converged =
 	    fabs(new_stress - old_stress) / fabs(old_stress + 1e-10) <
-	    Epsilon;
+	    lctx->Epsilon;
 	converged |= iterations > 1 && new_stress > old_stress;
 	/* in first iteration we allowed stress increase, which 
 	 * might result ny imposing constraints
@@ -61,6 +61,7 @@ int stress_majorization_cola(vtx_data * graph,	/* Input graph in sparse represen
 			     int maxi,	/* max iterations */
 			     ipsep_options * opt)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     int iterations = 0;		/* Output: number of iteration of the process */
 
 	/*************************************************
@@ -358,7 +359,7 @@ int stress_majorization_cola(vtx_data * graph,	/* Input graph in sparse represen
 	}
 	converged = new_stress < old_stress
 	    && fabs(new_stress - old_stress) / fabs(old_stress + 1e-10) <
-	    Epsilon;
+	    lctx->Epsilon;
 	/*converged = converged || (iterations>1 && new_stress>old_stress); */
 	/* in first iteration we allowed stress increase, which 
 	 * might result ny imposing constraints
@@ -16,6 +16,7 @@
 #include <string.h>
 #include <math.h>
 #include <cgraph/cgraph.h>     /* for agerr() and friends */
+#include <cgraph/tls.h>
 #include <neatogen/delaunay.h>
 #include <common/memory.h>
 
@@ -317,7 +318,7 @@ static gint addEdge(void *edge, void *state) {
 
 // when moving to C11, qsort_s should be used instead of having a global
 // variable
-static double* _vals;
+static TLS double* _vals;
 typedef int (*qsort_cmpf) (const void *, const void *);
 
 static int 
@@ -15,10 +15,10 @@
 #include <math.h>
 
 
-double pxmin, pxmax, pymin, pymax;	/* clipping window */
+TLS double pxmin, pxmax, pymin, pymax;	/* clipping window */
 
-static int nedges;
-static Freelist efl;
+static TLS int nedges;
+static TLS Freelist efl;
 
 void edgeinit()
 {
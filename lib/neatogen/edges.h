@@ -26,7 +26,7 @@ extern "C" {
 #define le 0
 #define re 1
 
-    extern double pxmin, pxmax, pymin, pymax;	/* clipping window */
+    extern TLS double pxmin, pxmax, pymin, pymax;	/* clipping window */
     extern void edgeinit(void);
     extern void endpoint(Edge *, int, Site *);
     extern void clip_line(Edge * e);
@@ -17,6 +17,7 @@
 ************************************************/
 
 
+#include <common/random.h>
 #include <neatogen/dijkstra.h>
 #include <neatogen/bfs.h>
 #include <neatogen/kkutils.h>
@@ -54,7 +55,7 @@ void embed_graph(vtx_data * graph, int n, int dim, DistType *** Coords,
     }
 
     /* select the first pivot */
-    node = rand() % n;
+    node = gv_rand() % n;
 
     if (reweight_graph) {
 	dijkstra(node, graph, n, coords[0]);
@@ -14,12 +14,12 @@
 
 Point origin = { 0, 0 };
 
-double xmin, xmax, ymin, ymax;	/* min and max x and y values of sites */
-double deltax,			/* xmax - xmin */
+TLS double xmin, xmax, ymin, ymax;	/* min and max x and y values of sites */
+TLS double deltax,			/* xmax - xmin */
  deltay;			/* ymax - ymin */
 
-size_t nsites;
-int sqrt_nsites;
+TLS size_t nsites;
+TLS int sqrt_nsites;
 
 void geominit()
 {
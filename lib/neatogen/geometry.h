@@ -10,6 +10,7 @@
 
 #pragma once
 
+#include <cgraph/tls.h>
 #include <stddef.h>
 
 #ifdef __cplusplus
@@ -26,11 +27,11 @@ extern "C" {
 
     extern Point origin;
 
-    extern double xmin, xmax, ymin, ymax;	/* extreme x,y values of sites */
-    extern double deltax, deltay;	/* xmax - xmin, ymax - ymin */
+    extern TLS double xmin, xmax, ymin, ymax;	/* extreme x,y values of sites */
+    extern TLS double deltax, deltay;	/* xmax - xmin, ymax - ymin */
 
-    extern size_t nsites; // Number of sites
-    extern int sqrt_nsites;
+    extern TLS size_t nsites; // Number of sites
+    extern TLS int sqrt_nsites;
 
     extern void geominit(void);
     extern double dist_2(Point *, Point *);	/* Distance squared between two points */
@@ -9,6 +9,7 @@
  *************************************************************************/
 
 #include <cgraph/prisize_t.h>
+#include <cgraph/tls.h>
 #include <common/render.h>
 #include <stdbool.h>
 #include <stdio.h>
@@ -18,10 +19,10 @@
 #include <neatogen/heap.h>
 
 
-static Halfedge *PQhash;
-static int PQhashsize;
-static int PQcount;
-static int PQmin;
+static TLS Halfedge *PQhash;
+static TLS int PQhashsize;
+static TLS int PQcount;
+static TLS int PQmin;
 
 static int PQbucket(Halfedge * he)
 {
@@ -15,12 +15,12 @@
 
 #define DELETED -2
 
-Halfedge *ELleftend, *ELrightend;
+TLS Halfedge *ELleftend, *ELrightend;
 
-static Freelist hfl;
-static int ELhashsize;
-static Halfedge **ELhash;
-static int ntry, totalsearch;
+static TLS Freelist hfl;
+static TLS int ELhashsize;
+static TLS Halfedge **ELhash;
+static TLS int ntry, totalsearch;
 
 void ELcleanup()
 {
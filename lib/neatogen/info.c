@@ -14,8 +14,8 @@
 #include <neatogen/info.h>
 
 
-Info_t *nodeInfo;		/* Array of node info */
-static Freelist pfl;
+TLS Info_t *nodeInfo;		/* Array of node info */
+static TLS Freelist pfl;
 
 void infoinit()
 {
@@ -31,7 +31,7 @@ extern "C" {
 	/* voronoi polygon */
     } Info_t;
 
-    extern Info_t *nodeInfo;	/* Array of node info */
+    extern TLS Info_t *nodeInfo;	/* Array of node info */
 
     extern void infoinit(void);
     /* Insert vertex into sorted list */
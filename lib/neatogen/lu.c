@@ -42,12 +42,13 @@
  *	written 3/2/79, revised and enhanced 8/9/83.
  */
 
+#include <cgraph/tls.h>
 #include <math.h>
 #include <neatogen/neato.h>
 
-static double *scales;
-static double **lu;
-static int *ps;
+static TLS double *scales;
+static TLS double **lu;
+static TLS int *ps;
 
 /* lu_decompose() decomposes the coefficient matrix A into upper and lower
  * triangular matrices, the composite being the LU matrix.
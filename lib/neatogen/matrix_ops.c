@@ -11,6 +11,7 @@
 
 #include <neatogen/matrix_ops.h>
 #include <common/memory.h>
+#include <common/random.h>
 #include <stdbool.h>
 #include <stdlib.h>
 #include <stdio.h>
@@ -47,7 +48,7 @@ bool power_iteration(double **square_mat, int n, int neigs, double **eigs,
       choose:
 	if (initialize)
 	    for (j = 0; j < n; j++)
-		curr_vector[j] = rand() % 100;
+		curr_vector[j] = gv_rand() % 100;
 	/* orthogonalize against higher eigenvectors */
 	for (j = 0; j < i; j++) {
 	    alpha = -dot(eigs[j], 0, n - 1, curr_vector);
@@ -94,7 +95,7 @@ bool power_iteration(double **square_mat, int n, int neigs, double **eigs,
 	curr_vector = eigs[i];
 	/* guess the i-th eigen vector */
 	for (j = 0; j < n; j++)
-	    curr_vector[j] = rand() % 100;
+	    curr_vector[j] = gv_rand() % 100;
 	/* orthogonalize against higher eigenvectors */
 	for (j = 0; j < i; j++) {
 	    alpha = -dot(eigs[j], 0, n - 1, curr_vector);
@@ -336,7 +337,7 @@ void init_vec_orth1(int n, double *vec)
     int i;
 
     for (i = 0; i < n; i++)
-	vec[i] = rand() % RANGE;
+	vec[i] = gv_rand() % RANGE;
 
     orthog1(n, vec);
 }
@@ -755,6 +755,7 @@ tweakPath (Ppoly_t poly, int s, int t, Ppolyline_t pl)
  */
 static int genroute(tripoly_t * trip, int s, int t, edge_t * e, int doPolyline)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     pointf eps[2];
     Pvector_t evs[2];
     pointf **cpts = NULL;		/* lists of control points */
@@ -786,7 +787,7 @@ static int genroute(tripoly_t * trip, int s, int t, edge_t * e, int doPolyline)
     evs[0].x = evs[0].y = 0;
     evs[1].x = evs[1].y = 0;
 
-    if (mult == 1 || Concentrate) {
+    if (mult == 1 || lctx->Concentrate) {
 	poly = trip->poly;
 	medges = gv_calloc(poly.pn, sizeof(Pedge_t));
 	for (j = 0; j < poly.pn; j++) {
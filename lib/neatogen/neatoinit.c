@@ -32,17 +32,16 @@
 #endif
 #include <neatogen/kkutils.h>
 #include <common/pointset.h>
+#include <common/random.h>
 #include <neatogen/sgd.h>
 #include <cgraph/bitarray.h>
+#include <cgraph/exit.h>
 #include <cgraph/strcasecmp.h>
+#include <cgraph/tls.h>
 #include <stdbool.h>
 
-#ifndef HAVE_SRAND48
-#define srand48 srand
-#endif
-
-static attrsym_t *N_pos;
-static int Pack;		/* If >= 0, layout components separately and pack together
+static TLS attrsym_t *N_pos;
+static TLS int Pack;		/* If >= 0, layout components separately and pack together
 				 * The value of Pack gives margins around graphs.
 				 */
 static char *cc_pfx = "_neato_cc";
@@ -57,13 +56,15 @@ void neato_init_node(node_t * n)
 
 static void neato_init_edge(edge_t * e)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     agbindrec(e, "Agedgeinfo_t", sizeof(Agedgeinfo_t), true);	//node custom data
     common_init_edge(e);
-    ED_factor(e) = late_double(e, E_weight, 1.0, 1.0);
+    ED_factor(e) = late_double(e, lctx->E_weight, 1.0, 1.0);
 }
 
 int user_pos(attrsym_t * posptr, attrsym_t * pinptr, node_t * np, int nG)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     double *pvec;
     char *p, c;
     double z;
@@ -74,14 +75,14 @@ int user_pos(attrsym_t * posptr, attrsym_t * pinptr, node_t * np, int nG)
     p = agxget(np, posptr);
     if (p[0]) {
 	c = '\0';
-	if (Ndim >= 3 && sscanf(p, "%lf,%lf,%lf%c", pvec, pvec+1, pvec+2, &c) >= 3){
+	if (lctx->Ndim >= 3 && sscanf(p, "%lf,%lf,%lf%c", pvec, pvec+1, pvec+2, &c) >= 3){
 	    ND_pinned(np) = P_SET;
-	    if (PSinputscale > 0.0) {
+	    if (lctx->PSinputscale > 0.0) {
 		int i;
-		for (i = 0; i < Ndim; i++)
-		    pvec[i] = pvec[i] / PSinputscale;
+		for (i = 0; i < lctx->Ndim; i++)
+		    pvec[i] = pvec[i] / lctx->PSinputscale;
 	    }
-	    if (Ndim > 3)
+	    if (lctx->Ndim > 3)
 		jitter_d(np, nG, 3);
 	    if (c == '!' || (pinptr && mapbool(agxget(np, pinptr))))
 		ND_pinned(np) = P_PIN;
@@ -89,15 +90,15 @@ int user_pos(attrsym_t * posptr, attrsym_t * pinptr, node_t * np, int nG)
 	}
 	else if (sscanf(p, "%lf,%lf%c", pvec, pvec + 1, &c) >= 2) {
 	    ND_pinned(np) = P_SET;
-	    if (PSinputscale > 0.0) {
+	    if (lctx->PSinputscale > 0.0) {
 		int i;
-		for (i = 0; i < Ndim; i++)
-		    pvec[i] /= PSinputscale;
+		for (i = 0; i < lctx->Ndim; i++)
+		    pvec[i] /= lctx->PSinputscale;
 	    }
-	    if (Ndim > 2) {
-		if (N_z && (p = agxget(np, N_z)) && sscanf(p,"%lf",&z) == 1) {
-		    if (PSinputscale > 0.0) {
-			pvec[2] = z / PSinputscale;
+	    if (lctx->Ndim > 2) {
+		if (lctx->N_z && (p = agxget(np, lctx->N_z)) && sscanf(p,"%lf",&z) == 1) {
+		    if (lctx->PSinputscale > 0.0) {
+			pvec[2] = z / lctx->PSinputscale;
 		    }
 		    else
 			pvec[2] = z;
@@ -138,7 +139,8 @@ static void neato_init_node_edge(graph_t * g)
 
 static void neato_cleanup_graph(graph_t * g)
 {
-    if (Nop || Pack < 0) {
+    layout_context_t *const lctx = gvLayoutContext();
+    if (lctx->Nop || Pack < 0) {
 	free_scan_graph(g);
 	free(GD_clust(g));
     }
@@ -375,6 +377,7 @@ typedef enum { NoEdges, SomeEdges, AllEdges } pos_edge;
  */
 static pos_edge nop_init_edges(Agraph_t * g)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     node_t *n;
     edge_t *e;
     int nedges = 0;
@@ -384,7 +387,7 @@ static pos_edge nop_init_edges(Agraph_t * g)
 	return AllEdges;
 
     E_pos = agfindedgeattr(g, "pos");
-    if (!E_pos || Nop < 2)
+    if (!E_pos || lctx->Nop < 2)
 	return NoEdges;
 
     for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
@@ -530,6 +533,7 @@ nop_init_graphs(Agraph_t * g, attrsym_t * G_lp, attrsym_t * G_bb)
  */
 int init_nop(Agraph_t * g, int adjust)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     int i;
     node_t *np;
     pos_edge posEdges;		/* How many edges have spline info */
@@ -563,7 +567,7 @@ int init_nop(Agraph_t * g, int adjust)
     else
 	haveBackground = 0;
 
-    if (adjust && Nop == 1 && !haveBackground)
+    if (adjust && lctx->Nop == 1 && !haveBackground)
 	didAdjust = adjustNodes(g);
 
     if (didAdjust) {
@@ -584,7 +588,7 @@ int init_nop(Agraph_t * g, int adjust)
 
     if (!adjust) {
 	node_t *n;
-	State = GVSPLINES;
+	lctx->State = GVSPLINES;
 	for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
 	    ND_coord(n).x = POINTS_PER_INCH * ND_pos(n)[0];
 	    ND_coord(n).y = POINTS_PER_INCH * ND_pos(n)[1];
@@ -603,7 +607,7 @@ int init_nop(Agraph_t * g, int adjust)
 	if (posEdges != AllEdges)
 	    spline_edges0(g, false);   /* add edges */
 	else
-	    State = GVSPLINES;
+	    lctx->State = GVSPLINES;
     }
 
     return haveBackground;
@@ -611,13 +615,14 @@ int init_nop(Agraph_t * g, int adjust)
 
 static void neato_init_graph (Agraph_t * g)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     int outdim;
 
     setEdgeType (g, EDGETYPE_LINE);
     outdim = late_int(g, agfindgraphattr(g, "dimen"), 2, 2);
     GD_ndim(agroot(g)) = late_int(g, agfindgraphattr(g, "dim"), outdim, 2);
-    Ndim = GD_ndim(g->root) = MIN(GD_ndim(g->root), MAXDIM);
-    GD_odim(g->root) = MIN(outdim, Ndim);
+    lctx->Ndim = GD_ndim(g->root) = MIN(GD_ndim(g->root), MAXDIM);
+    GD_odim(g->root) = MIN(outdim, lctx->Ndim);
     neato_init_node_edge(g);
 }
 
@@ -682,12 +687,11 @@ static int neatoMode(graph_t * g)
 }
 
 /* checkEdge:
- *
+ * Look up the edge between nodes i and j, in either direction, returning
+ * its neighbor index if seen before or recording idx for it if not.
  */
-static int checkEdge(PointMap * pm, edge_t * ep, int idx)
+static int checkEdge(PointMap * pm, int i, int j, int idx)
 {
-    int i = ND_id(agtail(ep));
-    int j = ND_id(aghead(ep));
     int tmp;
 
     if (i > j) {
@@ -770,9 +774,12 @@ acyclic (vtx_data* graph, int nv, int mode, node_t* nodes[])
  * of the first one encountered is used. Finally, a pass is made to guarantee
  * the graph is acyclic.
  *
+ * The edges are read from the graph's adjacency snapshot, visiting each
+ * node's out edges and then its in edges as agfstedge/agnxtedge would.
  */
 static vtx_data *makeGraphData(graph_t * g, int nv, int *nedges, int mode, int model, node_t*** nodedata)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     vtx_data *graph;
     node_t** nodes;
     int ne = agnedges(g);	/* upper bound */
@@ -780,6 +787,7 @@ static vtx_data *makeGraphData(graph_t * g, int nv, int *nedges, int mode, int m
     float *ewgts = NULL;
     node_t *np;
     edge_t *ep;
+    const Agcsr_t *csr;
     float *eweights = NULL;
 #ifdef DIGCOLA
     float *edists = NULL;
@@ -788,7 +796,7 @@ static vtx_data *makeGraphData(graph_t * g, int nv, int *nedges, int mode, int m
     int haveWt;
     int haveDir;
     PointMap *ps = newPM();
-    int i, i_nedges, idx;
+    int i, i_nedges, idx, k, nout, nin;
 
     /* lengths and weights unused in reweight model */
     if (model == MODEL_SUBSET) {
@@ -796,7 +804,7 @@ static vtx_data *makeGraphData(graph_t * g, int nv, int *nedges, int mode, int m
 	haveWt = FALSE;
     } else {
 	haveLen = agattr(g, AGEDGE, "len", 0) ;
-	haveWt = E_weight != 0;
+	haveWt = lctx->E_weight != 0;
     }
     if (mode == MODE_HIER || mode == MODE_IPSEP)
 	haveDir = TRUE;
@@ -815,10 +823,14 @@ static vtx_data *makeGraphData(graph_t * g, int nv, int *nedges, int mode, int m
 	edists = N_GNEW(2*ne+nv,float);
 #endif
 
-    i = 0;
+    if (!(csr = agcsr(g)))
+	graphviz_exit(EXIT_FAILURE);
+    assert(csr->nnodes == nv);
+
     ne = 0;
-    for (np = agfstnode(g); np; np = agnxtnode(g, np)) {
+    for (i = 0; i < nv; i++) {
 	int j = 1;		/* index of neighbors */
+	np = csr->node[i];
 	clearPM(ps);
 	assert(ND_id(np) == i);
 	nodes[i] = np;
@@ -840,10 +852,20 @@ static vtx_data *makeGraphData(graph_t * g, int nv, int *nedges, int mode, int m
 #endif
 	i_nedges = 1;		/* one for the self */
 
-	for (ep = agfstedge(g, np); ep; ep = agnxtedge(g, ep, np)) {
-	    if (aghead(ep) == agtail(ep))
+	nout = csr->out[i + 1] - csr->out[i];
+	nin = csr->in[i + 1] - csr->in[i];
+	for (k = 0; k < nout + nin; k++) {
+	    int vi;		/* index of the other end */
+	    if (k < nout) {
+		ep = csr->outedge[csr->out[i] + k];
+		vi = csr->head[csr->out[i] + k];
+	    } else {
+		ep = csr->inedge[csr->in[i] + k - nout];
+		vi = csr->tail[csr->in[i] + k - nout];
+	    }
+	    if (vi == i)
 		continue;	/* ignore loops */
-	    idx = checkEdge(ps, ep, j);
+	    idx = checkEdge(ps, i, vi, j);
 	    if (idx != j) {	/* seen before */
 		if (haveWt)
 		    graph[i].eweights[idx] += ED_factor(ep);
@@ -852,11 +874,10 @@ static vtx_data *makeGraphData(graph_t * g, int nv, int *nedges, int mode, int m
 		    graph[i].ewgts[idx] = MAX(ED_dist(ep), curlen);
 		}
 	    } else {
-		node_t *vp = agtail(ep) == np ? aghead(ep) : agtail(ep);
 		ne++;
 		j++;
 
-		*edges++ = ND_id(vp);
+		*edges++ = vi;
 		if (haveWt)
 		    *eweights++ = ED_factor(ep);
 		if (haveLen)
@@ -879,8 +900,8 @@ static vtx_data *makeGraphData(graph_t * g, int nv, int *nedges, int mode, int m
 
 	graph[i].nedges = i_nedges;
 	graph[i].edges[0] = i;
-	i++;
     }
+    agcsrfree(g);
 #ifdef DIGCOLA
     if (haveDir) {
     /* Make graph acyclic */
@@ -924,6 +945,7 @@ static vtx_data *makeGraphData(graph_t * g, int nv, int *nedges, int mode, int m
 
 static void initRegular(graph_t * G, int nG)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     double a, da;
     node_t *np;
 
@@ -934,7 +956,7 @@ static void initRegular(graph_t * G, int nG)
 	ND_pos(np)[1] = nG * Spring_coeff * sin(a);
 	ND_pinned(np) = P_SET;
 	a = a + da;
-	if (Ndim > 2)
+	if (lctx->Ndim > 2)
 	    jitter3d(np, nG);
     }
 }
@@ -1032,7 +1054,7 @@ int checkStart(graph_t * G, int nG, int dflt)
 	agerr(AGWARN, "node positions are ignored unless start=random\n");
     }
     if (init == INIT_REGULAR) initRegular(G, nG);
-    srand48(seed);
+    gv_srand48(seed);
     return init;
 }
 
@@ -1124,6 +1146,7 @@ void dumpOpts (ipsep_options* opp, int nv)
 static void
 majorization(graph_t *mg, graph_t * g, int nv, int mode, int model, int dim, adjust_data* am)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     double **coords;
     int ne;
     int rv = 0;
@@ -1143,12 +1166,12 @@ majorization(graph_t *mg, graph_t * g, int nv, int mode, int model, int dim, adj
 
     coords = N_GNEW(dim, double *);
     coords[0] = N_GNEW(nv * dim, double);
-    for (int i = 1; i < Ndim; i++) {
+    for (int i = 1; i < lctx->Ndim; i++) {
 	coords[i] = coords[0] + i * nv;
     }
     if (Verbose) {
 	fprintf(stderr, "model %d smart_init %d stresswt %d iterations %d tol %f\n",
-		model, init == INIT_SELF, opts & opt_exp_flag, MaxIter, Epsilon);
+		model, init == INIT_SELF, opts & opt_exp_flag, lctx->MaxIter, lctx->Epsilon);
 	fprintf(stderr, "convert graph: ");
 	start_timer();
         fprintf(stderr, "majorization\n");
@@ -1163,8 +1186,8 @@ majorization(graph_t *mg, graph_t * g, int nv, int mode, int model, int dim, adj
     if (mode != MODE_MAJOR) {
         double lgap = late_double(g, agfindgraphattr(g, "levelsgap"), 0.0, -MAXDOUBLE);
         if (mode == MODE_HIER) {
-            rv = stress_majorization_with_hierarchy(gp, nv, coords, nodes, Ndim,
-                       opts, model, MaxIter, lgap);
+            rv = stress_majorization_with_hierarchy(gp, nv, coords, nodes, lctx->Ndim,
+                       opts, model, lctx->MaxIter, lgap);
         }
 #ifdef IPSEPCOLA
 	else {
@@ -1215,7 +1238,7 @@ majorization(graph_t *mg, graph_t * g, int nv, int mode, int model, int dim, adj
             }
 
 #ifdef DEBUG_COLA
-	    fprintf (stderr, "nv %d ne %d Ndim %d model %d MaxIter %d\n", nv, ne, Ndim, model, MaxIter);
+	    fprintf (stderr, "nv %d ne %d Ndim %d model %d MaxIter %d\n", nv, ne, lctx->Ndim, model, lctx->MaxIter);
 	    fprintf (stderr, "Nodes:\n");
 	    for (int i = 0; i < nv; i++) {
 		fprintf (stderr, "  %s (%f,%f)\n", nodes[i]->name, coords[0][i],  coords[1][i]);
@@ -1225,7 +1248,7 @@ majorization(graph_t *mg, graph_t * g, int nv, int mode, int model, int dim, adj
 	    fprintf (stderr, "\n");
 	    dumpOpts (&opt, nv);
 #endif
-            rv = stress_majorization_cola(gp, nv, coords, nodes, Ndim, model, MaxIter, &opt);
+            rv = stress_majorization_cola(gp, nv, coords, nodes, lctx->Ndim, model, lctx->MaxIter, &opt);
 	    freeClusterData(cs);
 	    free (nsize);
         }
@@ -1233,14 +1256,14 @@ majorization(graph_t *mg, graph_t * g, int nv, int mode, int model, int dim, adj
     }
     else
 #endif
-	rv = stress_majorization_kD_mkernel(gp, nv, coords, nodes, Ndim, opts, model, MaxIter);
+	rv = stress_majorization_kD_mkernel(gp, nv, coords, nodes, lctx->Ndim, opts, model, lctx->MaxIter);
 
     if (rv < 0) {
 	agerr(AGPREV, "layout aborted\n");
     }
     else for (v = agfstnode(g); v; v = agnxtnode(g, v)) { /* store positions back in nodes */
 	int idx = ND_id(v);
-	for (int i = 0; i < Ndim; i++) {
+	for (int i = 0; i < lctx->Ndim; i++) {
 	    ND_pos(v)[i] = coords[i][idx];
 	}
     }
@@ -1294,6 +1317,7 @@ static void mds_model(graph_t * g)
  */
 static void kkNeato(Agraph_t * g, int nG, int model)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     if (model == MODEL_SUBSET) {
 	subset_model(g, nG);
     } else if (model == MODEL_CIRCUIT) {
@@ -1317,7 +1341,7 @@ static void kkNeato(Agraph_t * g, int nG, int model)
     diffeq_model(g, nG);
     if (Verbose) {
 	fprintf(stderr, "Solving model %d iterations %d tol %f\n",
-		model, MaxIter, Epsilon);
+		model, lctx->MaxIter, lctx->Epsilon);
 	start_timer();
     }
     solve_model(g, nG);
@@ -1330,27 +1354,28 @@ static void
 neatoLayout(Agraph_t * mg, Agraph_t * g, int layoutMode, int layoutModel,
   adjust_data* am)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     int nG;
     char *str;
 
     if ((str = agget(g, "maxiter")))
-	MaxIter = atoi(str);
+	lctx->MaxIter = atoi(str);
     else if (layoutMode == MODE_MAJOR)
-	MaxIter = DFLT_ITERATIONS;
+	lctx->MaxIter = DFLT_ITERATIONS;
     else if (layoutMode == MODE_SGD)
-	MaxIter = 30;
+	lctx->MaxIter = 30;
     else
-	MaxIter = 100 * agnnodes(g);
+	lctx->MaxIter = 100 * agnnodes(g);
 
     nG = scan_graph_mode(g, layoutMode);
-    if (nG < 2 || MaxIter < 0)
+    if (nG < 2 || lctx->MaxIter < 0)
 	return;
     if (layoutMode == MODE_KK)
 	kkNeato(g, nG, layoutModel);
     else if (layoutMode == MODE_SGD)
 	sgd(g, layoutModel);
     else
-	majorization(mg, g, nG, layoutMode, layoutModel, Ndim, am);
+	majorization(mg, g, nG, layoutMode, layoutModel, lctx->Ndim, am);
 }
 
 /* addZ;
@@ -1359,13 +1384,14 @@ neatoLayout(Agraph_t * mg, Agraph_t * g, int layoutMode, int layoutModel,
  */
 static void addZ (Agraph_t* g)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     node_t* n;
     char    buf[BUFSIZ];
 
-    if (Ndim >= 3 && N_z) {
+    if (lctx->Ndim >= 3 && lctx->N_z) {
 	for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
 	    snprintf(buf, sizeof(buf), "%lf", POINTS_PER_INCH * ND_pos(n)[2]);
-	    agxset(n, N_z, buf);
+	    agxset(n, lctx->N_z, buf);
 	}
     }
 }
@@ -1399,16 +1425,17 @@ static void doEdges(Agraph_t* g)
  */
 void neato_layout(Agraph_t * g)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     int layoutMode;
     int model;
     pack_mode mode;
     pack_info pinfo;
     adjust_data am;
-    double save_scale = PSinputscale;
+    double save_scale = lctx->PSinputscale;
 
-    if (Nop) {
+    if (lctx->Nop) {
 	int ret;
-	PSinputscale = POINTS_PER_INCH;
+	lctx->PSinputscale = POINTS_PER_INCH;
 	neato_init_graph(g);
 	addZ (g);
 	ret = init_nop(g, 1);
@@ -1419,7 +1446,7 @@ void neato_layout(Agraph_t * g)
 	else gv_postprocess(g, 0);
     } else {
 	bool noTranslate = mapBool(agget(g, "notranslate"), false);
-	PSinputscale = get_inputscale (g);
+	lctx->PSinputscale = get_inputscale (g);
 	neato_init_graph(g);
 	layoutMode = neatoMode(g);
 	graphAdjustMode (g, &am, 0);
@@ -1496,7 +1523,7 @@ void neato_layout(Agraph_t * g)
 	}
 	gv_postprocess(g, !noTranslate);
     }
-    PSinputscale = save_scale;
+    lctx->PSinputscale = save_scale;
 }
 
 /**
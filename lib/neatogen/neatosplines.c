@@ -12,6 +12,7 @@
 #include "config.h"
 #include <cgraph/alloc.h>
 #include <cgraph/unreachable.h>
+#include <common/random.h>
 #include <math.h>
 #include <neatogen/neato.h>
 #include <neatogen/adjust.h>
@@ -235,9 +236,10 @@ static edge_t *equivEdge(Dt_t * map, edge_t * e)
  */
 void makeSelfArcs(edge_t * e, int stepx)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     int cnt = ED_count(e);
 
-    if (cnt == 1 || Concentrate) {
+    if (cnt == 1 || lctx->Concentrate) {
 	edge_t *edges1[1];
 	edges1[0] = e;
 	makeSelfEdge(edges1, 0, 1, stepx, stepx, &sinfo);
@@ -331,7 +333,7 @@ Ppoly_t *makeObstacle(node_t * n, expand_t* pmargin, bool isOrtho)
 	} else {		/* ellipse */
 	    isPoly = false;
 	    sides = 8;
-	    adj = drand48() * .01;
+	    adj = gv_drand48() * .01;
 	}
 	obs->pn = sides;
 	obs->ps = gv_calloc(sides, sizeof(Ppoint_t));
@@ -538,6 +540,7 @@ void makeSpline(edge_t *e, Ppoly_t **obs, int npoly, bool chkPts) {
  */
 static int _spline_edges(graph_t * g, expand_t* pmargin, int edgetype)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     node_t *n;
     edge_t *e;
     edge_t *e0;
@@ -545,7 +548,7 @@ static int _spline_edges(graph_t * g, expand_t* pmargin, int edgetype)
     Ppoly_t *obp;
     int cnt, i = 0, npoly;
     vconfig_t *vconfig = 0;
-    int useEdges = Nop > 1;
+    int useEdges = lctx->Nop > 1;
     int legal = 0;
 
 #ifdef HAVE_GTS
@@ -633,7 +636,7 @@ static int _spline_edges(graph_t * g, expand_t* pmargin, int edgetype)
 		 */
 #endif
 		cnt = ED_count(e);
-		if (Concentrate) cnt = 1; /* only do representative */
+		if (lctx->Concentrate) cnt = 1; /* only do representative */
 		e0 = e;
 		for (i = 0; i < cnt; i++) {
 		    if (edgetype == EDGETYPE_SPLINE)
@@ -682,6 +685,7 @@ int
 splineEdges(graph_t * g, int (*edgefn) (graph_t *, expand_t*, int),
 	    int edgetype)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     node_t *n;
     edge_t *e;
     expand_t margin;
@@ -699,7 +703,7 @@ splineEdges(graph_t * g, int (*edgefn) (graph_t *, expand_t*, int),
     map = dtopen(&edgeItemDisc, Dtoset);
     for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
 	for (e = agfstout(g, n); e; e = agnxtout(g, e)) {
-	    if (Nop > 1 && ED_spl(e)) {
+	    if (lctx->Nop > 1 && ED_spl(e)) {
 		/* If Nop > 1 (use given edges) and e has a spline, it
  		 * should have its own equivalence class.
 		 */
@@ -719,7 +723,7 @@ splineEdges(graph_t * g, int (*edgefn) (graph_t *, expand_t*, int),
     if (edgefn(g, &margin, edgetype))
 	return 1;
 
-    State = GVSPLINES;
+    lctx->State = GVSPLINES;
     return 0;
 }
 
@@ -982,6 +986,7 @@ void neato_translate(Agraph_t * g)
  */
 static bool _neato_set_aspect(graph_t * g)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     double xf, yf, actual, desired;
     node_t *n;
     bool translated = false;
@@ -1042,7 +1047,7 @@ static bool _neato_set_aspect(graph_t * g)
 	    yf = t;
 	}
 
-	if (Nop > 1) {
+	if (lctx->Nop > 1) {
 	    edge_t *e;
 	    for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
 		for (e = agfstout(g, n); e; e = agnxtout(g, e))
@@ -24,10 +24,10 @@
 #define CIRCLE 2
 #define ISCIRCLE(p) ((p)->kind & CIRCLE)
 
-static int maxcnt = 0;
-static Point *tp1 = NULL;
-static Point *tp2 = NULL;
-static Point *tp3 = NULL;
+static TLS int maxcnt = 0;
+static TLS Point *tp1 = NULL;
+static TLS Point *tp2 = NULL;
+static TLS Point *tp3 = NULL;
 
 void polyFree()
 {
@@ -1,5 +1,7 @@
 #include <assert.h>
 #include <cgraph/bitarray.h>
+#include <cgraph/exit.h>
+#include <cgraph/tls.h>
 #include <limits.h>
 #include <neatogen/neato.h>
 #include <neatogen/sgd.h>
@@ -22,7 +24,7 @@ static float calculate_stress(float *pos, term_sgd *terms, int n_terms) {
     return stress;
 }
 // it is much faster to shuffle term rather than pointers to term, even though the swap is more expensive
-static rk_state rstate;
+static TLS rk_state rstate;
 static void fisheryates_shuffle(term_sgd *terms, int n_terms) {
     int i;
     for (i=n_terms-1; i>=1; i--) {
@@ -38,16 +40,15 @@ static void fisheryates_shuffle(term_sgd *terms, int n_terms) {
 
 // graph_sgd data structure exists only to make dijkstras faster
 static graph_sgd * extract_adjacency(graph_t *G, int model) {
-    node_t *np;
-    edge_t *ep;
-    size_t n_nodes = 0, n_edges = 0;
-    for (np = agfstnode(G); np; np = agnxtnode(G,np)) {
-        assert(ND_id(np) == n_nodes);
-        n_nodes++;
-        for (ep = agfstedge(G, np); ep; ep = agnxtedge(G, ep, np)) {
-            if (agtail(ep) != aghead(ep)) { // ignore self-loops and double edges
-                n_edges++;
-            }
+    const Agcsr_t *csr = agcsr(G);
+    if (csr == NULL) {
+        graphviz_exit(EXIT_FAILURE);
+    }
+    size_t n_nodes = (size_t)csr->nnodes, n_edges = 0;
+    // every edge other than a self-loop is seen from both of its ends
+    for (int x = 0; x < csr->nedges; x++) {
+        if (agtail(csr->outedge[x]) != aghead(csr->outedge[x])) {
+            n_edges += 2;
         }
     }
     graph_sgd *graph = N_NEW(1, graph_sgd);
@@ -60,18 +61,29 @@ static graph_sgd * extract_adjacency(graph_t *G, int model) {
     assert(n_edges <= INT_MAX);
     graph->sources[graph->n] = n_edges; // to make looping nice
 
+    // out edges then in edges of each node, as agfstedge/agnxtedge visit them
     n_nodes = 0, n_edges = 0;
-    for (np = agfstnode(G); np; np = agnxtnode(G,np)) {
+    for (int i = 0; i < csr->nnodes; i++) {
+        node_t *np = csr->node[i];
+        assert(ND_id(np) == i);
         assert(n_edges <= INT_MAX);
         graph->sources[n_nodes] = n_edges;
         bitarray_set(&graph->pinneds, n_nodes, isFixed(np));
-        for (ep = agfstedge(G, np); ep; ep = agnxtedge(G, ep, np)) {
-            if (agtail(ep) == aghead(ep)) { // ignore self-loops and double edges
+        for (int x = csr->out[i]; x < csr->out[i + 1]; x++) {
+            if (csr->head[x] == i) { // ignore self-loops
+                continue;
+            }
+            graph->targets[n_edges] = (size_t)csr->head[x];
+            graph->weights[n_edges] = ED_dist(csr->outedge[x]);
+            assert(graph->weights[n_edges] > 0);
+            n_edges++;
+        }
+        for (int x = csr->in[i]; x < csr->in[i + 1]; x++) {
+            if (csr->tail[x] == i) { // ignore self-loops
                 continue;
             }
-            node_t *target = (agtail(ep) == np) ? aghead(ep) : agtail(ep); // in case edge is reversed
-            graph->targets[n_edges] = (size_t)ND_id(target);
-            graph->weights[n_edges] = ED_dist(ep);
+            graph->targets[n_edges] = (size_t)csr->tail[x];
+            graph->weights[n_edges] = ED_dist(csr->inedge[x]);
             assert(graph->weights[n_edges] > 0);
             n_edges++;
         }
@@ -81,6 +93,7 @@ static graph_sgd * extract_adjacency(graph_t *G, int model) {
     assert(n_edges <= INT_MAX);
     assert(n_edges == graph->sources[graph->n]);
     graph->sources[n_nodes] = n_edges;
+    agcsrfree(G);
 
     if (model == MODEL_SHORTPATH) {
         // do nothing
@@ -146,6 +159,7 @@ static void free_adjacency(graph_sgd *graph) {
 void sgd(graph_t *G, /* input graph */
         int model /* distance model */)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     if (model == MODEL_CIRCUIT) {
         agerr(AGWARN, "circuit model not yet supported in Gmode=sgd, reverting to shortpath model\n");
         model = MODEL_SHORTPATH;
@@ -195,8 +209,8 @@ void sgd(graph_t *G, /* input graph */
     // note: Epsilon is different from MODE_KK and MODE_MAJOR as it is a minimum step size rather than energy threshold
     //       MaxIter is also different as it is a fixed number of iterations rather than a maximum
     float eta_max = 1 / w_min;
-    float eta_min = Epsilon / w_max;
-    float lambda = log(eta_max/eta_min) / (MaxIter-1);
+    float eta_min = lctx->Epsilon / w_max;
+    float lambda = log(eta_max/eta_min) / (lctx->MaxIter-1);
 
     // initialise starting positions (from neatoprocs)
     initial_positions(G, n);
@@ -217,7 +231,7 @@ void sgd(graph_t *G, /* input graph */
     }
     int t;
     rk_seed(0, &rstate); // TODO: get seed from graph
-    for (t=0; t<MaxIter; t++) {
+    for (t=0; t<lctx->MaxIter; t++) {
         fisheryates_shuffle(terms, n_terms);
         float eta = eta_max * exp(-lambda * t);
         for (ij=0; ij<n_terms; ij++) {
@@ -13,11 +13,11 @@
 #include <math.h>
 
 
-int siteidx;
-Site *bottomsite;
+TLS int siteidx;
+TLS Site *bottomsite;
 
-static Freelist sfl;
-static size_t nvertices;
+static TLS Freelist sfl;
+static TLS size_t nvertices;
 
 void siteinit()
 {
@@ -25,8 +25,8 @@ extern "C" {
 	unsigned refcnt;
     } Site;
 
-    extern int siteidx;
-    extern Site *bottomsite;
+    extern TLS int siteidx;
+    extern TLS Site *bottomsite;
 
     extern void siteinit(void);
     extern Site *getsite(void);
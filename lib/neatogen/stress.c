@@ -9,6 +9,7 @@
  *************************************************************************/
 
 #include <float.h>
+#include <common/random.h>
 #include <neatogen/neato.h>
 #include <neatogen/dijkstra.h>
 #include <neatogen/bfs.h>
@@ -161,11 +162,11 @@ int initLayout(int n, int dim, double **coords, node_t **nodes) {
 	    if (isFixed(np))
 		pinned = 1;
 	} else {
-	    *xp++ = drand48();
-	    *yp++ = drand48();
+	    *xp++ = gv_drand48();
+	    *yp++ = gv_drand48();
 	    if (dim > 2) {
 		for (d = 2; d < dim; d++)
-		    coords[d][i] = drand48();
+		    coords[d][i] = gv_drand48();
 	    }
 	}
     }
@@ -249,6 +250,7 @@ static int sparse_stress_subspace_majorization_kD(vtx_data * graph,	/* Input gra
 						  int num_centers	/* #pivots in sparse distance matrix  */
     )
 {
+    layout_context_t *const lctx = gvLayoutContext();
     int iterations;		/* output: number of iteration of the process */
 
     double conj_tol = tolerance_cg;	/* tolerance of Conjugate Gradient */
@@ -359,7 +361,7 @@ static int sparse_stress_subspace_majorization_kD(vtx_data * graph,	/* Input gra
     /* select 'num_centers' pivots that are uniformaly spread over the graph */
 
     /* the first pivots is selected randomly */
-    node = rand() % n;
+    node = gv_rand() % n;
     CenterIndex[node] = 0;
     invCenterIndex[0] = node;
 
@@ -391,7 +393,7 @@ static int sparse_stress_subspace_majorization_kD(vtx_data * graph,	/* Input gra
 	for (j = 0; j < n; j++) {
 	    dist[j] = MIN(dist[j], Dij[i][j]);
 	    if (dist[j] > max_dist
-		|| (dist[j] == max_dist && rand() % (j + 1) == 0)) {
+		|| (dist[j] == max_dist && gv_rand() % (j + 1) == 0)) {
 		node = j;
 		max_dist = dist[j];
 	    }
@@ -572,7 +574,7 @@ static int sparse_stress_subspace_majorization_kD(vtx_data * graph,	/* Input gra
 	/* random initialization */
 	for (k = 0; k < dim; k++) {
 	    for (i = 0; i < subspace_dim; i++) {
-		directions[k][i] = (double) rand() / RAND_MAX;
+		directions[k][i] = (double) gv_rand() / GV_RAND_MAX;
 	    }
 	}
     }
@@ -643,7 +645,7 @@ static int sparse_stress_subspace_majorization_kD(vtx_data * graph,	/* Input gra
 
 	if (iterations % 2 == 0) { // check for convergence each two iterations
 	    new_stress = compute_stress1(coords, distances, dim, n, exp);
-	    converged = fabs(new_stress - old_stress) / (new_stress + 1e-10) < Epsilon;
+	    converged = fabs(new_stress - old_stress) / (new_stress + 1e-10) < lctx->Epsilon;
 	    old_stress = new_stress;
 	}
     }
@@ -858,6 +860,7 @@ int stress_majorization_kD_mkernel(vtx_data * graph,	/* Input graph in sparse re
 				   int maxi	/* max iterations */
     )
 {
+    layout_context_t *const lctx = gvLayoutContext();
     int iterations;		/* output: number of iteration of the process */
 
     double conj_tol = tolerance_cg;	/* tolerance of Conjugate Gradient */
@@ -964,7 +967,7 @@ int stress_majorization_kD_mkernel(vtx_data * graph,	/* Input graph in sparse re
 	    }
 	    /* add small random noise */
 	    for (j = 0; j < n; j++) {
-		d_coords[i][j] += 1e-6 * (drand48() - 0.5);
+		d_coords[i][j] += 1e-6 * (gv_drand48() - 0.5);
 	    }
 	    orthog1(n, d_coords[i]);
 	}
@@ -1153,7 +1156,7 @@ int stress_majorization_kD_mkernel(vtx_data * graph,	/* Input graph in sparse re
 	{
 	    double diff = old_stress - new_stress;
 	    double change = fabs(diff);
-	    converged = change / old_stress < Epsilon || new_stress < Epsilon;
+	    converged = change / old_stress < lctx->Epsilon || new_stress < lctx->Epsilon;
 	}
 	old_stress = new_stress;
 
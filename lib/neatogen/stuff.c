@@ -11,6 +11,8 @@
 
 #include "config.h"
 #include	<cgraph/alloc.h>
+#include	<cgraph/tls.h>
+#include	<common/random.h>
 #include	<math.h>
 #include	<neatogen/neato.h>
 #include	<neatogen/stress.h>
@@ -19,7 +21,7 @@
 #include	<unistd.h>
 #endif
 
-static double Epsilon2;
+static TLS double Epsilon2;
 static Agnode_t *choose_node(graph_t *, int);
 static void make_spring(graph_t *, Agnode_t *, Agnode_t *, double);
 static void move_node(graph_t *, int, Agnode_t *);
@@ -32,10 +34,11 @@ static double fpow32(double x)
 
 static double distvec(double *p0, double *p1, double *vec)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     int k;
     double dist = 0.0;
 
-    for (k = 0; k < Ndim; k++) {
+    for (k = 0; k < lctx->Ndim; k++) {
 	vec[k] = p0[k] - p1[k];
 	dist += vec[k] * vec[k];
     }
@@ -106,6 +109,7 @@ static void free_3array(double ***rv)
  */
 static int lenattr(edge_t* e, Agsym_t* index, double* val)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     char* s;
 
     if (index == NULL)
@@ -114,7 +118,7 @@ static int lenattr(edge_t* e, Agsym_t* index, double* val)
     s = agxget(e, index);
     if (*s == '\0') return 1;
 
-    if (sscanf(s, "%lf", val) < 1 || *val < 0 || (*val == 0 && !Nop)) {
+    if (sscanf(s, "%lf", val) < 1 || *val < 0 || (*val == 0 && !lctx->Nop)) {
 	agerr(AGWARN, "bad edge len \"%s\"", s);
 	return 2;
     }
@@ -214,6 +218,7 @@ static double setEdgeLen(graph_t * G, node_t * np, Agsym_t* lenx, double dfltlen
  */
 int scan_graph_mode(graph_t * G, int mode)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     int i, nV, nE, deg;
     char *str;
     node_t *np, *xp, *other;
@@ -245,12 +250,12 @@ int scan_graph_mode(graph_t * G, int mode)
 
     lenx = agattr(G, AGEDGE, "len", 0);
     if (mode == MODE_KK) {
-	Epsilon = .0001 * nV;
-	getdouble(G, "epsilon", &Epsilon);
+	lctx->Epsilon = .0001 * nV;
+	getdouble(G, "epsilon", &lctx->Epsilon);
 	if ((str = agget(G->root, "Damping")))
-	    Damping = atof(str);
+	    lctx->Damping = atof(str);
 	else
-	    Damping = .99;
+	    lctx->Damping = .99;
 	GD_neato_nlist(G) = gv_calloc(nV + 1, sizeof(node_t*));
 	for (i = 0, np = agfstnode(G); np; np = agnxtnode(G, np)) {
 	    GD_neato_nlist(G)[i] = np;
@@ -259,8 +264,8 @@ int scan_graph_mode(graph_t * G, int mode)
 	    total_len += setEdgeLen(G, np, lenx, dfltlen);
 	}
     } else if (mode == MODE_SGD) {
-	Epsilon = .01;
-	getdouble(G, "epsilon", &Epsilon);
+	lctx->Epsilon = .01;
+	getdouble(G, "epsilon", &lctx->Epsilon);
 	GD_neato_nlist(G) = gv_calloc(nV + 1, sizeof(node_t*)); // not sure why but sometimes needs the + 1
 	for (i = 0, np = agfstnode(G); np; np = agnxtnode(G, np)) {
 	    GD_neato_nlist(G)[i] = np;
@@ -268,8 +273,8 @@ int scan_graph_mode(graph_t * G, int mode)
 	    total_len += setEdgeLen(G, np, lenx, dfltlen);
 	}
     } else {
-	Epsilon = DFLT_TOLERANCE;
-	getdouble(G, "epsilon", &Epsilon);
+	lctx->Epsilon = DFLT_TOLERANCE;
+	getdouble(G, "epsilon", &lctx->Epsilon);
 	for (i = 0, np = agfstnode(G); np; np = agnxtnode(G, np)) {
 	    ND_id(np) = i++;
 	    total_len += setEdgeLen(G, np, lenx, dfltlen);
@@ -278,15 +283,15 @@ int scan_graph_mode(graph_t * G, int mode)
 
     str = agget(G, "defaultdist");
     if (str && str[0])
-	Initial_dist = fmax(Epsilon, atof(str));
+	lctx->Initial_dist = fmax(lctx->Epsilon, atof(str));
     else
-	Initial_dist = total_len / (nE > 0 ? nE : 1) * sqrt(nV) + 1;
+	lctx->Initial_dist = total_len / (nE > 0 ? nE : 1) * sqrt(nV) + 1;
 
-    if (!Nop && mode == MODE_KK) {
-	GD_dist(G) = new_array(nV, nV, Initial_dist);
+    if (!lctx->Nop && mode == MODE_KK) {
+	GD_dist(G) = new_array(nV, nV, lctx->Initial_dist);
 	GD_spring(G) = new_array(nV, nV, 1.0);
-	GD_sum_t(G) = new_array(nV, Ndim, 1.0);
-	GD_t(G) = new_3array(nV, nV, Ndim, 0.0);
+	GD_sum_t(G) = new_array(nV, lctx->Ndim, 1.0);
+	GD_t(G) = new_3array(nV, nV, lctx->Ndim, 0.0);
     }
 
     return nV;
@@ -299,8 +304,9 @@ int scan_graph(graph_t * g)
 
 void free_scan_graph(graph_t * g)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     free(GD_neato_nlist(g));
-    if (!Nop) {
+    if (!lctx->Nop) {
 	free_array(GD_dist(g));
 	free_array(GD_spring(g));
 	free_array(GD_sum_t(g));
@@ -311,9 +317,10 @@ void free_scan_graph(graph_t * g)
 
 void jitter_d(node_t * np, int nG, int n)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     int k;
-    for (k = n; k < Ndim; k++)
-	ND_pos(np)[k] = nG * drand48();
+    for (k = n; k < lctx->Ndim; k++)
+	ND_pos(np)[k] = nG * gv_drand48();
 }
 
 void jitter3d(node_t * np, int nG)
@@ -323,9 +330,10 @@ void jitter3d(node_t * np, int nG)
 
 void randompos(node_t * np, int nG)
 {
-    ND_pos(np)[0] = nG * drand48();
-    ND_pos(np)[1] = nG * drand48();
-    if (Ndim > 2)
+    layout_context_t *const lctx = gvLayoutContext();
+    ND_pos(np)[0] = nG * gv_drand48();
+    ND_pos(np)[1] = nG * gv_drand48();
+    if (lctx->Ndim > 2)
 	jitter3d(np, nG);
 }
 
@@ -355,6 +363,7 @@ void initial_positions(graph_t * G, int nG)
 
 void diffeq_model(graph_t * G, int nG)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     int i, j, k;
     double dist, **D, **K, del[MAXDIM], f;
     node_t *vi, *vj;
@@ -378,7 +387,7 @@ void diffeq_model(graph_t * G, int nG)
 
     /* init differential equation solver */
     for (i = 0; i < nG; i++)
-	for (k = 0; k < Ndim; k++)
+	for (k = 0; k < lctx->Ndim; k++)
 	    GD_sum_t(G)[i][k] = 0.0;
 
     for (i = 0; (vi = GD_neato_nlist(G)[i]); i++) {
@@ -387,7 +396,7 @@ void diffeq_model(graph_t * G, int nG)
 		continue;
 	    vj = GD_neato_nlist(G)[j];
 	    dist = distvec(ND_pos(vi), ND_pos(vj), del);
-	    for (k = 0; k < Ndim; k++) {
+	    for (k = 0; k < lctx->Ndim; k++) {
 		GD_t(G)[i][j][k] =
 		    GD_spring(G)[i][j] * (del[k] -
 					  GD_dist(G)[i][j] * del[k] /
@@ -406,6 +415,7 @@ void diffeq_model(graph_t * G, int nG)
  */
 static double total_e(graph_t * G, int nG)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     int i, j, d;
     double e = 0.0;		/* 2*energy */
     double t0;			/* distance squared */
@@ -416,7 +426,7 @@ static double total_e(graph_t * G, int nG)
 	ip = GD_neato_nlist(G)[i];
 	for (j = i + 1; j < nG; j++) {
 	    jp = GD_neato_nlist(G)[j];
-	    for (t0 = 0.0, d = 0; d < Ndim; d++) {
+	    for (t0 = 0.0, d = 0; d < lctx->Ndim; d++) {
 		t1 = ND_pos(ip)[d] - ND_pos(jp)[d];
 		t0 += t1 * t1;
 	    }
@@ -430,9 +440,10 @@ static double total_e(graph_t * G, int nG)
 
 void solve_model(graph_t * G, int nG)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     node_t *np;
 
-    Epsilon2 = Epsilon * Epsilon;
+    Epsilon2 = lctx->Epsilon * lctx->Epsilon;
 
     while ((np = choose_node(G, nG))) {
 	move_node(G, nG, np);
@@ -440,29 +451,30 @@ void solve_model(graph_t * G, int nG)
     if (Verbose) {
 	fprintf(stderr, "\nfinal e = %f", total_e(G, nG));
 	fprintf(stderr, " %d%s iterations %.2f sec\n",
-		GD_move(G), GD_move(G) == MaxIter ? "!" : "",
+		GD_move(G), GD_move(G) == lctx->MaxIter ? "!" : "",
 		elapsed_sec());
     }
-    if (GD_move(G) == MaxIter)
+    if (GD_move(G) == lctx->MaxIter)
 	agerr(AGWARN, "Max. iterations (%d) reached on graph %s\n",
-	      MaxIter, agnameof(G));
+	      lctx->MaxIter, agnameof(G));
 }
 
 static void update_arrays(graph_t * G, int nG, int i)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     int j, k;
     double del[MAXDIM], dist, old;
     node_t *vi, *vj;
 
     vi = GD_neato_nlist(G)[i];
-    for (k = 0; k < Ndim; k++)
+    for (k = 0; k < lctx->Ndim; k++)
 	GD_sum_t(G)[i][k] = 0.0;
     for (j = 0; j < nG; j++) {
 	if (i == j)
 	    continue;
 	vj = GD_neato_nlist(G)[j];
 	dist = distvec(ND_pos(vi), ND_pos(vj), del);
-	for (k = 0; k < Ndim; k++) {
+	for (k = 0; k < lctx->Ndim; k++) {
 	    old = GD_t(G)[i][j][k];
 	    GD_t(G)[i][j][k] =
 		GD_spring(G)[i][j] * (del[k] -
@@ -475,9 +487,10 @@ static void update_arrays(graph_t * G, int nG, int i)
     }
 }
 
-#define Msub(i,j)  M[(i)*Ndim+(j)]
+#define Msub(i,j)  M[(i)*lctx->Ndim+(j)]
 static void D2E(graph_t * G, int nG, int n, double *M)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     int i, l, k;
     node_t *vi, *vn;
     double scale, sq, t[MAXDIM];
@@ -485,40 +498,41 @@ static void D2E(graph_t * G, int nG, int n, double *M)
     double **D = GD_dist(G);
 
     vn = GD_neato_nlist(G)[n];
-    for (l = 0; l < Ndim; l++)
-	for (k = 0; k < Ndim; k++)
+    for (l = 0; l < lctx->Ndim; l++)
+	for (k = 0; k < lctx->Ndim; k++)
 	    Msub(l, k) = 0.0;
     for (i = 0; i < nG; i++) {
 	if (n == i)
 	    continue;
 	vi = GD_neato_nlist(G)[i];
 	sq = 0.0;
-	for (k = 0; k < Ndim; k++) {
+	for (k = 0; k < lctx->Ndim; k++) {
 	    t[k] = ND_pos(vn)[k] - ND_pos(vi)[k];
 	    sq += (t[k] * t[k]);
 	}
 	scale = 1 / fpow32(sq);
-	for (k = 0; k < Ndim; k++) {
+	for (k = 0; k < lctx->Ndim; k++) {
 	    for (l = 0; l < k; l++)
 		Msub(l, k) += K[n][i] * D[n][i] * t[k] * t[l] * scale;
 	    Msub(k, k) +=
 		K[n][i] * (1.0 - D[n][i] * (sq - t[k] * t[k]) * scale);
 	}
     }
-    for (k = 1; k < Ndim; k++)
+    for (k = 1; k < lctx->Ndim; k++)
 	for (l = 0; l < k; l++)
 	    Msub(k, l) = Msub(l, k);
 }
 
 node_t *choose_node(graph_t * G, int nG)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     int i, k;
     double m, max;
     node_t *choice, *np;
-    static int cnt = 0;
+    static TLS int cnt = 0;
 
     cnt++;
-    if (GD_move(G) >= MaxIter)
+    if (GD_move(G) >= lctx->MaxIter)
 	return NULL;
     max = 0.0;
     choice = NULL;
@@ -526,7 +540,7 @@ node_t *choose_node(graph_t * G, int nG)
 	np = GD_neato_nlist(G)[i];
 	if (ND_pinned(np) > P_SET)
 	    continue;
-	for (m = 0.0, k = 0; k < Ndim; k++)
+	for (m = 0.0, k = 0; k < lctx->Ndim; k++)
 	    m += GD_sum_t(G)[i][k] * GD_sum_t(G)[i][k];
 	/* could set the color=energy of the node here */
 	if (m > max) {
@@ -548,24 +562,25 @@ node_t *choose_node(graph_t * G, int nG)
 
 void move_node(graph_t * G, int nG, node_t * n)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     int i, m;
-    static double *a, b[MAXDIM], c[MAXDIM];
+    static TLS double *a, b[MAXDIM], c[MAXDIM];
 
     m = ND_id(n);
-    a = ALLOC(Ndim * Ndim, a, double);
+    a = ALLOC(lctx->Ndim * lctx->Ndim, a, double);
     D2E(G, nG, m, a);
-    for (i = 0; i < Ndim; i++)
+    for (i = 0; i < lctx->Ndim; i++)
 	c[i] = -GD_sum_t(G)[m][i];
-    solve(a, b, c, Ndim);
-    for (i = 0; i < Ndim; i++) {
-	b[i] = (Damping + 2 * (1 - Damping) * drand48()) * b[i];
+    solve(a, b, c, lctx->Ndim);
+    for (i = 0; i < lctx->Ndim; i++) {
+	b[i] = (lctx->Damping + 2 * (1 - lctx->Damping) * gv_drand48()) * b[i];
 	ND_pos(n)[i] += b[i];
     }
     GD_move(G)++;
     update_arrays(G, nG, m);
     if (test_toggle()) {
 	double sum = 0;
-	for (i = 0; i < Ndim; i++) {
+	for (i = 0; i < lctx->Ndim; i++) {
 	    sum += fabs(b[i]);
 	}			/* Why not squared? */
 	sum = sqrt(sum);
@@ -573,9 +588,9 @@ void move_node(graph_t * G, int nG, node_t * n)
     }
 }
 
-static node_t **Heap;
-static int Heapsize;
-static node_t *Src;
+static TLS node_t **Heap;
+static TLS int Heapsize;
+static TLS node_t *Src;
 
 static void heapup(node_t * v)
 {
@@ -667,13 +682,14 @@ void shortest_path(graph_t * G, int nG)
 
 void s1(graph_t * G, node_t * node)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     node_t *v, *u;
     edge_t *e;
     int t;
     double f;
 
     for (t = 0; (v = GD_neato_nlist(G)[t]); t++)
-	ND_dist(v) = Initial_dist;
+	ND_dist(v) = lctx->Initial_dist;
     Src = node;
     ND_dist(Src) = 0;
     ND_hops(Src) = 0;
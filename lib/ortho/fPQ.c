@@ -12,14 +12,15 @@
 
 #include "config.h"
 #include <cgraph/alloc.h>
+#include <cgraph/tls.h>
 #include <assert.h>
 
 #include <ortho/fPQ.h>
 
-static snode**  pq;
-static int     PQcnt;
-static snode    guard;
-static int     PQsize;
+static TLS snode**  pq;
+static TLS int     PQcnt;
+static TLS snode    guard;
+static TLS int     PQsize;
 
 void
 PQgen(int sz)
@@ -1241,6 +1241,7 @@ static splineInfo sinfo = { swap_ends_p, spline_merge, true, true };
 void
 orthoEdges (Agraph_t* g, int doLbls)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     sgraph* sg;
     maze* mp;
     route* route_list;
@@ -1255,7 +1256,7 @@ orthoEdges (Agraph_t* g, int doLbls)
     PointSet* ps = NULL;
     textlabel_t* lbl;
 
-    if (Concentrate) 
+    if (lctx->Concentrate) 
 	ps = newPS();
 
 #ifdef DEBUG
@@ -1300,8 +1301,8 @@ orthoEdges (Agraph_t* g, int doLbls)
     size_t n_edges = 0;
     for (n = agfstnode (g); n; n = agnxtnode(g, n)) {
         for (e = agfstout(g, n); e; e = agnxtout(g,e)) {
-	    if (Nop == 2 && ED_spl(e)) continue;
-	    if (Concentrate) {
+	    if (lctx->Nop == 2 && ED_spl(e)) continue;
+	    if (lctx->Concentrate) {
 		int ti = AGSEQ(agtail(e));
 		int hi = AGSEQ(aghead(e));
 		if (ti <= hi) {
@@ -1363,7 +1364,7 @@ orthoEdges (Agraph_t* g, int doLbls)
     attachOrthoEdges(mp, n_edges, route_list, &sinfo, es, doLbls);
 
 orthofinish:
-    if (Concentrate)
+    if (lctx->Concentrate)
 	freePS (ps);
 
     for (size_t i=0; i < n_edges; i++)
@@ -37,11 +37,12 @@ DEFINE_LIST(clist, Agraph_t*)
 
 static void cluster_init_graph(graph_t * g)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     Agnode_t *n;
     Agedge_t *e;
 
     setEdgeType (g, EDGETYPE_LINE);
-    Ndim = GD_ndim(g)=2;	/* The algorithm only makes sense in 2D */
+    lctx->Ndim = GD_ndim(g)=2;	/* The algorithm only makes sense in 2D */
 
     for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
 	neato_init_node (n);
@@ -18,6 +18,7 @@
 #include <assert.h>
 #include <cgraph/alloc.h>
 #include <cgraph/startswith.h>
+#include <cgraph/tls.h>
 #include <common/render.h>
 #include <pack/pack.h>
 #include <common/pointset.h>
@@ -563,7 +564,7 @@ void dumpp(ginfo * info, char *pfx)
 }
 #endif
 
-static packval_t* userVals;
+static TLS packval_t* userVals;
 
 /* ucmpf;
  * Sort by user values.
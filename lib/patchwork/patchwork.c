@@ -201,12 +201,13 @@ static void layoutTree(treenode_t * tree)
 
 static void finishNode(node_t * n)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     char buf [40];
-    if (N_fontsize) {
-	char* str = agxget(n, N_fontsize);
+    if (lctx->N_fontsize) {
+	char* str = agxget(n, lctx->N_fontsize);
 	if (*str == '\0') {
 	    snprintf(buf, sizeof(buf), "%.03f", ND_ht(n)*0.7);
-	    agxset(n, N_fontsize, buf);
+	    agxset(n, lctx->N_fontsize, buf);
 	}
     }
     common_init_node (n);
@@ -13,6 +13,7 @@
 #include <stdlib.h>
 #include <cgraph/alloc.h>
 #include <cgraph/likely.h>
+#include <cgraph/tls.h>
 #include <limits.h>
 #include <pathplan/vis.h>
 
@@ -214,8 +215,8 @@ static void printDad(int *vis, int n)
 
 #ifdef GASP
 
-static Ppoint_t Bezpt[1000];
-static int Bezctr;
+static TLS Ppoint_t Bezpt[1000];
+static TLS int Bezctr;
 
 static void addpt(Ppoint_t p)
 {
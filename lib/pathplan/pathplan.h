@@ -50,6 +50,9 @@ extern "C" {
 /* function to convert a polyline into a spline representation */
     PATHPLAN_API void make_polyline(Ppolyline_t line, Ppolyline_t* sline);
 
+/* free the buffers the functions above keep for the calling thread */
+    PATHPLAN_API void Pfreebuffers(void);
+
 #undef PATHPLAN_API
 
 #ifdef __cplusplus
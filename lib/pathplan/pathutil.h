@@ -39,6 +39,10 @@ extern "C" {
 
     PATHUTIL_API int in_poly(Ppoly_t argpoly, Ppoint_t q);
 
+/* the parts of Pfreebuffers in route.c and shortest.c */
+    void route_free(void);
+    void shortest_free(void);
+
 #undef PATHUTIL_API
 #ifdef __cplusplus
 }
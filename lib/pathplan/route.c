@@ -13,6 +13,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
+#include <cgraph/tls.h>
 #include <pathplan/pathutil.h>
 #include <pathplan/solvers.h>
 
@@ -30,8 +31,11 @@ typedef struct tna_t {
 
 #define POINTSIZE sizeof (Ppoint_t)
 
-static Ppoint_t *ops;
-static int opn, opl;
+static TLS Ppoint_t *ops;
+static TLS int opn, opl;
+
+static TLS tna_t *tnas;
+static TLS int tnan;
 
 static int reallyroutespline(Pedge_t *, int,
 			     Ppoint_t *, int, Ppoint_t, Ppoint_t);
@@ -101,9 +105,6 @@ static int reallyroutespline(Pedge_t * edges, int edgen,
     double maxd, d, t;
     int maxi, i, spliti;
 
-    static tna_t *tnas;
-    static int tnan;
-
     if (tnan < inpn) {
 	if (!(tnas = realloc(tnas, sizeof(tna_t) * (size_t)inpn)))
 	    return -1;
@@ -427,6 +428,16 @@ static int growops(int newopn)
     return 0;
 }
 
+void route_free(void)
+{
+    free(ops);
+    ops = NULL;
+    opn = 0;
+    free(tnas);
+    tnas = NULL;
+    tnan = 0;
+}
+
 static Ppoint_t add(Ppoint_t p1, Ppoint_t p2)
 {
     p1.x += p2.x, p1.y += p2.y;
@@ -11,6 +11,7 @@
 #include <assert.h>
 #include <cgraph/list.h>
 #include <cgraph/prisize_t.h>
+#include <cgraph/tls.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdint.h>
@@ -57,14 +58,14 @@ typedef struct deque_t {
     size_t pnlpn, fpnlpi, lpnlpi, apex;
 } deque_t;
 
-static pointnlink_t *pnls, **pnlps;
-static size_t pnln;
-static int pnll;
+static TLS pointnlink_t *pnls, **pnlps;
+static TLS size_t pnln;
+static TLS int pnll;
 
-static triangles_t tris;
+static TLS triangles_t tris;
 
-static Ppoint_t *ops;
-static size_t opn;
+static TLS Ppoint_t *ops;
+static TLS size_t opn;
 
 static int triangulate(pointnlink_t **, int);
 static bool isdiagonal(int, int, pointnlink_t **, int);
@@ -526,3 +527,15 @@ static int growops(size_t newopn) {
 
     return 0;
 }
+
+void shortest_free(void) {
+    free(pnls);
+    free(pnlps);
+    pnls = NULL;
+    pnlps = NULL;
+    pnln = 0;
+    triangles_free(&tris);
+    free(ops);
+    ops = NULL;
+    opn = 0;
+}
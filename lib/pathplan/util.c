@@ -11,6 +11,7 @@
 
 #include <assert.h>
 #include <cgraph/alloc.h>
+#include <cgraph/tls.h>
 #include <stdlib.h>
 #include <pathplan/pathutil.h>
 
@@ -51,13 +52,14 @@ int Ppolybarriers(Ppoly_t ** polys, int npolys, Pedge_t ** barriers,
     return 1;
 }
 
+static TLS int isz = 0;
+static TLS Ppoint_t* ispline = 0;
+
 /* make_polyline:
  */
 void
 make_polyline(Ppolyline_t line, Ppolyline_t* sline)
 {
-    static int isz = 0;
-    static Ppoint_t* ispline = 0;
     int i, j;
     int npts = 4 + 3*(line.pn-2);
 
@@ -84,3 +86,12 @@ make_polyline(Ppolyline_t line, Ppolyline_t* sline)
  * @dir lib/pathplan
  * @brief finds and smooths shortest paths, API pathplan.h
  */
+
+void Pfreebuffers(void)
+{
+    free(ispline);
+    ispline = NULL;
+    isz = 0;
+    route_free();
+    shortest_free();
+}
@@ -45,13 +45,14 @@ static void sfdp_init_node_edge(graph_t * g)
 
 static void sfdp_init_graph(Agraph_t * g)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     int outdim;
 
     setEdgeType(g, EDGETYPE_LINE);
     outdim = late_int(g, agfindgraphattr(g, "dimen"), 2, 2);
     GD_ndim(agroot(g)) = late_int(g, agfindgraphattr(g, "dim"), outdim, 2);
-    Ndim = GD_ndim(agroot(g)) = MIN(GD_ndim(agroot(g)), MAXDIM);
-    GD_odim(agroot(g)) = MIN(outdim, Ndim);
+    lctx->Ndim = GD_ndim(agroot(g)) = MIN(GD_ndim(agroot(g)), MAXDIM);
+    GD_odim(agroot(g)) = MIN(outdim, lctx->Ndim);
     sfdp_init_node_edge(g);
 }
 
@@ -59,8 +60,9 @@ static void sfdp_init_graph(Agraph_t * g)
  */
 static double *getPos(Agraph_t * g)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     Agnode_t *n;
-    double *pos = N_NEW(Ndim * agnnodes(g), double);
+    double *pos = N_NEW(lctx->Ndim * agnnodes(g), double);
     int ix, i;
 
     if (agfindnodeattr(g, "pos") == NULL)
@@ -69,8 +71,8 @@ static double *getPos(Agraph_t * g)
     for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
 	i = ND_id(n);
 	if (hasPos(n)) {
-	    for (ix = 0; ix < Ndim; ix++) {
-		pos[i * Ndim + ix] = ND_pos(n)[ix];
+	    for (ix = 0; ix < lctx->Ndim; ix++) {
+		pos[i * lctx->Ndim + ix] = ND_pos(n)[ix];
 	    }
 	}
     }
@@ -80,6 +82,7 @@ static double *getPos(Agraph_t * g)
 
 static void sfdpLayout(graph_t * g, spring_electrical_control ctrl,
                        pointf pad) {
+    layout_context_t *const lctx = gvLayoutContext();
     double *sizes;
     double *pos;
     Agnode_t *n;
@@ -98,11 +101,11 @@ static void sfdpLayout(graph_t * g, spring_electrical_control ctrl,
 	sizes = NULL;
     pos = getPos(g);
 
-    multilevel_spring_electrical_embedding(Ndim, A, D, ctrl, sizes, pos, n_edge_label_nodes, edge_label_nodes, &flag);
+    multilevel_spring_electrical_embedding(lctx->Ndim, A, D, ctrl, sizes, pos, n_edge_label_nodes, edge_label_nodes, &flag);
 
     for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
-	double *npos = pos + (Ndim * ND_id(n));
-	for (i = 0; i < Ndim; i++) {
+	double *npos = pos + (lctx->Ndim * ND_id(n));
+	for (i = 0; i < lctx->Ndim; i++) {
 	    ND_pos(n)[i] = npos[i];
 	}
     }
@@ -225,10 +228,11 @@ tuneControl (graph_t* g, spring_electrical_control ctrl)
 
 void sfdp_layout(graph_t * g)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     int doAdjust;
     adjust_data am;
     sfdp_init_graph(g);
-    doAdjust = (Ndim == 2);
+    doAdjust = (lctx->Ndim == 2);
 
     if (agnnodes(g)) {
 	Agraph_t **ccs;
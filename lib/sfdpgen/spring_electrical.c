@@ -23,6 +23,7 @@
 #include <common/arith.h>
 #include <math.h>
 #include <common/globals.h>
+#include <common/random.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <string.h>
@@ -432,7 +433,7 @@ void spring_electrical_embedding_fast(int dim, SparseMatrix A0, spring_electrica
   ja = A->ja;
 
   if (ctrl->random_start){
-    srand(ctrl->random_seed);
+    gv_srand(ctrl->random_seed);
     for (i = 0; i < dim*n; i++) x[i] = drand();
   }
   if (K < 0){
@@ -601,7 +602,7 @@ static void spring_electrical_embedding_slow(int dim, SparseMatrix A0, spring_el
   ja = A->ja;
 
   if (ctrl->random_start){
-    srand(ctrl->random_seed);
+    gv_srand(ctrl->random_seed);
     for (i = 0; i < dim*n; i++) x[i] = drand();
   }
   if (K < 0){
@@ -777,7 +778,7 @@ void spring_electrical_embedding(int dim, SparseMatrix A0, spring_electrical_con
   ja = A->ja;
 
   if (ctrl->random_start){
-    srand(ctrl->random_seed);
+    gv_srand(ctrl->random_seed);
     for (i = 0; i < dim*n; i++) x[i] = drand();
   }
   if (K < 0){
@@ -1002,7 +1003,7 @@ void spring_electrical_spring_embedding(int dim, SparseMatrix A0, SparseMatrix D
   d = D->a;
 
   if (ctrl->random_start){
-    srand(ctrl->random_seed);
+    gv_srand(ctrl->random_seed);
     for (i = 0; i < dim*n; i++) x[i] = drand();
   }
   if (K < 0){
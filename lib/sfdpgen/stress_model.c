@@ -1,3 +1,4 @@
+#include <common/random.h>
 #include <sparse/general.h>
 #include <sparse/SparseMatrix.h>
 #include <sfdpgen/spring_electrical.h>
@@ -26,7 +27,7 @@ static void stress_model_core(int dim, SparseMatrix B, double **x, int edge_len_
   m = A->m;
   if (!x) {
     *x = MALLOC(sizeof(double)*m*dim);
-    srand(123);
+    gv_srand(123);
     for (i = 0; i < dim*m; i++) (*x)[i] = drand();
   }
 
@@ -80,6 +80,7 @@ SparseMatrix SparseMatrix_import_dot(Agraph_t *g, int dim, double **label_sizes,
   SparseMatrix A = 0;
   Agnode_t* n;
   Agedge_t* e;
+  const Agcsr_t *csr;
   Agsym_t *sym;
   Agsym_t *psym;
   int nnodes;
@@ -121,13 +122,14 @@ SparseMatrix SparseMatrix_import_dot(Agraph_t *g, int dim, double **label_sizes,
   }
 
   sym = agattr(g, AGEDGE, "weight", NULL);
-  i = 0;
-  for (n = agfstnode (g); n; n = agnxtnode (g, n)) {
+  if (!(csr = agcsr(g))) graphviz_exit(1);
+  for (row = 0; row < csr->nnodes; row++) {
+    n = csr->node[row];
     if (edge_label_nodes && strncmp(agnameof(n), "|edgelabel|",11)==0) nedge_nodes++;
-    row = ND_id(n);
-    for (e = agfstout (g, n); e; e = agnxtout (g, e)) {
+    for (i = csr->out[row]; i < csr->out[row + 1]; i++) {
+      e = csr->outedge[i];
       I[i] = row;
-      J[i] = ND_id(aghead(e));
+      J[i] = csr->head[i];
 
       /* edge weight */
       if (sym) {
@@ -136,10 +138,9 @@ SparseMatrix SparseMatrix_import_dot(Agraph_t *g, int dim, double **label_sizes,
         v = 1;
       }
       val[i] = v;
-
-      i++;
     }
   }
+  agcsrfree(g);
   
   if (edge_label_nodes) {
     *edge_label_nodes = MALLOC(sizeof(int)*nedge_nodes);
@@ -180,8 +181,8 @@ SparseMatrix SparseMatrix_import_dot(Agraph_t *g, int dim, double **label_sizes,
       i = ND_id(n);
       if ((pval = agxget(n, psym)) && *pval) {
 	if (dim == 2){
-	  nitems = sscanf(pval, "%lf,%lf", &xx, &yy);
-	  if (nitems != 2) {
+	  if (!agxgetpoint(n, psym, &xx, &yy)) {
+	    nitems = sscanf(pval, "%lf,%lf", &xx, &yy);
             has_positions = false;
             agerr(AGERR, "Node \"%s\" pos has %d < 2 values", agnameof(n), nitems);
 	  }
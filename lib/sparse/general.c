@@ -9,6 +9,7 @@
  *************************************************************************/
 
 #include <cgraph/alloc.h>
+#include <common/random.h>
 #include <math.h>
 #include <stdbool.h>
 #include <stddef.h>
@@ -20,14 +21,14 @@ double _statistics[10];
 #endif
 
 double drand(){
-  return rand()/(double) RAND_MAX;
+  return gv_rand()/(double) GV_RAND_MAX;
 }
 
 int irand(int n){
   /* 0, 1, ..., n-1 */
   assert(n > 1);
   /*return (int) MIN(floor(drand()*n),n-1);*/
-  return rand()%n;
+  return gv_rand()%n;
 }
 
 int *random_permutation(int n){
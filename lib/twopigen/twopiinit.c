@@ -23,9 +23,10 @@
 
 static void twopi_init_edge(edge_t * e)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     agbindrec(e, "Agedgeinfo_t", sizeof(Agedgeinfo_t), true);	//edge custom data
     common_init_edge(e);
-    ED_factor(e) = late_double(e, E_weight, 1.0, 0.0);
+    ED_factor(e) = late_double(e, lctx->E_weight, 1.0, 0.0);
 }
 
 static void twopi_init_node_edge(graph_t * g)
@@ -51,9 +52,10 @@ static void twopi_init_node_edge(graph_t * g)
 
 void twopi_init_graph(graph_t * g)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     setEdgeType (g, EDGETYPE_LINE);
     /* GD_ndim(g) = late_int(g,agfindgraphattr(g,"dim"),2,2); */
-	Ndim = GD_ndim(agroot(g)) = 2;	/* The algorithm only makes sense in 2D */
+	lctx->Ndim = GD_ndim(agroot(g)) = 2;	/* The algorithm only makes sense in 2D */
     twopi_init_node_edge(g);
 }
 
@@ -12,6 +12,7 @@
 
 // include vmalloc and some of its internals directly so we can call them
 #include <vmalloc/vmalloc.h>
+#include <vmalloc/vmhdr.h>
 #include <vmalloc/vmalloc.c>
 #include <vmalloc/vmclear.c>
 #include <vmalloc/vmclose.c>
@@ -253,6 +254,127 @@ static void test_strdup(void) {
   assert(r == 0);
 }
 
+// freed memory should be handed out again rather than the region growing
+static void test_reuse(void) {
+
+  // create a new vmalloc region
+  Vmalloc_t *v = vmopen();
+  assert(v != NULL);
+
+  // allocate and free something small
+  void *p = vmalloc(v, 40);
+  assert(p != NULL);
+  vmfree(v, p);
+  assert(v->size == 0);
+
+  // an allocation of the same size should receive the same memory
+  void *q = vmalloc(v, 40);
+  assert(q == p);
+
+  // repeatedly allocating and freeing should not consume more blocks
+  char *const next = v->next;
+  for (size_t i = 0; i < 100000; ++i) {
+    void *r = vmalloc(v, 100);
+    assert(r != NULL);
+    vmfree(v, r);
+  }
+  assert(v->next == next + sizeof(vmhead_t) + round_up(100));
+  assert(v->nblocks == 1);
+
+  // large allocations should be tracked and released individually
+  void *l1 = vmalloc(v, VM_SMALL * 4);
+  void *l2 = vmalloc(v, VM_SMALL * 8);
+  assert(l1 != NULL && l2 != NULL);
+  assert(v->nlarge == 2);
+  vmfree(v, l2);
+  assert(v->nlarge == 1 && v->large[0] == l1);
+  vmfree(v, l1);
+  assert(v->nlarge == 0);
+  assert(v->size == 1);
+
+  // pointers we did not allocate should be ignored
+  char *foreign = malloc(VM_SMALL * 4);
+  assert(foreign != NULL);
+  vmfree(v, foreign);
+  vmfree(v, foreign + 64);
+  assert(vmresize(v, foreign, 8) == NULL);
+  assert(v->size == 1);
+  free(foreign);
+
+  // as should pointers into the middle of our allocations
+  char *small = vmalloc(v, 64);
+  char *big = vmalloc(v, VM_SMALL * 2);
+  assert(small != NULL && big != NULL);
+  assert(v->size == 3);
+  vmfree(v, small + VM_ALIGN);
+  vmfree(v, small + 1);
+  vmfree(v, big + VM_ALIGN);
+  assert(vmresize(v, small + VM_ALIGN, 8) == NULL);
+  assert(vmresize(v, big + VM_ALIGN, 8) == NULL);
+  assert(v->size == 3);
+
+  // and pointers that have already been freed
+  vmfree(v, small);
+  vmfree(v, big);
+  assert(v->size == 1);
+  vmfree(v, small);
+  vmfree(v, big);
+  assert(vmresize(v, small, 8) == NULL);
+  assert(v->size == 1);
+
+  // a freed allocation handed out again should be live again
+  char *again = vmalloc(v, 64);
+  assert(again == small);
+  vmfree(v, again);
+  assert(v->size == 1);
+
+  // clean up
+  int r = vmclose(v);
+  assert(r == 0);
+}
+
+// resizing across the small/large boundary should preserve contents
+static void test_resize_large(void) {
+
+  // create a new vmalloc region
+  Vmalloc_t *v = vmopen();
+  assert(v != NULL);
+
+  // a trailing small allocation should be able to grow in place
+  unsigned char *p = vmalloc(v, 16);
+  assert(p != NULL);
+  unsigned char *q = vmresize(v, p, 512);
+  assert(q == p);
+
+  for (size_t i = 0; i < 512; ++i) {
+    p[i] = (unsigned char)i;
+  }
+
+  // grow it into a large allocation, in steps to exercise realloc
+  for (size_t s = VM_SMALL * 2; s <= VM_SMALL * 64; s *= 2) {
+    p = vmresize(v, p, s);
+    assert(p != NULL);
+    for (size_t i = 0; i < 512; ++i) {
+      assert(p[i] == (unsigned char)i);
+    }
+  }
+  assert(v->size == 1);
+  assert(v->nlarge == 1 && v->large[0] == (char *)p);
+
+  // shrink it back into a small allocation
+  p = vmresize(v, p, 100);
+  assert(p != NULL);
+  for (size_t i = 0; i < 100; ++i) {
+    assert(p[i] == (unsigned char)i);
+  }
+  assert(v->size == 1);
+  assert(v->nlarge == 0);
+
+  // clean up
+  int r = vmclose(v);
+  assert(r == 0);
+}
+
 int main(void) {
 
 #define RUN(t)                                                                 \
@@ -268,6 +390,8 @@ int main(void) {
   RUN(lifecycle);
   RUN(resize);
   RUN(strdup);
+  RUN(reuse);
+  RUN(resize_large);
 
 #undef RUN
 
@@ -9,48 +9,222 @@
  *************************************************************************/
 
 #include <vmalloc/vmalloc.h>
+#include <vmalloc/vmhdr.h>
 #include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
 
-/** make room to store a new pointer we are about to allocate
+/// round a request up to a whole number of alignment units
+static size_t round_up(size_t size) {
+  if (size == 0) {
+    return VM_ALIGN;
+  }
+  return (size + VM_ALIGN - 1) / VM_ALIGN * VM_ALIGN;
+}
+
+/// free list index of a small allocation of `size` usable bytes
+static size_t class_of(size_t size) { return size / VM_ALIGN - 1; }
+
+/// index of the first entry of an array sorted by address that is above `p`
+static size_t upper_bound(char *const *a, size_t n, const char *p) {
+  size_t lo = 0;
+  size_t hi = n;
+  while (lo < hi) {
+    const size_t mid = lo + (hi - lo) / 2;
+    if (a[mid] <= p) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+/** insert an address into an array sorted by address
  *
- * @param vm Vmalloc to operate on
+ * @param a The array, which may be reallocated
+ * @param n Used entries in the array
+ * @param capacity Available entries in the array
+ * @param p Address to insert
  * @returns true on success
  */
-static bool make_space(Vmalloc_t *vm) {
+static bool insert(char ***a, size_t *n, size_t *capacity, char *p) {
 
-  if (vm->size == vm->capacity) {
+  if (*n == *capacity) {
 
-    // expand our allocation storage
-    size_t c = vm->capacity == 0 ? 1 : vm->capacity * 2;
-    void **p = realloc(vm->allocated, sizeof(vm->allocated[0]) * c);
-    if (p == NULL) {
+    // expand the array
+    size_t c = *capacity == 0 ? 16 : *capacity * 2;
+    char **q = realloc(*a, sizeof(q[0]) * c);
+    if (q == NULL) {
       return false;
     }
 
     // save the new array
-    vm->allocated = p;
-    vm->capacity = c;
+    *a = q;
+    *capacity = c;
   }
 
+  const size_t i = upper_bound(*a, *n, p);
+  memmove(&(*a)[i + 1], &(*a)[i], sizeof((*a)[0]) * (*n - i));
+  (*a)[i] = p;
+  ++*n;
+
   return true;
 }
 
-void *vmalloc(Vmalloc_t *vm, size_t size) {
+/// set or clear the bit in a block’s map for the allocation at `p`
+static void mark(char *block, const char *p, bool live) {
+  unsigned char *map = (unsigned char *)block;
+  const size_t unit = (size_t)(p - block) / VM_ALIGN;
+  if (live) {
+    map[unit / 8] |= (unsigned char)(1u << (unit % 8));
+  } else {
+    map[unit / 8] &= (unsigned char)~(1u << (unit % 8));
+  }
+}
+
+/// is the bit in a block’s map for the allocation at `p` set?
+static bool marked(const char *block, const char *p) {
+  const unsigned char *map = (const unsigned char *)block;
+  const size_t unit = (size_t)(p - block) / VM_ALIGN;
+  return (map[unit / 8] >> (unit % 8)) & 1;
+}
+
+/** add a new block to carve small allocations out of
+ *
+ * @param vm Vmalloc to operate on
+ * @returns true on success
+ */
+static bool new_block(Vmalloc_t *vm) {
 
-  if (!make_space(vm)) {
+  char *b = malloc(VM_BLOCK);
+  if (b == NULL) {
+    return false;
+  }
+
+  if (!insert(&vm->blocks, &vm->nblocks, &vm->capacity, b)) {
+    free(b);
+    return false;
+  }
+
+  // nothing in it is allocated yet
+  memset(b, 0, VM_MAP);
+
+  // start allocating from it, abandoning the tail of the current one
+  vm->next = b + VM_MAP;
+  vm->end = b + VM_BLOCK;
+
+  return true;
+}
+
+/** carve a small allocation out of the current block
+ *
+ * @param vm Vmalloc to operate on
+ * @param size Usable bytes, a multiple of VM_ALIGN no greater than VM_SMALL
+ * @returns The allocation or NULL on failure
+ */
+static void *bump(Vmalloc_t *vm, size_t size) {
+
+  const size_t need = sizeof(vmhead_t) + size;
+
+  if ((size_t)(vm->end - vm->next) < need && !new_block(vm)) {
     return NULL;
   }
 
-  void *p = malloc(size);
-  if (p == NULL) {
+  vmhead_t *h = (vmhead_t *)vm->next;
+  vm->next += need;
+  h->size = size;
+  mark(vm->end - VM_BLOCK, (char *)(h + 1), true);
+  return h + 1;
+}
+
+/** find the block of a live small allocation
+ *
+ * @param vm Vmalloc to operate on
+ * @param data Pointer to look up
+ * @returns The block `data` was carved out of, or NULL if `data` is not the
+ *   start of a live small allocation
+ */
+static char *small_block(const Vmalloc_t *vm, const void *data) {
+
+  // find the last block starting at or before this pointer
+  const char *p = data;
+  const size_t i = upper_bound(vm->blocks, vm->nblocks, p);
+  if (i == 0) {
     return NULL;
   }
+  char *block = vm->blocks[i - 1];
 
-  vm->allocated[vm->size] = p;
-  ++vm->size;
+  // is it inside the block, at the start of a live allocation?
+  const size_t offset = (size_t)(p - block);
+  if (offset < VM_MAP + sizeof(vmhead_t) || offset >= VM_BLOCK ||
+      offset % VM_ALIGN != 0 || !marked(block, p)) {
+    return NULL;
+  }
+  return block;
+}
 
+/// index of a large allocation in the region’s list, or `vm->nlarge` if
+/// `data` is not one
+static size_t find_large(const Vmalloc_t *vm, const void *data) {
+  const size_t i = upper_bound(vm->large, vm->nlarge, data);
+  if (i > 0 && vm->large[i - 1] == data) {
+    return i - 1;
+  }
+  return vm->nlarge;
+}
+
+/// remove the entry at index `i` from the region’s large allocations
+static void remove_large(Vmalloc_t *vm, size_t i) {
+  memmove(&vm->large[i], &vm->large[i + 1],
+          sizeof(vm->large[0]) * (vm->nlarge - i - 1));
+  --vm->nlarge;
+}
+
+/** allocate something bigger than VM_SMALL straight from the system
+ *
+ * @param vm Vmalloc to operate on
+ * @param size Usable bytes, a multiple of VM_ALIGN
+ * @returns The allocation or NULL on failure
+ */
+static void *large(Vmalloc_t *vm, size_t size) {
+
+  vmhead_t *h = malloc(sizeof(vmhead_t) + size);
+  if (h == NULL) {
+    return NULL;
+  }
+  h->size = size;
+
+  if (!insert(&vm->large, &vm->nlarge, &vm->large_capacity, (char *)(h + 1))) {
+    free(h);
+    return NULL;
+  }
+  return h + 1;
+}
+
+void *vmalloc(Vmalloc_t *vm, size_t size) {
+
+  const size_t s = round_up(size);
+  if (s < size) { // overflow
+    return NULL;
+  }
+
+  void *p;
+  if (s > VM_SMALL) {
+    p = large(vm, s);
+  } else if (vm->free[class_of(s)] != NULL) {
+    // reuse a freed allocation of the same size
+    p = vm->free[class_of(s)];
+    memcpy(&vm->free[class_of(s)], p, sizeof(void *));
+    mark(vmhead(p)->block, p, true);
+    vmhead(p)->size = s;
+  } else {
+    p = bump(vm, s);
+  }
+
+  if (p != NULL) {
+    ++vm->size;
+  }
   return p;
 }
 
@@ -60,23 +234,24 @@ void vmfree(Vmalloc_t *vm, void *data) {
     return;
   }
 
-  // find the pointer we previously allocated
-  for (size_t i = 0; i < vm->size; ++i) {
-    if (vm->allocated[i] == data) {
-
-      // clear this slot
-      size_t extent = sizeof(vm->allocated[0]) * (vm->size - i - 1);
-      memmove(vm->allocated + i, vm->allocated + i + 1, extent);
-      --vm->size;
-
-      // give this back to the underlying allocator
-      free(data);
-
+  char *block = small_block(vm, data);
+  if (block != NULL) {
+    // push this onto the free list for its size
+    mark(block, data, false);
+    const size_t size = vmhead(data)->size;
+    vmhead(data)->block = block;
+    memcpy(data, &vm->free[class_of(size)], sizeof(void *));
+    vm->free[class_of(size)] = data;
+  } else {
+    const size_t i = find_large(vm, data);
+    if (i == vm->nlarge) {
+      // free() of something we did not allocate, or have already freed
       return;
     }
+    remove_large(vm, i);
+    free(vmhead(data));
   }
-
-  // we did not find this pointer; free() of something we did not allocate
+  --vm->size;
 }
 
 void *vmresize(Vmalloc_t *vm, void *data, size_t size) {
@@ -85,23 +260,64 @@ void *vmresize(Vmalloc_t *vm, void *data, size_t size) {
     return vmalloc(vm, size);
   }
 
-  // find the pointer we previously allocated
-  for (size_t i = 0; i < vm->size; ++i) {
-    if (vm->allocated[i] == data) {
+  // the pointer the caller gave us was not allocated by us
+  const size_t li = find_large(vm, data);
+  if (li == vm->nlarge && small_block(vm, data) == NULL) {
+    return NULL;
+  }
 
-      // resize the allocation
-      void *p = realloc(data, size);
-      if (p == NULL) {
-        return p;
-      }
+  const size_t s = round_up(size);
+  if (s < size) { // overflow
+    return NULL;
+  }
 
-      // save the updated pointer
-      vm->allocated[i] = p;
+  vmhead_t *h = vmhead(data);
 
-      return p;
+  // large allocations can be resized by the system, as long as they stay large
+  if (h->size > VM_SMALL && s > VM_SMALL) {
+    vmhead_t *p = realloc(h, sizeof(vmhead_t) + s);
+    if (p == NULL) {
+      return NULL;
     }
+    p->size = s;
+    // the allocation may have moved, changing its place in the list
+    remove_large(vm, li);
+    // cannot fail, as removing an entry left room for one
+    (void)insert(&vm->large, &vm->nlarge, &vm->large_capacity, (char *)(p + 1));
+    return p + 1;
   }
 
-  // the pointer the caller gave us was not allocated by us
-  return NULL;
+  // shrinking a small allocation, or growing it within its rounding, is free
+  if (h->size <= VM_SMALL && s <= h->size) {
+    return data;
+  }
+
+  // the most recent allocation from the current block can grow in place
+  if (h->size <= VM_SMALL && s <= VM_SMALL &&
+      (char *)data + h->size == vm->next &&
+      s - h->size <= (size_t)(vm->end - vm->next)) {
+    vm->next += s - h->size;
+    h->size = s;
+    return data;
+  }
+
+  void *p = vmalloc(vm, size);
+  if (p == NULL) {
+    return NULL;
+  }
+  memcpy(p, data, h->size < s ? h->size : s);
+  vmfree(vm, data);
+  return p;
+}
+
+void _vmrelease(Vmalloc_t *vm) {
+
+  for (size_t i = 0; i < vm->nblocks; ++i) {
+    free(vm->blocks[i]);
+  }
+  free(vm->blocks);
+  for (size_t i = 0; i < vm->nlarge; ++i) {
+    free(vmhead(vm->large[i]));
+  }
+  free(vm->large);
 }
@@ -23,10 +23,43 @@ extern "C" {
 
     typedef struct _vmalloc_s Vmalloc_t;
 
+/* A region hands out small allocations by bumping a pointer through large
+** blocks, recycling freed ones through per-size free lists. Larger
+** allocations come from the system individually. Every allocation is
+** preceded by a header recording its size, and clearing the region releases
+** whole blocks rather than individual allocations. Blocks and large
+** allocations are kept sorted by address, and each block marks where its live
+** allocations start, so vmfree and vmresize can recognize and ignore a
+** pointer the region did not hand out, or no longer has live.
+*/
+
+/// strictest alignment of anything allocated from a region
+    typedef union {
+	long double ld;
+	long long ll;
+	double d;
+	void *p;
+	void (*f)(void);
+    } vmalign_t;
+
+/// granularity of allocation sizes
+#define VM_ALIGN sizeof(vmalign_t)
+/// largest allocation carved out of a block
+#define VM_SMALL ((size_t)1024)
+/// number of free lists, one per size up to VM_SMALL
+#define VM_CLASSES (VM_SMALL / VM_ALIGN)
+
     struct _vmalloc_s {
-	void **allocated;	/* pointers we have given out           */
-	size_t size;	/* used entries in `allocated`          */
-	size_t capacity;	/* available entries in `allocated`     */
+	char **blocks;		/* blocks of small allocations, by address */
+	size_t nblocks;		/* used entries in `blocks`              */
+	size_t capacity;	/* available entries in `blocks`         */
+	char *next;		/* first free byte of the current block  */
+	char *end;		/* end of the current block              */
+	char **large;		/* allocations bigger than VM_SMALL, by address */
+	size_t nlarge;		/* used entries in `large`               */
+	size_t large_capacity;	/* available entries in `large`          */
+	void *free[VM_CLASSES];	/* freed small allocations, by size      */
+	size_t size;		/* number of live allocations            */
     };
 
     extern Vmalloc_t *vmopen(void);
@@ -9,7 +9,8 @@
  *************************************************************************/
 
 #include <vmalloc/vmalloc.h>
-#include <stdlib.h>
+#include <vmalloc/vmhdr.h>
+#include <string.h>
 
 /** Clear out all allocated space.
  *
@@ -21,15 +22,17 @@
  */
 int vmclear(Vmalloc_t *vm) {
 
-  // free all allocated pointers
-  for (size_t i = 0; i < vm->size; ++i) {
-    free(vm->allocated[i]);
-  }
+  // free all blocks and large allocations
+  _vmrelease(vm);
 
   // reset our metadata
-  free(vm->allocated);
-  vm->allocated = NULL;
-  vm->size = vm->capacity = 0;
+  vm->blocks = NULL;
+  vm->nblocks = vm->capacity = 0;
+  vm->next = vm->end = NULL;
+  vm->large = NULL;
+  vm->nlarge = vm->large_capacity = 0;
+  memset(vm->free, 0, sizeof(vm->free));
+  vm->size = 0;
 
   return 0;
 }
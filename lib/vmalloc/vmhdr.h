@@ -0,0 +1,37 @@
+/*************************************************************************
+ * Copyright (c) 2011 AT&T Intellectual Property 
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors: Details at https://graphviz.org
+ *************************************************************************/
+
+#pragma once
+
+/* Private header file for the virtual malloc package. */
+
+#include <stddef.h>
+#include <vmalloc/vmalloc.h>
+
+/// size of the blocks small allocations are carved out of
+#define VM_BLOCK ((size_t)64 * 1024)
+
+/// bytes at the start of a block marking which of its alignment units start a
+/// live allocation, one bit per unit
+#define VM_MAP (VM_BLOCK / VM_ALIGN / 8)
+
+/// header preceding every allocation
+typedef union {
+  size_t size; ///< usable bytes, a multiple of VM_ALIGN
+  char *block; ///< block a freed small allocation lies in, as its free list
+               ///< gives its size
+  vmalign_t align;
+} vmhead_t;
+
+/// header of the allocation at `p`
+static inline vmhead_t *vmhead(void *p) { return (vmhead_t *)p - 1; }
+
+/// release all blocks and large allocations of a region
+void _vmrelease(Vmalloc_t *vm);
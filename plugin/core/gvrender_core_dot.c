@@ -28,6 +28,7 @@
 #include <cgraph/alloc.h>
 #include <cgraph/agxbuf.h>
 #include <cgraph/prisize_t.h>
+#include <cgraph/tls.h>
 #include <cgraph/unreachable.h>
 #include <common/utils.h>
 #include <gvc/gvc.h>
@@ -43,6 +44,7 @@ typedef enum {
 	FORMAT_XDOT,
 	FORMAT_XDOT12,
 	FORMAT_XDOT14,
+	FORMAT_GVBIN,
 } format_type;
 
 #define XDOTVERSION "1.7"
@@ -52,18 +54,19 @@ typedef enum {
  * However, only the first NUMXBUFS are distinct. Nodes, clusters, and
  * edges are drawn atomically, so they share the DRAW and LABEL buffers
  */
-static agxbuf xbuf[NUMXBUFS];
-static agxbuf* xbufs[] = {
-    xbuf+EMIT_GDRAW, xbuf+EMIT_CDRAW, xbuf+EMIT_TDRAW, xbuf+EMIT_HDRAW, 
-    xbuf+EMIT_GLABEL, xbuf+EMIT_CLABEL, xbuf+EMIT_TLABEL, xbuf+EMIT_HLABEL, 
-    xbuf+EMIT_CDRAW, xbuf+EMIT_CDRAW, xbuf+EMIT_CLABEL, xbuf+EMIT_CLABEL, 
+static TLS agxbuf xbuf[NUMXBUFS];
+static const emit_state_t xbufidx[] = {
+    EMIT_GDRAW, EMIT_CDRAW, EMIT_TDRAW, EMIT_HDRAW,
+    EMIT_GLABEL, EMIT_CLABEL, EMIT_TLABEL, EMIT_HLABEL,
+    EMIT_CDRAW, EMIT_CDRAW, EMIT_CLABEL, EMIT_CLABEL,
 };
-static double penwidth [] = {
+#define xbufs(s) (xbuf + xbufidx[s])
+static TLS double penwidth [] = {
     1, 1, 1, 1,
     1, 1, 1, 1,
     1, 1, 1, 1,
 };
-static unsigned int textflags[EMIT_ELABEL+1];
+static TLS unsigned int textflags[EMIT_ELABEL+1];
 
 typedef struct {
     attrsym_t *g_draw;
@@ -80,7 +83,7 @@ typedef struct {
     unsigned short version;
     char* version_s;
 } xdot_state_t;
-static xdot_state_t* xd;
+static TLS xdot_state_t* xd;
 
 static void xdot_str_xbuf (agxbuf* xb, char* pfx, const char* s)
 {
@@ -90,7 +93,7 @@ static void xdot_str_xbuf (agxbuf* xb, char* pfx, const char* s)
 static void xdot_str (GVJ_t *job, char* pfx, const char* s)
 {   
     emit_state_t emit_state = job->obj->emit_state;
-    xdot_str_xbuf (xbufs[emit_state], pfx, s);
+    xdot_str_xbuf (xbufs(emit_state), pfx, s);
 }
 
 /* xdot_trim_zeros
@@ -157,15 +160,15 @@ static void xdot_points(GVJ_t *job, char c, pointf * A, int n)
     emit_state_t emit_state = job->obj->emit_state;
     int i;
 
-    agxbprint(xbufs[emit_state], "%c %d ", c, n);
+    agxbprint(xbufs(emit_state), "%c %d ", c, n);
     for (i = 0; i < n; i++)
-        xdot_point(xbufs[emit_state], A[i]);
+        xdot_point(xbufs(emit_state), A[i]);
 }
 
 static char*
 color2str (unsigned char rgba[4])
 {
-    static char buf [10];
+    static TLS char buf [10];
 
     if (rgba[3] == 0xFF)
 	snprintf(buf, sizeof(buf), "#%02x%02x%02x", rgba[0], rgba[1],  rgba[2]);
@@ -271,10 +274,10 @@ static void put_escaping_backslashes(Agobj_t* n, Agsym_t *sym, const char *value
 static void xdot_end_node(GVJ_t* job)
 {
     Agnode_t* n = job->obj->u.n; 
-    if (agxblen(xbufs[EMIT_NDRAW]))
-	agxset(n, xd->n_draw, agxbuse(xbufs[EMIT_NDRAW]));
-    if (agxblen(xbufs[EMIT_NLABEL]))
-	put_escaping_backslashes(&n->base, xd->n_l_draw, agxbuse(xbufs[EMIT_NLABEL]));
+    if (agxblen(xbufs(EMIT_NDRAW)))
+	agxset(n, xd->n_draw, agxbuse(xbufs(EMIT_NDRAW)));
+    if (agxblen(xbufs(EMIT_NLABEL)))
+	put_escaping_backslashes(&n->base, xd->n_l_draw, agxbuse(xbufs(EMIT_NLABEL)));
     penwidth[EMIT_NDRAW] = 1;
     penwidth[EMIT_NLABEL] = 1;
     textflags[EMIT_NDRAW] = 0;
@@ -285,18 +288,18 @@ static void xdot_end_edge(GVJ_t* job)
 {
     Agedge_t* e = job->obj->u.e; 
 
-    if (agxblen(xbufs[EMIT_EDRAW]))
-	agxset(e, xd->e_draw, agxbuse(xbufs[EMIT_EDRAW]));
-    if (agxblen(xbufs[EMIT_TDRAW]))
-	agxset(e, xd->t_draw, agxbuse(xbufs[EMIT_TDRAW]));
-    if (agxblen(xbufs[EMIT_HDRAW]))
-	agxset(e, xd->h_draw, agxbuse(xbufs[EMIT_HDRAW]));
-    if (agxblen(xbufs[EMIT_ELABEL]))
-	put_escaping_backslashes(&e->base, xd->e_l_draw, agxbuse(xbufs[EMIT_ELABEL]));
-    if (agxblen(xbufs[EMIT_TLABEL]))
-	agxset(e, xd->tl_draw, agxbuse(xbufs[EMIT_TLABEL]));
-    if (agxblen(xbufs[EMIT_HLABEL]))
-	agxset(e, xd->hl_draw, agxbuse(xbufs[EMIT_HLABEL]));
+    if (agxblen(xbufs(EMIT_EDRAW)))
+	agxset(e, xd->e_draw, agxbuse(xbufs(EMIT_EDRAW)));
+    if (agxblen(xbufs(EMIT_TDRAW)))
+	agxset(e, xd->t_draw, agxbuse(xbufs(EMIT_TDRAW)));
+    if (agxblen(xbufs(EMIT_HDRAW)))
+	agxset(e, xd->h_draw, agxbuse(xbufs(EMIT_HDRAW)));
+    if (agxblen(xbufs(EMIT_ELABEL)))
+	put_escaping_backslashes(&e->base, xd->e_l_draw, agxbuse(xbufs(EMIT_ELABEL)));
+    if (agxblen(xbufs(EMIT_TLABEL)))
+	agxset(e, xd->tl_draw, agxbuse(xbufs(EMIT_TLABEL)));
+    if (agxblen(xbufs(EMIT_HLABEL)))
+	agxset(e, xd->hl_draw, agxbuse(xbufs(EMIT_HLABEL)));
     penwidth[EMIT_EDRAW] = 1;
     penwidth[EMIT_ELABEL] = 1;
     penwidth[EMIT_TDRAW] = 1;
@@ -321,14 +324,14 @@ static void xdot_begin_anchor(GVJ_t * job, char *href, char *tooltip, char *targ
     emit_state_t emit_state = job->obj->emit_state;
     unsigned int flags = 0;
 
-    agxbput(xbufs[emit_state], "H ");
+    agxbput(xbufs(emit_state), "H ");
     if (href)
 	flags |= 1;
     if (tooltip)
 	flags |= 2;
     if (target)
 	flags |= 4;
-    agxbprint(xbufs[emit_state], "%d ", flags);
+    agxbprint(xbufs(emit_state), "%d ", flags);
     if (href)
 	xdot_str (job, "", href);
     if (tooltip)
@@ -341,7 +344,7 @@ static void xdot_end_anchor(GVJ_t * job)
 {
     emit_state_t emit_state = job->obj->emit_state;
 
-    agxbput(xbufs[emit_state], "H 0 ");
+    agxbput(xbufs(emit_state), "H 0 ");
 }
 #endif
 
@@ -349,9 +352,9 @@ static void xdot_end_cluster(GVJ_t * job)
 {
     Agraph_t* cluster_g = job->obj->u.sg;
 
-    agxset(cluster_g, xd->g_draw, agxbuse(xbufs[EMIT_CDRAW]));
+    agxset(cluster_g, xd->g_draw, agxbuse(xbufs(EMIT_CDRAW)));
     if (GD_label(cluster_g))
-	agxset(cluster_g, xd->g_l_draw, agxbuse(xbufs[EMIT_CLABEL]));
+	agxset(cluster_g, xd->g_l_draw, agxbuse(xbufs(EMIT_CLABEL)));
     penwidth[EMIT_CDRAW] = 1;
     penwidth[EMIT_CLABEL] = 1;
     textflags[EMIT_CDRAW] = 0;
@@ -475,6 +478,7 @@ static void dot_begin_graph(GVJ_t *job)
 
     switch (job->render.id) {
 	case FORMAT_DOT:
+	case FORMAT_GVBIN:
 	    attach_attrs(g);
 	    break;
 	case FORMAT_CANON:
@@ -499,13 +503,13 @@ static void xdot_end_graph(graph_t* g)
 {
     int i;
 
-    if (agxblen(xbufs[EMIT_GDRAW])) {
+    if (agxblen(xbufs(EMIT_GDRAW))) {
 	if (!xd->g_draw)
 	    xd->g_draw = safe_dcl(g, AGRAPH, "_draw_", "");
-	agxset(g, xd->g_draw, agxbuse(xbufs[EMIT_GDRAW]));
+	agxset(g, xd->g_draw, agxbuse(xbufs(EMIT_GDRAW)));
     }
     if (GD_label(g))
-	put_escaping_backslashes(&g->base, xd->g_l_draw, agxbuse(xbufs[EMIT_GLABEL]));
+	put_escaping_backslashes(&g->base, xd->g_l_draw, agxbuse(xbufs(EMIT_GLABEL)));
     agsafeset (g, "xdotversion", xd->version_s, "");
 
     for (i = 0; i < NUMXBUFS; i++)
@@ -517,13 +521,18 @@ static void xdot_end_graph(graph_t* g)
     textflags[EMIT_GLABEL] = 0;
 }
 
+static size_t gvbin_write(void *chan, const char *buf, size_t len)
+{
+    return gvwrite(chan, buf, len);
+}
+
 typedef int (*putstrfn) (void *chan, const char *str);
 typedef int (*flushfn) (void *chan);
 static void dot_end_graph(GVJ_t *job)
 {
     graph_t *g = job->obj->u.g;
     Agiodisc_t* io_save;
-    static Agiodisc_t io;
+    static TLS Agiodisc_t io;
 
     if (io.afread == NULL) {
 	io.afread = AgIoDisc.afread;
@@ -552,6 +561,10 @@ static void dot_end_graph(GVJ_t *job)
 	    if (!(job->flags & OUTPUT_NOT_REQUIRED))
 		agwrite(g, job);
 	    break;
+	case FORMAT_GVBIN:
+	    if (!(job->flags & OUTPUT_NOT_REQUIRED))
+		agwrite_binary(g, job, gvbin_write);
+	    break;
 	default:
 	    UNREACHABLE();
     }
@@ -567,9 +580,9 @@ static void xdot_textspan(GVJ_t * job, pointf p, textspan_t * span)
     char buf[BUFSIZ];
     int j;
     
-    agxbput(xbufs[emit_state], "F ");
+    agxbput(xbufs(emit_state), "F ");
     xdot_fmt_num(buf, sizeof(buf), span->font->size);
-    agxbput(xbufs[emit_state], buf);
+    agxbput(xbufs(emit_state), buf);
     xdot_str (job, "", span->font->name);
     xdot_pencolor(job);
 
@@ -593,17 +606,17 @@ static void xdot_textspan(GVJ_t * job, pointf p, textspan_t * span)
 	unsigned int mask = flag_masks[xd->version-15];
 	unsigned int bits = flags & mask;
 	if (textflags[emit_state] != bits) {
-	    agxbprint(xbufs[emit_state], "t %u ", bits);
+	    agxbprint(xbufs(emit_state), "t %u ", bits);
 	    textflags[emit_state] = bits;
 	}
     }
 
     p.y += span->yoffset_centerline;
-    agxbput(xbufs[emit_state], "T ");
-    xdot_point(xbufs[emit_state], p);
-    agxbprint(xbufs[emit_state], "%d ", j);
+    agxbput(xbufs(emit_state), "T ");
+    xdot_point(xbufs(emit_state), p);
+    agxbprint(xbufs(emit_state), "%d ", j);
     xdot_fmt_num(buf, sizeof(buf), span->size.x);
-    agxbput(xbufs[emit_state], buf);
+    agxbput(xbufs(emit_state), buf);
     xdot_str (job, "", span->str);
 }
 
@@ -690,15 +703,15 @@ static void xdot_ellipse(GVJ_t * job, pointf * A, int filled)
 	}
         else 
 	    xdot_fillcolor (job);
-        agxbput(xbufs[emit_state], "E ");
+        agxbput(xbufs(emit_state), "E ");
     }
     else
-        agxbput(xbufs[emit_state], "e ");
-    xdot_point(xbufs[emit_state], A[0]);
+        agxbput(xbufs(emit_state), "e ");
+    xdot_point(xbufs(emit_state), A[0]);
     xdot_fmt_num(buf, sizeof(buf), A[1].x - A[0].x);
-    agxbput(xbufs[emit_state], buf);
+    agxbput(xbufs(emit_state), buf);
     xdot_fmt_num(buf, sizeof(buf), A[1].y - A[0].y);
-    agxbput(xbufs[emit_state], buf);
+    agxbput(xbufs(emit_state), buf);
 }
 
 static void xdot_bezier(GVJ_t *job, pointf *A, int n, int filled) {
@@ -746,12 +759,12 @@ void core_loadimage_xdot(GVJ_t * job, usershape_t *us, boxf b, bool filled)
     emit_state_t emit_state = job->obj->emit_state;
     char buf[BUFSIZ];
     
-    agxbput(xbufs[emit_state], "I ");
-    xdot_point(xbufs[emit_state], b.LL);
+    agxbput(xbufs(emit_state), "I ");
+    xdot_point(xbufs(emit_state), b.LL);
     xdot_fmt_num(buf, sizeof(buf), b.UR.x - b.LL.x);
-    agxbput(xbufs[emit_state], buf);
+    agxbput(xbufs(emit_state), buf);
     xdot_fmt_num(buf, sizeof(buf), b.UR.y - b.LL.y);
-    agxbput(xbufs[emit_state], buf);
+    agxbput(xbufs(emit_state), buf);
     xdot_str (job, "", us->name);
 }
 
@@ -859,6 +872,13 @@ gvdevice_features_t device_features_dot = {
     {72.,72.},			/* default dpi */
 };
 
+gvdevice_features_t device_features_gvbin = {
+    GVDEVICE_BINARY_FORMAT,	/* flags */
+    {0.,0.},			/* default margin - points */
+    {0.,0.},			/* default page width, height - points */
+    {72.,72.},			/* default dpi */
+};
+
 gvplugin_installed_t gvrender_dot_types[] = {
     {FORMAT_DOT, "dot", 1, &dot_engine, &render_features_dot},
     {FORMAT_XDOT, "xdot", 1, &xdot_engine, &render_features_xdot},
@@ -874,5 +894,6 @@ gvplugin_installed_t gvdevice_dot_types[] = {
     {FORMAT_XDOT, "xdot:xdot", 1, NULL, &device_features_dot},
     {FORMAT_XDOT12, "xdot1.2:xdot", 1, NULL, &device_features_dot},
     {FORMAT_XDOT14, "xdot1.4:xdot", 1, NULL, &device_features_dot},
+    {FORMAT_GVBIN, "gvbin:dot", 1, NULL, &device_features_gvbin},
     {0, NULL, 0, NULL, NULL}
 };
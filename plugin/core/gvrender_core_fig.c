@@ -26,6 +26,7 @@
 #include <gvc/gvplugin_device.h>
 #include <gvc/gvio.h>
 #include <cgraph/agxbuf.h>
+#include <cgraph/tls.h>
 #include <cgraph/unreachable.h>
 #include <common/utils.h>
 #include <common/color.h>
@@ -57,8 +58,8 @@ static int figColorResolve(int *new, unsigned char r, unsigned char g,
   unsigned char b)
 {
 #define maxColors 256
-    static int top = 0;
-    static short red[maxColors], green[maxColors], blue[maxColors];
+    static TLS int top = 0;
+    static TLS short red[maxColors], green[maxColors], blue[maxColors];
     int c;
     int ct = -1;
     long rd, gd, bd, dist;
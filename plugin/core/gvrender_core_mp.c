@@ -21,6 +21,7 @@
 #include <io.h>
 #endif
 
+#include <cgraph/tls.h>
 #include <cgraph/unreachable.h>
 #include <common/macros.h>
 #include <common/const.h>
@@ -59,8 +60,8 @@ static int mpColorResolve(int *new, unsigned char r, unsigned char g,
   unsigned char b)
 {
 #define maxColors 256
-    static int top = 0;
-    static short red[maxColors], green[maxColors], blue[maxColors];
+    static TLS int top = 0;
+    static TLS short red[maxColors], green[maxColors], blue[maxColors];
     int c;
     int ct = -1;
     long rd, gd, bd, dist;
@@ -19,6 +19,7 @@
 #include <gvc/gvplugin_device.h>
 #include <gvc/gvio.h>
 #include <cgraph/agxbuf.h>
+#include <cgraph/tls.h>
 #include <common/utils.h>
 #include <common/color.h>
 #include <common/colorprocs.h>
@@ -307,8 +308,8 @@ static void pic_end_page(GVJ_t * job)
 
 static void pic_textspan(GVJ_t * job, pointf p, textspan_t * span)
 {
-    static char *lastname;
-    static int lastsize;
+    static TLS char *lastname;
+    static TLS int lastsize;
     int sz;
 
     switch (span->just) {
@@ -31,6 +31,7 @@
 
 #include <gvc/gvplugin_render.h>
 #include <cgraph/agxbuf.h>
+#include <cgraph/tls.h>
 #include <cgraph/unreachable.h>
 #include <common/utils.h>
 #include <gvc/gvplugin_device.h>
@@ -557,7 +558,7 @@ static void svg_print_stop(GVJ_t * job, double offset, gvcolor_t color)
 static int svg_gradstyle(GVJ_t * job, pointf * A, int n)
 {
     pointf G[2];
-    static int gradId;
+    static TLS int gradId;
     int id = gradId++;
 
     obj_state_t *obj = job->obj;
@@ -594,7 +595,7 @@ static int svg_gradstyle(GVJ_t * job, pointf * A, int n)
 static int svg_rgradstyle(GVJ_t * job)
 {
     double ifx, ify;
-    static int rgradId;
+    static TLS int rgradId;
     int id = rgradId++;
 
     obj_state_t *obj = job->obj;
@@ -18,6 +18,7 @@
 #include <string.h>
 #include <fcntl.h>
 #include <cgraph/alloc.h>
+#include <cgraph/tls.h>
 #include <cgraph/unreachable.h>
 #include <gvc/gvplugin_render.h>
 #include <gvc/gvplugin_device.h>
@@ -61,7 +62,7 @@ static void gdgen_resolve_color(GVJ_t * job, gvcolor_t * color)
     color->type = COLOR_INDEX;
 }
 
-static int transparent, basecolor;
+static TLS int transparent, basecolor;
 
 #define GD_XYMAX INT32_MAX
 
@@ -466,8 +467,8 @@ gdgen_bezier(GVJ_t *job, pointf *A, int n, int filled) {
 	gdImageDestroy(brush);
 }
 
-static gdPoint *points;
-static size_t points_allocated;
+static TLS gdPoint *points;
+static TLS size_t points_allocated;
 
 static void gdgen_polygon(GVJ_t * job, pointf * A, int n, int filled)
 {
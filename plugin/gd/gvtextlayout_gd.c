@@ -18,6 +18,7 @@
 #include <gvc/gvplugin_textlayout.h>
 #include <gd.h>
 #include <cgraph/strcasecmp.h>
+#include <cgraph/tls.h>
 
 #ifdef HAVE_GD_FREETYPE
 
@@ -90,7 +91,7 @@ char *gd_alternate_fontlist(const char *font) {
 
 char* gd_psfontResolve (PostscriptAlias* pa)
 {
-    static char buf[1024];
+    static TLS char buf[1024];
     int comma=0;
     strcpy(buf, pa->family);
 
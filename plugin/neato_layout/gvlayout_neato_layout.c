@@ -52,16 +52,18 @@ extern void osage_cleanup(graph_t * g);
 
 static void nop1_layout(graph_t * g)
 {
-    Nop = 1;
+    layout_context_t *const lctx = gvLayoutContext();
+    lctx->Nop = 1;
     neato_layout(g);
-    Nop = 0;
+    lctx->Nop = 0;
 }
 
 static void nop2_layout(graph_t * g)
 {
-    Nop = 2;
+    layout_context_t *const lctx = gvLayoutContext();
+    lctx->Nop = 2;
     neato_layout(g);
-    Nop = 0;
+    lctx->Nop = 0;
 }
 
 gvlayout_engine_t neatogen_engine = {
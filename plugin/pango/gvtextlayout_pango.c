@@ -18,6 +18,7 @@
 #include <gvc/gvplugin_render.h>
 #include <cgraph/agxbuf.h>
 #include <cgraph/alloc.h>
+#include <cgraph/tls.h>
 #include <common/utils.h>
 #include <gvc/gvplugin_textlayout.h>
 
@@ -34,7 +35,7 @@ static void pango_free_layout (void *layout)
 
 static char* pango_psfontResolve (PostscriptAlias* pa)
 {
-    static char buf[1024];
+    static TLS char buf[1024];
     strcpy(buf, pa->family);
     strcat(buf, ",");
     if (pa->weight) {
@@ -66,13 +67,13 @@ static int agxbput_int(void *buffer, const char *s) {
 
 static bool pango_textlayout(textspan_t * span, char **fontpath)
 {
-    static char buf[1024];  /* returned in fontpath, only good until next call */
-    static PangoFontMap *fontmap;
-    static PangoContext *context;
-    static PangoFontDescription *desc;
-    static char *fontname;
-    static double fontsize;
-    static gv_font_map* gv_fmap;
+    static TLS char buf[1024];  /* returned in fontpath, only good until next call */
+    static TLS PangoFontMap *fontmap;
+    static TLS PangoContext *context;
+    static TLS PangoFontDescription *desc;
+    static TLS char *fontname;
+    static TLS double fontsize;
+    static TLS gv_font_map* gv_fmap;
     char *fnt, *psfnt = NULL;
     PangoLayout *layout;
     PangoRectangle logical_rect;
@@ -220,6 +220,7 @@ void listEdgeAttrs (Tcl_Interp * interp, Agraph_t* g)
 
 void tcldot_layout(GVC_t *gvc, Agraph_t * g, char *engine)
 {
+    layout_context_t *const lctx = gvLayoutContext();
     char buf[256];
     Agsym_t *a;
     int rc;
@@ -235,8 +236,8 @@ void tcldot_layout(GVC_t *gvc, Agraph_t * g, char *engine)
     }
     else {
 	if (strcasecmp(engine, "nop") == 0) {
-	    Nop = 2;
-	    PSinputscale = POINTS_PER_INCH;
+	    lctx->Nop = 2;
+	    lctx->PSinputscale = POINTS_PER_INCH;
 	    rc = gvlayout_select(gvc, "neato");
 	}
 	else {
@@ -0,0 +1,129 @@
+/* building and closing graphs with the arena memory discipline
+ * (see test_cgraph.py:test_agarena())
+ *
+ * usage: agarena [nodes edges]
+ *
+ * The same pseudo-random graph, with some attributes and subgraphs, is built
+ * with the default and arena memory disciplines, and the program fails unless
+ * both write out the same. Subgraphs with internal names, which open the maps
+ * of internal names, are created in both, and one is closed before the graph
+ * is, so closing a subgraph and the root graph both close those maps.
+ */
+
+#include <graphviz/cgraph.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static uint64_t rand_state;
+
+/// a deterministic xorshift generator, so both disciplines see the same graph
+static uint64_t next_rand(void) {
+  rand_state ^= rand_state << 13;
+  rand_state ^= rand_state >> 7;
+  rand_state ^= rand_state << 17;
+  return rand_state;
+}
+
+static Agraph_t *build(Agdisc_t *disc, size_t nnodes, size_t nedges) {
+  rand_state = 1;
+
+  Agraph_t *g = agopen("G", Agdirected, disc);
+  Agsym_t *label = agattr(g, AGNODE, "label", "");
+  Agsym_t *weight = agattr(g, AGEDGE, "weight", "1");
+  Agraph_t *half = agsubg(g, "half", 1);
+  Agraph_t *kept = agsubg(g, "%kept", 1);
+
+  Agnode_t **nodes = calloc(nnodes, sizeof(Agnode_t *));
+  if (nodes == NULL) {
+    fprintf(stderr, "out of memory\n");
+    exit(EXIT_FAILURE);
+  }
+  for (size_t i = 0; i < nnodes; ++i) {
+    char name[32];
+    snprintf(name, sizeof(name), "n%zu", i);
+    nodes[i] = agnode(g, name, 1);
+    if (i % 3 == 0)
+      agxset(nodes[i], label, name);
+    if (i % 2 == 0)
+      agsubnode(half, nodes[i], 1);
+    if (i % 100 == 0)
+      agsubnode(kept, nodes[i], 1);
+  }
+  for (size_t i = 0; i < nedges; ++i) {
+    Agnode_t *t = nodes[next_rand() % nnodes];
+    Agnode_t *h = nodes[next_rand() % nnodes];
+    Agedge_t *e = agedge(g, t, h, NULL, 1);
+    if (i % 5 == 0) {
+      char w[32];
+      snprintf(w, sizeof(w), "%zu", i % 7 + 2);
+      agxset(e, weight, w);
+    }
+  }
+  free(nodes);
+
+  // a subgraph with an internal name, closed before the graph
+  Agraph_t *scratch = agsubg(g, "%scratch", 1);
+  agsubnode(scratch, agfstnode(g), 1);
+  agclose(scratch);
+
+  return g;
+}
+
+/// write a graph to a temporary file and return its contents
+static char *contents(Agraph_t *g) {
+  FILE *f = tmpfile();
+  if (f == NULL) {
+    perror("tmpfile");
+    exit(EXIT_FAILURE);
+  }
+  agwrite(g, f);
+  const long size = ftell(f);
+  char *text = calloc((size_t)size + 1, 1);
+  rewind(f);
+  if (text == NULL || fread(text, 1, (size_t)size, f) != (size_t)size) {
+    fprintf(stderr, "failed to read back the graph\n");
+    exit(EXIT_FAILURE);
+  }
+  fclose(f);
+  return text;
+}
+
+int main(int argc, char **argv) {
+
+  size_t nnodes = 1000;
+  size_t nedges = 5000;
+  if (argc == 3) {
+    nnodes = strtoul(argv[1], NULL, 10);
+    nedges = strtoul(argv[2], NULL, 10);
+  }
+  if ((argc != 1 && argc != 3) || nnodes == 0) {
+    fprintf(stderr, "usage: %s [nodes edges]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  Agraph_t *expected = build(&AgDefaultDisc, nnodes, nedges);
+  Agraph_t *arena = build(&AgArenaDisc, nnodes, nedges);
+
+  if (agnnodes(arena) != agnnodes(expected) ||
+      agnedges(arena) != agnedges(expected) || agnsubg(arena) != 2) {
+    fprintf(stderr, "arena graph has %d nodes, %d edges and %d subgraphs\n",
+            agnnodes(arena), agnedges(arena), agnsubg(arena));
+    return EXIT_FAILURE;
+  }
+
+  char *want = contents(expected);
+  char *got = contents(arena);
+  if (strcmp(want, got) != 0) {
+    fprintf(stderr, "arena discipline produced a different graph\n");
+    return EXIT_FAILURE;
+  }
+  free(want);
+  free(got);
+
+  agclose(expected);
+  agclose(arena);
+
+  return EXIT_SUCCESS;
+}
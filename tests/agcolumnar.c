@@ -0,0 +1,224 @@
+/* graphs storing node and edge attributes by object or by attribute
+ * (see test_cgraph.py:test_agcolumnar())
+ *
+ * usage: agcolumnar [file...]
+ *
+ * A pseudo-random graph with many node attributes, a subgraph with its own
+ * defaults, a change of default part way through, renumbered and deleted nodes
+ * and values set back to their defaults is built in both stores, and the
+ * program fails unless both write out the same and the columnar one allocates
+ * less. Each file given is also parsed both ways, into a columnar graph through
+ * agconcat, and the two must write out the same.
+ */
+
+#include <graphviz/cgraph.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static size_t allocated;
+
+/// a memory discipline counting the bytes a graph asks for
+///
+/// Frees are not counted, as they do not say how big the block was.
+
+static void *count_open(Agdisc_t *disc) {
+  (void)disc;
+  return NULL;
+}
+
+static void *count_alloc(void *heap, size_t request) {
+  (void)heap;
+  allocated += request;
+  return calloc(1, request);
+}
+
+static void *count_resize(void *heap, void *ptr, size_t oldsize,
+                          size_t request) {
+  (void)heap;
+  char *p = realloc(ptr, request);
+  if (p == NULL)
+    return NULL;
+  if (request > oldsize) {
+    memset(p + oldsize, 0, request - oldsize);
+    allocated += request - oldsize;
+  }
+  return p;
+}
+
+static void count_free(void *heap, void *ptr) {
+  (void)heap;
+  free(ptr);
+}
+
+static Agmemdisc_t CountMemDisc = {count_open, count_alloc, count_resize,
+                                   count_free, NULL};
+static Agdisc_t CountDisc = {&CountMemDisc, &AgIdDisc, &AgIoDisc};
+
+static uint64_t rand_state;
+
+/// a deterministic xorshift generator, so both stores see the same graph
+static uint64_t next_rand(void) {
+  rand_state ^= rand_state << 13;
+  rand_state ^= rand_state >> 7;
+  rand_state ^= rand_state << 17;
+  return rand_state;
+}
+
+static Agraph_t *build(Agdesc_t desc, size_t nnodes, size_t nedges) {
+  Agraph_t *g = agopen("G", desc, &CountDisc);
+
+  // many declared node attributes, as layouts produce
+  static const char *declared[] = {
+      "color",  "fillcolor", "fontcolor", "fontname", "fontsize", "height",
+      "width",  "label",     "penwidth",  "peripheries", "pos",   "rects",
+      "shape",  "sides",     "skew",      "style",    "tooltip", "xlabel",
+      "group",  "ordering"};
+  for (size_t i = 0; i < sizeof(declared) / sizeof(declared[0]); ++i)
+    agattr(g, AGNODE, (char *)declared[i], "");
+  Agsym_t *label = agattr(g, AGNODE, "label", NULL);
+  Agsym_t *pos = agattr(g, AGNODE, "pos", NULL);
+  Agsym_t *weight = agattr(g, AGEDGE, "weight", "1");
+
+  // a subgraph whose nodes take a local default
+  Agraph_t *half = agsubg(g, "half", 1);
+  agattr(half, AGNODE, "color", "red");
+
+  Agnode_t **nodes = calloc(nnodes, sizeof(Agnode_t *));
+  if (nodes == NULL) {
+    fprintf(stderr, "out of memory\n");
+    exit(EXIT_FAILURE);
+  }
+  for (size_t i = 0; i < nnodes; ++i) {
+    char name[32];
+    snprintf(name, sizeof(name), "n%zu", i);
+    if (i == nnodes / 2)
+      agattr(g, AGNODE, "shape", "box");
+    nodes[i] = agnode(i % 4 == 0 ? half : g, name, 1);
+    if (i % 3 == 0)
+      agxset(nodes[i], label, name);
+    if (i % 50 == 0) {
+      snprintf(name, sizeof(name), "%zu,%zu", i, i * 2);
+      agxset(nodes[i], pos, name);
+    }
+  }
+  // renumber some nodes, which moves their values
+  if (nnodes > 2)
+    agnodebefore(nodes[1], nodes[nnodes - 1]);
+
+  for (size_t i = 0; i < nedges; ++i) {
+    Agnode_t *t = nodes[next_rand() % nnodes];
+    Agnode_t *h = nodes[next_rand() % nnodes];
+    Agedge_t *e = agedge(g, t, h, NULL, 1);
+    if (i % 5 == 0) {
+      char w[32];
+      snprintf(w, sizeof(w), "%zu", i % 7 + 2);
+      agxset(e, weight, w);
+    }
+  }
+
+  // set some values back to their defaults and delete some nodes
+  for (size_t i = 0; i < nnodes; i += 6)
+    agxset(nodes[i], label, "");
+  for (size_t i = 7; i < nnodes; i += 10)
+    agdelnode(g, nodes[i]);
+  free(nodes);
+
+  return g;
+}
+
+/// write a graph to a temporary file and return its contents
+static char *contents(Agraph_t *g) {
+  FILE *f = tmpfile();
+  if (f == NULL) {
+    perror("tmpfile");
+    exit(EXIT_FAILURE);
+  }
+  agwrite(g, f);
+  const long size = ftell(f);
+  char *text = calloc((size_t)size + 1, 1);
+  rewind(f);
+  if (text == NULL || fread(text, 1, (size_t)size, f) != (size_t)size) {
+    fprintf(stderr, "failed to read back the graph\n");
+    exit(EXIT_FAILURE);
+  }
+  fclose(f);
+  return text;
+}
+
+/// fail unless two graphs write out the same, and close them
+static void compare(const char *what, Agraph_t *rows, Agraph_t *columns) {
+  char *want = contents(rows);
+  char *got = contents(columns);
+  if (strcmp(want, got) != 0) {
+    fprintf(stderr, "%s: columnar attributes produced a different graph\n",
+            what);
+    exit(EXIT_FAILURE);
+  }
+  free(want);
+  free(got);
+  agclose(rows);
+  agclose(columns);
+}
+
+/// parse a file into a graph of each store
+static void parse(const char *file) {
+  FILE *f = fopen(file, "r");
+  if (f == NULL) {
+    perror(file);
+    exit(EXIT_FAILURE);
+  }
+  agsetfile(file);
+  Agraph_t *rows = agread(f, NULL);
+  if (rows == NULL) {
+    fprintf(stderr, "%s: failed to parse\n", file);
+    exit(EXIT_FAILURE);
+  }
+
+  // parse the file again into a columnar graph of the same kind
+  Agdesc_t desc = {.directed = agisdirected(rows), .strict = agisstrict(rows),
+                   .maingraph = 1, .columnar = 1};
+  Agraph_t *columns = agopen(agnameof(rows), desc, NULL);
+  rewind(f);
+  agsetfile(file);
+  columns = agconcat(columns, f, NULL);
+  fclose(f);
+  if (columns == NULL) {
+    fprintf(stderr, "%s: failed to parse into a columnar graph\n", file);
+    exit(EXIT_FAILURE);
+  }
+
+  compare(file, rows, columns);
+}
+
+int main(int argc, char **argv) {
+
+  size_t bytes[2];
+  Agraph_t *g[2];
+  for (int columns = 0; columns < 2; ++columns) {
+    Agdesc_t desc = Agdirected;
+    desc.columnar = columns;
+    rand_state = 1;
+    allocated = 0;
+    g[columns] = build(desc, 1000, 5000);
+    bytes[columns] = allocated;
+  }
+  if (agnnodes(g[1]) != 900 || agnedges(g[1]) != 4041) {
+    fprintf(stderr, "columnar graph has %d nodes and %d edges\n",
+            agnnodes(g[1]), agnedges(g[1]));
+    return EXIT_FAILURE;
+  }
+  if (bytes[1] >= bytes[0]) {
+    fprintf(stderr, "columnar graph allocated %zu bytes, rather than less than "
+            "%zu\n", bytes[1], bytes[0]);
+    return EXIT_FAILURE;
+  }
+  compare("generated graph", g[0], g[1]);
+
+  for (int i = 1; i < argc; ++i)
+    parse(argv[i]);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,174 @@
+/* adjacency snapshots of graphs and subgraphs
+ * (see test_cgraph.py:test_agcsr())
+ *
+ * Checks that agcsr lists the nodes and edges of a graph and its subgraphs as
+ * the iteration functions visit them, before and after the graph changes and
+ * after snapshots are freed, and that the neighbor indices a snapshot gives
+ * agree with those gathered through agfstedge/agnxtedge.
+ */
+
+#include <assert.h>
+#include <graphviz/cgraph.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef NDEBUG
+#error this is not intended to be compiled with assertions off
+#endif
+
+static uint64_t rand_state = 1;
+
+/// a deterministic xorshift generator
+static uint64_t next_rand(void) {
+  rand_state ^= rand_state << 13;
+  rand_state ^= rand_state >> 7;
+  rand_state ^= rand_state << 17;
+  return rand_state;
+}
+
+/// check a snapshot of `g` against the iteration functions
+static void check_csr(Agraph_t *g) {
+  const Agcsr_t *csr = agcsr(g);
+  assert(csr != NULL);
+  assert(csr->nnodes == agnnodes(g));
+  assert(csr->nedges == agnedges(g));
+
+  int i = 0;
+  for (Agnode_t *n = agfstnode(g); n; n = agnxtnode(g, n), ++i) {
+    assert(csr->node[i] == n);
+    assert(agcsrindex(csr, n) == i);
+
+    int k = csr->out[i];
+    for (Agedge_t *e = agfstout(g, n); e; e = agnxtout(g, e), ++k) {
+      assert(k < csr->out[i + 1]);
+      assert(csr->outedge[k] == e);
+      assert(csr->node[csr->head[k]] == aghead(e));
+    }
+    assert(k == csr->out[i + 1]);
+
+    k = csr->in[i];
+    for (Agedge_t *e = agfstin(g, n); e; e = agnxtin(g, e), ++k) {
+      assert(k < csr->in[i + 1]);
+      assert(csr->inedge[k] == e);
+      assert(csr->node[csr->tail[k]] == agtail(e));
+    }
+    assert(k == csr->in[i + 1]);
+  }
+  assert(i == csr->nnodes);
+}
+
+static void check_snapshots(void) {
+  Agraph_t *g = agopen("G", Agdirected, NULL);
+  Agraph_t *sg = agsubg(g, "sg", 1);
+  Agnode_t *nodes[20];
+  for (int i = 0; i < 20; ++i) {
+    char name[16];
+    snprintf(name, sizeof(name), "n%d", i);
+    nodes[i] = agnode(i % 3 == 0 ? sg : g, name, 1);
+  }
+  for (int i = 0; i < 60; ++i)
+    (void)agedge(g, nodes[next_rand() % 20], nodes[next_rand() % 20], NULL, 1);
+  (void)agedge(sg, nodes[0], nodes[3], NULL, 1);
+  (void)agedge(sg, nodes[3], nodes[3], NULL, 1);
+  check_csr(g);
+  check_csr(sg);
+
+  // an unchanged graph keeps its snapshot
+  const Agcsr_t *csr = agcsr(g);
+  assert(agcsr(g) == csr);
+
+  // nodes outside a subgraph are not in its snapshot
+  assert(agcsrindex(agcsr(sg), nodes[1]) == -1);
+  assert(agcsrindex(agcsr(sg), nodes[3]) >= 0);
+
+  // changes anywhere are seen everywhere
+  (void)agedge(sg, nodes[6], nodes[9], NULL, 1);
+  check_csr(g);
+  check_csr(sg);
+  agdelnode(g, nodes[3]);
+  check_csr(g);
+  check_csr(sg);
+  agdeledge(g, agfstout(g, nodes[0]));
+  check_csr(g);
+  check_csr(sg);
+  agnodebefore(nodes[12], nodes[1]);
+  check_csr(g);
+  check_csr(sg);
+
+  // freed snapshots are built again
+  agcsrfree(sg);
+  agcsrfree(sg);
+  check_csr(sg);
+  agcsrfree(g);
+  check_csr(g);
+
+  // a subgraph of a few nodes far apart in a large graph
+  Agraph_t *few = agsubg(g, "few", 1);
+  for (int i = 0; i < 1000; ++i) {
+    char name[16];
+    snprintf(name, sizeof(name), "m%d", i);
+    Agnode_t *n = agnode(g, name, 1);
+    if (i % 256 == 0)
+      agsubnode(few, n, 1);
+  }
+  (void)agedge(few, agfstnode(few), aglstnode(few), NULL, 1);
+  check_csr(few);
+  check_csr(g);
+  assert(agcsrindex(agcsr(few), nodes[0]) == -1);
+
+  agclose(g);
+}
+
+/// sum the neighbor indices of every node through the graph and through a
+/// snapshot, as a layout's conversion would gather them
+static void check_neighbors(size_t nnodes, size_t nedges) {
+  Agraph_t *g = agopen("G", Agdirected, NULL);
+  Agnode_t **nodes = calloc(nnodes, sizeof(Agnode_t *));
+  assert(nodes != NULL);
+  for (size_t i = 0; i < nnodes; ++i) {
+    char name[32];
+    snprintf(name, sizeof(name), "n%zu", i);
+    nodes[i] = agnode(g, name, 1);
+  }
+  for (size_t i = 0; i < nedges; ++i)
+    (void)agedge(g, nodes[next_rand() % nnodes], nodes[next_rand() % nnodes],
+                 NULL, 1);
+  free(nodes);
+
+  int *index = calloc((size_t)agnnodes(g) + 1, sizeof(int));
+  assert(index != NULL);
+  uint64_t total = 0;
+  int i = 0;
+  for (Agnode_t *n = agfstnode(g); n; n = agnxtnode(g, n))
+    index[AGSEQ(n)] = i++;
+  for (Agnode_t *n = agfstnode(g); n; n = agnxtnode(g, n)) {
+    for (Agedge_t *e = agfstedge(g, n); e; e = agnxtedge(g, e, n)) {
+      Agnode_t *other = agtail(e) == n ? aghead(e) : agtail(e);
+      total += (uint64_t)index[AGSEQ(other)];
+    }
+  }
+  free(index);
+
+  uint64_t sum = 0;
+  const Agcsr_t *csr = agcsr(g);
+  for (i = 0; i < csr->nnodes; ++i) {
+    for (int k = csr->out[i]; k < csr->out[i + 1]; ++k)
+      sum += (uint64_t)csr->head[k];
+    for (int k = csr->in[i]; k < csr->in[i + 1]; ++k) {
+      if (csr->tail[k] != i)
+        sum += (uint64_t)csr->tail[k];
+    }
+  }
+  assert(sum == total);
+
+  agclose(g);
+}
+
+int main(void) {
+
+  check_snapshots();
+  check_neighbors(10000, 50000);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,178 @@
+/* finding edges through a hash index of their endpoints
+ * (see test_cgraph.py:test_agedgeindex())
+ *
+ * Checks that agedge finds the same edges in graphs with and without an
+ * edge index as edges and nodes come and go, that strict star graphs, directed
+ * towards the hub and undirected, keep one edge per spoke when their edges are
+ * asked for again with and without the index, and that parsing a strict graph
+ * indexes it.
+ */
+
+#include <assert.h>
+#include <graphviz/cgraph.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef NDEBUG
+#error this is not intended to be compiled with assertions off
+#endif
+
+static uint64_t rand_state = 1;
+
+/// a deterministic xorshift generator
+static uint64_t next_rand(void) {
+  rand_state ^= rand_state << 13;
+  rand_state ^= rand_state >> 7;
+  rand_state ^= rand_state << 17;
+  return rand_state;
+}
+
+enum { NODES = 30 };
+
+/// does `g` hold the same edges between the same nodes as `ref`?
+static void check_same(Agraph_t *ref, Agnode_t **rn, Agraph_t *g,
+                       Agnode_t **n) {
+  for (int i = 0; i < NODES; ++i) {
+    for (int j = 0; j < NODES; ++j) {
+      if (rn[i] == NULL) {
+        assert(n[i] == NULL);
+        continue;
+      }
+      if (rn[j] == NULL)
+        continue;
+      Agedge_t *a = agedge(ref, rn[i], rn[j], NULL, 0);
+      Agedge_t *b = agedge(g, n[i], n[j], NULL, 0);
+      assert((a == NULL) == (b == NULL));
+      if (b != NULL) {
+        assert(agtail(b) == n[i] && aghead(b) == n[j]);
+        assert(AGTYPE(a) == AGTYPE(b));
+      }
+      a = agedge(ref, rn[i], rn[j], "key", 0);
+      b = agedge(g, n[i], n[j], "key", 0);
+      assert((a == NULL) == (b == NULL));
+      assert(b == NULL || strcmp(agnameof(b), "key") == 0);
+    }
+  }
+}
+
+static void check_lookups(void) {
+  Agraph_t *g[2];
+  Agraph_t *sg[2];
+  Agnode_t *n[2][NODES];
+  for (int k = 0; k < 2; ++k) {
+    g[k] = agopen("G", Agdirected, NULL);
+    assert(agedgeindex(g[k], k) == 0);
+    sg[k] = agsubg(g[k], "sg", 1);
+    (void)agedgeindex(sg[k], k);
+    for (int i = 0; i < NODES; ++i) {
+      char name[16];
+      snprintf(name, sizeof(name), "n%d", i);
+      n[k][i] = agnode(g[k], name, 1);
+    }
+  }
+  assert(agedgeindex(g[1], 1) == 1);
+
+  // the same random multigraph in both, some edges named and some in the
+  // subgraph
+  for (int i = 0; i < 400; ++i) {
+    const int t = (int)(next_rand() % NODES);
+    const int h = (int)(next_rand() % NODES);
+    const int named = next_rand() % 5 == 0;
+    const int sub = next_rand() % 3 == 0;
+    for (int k = 0; k < 2; ++k)
+      (void)agedge(sub ? sg[k] : g[k], n[k][t], n[k][h], named ? "key" : NULL,
+                   1);
+  }
+  check_same(g[0], n[0], g[1], n[1]);
+  check_same(sg[0], n[0], sg[1], n[1]);
+
+  // delete some edges and nodes
+  for (int i = 0; i < 100; ++i) {
+    const int t = (int)(next_rand() % NODES);
+    if (n[0][t] == NULL)
+      continue;
+    // which of several edges between two nodes agedge finds differs, so pick
+    // the same one in both graphs by creation order
+    for (int k = 0; k < 2; ++k) {
+      Agedge_t *e = agfstout(g[k], n[k][t]);
+      if (e != NULL)
+        agdeledge(g[k], e);
+    }
+    if (i % 10 == 0) {
+      for (int k = 0; k < 2; ++k) {
+        agdelnode(g[k], n[k][t]);
+        n[k][t] = NULL;
+      }
+    }
+  }
+  check_same(g[0], n[0], g[1], n[1]);
+  check_same(sg[0], n[0], sg[1], n[1]);
+
+  // dropping the index and indexing an existing graph change nothing
+  assert(agedgeindex(sg[1], 0) == 1);
+  check_same(sg[0], n[0], sg[1], n[1]);
+  assert(agedgeindex(g[0], 1) == 0);
+  check_same(g[1], n[1], g[0], n[0]);
+
+  agclose(g[0]);
+  agclose(g[1]);
+}
+
+/// build a strict star, then ask for its edges again in a random order, as
+/// input repeating edges would
+static void star(size_t spokes, Agdesc_t desc, int indexed) {
+  Agnode_t **spoke = calloc(spokes, sizeof(Agnode_t *));
+  assert(spoke != NULL);
+  Agraph_t *g = agopen("star", desc, NULL);
+  (void)agedgeindex(g, indexed);
+  Agnode_t *hub = agnode(g, "hub", 1);
+  for (size_t i = 0; i < spokes; ++i) {
+    char name[32];
+    snprintf(name, sizeof(name), "s%zu", i);
+    spoke[i] = agnode(g, name, 1);
+    (void)agedge(g, spoke[i], hub, NULL, 1);
+  }
+  for (size_t i = 0; i < spokes; ++i) {
+    Agnode_t *s = spoke[next_rand() % spokes];
+    // undirected edges are found from either end
+    Agedge_t *e = desc.directed || i % 2 ? agedge(g, s, hub, NULL, 1)
+                                         : agedge(g, hub, s, NULL, 1);
+    assert(e != NULL && agtail(e) == s && aghead(e) == hub);
+  }
+  assert((size_t)agnedges(g) == spokes);
+  agclose(g);
+  free(spoke);
+}
+
+/// parse a strict star, which should be indexed
+static void parsed_star(size_t spokes) {
+  size_t size = 64 + 24 * spokes;
+  char *text = malloc(size);
+  assert(text != NULL);
+  size_t len = (size_t)snprintf(text, size, "strict digraph {\n");
+  for (size_t i = 0; i < spokes; ++i)
+    len += (size_t)snprintf(text + len, size - len, "s%zu -> hub\n", i);
+  for (size_t i = 0; i < spokes; i += 3)
+    len += (size_t)snprintf(text + len, size - len, "s%zu -> hub\n", i);
+  (void)snprintf(text + len, size - len, "}\n");
+  Agraph_t *g = agmemread(text);
+  assert(g != NULL && (size_t)agnedges(g) == spokes);
+  assert(agedgeindex(g, 1) == 1);
+  agclose(g);
+  free(text);
+}
+
+int main(void) {
+
+  check_lookups();
+
+  for (int indexed = 0; indexed < 2; ++indexed) {
+    star(2000, Agstrictdirected, indexed);
+    star(2000, Agstrictundirected, indexed);
+  }
+  parsed_star(2000);
+
+  return EXIT_SUCCESS;
+}
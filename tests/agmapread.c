@@ -0,0 +1,177 @@
+/* reading graphs through a memory mapping
+ * (see test_cgraph.py:test_agmapread() and test_gvbin())
+ *
+ * usage: agmapread file [snapshot]
+ *
+ * The graphs in the file are read both through stdio and through a memory
+ * mapping, and the program fails unless the two agree. If a snapshot path is
+ * given, binary snapshots of the graphs are written there with agwrite_binary,
+ * mapped back and compared with the graphs read from the file in the same way.
+ */
+
+#include <graphviz/cgraph.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *input;
+
+static void fail(const char *fmt, ...) {
+  va_list ap;
+  va_start(ap, fmt);
+  fprintf(stderr, "%s: ", input);
+  vfprintf(stderr, fmt, ap);
+  fprintf(stderr, "\n");
+  va_end(ap);
+  exit(EXIT_FAILURE);
+}
+
+static bool streq(const char *a, const char *b) {
+  if (a == NULL || b == NULL)
+    return a == b;
+  return strcmp(a, b) == 0;
+}
+
+/// compare the attribute values of two corresponding objects
+static void compare_attrs(void *a, void *b) {
+  const int kind = AGTYPE(a);
+  Agraph_t *ga = agraphof(a);
+  Agraph_t *gb = agraphof(b);
+  for (Agsym_t *sa = agnxtattr(ga, kind, NULL); sa != NULL;
+       sa = agnxtattr(ga, kind, sa)) {
+    Agsym_t *sb = agattr(gb, kind, sa->name, NULL);
+    if (sb == NULL)
+      fail("attribute %s is missing", sa->name);
+    const char *va = agxget(a, sa);
+    const char *vb = agxget(b, sb);
+    if (!streq(va, vb) || aghtmlstr((char *)va) != aghtmlstr((char *)vb))
+      fail("attribute %s differs: \"%s\" vs \"%s\"", sa->name, va, vb);
+  }
+}
+
+/// is this an anonymous subgraph, named internally?
+static bool anonymous(Agraph_t *g) { return agnameof(g)[0] == '%'; }
+
+/// fail unless two graphs have the same attributes, subgraphs, nodes and edges
+static void compare(Agraph_t *a, Agraph_t *b) {
+  if (!anonymous(a) && !streq(agnameof(a), agnameof(b)))
+    fail("graph %s is read as %s", agnameof(a), agnameof(b));
+  if (agisdirected(a) != agisdirected(b) || agisstrict(a) != agisstrict(b))
+    fail("graph %s changes kind", agnameof(a));
+  compare_attrs(a, b);
+
+  // named subgraphs are found by name, and anonymous ones by their order
+  if (agnsubg(a) != agnsubg(b))
+    fail("graph %s has %d subgraphs rather than %d", agnameof(a), agnsubg(b),
+         agnsubg(a));
+  Agraph_t *anon = agfstsubg(b);
+  for (Agraph_t *sa = agfstsubg(a); sa != NULL; sa = agnxtsubg(sa)) {
+    Agraph_t *sb;
+    if (anonymous(sa)) {
+      while (anon != NULL && !anonymous(anon))
+        anon = agnxtsubg(anon);
+      sb = anon;
+      if (anon != NULL)
+        anon = agnxtsubg(anon);
+    } else {
+      sb = agsubg(b, agnameof(sa), 0);
+    }
+    if (sb == NULL)
+      fail("subgraph %s is missing", agnameof(sa));
+    compare(sa, sb);
+  }
+
+  if (agnnodes(a) != agnnodes(b) || agnedges(a) != agnedges(b))
+    fail("graph %s has %d nodes and %d edges rather than %d and %d",
+         agnameof(a), agnnodes(b), agnedges(b), agnnodes(a), agnedges(a));
+  for (Agnode_t *na = agfstnode(a); na != NULL; na = agnxtnode(a, na)) {
+    Agnode_t *nb = agnode(b, agnameof(na), 0);
+    if (nb == NULL)
+      fail("node %s is missing from %s", agnameof(na), agnameof(a));
+    if (agroot(a) != a)
+      continue; // attributes and edges are compared in the root graph
+    compare_attrs(na, nb);
+
+    // both graphs list the out edges of a node in the order they were read
+    Agedge_t *eb = agfstout(b, nb);
+    for (Agedge_t *ea = agfstout(a, na); ea != NULL;
+         ea = agnxtout(a, ea), eb = agnxtout(b, eb)) {
+      if (eb == NULL || !streq(agnameof(aghead(ea)), agnameof(aghead(eb))) ||
+          !streq(agnameof(ea), agnameof(eb)))
+        fail("edge %s -> %s differs", agnameof(na), agnameof(aghead(ea)));
+      compare_attrs(ea, eb);
+    }
+  }
+}
+
+/// compare the graphs read from a file through stdio with those mapped from
+/// another, optionally writing snapshots of the former
+static void compare_all(const char *file, const char *mapped_file,
+                        const char *snapshot) {
+  input = file;
+  // the scanner cannot switch channels part way through a file, so the file
+  // is read in full through stdio before anything is read from a mapping
+  FILE *f = fopen(file, "r");
+  if (f == NULL) {
+    perror(file);
+    exit(EXIT_FAILURE);
+  }
+  agsetfile(file);
+  Agraph_t *expected[16];
+  size_t n = 0;
+  while (n < sizeof(expected) / sizeof(expected[0]) &&
+         (expected[n] = agread(f, NULL)) != NULL)
+    ++n;
+  fclose(f);
+
+  if (snapshot != NULL) {
+    FILE *out = fopen(snapshot, "wb");
+    if (out == NULL) {
+      perror(snapshot);
+      exit(EXIT_FAILURE);
+    }
+    for (size_t i = 0; i < n; ++i) {
+      if (agwrite_binary(expected[i], out, NULL) != 0)
+        fail("failed to write a snapshot of graph %zu", i + 1);
+    }
+    fclose(out);
+  }
+
+  input = mapped_file;
+  Agmapped_t *m = agmapopen(mapped_file);
+  if (m == NULL) {
+    perror(mapped_file);
+    exit(EXIT_FAILURE);
+  }
+  agsetfile(mapped_file);
+  for (size_t i = 0; i <= n; ++i) {
+    Agraph_t *mapped = agmapread(m, NULL);
+    if (i == n) {
+      if (mapped != NULL)
+        fail("graph %zu is extra", i + 1);
+      break;
+    }
+    if (mapped == NULL)
+      fail("graph %zu is missing", i + 1);
+    compare(expected[i], mapped);
+    agclose(expected[i]);
+    agclose(mapped);
+  }
+  agmapclose(m);
+}
+
+int main(int argc, char **argv) {
+
+  if (argc < 2 || argc > 3) {
+    fprintf(stderr, "usage: %s file [snapshot]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  compare_all(argv[1], argv[1], argc > 2 ? argv[2] : NULL);
+  if (argc > 2)
+    compare_all(argv[1], argv[2], NULL);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,248 @@
+/* reading graphs in several threads at once
+ * (see test_cgraph.py:test_agreentrant())
+ *
+ * Generates DOT texts, some holding more than one graph and some with syntax
+ * errors, and parses each of them once in this thread. Then parses all of them
+ * again from a pool of threads and checks every result, and every error,
+ * matches the sequential one.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <graphviz/cgraph.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef NDEBUG
+#error this is not intended to be compiled with assertions off
+#endif
+
+/// a growable string
+typedef struct {
+  char *s;
+  size_t len, cap;
+} buf_t;
+
+static void append(buf_t *b, const char *s) {
+  size_t n = strlen(s);
+  if (b->len + n + 1 > b->cap) {
+    b->cap = (b->len + n + 1) * 2;
+    b->s = realloc(b->s, b->cap);
+    assert(b->s != NULL);
+  }
+  memcpy(b->s + b->len, s, n + 1);
+  b->len += n;
+}
+
+static void appendf(buf_t *b, const char *fmt, ...) {
+  char tmp[256];
+  va_list ap;
+  va_start(ap, fmt);
+  int n = vsnprintf(tmp, sizeof(tmp), fmt, ap);
+  va_end(ap);
+  assert(n >= 0 && (size_t)n < sizeof(tmp));
+  append(b, tmp);
+}
+
+/// DOT text number `i`, deterministic in `i`
+static char *generate(int i) {
+  buf_t b = {0};
+  srand((unsigned)i);
+  const int graphs = 1 + i % 3;
+  for (int g = 0; g < graphs; ++g) {
+    const bool directed = (i + g) % 2 == 0;
+    const char *op = directed ? "->" : "--";
+    appendf(&b, "/* text %d */ %s%s \"g%d_%d\" {\n", i,
+            (i + g) % 5 == 0 ? "strict " : "", directed ? "digraph" : "graph",
+            i, g);
+    appendf(&b, "  node [shape=box] edge [weight=%d]\n", 1 + rand() % 4);
+    const int nodes = 5 + rand() % 40;
+    for (int n = 0; n < nodes; ++n) {
+      if (n % 7 == 0)
+        appendf(&b, "  subgraph cluster_%d { label=<<b>c%d</b>>\n", n, n);
+      appendf(&b, "  n%d [label=\"node \\\"%d\\\"\"]", n, n);
+      const int edges = rand() % 4;
+      for (int e = 0; e < edges; ++e)
+        appendf(&b, " n%d %s n%d [color=c%d]", n, op, rand() % nodes, e);
+      if (n % 5 == 1)
+        appendf(&b, " { n%d n%d } %s n%d", rand() % nodes, rand() % nodes, op,
+                n);
+      if (n % 7 == 6 || n == nodes - 1)
+        append(&b, " }");
+      append(&b, n % 3 == 0 ? "\n" : "; # trailing comment\n");
+    }
+    if (i % 11 == 10 && g == graphs - 1)
+      append(&b, "  n0 -> -> n1\n"); // a syntax error, on a known line
+    append(&b, "}\n");
+  }
+  return b.s;
+}
+
+/// a read position in memory
+typedef struct {
+  const char *text;
+  size_t pos;
+} memchan_t;
+
+static int memread(void *chan, char *buf, int bufsize) {
+  memchan_t *m = chan;
+  size_t len = strlen(m->text + m->pos);
+  if (len > (size_t)bufsize)
+    len = (size_t)bufsize;
+  memcpy(buf, m->text + m->pos, len);
+  m->pos += len;
+  return (int)len;
+}
+
+static void attrs(buf_t *b, void *obj, int kind) {
+  Agraph_t *root = agroot(obj);
+  for (Agsym_t *a = agnxtattr(root, kind, NULL); a != NULL;
+       a = agnxtattr(root, kind, a))
+    appendf(b, " %s=%s", a->name, agxget(obj, a));
+}
+
+static int cmpstr(const void *a, const void *b) {
+  return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+/// a description of `g` that does not depend on where anything was allocated
+/// or on the order in which other threads made anonymous subgraphs
+static void describe(buf_t *b, Agraph_t *g) {
+  const char *name = agnameof(g);
+  appendf(b, "graph %s%s%s\n", name[0] == '%' ? "(anonymous)" : name,
+          agisdirected(g) ? " directed" : "", agisstrict(g) ? " strict" : "");
+  attrs(b, g, AGRAPH);
+  for (Agnode_t *n = agfstnode(g); n != NULL; n = agnxtnode(g, n)) {
+    appendf(b, "\n node %s", agnameof(n));
+    attrs(b, n, AGNODE);
+    for (Agedge_t *e = agfstout(g, n); e != NULL; e = agnxtout(g, e)) {
+      appendf(b, "\n  edge %s %s", agnameof(agtail(e)), agnameof(aghead(e)));
+      attrs(b, e, AGEDGE);
+    }
+  }
+  append(b, "\n");
+
+  // subgraphs are kept in an order that depends on their names’ addresses
+  int count = agnsubg(g);
+  char **subs = calloc((size_t)count + 1, sizeof(subs[0]));
+  assert(subs != NULL);
+  int i = 0;
+  for (Agraph_t *s = agfstsubg(g); s != NULL; s = agnxtsubg(s)) {
+    buf_t sb = {0};
+    describe(&sb, s);
+    subs[i++] = sb.s;
+  }
+  assert(i == count);
+  qsort(subs, (size_t)count, sizeof(subs[0]), cmpstr);
+  for (i = 0; i < count; ++i) {
+    append(b, subs[i]);
+    free(subs[i]);
+  }
+  free(subs);
+}
+
+/// parse every graph in `text`, describing them and any error
+static char *parse(const char *text) {
+  memchan_t m = {text, 0};
+  Agiodisc_t io = {memread, AgIoDisc.putstr, AgIoDisc.flush};
+  Agdisc_t disc = {.id = &AgIdDisc, .io = &io};
+  buf_t b = {0};
+  append(&b, "");
+  agreseterrors();
+  agsetfile("text"); // and count lines from 1 again
+  Agraph_t *g;
+  while ((g = agread(&m, &disc)) != NULL) {
+    describe(&b, g);
+    agclose(g);
+  }
+  if (agerrors()) {
+    char *err = aglasterr();
+    assert(err != NULL);
+    appendf(&b, "error: %s", err);
+    free(err);
+  }
+  return b.s;
+}
+
+/// work shared by the pool
+typedef struct {
+  char **texts;
+  char **expected;
+  int count;
+  int next; ///< next text to parse, under `lock`
+  int done; ///< texts checked, under `lock`
+  pthread_mutex_t lock;
+} pool_t;
+
+static void *worker(void *arg) {
+  pool_t *p = arg;
+  for (;;) {
+    pthread_mutex_lock(&p->lock);
+    const int i = p->next++;
+    pthread_mutex_unlock(&p->lock);
+    if (i >= p->count)
+      break;
+    char *got = parse(p->texts[i]);
+    if (strcmp(got, p->expected[i]) != 0) {
+      fprintf(stderr, "text %d parsed differently in a thread:\n%s\n---\n%s\n",
+              i, got, p->expected[i]);
+      abort();
+    }
+    free(got);
+    pthread_mutex_lock(&p->lock);
+    ++p->done;
+    pthread_mutex_unlock(&p->lock);
+  }
+  return NULL;
+}
+
+int main(void) {
+
+  const int count = 200;
+  const int threads = 4;
+
+  // keep errors out of the way, but still recorded
+  agseterr(AGMAX);
+
+  pool_t pool = {.count = count};
+  pool.texts = calloc((size_t)count, sizeof(pool.texts[0]));
+  pool.expected = calloc((size_t)count, sizeof(pool.expected[0]));
+  assert(pool.texts != NULL && pool.expected != NULL);
+  for (int i = 0; i < count; ++i)
+    pool.texts[i] = generate(i);
+
+  int errors = 0;
+  for (int i = 0; i < count; ++i) {
+    pool.expected[i] = parse(pool.texts[i]);
+    if (strstr(pool.expected[i], "error: ") != NULL) {
+      assert(strstr(pool.expected[i], "syntax error") != NULL);
+      ++errors;
+    }
+  }
+  assert(errors > 0 && errors < count);
+
+  pthread_mutex_init(&pool.lock, NULL);
+  pthread_t *tids = calloc((size_t)threads, sizeof(tids[0]));
+  assert(tids != NULL);
+  for (int t = 0; t < threads; ++t)
+    assert(pthread_create(&tids[t], NULL, worker, &pool) == 0);
+  for (int t = 0; t < threads; ++t)
+    assert(pthread_join(tids[t], NULL) == 0);
+  assert(pool.done == count);
+  pthread_mutex_destroy(&pool.lock);
+
+  for (int i = 0; i < count; ++i) {
+    free(pool.texts[i]);
+    free(pool.expected[i]);
+  }
+  free(tids);
+  free(pool.expected);
+  free(pool.texts);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,296 @@
+/* reading DOT as a stream of statements
+ * (see test_cgraph.py:test_agstream())
+ *
+ * Rebuilds graphs from the statements agstream reports for some awkward
+ * inputs and checks they match what agread makes of the same text, then
+ * streams a generated graph from an input discipline that never holds more
+ * than one line of it and checks every edge is reported.
+ */
+
+#include <assert.h>
+#include <graphviz/cgraph.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef NDEBUG
+#error this is not intended to be compiled with assertions off
+#endif
+
+static const char *inputs[] = {
+    "/* comment */ strict graph \"a b\" { # shell comment\n"
+    "  a:p:n -- b:q [key=k1]; b -- a; a -- a; a -- a\n"
+    "  \"x\" + \"y\" -- <h<b>i</b>> -- \"line\\\ncont\"\n"
+    "  {c d} -- {e f -- g} -- subgraph s {h i}\n"
+    "  subgraph s { j }\n"
+    "  s2 -- {}\n"
+    "  1.5 -- -2 -- .3\n"
+    "}\n",
+    "digraph { rankdir=LR node [shape=box] edge [color=red]\n"
+    "  a -> b [key=1]; a -> b [key=1]; a -> b [key=2]; a -> b; a -> b\n"
+    "  subgraph cluster_1 { c [shape=\"\"] d -> c }\n"
+    "  { subgraph cluster_1 { e } }\n"
+    "  A -> {B C} -> D [weight=2]; { E F } -> { G E }\n"
+    "  n [label=<<b>bold</b>>, \"quoted \\\"name\\\"\"=1]\n"
+    "}\n"
+    "graph { a -- b [key=x]; b -- a [key=x]; a -- b [key=y] }\n",
+    "strict digraph { a -> b; b -> a; a -> b [key=z]; x -> x; x -> x }\n"
+    "digraph G { subgraph { subgraph s { a b } } subgraph s { c } }\n",
+};
+
+/// a read position in memory
+typedef struct {
+  const char *text;
+  size_t pos;
+} memchan_t;
+
+static int memread(void *chan, char *buf, int bufsize) {
+  memchan_t *m = chan;
+  size_t len = strlen(m->text + m->pos);
+  if (len > (size_t)bufsize)
+    len = (size_t)bufsize;
+  memcpy(buf, m->text + m->pos, len);
+  m->pos += len;
+  return (int)len;
+}
+
+/// a copy of `t`, for the cgraph functions that want strings
+static char *str(Agtext_t t) {
+  static char buf[2][256];
+  static int i;
+  i = !i;
+  assert(t.size < sizeof(buf[i]));
+  memcpy(buf[i], t.data, t.size);
+  buf[i][t.size] = '\0';
+  return buf[i];
+}
+
+enum { MAXGRAPHS = 8, MAXDEPTH = 8 };
+
+/// graphs being rebuilt from statements
+typedef struct {
+  Agraph_t *graphs[MAXGRAPHS];
+  int ngraphs;
+  Agraph_t *stack[MAXDEPTH];
+  int depth;
+} rebuild_t;
+
+static Agnode_t *mknode(rebuild_t *r, Agtext_t name) {
+  Agraph_t *g = r->stack[r->depth - 1];
+  char *s = str(name);
+  if (name.html)
+    s = agstrdup_html(g, s);
+  Agnode_t *n = agnode(g, s, 1);
+  if (name.html)
+    agstrfree(g, s);
+  return n;
+}
+
+static void setattrs(void *obj, size_t nattrs, const Agtext_t *attrs) {
+  for (size_t i = 0; i < nattrs; ++i) {
+    char name[256];
+    snprintf(name, sizeof(name), "%s", str(attrs[2 * i]));
+    if (strcmp(name, "key") != 0)
+      agsafeset(obj, name, str(attrs[2 * i + 1]), "");
+  }
+}
+
+static int on_graph(void *state, Agtext_t name, Agdesc_t desc) {
+  rebuild_t *r = state;
+  assert(r->ngraphs < MAXGRAPHS && r->depth == 0);
+  Agraph_t *g = agopen(name.data ? str(name) : NULL, desc, NULL);
+  r->graphs[r->ngraphs++] = g;
+  r->stack[r->depth++] = g;
+  return 0;
+}
+
+static int on_endgraph(void *state) {
+  rebuild_t *r = state;
+  assert(r->depth == 1);
+  --r->depth;
+  return 0;
+}
+
+static int on_subgraph(void *state, Agtext_t name) {
+  rebuild_t *r = state;
+  assert(r->depth > 0 && r->depth < MAXDEPTH);
+  Agraph_t *parent = r->stack[r->depth - 1];
+  r->stack[r->depth++] = agsubg(parent, name.data ? str(name) : NULL, 1);
+  return 0;
+}
+
+static int on_endsubgraph(void *state) {
+  rebuild_t *r = state;
+  assert(r->depth > 1);
+  --r->depth;
+  return 0;
+}
+
+static int on_node(void *state, Agtext_t name, size_t nattrs,
+                   const Agtext_t *attrs) {
+  setattrs(mknode(state, name), nattrs, attrs);
+  return 0;
+}
+
+static int on_edge(void *state, Agtext_t tail, Agtext_t head, size_t nattrs,
+                   const Agtext_t *attrs) {
+  rebuild_t *r = state;
+  Agnode_t *t = mknode(r, tail);
+  Agnode_t *h = mknode(r, head);
+  char key[256] = {0};
+  for (size_t i = 0; i < nattrs; ++i) {
+    if (attrs[2 * i].size == 3 && memcmp(attrs[2 * i].data, "key", 3) == 0)
+      snprintf(key, sizeof(key), "%s", str(attrs[2 * i + 1]));
+  }
+  Agedge_t *e = agedge(r->stack[r->depth - 1], t, h, key[0] ? key : NULL, 1);
+  if (e != NULL)
+    setattrs(e, nattrs, attrs);
+  return 0;
+}
+
+static int on_attr(void *state, int kind, size_t nattrs,
+                   const Agtext_t *attrs) {
+  rebuild_t *r = state;
+  if (kind == AGRAPH)
+    setattrs(r->stack[r->depth - 1], nattrs, attrs);
+  return 0;
+}
+
+static Agstreamdisc_t rebuild_disc = {on_graph,    on_endgraph, on_subgraph,
+                                      on_endsubgraph, on_node,  on_edge,
+                                      on_attr};
+
+static int count_subgs(Agraph_t *g) {
+  int n = 0;
+  for (Agraph_t *s = agfstsubg(g); s != NULL; s = agnxtsubg(s))
+    n += 1 + count_subgs(s);
+  return n;
+}
+
+/// do `a` and `b` hold the same nodes, edges and subgraphs?
+static void check_same(Agraph_t *a, Agraph_t *b) {
+  assert(agisdirected(a) == agisdirected(b));
+  assert(agisstrict(a) == agisstrict(b));
+  assert(agnnodes(a) == agnnodes(b));
+  assert(agnedges(a) == agnedges(b));
+  assert(count_subgs(a) == count_subgs(b));
+  for (Agnode_t *n = agfstnode(a); n != NULL; n = agnxtnode(a, n)) {
+    Agnode_t *m = agnode(b, agnameof(n), 0);
+    assert(m != NULL);
+    assert(agdegree(a, n, 1, 1) == agdegree(b, m, 1, 1));
+  }
+  for (Agraph_t *s = agfstsubg(a); s != NULL; s = agnxtsubg(s)) {
+    if (agnameof(s)[0] == '%')
+      continue;
+    Agraph_t *t = agsubg(b, agnameof(s), 0);
+    assert(t != NULL);
+    check_same(s, t);
+  }
+}
+
+static void check_inputs(void) {
+  for (size_t i = 0; i < sizeof(inputs) / sizeof(inputs[0]); ++i) {
+    rebuild_t r = {0};
+    memchan_t m = {inputs[i], 0};
+    Agiodisc_t io = {memread, AgIoDisc.putstr, AgIoDisc.flush};
+    assert(agstream(&m, &io, &rebuild_disc, &r) == 0);
+    assert(r.depth == 0);
+
+    // the same text, parsed
+    m = (memchan_t){inputs[i], 0};
+    Agdisc_t disc = {.id = &AgIdDisc, .io = &io};
+    for (int j = 0; j < r.ngraphs; ++j) {
+      Agraph_t *g = agread(&m, &disc);
+      assert(g != NULL);
+      check_same(g, r.graphs[j]);
+      check_same(r.graphs[j], g);
+      agclose(g);
+      agclose(r.graphs[j]);
+    }
+    assert(agread(&m, &disc) == NULL);
+  }
+}
+
+static int stop_on_node(void *state, Agtext_t name, size_t nattrs,
+                        const Agtext_t *attrs) {
+  (void)nattrs;
+  (void)attrs;
+  return name.size == 1 && name.data[0] == 'c' ? *(int *)state : 0;
+}
+
+/// errors and handlers that stop the read
+static void check_stops(void) {
+  Agiodisc_t io = {memread, AgIoDisc.putstr, AgIoDisc.flush};
+  Agstreamdisc_t disc = {0};
+  disc.node = stop_on_node;
+  int stop = 42;
+
+  memchan_t m = {"graph { a b c d }", 0};
+  assert(agstream(&m, &io, &disc, &stop) == 42);
+
+  agseterr(AGMAX);
+  m = (memchan_t){"graph { a -- }", 0};
+  assert(agstream(&m, &io, &disc, &stop) == -1);
+  m = (memchan_t){"graph { a [label=\"unterminated }", 0};
+  assert(agstream(&m, &io, &disc, &stop) == -1);
+  agseterr(AGWARN);
+}
+
+/// a generated chain of edges, a line at a time
+typedef struct {
+  size_t edges;
+  size_t next;
+  char line[64];
+  size_t len, pos;
+} genchan_t;
+
+static int genread(void *chan, char *buf, int bufsize) {
+  genchan_t *g = chan;
+  if (g->pos == g->len) {
+    if (g->next == 0)
+      g->len = (size_t)snprintf(g->line, sizeof(g->line), "digraph {\n");
+    else if (g->next <= g->edges)
+      g->len = (size_t)snprintf(g->line, sizeof(g->line),
+                                "n%zu -> n%zu [weight=2]\n", g->next % 1000,
+                                g->next);
+    else if (g->next == g->edges + 1)
+      g->len = (size_t)snprintf(g->line, sizeof(g->line), "}\n");
+    else
+      return 0;
+    ++g->next;
+    g->pos = 0;
+  }
+  size_t len = g->len - g->pos;
+  if (len > (size_t)bufsize)
+    len = (size_t)bufsize;
+  memcpy(buf, g->line + g->pos, len);
+  g->pos += len;
+  return (int)len;
+}
+
+static int count_edge(void *state, Agtext_t tail, Agtext_t head,
+                      size_t nattrs, const Agtext_t *attrs) {
+  (void)tail;
+  (void)head;
+  assert(nattrs == 1 && attrs[1].size == 1 && attrs[1].data[0] == '2');
+  ++*(size_t *)state;
+  return 0;
+}
+
+int main(void) {
+
+  check_inputs();
+  check_stops();
+
+  const size_t edges = 100000;
+  genchan_t gen = {.edges = edges};
+  Agiodisc_t io = {genread, AgIoDisc.putstr, AgIoDisc.flush};
+  Agstreamdisc_t disc = {0};
+  disc.edge = count_edge;
+  size_t seen = 0;
+  assert(agstream(&gen, &io, &disc, &seen) == 0);
+  assert(seen == edges);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,148 @@
+/* parsed attribute values
+ * (see test_cgraph.py:test_attrcache())
+ *
+ * usage: attrcache [nodes]
+ *
+ * Checks that agxgetdouble, agxgetint and agxgetpoint agree with the strings
+ * they parse as those strings change, including for objects that are not in
+ * the graph, then reads a numeric attribute of every node of a larger graph
+ * through strtod and through agxgetdouble and checks both agree.
+ */
+
+#include <assert.h>
+#include <graphviz/cgraph.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef NDEBUG
+#error this is not intended to be compiled with assertions off
+#endif
+
+static void check_values(void) {
+  Agraph_t *g = agopen("G", Agdirected, NULL);
+  Agsym_t *width = agattr(g, AGNODE, "width", "0.75");
+  Agsym_t *pos = agattr(g, AGNODE, "pos", "");
+  Agsym_t *weight = agattr(g, AGEDGE, "weight", "1");
+  Agnode_t *a = agnode(g, "a", 1);
+  Agnode_t *b = agnode(g, "b", 1);
+  Agedge_t *e = agedge(g, a, b, NULL, 1);
+  double d = 0, x = 0, y = 0;
+  long l = 0;
+
+  // defaults, read twice so the second read comes from the cache
+  for (int i = 0; i < 2; ++i) {
+    assert(agxgetdouble(a, width, &d) && d == 0.75);
+    assert(!agxgetpoint(a, pos, &x, &y));
+    assert(agxgetint(e, weight, &l) && l == 1);
+  }
+
+  // changed values are seen
+  agxset(a, width, "2.5");
+  assert(agxgetdouble(a, width, &d) && d == 2.5);
+  assert(agxgetdouble(b, width, &d) && d == 0.75);
+  agxset(a, width, "");
+  d = 42;
+  assert(!agxgetdouble(a, width, &d) && d == 42);
+  agxset(a, width, "abc");
+  assert(!agxgetdouble(a, width, &d) && d == 42);
+  agxset(a, pos, "1.5,-3");
+  assert(agxgetpoint(a, pos, &x, &y) && x == 1.5 && y == -3);
+
+  // both halves of an edge share their values
+  agxset(agopp(e), weight, "7");
+  assert(agxgetint(e, weight, &l) && l == 7);
+  assert(agxgetint(agopp(e), weight, &l) && l == 7);
+
+  // a subgraph's local symbol shares its root symbol's values
+  Agraph_t *sg = agsubg(g, "sg", 1);
+  agsubnode(sg, b, 1);
+  Agsym_t *local = agattr(sg, AGNODE, "width", "3");
+  assert(local != width && local->id == width->id);
+  assert(agxgetdouble(b, width, &d) && d == 0.75);
+  agxset(b, local, "4");
+  assert(agxgetdouble(b, width, &d) && d == 4);
+  assert(agxgetdouble(b, local, &d) && d == 4);
+
+  // renumbering nodes keeps their values
+  agxset(a, width, "5");
+  assert(agxgetdouble(a, width, &d) && d == 5);
+  agnodebefore(b, a);
+  assert(agxgetdouble(a, width, &d) && d == 5);
+  assert(agxgetdouble(b, width, &d) && d == 4);
+
+  // graphs are not cached, but are still parsed
+  Agsym_t *ratio = agattr(g, AGRAPH, "nodesep", "0.25");
+  assert(agxgetdouble(g, ratio, &d) && d == 0.25);
+  agxset(g, ratio, "0.5");
+  assert(agxgetdouble(g, ratio, &d) && d == 0.5);
+
+  agclose(g);
+}
+
+/// objects the graph does not know of, such as the virtual nodes dot makes by
+/// copying a node, must not see the values of the object their number names
+static void check_strangers(void) {
+  Agraph_t *g = agopen("G", Agdirected, NULL);
+  Agsym_t *width = agattr(g, AGNODE, "width", "1");
+  Agnode_t *a = agnode(g, "a", 1);
+  Agnode_t *b = agnode(g, "b", 1);
+  agxset(a, width, "2");
+  agxset(b, width, "3");
+  double d = 0;
+
+  // build the column
+  assert(agxgetdouble(a, width, &d) && d == 2);
+
+  // a copy of a with no number, and one numbered as b
+  Agnode_t copy = *a;
+  AGSEQ(&copy) = 0;
+  assert(agxgetdouble(&copy, width, &d) && d == 2);
+  AGSEQ(&copy) = AGSEQ(b);
+  assert(agxgetdouble(&copy, width, &d) && d == 2);
+  assert(agxgetdouble(b, width, &d) && d == 3);
+
+  // a node made after the column was built
+  Agnode_t *c = agnode(g, "c", 1);
+  assert(agxgetdouble(c, width, &d) && d == 1);
+  agxset(c, width, "4");
+  assert(agxgetdouble(c, width, &d) && d == 4);
+  assert(agxgetdouble(a, width, &d) && d == 2);
+
+  // a deleted node's number is not reused
+  agdelnode(g, b);
+  Agnode_t *e = agnode(g, "e", 1);
+  assert(agxgetdouble(e, width, &d) && d == 1);
+
+  agclose(g);
+}
+
+int main(int argc, char **argv) {
+
+  const size_t nnodes = argc > 1 ? strtoul(argv[1], NULL, 10) : 10000;
+
+  check_values();
+  check_strangers();
+
+  Agraph_t *g = agopen("G", Agdirected, NULL);
+  Agsym_t *width = agattr(g, AGNODE, "width", "0.75");
+  for (size_t i = 0; i < nnodes; ++i) {
+    char name[32];
+    snprintf(name, sizeof(name), "n%zu", i);
+    Agnode_t *n = agnode(g, name, 1);
+    if (i % 7 != 0) {
+      snprintf(name, sizeof(name), "%zu.%zu", i % 10, i % 1000);
+      agxset(n, width, name);
+    }
+  }
+
+  for (Agnode_t *n = agfstnode(g); n; n = agnxtnode(g, n)) {
+    double d = 0;
+    assert(agxgetdouble(n, width, &d));
+    assert(d == strtod(agxget(n, width), NULL));
+  }
+
+  agclose(g);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,137 @@
+/* counting the crossings dot leaves, by the method it used before tree_cross
+ * (see test_misc.py:test_crossings())
+ *
+ * usage: crossings file...
+ *
+ * Each graph is laid out with dot, under -v, and the crossings of the edges
+ * between each pair of adjacent ranks, weighted by xpenalty, are counted in
+ * the order dot left them with array_cross, the quadratic counter mincross.c
+ * used before it counted them in a tree. The program fails unless their sum is
+ * the count dot reports at the end of crossing minimization. The graphs must
+ * have no clusters or ports, whose crossings dot counts in other ways.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "gvtest_plugins.h"
+#include <graphviz/cgraph.h>
+#include <graphviz/gvc.h>
+#include <graphviz/types.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// from lib/common/globals.h, which is not installed
+extern unsigned char Verbose;
+
+/// the crossings of the edges between ranks r and r+1, weighted by their
+/// xpenalty, by summing for each edge the weights of the edges from earlier
+/// nodes to later ones
+static long array_cross(graph_t *g, int r) {
+  const rank_t *top = &GD_rank(g)[r];
+  const rank_t *bot = &GD_rank(g)[r + 1];
+  long *count = calloc((size_t)bot->n + 1, sizeof(long));
+  if (count == NULL) {
+    fprintf(stderr, "out of memory\n");
+    exit(EXIT_FAILURE);
+  }
+
+  long cross = 0;
+  int max = 0;
+  for (int i = 0; i < top->n; i++) {
+    edge_t *e;
+    if (max > 0) {
+      for (int j = 0; (e = ND_out(top->v[i]).list[j]); j++) {
+        for (int k = ND_order(aghead(e)) + 1; k <= max; k++)
+          cross += count[k] * ED_xpenalty(e);
+      }
+    }
+    for (int j = 0; (e = ND_out(top->v[i]).list[j]); j++) {
+      const int inv = ND_order(aghead(e));
+      if (inv > max)
+        max = inv;
+      count[inv] += ED_xpenalty(e);
+    }
+  }
+  free(count);
+  return cross;
+}
+
+/// lay out g, returning the crossings dot reports
+static long layout(GVC_t *gvc, graph_t *g) {
+  // collect what dot writes under -v
+  FILE *log = tmpfile();
+  if (log == NULL) {
+    perror("tmpfile");
+    exit(EXIT_FAILURE);
+  }
+  fflush(stderr);
+  const int saved = dup(STDERR_FILENO);
+  dup2(fileno(log), STDERR_FILENO);
+  Verbose = 1;
+  const int rc = gvLayout(gvc, g, "dot");
+  Verbose = 0;
+  fflush(stderr);
+  dup2(saved, STDERR_FILENO);
+  close(saved);
+  if (rc != 0) {
+    fprintf(stderr, "failed to lay out %s\n", agnameof(g));
+    exit(EXIT_FAILURE);
+  }
+
+  long reported = -1;
+  char line[1024];
+  rewind(log);
+  while (fgets(line, sizeof(line), log) != NULL) {
+    long n;
+    if (strncmp(line, "mincross ", strlen("mincross ")) == 0 &&
+        sscanf(line, "mincross %*[^:]: %ld crossings", &n) == 1)
+      reported = n;
+  }
+  fclose(log);
+  if (reported < 0) {
+    fprintf(stderr, "no crossings reported for %s\n", agnameof(g));
+    exit(EXIT_FAILURE);
+  }
+  return reported;
+}
+
+int main(int argc, char **argv) {
+
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s file...\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  GVC_t *gvc = gvtest_context();
+  for (int i = 1; i < argc; ++i) {
+    FILE *f = fopen(argv[i], "r");
+    if (f == NULL) {
+      perror(argv[i]);
+      return EXIT_FAILURE;
+    }
+    graph_t *g = agread(f, NULL);
+    fclose(f);
+    if (g == NULL) {
+      fprintf(stderr, "%s: no graph\n", argv[i]);
+      return EXIT_FAILURE;
+    }
+
+    const long reported = layout(gvc, g);
+    long counted = 0;
+    for (int r = GD_minrank(g); r < GD_maxrank(g); r++)
+      counted += array_cross(g, r);
+    if (counted != reported) {
+      fprintf(stderr, "%s: dot reports %ld crossings, but there are %ld\n",
+              argv[i], reported, counted);
+      return EXIT_FAILURE;
+    }
+
+    gvFreeLayout(gvc, g);
+    agclose(g);
+  }
+  gvFreeContext(gvc);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,151 @@
+/* laying out a batch of graphs with gvLayoutBatch
+ * (see test_misc.py:test_gvbatch())
+ *
+ * Generates small graphs and lays out and renders each of them in a loop of
+ * gvLayout and gvRenderData calls. Then does all of them again, twice, with
+ * gvLayoutBatch using several threads, and checks every rendering matches the
+ * one from the loop. This is repeated for each of the core output formats. The
+ * second batch reuses the worker contexts made by the first.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "gvtest_plugins.h"
+#include <assert.h>
+#include <graphviz/cgraph.h>
+#include <graphviz/gvc.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef NDEBUG
+#error this is not intended to be compiled with assertions off
+#endif
+
+/// a growable string
+typedef struct {
+  char *s;
+  size_t len, cap;
+} buf_t;
+
+static void appendf(buf_t *b, const char *fmt, ...) {
+  char tmp[256];
+  va_list ap;
+  va_start(ap, fmt);
+  int n = vsnprintf(tmp, sizeof(tmp), fmt, ap);
+  va_end(ap);
+  assert(n >= 0 && (size_t)n < sizeof(tmp));
+  if (b->len + (size_t)n + 1 > b->cap) {
+    b->cap = (b->len + (size_t)n + 1) * 2;
+    b->s = realloc(b->s, b->cap);
+    assert(b->s != NULL);
+  }
+  memcpy(b->s + b->len, tmp, (size_t)n + 1);
+  b->len += (size_t)n;
+}
+
+/// graph number `i`, deterministic in `i`
+static Agraph_t *generate(int i) {
+  buf_t b = {0};
+  srand((unsigned)i);
+  appendf(&b, "digraph g%d {\n", i);
+  if (i % 3 == 0)
+    appendf(&b, "  rankdir=LR\n");
+  const int nodes = 4 + rand() % 20;
+  for (int n = 0; n < nodes; ++n) {
+    appendf(&b, "  n%d [label=\"node %d\" shape=%s]\n", n, n,
+            n % 2 ? "ellipse" : "box");
+    const int edges = rand() % 3;
+    for (int e = 0; e < edges; ++e)
+      appendf(&b, "  n%d -> n%d [label=\"e%d\"]\n", n, rand() % nodes, e);
+  }
+  appendf(&b, "}\n");
+  Agraph_t *g = agmemread(b.s);
+  assert(g != NULL);
+  free(b.s);
+  return g;
+}
+
+/// replace each graph with a fresh copy, as rendering to some formats attaches
+/// the layout to the graph and that would change the next layout of it
+static void regenerate(Agraph_t **graphs, int count) {
+  for (int i = 0; i < count; ++i) {
+    if (graphs[i] != NULL)
+      agclose(graphs[i]);
+    graphs[i] = generate(i);
+  }
+}
+
+static const char *formats[] = {"svg", "dot", "xdot", "json", "plain"};
+enum { FORMATS = sizeof(formats) / sizeof(formats[0]) };
+
+int main(void) {
+
+  const int count = 100;
+  const int threads = 4;
+
+  GVC_t *gvc = gvtest_context();
+  assert(gvc != NULL);
+
+  Agraph_t **graphs = calloc((size_t)count, sizeof(graphs[0]));
+  char **expected = calloc((size_t)count, sizeof(expected[0]));
+  unsigned *expected_lengths = calloc((size_t)count, sizeof(expected_lengths[0]));
+  char **results = calloc((size_t)count, sizeof(results[0]));
+  unsigned *lengths = calloc((size_t)count, sizeof(lengths[0]));
+  assert(graphs != NULL && expected != NULL && expected_lengths != NULL);
+  assert(results != NULL && lengths != NULL);
+
+  for (int f = 0; f < FORMATS; ++f) {
+    const char *format = formats[f];
+
+    regenerate(graphs, count);
+    for (int i = 0; i < count; ++i) {
+      assert(gvLayout(gvc, graphs[i], "dot") == 0);
+      assert(gvRenderData(gvc, graphs[i], format, &expected[i],
+                          &expected_lengths[i]) == 0);
+      assert(gvFreeLayout(gvc, graphs[i]) == 0);
+    }
+
+    for (int pass = 0; pass < 2; ++pass) {
+      regenerate(graphs, count);
+      const int failed = gvLayoutBatch(gvc, graphs, (size_t)count, "dot",
+                                       format, results, lengths, threads);
+      assert(failed == 0);
+
+      for (int i = 0; i < count; ++i) {
+        assert(results[i] != NULL);
+        if (lengths[i] != expected_lengths[i] ||
+            memcmp(results[i], expected[i], lengths[i]) != 0) {
+          fprintf(stderr,
+                  "graph %d rendered as %s differently in a batch:\n%s\n---\n"
+                  "%s\n",
+                  i, format, results[i], expected[i]);
+          abort();
+        }
+        assert(!gvLayoutDone(graphs[i]));
+        gvFreeRenderData(results[i]);
+      }
+    }
+
+    for (int i = 0; i < count; ++i)
+      gvFreeRenderData(expected[i]);
+  }
+
+  // an unknown engine fails every graph, and leaves no results
+  assert(gvLayoutBatch(gvc, graphs, (size_t)count, "no such engine", "svg",
+                       results, lengths, threads) == count);
+  for (int i = 0; i < count; ++i)
+    assert(results[i] == NULL && lengths[i] == 0);
+
+  for (int i = 0; i < count; ++i)
+    agclose(graphs[i]);
+  free(lengths);
+  free(results);
+  free(expected_lengths);
+  free(expected);
+  free(graphs);
+  (void)gvFreeContext(gvc);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,202 @@
+/* laying out graphs in several threads at once
+ * (see test_misc.py:test_gvreentrant())
+ *
+ * Generates graphs using a mix of layout engines, labels, clusters and spline
+ * styles, and lays out each of them once in this thread and renders it to each
+ * of the core output formats. Then does all of them again from a pool of
+ * threads, each with its own GVC_t, and checks every rendering matches the
+ * sequential one.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include "gvtest_plugins.h"
+#include <graphviz/cgraph.h>
+#include <graphviz/gvc.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef NDEBUG
+#error this is not intended to be compiled with assertions off
+#endif
+
+/// a growable string
+typedef struct {
+  char *s;
+  size_t len, cap;
+} buf_t;
+
+static void append(buf_t *b, const char *s) {
+  size_t n = strlen(s);
+  if (b->len + n + 1 > b->cap) {
+    b->cap = (b->len + n + 1) * 2;
+    b->s = realloc(b->s, b->cap);
+    assert(b->s != NULL);
+  }
+  memcpy(b->s + b->len, s, n + 1);
+  b->len += n;
+}
+
+static void appendf(buf_t *b, const char *fmt, ...) {
+  char tmp[256];
+  va_list ap;
+  va_start(ap, fmt);
+  int n = vsnprintf(tmp, sizeof(tmp), fmt, ap);
+  va_end(ap);
+  assert(n >= 0 && (size_t)n < sizeof(tmp));
+  append(b, tmp);
+}
+
+static const char *engines[] = {"dot", "neato", "circo", "twopi"};
+enum { ENGINES = sizeof(engines) / sizeof(engines[0]) };
+
+static const char *spline_styles[] = {"true", "polyline", "curved", "line"};
+enum { SPLINES = sizeof(spline_styles) / sizeof(spline_styles[0]) };
+
+static const char *formats[] = {"svg", "dot", "xdot", "json", "plain"};
+enum { FORMATS = sizeof(formats) / sizeof(formats[0]) };
+
+/// graph number `i`, deterministic in `i`
+static char *generate(int i) {
+  buf_t b = {0};
+  srand((unsigned)i);
+  const bool dot = strcmp(engines[i % ENGINES], "dot") == 0;
+  // dot cannot route flat edges between adjacent records, so leave those to
+  // the other engines
+  const bool records = i % 3 == 0 && !dot;
+  // subgraphs are kept in an order that depends on their names’ addresses, so
+  // there is at most one, or the output order would vary from run to run
+  const bool cluster = dot && i % 2 == 0;
+  appendf(&b, "digraph g%d {\n  splines=%s; concentrate=%s\n", i,
+          spline_styles[(i / ENGINES) % SPLINES], i % 7 == 0 ? "true" : "false");
+  if (i % 3 == 0)
+    append(&b, "  rankdir=LR\n");
+  if (records)
+    append(&b, "  node [shape=record]\n");
+  if (i % 4 == 1)
+    append(&b, "  mode=KK; overlap=false\n");
+  const int nodes = 4 + rand() % 30;
+  if (cluster)
+    appendf(&b, "  subgraph cluster_0 { label=\"cluster %d\"\n", i);
+  for (int n = 0; n < nodes; ++n) {
+    if (n % 5 == 2)
+      appendf(&b,
+              "  n%d [shape=plaintext label=<<table><tr><td>%d</td>"
+              "<td port=\"p\"><b>html</b></td></tr></table>>]\n",
+              n, n);
+    else if (n % 3 == 0 && records)
+      appendf(&b, "  n%d [label=\"{<a> %d | { x | <b> y } }\"]\n", n, n);
+    else
+      appendf(&b, "  n%d [label=\"node\\n%d\" shape=%s]\n", n, n,
+              n % 2 ? "ellipse" : "box");
+    const int edges = rand() % 3;
+    // dot mishandles labelled flat edges in clusters, so those get xlabels
+    for (int e = 0; e < edges; ++e)
+      appendf(&b, "  n%d -> n%d [%s=\"e%d\" color=\"/blues9/%d\"]\n", n,
+              rand() % nodes, cluster ? "xlabel" : "label", e, 1 + e);
+    if (cluster && n == nodes / 3)
+      append(&b, "  }\n");
+  }
+  append(&b, "}\n");
+  return b.s;
+}
+
+/// lay out graph `i` with its own context, and render it in every format
+static char *layout(int i, const char *text) {
+  GVC_t *gvc = gvtest_context();
+  assert(gvc != NULL);
+  Agraph_t *g = agmemread(text);
+  assert(g != NULL);
+  assert(gvLayout(gvc, g, engines[i % ENGINES]) == 0);
+  buf_t all = {0};
+  for (int f = 0; f < FORMATS; ++f) {
+    char *result = NULL;
+    unsigned length = 0;
+    assert(gvRenderData(gvc, g, formats[f], &result, &length) == 0);
+    assert(result != NULL && strlen(result) == length);
+    appendf(&all, "--- %s\n", formats[f]);
+    append(&all, result);
+    gvFreeRenderData(result);
+  }
+  assert(gvFreeLayout(gvc, g) == 0);
+  agclose(g);
+  assert(gvFreeContext(gvc) == 0);
+  return all.s;
+}
+
+/// work shared by the pool
+typedef struct {
+  char **texts;
+  char **expected;
+  int count;
+  int next; ///< next graph to lay out, under `lock`
+  int done; ///< graphs checked, under `lock`
+  pthread_mutex_t lock;
+} pool_t;
+
+static void *worker(void *arg) {
+  pool_t *p = arg;
+  for (;;) {
+    pthread_mutex_lock(&p->lock);
+    const int i = p->next++;
+    pthread_mutex_unlock(&p->lock);
+    if (i >= p->count)
+      break;
+    char *got = layout(i, p->texts[i]);
+    if (strcmp(got, p->expected[i]) != 0) {
+      fprintf(stderr,
+              "graph %d laid out differently in a thread:\n%s\n---\n%s\n", i,
+              got, p->expected[i]);
+      abort();
+    }
+    free(got);
+    pthread_mutex_lock(&p->lock);
+    ++p->done;
+    pthread_mutex_unlock(&p->lock);
+  }
+  return NULL;
+}
+
+int main(void) {
+
+  const int count = 40;
+  const int threads = 4;
+
+  // the generated graphs provoke warnings that are not of interest here
+  agseterr(AGERR);
+
+  pool_t pool = {.count = count};
+  pool.texts = calloc((size_t)count, sizeof(pool.texts[0]));
+  pool.expected = calloc((size_t)count, sizeof(pool.expected[0]));
+  assert(pool.texts != NULL && pool.expected != NULL);
+  for (int i = 0; i < count; ++i)
+    pool.texts[i] = generate(i);
+
+  for (int i = 0; i < count; ++i)
+    pool.expected[i] = layout(i, pool.texts[i]);
+
+  pthread_mutex_init(&pool.lock, NULL);
+  pthread_t *tids = calloc((size_t)threads, sizeof(tids[0]));
+  assert(tids != NULL);
+  for (int t = 0; t < threads; ++t)
+    assert(pthread_create(&tids[t], NULL, worker, &pool) == 0);
+  for (int t = 0; t < threads; ++t)
+    assert(pthread_join(tids[t], NULL) == 0);
+  assert(pool.done == count);
+  pthread_mutex_destroy(&pool.lock);
+
+  for (int i = 0; i < count; ++i) {
+    free(pool.texts[i]);
+    free(pool.expected[i]);
+  }
+  free(tids);
+  free(pool.expected);
+  free(pool.texts);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,32 @@
+/* the plugins test programs lay out and render graphs with
+ *
+ * Test programs built by CMake link the plugins built alongside them and load
+ * them directly, so they need no installation. Otherwise they find the
+ * installed plugins as applications do.
+ */
+
+#pragma once
+
+#include <graphviz/gvc.h>
+
+#ifdef GVTEST_BUILTINS
+#include <graphviz/gvplugin.h>
+
+extern gvplugin_library_t gvplugin_core_LTX_library;
+extern gvplugin_library_t gvplugin_dot_layout_LTX_library;
+extern gvplugin_library_t gvplugin_neato_layout_LTX_library;
+
+static lt_symlist_t gvtest_builtins[] = {
+    {"gvplugin_core_LTX_library", &gvplugin_core_LTX_library},
+    {"gvplugin_dot_layout_LTX_library", &gvplugin_dot_layout_LTX_library},
+    {"gvplugin_neato_layout_LTX_library", &gvplugin_neato_layout_LTX_library},
+    {0, 0}};
+
+/// a new context with the core, dot and neato plugins
+static inline GVC_t *gvtest_context(void) {
+  return gvContextPlugins(gvtest_builtins, 0);
+}
+#else
+/// a new context with the installed plugins
+static inline GVC_t *gvtest_context(void) { return gvContext(); }
+#endif
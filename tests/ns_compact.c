@@ -0,0 +1,158 @@
+/* ranking graphs with the network simplex solver over compact arrays
+ * (see test_misc.py:test_ns_compact())
+ *
+ * rank2 ranks graphs of fewer than 2000 nodes with the solver in ns.c. The
+ * same pseudo-random graphs, of sizes below that, are ranked with it and with
+ * ns_compact called directly, with one thread and with several, for each kind
+ * of balancing, and the program fails unless all give every node the same
+ * rank.
+ */
+
+#include <graphviz/cgraph.h>
+#include <graphviz/types.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// from lib/common/render.h and lib/common/ns_compact.h, which are not installed
+extern int rank2(graph_t *g, int balance, int maxiter, int search_size);
+extern int ns_compact(graph_t *g, int balance, int maxiter, int search_size,
+                      bool warm, int threads);
+
+// the search size rank2 uses by default, which ns_compact must be given
+enum { SEARCH_SIZE = 30 };
+
+// node types, from lib/common/const.h
+enum { NORMAL = 0, VIRTUAL = 1 };
+
+static uint64_t rand_state;
+
+/// a deterministic xorshift generator, so both solvers see the same graph
+static uint64_t next_rand(void) {
+  rand_state ^= rand_state << 13;
+  rand_state ^= rand_state >> 7;
+  rand_state ^= rand_state << 17;
+  return rand_state;
+}
+
+static void *alloc(size_t n, size_t size) {
+  void *p = calloc(n, size);
+  if (p == NULL) {
+    fprintf(stderr, "out of memory\n");
+    exit(EXIT_FAILURE);
+  }
+  return p;
+}
+
+static void append(elist *l, edge_t *e) {
+  edge_t **list = realloc(l->list, (l->size + 2) * sizeof(edge_t *));
+  if (list == NULL) {
+    fprintf(stderr, "out of memory\n");
+    exit(EXIT_FAILURE);
+  }
+  l->list = list;
+  l->list[l->size++] = e;
+  l->list[l->size] = NULL;
+}
+
+/// build a connected graph ready for network simplex, as dot builds its own
+static graph_t *build(size_t nnodes, uint64_t seed) {
+  rand_state = seed;
+
+  graph_t *g = agopen("G", Agstrictdirected, NULL);
+  agbindrec(g, "Agraphinfo_t", sizeof(Agraphinfo_t), true);
+  node_t **nodes = alloc(nnodes, sizeof(node_t *));
+  node_t *last = NULL;
+  for (size_t i = 0; i < nnodes; ++i) {
+    char name[32];
+    snprintf(name, sizeof(name), "n%zu", i);
+    node_t *n = nodes[i] = agnode(g, name, 1);
+    agbindrec(n, "Agnodeinfo_t", sizeof(Agnodeinfo_t), true);
+    ND_out(n).list = alloc(1, sizeof(edge_t *));
+    ND_in(n).list = alloc(1, sizeof(edge_t *));
+    ND_node_type(n) = next_rand() % 4 == 0 ? VIRTUAL : NORMAL;
+    if (last == NULL)
+      GD_nlist(g) = n;
+    else
+      ND_next(last) = n;
+    ND_prev(n) = last;
+    last = n;
+  }
+
+  // a tree joining every node to an earlier one, and then edges between
+  // random pairs, always from the earlier node so there are no cycles
+  for (size_t i = 1; i < 3 * nnodes; ++i) {
+    size_t t = i < nnodes ? (size_t)(next_rand() % i) : next_rand() % nnodes;
+    size_t h = i < nnodes ? i : next_rand() % nnodes;
+    if (t == h)
+      continue;
+    if (t > h) {
+      const size_t s = t;
+      t = h;
+      h = s;
+    }
+    edge_t *e = agedge(g, nodes[t], nodes[h], NULL, 0);
+    if (e != NULL)
+      continue;
+    e = agedge(g, nodes[t], nodes[h], NULL, 1);
+    agbindrec(e, "Agedgeinfo_t", sizeof(Agedgeinfo_t), true);
+    ED_minlen(e) = (unsigned short)(next_rand() % 3);
+    ED_weight(e) = (int)(next_rand() % 4);
+    append(&ND_out(nodes[t]), e);
+    append(&ND_in(nodes[h]), e);
+  }
+  free(nodes);
+  return g;
+}
+
+static void close_graph(graph_t *g) {
+  for (node_t *n = agfstnode(g); n != NULL; n = agnxtnode(g, n)) {
+    free(ND_out(n).list);
+    free(ND_in(n).list);
+  }
+  agclose(g);
+}
+
+int main(void) {
+
+  const size_t sizes[] = {2, 10, 200, 1999};
+  for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i) {
+    for (int balance = 0; balance <= 2; ++balance) {
+      for (int threads = 1; threads <= 4; threads += 3) {
+        const uint64_t seed = 1 + i * 3 + (uint64_t)balance;
+        graph_t *expected = build(sizes[i], seed);
+        graph_t *compact = build(sizes[i], seed);
+
+        const int want = rank2(expected, balance, INT_MAX, SEARCH_SIZE);
+        const int got =
+            ns_compact(compact, balance, INT_MAX, SEARCH_SIZE, false, threads);
+        if (want != got) {
+          fprintf(stderr,
+                  "%zu nodes, balance %d, %d threads: returned %d rather than "
+                  "%d\n",
+                  sizes[i], balance, threads, got, want);
+          return EXIT_FAILURE;
+        }
+
+        for (node_t *n = GD_nlist(expected), *m = GD_nlist(compact); n != NULL;
+             n = ND_next(n), m = ND_next(m)) {
+          if (ND_rank(n) != ND_rank(m)) {
+            fprintf(stderr,
+                    "%zu nodes, balance %d, %d threads: %s ranked %d rather "
+                    "than %d\n",
+                    sizes[i], balance, threads, agnameof(m), ND_rank(m),
+                    ND_rank(n));
+            return EXIT_FAILURE;
+          }
+        }
+
+        close_graph(expected);
+        close_graph(compact);
+      }
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -2,13 +2,21 @@
 Tests of large and/or expensive graphs.
 """
 
+import json
 import os
+import platform
+import random
+import re
 import subprocess
 import sys
+import time
 from pathlib import Path
+from typing import Dict, List, Optional, Tuple
+
+import pytest
 
 sys.path.append(os.path.join(os.path.dirname(__file__), "../../../tests"))
-from gvtest import dot  # pylint: disable=wrong-import-position
+from gvtest import dot, is_mingw, run_c  # pylint: disable=wrong-import-position
 
 
 def test_long_chain():
@@ -42,3 +50,605 @@ def test_wide_clusters():
     A simple regression test for https://gitlab.com/graphviz/graphviz/-/issues/2080#
     """
     dot("svg", Path(__file__).parent / "wide_clusters")
+
+
+def test_warmstart():
+    """
+    relaying out a graph after small edits, starting from the positions of its
+    previous layout, should give valid layouts in fewer network simplex
+    iterations than starting from scratch
+    """
+
+    rng = random.Random(42)
+    nodes = 300
+    labels = {i: f"n{i}" for i in range(nodes)}
+    edges = [(rng.randrange(i), i) for i in range(1, nodes)]
+    edges += [tuple(sorted(rng.sample(range(nodes), 2))) for _ in range(nodes // 10)]
+
+    def source(positions: str = "") -> str:
+        text = ["digraph {"]
+        text += [f'  {i} [label="{l}"];' for i, l in labels.items()]
+        text += [f"  {t} -> {h};" for t, h in edges]
+        return "\n".join(text) + positions + "\n}\n"
+
+    def layout(src: str, warm: bool):
+        proc = subprocess.run(
+            ["dot", "-v", f"-Gwarmstart={str(warm).lower()}", "-Tdot"],
+            input=src,
+            stdout=subprocess.PIPE,
+            stderr=subprocess.PIPE,
+            check=True,
+            universal_newlines=True,
+        )
+        solves = re.findall(
+            r"^network simplex: \d+ nodes \d+ edges (\d+) iter ([\d.]+) sec$",
+            proc.stderr,
+            flags=re.MULTILINE,
+        )
+        iterations = sum(int(i) for i, _ in solves)
+        seconds = sum(float(s) for _, s in solves)
+        return proc.stdout.replace("\\\n", ""), iterations, seconds
+
+    def positions(output: str) -> str:
+        """the node and edge positions of a layout, as statements to append"""
+        stmts = re.findall(
+            r'^\s*(\d+(?: -> \d+)?)\s+\[[^\]]*?\bpos="([^"]*)"', output, re.MULTILINE
+        )
+        return "".join(f'\n  {o} [pos="{p}"];' for o, p in stmts)
+
+    previous, _, _ = layout(source(), False)
+    totals = {False: [0, 0.0], True: [0, 0.0]}
+    for step in range(12):
+        # alternately add a leaf, relabel a node and add an edge
+        if step % 3 == 0:
+            edges.append((rng.randrange(nodes), nodes))
+            labels[nodes] = f"n{nodes}"
+            nodes += 1
+        elif step % 3 == 1:
+            i = rng.randrange(nodes)
+            labels[i] = f"node number {i}"
+        else:
+            edges.append(tuple(sorted(rng.sample(range(nodes), 2))))
+
+        cold, iterations, seconds = layout(source(), False)
+        totals[False][0] += iterations
+        totals[False][1] += seconds
+        warm, iterations, seconds = layout(source(positions(previous)), True)
+        totals[True][0] += iterations
+        totals[True][1] += seconds
+
+        # every edge points down in both layouts
+        for out in (cold, warm):
+            y = {
+                int(n): float(p.split(",")[1])
+                for n, p in re.findall(
+                    r'^\s*(\d+)\s+\[[^\]]*?\bpos="([^"]*)"', out, re.MULTILINE
+                )
+            }
+            for t, h in edges:
+                assert y[t] > y[h], f"edge {t} -> {h} does not point down"
+        previous = warm
+
+    print(f"cold: {totals[False][0]} iterations, {totals[False][1]:.2f}s")
+    print(f"warm: {totals[True][0]} iterations, {totals[True][1]:.2f}s")
+    assert totals[True][0] < totals[False][0], "warm start took more iterations"
+
+
+def random_dag(nodes: int, seed: int) -> str:
+    """
+    a DAG of mostly short edges, in DOT, that dot lays out quickly for its size
+    """
+    rng = random.Random(seed)
+    text = ["digraph {"]
+    for i in range(1, nodes):
+        text.append(f"  {rng.randrange(max(0, i - 20), i)} -> {i};")
+        if i % 3 == 0:
+            text.append(f"  {rng.randrange(max(0, i - 100), i)} -> {i};")
+    return "\n".join(text) + "\n}\n"
+
+
+def ns_layout(source: str, args: List[str]) -> Tuple[str, List[str]]:
+    """
+    lay out a graph with dot, returning the output and the network simplex
+    header lines
+    """
+    proc = subprocess.run(
+        ["dot", "-v", "-Gmclimit=0.1", "-Tplain"] + args,
+        input=source,
+        stdout=subprocess.PIPE,
+        stderr=subprocess.PIPE,
+        check=True,
+        universal_newlines=True,
+    )
+    headers = re.findall(
+        r"^network simplex:  \d+ nodes .*$", proc.stderr, flags=re.MULTILINE
+    )
+    return proc.stdout, headers
+
+
+@pytest.mark.parametrize("args", ([], ["-Grankdir=LR", "-Gnewrank=true"]))
+def test_ns_compact(args: List[str]):
+    """
+    large graphs should be ranked with the network simplex solver over compact
+    arrays, and small ones with the solver over the graph; that both give the
+    same ranks is checked by test_misc.py:test_ns_compact
+    """
+
+    _, headers = ns_layout(random_dag(2500, 14), args)
+    assert any(h.endswith(" compact") for h in headers), "compact solver not used"
+
+    _, headers = ns_layout(random_dag(100, 14), args)
+    assert headers, "no network simplex statistics in output"
+    assert not any(h.endswith(" compact") for h in headers)
+
+
+@pytest.mark.parametrize("args", ([], ["-Gnewrank=true"]))
+def test_ns_threads(args: List[str]):
+    """
+    sharing the network simplex searches for edges to exchange among threads
+    should not change the layout
+    """
+
+    source = random_dag(5000, 15)
+    expected = None
+    for threads in (1, 2, 4, 8):
+        output, headers = ns_layout(source, args + [f"-Gthreads={threads}"])
+        if threads > 1:
+            assert any(h.endswith(f" threads={threads}") for h in headers)
+        if expected is None:
+            expected = output
+        assert output == expected, f"layout differs with {threads} threads"
+
+
+def bb_width(output: str) -> float:
+    """the width of the bounding box of a layout in -Tdot output"""
+    m = re.search(r'\bbb="([-\d.]+),[-\d.]+,([-\d.]+),[-\d.]+"', output)
+    assert m is not None, "no bounding box in output"
+    return float(m.group(2)) - float(m.group(1))
+
+
+@pytest.mark.parametrize("graph", ("random_dag", "wide_clusters"))
+def test_bk_position(graph: str):
+    """
+    x coordinates found by the method of Brandes and Köpf should be used in
+    place of network simplex when asked for; the time taken and the width of the
+    layout are reported for both
+    """
+
+    if graph == "random_dag":
+        source = random_dag(5000, 16)
+    else:
+        source = (Path(__file__).parent / graph).read_text(encoding="utf-8")
+
+    results = {}
+    for xposition in ("ns", "bk"):
+        start = time.monotonic()
+        proc = subprocess.run(
+            ["dot", "-v", f"-Gxposition={xposition}", "-Tdot"],
+            input=source,
+            stdout=subprocess.PIPE,
+            stderr=subprocess.PIPE,
+            check=True,
+            universal_newlines=True,
+        )
+        seconds = time.monotonic() - start
+        used = re.search(
+            r"^Brandes-Koepf: \d+ nodes \d+ constraints (\w+)",
+            proc.stderr,
+            flags=re.MULTILINE,
+        )
+        if xposition == "bk":
+            assert used is not None, "Brandes-Koepf positioning not tried"
+            assert used.group(1) != "failed", "Brandes-Koepf positioning failed"
+        else:
+            assert used is None, "Brandes-Koepf positioning used by default"
+        output = proc.stdout.replace("\\\n", "")
+        results[xposition] = (seconds, bb_width(output))
+
+    for xposition, (seconds, width) in results.items():
+        print(f"{graph} xposition={xposition}: {seconds:.2f}s, width {width:.0f}")
+
+
+@pytest.mark.skipif(
+    platform.system() == "Windows" and not is_mingw(),
+    reason="test program uses POSIX file descriptors",
+)
+def test_cross_tree(tmp_path: Path):
+    """
+    the crossings counted in a tree during crossing minimization should be those
+    of the order it leaves, counted edge by edge by test program crossings.c
+    """
+
+    rng = random.Random(17)
+    text = ["digraph {", "  mclimit=0.2;"]
+    for i in range(300, 3000):
+        for _ in range(3):
+            text.append(f"  {rng.randrange(i - 300, i)} -> {i};")
+    source = tmp_path / "cross.gv"
+    source.write_text("\n".join(text) + "\n}\n", encoding="utf-8")
+
+    c_src = Path(__file__).parents[2] / "crossings.c"
+    assert c_src.exists(), "missing test case"
+    run_c(c_src, [str(source)], link=["gvc", "cgraph"])
+
+
+def test_mincross_threads():
+    """
+    ordering the components of a graph in several threads should give the same
+    layout as ordering them one after another, whether or not they have flat
+    edges
+    """
+
+    rng = random.Random(18)
+    text = ["digraph {"]
+    for comp in range(200):
+        base = comp * 40
+        for i in range(1, 40):
+            text.append(f"  {base + rng.randrange(max(0, i - 8), i)} -> {base + i};")
+            if i % 4 == 0:
+                text.append(f"  {base + rng.randrange(i)} -> {base + i};")
+        if comp % 5 == 0:
+            members = " ".join(str(base + i) for i in range(5, 15))
+            text.append(f"  subgraph cluster_{comp} {{ {members} }}")
+        if comp % 5 == 2:
+            a, b = f"a{comp}", f"b{comp}"
+            text.append(f"  {base + 20} -> {a}; {base + 20} -> {b};")
+            text.append(f'  {{ rank=same; {a}; {b}; }}\n  {a} -> {b} [label="f"];')
+            text.append(f"  {base + 30} -> {base + 30};")
+    flat = "\n".join(text) + "\n}\n"
+    plain = "\n".join(t for t in text if "rank=same" not in t) + "\n}\n"
+
+    for source in (plain, flat):
+        expected = None
+        for threads in (1, 4):
+            proc = subprocess.run(
+                ["dot", "-v", f"-Gthreads={threads}", "-Tplain"],
+                input=source,
+                stdout=subprocess.PIPE,
+                stderr=subprocess.PIPE,
+                check=True,
+                universal_newlines=True,
+            )
+            if threads > 1:
+                assert f"200 components in {threads} threads" in proc.stderr
+            if expected is None:
+                expected = proc.stdout
+            assert proc.stdout == expected, f"layout differs with {threads} threads"
+
+
+def test_spline_threads():
+    """
+    routing edges in several threads should give the same splines as routing
+    them one after another
+    """
+
+    source = random_dag(2000, 23).rstrip().rstrip("}")
+    rng = random.Random(23)
+    for _ in range(30):
+        a = rng.randrange(2000 - 40)
+        source += f'  {a} -> {a};\n  {a} -> {a + rng.randrange(1, 40)} [label="x"];\n'
+    source += "  { rank=same; 100; 101; 102 }\n  100 -> 102;\n}\n"
+
+    expected = None
+    for threads in (1, 4):
+        proc = subprocess.run(
+            ["dot", "-v", f"-Gthreads={threads}", "-Tplain"],
+            input=source,
+            stdout=subprocess.PIPE,
+            stderr=subprocess.PIPE,
+            check=True,
+            universal_newlines=True,
+        )
+        if threads > 1:
+            assert re.search(
+                rf"^splines: \d+ groups of edges in \d+ levels, {threads} threads$",
+                proc.stderr,
+                re.MULTILINE,
+            )
+        if expected is None:
+            expected = proc.stdout
+        assert proc.stdout == expected, f"splines differ with {threads} threads"
+
+
+def test_mcrestarts():
+    """
+    ordering each component several times should find no more crossings than
+    ordering it once, flat edges or not, and give the same layout for the same
+    seed however many threads are used
+    """
+
+    rng = random.Random(19)
+    text = ["digraph {"]
+    for comp in range(20):
+        base = comp * 60
+        for i in range(1, 60):
+            text.append(f"  {base + rng.randrange(i)} -> {base + i};")
+            if i % 2 == 0:
+                text.append(f"  {base + rng.randrange(i)} -> {base + i};")
+        if comp % 2 == 0:
+            a, b = f"a{comp}", f"b{comp}"
+            text.append(f"  {base + 30} -> {a}; {base + 40} -> {b};")
+            text.append(f'  {{ rank=same; {a}; {b}; }}\n  {b} -> {a} [label="f"];')
+    source = "\n".join(text) + "\n}\n"
+
+    def layout(restarts: int, threads: int):
+        proc = subprocess.run(
+            [
+                "dot",
+                "-v",
+                f"-Gmcrestarts={restarts}",
+                "-Gmcseed=7",
+                f"-Gthreads={threads}",
+                "-Tplain",
+            ],
+            input=source,
+            stdout=subprocess.PIPE,
+            stderr=subprocess.PIPE,
+            check=True,
+            universal_newlines=True,
+        )
+        m = re.search(r"^mincross \S+: (\d+) crossings", proc.stderr, re.MULTILINE)
+        assert m is not None, "no mincross statistics in output"
+        return proc.stdout, int(m.group(1))
+
+    _, once = layout(1, 1)
+    output, restarted = layout(8, 1)
+    assert restarted < once, "restarts found no fewer crossings"
+    assert layout(8, 1)[0] == output, "restarts are not reproducible"
+    assert layout(8, 4)[0] == output, "restarts depend on the threads used"
+
+
+def test_timelimit():
+    """
+    a layout given too little time should still finish, soon after its limit,
+    with every phase that ran out of time reported under -v
+    """
+
+    source = random_dag(40000, 20)
+    start = time.monotonic()
+    proc = subprocess.run(
+        ["dot", "-v", "-Gtimelimit=1", "-Tdot"],
+        input=source,
+        stdout=subprocess.PIPE,
+        stderr=subprocess.PIPE,
+        check=True,
+        universal_newlines=True,
+    )
+    seconds = time.monotonic() - start
+    assert re.search(
+        r"^dot: \w+ stopped at the time limit$", proc.stderr, re.MULTILINE
+    ), "no phase was cut short"
+    assert re.search(r"\bbb=", proc.stdout), "no layout in output"
+    print(f"timelimit=1: {seconds:.2f}s")
+
+
+def test_incremental():
+    """
+    a warm started layout after a small edit should move the nodes that were
+    already there less than a layout from scratch does
+    """
+
+    rng = random.Random(21)
+    nodes = 200
+    edges = [(rng.randrange(i), i) for i in range(1, nodes)]
+    edges += [tuple(sorted(rng.sample(range(nodes), 2))) for _ in range(nodes // 10)]
+
+    def source(positions: str = "") -> str:
+        text = ["digraph {"]
+        text += [f"  {t} -> {h};" for t, h in edges]
+        return "\n".join(text) + positions + "\n}\n"
+
+    def layout(src: str, warm: bool):
+        start = time.monotonic()
+        proc = subprocess.run(
+            ["dot", f"-Gwarmstart={str(warm).lower()}", "-Tdot"],
+            input=src,
+            stdout=subprocess.PIPE,
+            check=True,
+            universal_newlines=True,
+        )
+        return proc.stdout.replace("\\\n", ""), time.monotonic() - start
+
+    def positions(output: str) -> Dict[int, Tuple[float, float]]:
+        return {
+            int(n): tuple(float(c) for c in p.split(","))
+            for n, p in re.findall(
+                r'^\s*(\d+)\s+\[[^\]]*?\bpos="([^"]*)"', output, re.MULTILINE
+            )
+        }
+
+    def statements(output: str) -> str:
+        """the node and edge positions of a layout, as statements to append"""
+        stmts = re.findall(
+            r'^\s*(\d+(?: -> \d+)?)\s+\[[^\]]*?\bpos="([^"]*)"', output, re.MULTILINE
+        )
+        return "".join(f'\n  {o} [pos="{p}"];' for o, p in stmts)
+
+    def moved(before: str, after: str) -> float:
+        """how far the nodes of before moved, relative to node 0"""
+        p, q = positions(before), positions(after)
+        dx, dy = q[0][0] - p[0][0], q[0][1] - p[0][1]
+        return sum(
+            abs(q[n][0] - p[n][0] - dx) + abs(q[n][1] - p[n][1] - dy) for n in p
+        )
+
+    cold, _ = layout(source(), False)
+    warm = cold
+    totals = {False: [0.0, 0.0], True: [0.0, 0.0]}
+    for step in range(10):
+        # alternately add a leaf and an edge
+        if step % 2 == 0:
+            edges.append((rng.randrange(nodes), nodes))
+            nodes += 1
+        else:
+            edges.append(tuple(sorted(rng.sample(range(nodes), 2))))
+
+        new_cold, seconds = layout(source(), False)
+        totals[False][0] += moved(cold, new_cold)
+        totals[False][1] += seconds
+        new_warm, seconds = layout(source(statements(warm)), True)
+        totals[True][0] += moved(warm, new_warm)
+        totals[True][1] += seconds
+        cold, warm = new_cold, new_warm
+
+    print(f"cold: nodes moved {totals[False][0]:.0f}pt, {totals[False][1]:.2f}s")
+    print(f"warm: nodes moved {totals[True][0]:.0f}pt, {totals[True][1]:.2f}s")
+    assert totals[True][0] < totals[False][0], "warm start moved nodes more"
+
+
+@pytest.mark.parametrize(
+    "graph", ["clust4.gv", "clust5.gv", "KW91.gv", "sdh.gv", "unix.gv"]
+)
+def test_warm_unchanged(graph: str):
+    """
+    relaying out an unchanged graph, clusters and all, with a warm start should
+    keep the left to right order of the nodes on every rank
+    """
+
+    src = Path(__file__).parent / "../../../graphs/directed" / graph
+    before = dot("dot", src.resolve()).replace("\\\n", "")
+    proc = subprocess.run(
+        ["dot", "-Gwarmstart=true", "-Tdot"],
+        input=before,
+        stdout=subprocess.PIPE,
+        check=True,
+        universal_newlines=True,
+    )
+    after = proc.stdout.replace("\\\n", "")
+
+    def positions(output: str) -> Dict[str, Tuple[float, float]]:
+        return {
+            n: tuple(float(c) for c in p.split(","))
+            for n, p in re.findall(
+                r'^\s*("[^"]*"|\w+)\s+\[[^\]]*?\bpos="([^"]*)"',
+                output,
+                re.MULTILINE,
+            )
+        }
+
+    # ranks may be spaced differently, so nodes are grouped by the rank they
+    # were on in both layouts
+    old, new = positions(before), positions(after)
+    assert old.keys() == new.keys(), "nodes lost"
+    rows: Dict[Tuple[float, float], List[str]] = {}
+    for n in old:
+        rows.setdefault((old[n][1], new[n][1]), []).append(n)
+    for row in rows.values():
+        assert sorted(row, key=lambda n: old[n][0]) == sorted(
+            row, key=lambda n: new[n][0]
+        ), "warm start reordered a rank"
+
+
+def test_layout_cache(tmp_path: Path):
+    """
+    a graph differing from one laid out before only in its colors should get
+    the same layout back from the cache, from memory and from disk, as it
+    would from the engine
+    """
+
+    text = random_dag(3000, 22).rstrip().rstrip("}")
+    text += (
+        '  subgraph cluster_a { label="A"; 10; 11; 12 }\n'
+        '  subgraph cluster_b { label="B"; 20; 21 -> 22 [label="x"] }\n'
+        # dot moves this edge into cluster_a, which the cache has to repeat
+        "  12 -> 10;\n"
+    )
+    source = text + '  node [color="red"];\n}\n'
+    recolored = text + '  node [color="blue"]; bgcolor="gray"\n}\n'
+
+    def layout(src: str, cache: Dict[str, Optional[str]]):
+        environ = os.environ.copy()
+        for k in ("GV_LAYOUT_CACHE", "GV_LAYOUT_CACHE_DIR"):
+            environ.pop(k, None)
+        environ.update({k: v for k, v in cache.items() if v is not None})
+        start = time.monotonic()
+        proc = subprocess.run(
+            ["dot", "-v", "-Tdot"],
+            input=src,
+            stdout=subprocess.PIPE,
+            stderr=subprocess.PIPE,
+            env=environ,
+            check=True,
+            universal_newlines=True,
+        )
+        hits = re.findall(r"^layout cache: hit in (\w+)", proc.stderr, re.MULTILINE)
+        return proc.stdout, hits, time.monotonic() - start
+
+    expected, hits, engine_seconds = layout(recolored, {})
+    assert hits == []
+
+    # twice in one input, the second from memory
+    both, hits, _ = layout(source + recolored, {"GV_LAYOUT_CACHE": "4"})
+    assert hits == ["memory"]
+    assert both.endswith(expected), "layout from memory differs"
+
+    # across runs, from disk
+    disk = {"GV_LAYOUT_CACHE_DIR": str(tmp_path)}
+    _, hits, _ = layout(source, disk)
+    assert hits == []
+    assert list(tmp_path.glob("*.gvl")), "no layout written"
+    cached, hits, cached_seconds = layout(recolored, disk)
+    assert hits == ["disk"]
+    assert cached == expected, "layout from disk differs"
+
+    # a change to what the layout depends on misses
+    _, hits, _ = layout(recolored.replace("21 -> 22", "21 -> 23"), disk)
+    assert hits == []
+    print(f"engine: {engine_seconds:.2f}s, cache: {cached_seconds:.2f}s")
+
+
+def sibling_clusters(count: int, seed: int) -> str:
+    """a graph of `count` small sibling clusters, some with a nested cluster"""
+    rng = random.Random(seed)
+    text = ["digraph {"]
+    for i in range(count):
+        text.append(f"  subgraph cluster_{i} {{ a{i} -> b{i} -> c{i}; a{i} -> c{i};")
+        if i % 10 == 0:
+            text.append(f"    subgraph cluster_{i}_in {{ b{i}; c{i} }}")
+        text.append("  }")
+    for i in range(1, count):
+        text.append(f"  b{rng.randrange(i)} -> a{i};")
+    return "\n".join(text) + "\n}\n"
+
+
+def test_cluster_scaling():
+    """
+    ordering each cluster by the crossings in its own ranks should give the
+    same layout as counting all of them, sibling clusters should not overlap,
+    and the time for each number of clusters is reported
+    """
+
+    def layout(source: str, local: str) -> Tuple[dict, float]:
+        environ = os.environ.copy()
+        environ["GV_CROSS_LOCAL"] = local
+        start = time.monotonic()
+        proc = subprocess.run(
+            ["dot", "-Tjson"],
+            input=source,
+            stdout=subprocess.PIPE,
+            env=environ,
+            check=True,
+            universal_newlines=True,
+        )
+        return json.loads(proc.stdout), time.monotonic() - start
+
+    source = sibling_clusters(300, 23)
+    local, _ = layout(source, "true")
+    full, _ = layout(source, "false")
+    assert local == full, "layouts differ"
+
+    boxes = [
+        [float(c) for c in o["bb"].split(",")]
+        for o in local["objects"]
+        if re.fullmatch(r"cluster_\d+", o["name"])
+    ]
+    assert len(boxes) == 300
+    for i, a in enumerate(boxes):
+        for b in boxes[i + 1 :]:
+            assert (
+                a[2] <= b[0] or b[2] <= a[0] or a[3] <= b[1] or b[3] <= a[1]
+            ), "sibling clusters overlap"
+
+    for count in (100, 1000, 4000):
+        _, seconds = layout(sibling_clusters(count, 23), "true")
+        print(f"{count} clusters: {seconds:.2f}s")
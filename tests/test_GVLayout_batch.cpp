@@ -0,0 +1,73 @@
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+#include <cgraph++/AGraph.h>
+#include <gvc++/GVContext.h>
+#include <gvc++/GVLayout.h>
+#include <gvc++/GVRenderData.h>
+
+namespace {
+std::vector<std::shared_ptr<CGraph::AGraph>> make_graphs(int count) {
+  std::vector<std::shared_ptr<CGraph::AGraph>> graphs;
+  for (int i = 0; i < count; ++i) {
+    const auto dot = "digraph g" + std::to_string(i) + " {a -> b" +
+                     std::to_string(i) + "}";
+    graphs.push_back(std::make_shared<CGraph::AGraph>(dot));
+  }
+  return graphs;
+}
+} // namespace
+
+TEST_CASE("A batch renders every graph, in order, as a single layout would") {
+  const auto demand_loading = false;
+  auto gvc =
+      std::make_shared<GVC::GVContext>(lt_preloaded_symbols, demand_loading);
+  // rendering some formats attaches the layout to the graph, so the batch and
+  // the single layouts each get their own copies
+  const auto graphs = make_graphs(20);
+  const auto singles = make_graphs(20);
+
+  const auto format = GENERATE(as<std::string>{}, "svg", "dot", "xdot", "json",
+                               "plain");
+  const auto threads = GENERATE(0u, 1u, 3u);
+  const auto rendered =
+      GVC::GVLayout::render_batch(*gvc, graphs, "dot", format, threads);
+
+  REQUIRE(rendered.size() == graphs.size());
+  for (std::size_t i = 0; i < singles.size(); ++i) {
+    const auto layout = GVC::GVLayout(gvc, singles[i], "dot");
+    const auto expected = layout.render(format);
+    REQUIRE(rendered[i].string_view() == expected.string_view());
+  }
+}
+
+TEST_CASE("A batch can be run asynchronously") {
+  const auto demand_loading = false;
+  auto gvc =
+      std::make_shared<GVC::GVContext>(lt_preloaded_symbols, demand_loading);
+  const auto graphs = make_graphs(5);
+
+  auto future = GVC::GVLayout::render_batch_async(gvc, graphs, "dot", "svg");
+  const auto rendered = future.get();
+
+  REQUIRE(rendered.size() == graphs.size());
+  for (std::size_t i = 0; i < graphs.size(); ++i) {
+    const auto name = "g" + std::to_string(i);
+    REQUIRE(rendered[i].string_view().find(name) != std::string_view::npos);
+  }
+}
+
+TEST_CASE("A batch with an unknown layout engine throws an exception") {
+  const auto demand_loading = false;
+  auto gvc =
+      std::make_shared<GVC::GVContext>(lt_preloaded_symbols, demand_loading);
+  const auto graphs = make_graphs(3);
+
+  REQUIRE_THROWS_AS(
+      GVC::GVLayout::render_batch(*gvc, graphs, "UNKNOWN_ENGINE", "svg"),
+      std::runtime_error);
+}
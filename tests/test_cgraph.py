@@ -0,0 +1,190 @@
+"""test ../lib/cgraph through the C programs alongside this file"""
+
+import os
+import platform
+import subprocess
+import sys
+from pathlib import Path
+
+import pytest
+
+sys.path.append(os.path.dirname(__file__))
+from gvtest import dot, is_mingw, run_c  # pylint: disable=wrong-import-position
+
+
+def test_agmapread(tmp_path: Path):
+    """
+    parsing from a memory mapping should produce the same graphs as parsing
+    through stdio
+    """
+
+    # find co-located test source
+    c_src = (Path(__file__).parent / "agmapread.c").resolve()
+    assert c_src.exists(), "missing test case"
+
+    # a file holding several graphs, exactly one page long so the mapping ends
+    # at the end of the file
+    multi = tmp_path / "multi.gv"
+    graphs = 'digraph a { x -> y }\ngraph b { p -- q [label="r\\ns"] }\n'
+    multi.write_text(graphs + "#" * (4096 - len(graphs) - 1) + "\n", "utf-8")
+
+    # an empty file, which cannot be mapped
+    empty = tmp_path / "empty.gv"
+    empty.write_text("", "utf-8")
+
+    large = Path(__file__).parent / "regression_tests/large"
+    for i in (multi, empty, large / "long_chain", large / "wide_clusters"):
+        run_c(c_src, [str(i)], link=["cgraph"])
+
+
+def test_gvbin(tmp_path: Path):
+    """
+    binary snapshots of graphs, including their layouts, should reload to the
+    same graphs, and `dot` should accept them as input
+    """
+
+    # find co-located test source
+    c_src = (Path(__file__).parent / "agmapread.c").resolve()
+    assert c_src.exists(), "missing test case"
+
+    multi = tmp_path / "multi.gv"
+    multi.write_text(
+        'digraph a { x -> y }\ngraph b { p -- q [label="r\\ns"] }\n'
+        'strict digraph c { subgraph { rank=same; "<html>"; t -> u [key=k] } '
+        "node [shape=box]; v; w [label=<<b>w</b>>] }\n",
+        "utf-8",
+    )
+
+    large = Path(__file__).parent / "regression_tests/large"
+    for i in (multi, large / "long_chain", large / "wide_clusters"):
+        text = tmp_path / f"{i.name}.dot"
+        binary = tmp_path / f"{i.name}.gvbin"
+
+        # snapshots written by the library
+        subprocess.check_call(["dot", "-Tdot", "-o", text, i])
+        run_c(c_src, [str(text), str(binary)], link=["cgraph"])
+
+        # snapshots written by `dot -Tgvbin`
+        subprocess.check_call(["dot", "-Tgvbin", "-o", binary, i])
+        assert dot("canon", binary) == dot("canon", text)
+
+    # a truncated snapshot should be rejected rather than misread
+    image = (tmp_path / "wide_clusters.gvbin").read_bytes()
+    truncated = tmp_path / "truncated.gvbin"
+    truncated.write_bytes(image[: len(image) // 2])
+    proc = subprocess.run(
+        ["dot", "-Tcanon", truncated],
+        stdout=subprocess.PIPE,
+        stderr=subprocess.PIPE,
+        universal_newlines=True,
+    )
+    assert proc.returncode != 0, "truncated snapshot was accepted"
+    assert "truncated binary graph snapshot" in proc.stderr
+
+
+def test_agarena():
+    """
+    graphs built with the arena memory discipline should match those built
+    with the default one, and closing them should release the maps of internal
+    names through the arena
+    """
+
+    # find co-located test source
+    c_src = (Path(__file__).parent / "agarena.c").resolve()
+    assert c_src.exists(), "missing test case"
+
+    run_c(c_src, link=["cgraph"])
+
+    # `dot --arena` should lay out graphs just as `dot` does, on a graph whose
+    # subgraphs are anonymous so their order does not depend on where their
+    # names are allocated
+    source = Path(__file__).parents[1] / "graphs/directed/world.gv"
+    expected = subprocess.check_output(["dot", "-Tdot", source])
+    actual = subprocess.check_output(["dot", "--arena", "-Tdot", source])
+    assert expected == actual, "--arena changed the layout"
+
+
+def test_attrcache():
+    """
+    parsed attribute values should follow changes to the strings they were
+    parsed from, and objects outside the graph should not see other objects'
+    values
+    """
+
+    # find co-located test source
+    c_src = (Path(__file__).parent / "attrcache.c").resolve()
+    assert c_src.exists(), "missing test case"
+
+    run_c(c_src, link=["cgraph"])
+
+
+def test_agcolumnar():
+    """
+    graphs storing node and edge attributes in columns should match those
+    storing them per object, and allocate less
+    """
+
+    # find co-located test source
+    c_src = (Path(__file__).parent / "agcolumnar.c").resolve()
+    assert c_src.exists(), "missing test case"
+
+    # parsed graphs, without named subgraphs whose order would depend on where
+    # their names are allocated
+    root = Path(__file__).parents[1] / "graphs"
+    sources = [root / "directed/unix.gv", root / "undirected/process.gv"]
+    run_c(c_src, sources, link=["cgraph"])
+
+
+def test_agcsr():
+    """
+    adjacency snapshots should list nodes and edges as the iteration functions
+    do
+    """
+
+    # find co-located test source
+    c_src = (Path(__file__).parent / "agcsr.c").resolve()
+    assert c_src.exists(), "missing test case"
+
+    run_c(c_src, link=["cgraph"])
+
+
+def test_agedgeindex():
+    """
+    indexed graphs should find the same edges as unindexed ones
+    """
+
+    # find co-located test source
+    c_src = (Path(__file__).parent / "agedgeindex.c").resolve()
+    assert c_src.exists(), "missing test case"
+
+    run_c(c_src, link=["cgraph"])
+
+
+def test_agstream():
+    """
+    graphs rebuilt from the statements agstream reports should match parsed
+    ones
+    """
+
+    # find co-located test source
+    c_src = (Path(__file__).parent / "agstream.c").resolve()
+    assert c_src.exists(), "missing test case"
+
+    run_c(c_src, link=["cgraph"])
+
+
+@pytest.mark.skipif(
+    platform.system() == "Windows" and not is_mingw(),
+    reason="test case uses POSIX threads",
+)
+def test_agreentrant():
+    """
+    graphs parsed in several threads at once should match those parsed one at a
+    time
+    """
+
+    # find co-located test source
+    c_src = (Path(__file__).parent / "agreentrant.c").resolve()
+    assert c_src.exists(), "missing test case"
+
+    run_c(c_src, link=["cgraph", "pthread"])
@@ -14,7 +14,7 @@ from pathlib import Path
 import pytest
 
 sys.path.append(os.path.dirname(__file__))
-from gvtest import ROOT, compile_c, dot  # pylint: disable=wrong-import-position
+from gvtest import ROOT, compile_c, dot, is_mingw, run_c  # pylint: disable=wrong-import-position
 
 
 def test_json_node_order():
@@ -228,3 +228,71 @@ def test_xml_escape():
                     assert escaped == f"character |{expected}|", "bad UTF-8 escaping"
                 else:
                     assert escaped == unescaped, "bad UTF-8 passthrough"
+
+
+@pytest.mark.skipif(
+    platform.system() == "Windows" and not is_mingw(),
+    reason="test case uses POSIX threads",
+)
+def test_gvreentrant():
+    """
+    graphs laid out in several threads at once should match those laid out one
+    at a time
+    """
+
+    # find co-located test source
+    c_src = (Path(__file__).parent / "gvreentrant.c").resolve()
+    assert c_src.exists(), "missing test case"
+
+    run_c(c_src, link=["gvc", "cgraph", "pthread"])
+
+
+def test_gvbatch():
+    """
+    graphs laid out by `gvLayoutBatch` should match those laid out one at a time
+    in a loop
+    """
+
+    # find co-located test source
+    c_src = (Path(__file__).parent / "gvbatch.c").resolve()
+    assert c_src.exists(), "missing test case"
+
+    run_c(c_src, link=["gvc", "cgraph"])
+
+
+@pytest.mark.skipif(
+    platform.system() == "Windows",
+    reason="ns_compact is not exported from the Windows libraries",
+)
+def test_ns_compact():
+    """
+    the network simplex solver over compact arrays should rank graphs exactly as
+    the solver over the graph does
+    """
+
+    # find co-located test source
+    c_src = (Path(__file__).parent / "ns_compact.c").resolve()
+    assert c_src.exists(), "missing test case"
+
+    run_c(c_src, link=["gvc", "cgraph"])
+
+
+@pytest.mark.skipif(
+    platform.system() == "Windows" and not is_mingw(),
+    reason="test case uses POSIX file descriptors",
+)
+def test_crossings():
+    """
+    the crossings dot reports after crossing minimization should be those of the
+    order it leaves, counted edge by edge
+    """
+
+    # find co-located test source
+    c_src = (Path(__file__).parent / "crossings.c").resolve()
+    assert c_src.exists(), "missing test case"
+
+    graphs = [
+        ROOT / "graphs/directed" / f"{g}.gv"
+        for g in ("abstract", "alf", "crazy", "unix", "world")
+    ]
+    run_c(c_src, [str(g) for g in graphs], link=["gvc", "cgraph"])